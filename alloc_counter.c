@@ -0,0 +1,278 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Needs glibc: ld --wrap, backtrace() and dladdr() */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+
+#include "alloc_counter.h"
+#include "verbosity.h"
+
+#define ALLOC_COUNTER_MAX_SITES     32
+#define ALLOC_COUNTER_STACK_DEPTH   8
+/* Frame time histogram, in 10 us buckets up to 100 ms */
+#define ALLOC_COUNTER_BUCKET_USEC   10
+#define ALLOC_COUNTER_BUCKETS       10000
+
+struct alloc_counter_site
+{
+   void *stack[ALLOC_COUNTER_STACK_DEPTH];
+   unsigned depth;
+   unsigned count;
+   unsigned first_frame;
+   bool in_core_run;
+};
+
+static struct
+{
+   struct alloc_counter_site sites[ALLOC_COUNTER_MAX_SITES];
+   uint32_t histogram[ALLOC_COUNTER_BUCKETS];
+   retro_time_t frame_start;
+   retro_time_t time_sum;
+   retro_time_t time_max;
+   uint64_t steady_allocs;
+   uint64_t steady_frees;
+   uint64_t steady_core_run_allocs;
+   pthread_t thread;
+   unsigned num_sites;
+   unsigned frame_allocs;
+   unsigned frame_frees;
+   unsigned frame_core_run_allocs;
+   unsigned frames;
+   unsigned steady_frames;
+   unsigned dirty_frames;
+   bool armed;
+   bool in_core_run;
+   bool ran_core;
+   bool recording;
+} alloc_counter;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+char *__real_strdup(const char *s);
+int   __real_posix_memalign(void **memptr, size_t alignment, size_t size);
+void  __real_free(void *ptr);
+
+static bool alloc_counter_active(void)
+{
+   return alloc_counter.armed
+      && !alloc_counter.recording
+      && pthread_equal(pthread_self(), alloc_counter.thread);
+}
+
+static void alloc_counter_record_site(void)
+{
+   unsigned i;
+   int depth;
+   void *stack[ALLOC_COUNTER_STACK_DEPTH + 2];
+   struct alloc_counter_site *site;
+
+   /* backtrace() may allocate the first time it is called */
+   alloc_counter.recording = true;
+   depth                   = backtrace(stack, ALLOC_COUNTER_STACK_DEPTH + 2);
+   alloc_counter.recording = false;
+
+   /* Skip this function and alloc_counter_alloc() */
+   if (depth <= 2)
+      return;
+   depth -= 2;
+
+   for (i = 0; i < alloc_counter.num_sites; i++)
+   {
+      site = &alloc_counter.sites[i];
+      if (     site->depth == (unsigned)depth
+            && !memcmp(site->stack, stack + 2, depth * sizeof(void*)))
+      {
+         site->count++;
+         return;
+      }
+   }
+
+   if (alloc_counter.num_sites >= ALLOC_COUNTER_MAX_SITES)
+      return;
+
+   site              = &alloc_counter.sites[alloc_counter.num_sites++];
+   site->depth       = (unsigned)depth;
+   site->count       = 1;
+   site->first_frame = alloc_counter.frames;
+   site->in_core_run = alloc_counter.in_core_run;
+   memcpy(site->stack, stack + 2, depth * sizeof(void*));
+}
+
+static void alloc_counter_alloc(void)
+{
+   if (!alloc_counter_active())
+      return;
+   alloc_counter.frame_allocs++;
+   if (alloc_counter.in_core_run)
+      alloc_counter.frame_core_run_allocs++;
+   if (alloc_counter.frames >= ALLOC_COUNTER_WARMUP_FRAMES)
+      alloc_counter_record_site();
+}
+
+void *__wrap_malloc(size_t size)
+{
+   alloc_counter_alloc();
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+   alloc_counter_alloc();
+   return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   alloc_counter_alloc();
+   return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *s)
+{
+   alloc_counter_alloc();
+   return __real_strdup(s);
+}
+
+int __wrap_posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+   alloc_counter_alloc();
+   return __real_posix_memalign(memptr, alignment, size);
+}
+
+void __wrap_free(void *ptr)
+{
+   if (ptr && alloc_counter_active())
+      alloc_counter.frame_frees++;
+   __real_free(ptr);
+}
+
+void alloc_counter_frame_begin(void)
+{
+   alloc_counter.thread                = pthread_self();
+   alloc_counter.frame_allocs          = 0;
+   alloc_counter.frame_frees           = 0;
+   alloc_counter.frame_core_run_allocs = 0;
+   alloc_counter.ran_core              = false;
+   alloc_counter.frame_start           = cpu_features_get_time_usec();
+   alloc_counter.armed                 = true;
+}
+
+void alloc_counter_frame_end(void)
+{
+   retro_time_t frame_time;
+
+   alloc_counter.armed = false;
+   if (!alloc_counter.ran_core)
+      return;
+
+   if (alloc_counter.frames++ < ALLOC_COUNTER_WARMUP_FRAMES)
+      return;
+
+   frame_time = cpu_features_get_time_usec() - alloc_counter.frame_start;
+   alloc_counter.steady_frames++;
+   alloc_counter.time_sum += frame_time;
+   if (frame_time > alloc_counter.time_max)
+      alloc_counter.time_max = frame_time;
+   alloc_counter.histogram[MIN(frame_time / ALLOC_COUNTER_BUCKET_USEC,
+         ALLOC_COUNTER_BUCKETS - 1)]++;
+
+   alloc_counter.steady_allocs          += alloc_counter.frame_allocs;
+   alloc_counter.steady_frees           += alloc_counter.frame_frees;
+   alloc_counter.steady_core_run_allocs += alloc_counter.frame_core_run_allocs;
+   if (alloc_counter.frame_allocs)
+      alloc_counter.dirty_frames++;
+}
+
+void alloc_counter_core_run_begin(void)
+{
+   alloc_counter.ran_core    = true;
+   alloc_counter.in_core_run = true;
+}
+
+void alloc_counter_core_run_end(void)
+{
+   alloc_counter.in_core_run = false;
+}
+
+static unsigned alloc_counter_percentile(unsigned percent)
+{
+   unsigned i;
+   uint64_t seen   = 0;
+   uint64_t target = ((uint64_t)alloc_counter.steady_frames * percent + 99) / 100;
+
+   for (i = 0; i < ALLOC_COUNTER_BUCKETS; i++)
+   {
+      seen += alloc_counter.histogram[i];
+      if (seen >= target)
+         break;
+   }
+   return (i + 1) * ALLOC_COUNTER_BUCKET_USEC;
+}
+
+bool alloc_counter_report(void)
+{
+   unsigned i, j;
+
+   if (!alloc_counter.steady_frames)
+   {
+      RARCH_WARN("[AllocCounter] No steady-state frames (%u warm-up frames ran).\n",
+            alloc_counter.frames);
+      return true;
+   }
+
+   RARCH_LOG("[AllocCounter] %u steady-state frames: %u allocated, "
+         "%llu allocations (%llu in core_run()), %llu frees.\n",
+         alloc_counter.steady_frames, alloc_counter.dirty_frames,
+         (unsigned long long)alloc_counter.steady_allocs,
+         (unsigned long long)alloc_counter.steady_core_run_allocs,
+         (unsigned long long)alloc_counter.steady_frees);
+   RARCH_LOG("[AllocCounter] Frame time: mean %.1f us, p50 <%u us, "
+         "p99 <%u us, max %u us.\n",
+         (double)alloc_counter.time_sum / alloc_counter.steady_frames,
+         alloc_counter_percentile(50), alloc_counter_percentile(99),
+         (unsigned)alloc_counter.time_max);
+
+   for (i = 0; i < alloc_counter.num_sites; i++)
+   {
+      const struct alloc_counter_site *site = &alloc_counter.sites[i];
+
+      RARCH_ERR("[AllocCounter] %u allocation(s)%s, first in frame %u:\n",
+            site->count, site->in_core_run ? " in core_run()" : "",
+            site->first_frame);
+      for (j = 0; j < site->depth; j++)
+      {
+         Dl_info info;
+         if (dladdr(site->stack[j], &info) && info.dli_fname)
+            RARCH_ERR("[AllocCounter]   %s+0x%lx %s\n",
+                  path_basename(info.dli_fname),
+                  (unsigned long)((uintptr_t)site->stack[j]
+                     - (uintptr_t)info.dli_fbase),
+                  info.dli_sname ? info.dli_sname : "");
+         else
+            RARCH_ERR("[AllocCounter]   %p\n", site->stack[j]);
+      }
+   }
+
+   return alloc_counter.dirty_frames == 0;
+}
@@ -0,0 +1,62 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ALLOC_COUNTER_H
+#define __ALLOC_COUNTER_H
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Test build mode (HAVE_ALLOC_COUNTER=1), enforcing that running
+ * content does not touch the heap once it has settled.
+ *
+ * malloc(), calloc(), realloc(), strdup(), posix_memalign() and free()
+ * are wrapped at link time (ld --wrap), so only calls made by the
+ * frontend itself are seen: the core, system libraries and drivers
+ * loaded at runtime are not counted. Calls are only counted on the
+ * main thread, between alloc_counter_frame_begin() and
+ * alloc_counter_frame_end().
+ *
+ * Frames that ran the core after the first ALLOC_COUNTER_WARMUP_FRAMES
+ * are steady-state frames. Any allocation in one of them is reported
+ * with its call stack, and makes RetroArch exit with a failure. Frame
+ * times are reported too, so the mode doubles as a benchmark of the
+ * frontend overhead per frame. */
+
+#define ALLOC_COUNTER_WARMUP_FRAMES 120
+
+void alloc_counter_frame_begin(void);
+
+void alloc_counter_frame_end(void);
+
+/* Marks the frame as running the core, and counts what is allocated
+ * within core_run() separately */
+void alloc_counter_core_run_begin(void);
+
+void alloc_counter_core_run_end(void);
+
+/**
+ * alloc_counter_report:
+ *
+ * Logs the allocations and frame times seen so far.
+ *
+ * Returns: false if a steady-state frame allocated.
+ **/
+bool alloc_counter_report(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -33,6 +33,7 @@
 #include <audio/conversion/s16_to_float.h>
 #include <audio/conversion/dual_mono.h>
 #ifdef HAVE_AUDIOMIXER
+#include <audio/audio_mix.h>
 #include <audio/audio_mixer.h>
 #include "../tasks/task_audio_mixer.h"
 #endif
@@ -512,15 +513,26 @@ static void audio_driver_flush(audio_driver_state_t *audio_st,
       /* Readjust the audio input rate. */
       if (audio_st->flags & AUDIO_FLAG_CONTROL)
       {
-         int avail                   = (int)audio_st->current_audio->write_avail(
+         size_t avail                = audio_st->current_audio->write_avail(
                audio_st->context_audio_data);
-         int half_size               = (int)(audio_st->buffer_size / 2);
-         int delta_mid               = avail - half_size;
-         double direction            = (double)delta_mid / half_size;
-         double adjust               = 1.0 + audio_st->rate_control_delta * direction;
+         size_t queued               = (avail < audio_st->buffer_size)
+               ? audio_st->buffer_size - avail
+               : 0;
+         double adjust;
 
-         audio_st->free_samples_buf[write_idx] = avail;
-         audio_st->src_ratio_curr = audio_st->src_ratio_orig * adjust;
+         /* Audio produced at another speed says nothing
+          * about the drift between the two clocks */
+         if (is_slowmotion || is_fastforward)
+            audio_rate_control_resync(&audio_st->rate_control);
+
+         adjust                      = audio_rate_control_update(
+               &audio_st->rate_control,
+               queued * audio_st->rate_control_sec_per_byte,
+               audio_st->rate_control_target,
+               cpu_features_get_time_usec());
+
+         audio_st->free_samples_buf[write_idx] = (unsigned)avail;
+         audio_st->src_ratio_curr = audio_st->src_ratio_orig * (1.0 + adjust);
 
 #if 0
          if (verbosity_is_enabled())
@@ -674,6 +686,9 @@ bool audio_driver_init_internal(void *settings_data, bool audio_cb_inited)
 
    convert_s16_to_float_init_simd();
    convert_float_to_s16_init_simd();
+#ifdef HAVE_AUDIOMIXER
+   audio_mix_init_simd();
+#endif
 
    if (!out_conv_buf || !audio_buf)
       goto error;
@@ -826,9 +841,17 @@ bool audio_driver_init_internal(void *settings_data, bool audio_cb_inited)
        * and buffer_size to be implemented. */
       if (audio_driver_st.current_audio->buffer_size)
       {
-         audio_driver_st.buffer_size =
+         size_t frame_size           = 2 *
+            ((audio_driver_st.flags & AUDIO_FLAG_USE_FLOAT)
+             ? sizeof(float) : sizeof(int16_t));
+
+         audio_driver_st.rate_control_sec_per_byte = 1.0 /
+            ((double)frame_size * settings->uints.audio_output_sample_rate);
+         audio_driver_set_buffer_size(
             audio_driver_st.current_audio->buffer_size(
-                  audio_driver_st.context_audio_data);
+                  audio_driver_st.context_audio_data));
+         audio_rate_control_init(&audio_driver_st.rate_control,
+               audio_driver_st.rate_control_delta);
          audio_driver_st.flags |= AUDIO_FLAG_CONTROL;
       }
       else
@@ -863,6 +886,9 @@ void audio_driver_sample(int16_t left, int16_t right)
       return;
    if (audio_st->flags & AUDIO_FLAG_SUSPENDED)
       return;
+   /* Frame dropped by turbo fast-forward */
+   if (runloop_state_get_ptr()->fastforward_skip)
+      return;
    audio_st->output_samples_conv_buf[audio_st->data_ptr++] = left;
    audio_st->output_samples_conv_buf[audio_st->data_ptr++] = right;
 
@@ -907,7 +933,9 @@ size_t audio_driver_sample_batch(const int16_t *data, size_t frames)
    audio_driver_state_t *audio_st = &audio_driver_st;
    float slowmotion_ratio         = config_get_ptr()->floats.slowmotion_ratio;
 
-   if ((audio_st->flags & AUDIO_FLAG_SUSPENDED) || (frames < 1))
+   if (     (audio_st->flags & AUDIO_FLAG_SUSPENDED)
+         || (frames < 1)
+         || runloop_state_get_ptr()->fastforward_skip)
       return frames;
 
    runloop_flags                  = runloop_get_flags();
@@ -1019,7 +1047,20 @@ bool audio_driver_dsp_filter_init(const char *device)
 
 void audio_driver_set_buffer_size(size_t bufsize)
 {
+   settings_t *settings = config_get_ptr();
+   unsigned target_ms   = settings->uints.audio_rate_control_target;
+   double buffer_sec    = bufsize * audio_driver_st.rate_control_sec_per_byte;
+
    audio_driver_st.buffer_size = bufsize;
+
+   /* Leave some room at the top, a full buffer blocks
+    * instead of telling how far ahead we are */
+   if (!target_ms)
+      audio_driver_st.rate_control_target = buffer_sec * 0.5;
+   else if (target_ms < buffer_sec * 900.0)
+      audio_driver_st.rate_control_target = target_ms / 1000.0;
+   else
+      audio_driver_st.rate_control_target = buffer_sec * 0.9;
 }
 
 #ifdef HAVE_REWIND
@@ -2184,6 +2225,8 @@ bool microphone_driver_init_internal(void *settings_data)
 
    convert_s16_to_float_init_simd();
    convert_float_to_s16_init_simd();
+   convert_to_dual_mono_float_init_simd();
+   convert_to_mono_float_left_init_simd();
 
    if (!(microphone_driver_find_driver(settings,
                "microphone driver", verbosity_enabled)))
@@ -41,6 +41,7 @@
 #include <audio/audio_resampler.h>
 
 #include "audio_defines.h"
+#include "audio_rate_control.h"
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
@@ -230,6 +231,12 @@ typedef struct
 
    unsigned free_samples_buf[AUDIO_BUFFER_FREE_SAMPLES_COUNT];
 
+   audio_rate_control_t rate_control;
+   /* Duration of one byte of the driver buffer, seconds */
+   double rate_control_sec_per_byte;
+   /* Queued audio rate control steers towards, seconds */
+   double rate_control_target;
+
 #ifdef HAVE_AUDIOMIXER
    float mixer_volume_gain;
 #endif
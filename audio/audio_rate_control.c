@@ -0,0 +1,149 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "audio_rate_control.h"
+
+/* Model, with the queue f in seconds and time t in seconds:
+ *
+ *   df/dt = adjust - drift
+ *
+ * The state [f, drift] is estimated from noisy measurements of f.
+ * Drift is modelled as a slow random walk, f as the integral of the
+ * rate mismatch plus white noise from bursty production.
+ *
+ * With drift cancelled, the remaining loop is f' = -(f - target) / TAU,
+ * so a queue that is off target recovers with time constant TAU. */
+
+/* Time constant of the latency correction, seconds */
+#define AUDIO_RATE_CONTROL_TAU         2.0
+
+/* Process noise of the queue (s^2 per s) and of the drift (per s) */
+#define AUDIO_RATE_CONTROL_Q_FILL      (0.002 * 0.002)
+#define AUDIO_RATE_CONTROL_Q_DRIFT     (0.0002 * 0.0002)
+
+/* Bounds and adaptation rate of the measurement noise variance.
+ * Device periods make the measured queue a sawtooth whose size
+ * depends on the driver, so it is learned from the innovations */
+#define AUDIO_RATE_CONTROL_NOISE_MIN   (0.0005 * 0.0005)
+#define AUDIO_RATE_CONTROL_NOISE_MAX   (0.050 * 0.050)
+#define AUDIO_RATE_CONTROL_NOISE_INIT  (0.005 * 0.005)
+#define AUDIO_RATE_CONTROL_NOISE_RATE  0.02
+
+/* Innovations beyond this many standard deviations are steps
+ * of the queue rather than noise */
+#define AUDIO_RATE_CONTROL_GATE        4.0
+
+/* Longer gaps between updates are treated as an interruption */
+#define AUDIO_RATE_CONTROL_MAX_GAP     250000
+
+static double audio_rate_control_clamp(double v, double lim)
+{
+   if (v > lim)
+      return lim;
+   if (v < -lim)
+      return -lim;
+   return v;
+}
+
+void audio_rate_control_init(audio_rate_control_t *rc, double max_adjust)
+{
+   memset(rc, 0, sizeof(*rc));
+   rc->max_adjust = max_adjust > 0.0 ? max_adjust : 0.0;
+   rc->noise      = AUDIO_RATE_CONTROL_NOISE_INIT;
+}
+
+void audio_rate_control_resync(audio_rate_control_t *rc)
+{
+   rc->primed = false;
+}
+
+double audio_rate_control_update(audio_rate_control_t *rc,
+      double queued, double target, int64_t now_usec)
+{
+   double dt, y, s, k0, k1, p00, p01, p11, err;
+
+   if (rc->max_adjust <= 0.0)
+      return 0.0;
+
+   if (     !rc->primed
+         || now_usec <= rc->last_usec
+         || now_usec - rc->last_usec > AUDIO_RATE_CONTROL_MAX_GAP)
+   {
+      /* Start over from the measurement. Drift is a property
+       * of the clocks involved and survives interruptions,
+       * but is trusted less afterwards */
+      rc->fill      = queued;
+      rc->p00       = rc->noise;
+      rc->p01       = 0.0;
+      if (rc->p11 < rc->max_adjust * rc->max_adjust * 0.25)
+         rc->p11    = rc->max_adjust * rc->max_adjust * 0.25;
+      rc->last_usec = now_usec;
+      rc->primed    = true;
+   }
+   else
+   {
+      dt            = (double)(now_usec - rc->last_usec) / 1000000.0;
+      rc->last_usec = now_usec;
+
+      /* Predict with the adjustment in effect since last time */
+      rc->fill     += (rc->adjust - rc->drift) * dt;
+      p00           = rc->p00 - dt * 2.0 * rc->p01 + dt * dt * rc->p11
+         + AUDIO_RATE_CONTROL_Q_FILL * dt;
+      p01           = rc->p01 - dt * rc->p11;
+      p11           = rc->p11 + AUDIO_RATE_CONTROL_Q_DRIFT * dt;
+
+      /* Correct with the measured queue */
+      y             = queued - rc->fill;
+      s             = p00 + rc->noise;
+
+      if (y * y > AUDIO_RATE_CONTROL_GATE * AUDIO_RATE_CONTROL_GATE * s)
+      {
+         /* A late frame or a skipped device period moves the
+          * queue in one go. Take the new level, but do not
+          * let it pass for drift */
+         rc->fill   = queued;
+         rc->p00    = p00 > rc->noise ? p00 : rc->noise;
+         rc->p01    = 0.0;
+         rc->p11    = p11;
+      }
+      else
+      {
+         k0         = p00 / s;
+         k1         = p01 / s;
+
+         rc->fill  += k0 * y;
+         rc->drift += k1 * y;
+         rc->p00    = (1.0 - k0) * p00;
+         rc->p01    = (1.0 - k0) * p01;
+         rc->p11    = p11 - k1 * p01;
+
+         /* Innovations larger than the predicted spread mean
+          * the measurements are noisier than assumed */
+         rc->noise += AUDIO_RATE_CONTROL_NOISE_RATE * (y * y - p00 - rc->noise);
+         if (rc->noise < AUDIO_RATE_CONTROL_NOISE_MIN)
+            rc->noise = AUDIO_RATE_CONTROL_NOISE_MIN;
+         else if (rc->noise > AUDIO_RATE_CONTROL_NOISE_MAX)
+            rc->noise = AUDIO_RATE_CONTROL_NOISE_MAX;
+      }
+   }
+
+   rc->drift  = audio_rate_control_clamp(rc->drift, rc->max_adjust);
+
+   err        = rc->fill - target;
+   rc->adjust = audio_rate_control_clamp(
+         rc->drift - err / AUDIO_RATE_CONTROL_TAU, rc->max_adjust);
+   return rc->adjust;
+}
@@ -0,0 +1,90 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __AUDIO_RATE_CONTROL_H
+#define __AUDIO_RATE_CONTROL_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Dynamic rate control.
+ *
+ * The audio device drains the buffer at its own clock, which never
+ * exactly matches the rate the core produces samples at once video
+ * pacing is taken into account. Left alone the buffer slowly fills
+ * up or runs dry. The controller tracks two things from the buffer
+ * fill measured on every flush, using a Kalman filter:
+ *
+ * - how much audio is really queued, with the jitter of device
+ *   periods and frame pacing filtered out;
+ * - the relative drift between production and consumption.
+ *
+ * The resampling ratio is then adjusted by the estimated drift, plus
+ * a proportional correction that walks the queue back to the target
+ * latency. Since drift is cancelled explicitly, the correction can
+ * be gentle and the pitch stays steady, while the buffer still does
+ * not creep towards an underrun. */
+
+typedef struct audio_rate_control
+{
+   double fill;            /* Estimated queued audio, seconds */
+   double drift;           /* Estimated consumption / production - 1 */
+   double p00;             /* Estimate covariance */
+   double p01;
+   double p11;
+   double noise;           /* Measurement noise variance, adapted */
+   double adjust;          /* Adjustment in effect since last update */
+   double max_adjust;
+   int64_t last_usec;
+   bool primed;
+} audio_rate_control_t;
+
+/**
+ * audio_rate_control_init:
+ * @rc          : Controller.
+ * @max_adjust  : Largest relative change of the rate, the
+ *                "audio_rate_control_delta" setting.
+ **/
+void audio_rate_control_init(audio_rate_control_t *rc, double max_adjust);
+
+/**
+ * audio_rate_control_resync:
+ * @rc          : Controller.
+ *
+ * Takes the next measurement as is, keeping the drift estimate.
+ * Call after the audio stream was interrupted or ran at another
+ * speed (pause, fast-forward, slow motion).
+ **/
+void audio_rate_control_resync(audio_rate_control_t *rc);
+
+/**
+ * audio_rate_control_update:
+ * @rc          : Controller.
+ * @queued      : Audio currently queued in the driver, seconds.
+ * @target      : Desired queued audio, seconds.
+ * @now_usec    : Monotonic time of the measurement.
+ *
+ * @return relative rate adjustment to apply until the next update:
+ * produce (1 + adjustment) times as many output frames.
+ **/
+double audio_rate_control_update(audio_rate_control_t *rc,
+      double queued, double target, int64_t now_usec);
+
+RETRO_END_DECLS
+
+#endif
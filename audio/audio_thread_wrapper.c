@@ -62,6 +62,8 @@ static void audio_thread_loop(void *data)
    if (!thr)
       return;
 
+   sthread_role_apply(STHREAD_ROLE_AUDIO);
+
    thr->driver_data   = thr->driver->init(
          thr->device, thr->out_rate, thr->latency,
          thr->block_frames, thr->new_rate);
@@ -41,6 +41,7 @@
 #endif
 
 #include "cheat_manager.h"
+#include "cheat_program.h"
 
 #include "msg_hash.h"
 #include "retroarch.h"
@@ -52,6 +53,14 @@
 /* TODO/FIXME - public global variables */
 cheat_manager_t cheat_manager_state;
 
+/* Compiled cheats point into the cheat list and into core
+ * memory, they are compiled again once either changed */
+static void cheat_manager_invalidate_program(cheat_manager_t *cheat_st)
+{
+   cheat_program_free(cheat_st->program);
+   cheat_st->program = NULL;
+}
+
 unsigned cheat_manager_get_buf_size(void)
 {
    cheat_manager_t *cheat_st = &cheat_manager_state;
@@ -285,6 +294,7 @@ bool cheat_manager_copy_working_to_idx(unsigned idx)
 
    memcpy(&cheat_st->cheats[idx], &cheat_st->working_cheat,
          sizeof(struct item_cheat));
+   cheat_manager_invalidate_program(cheat_st);
 
    if (cheat_st->cheats[idx].desc)
       free(cheat_st->cheats[idx].desc);
@@ -304,6 +314,8 @@ static void cheat_manager_free(void)
    unsigned i = 0;
    cheat_manager_t *cheat_st   = &cheat_manager_state;
 
+   cheat_manager_invalidate_program(cheat_st);
+
    if (cheat_st->cheats)
    {
       for (i = 0; i < cheat_st->size; i++)
@@ -539,6 +551,8 @@ bool cheat_manager_realloc(unsigned new_size, unsigned default_handler)
    unsigned        orig_size = 0;
    cheat_manager_t *cheat_st = &cheat_manager_state;
 
+   cheat_manager_invalidate_program(cheat_st);
+
    if (!cheat_st->cheats)
    {
       cheat_st->cheats = (struct item_cheat*)
@@ -627,6 +641,7 @@ void cheat_manager_toggle_index(bool apply_cheats_after_toggle,
       return;
 
    cheat_st->cheats[i].state = !cheat_st->cheats[i].state;
+   cheat_manager_invalidate_program(cheat_st);
    cheat_manager_update(cheat_st, i);
 
    if (apply_cheats_after_toggle)
@@ -640,6 +655,7 @@ void cheat_manager_toggle(bool notification_show_cheats_applied)
       return;
 
    cheat_st->cheats[cheat_st->ptr].state ^= true;
+   cheat_manager_invalidate_program(cheat_st);
    cheat_manager_apply_cheats(notification_show_cheats_applied);
    cheat_manager_update(cheat_st, cheat_st->ptr);
 }
@@ -772,6 +788,8 @@ int cheat_manager_initialize_memory(rarch_setting_t *setting, size_t idx, bool w
    struct menu_state *menu_st             = menu_state_get_ptr();
 #endif
 
+   cheat_manager_invalidate_program(cheat_st);
+
    cheat_st->num_memory_buffers           = 0;
    cheat_st->total_memory_size            = 0;
    cheat_st->curr_memory_buf              = NULL;
@@ -1388,201 +1406,36 @@ void cheat_manager_apply_rumble(struct item_cheat *cheat, unsigned int curr_valu
 
 void cheat_manager_apply_retro_cheats(void)
 {
-   unsigned i;
-   unsigned int offset;
-   unsigned int mask           = 0;
-   unsigned int bytes_per_item = 1;
-   unsigned int bits           = 8;
-   unsigned int curr_val       = 0;
-   bool run_cheat              = true;
-#ifdef HAVE_CHEEVOS
-   bool cheat_applied          = false;
-#endif
    cheat_manager_t   *cheat_st = &cheat_manager_state;
 
    if ((!cheat_st->cheats))
       return;
 
-   for (i = 0; i < cheat_st->size; i++)
+   if (!cheat_st->program)
    {
-      unsigned char *curr       = NULL;
-      bool set_value            = false;
-      unsigned int idx          = 0;
-      unsigned int value_to_set = 0;
-      unsigned int repeat_iter  = 0;
-      unsigned int address_mask = cheat_st->cheats[i].address_mask;
-
-      if (cheat_st->cheats[i].handler != CHEAT_HANDLER_TYPE_RETRO || !cheat_st->cheats[i].state)
-         continue;
-      if (!cheat_st->memory_initialized)
-         cheat_manager_initialize_memory(NULL, 0, false);
-
-      /* If we're still not initialized, something
-       * must have gone wrong - just bail */
-      if (!cheat_st->memory_initialized)
-         return;
-
-      if (!run_cheat)
+      if (     !cheat_st->memory_initialized
+            &&  cheat_program_needed(cheat_st))
       {
-         run_cheat = true;
-         continue;
-      }
-      cheat_manager_setup_search_meta(cheat_st->cheats[i].memory_search_size, &bytes_per_item, &mask, &bits);
-
-      curr   = cheat_st->curr_memory_buf;
-      idx    = cheat_st->cheats[i].address;
-
-      offset = translate_address(idx, &curr);
-
-      switch (bytes_per_item)
-      {
-         case 2:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256) + *(curr + idx + 1 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256);
-            break;
-         case 4:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256 * 256 * 256) + (*(curr + idx + 1 - offset) * 256 * 256) + (*(curr + idx + 2 - offset) * 256) + *(curr + idx + 3 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256) + (*(curr + idx + 2 - offset) * 256 * 256) + (*(curr + idx + 3 - offset) * 256 * 256 * 256);
-            break;
-         case 1:
-         default:
-            curr_val = *(curr + idx - offset);
-            break;
-      }
-
-      cheat_manager_apply_rumble(&cheat_st->cheats[i], curr_val);
+         cheat_manager_initialize_memory(NULL, 0, false);
 
-      switch (cheat_st->cheats[i].cheat_type)
-      {
-         case CHEAT_TYPE_SET_TO_VALUE:
-            set_value = true;
-            value_to_set = cheat_st->cheats[i].value;
-            break;
-         case CHEAT_TYPE_INCREASE_VALUE:
-            set_value = true;
-            value_to_set = curr_val + cheat_st->cheats[i].value;
-            break;
-         case CHEAT_TYPE_DECREASE_VALUE:
-            set_value = true;
-            value_to_set = curr_val - cheat_st->cheats[i].value;
-            break;
-         case CHEAT_TYPE_RUN_NEXT_IF_EQ:
-            if (!(curr_val == cheat_st->cheats[i].value))
-               run_cheat = false;
-            break;
-         case CHEAT_TYPE_RUN_NEXT_IF_NEQ:
-            if (!(curr_val != cheat_st->cheats[i].value))
-               run_cheat = false;
-            break;
-         case CHEAT_TYPE_RUN_NEXT_IF_LT:
-            if (!(cheat_st->cheats[i].value < curr_val))
-               run_cheat = false;
-            break;
-         case CHEAT_TYPE_RUN_NEXT_IF_GT:
-            if (!(cheat_st->cheats[i].value > curr_val))
-               run_cheat = false;
-            break;
+         /* If we're still not initialized, something
+          * must have gone wrong - just bail */
+         if (!cheat_st->memory_initialized)
+            return;
       }
 
-      if (set_value)
-      {
-#ifdef HAVE_CHEEVOS
-         cheat_applied = true;
-#endif
-         for (repeat_iter = 1; repeat_iter <= cheat_st->cheats[i].repeat_count; repeat_iter++)
-         {
-            switch (bytes_per_item)
-            {
-               case 2:
-                  if (cheat_st->cheats[i].big_endian)
-                  {
-                     *(curr + idx - offset) = (value_to_set >> 8) & 0xFF;
-                     *(curr + idx + 1 - offset) = value_to_set & 0xFF;
-                  }
-                  else
-                  {
-                     *(curr + idx - offset) = value_to_set & 0xFF;
-                     *(curr + idx + 1 - offset) = (value_to_set >> 8) & 0xFF;
-                  }
-                  break;
-               case 4:
-                  if (cheat_st->cheats[i].big_endian)
-                  {
-                     *(curr + idx - offset) = (value_to_set >> 24) & 0xFF;
-                     *(curr + idx + 1 - offset) = (value_to_set >> 16) & 0xFF;
-                     *(curr + idx + 2 - offset) = (value_to_set >> 8) & 0xFF;
-                     *(curr + idx + 3 - offset) = value_to_set & 0xFF;
-                  }
-                  else
-                  {
-                     *(curr + idx - offset) = value_to_set & 0xFF;
-                     *(curr + idx + 1 - offset) = (value_to_set >> 8) & 0xFF;
-                     *(curr + idx + 2 - offset) = (value_to_set >> 16) & 0xFF;
-                     *(curr + idx + 3 - offset) = (value_to_set >> 24) & 0xFF;
-                  }
-                  break;
-               case 1:
-                  if (bits < 8)
-                  {
-                     unsigned bitpos;
-                     unsigned char val = *(curr + idx - offset);
-
-                     for (bitpos = 0; bitpos < 8; bitpos++)
-                     {
-                        if ((address_mask >> bitpos) & 0x01)
-                        {
-                           mask = (~(1 << bitpos) & 0xFF);
-                           /* Clear current bit value */
-                           val = val & mask;
-                           /* Inject cheat bit value */
-                           val = val | (((value_to_set >> bitpos) & 0x01) << bitpos);
-                        }
-                     }
-
-                     *(curr + idx - offset) = val;
-                  }
-                  else
-                     *(curr + idx - offset) = value_to_set & 0xFF;
-                  break;
-               default:
-                  *(curr + idx - offset) = value_to_set & 0xFF;
-                  break;
-            }
-
-            value_to_set += cheat_st->cheats[i].repeat_add_to_value;
-
-            if (mask != 0)
-               value_to_set = value_to_set % mask;
-
-            if (bits < 8)
-            {
-               unsigned int bit_iter;
-               for (bit_iter = 0; bit_iter < cheat_st->cheats[i].repeat_add_to_address; bit_iter++)
-               {
-                  address_mask = (address_mask << mask) & 0xFF;
-
-                  if (address_mask == 0)
-                  {
-                     address_mask = mask;
-                     idx++;
-                  }
-               }
-            }
-            else
-               idx += (cheat_st->cheats[i].repeat_add_to_address * bytes_per_item);
-
-            idx = idx % cheat_st->total_memory_size;
-
-            offset = translate_address(idx, &curr);
-         }
-      }
+      if (!(cheat_st->program = cheat_program_new(cheat_st)))
+         return;
    }
 
 #ifdef HAVE_CHEEVOS
-   if (cheat_applied && rcheevos_hardcore_active())
+   if (     cheat_program_apply(cheat_st->program,
+               cheat_st->big_endian, cheat_manager_apply_rumble)
+         && rcheevos_hardcore_active())
       cheat_manager_pause_cheevos();
+#else
+   cheat_program_apply(cheat_st->program,
+         cheat_st->big_endian, cheat_manager_apply_rumble);
 #endif
 }
 
@@ -155,10 +155,15 @@ struct item_cheat
    bool big_endian;
 };
 
+struct cheat_program;
+
 struct cheat_manager
 {
    struct item_cheat working_cheat; /* retro_time_t alignment */
    struct item_cheat *cheats;
+   /* Enabled RetroArch cheats, compiled on first use
+    * after cheats or memory maps changed */
+   struct cheat_program *program;
    uint8_t *curr_memory_buf;
    uint8_t *prev_memory_buf;
    uint8_t *matches;
@@ -0,0 +1,424 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <retro_inline.h>
+
+#include "cheat_program.h"
+
+enum cheat_write_kind
+{
+   CHEAT_WRITE_NONE = 0,
+   CHEAT_WRITE_BYTE,
+   CHEAT_WRITE_BITS,
+   CHEAT_WRITE_LE16,
+   CHEAT_WRITE_BE16,
+   CHEAT_WRITE_LE32,
+   CHEAT_WRITE_BE32
+};
+
+typedef struct cheat_write
+{
+   uint8_t *ptr;
+   /* Value written, for CHEAT_TYPE_SET_TO_VALUE */
+   unsigned value;
+   /* Modulo of the value carried to the next repeat, if not 0 */
+   unsigned mod;
+   /* Bits written by CHEAT_WRITE_BITS */
+   uint8_t bits;
+} cheat_write_t;
+
+typedef struct cheat_op
+{
+   uint8_t *ptr;
+   /* NULL if the cheat has no rumble set up */
+   struct item_cheat *rumble;
+   const cheat_write_t *writes;
+   unsigned num_writes;
+   unsigned value;
+   unsigned repeat_add_to_value;
+   uint8_t cheat_type;
+   uint8_t read_size;
+   uint8_t write_kind;
+} cheat_op_t;
+
+struct cheat_program
+{
+   cheat_op_t *ops;
+   cheat_write_t *writes;
+   size_t num_ops;
+};
+
+/* Search size state carried from one cheat to the next,
+ * as cheat_manager_apply_retro_cheats() did */
+typedef struct cheat_meta
+{
+   unsigned bytes_per_item;
+   unsigned bits;
+   unsigned mask;
+} cheat_meta_t;
+
+static bool cheat_program_is_compiled(const struct item_cheat *cheat)
+{
+   return cheat->handler == CHEAT_HANDLER_TYPE_RETRO && cheat->state;
+}
+
+static bool cheat_program_writes(const struct item_cheat *cheat)
+{
+   return cheat->cheat_type == CHEAT_TYPE_SET_TO_VALUE
+      ||  cheat->cheat_type == CHEAT_TYPE_INCREASE_VALUE
+      ||  cheat->cheat_type == CHEAT_TYPE_DECREASE_VALUE;
+}
+
+static void cheat_program_setup_meta(cheat_meta_t *meta,
+      unsigned memory_search_size)
+{
+   static const unsigned bytes_per_item[] = { 1, 1, 1, 1, 2, 4 };
+   static const unsigned bits[]           = { 1, 2, 4, 8, 8, 8 };
+   static const unsigned mask[]           = {
+      0x01, 0x03, 0x0F, 0xFF, 0xFFFF, 0xFFFFFFFF };
+
+   /* Other sizes keep the state of the previous cheat */
+   if (memory_search_size >= sizeof(mask) / sizeof(mask[0]))
+      return;
+
+   meta->bytes_per_item = bytes_per_item[memory_search_size];
+   meta->bits           = bits[memory_search_size];
+   meta->mask           = mask[memory_search_size];
+}
+
+/* Address @address falls in, relative to the buffer it
+ * is found in. Out of range addresses stay relative
+ * to @curr, past the end of all buffers */
+static uint8_t *cheat_program_resolve(const cheat_manager_t *cheat_st,
+      unsigned address, uint8_t **curr)
+{
+   unsigned i;
+   unsigned offset = 0;
+
+   for (i = 0; i < cheat_st->num_memory_buffers; i++)
+   {
+      if (     (address >= offset)
+            && (address <  offset + cheat_st->memory_size_list[i]))
+      {
+         *curr = cheat_st->memory_buf_list[i];
+         break;
+      }
+      offset += cheat_st->memory_size_list[i];
+   }
+
+   return *curr + address - offset;
+}
+
+static enum cheat_write_kind cheat_program_write_kind(
+      const struct item_cheat *cheat, const cheat_meta_t *meta)
+{
+   switch (meta->bytes_per_item)
+   {
+      case 2:
+         return cheat->big_endian ? CHEAT_WRITE_BE16 : CHEAT_WRITE_LE16;
+      case 4:
+         return cheat->big_endian ? CHEAT_WRITE_BE32 : CHEAT_WRITE_LE32;
+      case 1:
+         if (meta->bits < 8)
+            return CHEAT_WRITE_BITS;
+         break;
+      default:
+         break;
+   }
+   return CHEAT_WRITE_BYTE;
+}
+
+/* Expands the repeats of @cheat into @writes, following
+ * the same address and value steps as the interpreter */
+static void cheat_program_expand(const cheat_manager_t *cheat_st,
+      const struct item_cheat *cheat, cheat_meta_t *meta,
+      uint8_t *curr, cheat_write_t *writes)
+{
+   unsigned i;
+   unsigned idx          = cheat->address;
+   unsigned address_mask = cheat->address_mask;
+   unsigned value        = cheat->value;
+   uint8_t *ptr          = cheat_program_resolve(cheat_st, idx, &curr);
+   bool bit_write        = meta->bytes_per_item == 1 && meta->bits < 8;
+
+   for (i = 0; i < cheat->repeat_count; i++)
+   {
+      cheat_write_t *write = &writes[i];
+
+      write->ptr   = ptr;
+      write->value = value;
+      write->bits  = (uint8_t)(address_mask & 0xFF);
+
+      if (bit_write)
+      {
+         unsigned bitpos;
+         /* Writing bits reuses the search size mask */
+         for (bitpos = 0; bitpos < 8; bitpos++)
+            if ((address_mask >> bitpos) & 0x01)
+               meta->mask = (~(1 << bitpos) & 0xFF);
+      }
+
+      value += cheat->repeat_add_to_value;
+      if (meta->mask != 0)
+         value = value % meta->mask;
+      write->mod = meta->mask;
+
+      if (meta->bits < 8)
+      {
+         unsigned bit_iter;
+         for (bit_iter = 0; bit_iter < cheat->repeat_add_to_address; bit_iter++)
+         {
+            address_mask = (address_mask << meta->mask) & 0xFF;
+
+            if (address_mask == 0)
+            {
+               address_mask = meta->mask;
+               idx++;
+            }
+         }
+      }
+      else
+         idx += cheat->repeat_add_to_address * meta->bytes_per_item;
+
+      idx = idx % cheat_st->total_memory_size;
+      ptr = cheat_program_resolve(cheat_st, idx, &curr);
+   }
+}
+
+bool cheat_program_needed(const cheat_manager_t *cheat_st)
+{
+   unsigned i;
+
+   if (cheat_st->cheats)
+      for (i = 0; i < cheat_st->size; i++)
+         if (cheat_program_is_compiled(&cheat_st->cheats[i]))
+            return true;
+
+   return false;
+}
+
+cheat_program_t *cheat_program_new(const cheat_manager_t *cheat_st)
+{
+   unsigned i;
+   cheat_meta_t meta;
+   size_t num_ops           = 0;
+   size_t num_writes        = 0;
+   cheat_program_t *program = (cheat_program_t*)
+         calloc(1, sizeof(*program));
+
+   if (!program)
+      return NULL;
+
+   for (i = 0; cheat_st->cheats && i < cheat_st->size; i++)
+   {
+      const struct item_cheat *cheat = &cheat_st->cheats[i];
+
+      if (!cheat_program_is_compiled(cheat))
+         continue;
+
+      num_ops++;
+      if (cheat_program_writes(cheat))
+         num_writes += cheat->repeat_count;
+   }
+
+   if (!num_ops)
+      return program;
+
+   if (     !cheat_st->memory_initialized
+         || !(program->ops = (cheat_op_t*)
+               calloc(num_ops, sizeof(cheat_op_t)))
+         || (num_writes && !(program->writes = (cheat_write_t*)
+               calloc(num_writes, sizeof(cheat_write_t)))))
+   {
+      cheat_program_free(program);
+      return NULL;
+   }
+
+   meta.bytes_per_item = 1;
+   meta.bits           = 8;
+   meta.mask           = 0;
+   num_writes          = 0;
+
+   for (i = 0; i < cheat_st->size; i++)
+   {
+      struct item_cheat *cheat = &cheat_st->cheats[i];
+      cheat_op_t *op           = NULL;
+      uint8_t *curr            = cheat_st->curr_memory_buf;
+
+      if (!cheat_program_is_compiled(cheat))
+         continue;
+
+      cheat_program_setup_meta(&meta, cheat->memory_search_size);
+
+      op                      = &program->ops[program->num_ops++];
+      op->ptr                 = cheat_program_resolve(cheat_st,
+            cheat->address, &curr);
+      op->rumble              = (cheat->rumble_type != RUMBLE_TYPE_DISABLED)
+            ? cheat : NULL;
+      op->value               = cheat->value;
+      op->repeat_add_to_value = cheat->repeat_add_to_value;
+      op->cheat_type          = (uint8_t)cheat->cheat_type;
+      op->read_size           = (uint8_t)meta.bytes_per_item;
+
+      if (cheat_program_writes(cheat))
+      {
+         op->write_kind = (uint8_t)cheat_program_write_kind(cheat, &meta);
+         op->writes     = program->writes + num_writes;
+         op->num_writes = cheat->repeat_count;
+         cheat_program_expand(cheat_st, cheat, &meta, curr,
+               program->writes + num_writes);
+         num_writes    += cheat->repeat_count;
+      }
+   }
+
+   return program;
+}
+
+void cheat_program_free(cheat_program_t *program)
+{
+   if (!program)
+      return;
+   free(program->ops);
+   free(program->writes);
+   free(program);
+}
+
+static unsigned cheat_program_read(const uint8_t *p, unsigned size,
+      bool big_endian)
+{
+   switch (size)
+   {
+      case 2:
+         return big_endian
+            ? (p[0] << 8) | p[1]
+            :  p[0] | (p[1] << 8);
+      case 4:
+         return big_endian
+            ? ((unsigned)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]
+            :  p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+      default:
+         break;
+   }
+   return p[0];
+}
+
+static INLINE void cheat_program_write(uint8_t *p,
+      enum cheat_write_kind kind, unsigned value, uint8_t bits)
+{
+   switch (kind)
+   {
+      case CHEAT_WRITE_BITS:
+         p[0] = (uint8_t)((p[0] & ~bits) | (value & bits));
+         break;
+      case CHEAT_WRITE_LE16:
+         p[0] = value & 0xFF;
+         p[1] = (value >> 8) & 0xFF;
+         break;
+      case CHEAT_WRITE_BE16:
+         p[0] = (value >> 8) & 0xFF;
+         p[1] = value & 0xFF;
+         break;
+      case CHEAT_WRITE_LE32:
+         p[0] = value & 0xFF;
+         p[1] = (value >> 8) & 0xFF;
+         p[2] = (value >> 16) & 0xFF;
+         p[3] = (value >> 24) & 0xFF;
+         break;
+      case CHEAT_WRITE_BE32:
+         p[0] = (value >> 24) & 0xFF;
+         p[1] = (value >> 16) & 0xFF;
+         p[2] = (value >> 8) & 0xFF;
+         p[3] = value & 0xFF;
+         break;
+      default:
+         p[0] = value & 0xFF;
+         break;
+   }
+}
+
+bool cheat_program_apply(const cheat_program_t *program,
+      bool big_endian, cheat_program_rumble_t rumble)
+{
+   size_t i;
+   bool skip    = false;
+   bool applied = false;
+
+   if (!program)
+      return false;
+
+   for (i = 0; i < program->num_ops; i++)
+   {
+      unsigned j, value;
+      const cheat_op_t *op = &program->ops[i];
+
+      /* A failed condition skips the next cheat */
+      if (skip)
+      {
+         skip = false;
+         continue;
+      }
+
+      value = cheat_program_read(op->ptr, op->read_size, big_endian);
+
+      if (op->rumble && rumble)
+         rumble(op->rumble, value);
+
+      switch (op->cheat_type)
+      {
+         case CHEAT_TYPE_SET_TO_VALUE:
+            applied = true;
+            for (j = 0; j < op->num_writes; j++)
+               cheat_program_write(op->writes[j].ptr,
+                     (enum cheat_write_kind)op->write_kind,
+                     op->writes[j].value, op->writes[j].bits);
+            break;
+         case CHEAT_TYPE_INCREASE_VALUE:
+         case CHEAT_TYPE_DECREASE_VALUE:
+            applied = true;
+            value   = (op->cheat_type == CHEAT_TYPE_INCREASE_VALUE)
+               ? value + op->value
+               : value - op->value;
+            for (j = 0; j < op->num_writes; j++)
+            {
+               const cheat_write_t *write = &op->writes[j];
+               cheat_program_write(write->ptr,
+                     (enum cheat_write_kind)op->write_kind,
+                     value, write->bits);
+               value += op->repeat_add_to_value;
+               if (write->mod)
+                  value = value % write->mod;
+            }
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_EQ:
+            skip = !(value == op->value);
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_NEQ:
+            skip = !(value != op->value);
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_LT:
+            skip = !(op->value < value);
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_GT:
+            skip = !(op->value > value);
+            break;
+         default:
+            break;
+      }
+   }
+
+   return applied;
+}
@@ -0,0 +1,70 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CHEAT_PROGRAM_H
+#define __CHEAT_PROGRAM_H
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+#include "cheat_manager.h"
+
+RETRO_BEGIN_DECLS
+
+/* Active RetroArch cheats, compiled for applying them every frame.
+ *
+ * Each enabled CHEAT_HANDLER_TYPE_RETRO cheat becomes one operation
+ * with its memory already resolved to a pointer, and each of its
+ * repeats to a write with its own pointer, bit mask and, for
+ * CHEAT_TYPE_SET_TO_VALUE, the value to write. Applying a program
+ * does exactly what interpreting the cheats does, without looking up
+ * memory buffers or search sizes again.
+ *
+ * A program holds pointers into the cheats and into core memory: it
+ * must be built again whenever either changes. */
+
+typedef struct cheat_program cheat_program_t;
+
+typedef void (*cheat_program_rumble_t)(struct item_cheat *cheat,
+      unsigned int value);
+
+/**
+ * cheat_program_new:
+ * @cheat_st    : Cheats and the core memory they apply to. Memory
+ *                must be initialised if any RetroArch cheat is on.
+ *
+ * Returns: program, or NULL on allocation failure.
+ **/
+cheat_program_t *cheat_program_new(const cheat_manager_t *cheat_st);
+
+void cheat_program_free(cheat_program_t *program);
+
+/* Returns: true if any cheat of @cheat_st would be compiled */
+bool cheat_program_needed(const cheat_manager_t *cheat_st);
+
+/**
+ * cheat_program_apply:
+ * @program     : Program.
+ * @big_endian  : Whether core memory is read as big endian.
+ * @rumble      : Called with the value read by every cheat run
+ *                that has rumble set up.
+ *
+ * Returns: true if any cheat wrote to memory.
+ **/
+bool cheat_program_apply(const cheat_program_t *program,
+      bool big_endian, cheat_program_rumble_t rumble);
+
+RETRO_END_DECLS
+
+#endif
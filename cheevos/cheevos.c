@@ -89,6 +89,10 @@ static rcheevos_locals_t rcheevos_locals =
 {
    NULL, /* client */
    {{0}},/* memory */
+   {0},  /* memory_pages */
+   0,    /* eval_usec_total */
+   0,    /* eval_usec_peak */
+   0,    /* eval_frames */
 #ifdef HAVE_THREADS
    CMD_EVENT_NONE, /* queued_command */
 #endif
@@ -183,6 +187,10 @@ static int rcheevos_init_memory(rcheevos_locals_t* locals)
    result = rc_libretro_memory_init(&locals->memory, &mmap,
          rcheevos_get_core_memory_info, console_id);
 
+   rcheevos_memory_pages_free(&locals->memory_pages);
+   if (result)
+      rcheevos_memory_pages_init(&locals->memory_pages, &locals->memory);
+
    free(descriptors);
    return result;
 }
@@ -193,7 +201,7 @@ uint8_t* rcheevos_patch_address(unsigned address)
     * (no achievements for this game?), try now */
    if (rcheevos_locals.memory.count == 0)
       rcheevos_init_memory(&rcheevos_locals);
-   return rc_libretro_memory_find(&rcheevos_locals.memory, address);
+   return rcheevos_memory_pages_find(&rcheevos_locals.memory_pages, address);
 }
 
 static bool rcheevos_is_game_loaded(void)
@@ -700,6 +708,18 @@ bool rcheevos_unload(void)
 
    if (rcheevos_locals.memory.count > 0)
       rc_libretro_memory_destroy(&rcheevos_locals.memory);
+   rcheevos_memory_pages_free(&rcheevos_locals.memory_pages);
+
+   if (rcheevos_locals.eval_frames)
+   {
+      CHEEVOS_LOG(RCHEEVOS_TAG "Evaluated %u frames, %.1f us average, %u us peak\n",
+            rcheevos_locals.eval_frames,
+            (double)rcheevos_locals.eval_usec_total / rcheevos_locals.eval_frames,
+            (unsigned)rcheevos_locals.eval_usec_peak);
+      rcheevos_locals.eval_usec_total = 0;
+      rcheevos_locals.eval_usec_peak  = 0;
+      rcheevos_locals.eval_frames     = 0;
+   }
 
    if (was_loaded)
    {
@@ -1007,7 +1027,23 @@ void rcheevos_test(void)
 #endif
 
    if (rcheevos_locals.memory.count != 0)
+   {
+      static struct retro_perf_counter rcheevos_frame_perf = {0};
+      bool perfcnt_enable  = runloop_state_get_ptr()->perfcnt_enable;
+      int64_t start        = cpu_features_get_time_usec();
+      int64_t elapsed;
+
+      performance_counter_init(rcheevos_frame_perf, "rcheevos_frame");
+      performance_counter_start_plus(perfcnt_enable, rcheevos_frame_perf);
       rc_client_do_frame(rcheevos_locals.client);
+      performance_counter_stop_plus(perfcnt_enable, rcheevos_frame_perf);
+
+      elapsed = cpu_features_get_time_usec() - start;
+      rcheevos_locals.eval_usec_total += elapsed;
+      if (elapsed > rcheevos_locals.eval_usec_peak)
+         rcheevos_locals.eval_usec_peak = elapsed;
+      rcheevos_locals.eval_frames++;
+   }
    else
       rc_client_idle(rcheevos_locals.client);
 }
@@ -1290,7 +1326,7 @@ static void rcheevos_show_game_placard(void)
 static uint32_t rcheevos_client_read_memory(uint32_t address,
    uint8_t* buffer, uint32_t num_bytes, rc_client_t* client)
 {
-   return rc_libretro_memory_read(&rcheevos_locals.memory, address, buffer, num_bytes);
+   return rcheevos_memory_pages_read(&rcheevos_locals.memory_pages, address, buffer, num_bytes);
 }
 
 static uint32_t rcheevos_client_read_memory_dummy(uint32_t address,
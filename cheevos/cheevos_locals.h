@@ -33,6 +33,8 @@
 #include "../command.h"
 #include "../verbosity.h"
 
+#include "cheevos_memory.h"
+
 RETRO_BEGIN_DECLS
 
 /************************************************************************
@@ -83,6 +85,11 @@ typedef struct rcheevos_locals_t
 {
    rc_client_t* client;               /* rcheevos client state */
    rc_libretro_memory_regions_t memory;/* achievement addresses to core memory mappings */
+   rcheevos_memory_pages_t memory_pages;/* page table over memory for O(1) lookups */
+
+   int64_t eval_usec_total;           /* time spent evaluating achievements since load */
+   int64_t eval_usec_peak;            /* longest evaluation of a single frame */
+   unsigned eval_frames;              /* frames evaluated since load */
 
 #ifdef HAVE_THREADS
    enum event_command queued_command; /* action queued by background thread to be run on main thread */
@@ -0,0 +1,168 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cheevos_memory.h"
+
+/* Pages are as large as the region boundaries allow, so that no page
+ * straddles two regions, within these bounds */
+#define RCHEEVOS_MEMORY_PAGE_SHIFT_MIN   6
+#define RCHEEVOS_MEMORY_PAGE_SHIFT_MAX   12
+
+/* Beyond this many pages, larger pages are used even if some then
+ * straddle regions and have to fall back */
+#define RCHEEVOS_MEMORY_PAGES_MAX        (1 << 18)
+
+bool rcheevos_memory_pages_init(rcheevos_memory_pages_t *pages,
+      const rc_libretro_memory_regions_t *regions)
+{
+   uint32_t i, j;
+   uint64_t total       = 0;
+   uint64_t boundaries  = 0;
+   uint64_t region_start;
+   uint64_t region_end;
+   uint32_t shift;
+
+   memset(pages, 0, sizeof(*pages));
+   pages->regions = regions;
+
+   if (!regions)
+      return false;
+
+   for (i = 0; i < regions->count; i++)
+   {
+      if (i > 0)
+         boundaries |= total;
+      total += regions->size[i];
+   }
+
+   /* Addresses are 32-bit */
+   if (total == 0 || total > 0xFFFFFFFFull)
+      return false;
+
+   shift = RCHEEVOS_MEMORY_PAGE_SHIFT_MAX;
+   for (i = 0; i < shift; i++)
+   {
+      if (boundaries & ((uint64_t)1 << i))
+      {
+         shift = (i > RCHEEVOS_MEMORY_PAGE_SHIFT_MIN)
+            ? i : RCHEEVOS_MEMORY_PAGE_SHIFT_MIN;
+         break;
+      }
+   }
+   while ((total >> shift) >= RCHEEVOS_MEMORY_PAGES_MAX)
+      shift++;
+
+   pages->shift = shift;
+   pages->mask  = (1u << shift) - 1;
+   pages->count = (uint32_t)((total + pages->mask) >> shift);
+   pages->base  = (uint8_t**)calloc(pages->count, sizeof(*pages->base));
+   pages->avail = (uint32_t*)calloc(pages->count, sizeof(*pages->avail));
+
+   if (!pages->base || !pages->avail)
+   {
+      rcheevos_memory_pages_free(pages);
+      pages->regions = regions;
+      return false;
+   }
+
+   j            = 0;
+   region_start = 0;
+   region_end   = regions->size[0];
+
+   for (i = 0; i < pages->count; i++)
+   {
+      uint64_t page_start = (uint64_t)i << shift;
+      uint64_t page_end   = page_start + pages->mask + 1;
+
+      if (page_end > total)
+         page_end = total;
+
+      /* Find the region the page starts in, skipping empty ones */
+      while (page_start >= region_end && j + 1 < regions->count)
+      {
+         region_start  = region_end;
+         region_end   += regions->size[++j];
+      }
+
+      if (page_end > region_end)
+         continue;
+
+      /* A page without memory keeps a NULL base but a non-zero avail,
+       * which reads as unmapped without walking the regions */
+      if (regions->data[j])
+         pages->base[i]  = regions->data[j] + (page_start - region_start);
+      pages->avail[i]    = (uint32_t)(region_end - page_start);
+   }
+
+   return true;
+}
+
+void rcheevos_memory_pages_free(rcheevos_memory_pages_t *pages)
+{
+   free(pages->base);
+   free(pages->avail);
+   memset(pages, 0, sizeof(*pages));
+}
+
+uint8_t *rcheevos_memory_pages_find(const rcheevos_memory_pages_t *pages,
+      uint32_t address)
+{
+   uint32_t index = address >> pages->shift;
+
+   if (index < pages->count && pages->avail[index])
+   {
+      uint32_t offset = address & pages->mask;
+      if (!pages->base[index] || offset >= pages->avail[index])
+         return NULL;
+      return pages->base[index] + offset;
+   }
+
+   if (!pages->regions)
+      return NULL;
+   return rc_libretro_memory_find(pages->regions, address);
+}
+
+uint32_t rcheevos_memory_pages_read(const rcheevos_memory_pages_t *pages,
+      uint32_t address, uint8_t *buffer, uint32_t num_bytes)
+{
+   uint32_t index = address >> pages->shift;
+
+   if (index < pages->count)
+   {
+      const uint8_t *base = pages->base[index];
+      uint32_t offset     = address & pages->mask;
+      uint32_t avail      = pages->avail[index];
+
+      if (offset < avail && num_bytes <= avail - offset)
+      {
+         if (!base)
+            return 0;
+         if (num_bytes == 1)
+            *buffer = base[offset];
+         else
+            memcpy(buffer, base + offset, num_bytes);
+         return num_bytes;
+      }
+   }
+   /* Past the end of the table nothing is mapped */
+   else if (pages->count)
+      return 0;
+
+   if (!pages->regions)
+      return 0;
+   return rc_libretro_memory_read(pages->regions, address, buffer, num_bytes);
+}
@@ -0,0 +1,82 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_CHEEVOS_MEMORY_H
+#define __RARCH_CHEEVOS_MEMORY_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+#include "../deps/rcheevos/src/rc_libretro.h"
+
+RETRO_BEGIN_DECLS
+
+/* Page table over the achievement address space.
+ *
+ * rc_libretro lays the core's memory regions out back to back and
+ * resolves every address by walking the region list. For cores that
+ * expose many regions that walk runs for every memory reference on
+ * every frame. The page table is built once when the regions are set
+ * up and turns an address into a pointer with a single lookup.
+ *
+ * Each page also records how many bytes are contiguous from its start
+ * to the end of its region, so reads spanning several pages of the
+ * same region are a single copy. Pages that straddle two regions fall
+ * back to rc_libretro. */
+
+typedef struct rcheevos_memory_pages
+{
+   const rc_libretro_memory_regions_t *regions;
+   uint8_t **base;            /* Start of each page, NULL if unmapped */
+   uint32_t *avail;           /* Contiguous bytes from the page start,
+                                 0 to fall back */
+   uint32_t count;
+   uint32_t shift;
+   uint32_t mask;
+} rcheevos_memory_pages_t;
+
+/**
+ * rcheevos_memory_pages_init:
+ * @pages       : Page table to build.
+ * @regions     : Initialized rc_libretro regions, must outlive @pages.
+ *
+ * Returns: true if the table was built. When it was not, lookups
+ * fall back to rc_libretro.
+ **/
+bool rcheevos_memory_pages_init(rcheevos_memory_pages_t *pages,
+      const rc_libretro_memory_regions_t *regions);
+
+void rcheevos_memory_pages_free(rcheevos_memory_pages_t *pages);
+
+/**
+ * rcheevos_memory_pages_find:
+ *
+ * Same as rc_libretro_memory_find().
+ **/
+uint8_t *rcheevos_memory_pages_find(const rcheevos_memory_pages_t *pages,
+      uint32_t address);
+
+/**
+ * rcheevos_memory_pages_read:
+ *
+ * Same as rc_libretro_memory_read().
+ **/
+uint32_t rcheevos_memory_pages_read(const rcheevos_memory_pages_t *pages,
+      uint32_t address, uint8_t *buffer, uint32_t num_bytes);
+
+RETRO_END_DECLS
+
+#endif
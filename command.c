@@ -1328,6 +1328,24 @@ static size_t command_event_undo_save_state(char *s, size_t len)
          msg_hash_to_str(MSG_UNDOING_SAVE_STATE), len);
 }
 
+static size_t command_event_export_save_state(const char *path,
+      char *s, size_t len)
+{
+   size_t _len;
+   char out_path[PATH_MAX_LENGTH];
+
+   _len = strlcpy(out_path, path, sizeof(out_path));
+   strlcpy(out_path + _len, ".export", sizeof(out_path) - _len);
+
+   if (!path_is_valid(path) || !content_export_state(path, out_path))
+      return snprintf(s, len, "%s \"%s\".",
+            msg_hash_to_str(MSG_FAILED_TO_EXPORT_SAVE_STATE),
+            path_basename(path));
+   return snprintf(s, len, "%s \"%s\".",
+         msg_hash_to_str(MSG_EXPORTED_SAVE_STATE_TO),
+         path_basename(out_path));
+}
+
 static size_t command_event_undo_load_state(char *s, size_t len)
 {
    if (content_undo_load_buf_is_empty())
@@ -2305,6 +2323,11 @@ bool command_event_main_state(unsigned cmd)
             _len = command_event_undo_save_state(msg, sizeof(msg));
             ret  = true;
             break;
+         case CMD_EVENT_EXPORT_SAVE_STATE:
+            _len = command_event_export_save_state(state_path,
+                  msg, sizeof(msg));
+            ret  = true;
+            break;
       }
    }
    else
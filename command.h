@@ -60,6 +60,8 @@ enum event_command
    CMD_EVENT_UNDO_LOAD_STATE,
    /* Rewrites a savestate on disk. */
    CMD_EVENT_UNDO_SAVE_STATE,
+   /* Writes the savestate of the current slot as a plain file. */
+   CMD_EVENT_EXPORT_SAVE_STATE,
    /* Save state hotkeys. */
    CMD_EVENT_LOAD_STATE,
    CMD_EVENT_SAVE_STATE,
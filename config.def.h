@@ -351,6 +351,19 @@
  * (run ahead, rewind, etc) */
 #define DEFAULT_CORE_INFO_SAVESTATE_BYPASS false
 
+/* Memory budget in MB for keeping loaded content
+ * in memory, so reloading it skips reading,
+ * extracting and hashing (0 = disabled) */
+#define DEFAULT_CONTENT_CACHE_SIZE 0
+
+/* Compress content kept in the content cache */
+#define DEFAULT_CONTENT_CACHE_COMPRESS false
+
+/* Pass content inside zip archives to cores that
+ * need a full path and read files through the VFS
+ * interface as is, instead of extracting it */
+#define DEFAULT_ARCHIVE_VFS_MOUNT false
+
 /* Specifies whether to 'reload' (fork and quit)
  * RetroArch when launching content with the
  * currently loaded core
@@ -457,6 +470,30 @@
 #define DEFAULT_THREADED_DATA_RUNLOOP_ENABLE false
 #endif
 
+/* Apply the CPU affinity and scheduling settings below
+ * to the main, audio, video and task threads */
+#define DEFAULT_THREAD_ROLES_ENABLE false
+
+/* Timer slack of the main, audio and video threads in
+ * nanoseconds, 0 leaves the system default (Linux only) */
+#define DEFAULT_THREAD_TIMER_SLACK 0
+
+/* Scheduling policy of each thread role:
+ * 0 = unchanged, 1 = nice value, 2 = real-time FIFO,
+ * 3 = real-time round-robin. The priority is a nice value
+ * for policy 1 and a real-time priority otherwise. Threads
+ * fall back to DEFAULT_THREAD_RT_FALLBACK_NICE when the
+ * system refuses real-time scheduling */
+#define DEFAULT_THREAD_MAIN_POLICY 1
+#define DEFAULT_THREAD_MAIN_PRIORITY -5
+#define DEFAULT_THREAD_AUDIO_POLICY 2
+#define DEFAULT_THREAD_AUDIO_PRIORITY 10
+#define DEFAULT_THREAD_VIDEO_POLICY 1
+#define DEFAULT_THREAD_VIDEO_PRIORITY -5
+#define DEFAULT_THREAD_TASK_POLICY 1
+#define DEFAULT_THREAD_TASK_PRIORITY 5
+#define DEFAULT_THREAD_RT_FALLBACK_NICE -10
+
 /* Set to true if HW render cores should get their private context. */
 #define DEFAULT_VIDEO_SHARED_CONTEXT false
 
@@ -654,6 +691,11 @@
 #define DEFAULT_INPUT_TOUCH_VMOUSE_GESTURE true
 #endif
 
+/* Have the udev input driver read devices on a thread
+ * of its own, as soon as they report events, instead of
+ * once per frame */
+#define DEFAULT_INPUT_EVDEV_THREAD_ENABLE false
+
 #include "runtime_file_defines.h"
 #ifdef HAVE_MENU
 #include "menu/menu_defines.h"
@@ -1215,6 +1257,10 @@
  * is allowed to adjust input rate. */
 #define DEFAULT_RATE_CONTROL_DELTA  0.005f
 
+/* Audio latency rate control aims for, in milliseconds.
+ * 0 keeps the audio buffer half full. */
+#define DEFAULT_RATE_CONTROL_TARGET 0
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 #define DEFAULT_MAX_TIMING_SKEW  0.05f
@@ -1339,6 +1385,12 @@
 #define DEFAULT_GEKKONET_LIMITED_SAVING        false
 #define DEFAULT_GEKKONET_ALLOW_LATE_JOIN       false
 #define DEFAULT_GEKKONET_LOCAL_DELAY           0
+/* Validate memory-map rollback snapshots against full
+ * serialization once every N saves (0 = never) */
+#define DEFAULT_GEKKONET_SNAPSHOT_CHECK_INTERVAL 600
+/* Spread rollbacks that do not fit in one frame over at most
+ * this many frames (0 or 1 = always resimulate at once) */
+#define DEFAULT_GEKKONET_ROLLBACK_SPREAD       3
 #define DEFAULT_NETPLAY_UDP_PORT               55435
 
 /* Start netplay in spectator mode */
@@ -1366,6 +1418,17 @@
 
 #define DEFAULT_NETPLAY_NAT_TRAVERSAL false
 
+/* Also exchange input frames over UDP, when the
+ * other side supports it. Commands and savestates
+ * always go over TCP. */
+#define DEFAULT_NETPLAY_UDP_INPUT false
+
+/* Highest zstd level for savestates sent to
+ * other players. Everyone waits while a state
+ * is compressed, so the lowest level of all
+ * peers is used. */
+#define DEFAULT_NETPLAY_ZSTD_LEVEL 1
+
 #define DEFAULT_NETPLAY_DELAY_FRAMES 16
 
 #define DEFAULT_NETPLAY_CHECK_FRAMES 600
@@ -1401,6 +1464,16 @@
  *   savestates will be deleted in this case) */
 #define DEFAULT_SAVESTATE_MAX_KEEP 0
 
+/* How save state files are flushed to storage
+ * (0 = left to the OS, 1 = flush each file,
+ * 2 = flush and replace through a temporary file) */
+#define DEFAULT_SAVESTATE_FILE_SYNC 0
+
+/* Save states to a store of chunks shared by all
+ * states of a content, leaving manifests in the
+ * state files */
+#define DEFAULT_SAVESTATE_DEDUP_STORE false
+
 /* When recording replays, replay index is automatically
  * incremented before recording starts.
  * When the content is loaded, replay index will be set
@@ -1461,6 +1534,10 @@
 /* Skip frames when fast forwarding. */
 #define DEFAULT_FASTFORWARD_FRAMESKIP true
 
+/* Run the core back to back when fast forwarding,
+ * presenting only at the display refresh rate. */
+#define DEFAULT_FASTFORWARD_TURBO false
+
 /* Enable runloop for variable refresh rate screens. Force x1 speed while handling fast forward too. */
 #define DEFAULT_VRR_RUNLOOP_ENABLE false
 
@@ -1899,6 +1976,11 @@
 
 #define DEFAULT_AI_SERVICE_PAUSE false
 
+/* In automatic translation, send only the parts of the
+ * screen that changed since the previous request, with
+ * their position, instead of the whole screen */
+#define DEFAULT_AI_SERVICE_SEND_REGIONS false
+
 #define DEFAULT_AI_SERVICE_MODE 1
 
 #define DEFAULT_AI_SERVICE_URL "http://localhost:4404/"
@@ -40,6 +40,7 @@
 #include "config.features.h"
 #include "input/input_keymaps.h"
 #include "input/input_remapping.h"
+#include "input/input_autodetect_index.h"
 #include "led/led_defines.h"
 #include "defaults.h"
 #include "core.h"
@@ -1562,6 +1563,11 @@ static struct config_array_setting *populate_settings_array(
    SETTING_ARRAY("video_context_driver",         settings->arrays.video_context_driver, false, NULL, true);
    SETTING_ARRAY("crt_switch_timings",           settings->arrays.crt_switch_timings, false, NULL, true);
 
+   SETTING_ARRAY("thread_main_cpus",             settings->arrays.thread_main_cpus, false, NULL, true);
+   SETTING_ARRAY("thread_audio_cpus",            settings->arrays.thread_audio_cpus, false, NULL, true);
+   SETTING_ARRAY("thread_video_cpus",            settings->arrays.thread_video_cpus, false, NULL, true);
+   SETTING_ARRAY("thread_task_cpus",             settings->arrays.thread_task_cpus, false, NULL, true);
+
    SETTING_ARRAY("input_driver",                 settings->arrays.input_driver, false, NULL, true);
    SETTING_ARRAY("input_joypad_driver",          settings->arrays.input_joypad_driver, false, NULL, true);
    SETTING_ARRAY("input_keyboard_layout",        settings->arrays.input_keyboard_layout, false, NULL, true);
@@ -1706,6 +1712,8 @@ static struct config_path_setting *populate_settings_path(
 #ifdef HAVE_NETWORKING
    SETTING_PATH("netplay_ip_address",            settings->paths.netplay_server, false, NULL, true);
    SETTING_PATH("netplay_custom_mitm_server",    settings->paths.netplay_custom_mitm_server, false, NULL, true);
+   SETTING_PATH("gekkonet_relay_server",         settings->paths.gekkonet_relay_server, false, NULL, true);
+   SETTING_PATH("gekkonet_relay_session",        settings->paths.gekkonet_relay_session, false, NULL, true);
    SETTING_PATH("netplay_nickname",              settings->paths.username, false, NULL, true);
    SETTING_PATH("netplay_password",              settings->paths.netplay_password, false, NULL, true);
    SETTING_PATH("netplay_spectate_password",     settings->paths.netplay_spectate_password, false, NULL, true);
@@ -1747,6 +1755,8 @@ static struct config_bool_setting *populate_settings_bool(
    SETTING_BOOL("check_firmware_before_loading", &settings->bools.check_firmware_before_loading, true, DEFAULT_CHECK_FIRMWARE_BEFORE_LOADING, false);
    SETTING_BOOL("core_option_category_enable",   &settings->bools.core_option_category_enable, true, DEFAULT_CORE_OPTION_CATEGORY_ENABLE, false);
    SETTING_BOOL("core_info_savestate_bypass",    &settings->bools.core_info_savestate_bypass, true, DEFAULT_CORE_INFO_SAVESTATE_BYPASS, false);
+   SETTING_BOOL("content_cache_compress",        &settings->bools.content_cache_compress, true, DEFAULT_CONTENT_CACHE_COMPRESS, false);
+   SETTING_BOOL("archive_vfs_mount",             &settings->bools.archive_vfs_mount, true, DEFAULT_ARCHIVE_VFS_MOUNT, false);
 #if defined(__WINRT__) || defined(WINAPI_FAMILY) && WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP
    SETTING_BOOL("core_info_cache_enable",        &settings->bools.core_info_cache_enable, false, DEFAULT_CORE_INFO_CACHE_ENABLE, false);
 #else
@@ -1775,6 +1785,7 @@ static struct config_bool_setting *populate_settings_bool(
    SETTING_BOOL("apply_cheats_after_load",       &settings->bools.apply_cheats_after_load, true, DEFAULT_APPLY_CHEATS_AFTER_LOAD, false);
    SETTING_BOOL("rewind_enable",                 &settings->bools.rewind_enable, true, DEFAULT_REWIND_ENABLE, false);
    SETTING_BOOL("fastforward_frameskip",         &settings->bools.fastforward_frameskip, true, DEFAULT_FASTFORWARD_FRAMESKIP, false);
+   SETTING_BOOL("fastforward_turbo",             &settings->bools.fastforward_turbo, true, DEFAULT_FASTFORWARD_TURBO, false);
    SETTING_BOOL("vrr_runloop_enable",            &settings->bools.vrr_runloop_enable, true, DEFAULT_VRR_RUNLOOP_ENABLE, false);
    SETTING_BOOL("menu_throttle_framerate",       &settings->bools.menu_throttle_framerate, true, true, false);
    SETTING_BOOL("run_ahead_enabled",             &settings->bools.run_ahead_enabled, true, false, false);
@@ -1792,6 +1803,7 @@ static struct config_bool_setting *populate_settings_bool(
    SETTING_BOOL("savestate_thumbnail_enable",    &settings->bools.savestate_thumbnail_enable, true, DEFAULT_SAVESTATE_THUMBNAIL_ENABLE, false);
    SETTING_BOOL("save_file_compression",         &settings->bools.save_file_compression, true, DEFAULT_SAVE_FILE_COMPRESSION, false);
    SETTING_BOOL("savestate_file_compression",    &settings->bools.savestate_file_compression, true, DEFAULT_SAVESTATE_FILE_COMPRESSION, false);
+   SETTING_BOOL("savestate_dedup_store",         &settings->bools.savestate_dedup_store, true, DEFAULT_SAVESTATE_DEDUP_STORE, false);
    SETTING_BOOL("game_specific_options",         &settings->bools.game_specific_options, true, DEFAULT_GAME_SPECIFIC_OPTIONS, false);
    SETTING_BOOL("auto_overrides_enable",         &settings->bools.auto_overrides_enable, true, DEFAULT_AUTO_OVERRIDES_ENABLE, false);
    SETTING_BOOL("auto_remaps_enable",            &settings->bools.auto_remaps_enable, true, DEFAULT_AUTO_REMAPS_ENABLE, false);
@@ -1829,12 +1841,14 @@ static struct config_bool_setting *populate_settings_bool(
 #endif
 #ifdef HAVE_THREADS
    SETTING_BOOL("threaded_data_runloop_enable",  &settings->bools.threaded_data_runloop_enable, true, DEFAULT_THREADED_DATA_RUNLOOP_ENABLE, false);
+   SETTING_BOOL("thread_roles_enable",           &settings->bools.thread_roles_enable, true, DEFAULT_THREAD_ROLES_ENABLE, false);
 #endif
    SETTING_BOOL("log_to_file",                   &settings->bools.log_to_file, true, DEFAULT_LOG_TO_FILE, false);
    SETTING_OVERRIDE(RARCH_OVERRIDE_SETTING_LOG_TO_FILE);
    SETTING_BOOL("log_to_file_timestamp",         &settings->bools.log_to_file_timestamp, true, DEFAULT_LOG_TO_FILE_TIMESTAMP, false);
    SETTING_BOOL("ai_service_enable",             &settings->bools.ai_service_enable, true, DEFAULT_AI_SERVICE_ENABLE, false);
    SETTING_BOOL("ai_service_pause",              &settings->bools.ai_service_pause, true, DEFAULT_AI_SERVICE_PAUSE, false);
+   SETTING_BOOL("ai_service_send_regions",       &settings->bools.ai_service_send_regions, true, DEFAULT_AI_SERVICE_SEND_REGIONS, false);
    SETTING_BOOL("wifi_enabled",                  &settings->bools.wifi_enabled, true, DEFAULT_WIFI_ENABLE, false);
 #ifndef HAVE_LAKKA
    SETTING_BOOL("gamemode_enable",               &settings->bools.gamemode_enable, true, DEFAULT_GAMEMODE_ENABLE, false);
@@ -2164,6 +2178,9 @@ static struct config_bool_setting *populate_settings_bool(
    SETTING_BOOL("input_touch_vmouse_trackball",  &settings->bools.input_touch_vmouse_trackball, true, DEFAULT_INPUT_TOUCH_VMOUSE_TRACKBALL, false);
    SETTING_BOOL("input_touch_vmouse_gesture",    &settings->bools.input_touch_vmouse_gesture, true, DEFAULT_INPUT_TOUCH_VMOUSE_GESTURE, false);
 #endif
+#if defined(HAVE_UDEV) && defined(HAVE_THREADS)
+   SETTING_BOOL("input_evdev_thread_enable",     &settings->bools.input_evdev_thread_enable, true, DEFAULT_INPUT_EVDEV_THREAD_ENABLE, false);
+#endif
 #if defined(VITA)
    SETTING_BOOL("input_backtouch_enable",        &settings->bools.input_backtouch_enable, false, DEFAULT_INPUT_BACKTOUCH_ENABLE, false);
    SETTING_BOOL("input_backtouch_toggle",        &settings->bools.input_backtouch_toggle, false, DEFAULT_INPUT_BACKTOUCH_TOGGLE, false);
@@ -2229,6 +2246,7 @@ static struct config_bool_setting *populate_settings_bool(
    SETTING_BOOL("gekkonet_allow_late_join",      &settings->bools.gekkonet_allow_late_join, true, DEFAULT_GEKKONET_ALLOW_LATE_JOIN, false);
    SETTING_BOOL("netplay_start_as_spectator",    &settings->bools.netplay_start_as_spectator, false, DEFAULT_NETPLAY_START_AS_SPECTATOR, false);
    SETTING_BOOL("netplay_nat_traversal",         &settings->bools.netplay_nat_traversal, true, true, false);
+   SETTING_BOOL("netplay_udp_input",             &settings->bools.netplay_udp_input, true, DEFAULT_NETPLAY_UDP_INPUT, false);
    SETTING_BOOL("netplay_fade_chat",             &settings->bools.netplay_fade_chat, true, DEFAULT_NETPLAY_FADE_CHAT, false);
    SETTING_BOOL("netplay_allow_pausing",         &settings->bools.netplay_allow_pausing, true, DEFAULT_NETPLAY_ALLOW_PAUSING, false);
    SETTING_BOOL("netplay_allow_slaves",          &settings->bools.netplay_allow_slaves, true, DEFAULT_NETPLAY_ALLOW_SLAVES, false);
@@ -2413,6 +2431,8 @@ static struct config_uint_setting *populate_settings_uint(
    SETTING_UINT("replay_max_keep",               &settings->uints.replay_max_keep, true, DEFAULT_REPLAY_MAX_KEEP, false);
    SETTING_UINT("replay_checkpoint_interval",    &settings->uints.replay_checkpoint_interval,  true, DEFAULT_REPLAY_CHECKPOINT_INTERVAL, false);
    SETTING_UINT("savestate_max_keep",            &settings->uints.savestate_max_keep, true, DEFAULT_SAVESTATE_MAX_KEEP, false);
+   SETTING_UINT("savestate_file_sync",           &settings->uints.savestate_file_sync, true, DEFAULT_SAVESTATE_FILE_SYNC, false);
+   SETTING_UINT("content_cache_size",            &settings->uints.content_cache_size, true, DEFAULT_CONTENT_CACHE_SIZE, false);
 #ifdef HAVE_MENU
    SETTING_UINT("content_show_add_entry",        &settings->uints.menu_content_show_add_entry, true, DEFAULT_MENU_CONTENT_SHOW_ADD_ENTRY, false);
    SETTING_UINT("content_show_contentless_cores",&settings->uints.menu_content_show_contentless_cores, true, DEFAULT_MENU_CONTENT_SHOW_CONTENTLESS_CORES, false);
@@ -2477,6 +2497,7 @@ static struct config_uint_setting *populate_settings_uint(
 
    SETTING_UINT("audio_out_rate",                &settings->uints.audio_output_sample_rate, true, DEFAULT_OUTPUT_RATE, false);
    SETTING_UINT("audio_latency",                 &settings->uints.audio_latency, false, 0 /* TODO */, false);
+   SETTING_UINT("audio_rate_control_target",     &settings->uints.audio_rate_control_target, true, DEFAULT_RATE_CONTROL_TARGET, false);
    SETTING_UINT("audio_resampler_quality",       &settings->uints.audio_resampler_quality, true, DEFAULT_AUDIO_RESAMPLER_QUALITY_LEVEL, false);
    SETTING_UINT("audio_block_frames",            &settings->uints.audio_block_frames, true, 0, false);
    SETTING_UINT("midi_volume",                   &settings->uints.midi_volume, true, DEFAULT_MIDI_VOLUME, false);
@@ -2529,6 +2550,11 @@ static struct config_uint_setting *populate_settings_uint(
 #endif
    SETTING_UINT("video_hard_sync_frames",        &settings->uints.video_hard_sync_frames, true, DEFAULT_HARD_SYNC_FRAMES, false);
    SETTING_UINT("video_frame_delay",             &settings->uints.video_frame_delay,      true, DEFAULT_FRAME_DELAY, false);
+   SETTING_UINT("thread_timer_slack",            &settings->uints.thread_timer_slack, true, DEFAULT_THREAD_TIMER_SLACK, false);
+   SETTING_UINT("thread_main_policy",            &settings->uints.thread_main_policy, true, DEFAULT_THREAD_MAIN_POLICY, false);
+   SETTING_UINT("thread_audio_policy",           &settings->uints.thread_audio_policy, true, DEFAULT_THREAD_AUDIO_POLICY, false);
+   SETTING_UINT("thread_video_policy",           &settings->uints.thread_video_policy, true, DEFAULT_THREAD_VIDEO_POLICY, false);
+   SETTING_UINT("thread_task_policy",            &settings->uints.thread_task_policy, true, DEFAULT_THREAD_TASK_POLICY, false);
    SETTING_UINT("video_max_swapchain_images",    &settings->uints.video_max_swapchain_images, true, DEFAULT_MAX_SWAPCHAIN_IMAGES, false);
    SETTING_UINT("video_black_frame_insertion",   &settings->uints.video_black_frame_insertion, true, DEFAULT_BLACK_FRAME_INSERTION, false);
    SETTING_UINT("video_bfi_dark_frames",         &settings->uints.video_bfi_dark_frames, true, DEFAULT_BFI_DARK_FRAMES, false);
@@ -2602,6 +2628,7 @@ static struct config_uint_setting *populate_settings_uint(
    SETTING_UINT("netplay_ip_port",                    &settings->uints.netplay_port, true, RARCH_DEFAULT_PORT, false);
    SETTING_OVERRIDE(RARCH_OVERRIDE_SETTING_NETPLAY_IP_PORT);
    SETTING_UINT("netplay_udp_port",                   &settings->uints.netplay_udp_port, true, DEFAULT_NETPLAY_UDP_PORT, false);
+   SETTING_UINT("netplay_zstd_level",                 &settings->uints.netplay_zstd_level, true, DEFAULT_NETPLAY_ZSTD_LEVEL, false);
    SETTING_UINT("netplay_max_connections",            &settings->uints.netplay_max_connections, true, DEFAULT_NETPLAY_MAX_CONNECTIONS, false);
    SETTING_UINT("netplay_max_ping",                   &settings->uints.netplay_max_ping, true, DEFAULT_NETPLAY_MAX_PING, false);
    SETTING_UINT("netplay_chat_color_name",            &settings->uints.netplay_chat_color_name, true, DEFAULT_NETPLAY_CHAT_COLOR_NAME, false);
@@ -2614,6 +2641,8 @@ static struct config_uint_setting *populate_settings_uint(
    SETTING_UINT("gekkonet_spectator_delay",           &settings->uints.gekkonet_spectator_delay, true, DEFAULT_GEKKONET_SPECTATOR_DELAY, false);
    SETTING_UINT("gekkonet_max_spectators",            &settings->uints.gekkonet_max_spectators, true, DEFAULT_GEKKONET_MAX_SPECTATORS, false);
    SETTING_UINT("gekkonet_local_delay",               &settings->uints.gekkonet_local_delay, true, DEFAULT_GEKKONET_LOCAL_DELAY, false);
+   SETTING_UINT("gekkonet_snapshot_check_interval",   &settings->uints.gekkonet_snapshot_check_interval, true, DEFAULT_GEKKONET_SNAPSHOT_CHECK_INTERVAL, false);
+   SETTING_UINT("gekkonet_rollback_spread",           &settings->uints.gekkonet_rollback_spread, true, DEFAULT_GEKKONET_ROLLBACK_SPREAD, false);
 #endif
 #ifdef HAVE_COMMAND
    SETTING_UINT("network_cmd_port",              &settings->uints.network_cmd_port,    true, DEFAULT_NETWORK_CMD_PORT, false);
@@ -2725,6 +2754,10 @@ static struct config_int_setting *populate_settings_int(
    SETTING_INT("video_window_offset_y",          &settings->ints.video_window_offset_y, true, DEFAULT_WINDOW_OFFSET_Y, false);
 #endif
    SETTING_INT("video_max_frame_latency",        &settings->ints.video_max_frame_latency, true, DEFAULT_MAX_FRAME_LATENCY, false);
+   SETTING_INT("thread_main_priority",           &settings->ints.thread_main_priority, true, DEFAULT_THREAD_MAIN_PRIORITY, false);
+   SETTING_INT("thread_audio_priority",          &settings->ints.thread_audio_priority, true, DEFAULT_THREAD_AUDIO_PRIORITY, false);
+   SETTING_INT("thread_video_priority",          &settings->ints.thread_video_priority, true, DEFAULT_THREAD_VIDEO_PRIORITY, false);
+   SETTING_INT("thread_task_priority",           &settings->ints.thread_task_priority, true, DEFAULT_THREAD_TASK_PRIORITY, false);
 
 #ifdef HAVE_D3D10
    SETTING_INT("d3d10_gpu_index",                &settings->ints.d3d10_gpu_index, true, DEFAULT_D3D10_GPU_INDEX, false);
@@ -5444,6 +5477,9 @@ bool config_save_autoconf_profile(const char *device_name, unsigned user)
    ret = config_file_write(conf, autoconf_file, false);
    if (conf)
       config_file_free(conf);
+   /* Overwriting a profile leaves the directory untouched */
+   input_autodetect_index_invalidate(autoconf_dir,
+         settings->paths.directory_cache);
    return ret;
 }
 
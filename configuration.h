@@ -124,6 +124,10 @@ typedef struct settings
       int crt_switch_porch_adjust;
       int crt_switch_vertical_adjust;
       int video_max_frame_latency;
+      int thread_main_priority;
+      int thread_audio_priority;
+      int thread_video_priority;
+      int thread_task_priority;
 #ifdef HAVE_VULKAN
       int vulkan_gpu_index;
 #endif
@@ -180,6 +184,7 @@ typedef struct settings
       unsigned audio_output_sample_rate;
       unsigned audio_block_frames;
       unsigned audio_latency;
+      unsigned audio_rate_control_target;
 
 #ifdef HAVE_WASAPI
       unsigned audio_wasapi_sh_buffer_length;
@@ -224,6 +229,7 @@ typedef struct settings
 
       unsigned netplay_port;
       unsigned netplay_udp_port;
+      unsigned netplay_zstd_level;
       unsigned netplay_max_connections;
       unsigned netplay_max_ping;
       unsigned netplay_chat_color_name;
@@ -236,6 +242,8 @@ typedef struct settings
       unsigned gekkonet_spectator_delay;
       unsigned gekkonet_max_spectators;
       unsigned gekkonet_local_delay;
+      unsigned gekkonet_snapshot_check_interval;
+      unsigned gekkonet_rollback_spread;
       unsigned bundle_assets_extract_version_current;
       unsigned bundle_assets_extract_last_version;
       unsigned content_history_size;
@@ -247,6 +255,8 @@ typedef struct settings
       unsigned replay_checkpoint_interval;
       unsigned replay_max_keep;
       unsigned savestate_max_keep;
+      unsigned savestate_file_sync;
+      unsigned content_cache_size;
       unsigned network_cmd_port;
       unsigned network_remote_base_port;
       unsigned keymapper_port;
@@ -265,6 +275,11 @@ typedef struct settings
       unsigned video_swap_interval;
       unsigned video_hard_sync_frames;
       unsigned video_frame_delay;
+      unsigned thread_timer_slack;
+      unsigned thread_main_policy;
+      unsigned thread_audio_policy;
+      unsigned thread_video_policy;
+      unsigned thread_task_policy;
       unsigned video_viwidth;
       unsigned video_aspect_ratio_idx;
       unsigned video_rotation;
@@ -507,6 +522,10 @@ typedef struct settings
       char midi_driver[32];
       char midi_input[32];
       char midi_output[32];
+      char thread_main_cpus[32];
+      char thread_audio_cpus[32];
+      char thread_video_cpus[32];
+      char thread_task_cpus[32];
 #ifdef HAVE_LAKKA
       char cpu_main_gov[32];
       char cpu_menu_gov[32];
@@ -561,6 +580,8 @@ typedef struct settings
 
       char netplay_server[NAME_MAX_LENGTH];
       char netplay_custom_mitm_server[NAME_MAX_LENGTH];
+      char gekkonet_relay_server[NAME_MAX_LENGTH];
+      char gekkonet_relay_session[NAME_MAX_LENGTH];
       char network_buildbot_url[NAME_MAX_LENGTH];
       char network_buildbot_assets_url[NAME_MAX_LENGTH];
       char menu_content_show_settings_password[NAME_MAX_LENGTH];
@@ -757,6 +778,9 @@ typedef struct settings
       bool input_touch_vmouse_trackball;
       bool input_touch_vmouse_gesture;
 #endif
+#if defined(HAVE_UDEV) && defined(HAVE_THREADS)
+      bool input_evdev_thread_enable;
+#endif
 
       /* Frame time counter */
       bool frame_time_counter_reset_after_fastforwarding;
@@ -942,6 +966,7 @@ typedef struct settings
       bool netplay_allow_slaves;
       bool netplay_require_slaves;
       bool netplay_nat_traversal;
+      bool netplay_udp_input;
       bool netplay_use_mitm_server;
       bool netplay_request_devices[MAX_USERS];
       bool netplay_ping_show;
@@ -1021,12 +1046,14 @@ typedef struct settings
       /* Misc. */
       bool discord_enable;
       bool threaded_data_runloop_enable;
+      bool thread_roles_enable;
       bool set_supports_no_game_enable;
       bool auto_screenshot_filename;
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
       bool fastforward_frameskip;
+      bool fastforward_turbo;
       bool vrr_runloop_enable;
       bool menu_throttle_framerate;
       bool apply_cheats_after_toggle;
@@ -1045,6 +1072,7 @@ typedef struct settings
       bool savestate_thumbnail_enable;
       bool save_file_compression;
       bool savestate_file_compression;
+      bool savestate_dedup_store;
       bool network_cmd_enable;
       bool stdin_cmd_enable;
       bool keymapper_enable;
@@ -1055,6 +1083,8 @@ typedef struct settings
       bool core_option_category_enable;
       bool core_info_cache_enable;
       bool core_info_savestate_bypass;
+      bool content_cache_compress;
+      bool archive_vfs_mount;
 #ifndef HAVE_DYNAMIC
       bool always_reload_core_on_run_content;
 #endif
@@ -1127,6 +1157,7 @@ typedef struct settings
 
       bool ai_service_enable;
       bool ai_service_pause;
+      bool ai_service_send_regions;
 
       bool gamemode_enable;
 #ifdef HAVE_BSV_MOVIE
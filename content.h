@@ -74,6 +74,14 @@ bool content_deserialize_state(const void* serialized_data, size_t serialized_si
 
 /* Waits for any in-progress save state tasks to finish */
 void content_wait_for_save_state_task(void);
+
+/* Creates the queue that writes state files, and sets up the
+ * deduplicating state store. Must be called on the main thread
+ * before any state is saved or loaded. */
+void content_state_writer_init(void);
+/* Waits for the states being written, then frees the queue */
+void content_state_writer_deinit(void);
+
 /* Waits for any in-progress load state tasks to finish */
 void content_wait_for_load_state_task(void);
 
@@ -86,6 +94,11 @@ bool content_undo_load_state(void);
 /* Restores the last savestate file which was overwritten */
 bool content_undo_save_state(void);
 
+/* Writes the state in @path to @out_path as a plain state file,
+ * once pending writes to @path are done. @path may hold a manifest
+ * of the deduplicating state store. */
+bool content_export_state(const char *path, const char *out_path);
+
 uint8_t content_get_flags(void);
 
 void content_set_does_not_need_content(void);
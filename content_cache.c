@@ -0,0 +1,423 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "content_cache.h"
+
+/* Uncompressed size of each frame of a compressed entry */
+#define CONTENT_CACHE_FRAME_SIZE (1 << 20)
+
+/* Favour speed, content is compressed while it loads */
+#define CONTENT_CACHE_ZSTD_LEVEL 1
+
+typedef struct
+{
+   uint32_t offset;                /* in entry data */
+   uint32_t size;                  /* == uncompressed size if stored raw */
+} content_cache_frame_t;
+
+typedef struct
+{
+   char *path;
+   uint8_t *data;
+   content_cache_frame_t *frames;  /* NULL if data is stored raw */
+   int64_t file_size;              /* of the file, or archive, on disk */
+   int64_t file_stamp;
+   int64_t len;                    /* of the content */
+   size_t stored;                  /* memory held by the entry */
+   uint64_t last_use;
+   uint32_t crc;
+   bool has_crc;
+} content_cache_entry_t;
+
+typedef struct
+{
+   content_cache_entry_t *entries;
+   size_t count;
+   size_t cap;
+   size_t used;
+   size_t budget;
+   uint64_t clock;
+#ifdef HAVE_ZSTD
+   ZSTD_CCtx *cctx;
+   ZSTD_DCtx *dctx;
+#endif
+   bool compress;
+} content_cache_state_t;
+
+static content_cache_state_t content_cache_st;
+
+static bool content_cache_stat(const char *path,
+      int64_t *size, int64_t *stamp)
+{
+   char archive_path[PATH_MAX_LENGTH];
+   const char *delim = path_get_archive_delim(path);
+
+   /* Content inside an archive is only as fresh as the archive */
+   if (delim)
+   {
+      size_t _len = delim - path;
+      if (_len >= sizeof(archive_path))
+         return false;
+      memcpy(archive_path, path, _len);
+      archive_path[_len] = '\0';
+      path               = archive_path;
+   }
+
+   return path_get_stamp(path, stamp, size);
+}
+
+static void content_cache_remove(size_t i)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+   content_cache_entry_t *entry    = &cache_st->entries[i];
+
+   cache_st->used -= entry->stored;
+   free(entry->path);
+   free(entry->data);
+   free(entry->frames);
+
+   cache_st->entries[i] = cache_st->entries[--cache_st->count];
+}
+
+/* Drops least recently used entries until @len more bytes fit */
+static void content_cache_evict(size_t len)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+
+   while (cache_st->count && cache_st->used + len > cache_st->budget)
+   {
+      size_t i;
+      size_t lru = 0;
+
+      for (i = 1; i < cache_st->count; i++)
+         if (cache_st->entries[i].last_use < cache_st->entries[lru].last_use)
+            lru = i;
+
+      content_cache_remove(lru);
+   }
+}
+
+/* Returns the index of the entry for @path if it is still
+ * valid, dropping it if the file has changed */
+static ptrdiff_t content_cache_find(const char *path)
+{
+   size_t i;
+   content_cache_state_t *cache_st = &content_cache_st;
+
+   for (i = 0; i < cache_st->count; i++)
+   {
+      int64_t size, stamp;
+      content_cache_entry_t *entry = &cache_st->entries[i];
+
+      if (!string_is_equal(entry->path, path))
+         continue;
+
+      if (     !content_cache_stat(path, &size, &stamp)
+            || size  != entry->file_size
+            || stamp != entry->file_stamp)
+      {
+         content_cache_remove(i);
+         return -1;
+      }
+
+      entry->last_use = ++cache_st->clock;
+      return (ptrdiff_t)i;
+   }
+
+   return -1;
+}
+
+#ifdef HAVE_ZSTD
+/* Compresses @data into independent frames. Returns false
+ * if compression would not save memory. */
+static bool content_cache_compress(content_cache_entry_t *entry,
+      const uint8_t *data)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+   size_t num_frames = (size_t)((entry->len + CONTENT_CACHE_FRAME_SIZE - 1)
+         / CONTENT_CACHE_FRAME_SIZE);
+   size_t bound      = ZSTD_compressBound(CONTENT_CACHE_FRAME_SIZE);
+   size_t frames_len = num_frames * sizeof(content_cache_frame_t);
+   size_t offset     = 0;
+   uint8_t *buf      = NULL;
+   uint8_t *out      = NULL;
+   size_t i;
+
+   /* Frame offsets are 32-bit */
+   if (entry->len > 0x7FFFFFFF)
+      return false;
+
+   if (!cache_st->cctx && !(cache_st->cctx = ZSTD_createCCtx()))
+      return false;
+
+   if (!(entry->frames = (content_cache_frame_t*)malloc(frames_len)))
+      return false;
+   if (!(buf = (uint8_t*)malloc(bound)))
+      goto error;
+   /* Never larger than the raw content */
+   if (!(out = (uint8_t*)malloc((size_t)entry->len)))
+      goto error;
+
+   for (i = 0; i < num_frames; i++)
+   {
+      const uint8_t *src = data + (size_t)i * CONTENT_CACHE_FRAME_SIZE;
+      size_t src_len     = (size_t)MIN(entry->len
+            - (int64_t)i * CONTENT_CACHE_FRAME_SIZE, CONTENT_CACHE_FRAME_SIZE);
+      size_t _len        = ZSTD_compressCCtx(cache_st->cctx, buf, bound,
+            src, src_len, CONTENT_CACHE_ZSTD_LEVEL);
+
+      /* Store the frame raw if it does not shrink */
+      if (ZSTD_isError(_len) || _len >= src_len)
+         _len = src_len;
+      else
+         src  = buf;
+
+      memcpy(out + offset, src, _len);
+      entry->frames[i].offset = (uint32_t)offset;
+      entry->frames[i].size   = (uint32_t)_len;
+      offset                 += _len;
+   }
+
+   free(buf);
+
+   /* Not worth decompressing on every load */
+   if (offset + frames_len >= (size_t)entry->len)
+   {
+      free(out);
+      free(entry->frames);
+      entry->frames = NULL;
+      return false;
+   }
+
+   /* Give back the unused tail */
+   entry->data   = (uint8_t*)realloc(out, offset ? offset : 1);
+   if (!entry->data)
+      entry->data = out;
+   entry->stored = offset + frames_len;
+   return true;
+
+error:
+   free(buf);
+   free(entry->frames);
+   entry->frames = NULL;
+   return false;
+}
+
+static bool content_cache_decompress(const content_cache_entry_t *entry,
+      uint8_t *out)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+   size_t num_frames = (size_t)((entry->len + CONTENT_CACHE_FRAME_SIZE - 1)
+         / CONTENT_CACHE_FRAME_SIZE);
+   size_t i;
+
+   if (!cache_st->dctx && !(cache_st->dctx = ZSTD_createDCtx()))
+      return false;
+
+   for (i = 0; i < num_frames; i++)
+   {
+      uint8_t *dst   = out + (size_t)i * CONTENT_CACHE_FRAME_SIZE;
+      size_t dst_len = (size_t)MIN(entry->len
+            - (int64_t)i * CONTENT_CACHE_FRAME_SIZE, CONTENT_CACHE_FRAME_SIZE);
+      const content_cache_frame_t *frame = &entry->frames[i];
+
+      if (frame->size == dst_len)
+         memcpy(dst, entry->data + frame->offset, dst_len);
+      else if (ZSTD_decompressDCtx(cache_st->dctx, dst, dst_len,
+               entry->data + frame->offset, frame->size) != dst_len)
+         return false;
+   }
+
+   return true;
+}
+#endif
+
+void content_cache_set_limits(size_t budget, bool compress)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+
+   cache_st->budget   = budget;
+   cache_st->compress = compress;
+
+   if (!budget)
+      content_cache_deinit();
+   else
+      content_cache_evict(0);
+}
+
+void content_cache_deinit(void)
+{
+   content_cache_state_t *cache_st = &content_cache_st;
+
+   while (cache_st->count)
+      content_cache_remove(cache_st->count - 1);
+
+   free(cache_st->entries);
+   cache_st->entries = NULL;
+   cache_st->cap     = 0;
+   cache_st->used    = 0;
+
+#ifdef HAVE_ZSTD
+   if (cache_st->cctx)
+      ZSTD_freeCCtx(cache_st->cctx);
+   if (cache_st->dctx)
+      ZSTD_freeDCtx(cache_st->dctx);
+   cache_st->cctx    = NULL;
+   cache_st->dctx    = NULL;
+#endif
+}
+
+bool content_cache_get(const char *path, void **data, int64_t *len)
+{
+   ptrdiff_t i;
+   uint8_t *out;
+   content_cache_entry_t *entry;
+
+   if (string_is_empty(path) || (i = content_cache_find(path)) < 0)
+      return false;
+
+   entry = &content_cache_st.entries[i];
+
+   if (!(out = (uint8_t*)malloc((size_t)entry->len + 1)))
+      return false;
+
+#ifdef HAVE_ZSTD
+   if (entry->frames)
+   {
+      if (!content_cache_decompress(entry, out))
+      {
+         free(out);
+         content_cache_remove((size_t)i);
+         return false;
+      }
+   }
+   else
+#endif
+      memcpy(out, entry->data, (size_t)entry->len);
+
+   out[entry->len] = '\0';
+   *data           = out;
+   *len            = entry->len;
+   return true;
+}
+
+bool content_cache_put(const char *path, const void *data, int64_t len)
+{
+   size_t i;
+   content_cache_entry_t entry;
+   content_cache_state_t *cache_st = &content_cache_st;
+
+   if (     !cache_st->budget
+         || string_is_empty(path)
+         || !data
+         || len <= 0
+         || (uint64_t)len > cache_st->budget)
+      return false;
+
+   /* Replace any previous content */
+   for (i = 0; i < cache_st->count; i++)
+   {
+      if (string_is_equal(cache_st->entries[i].path, path))
+      {
+         content_cache_remove(i);
+         break;
+      }
+   }
+
+   memset(&entry, 0, sizeof(entry));
+   entry.len = len;
+
+   if (!content_cache_stat(path, &entry.file_size, &entry.file_stamp))
+      return false;
+
+#ifdef HAVE_ZSTD
+   if (!cache_st->compress || !content_cache_compress(&entry,
+            (const uint8_t*)data))
+#endif
+   {
+      if (!(entry.data = (uint8_t*)malloc((size_t)len)))
+         return false;
+      memcpy(entry.data, data, (size_t)len);
+      entry.stored = (size_t)len;
+   }
+
+   if (     entry.stored > cache_st->budget
+         || !(entry.path = strdup(path)))
+      goto error;
+
+   if (cache_st->count == cache_st->cap)
+   {
+      size_t cap = cache_st->cap ? cache_st->cap * 2 : 8;
+      content_cache_entry_t *entries = (content_cache_entry_t*)
+         realloc(cache_st->entries, cap * sizeof(*entries));
+      if (!entries)
+         goto error;
+      cache_st->entries = entries;
+      cache_st->cap     = cap;
+   }
+
+   content_cache_evict(entry.stored);
+
+   entry.last_use                     = ++cache_st->clock;
+   cache_st->entries[cache_st->count++] = entry;
+   cache_st->used                    += entry.stored;
+   return true;
+
+error:
+   free(entry.path);
+   free(entry.data);
+   free(entry.frames);
+   return false;
+}
+
+bool content_cache_get_crc(const char *path, uint32_t *crc)
+{
+   ptrdiff_t i;
+
+   if (string_is_empty(path) || (i = content_cache_find(path)) < 0)
+      return false;
+   if (!content_cache_st.entries[i].has_crc)
+      return false;
+
+   *crc = content_cache_st.entries[i].crc;
+   return true;
+}
+
+void content_cache_set_crc(const char *path, uint32_t crc)
+{
+   ptrdiff_t i;
+
+   if (string_is_empty(path) || (i = content_cache_find(path)) < 0)
+      return;
+
+   content_cache_st.entries[i].crc     = crc;
+   content_cache_st.entries[i].has_crc = true;
+}
+
+size_t content_cache_get_size(void)
+{
+   return content_cache_st.used;
+}
@@ -0,0 +1,101 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONTENT_CACHE_H
+#define __CONTENT_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Process-wide cache of content loaded into memory.
+ *
+ * Keeps copies of recently loaded content files, as read from disk or
+ * extracted from an archive, together with their CRC32 once known.
+ * Entries are keyed by path and only returned while the file (or the
+ * archive holding it) still has the size and modification time it had
+ * when stored. The least recently used entries are dropped to stay
+ * within the memory budget.
+ *
+ * With zstd support, entries can be stored compressed in independently
+ * compressed frames; frames that do not shrink are stored as they are.
+ *
+ * Not thread-safe: content is loaded on the main thread. */
+
+/**
+ * content_cache_set_limits:
+ * @budget      : Memory to use, in bytes. 0 disables the cache and
+ *                drops all entries.
+ * @compress    : Store new entries compressed, if supported.
+ *
+ * Drops entries as needed to fit @budget.
+ **/
+void content_cache_set_limits(size_t budget, bool compress);
+
+/**
+ * content_cache_deinit:
+ *
+ * Drops all entries and frees the cache.
+ **/
+void content_cache_deinit(void);
+
+/**
+ * content_cache_get:
+ * @path        : Content path, may point inside an archive.
+ * @data        : Set to a malloc()ed copy of the content, with a
+ *                terminating NUL byte like filestream_read_file().
+ * @len         : Set to the size of the content.
+ *
+ * Returns: true if @path is cached and unchanged on disk.
+ **/
+bool content_cache_get(const char *path, void **data, int64_t *len);
+
+/**
+ * content_cache_put:
+ *
+ * Stores a copy of @data as the content of @path.
+ *
+ * Returns: true if stored, false if disabled, too large for the
+ * budget or the file cannot be checked for changes.
+ **/
+bool content_cache_put(const char *path, const void *data, int64_t len);
+
+/**
+ * content_cache_get_crc:
+ *
+ * Returns: true if @path is cached with a known CRC32, set to @crc.
+ **/
+bool content_cache_get_crc(const char *path, uint32_t *crc);
+
+/**
+ * content_cache_set_crc:
+ *
+ * Remembers the CRC32 of the cached content of @path.
+ **/
+void content_cache_set_crc(const char *path, uint32_t crc);
+
+/**
+ * content_cache_get_size:
+ *
+ * Returns: memory currently used by cached entries, in bytes.
+ **/
+size_t content_cache_get_size(void);
+
+RETRO_END_DECLS
+
+#endif
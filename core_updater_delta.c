@@ -0,0 +1,140 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zstd.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <encodings/crc32.h>
+
+#include "core_updater_delta.h"
+
+size_t core_updater_delta_get_url(char *s, size_t len,
+      const char *remote_core_path,
+      uint32_t base_crc, uint32_t target_crc)
+{
+   size_t _len;
+   char *ext;
+
+   if (string_is_empty(remote_core_path) || !base_crc || !target_crc)
+      return 0;
+
+   _len = strlcpy(s, remote_core_path, len);
+   if (_len >= len)
+      return 0;
+
+   /* Deltas rebuild the core itself, not its archive */
+   if (     (ext = path_get_extension_mutable(s))
+         && string_is_equal_noncase(ext, ".zip"))
+   {
+      *ext = '\0';
+      _len = ext - s;
+   }
+
+   _len += snprintf(s + _len, len - _len, ".%08lx-%08lx.zst",
+         (unsigned long)base_crc, (unsigned long)target_crc);
+
+   return (_len < len) ? _len : 0;
+}
+
+bool core_updater_delta_apply(const char *base_path,
+      const char *delta_path, const char *out_path,
+      uint32_t target_crc)
+{
+   size_t _len;
+   char tmp[PATH_MAX_LENGTH + 8];
+   unsigned long long out_size;
+   void *base        = NULL;
+   void *delta       = NULL;
+   uint8_t *out      = NULL;
+   ZSTD_DCtx *dctx   = NULL;
+   int64_t base_len  = 0;
+   int64_t delta_len = 0;
+   bool ret          = false;
+
+   if (     string_is_empty(base_path)
+         || string_is_empty(delta_path)
+         || string_is_empty(out_path))
+      return false;
+
+   if (     !filestream_read_file(base_path,  &base,  &base_len)
+         || !filestream_read_file(delta_path, &delta, &delta_len)
+         || base_len  <= 0
+         || delta_len <= 0)
+      goto end;
+
+   /* Deltas carry the size of the core they rebuild,
+    * so the output is decompressed in one go */
+   out_size = ZSTD_getFrameContentSize(delta, (size_t)delta_len);
+   if (     out_size == ZSTD_CONTENTSIZE_UNKNOWN
+         || out_size == ZSTD_CONTENTSIZE_ERROR
+         || out_size == 0
+         || out_size >  CORE_UPDATER_DELTA_MAX_SIZE)
+      goto end;
+
+   if (     !(out  = (uint8_t*)malloc((size_t)out_size))
+         || !(dctx = ZSTD_createDCtx()))
+      goto end;
+
+   if (     ZSTD_isError(ZSTD_DCtx_setParameter(dctx,
+                  ZSTD_d_windowLogMax, CORE_UPDATER_DELTA_WINDOW_LOG))
+         || ZSTD_isError(ZSTD_DCtx_refPrefix(dctx,
+                  base, (size_t)base_len)))
+      goto end;
+
+   _len = ZSTD_decompressDCtx(dctx, out, (size_t)out_size,
+         delta, (size_t)delta_len);
+   if (ZSTD_isError(_len) || _len != (size_t)out_size)
+      goto end;
+
+   /* A delta made against another build than the one
+    * installed decodes to garbage rather than failing */
+   if (encoding_crc32(0, out, _len) != target_crc)
+      goto end;
+
+   /* Never leave a torn core behind */
+   _len = strlcpy(tmp, out_path, sizeof(tmp));
+   strlcpy(tmp + _len, ".tmp", sizeof(tmp) - _len);
+
+   if (filestream_write_file(tmp, out, (int64_t)out_size))
+   {
+      /* Renaming over an existing file fails on some
+       * platforms, only then is the old core removed first */
+      if (filestream_rename(tmp, out_path) == 0)
+         ret = true;
+      else
+      {
+         filestream_delete(out_path);
+         if (filestream_rename(tmp, out_path) == 0)
+            ret = true;
+         else
+            filestream_delete(tmp);
+      }
+   }
+
+end:
+   if (dctx)
+      ZSTD_freeDCtx(dctx);
+   free(out);
+   free(delta);
+   free(base);
+   return ret;
+}
@@ -0,0 +1,79 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CORE_UPDATER_DELTA_H
+#define __CORE_UPDATER_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Delta updates of installed cores.
+ *
+ * A delta rebuilds one build of a core from another. It is a single
+ * zstd frame compressed with the older build as its prefix, as written
+ * by 'zstd --patch-from=<old core> <new core>'. The buildbot publishes
+ * deltas next to the core archive, named after the CRC32 of both
+ * builds:
+ *
+ *    snes9x_libretro.so.zip                   <- full archive
+ *    snes9x_libretro.so.1a2b3c4d-5e6f7a8b.zst <- delta from 1a2b3c4d
+ *
+ * A delta is therefore only fetched for the exact build installed,
+ * and the rebuilt core is checked against the CRC of the build the
+ * core updater list advertises before it replaces anything. */
+
+/* Largest core a delta may rebuild. Also bounds the
+ * window of the frame, which spans the whole base core */
+#define CORE_UPDATER_DELTA_WINDOW_LOG 28
+#define CORE_UPDATER_DELTA_MAX_SIZE   (1 << CORE_UPDATER_DELTA_WINDOW_LOG)
+
+/**
+ * core_updater_delta_get_url:
+ * @s                : Output URL.
+ * @len              : Size of @s.
+ * @remote_core_path : URL of the full core archive.
+ * @base_crc         : CRC32 of the installed core.
+ * @target_crc       : CRC32 of the core to install.
+ *
+ * Returns: length of the URL written to @s, or 0.
+ **/
+size_t core_updater_delta_get_url(char *s, size_t len,
+      const char *remote_core_path,
+      uint32_t base_crc, uint32_t target_crc);
+
+/**
+ * core_updater_delta_apply:
+ * @base_path  : Installed core the delta was made against.
+ * @delta_path : Downloaded delta.
+ * @out_path   : Core to write. May be @base_path.
+ * @target_crc : Expected CRC32 of the rebuilt core.
+ *
+ * Rebuilds the core and writes it to @out_path, only if its
+ * CRC32 is @target_crc. @out_path is replaced atomically, a
+ * failed update leaves the installed core in place.
+ *
+ * Returns: true if @out_path now holds the rebuilt core.
+ **/
+bool core_updater_delta_apply(const char *base_path,
+      const char *delta_path, const char *out_path,
+      uint32_t target_crc);
+
+RETRO_END_DECLS
+
+#endif
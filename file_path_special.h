@@ -96,6 +96,7 @@ RETRO_BEGIN_DECLS
 #define FILE_PATH_BACKGROUND_IMAGE "bg.png"
 #define FILE_PATH_TTF_FONT "font.ttf"
 #define FILE_PATH_RUNTIME_EXTENSION ".lrtl"
+#define FILE_PATH_RUNTIME_DATABASE "content_runtime.lrtdb"
 #define FILE_PATH_DEFAULT_EVENT_LOG "retroarch.log"
 #define FILE_PATH_EVENT_LOG_EXTENSION ".log"
 #define FILE_PATH_DISK_CONTROL_INDEX_EXTENSION ".ldci"
@@ -0,0 +1,827 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <gfx/scaler/pixconv.h>
+#include <gfx/video_frame.h>
+
+#include "softrender.h"
+
+static bool softrender_realloc(uint32_t **buf, unsigned *size,
+      unsigned count)
+{
+   uint32_t *tmp;
+
+   if (count <= *size)
+      return true;
+
+   tmp = (uint32_t*)realloc(*buf, count * sizeof(uint32_t));
+   if (!tmp)
+      return false;
+
+   *buf  = tmp;
+   *size = count;
+   return true;
+}
+
+static void softrender_fill(uint32_t *dst, unsigned pitch,
+      unsigned width, unsigned height)
+{
+   unsigned y;
+
+   if (!width || !height)
+      return;
+   for (y = 0; y < height; y++, dst += pitch)
+      memset(dst, 0, width * sizeof(uint32_t));
+}
+
+static void softrender_clear_borders(softrender_t *r)
+{
+   uint32_t *out   = r->out;
+   unsigned pitch  = r->out_pitch;
+   unsigned bottom = r->vp_y + r->vp_height;
+   unsigned right  = r->vp_x + r->vp_width;
+
+   softrender_fill(out, pitch, r->out_width, r->vp_y);
+   softrender_fill(out + bottom * pitch, pitch,
+         r->out_width, r->out_height - bottom);
+   softrender_fill(out + r->vp_y * pitch, pitch,
+         r->vp_x, r->vp_height);
+   softrender_fill(out + r->vp_y * pitch + right, pitch,
+         r->out_width - right, r->vp_height);
+}
+
+/* Repeats every pixel of @src @scale times */
+static void softrender_expand_row(uint32_t *dst, const uint32_t *src,
+      unsigned width, unsigned scale)
+{
+   unsigned x = 0;
+
+   switch (scale)
+   {
+      case 1:
+         memcpy(dst, src, width * sizeof(uint32_t));
+         return;
+#if defined(__SSE2__)
+      case 2:
+         for (; x + 4 <= width; x += 4, dst += 8)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)dst,       _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(v, v));
+         }
+         break;
+      case 4:
+         for (; x + 4 <= width; x += 4, dst += 16)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)dst,
+                  _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 0, 0)));
+            _mm_storeu_si128((__m128i*)(dst + 4),
+                  _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+            _mm_storeu_si128((__m128i*)(dst + 8),
+                  _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+            _mm_storeu_si128((__m128i*)(dst + 12),
+                  _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+         }
+         break;
+      default:
+         if (scale >= 4)
+         {
+            /* Whole vectors per pixel, then the remainder */
+            for (; x < width; x++)
+            {
+               unsigned i;
+               __m128i v = _mm_set1_epi32((int)src[x]);
+               for (i = 0; i + 4 <= scale; i += 4)
+                  _mm_storeu_si128((__m128i*)(dst + i), v);
+               for (; i < scale; i++)
+                  dst[i] = src[x];
+               dst += scale;
+            }
+            return;
+         }
+         break;
+#endif
+   }
+
+   for (; x < width; x++)
+   {
+      unsigned i;
+      for (i = 0; i < scale; i++)
+         *dst++ = src[x];
+   }
+}
+
+/* Returns a row of the core frame as XRGB8888 */
+static const uint32_t *softrender_src_row(softrender_t *r,
+      const uint8_t *frame, unsigned y, unsigned width,
+      unsigned pitch, bool rgb32)
+{
+   const uint8_t *row = frame + (size_t)y * pitch;
+
+   if (rgb32)
+      return (const uint32_t*)row;
+
+   conv_rgb565_argb8888(r->line, row, width, 1,
+         width * sizeof(uint32_t), pitch);
+   return r->line;
+}
+
+static void softrender_draw_nearest(softrender_t *r, const uint8_t *frame,
+      unsigned width, unsigned height, unsigned pitch, bool rgb32)
+{
+   unsigned x, y;
+   unsigned vp_width  = r->vp_width;
+   unsigned vp_height = r->vp_height;
+   uint32_t *dst      = r->out + r->vp_y * r->out_pitch + r->vp_x;
+   int last_src_y     = -1;
+
+   /* Exact multiples: expand each source row once, then copy it down */
+   if (     vp_width  % width  == 0
+         && vp_height % height == 0)
+   {
+      unsigned scale_x = vp_width  / width;
+      unsigned scale_y = vp_height / height;
+
+      for (y = 0; y < height; y++)
+      {
+         unsigned i;
+         uint32_t *first = dst;
+
+         softrender_expand_row(dst,
+               softrender_src_row(r, frame, y, width, pitch, rgb32),
+               width, scale_x);
+         dst += r->out_pitch;
+
+         for (i = 1; i < scale_y; i++, dst += r->out_pitch)
+            memcpy(dst, first, vp_width * sizeof(uint32_t));
+      }
+      return;
+   }
+
+   if (     r->xmap_src_width != width
+         || r->xmap_vp_width  != vp_width
+         || r->xmap_filter    != SOFTRENDER_FILTER_NEAREST)
+   {
+      /* Sample at pixel centres */
+      for (x = 0; x < vp_width; x++)
+         r->xmap[x] = (uint32_t)(((uint64_t)(2 * x + 1) * width)
+               / (2 * vp_width));
+      r->xmap_src_width = width;
+      r->xmap_vp_width  = vp_width;
+      r->xmap_filter    = SOFTRENDER_FILTER_NEAREST;
+   }
+
+   for (y = 0; y < vp_height; y++, dst += r->out_pitch)
+   {
+      const uint32_t *src;
+      int src_y = (int)(((uint64_t)(2 * y + 1) * height)
+            / (2 * vp_height));
+
+      /* Rows sampling the same source row are identical */
+      if (src_y == last_src_y)
+      {
+         memcpy(dst, dst - r->out_pitch, vp_width * sizeof(uint32_t));
+         continue;
+      }
+
+      src = softrender_src_row(r, frame, src_y, width, pitch, rgb32);
+      for (x = 0; x < vp_width; x++)
+         dst[x] = src[r->xmap[x]];
+      last_src_y = src_y;
+   }
+}
+
+/* Scales source row @y horizontally into @dst */
+static void softrender_bilinear_row(softrender_t *r, uint32_t *dst,
+      const uint8_t *frame, unsigned y, unsigned width,
+      unsigned pitch, bool rgb32)
+{
+   unsigned x;
+   const uint32_t *src;
+   const uint16_t *weights = r->xweights;
+   unsigned vp_width       = r->vp_width;
+
+   /* Pad with the last pixel so x + 1 is always readable */
+   if (rgb32)
+      memcpy(r->line, frame + (size_t)y * pitch, width * sizeof(uint32_t));
+   else
+      conv_rgb565_argb8888(r->line, frame + (size_t)y * pitch, width, 1,
+            width * sizeof(uint32_t), pitch);
+   r->line[width] = r->line[width - 1];
+   src            = r->line;
+
+#if defined(__SSE2__)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      for (x = 0; x < vp_width; x++, weights += 8)
+      {
+         __m128i p = _mm_unpacklo_epi8(
+               _mm_loadl_epi64((const __m128i*)(src + r->xmap[x])), zero);
+         __m128i m = _mm_mullo_epi16(p,
+               _mm_loadu_si128((const __m128i*)weights));
+         m         = _mm_srli_epi16(_mm_add_epi16(m,
+                  _mm_srli_si128(m, 8)), 8);
+         dst[x]    = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(m, m));
+      }
+   }
+#else
+   for (x = 0; x < vp_width; x++, weights += 8)
+   {
+      unsigned k;
+      uint32_t a   = src[r->xmap[x]];
+      uint32_t b   = src[r->xmap[x] + 1];
+      uint32_t out = 0;
+      for (k = 0; k < 32; k += 8)
+         out |= ((((a >> k) & 0xff) * weights[0]
+                + ((b >> k) & 0xff) * weights[4]) >> 8) << k;
+      dst[x] = out;
+   }
+#endif
+}
+
+/* dst = (a * (256 - f) + b * f) >> 8 per channel */
+static void softrender_lerp_rows(uint32_t *dst, const uint32_t *a,
+      const uint32_t *b, unsigned width, unsigned f)
+{
+   unsigned x = 0;
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i fa   = _mm_set1_epi16((short)(256 - f));
+   const __m128i fb   = _mm_set1_epi16((short)f);
+
+   for (; x + 4 <= width; x += 4)
+   {
+      __m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+      __m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+      __m128i lo = _mm_srli_epi16(_mm_add_epi16(
+               _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), fa),
+               _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), fb)), 8);
+      __m128i hi = _mm_srli_epi16(_mm_add_epi16(
+               _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), fa),
+               _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), fb)), 8);
+      _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+   }
+#endif
+
+   for (; x < width; x++)
+   {
+      unsigned k;
+      uint32_t out = 0;
+      for (k = 0; k < 32; k += 8)
+         out |= ((((a[x] >> k) & 0xff) * (256 - f)
+                + ((b[x] >> k) & 0xff) * f) >> 8) << k;
+      dst[x] = out;
+   }
+}
+
+/* Separable bilinear: every source row is scaled horizontally at most
+ * once, and output rows interpolate between the two cached ones. */
+static void softrender_draw_bilinear(softrender_t *r, const uint8_t *frame,
+      unsigned width, unsigned height, unsigned pitch, bool rgb32)
+{
+   unsigned x, y;
+   int rows_y[2]      = { -1, -1 };
+   unsigned vp_width  = r->vp_width;
+   unsigned vp_height = r->vp_height;
+   uint32_t *dst      = r->out + r->vp_y * r->out_pitch + r->vp_x;
+
+   if (     r->xmap_src_width != width
+         || r->xmap_vp_width  != vp_width
+         || r->xmap_filter    != SOFTRENDER_FILTER_BILINEAR)
+   {
+      for (x = 0; x < vp_width; x++)
+      {
+         /* Source position of the pixel centre in 1/256ths */
+         int pos = (int)((((int64_t)(2 * x + 1) * width << 8)
+                  / (2 * vp_width)) - 128);
+         unsigned f, k;
+
+         if (pos < 0)
+            pos = 0;
+         r->xmap[x] = (uint32_t)(pos >> 8);
+         f          = pos & 0xff;
+         if (r->xmap[x] >= width - 1)
+         {
+            r->xmap[x] = width - 1;
+            f          = 0;
+         }
+         for (k = 0; k < 4; k++)
+         {
+            r->xweights[x * 8 + k]     = (uint16_t)(256 - f);
+            r->xweights[x * 8 + 4 + k] = (uint16_t)f;
+         }
+      }
+      r->xmap_src_width = width;
+      r->xmap_vp_width  = vp_width;
+      r->xmap_filter    = SOFTRENDER_FILTER_BILINEAR;
+   }
+
+   for (y = 0; y < vp_height; y++, dst += r->out_pitch)
+   {
+      int pos = (int)((((int64_t)(2 * y + 1) * height << 8)
+               / (2 * vp_height)) - 128);
+      int y0, y1;
+      unsigned f;
+
+      if (pos < 0)
+         pos = 0;
+      y0 = pos >> 8;
+      f  = pos & 0xff;
+      if (y0 >= (int)height - 1)
+      {
+         y0 = height - 1;
+         f  = 0;
+      }
+      y1 = y0 + 1;
+
+      /* Moving down, the old second row is usually the new first one */
+      if (rows_y[0] != y0)
+      {
+         if (rows_y[1] == y0)
+         {
+            uint32_t *tmp = r->rows[0];
+            r->rows[0]    = r->rows[1];
+            r->rows[1]    = tmp;
+            rows_y[1]     = rows_y[0];
+         }
+         else
+            softrender_bilinear_row(r, r->rows[0], frame, y0,
+                  width, pitch, rgb32);
+         rows_y[0] = y0;
+      }
+
+      if (f && rows_y[1] != y1)
+      {
+         softrender_bilinear_row(r, r->rows[1], frame, y1,
+               width, pitch, rgb32);
+         rows_y[1] = y1;
+      }
+
+      if (f)
+         softrender_lerp_rows(dst, r->rows[0], r->rows[1], vp_width, f);
+      else
+         memcpy(dst, r->rows[0], vp_width * sizeof(uint32_t));
+   }
+}
+
+bool softrender_init(softrender_t *r, const softrender_sink_t *sink,
+      unsigned width, unsigned height)
+{
+   memset(r, 0, sizeof(*r));
+
+   r->sink       = sink;
+   r->sink_data  = sink->init(width, height);
+   r->menu_alpha = 256;
+   r->clear      = true;
+
+   if (!r->sink_data)
+      return false;
+
+   r->menu_scaler.scaler_type = SCALER_TYPE_BILINEAR;
+   r->menu_scaler.in_fmt      = SCALER_FMT_ARGB8888;
+   r->menu_scaler.out_fmt     = SCALER_FMT_ARGB8888;
+
+   return true;
+}
+
+void softrender_free(softrender_t *r)
+{
+   if (r->sink_data)
+      r->sink->free(r->sink_data);
+   r->sink_data = NULL;
+
+   scaler_ctx_gen_reset(&r->menu_scaler);
+
+   free(r->line);
+   free(r->xmap);
+   free(r->xweights);
+   free(r->rows[0]);
+   free(r->rows[1]);
+   free(r->menu);
+   free(r->menu_scaled);
+   r->line        = NULL;
+   r->xmap        = NULL;
+   r->xweights    = NULL;
+   r->rows[0]     = NULL;
+   r->rows[1]     = NULL;
+   r->menu        = NULL;
+   r->menu_scaled = NULL;
+}
+
+bool softrender_begin(softrender_t *r, unsigned width, unsigned height)
+{
+   unsigned pitch = 0;
+   uint32_t *out  = r->sink->get_buffer(r->sink_data, width, height, &pitch);
+
+   if (!out)
+      return false;
+
+   if (     out    != r->out
+         || pitch  != r->out_pitch
+         || width  != r->out_width
+         || height != r->out_height)
+   {
+      r->out        = out;
+      r->out_pitch  = pitch;
+      r->out_width  = width;
+      r->out_height = height;
+      r->clear      = true;
+      r->menu_dirty = true;
+   }
+
+   return true;
+}
+
+void softrender_set_viewport(softrender_t *r,
+      int x, int y, unsigned width, unsigned height)
+{
+   /* Integer scaling can ask for more than fits; crop to the output */
+   if (x < 0)
+   {
+      width  = ((unsigned)-x < width)  ? width  + x : 0;
+      x      = 0;
+   }
+   if (y < 0)
+   {
+      height = ((unsigned)-y < height) ? height + y : 0;
+      y      = 0;
+   }
+   if ((unsigned)x > r->out_width)
+      x      = r->out_width;
+   if ((unsigned)y > r->out_height)
+      y      = r->out_height;
+   if (width  > r->out_width  - x)
+      width  = r->out_width  - x;
+   if (height > r->out_height - y)
+      height = r->out_height - y;
+
+   if (     x      == r->vp_x
+         && y      == r->vp_y
+         && width  == r->vp_width
+         && height == r->vp_height)
+      return;
+
+   r->vp_x       = x;
+   r->vp_y       = y;
+   r->vp_width   = width;
+   r->vp_height  = height;
+   r->clear      = true;
+   r->menu_dirty = true;
+}
+
+void softrender_draw_frame(softrender_t *r, const void *frame,
+      unsigned width, unsigned height, unsigned pitch, bool rgb32)
+{
+   if (!r->out)
+      return;
+
+   if (r->clear)
+   {
+      softrender_clear_borders(r);
+      r->clear = false;
+   }
+
+   if (!frame || !width || !height || !r->vp_width || !r->vp_height)
+   {
+      softrender_fill(r->out + r->vp_y * r->out_pitch + r->vp_x,
+            r->out_pitch, r->vp_width, r->vp_height);
+      return;
+   }
+
+   if (     !softrender_realloc(&r->line, &r->line_size, width + 1)
+         || !softrender_realloc(&r->xmap, &r->xmap_size, r->vp_width))
+      return;
+
+   if (r->filter == SOFTRENDER_FILTER_BILINEAR)
+   {
+      if (r->rows_size < r->vp_width)
+      {
+         unsigned i;
+         uint16_t *weights = (uint16_t*)realloc(r->xweights,
+               r->vp_width * 8 * sizeof(uint16_t));
+         if (!weights)
+            return;
+         r->xweights = weights;
+
+         for (i = 0; i < 2; i++)
+         {
+            uint32_t *row = (uint32_t*)realloc(r->rows[i],
+                  r->vp_width * sizeof(uint32_t));
+            if (!row)
+               return;
+            r->rows[i] = row;
+         }
+         r->rows_size = r->vp_width;
+      }
+
+      softrender_draw_bilinear(r, (const uint8_t*)frame,
+            width, height, pitch, rgb32);
+      return;
+   }
+
+   softrender_draw_nearest(r, (const uint8_t*)frame,
+         width, height, pitch, rgb32);
+}
+
+bool softrender_set_menu(softrender_t *r, const void *frame, bool rgb32,
+      unsigned width, unsigned height, float alpha)
+{
+   unsigned i;
+   unsigned count = width * height;
+
+   if (!softrender_realloc(&r->menu, &r->menu_size, count))
+      return false;
+
+   if (rgb32)
+      memcpy(r->menu, frame, count * sizeof(uint32_t));
+   else
+   {
+      /* conv_rgba4444_argb8888 drops the alpha channel on MMX */
+      const uint16_t *src = (const uint16_t*)frame;
+      for (i = 0; i < count; i++)
+      {
+         uint32_t c = src[i];
+         uint32_t a = (c >>  0) & 0xf;
+         uint32_t b = (c >>  4) & 0xf;
+         uint32_t g = (c >>  8) & 0xf;
+         uint32_t red = (c >> 12) & 0xf;
+         r->menu[i] = ((a   * 0x11) << 24) | ((red * 0x11) << 16)
+                    | ((g   * 0x11) <<  8) |  (b   * 0x11);
+      }
+   }
+
+   if (alpha < 0.0f)
+      alpha = 0.0f;
+   else if (alpha > 1.0f)
+      alpha = 1.0f;
+
+   r->menu_width  = width;
+   r->menu_height = height;
+   r->menu_alpha  = (unsigned)(alpha * 256.0f + 0.5f);
+   r->menu_dirty  = true;
+   return true;
+}
+
+void softrender_enable_menu(softrender_t *r, bool enable, bool full_screen)
+{
+   if (full_screen != r->menu_full_screen)
+      r->menu_dirty = true;
+   r->menu_enable      = enable;
+   r->menu_full_screen = full_screen;
+}
+
+/* dst = (src * a + dst * (256 - a)) >> 8 per channel, with
+ * a = src alpha scaled by @global (0-256) and stretched to 0-256.
+ * The SSE2 and C paths give the same result. */
+static void softrender_blend_row(uint32_t *dst, const uint32_t *src,
+      unsigned width, unsigned global)
+{
+   unsigned x = 0;
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i g    = _mm_set1_epi16((short)global);
+   const __m128i full = _mm_set1_epi16(256);
+
+   for (; x + 4 <= width; x += 4)
+   {
+      __m128i s     = _mm_loadu_si128((const __m128i*)(src + x));
+      __m128i d     = _mm_loadu_si128((const __m128i*)(dst + x));
+      __m128i s_lo  = _mm_unpacklo_epi8(s, zero);
+      __m128i s_hi  = _mm_unpackhi_epi8(s, zero);
+      __m128i d_lo  = _mm_unpacklo_epi8(d, zero);
+      __m128i d_hi  = _mm_unpackhi_epi8(d, zero);
+      /* Broadcast alpha (lane 3 of each pixel) to all four lanes */
+      __m128i a_lo  = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+      __m128i a_hi  = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+
+      a_lo = _mm_srli_epi16(_mm_mullo_epi16(a_lo, g), 8);
+      a_hi = _mm_srli_epi16(_mm_mullo_epi16(a_hi, g), 8);
+      a_lo = _mm_add_epi16(a_lo, _mm_srli_epi16(a_lo, 7));
+      a_hi = _mm_add_epi16(a_hi, _mm_srli_epi16(a_hi, 7));
+
+      d_lo = _mm_srli_epi16(_mm_add_epi16(
+               _mm_mullo_epi16(s_lo, a_lo),
+               _mm_mullo_epi16(d_lo, _mm_sub_epi16(full, a_lo))), 8);
+      d_hi = _mm_srli_epi16(_mm_add_epi16(
+               _mm_mullo_epi16(s_hi, a_hi),
+               _mm_mullo_epi16(d_hi, _mm_sub_epi16(full, a_hi))), 8);
+
+      _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(d_lo, d_hi));
+   }
+#endif
+
+   for (; x < width; x++)
+   {
+      unsigned i;
+      uint32_t s   = src[x];
+      uint32_t d   = dst[x];
+      uint32_t out = 0;
+      uint32_t a   = ((s >> 24) * global) >> 8;
+
+      a += a >> 7;
+      for (i = 0; i < 32; i += 8)
+         out |= (((((s >> i) & 0xff) * a
+                 + ((d >> i) & 0xff) * (256 - a)) >> 8) & 0xff) << i;
+      dst[x] = out;
+   }
+}
+
+void softrender_draw_menu(softrender_t *r)
+{
+   unsigned y;
+   int x0, y0;
+   unsigned width, height;
+   uint32_t *dst;
+   const uint32_t *src;
+
+   if (     !r->menu_enable
+         || !r->menu_width
+         || !r->menu_height
+         || !r->out)
+      return;
+
+   if (r->menu_full_screen)
+   {
+      x0     = 0;
+      y0     = 0;
+      width  = r->out_width;
+      height = r->out_height;
+   }
+   else
+   {
+      x0     = r->vp_x;
+      y0     = r->vp_y;
+      width  = r->vp_width;
+      height = r->vp_height;
+   }
+
+   if (!width || !height)
+      return;
+
+   /* The scaled copy only changes with the texture or the layout */
+   if (     r->menu_dirty
+         || r->menu_scaled_width  != width
+         || r->menu_scaled_height != height)
+   {
+      if (!softrender_realloc(&r->menu_scaled, &r->menu_scaled_size,
+               width * height))
+         return;
+
+      r->menu_scaler.scaler_type =
+         (r->menu_filter == SOFTRENDER_FILTER_BILINEAR)
+         ? SCALER_TYPE_BILINEAR : SCALER_TYPE_POINT;
+      /* Force the filter to be rebuilt for the new type */
+      r->menu_scaler.in_width    = 0;
+      video_frame_scale(&r->menu_scaler, r->menu_scaled, r->menu,
+            SCALER_FMT_ARGB8888, width, height, width * sizeof(uint32_t),
+            r->menu_width, r->menu_height,
+            r->menu_width * sizeof(uint32_t));
+
+      r->menu_scaled_width  = width;
+      r->menu_scaled_height = height;
+      r->menu_dirty         = false;
+   }
+
+   /* A full screen menu paints over the borders */
+   if (r->menu_full_screen)
+      r->clear = true;
+
+   dst = r->out + y0 * r->out_pitch + x0;
+   src = r->menu_scaled;
+   for (y = 0; y < height; y++, dst += r->out_pitch, src += width)
+      softrender_blend_row(dst, src, width, r->menu_alpha);
+}
+
+void softrender_draw_mask(softrender_t *r, int x, int y,
+      const uint8_t *mask, unsigned width, unsigned height,
+      unsigned mask_pitch, uint32_t color)
+{
+   int i, j;
+   int w = (int)width;
+   int h = (int)height;
+   uint32_t *dst;
+
+   if (!r->out)
+      return;
+
+   if (x < 0)
+   {
+      mask -= x;
+      w    += x;
+      x     = 0;
+   }
+   if (y < 0)
+   {
+      mask -= y * (int)mask_pitch;
+      h    += y;
+      y     = 0;
+   }
+   if (x + w > (int)r->out_width)
+      w = (int)r->out_width  - x;
+   if (y + h > (int)r->out_height)
+      h = (int)r->out_height - y;
+   if (w <= 0 || h <= 0)
+      return;
+
+   if (     x     < r->vp_x
+         || y     < r->vp_y
+         || x + w > r->vp_x + (int)r->vp_width
+         || y + h > r->vp_y + (int)r->vp_height)
+      r->clear = true;
+
+   dst = r->out + y * r->out_pitch + x;
+   for (j = 0; j < h; j++, dst += r->out_pitch, mask += mask_pitch)
+   {
+      for (i = 0; i < w; i++)
+      {
+         unsigned k;
+         uint32_t d   = dst[i];
+         uint32_t out = 0;
+         uint32_t a   = mask[i];
+
+         if (!a)
+            continue;
+
+         a += a >> 7;
+         for (k = 0; k < 24; k += 8)
+            out |= (((((color >> k) & 0xff) * a
+                    + ((d >> k) & 0xff) * (256 - a)) >> 8) & 0xff) << k;
+         dst[i] = out;
+      }
+   }
+}
+
+void softrender_present(softrender_t *r)
+{
+   if (r->sink->present)
+      r->sink->present(r->sink_data);
+}
+
+typedef struct softrender_memory
+{
+   uint32_t *buffer;
+   unsigned width;
+   unsigned height;
+} softrender_memory_t;
+
+static void *softrender_memory_init(unsigned width, unsigned height)
+{
+   return calloc(1, sizeof(softrender_memory_t));
+}
+
+static uint32_t *softrender_memory_get_buffer(void *data,
+      unsigned width, unsigned height, unsigned *pitch)
+{
+   softrender_memory_t *mem = (softrender_memory_t*)data;
+
+   if (mem->width != width || mem->height != height)
+   {
+      uint32_t *buffer = (uint32_t*)calloc(
+            (size_t)width * height + 1, sizeof(uint32_t));
+      if (!buffer)
+         return NULL;
+      free(mem->buffer);
+      mem->buffer = buffer;
+      mem->width  = width;
+      mem->height = height;
+   }
+
+   *pitch = width;
+   return mem->buffer;
+}
+
+static void softrender_memory_free(void *data)
+{
+   softrender_memory_t *mem = (softrender_memory_t*)data;
+   free(mem->buffer);
+   free(mem);
+}
+
+const softrender_sink_t softrender_sink_memory = {
+   softrender_memory_init,
+   softrender_memory_get_buffer,
+   NULL, /* present */
+   softrender_memory_free,
+   "memory"
+};
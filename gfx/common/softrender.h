@@ -0,0 +1,174 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFTRENDER_H__
+#define SOFTRENDER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <gfx/scaler/scaler.h>
+
+RETRO_BEGIN_DECLS
+
+/* CPU compositor for video drivers without a GPU to lean on.
+ *
+ * Every frame is built in an XRGB8888 buffer owned by a sink: the core
+ * frame is converted and scaled into the viewport, the menu texture is
+ * blended over it, OSD text is drawn on top, and the sink presents it.
+ * Only libretro-common is used here, so the sinks can be swapped for a
+ * plain memory buffer in tools and tests. */
+
+enum softrender_filter
+{
+   SOFTRENDER_FILTER_NEAREST = 0,
+   SOFTRENDER_FILTER_BILINEAR
+};
+
+typedef struct softrender_sink
+{
+   void *(*init)(unsigned width, unsigned height);
+
+   /* Returns the buffer for the next frame, with its pitch in pixels.
+    * The contents are kept between frames as long as the size stays. */
+   uint32_t *(*get_buffer)(void *data, unsigned width, unsigned height,
+         unsigned *pitch);
+
+   void (*present)(void *data);
+   void (*free)(void *data);
+
+   const char *ident;
+} softrender_sink_t;
+
+typedef struct softrender
+{
+   struct scaler_ctx menu_scaler;
+
+   const softrender_sink_t *sink;
+   void *sink_data;
+
+   uint32_t *out;
+   uint32_t *line;       /* One source row converted to XRGB8888 */
+   uint32_t *xmap;       /* Source column of each viewport column */
+   uint16_t *xweights;   /* Bilinear weights of each viewport column */
+   uint32_t *rows[2];    /* Horizontally scaled rows for bilinear */
+   uint32_t *menu;       /* Menu texture, converted */
+   uint32_t *menu_scaled;
+
+   unsigned out_pitch;
+   unsigned out_width;
+   unsigned out_height;
+   /* Allocated sizes in pixels */
+   unsigned line_size;
+   unsigned xmap_size;
+   unsigned menu_size;
+   unsigned menu_scaled_size;
+   unsigned rows_size;
+
+   int vp_x;
+   int vp_y;
+   unsigned vp_width;
+   unsigned vp_height;
+
+   /* Source width the column map was built for */
+   unsigned xmap_src_width;
+   unsigned xmap_vp_width;
+   enum softrender_filter xmap_filter;
+
+   unsigned menu_width;
+   unsigned menu_height;
+   unsigned menu_scaled_width;
+   unsigned menu_scaled_height;
+   /* Global menu alpha, 0-256 */
+   unsigned menu_alpha;
+
+   enum softrender_filter filter;
+   enum softrender_filter menu_filter;
+
+   bool clear;
+   bool menu_enable;
+   bool menu_full_screen;
+   bool menu_dirty;
+} softrender_t;
+
+bool softrender_init(softrender_t *r, const softrender_sink_t *sink,
+      unsigned width, unsigned height);
+
+void softrender_free(softrender_t *r);
+
+/**
+ * softrender_begin:
+ * @r            : compositor
+ * @width        : output width
+ * @height       : output height
+ *
+ * Starts a frame of the given output size.
+ **/
+bool softrender_begin(softrender_t *r, unsigned width, unsigned height);
+
+void softrender_set_viewport(softrender_t *r,
+      int x, int y, unsigned width, unsigned height);
+
+/**
+ * softrender_draw_frame:
+ * @r            : compositor
+ * @frame        : core frame, XRGB8888 or RGB565
+ * @width        : frame width
+ * @height       : frame height
+ * @pitch        : frame pitch in bytes
+ * @rgb32        : whether @frame is XRGB8888
+ *
+ * Scales the frame into the viewport and clears the borders when they
+ * need it. Exact multiples take a replicating fast path with nearest
+ * filtering.
+ **/
+void softrender_draw_frame(softrender_t *r, const void *frame,
+      unsigned width, unsigned height, unsigned pitch, bool rgb32);
+
+/* Keeps a copy of the menu texture (ARGB8888 or RGBA4444). */
+bool softrender_set_menu(softrender_t *r, const void *frame, bool rgb32,
+      unsigned width, unsigned height, float alpha);
+
+void softrender_enable_menu(softrender_t *r, bool enable, bool full_screen);
+
+/* Blends the menu texture over the frame, if enabled. */
+void softrender_draw_menu(softrender_t *r);
+
+/**
+ * softrender_draw_mask:
+ * @r            : compositor
+ * @x            : left edge in the output, may be negative
+ * @y            : top edge in the output, may be negative
+ * @mask         : 8-bit coverage, such as a font atlas glyph
+ * @width        : mask width
+ * @height       : mask height
+ * @mask_pitch   : mask pitch in bytes
+ * @color        : XRGB8888 color
+ *
+ * Draws @color through @mask, clipped to the output.
+ **/
+void softrender_draw_mask(softrender_t *r, int x, int y,
+      const uint8_t *mask, unsigned width, unsigned height,
+      unsigned mask_pitch, uint32_t color);
+
+void softrender_present(softrender_t *r);
+
+/* A sink that just keeps the frame in memory. */
+extern const softrender_sink_t softrender_sink_memory;
+
+RETRO_END_DECLS
+
+#endif
@@ -19,11 +19,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/ipc.h>
 #include <sys/shm.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/XShm.h>
 
+#include <retro_timers.h>
+#include <features/features_cpu.h>
+#include <string/stdstring.h>
+
 #ifdef HAVE_CONFIG_H
 #include "../../config.h"
 #endif
@@ -32,38 +37,335 @@
 #include "../../menu/menu_driver.h"
 #endif
 
+#include "../font_driver.h"
+#include "../common/softrender.h"
 #include "../common/x11_common.h"
+
 #include "../../configuration.h"
+#include "../../frontend/frontend_driver.h"
+#include "../../input/input_driver.h"
 #include "../../verbosity.h"
 
-typedef struct xshm
+/* Everything is composited on the CPU by softrender and handed to the
+ * X server through this sink, in a shared memory segment when the server
+ * allows it. */
+
+typedef struct xshm_sink
 {
-   XShmSegmentInfo shmInfo;
-   XImage* image;
-   uint8_t *fbptr;
+   XShmSegmentInfo shminfo;
+   XImage *image;
    GC gc;
-   int width;
-   int height;
+   unsigned width;
+   unsigned height;
    bool use_shm;
+} xshm_sink_t;
+
+typedef struct xshm
+{
+   softrender_t render;
+   struct video_viewport vp;
+
+   void *font;
+   const font_renderer_driver_t *font_driver;
+
+   /* Queued by set_osd_msg, drawn with the next frame */
+   struct font_params osd_params;
+   char osd_msg[256];
+
+   retro_time_t next_present;
+
+   bool keep_aspect;
+   bool nonblock;
+   bool should_resize;
+   bool osd_pending;
 } xshm_t;
 
+static void xshm_sink_destroy_image(xshm_sink_t *sink)
+{
+   if (!sink->image)
+      return;
+
+   if (sink->use_shm)
+   {
+      XShmDetach(g_x11_dpy, &sink->shminfo);
+      XSync(g_x11_dpy, False);
+      shmdt(sink->shminfo.shmaddr);
+      shmctl(sink->shminfo.shmid, IPC_RMID, NULL);
+      sink->image->data = NULL;
+   }
+   XDestroyImage(sink->image);
+   sink->image = NULL;
+}
+
+static bool xshm_sink_create_image(xshm_sink_t *sink,
+      unsigned width, unsigned height)
+{
+   Visual *visual = DefaultVisual(g_x11_dpy, DefaultScreen(g_x11_dpy));
+   int depth      = DefaultDepth(g_x11_dpy, DefaultScreen(g_x11_dpy));
+
+   if (sink->use_shm)
+   {
+      memset(&sink->shminfo, 0, sizeof(sink->shminfo));
+      sink->image = XShmCreateImage(g_x11_dpy, visual, depth, ZPixmap,
+            NULL, &sink->shminfo, width, height);
+
+      if (sink->image)
+      {
+         sink->shminfo.shmid = shmget(IPC_PRIVATE,
+               sink->image->bytes_per_line * height, IPC_CREAT | 0600);
+         if (sink->shminfo.shmid >= 0)
+         {
+            sink->shminfo.shmaddr  = sink->image->data =
+               (char*)shmat(sink->shminfo.shmid, NULL, 0);
+            sink->shminfo.readOnly = False;
+
+            if (     sink->shminfo.shmaddr != (char*)-1
+                  && XShmAttach(g_x11_dpy, &sink->shminfo))
+            {
+               XSync(g_x11_dpy, False);
+               /* Gone once everybody detached */
+               shmctl(sink->shminfo.shmid, IPC_RMID, NULL);
+               goto created;
+            }
+
+            if (sink->shminfo.shmaddr != (char*)-1)
+               shmdt(sink->shminfo.shmaddr);
+            shmctl(sink->shminfo.shmid, IPC_RMID, NULL);
+         }
+         sink->image->data = NULL;
+         XDestroyImage(sink->image);
+         sink->image = NULL;
+      }
+
+      RARCH_WARN("[XShm] Shared memory unavailable, using XPutImage.\n");
+      sink->use_shm = false;
+   }
+
+   {
+      char *data = (char*)malloc((size_t)width * height * sizeof(uint32_t));
+      if (!data)
+         return false;
+      sink->image = XCreateImage(g_x11_dpy, visual, depth, ZPixmap, 0,
+            data, width, height, 32, width * sizeof(uint32_t));
+      if (!sink->image)
+      {
+         free(data);
+         return false;
+      }
+   }
+
+created:
+   if (sink->image->bits_per_pixel != 32)
+   {
+      RARCH_ERR("[XShm] Only 32 bits per pixel visuals are supported.\n");
+      xshm_sink_destroy_image(sink);
+      return false;
+   }
+
+   sink->width  = width;
+   sink->height = height;
+   return true;
+}
+
+static void *xshm_sink_init(unsigned width, unsigned height)
+{
+   xshm_sink_t *sink = (xshm_sink_t*)calloc(1, sizeof(*sink));
+
+   if (!sink)
+      return NULL;
+
+   sink->use_shm = XShmQueryExtension(g_x11_dpy);
+   if (!sink->use_shm)
+      RARCH_LOG("[XShm] XShm extension not found.\n");
+   sink->gc      = XCreateGC(g_x11_dpy, g_x11_win, 0, NULL);
+
+   return sink;
+}
+
+static uint32_t *xshm_sink_get_buffer(void *data,
+      unsigned width, unsigned height, unsigned *pitch)
+{
+   xshm_sink_t *sink = (xshm_sink_t*)data;
+
+   if (!width || !height)
+      return NULL;
+
+   if (!sink->image || sink->width != width || sink->height != height)
+   {
+      xshm_sink_destroy_image(sink);
+      if (!xshm_sink_create_image(sink, width, height))
+         return NULL;
+   }
+
+   *pitch = sink->image->bytes_per_line / sizeof(uint32_t);
+   return (uint32_t*)sink->image->data;
+}
+
+static void xshm_sink_present(void *data)
+{
+   xshm_sink_t *sink = (xshm_sink_t*)data;
+
+   if (!sink->image)
+      return;
+
+   if (sink->use_shm)
+      XShmPutImage(g_x11_dpy, g_x11_win, sink->gc, sink->image,
+            0, 0, 0, 0, sink->width, sink->height, False);
+   else
+      XPutImage(g_x11_dpy, g_x11_win, sink->gc, sink->image,
+            0, 0, 0, 0, sink->width, sink->height);
+
+   /* The server reads the segment asynchronously; wait for it
+    * before the next frame is drawn into it. */
+   XSync(g_x11_dpy, False);
+}
+
+static void xshm_sink_free(void *data)
+{
+   xshm_sink_t *sink = (xshm_sink_t*)data;
+
+   xshm_sink_destroy_image(sink);
+   if (sink->gc)
+      XFreeGC(g_x11_dpy, sink->gc);
+   free(sink);
+}
+
+static const softrender_sink_t xshm_sink = {
+   xshm_sink_init,
+   xshm_sink_get_buffer,
+   xshm_sink_present,
+   xshm_sink_free,
+   "xshm"
+};
+
+static void xshm_init_font(xshm_t *xshm)
+{
+   settings_t *settings   = config_get_ptr();
+   const char *path_font  = settings->paths.path_font;
+   float video_font_size  = settings->floats.video_font_size;
+
+   if (!settings->bools.video_font_enable)
+      return;
+
+   if (!font_renderer_create_default(&xshm->font_driver, &xshm->font,
+            *path_font ? path_font : NULL, video_font_size))
+      RARCH_LOG("[XShm] Could not initialize fonts.\n");
+}
+
+static void xshm_render_msg(xshm_t *xshm, const char *msg,
+      float pos_x, float pos_y, uint32_t color)
+{
+   int msg_base_x, msg_base_y;
+   const struct font_atlas *atlas = NULL;
+   softrender_t *r                = &xshm->render;
+
+   if (!xshm->font)
+      return;
+
+   atlas      = xshm->font_driver->get_atlas(xshm->font);
+   msg_base_x = pos_x * r->out_width;
+   msg_base_y = r->out_height * (1.0f - pos_y);
+
+   for (; *msg; msg++)
+   {
+      const struct font_glyph *glyph =
+         xshm->font_driver->get_glyph(xshm->font, (uint8_t)*msg);
+
+      if (!glyph)
+         continue;
+
+      softrender_draw_mask(r,
+            msg_base_x + glyph->draw_offset_x,
+            msg_base_y + glyph->draw_offset_y,
+            atlas->buffer + glyph->atlas_offset_x
+            + glyph->atlas_offset_y * atlas->width,
+            glyph->width, glyph->height, atlas->width, color);
+
+      msg_base_x += glyph->advance_x;
+      msg_base_y += glyph->advance_y;
+   }
+}
+
+static void xshm_update_viewport(xshm_t *xshm)
+{
+   unsigned width  = 0;
+   unsigned height = 0;
+
+   x11_get_video_size(NULL, &width, &height);
+
+   if (     !xshm->should_resize
+         && width  == xshm->vp.full_width
+         && height == xshm->vp.full_height)
+      return;
+
+   xshm->vp.full_width  = width;
+   xshm->vp.full_height = height;
+   video_driver_update_viewport(&xshm->vp, false, xshm->keep_aspect);
+   xshm->should_resize  = false;
+}
+
+/* Without vsync to block on, hold presents to the refresh rate */
+static void xshm_pace(xshm_t *xshm, float refresh_rate)
+{
+   retro_time_t now, interval;
+
+   if (xshm->nonblock || refresh_rate <= 0.0f)
+   {
+      xshm->next_present = 0;
+      return;
+   }
+
+   interval = (retro_time_t)(1000000.0f / refresh_rate);
+   now      = cpu_features_get_time_usec();
+
+   if (xshm->next_present > now)
+   {
+      retro_time_t wait = xshm->next_present - now;
+      if (wait >= 1000)
+         retro_sleep((unsigned)(wait / 1000));
+      now = cpu_features_get_time_usec();
+   }
+
+   /* Behind by more than a frame: start over rather than burst */
+   if (now - xshm->next_present > interval)
+      xshm->next_present = now;
+   xshm->next_present += interval;
+}
+
 static void *xshm_init(const video_info_t *video,
       input_driver_t **input, void **input_data)
 {
-   xshm_t* xshm = (xshm_t*)malloc(sizeof(xshm_t));
+   char title[128]                        = {0};
+   XSetWindowAttributes attributes        = {0};
    Window parent;
-   XSetWindowAttributes attributes;
+   unsigned width                         = video->width;
+   unsigned height                        = video->height;
+   video_driver_state_t *video_st         = video_state_get_ptr();
+   const struct retro_game_geometry *geom = &video_st->av_info.geometry;
+   settings_t *settings                   = config_get_ptr();
+   xshm_t *xshm                           = (xshm_t*)calloc(1, sizeof(*xshm));
 
-   XInitThreads();
+   if (!xshm)
+      return NULL;
 
-   g_x11_dpy     = XOpenDisplay(NULL);
+   if (video->fullscreen)
+   {
+      if (!width)
+         width  = geom->base_width;
+      if (!height)
+         height = geom->base_height;
+   }
+
+   XInitThreads();
 
-   xshm->use_shm = true;
+   g_x11_dpy = XOpenDisplay(NULL);
 
-   if (!XShmQueryExtension(g_x11_dpy))
+   if (!g_x11_dpy)
    {
-      RARCH_LOG("[X11] XShm extension not found.\n");
-      xshm->use_shm        = false;
+      RARCH_ERR("[XShm] Cannot connect to the X server.\n");
+      RARCH_ERR("[XShm] Check DISPLAY variable and if X is running.\n");
+      free(xshm);
+      return NULL;
    }
 
 #ifdef RARCH_INTERNAL
@@ -72,65 +374,69 @@ static void *xshm_init(const video_info_t *video,
    parent                  = video->parent;
 #endif
    attributes.border_pixel = 0;
+   attributes.event_mask   = StructureNotifyMask | KeyPressMask |
+      KeyReleaseMask | ButtonReleaseMask | ButtonPressMask | DestroyNotify | ClientMessage;
    g_x11_win               = XCreateWindow(g_x11_dpy, parent,
-			     0, 0, video->width, video->height,
-			     0, 24, CopyFromParent, NULL, CWBorderPixel, &attributes);
+         0, 0, width, height,
+         0, CopyFromParent, InputOutput, CopyFromParent,
+         CWBorderPixel | CWEventMask, &attributes);
    XSetWindowBackground(g_x11_dpy, g_x11_win, 0);
    XMapWindow(g_x11_dpy, g_x11_win);
 
-   if (xshm->use_shm)
-   {
-      xshm->shmInfo.shmid = shmget(IPC_PRIVATE, sizeof(uint32_t) * video->width * video->height,
-				   IPC_CREAT | 0600);
-      if (xshm->shmInfo.shmid < 0)
-         abort();/* seems like an OOM situation... let's just blow up. */
-
-      xshm->shmInfo.shmaddr  = (char*)shmat(xshm->shmInfo.shmid, 0, 0);
-      xshm->shmInfo.readOnly = False;
-      XShmAttach(g_x11_dpy, &xshm->shmInfo);
-      XSync(g_x11_dpy, False);/* no idea why this is required, but I get weird errors without it. */
-      xshm->image = XShmCreateImage(g_x11_dpy, NULL, 24, ZPixmap,
-				    xshm->shmInfo.shmaddr, &xshm->shmInfo, video->width, video->height);
-      xshm->fbptr = (uint8_t*)xshm->shmInfo.shmaddr;
-   }
-   else
+   video_driver_get_window_title(title, sizeof(title));
+   if (title[0])
+      XStoreName(g_x11_dpy, g_x11_win, title);
+
+   x11_set_window_attr(g_x11_dpy, g_x11_win);
+
+   if (video->fullscreen)
    {
-      size_t pitch = video->width * 4;
-      void *data   = malloc (pitch * video->height);
-      if (!data)
-         abort(); /* seems like an OOM situation... let's just blow up. */
-      xshm->image  = XCreateImage(g_x11_dpy, NULL, 24, ZPixmap, 0,
-				 (char *) data, video->width,
-				 video->height, 8, pitch);
-      xshm->fbptr  = (uint8_t*)data;
-      XSync(g_x11_dpy, False);
+      x11_set_net_wm_fullscreen(g_x11_dpy, g_x11_win);
+      x11_show_mouse(xshm, false);
    }
 
-   xshm->gc     = XCreateGC(g_x11_dpy, g_x11_win, 0, NULL);
+   x11_install_quit_atom();
+   frontend_driver_install_signal_handler();
 
-   xshm->width  = video->width;
-   xshm->height = video->height;
+   if (!softrender_init(&xshm->render, &xshm_sink, width, height))
+      goto error;
+
+   xshm->render.filter      = video->smooth
+      ? SOFTRENDER_FILTER_BILINEAR : SOFTRENDER_FILTER_NEAREST;
+   xshm->render.menu_filter = settings->bools.menu_linear_filter
+      ? SOFTRENDER_FILTER_BILINEAR : SOFTRENDER_FILTER_NEAREST;
+   xshm->keep_aspect        = video->force_aspect;
+   xshm->nonblock           = !video->vsync;
+   xshm->should_resize      = true;
+
+   xshm_init_font(xshm);
 
    if (!x11_input_ctx_new(true))
       goto error;
 
    if (input && input_data)
    {
-      settings_t *settings                   = config_get_ptr();
-      void *xinput                           = input_driver_init_wrap(&input_x,
+      void *xinput = input_driver_init_wrap(&input_x,
             settings->arrays.input_joypad_driver);
       if (xinput)
       {
-         *input = &input_x;
+         *input      = &input_x;
          *input_data = xinput;
       }
       else
-         *input = NULL;
+         *input      = NULL;
    }
 
+   xshm_update_viewport(xshm);
+
    return xshm;
- error:
-   free (xshm);
+
+error:
+   softrender_free(&xshm->render);
+   x11_window_destroy(true);
+   XCloseDisplay(g_x11_dpy);
+   g_x11_dpy = NULL;
+   free(xshm);
    return NULL;
 }
 
@@ -138,49 +444,171 @@ static bool xshm_frame(void *data, const void *frame, unsigned width,
       unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
-   unsigned y;
    xshm_t      *xshm  = (xshm_t*)data;
+   softrender_t *r    = &xshm->render;
+   bool rgb32         = (video_info->video_st_flags & VIDEO_FLAG_USE_RGBA) ? true : false;
 #ifdef HAVE_MENU
    bool menu_is_alive = (video_info->menu_st_flags & MENU_ST_FLAG_ALIVE) ? true : false;
-#endif
 
-   for (y = 0; y < height; y++)
-      memcpy(xshm->fbptr + sizeof(uint32_t)*xshm->width*y,
-            (uint8_t*)frame + pitch*y, pitch);
-
-#ifdef HAVE_MENU
    menu_driver_frame(menu_is_alive, video_info);
 #endif
 
-   if (xshm->use_shm)
-      XShmPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
-		   0, 0, 0, 0, xshm->width, xshm->height, False);
-   else
-      XPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
-		0, 0, 0, 0, xshm->width, xshm->height);
-   XFlush(g_x11_dpy);
+   xshm_update_viewport(xshm);
+
+   if (!softrender_begin(r, xshm->vp.full_width, xshm->vp.full_height))
+      return true;
+
+   softrender_set_viewport(r, xshm->vp.x, xshm->vp.y,
+         xshm->vp.width, xshm->vp.height);
+   /* Duped frames come in as NULL; the last one is still in the image
+    * unless something has to be drawn over it */
+   if (frame || r->clear || r->menu_enable)
+      softrender_draw_frame(r, frame, width, height, pitch, rgb32);
+   softrender_draw_menu(r);
+
+   if (xshm->osd_pending)
+   {
+      const struct font_params *p = &xshm->osd_params;
+      xshm_render_msg(xshm, xshm->osd_msg, p->x, p->y,
+              (FONT_COLOR_GET_RED(p->color)   << 16)
+            | (FONT_COLOR_GET_GREEN(p->color) <<  8)
+            |  FONT_COLOR_GET_BLUE(p->color));
+      xshm->osd_pending = false;
+   }
+
+   if (!string_is_empty(msg))
+      xshm_render_msg(xshm, msg,
+            video_info->font_msg_pos_x, video_info->font_msg_pos_y,
+              ((uint32_t)(video_info->font_msg_color_r * 255.0f) << 16)
+            | ((uint32_t)(video_info->font_msg_color_g * 255.0f) <<  8)
+            |  (uint32_t)(video_info->font_msg_color_b * 255.0f));
+
+   xshm_pace(xshm, video_info->refresh_rate);
+   softrender_present(r);
+
+   x11_update_title(NULL);
 
    return true;
 }
 
-static void xshm_set_nonblock_state(void *a, bool b, bool c, unsigned d) { }
-static bool xshm_alive(void *data) { return true; }
-static bool xshm_focus(void *data) { return true; }
-static bool xshm_suppress_screensaver(void *data, bool enable) { return false; }
-static void xshm_free(void *data) { }
-static void xshm_poke_set_filtering(void *data, unsigned index, bool smooth, bool ctx_scaling) { }
-static void xshm_poke_set_aspect_ratio(void *data, unsigned aspect_ratio_idx) { }
-static void xshm_poke_apply_state_changes(void *data) { }
+static void xshm_set_nonblock_state(void *data, bool state,
+      bool adaptive_vsync_enabled, unsigned swap_interval)
+{
+   xshm_t *xshm = (xshm_t*)data;
+   if (xshm)
+      xshm->nonblock = state;
+}
+
+static bool xshm_has_windowed(void *data) { return true; }
+
+static void xshm_free(void *data)
+{
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   x11_input_ctx_destroy();
+
+   softrender_free(&xshm->render);
+
+   if (xshm->font)
+      xshm->font_driver->free(xshm->font);
+
+   x11_window_destroy(true);
+   XCloseDisplay(g_x11_dpy);
+   g_x11_dpy = NULL;
+
+   free(xshm);
+}
+
+static void xshm_viewport_info(void *data, struct video_viewport *vp)
+{
+   xshm_t *xshm = (xshm_t*)data;
+   *vp = xshm->vp;
+}
+
+static bool xshm_read_viewport(void *data, uint8_t *buffer, bool is_idle)
+{
+   unsigned x, y;
+   xshm_t *xshm    = (xshm_t*)data;
+   softrender_t *r = &xshm->render;
+
+   if (!r->out)
+      return false;
+
+   if (!is_idle)
+      video_driver_cached_frame();
+
+   /* BGR24, bottom up */
+   for (y = 0; y < r->vp_height; y++)
+   {
+      const uint32_t *src = r->out
+         + (r->vp_y + r->vp_height - 1 - y) * r->out_pitch + r->vp_x;
+      for (x = 0; x < r->vp_width; x++, buffer += 3)
+      {
+         buffer[0] = (uint8_t)(src[x]);
+         buffer[1] = (uint8_t)(src[x] >> 8);
+         buffer[2] = (uint8_t)(src[x] >> 16);
+      }
+   }
+
+   return true;
+}
+
+static void xshm_poke_set_filtering(void *data, unsigned index,
+      bool smooth, bool ctx_scaling)
+{
+   xshm_t *xshm        = (xshm_t*)data;
+   xshm->render.filter = smooth
+      ? SOFTRENDER_FILTER_BILINEAR : SOFTRENDER_FILTER_NEAREST;
+}
+
+static void xshm_poke_set_aspect_ratio(void *data, unsigned aspect_ratio_idx)
+{
+   xshm_t *xshm        = (xshm_t*)data;
+   xshm->keep_aspect   = true;
+   xshm->should_resize = true;
+}
+
+static void xshm_poke_apply_state_changes(void *data)
+{
+   xshm_t *xshm        = (xshm_t*)data;
+   xshm->should_resize = true;
+}
+
 static void xshm_poke_set_texture_frame(void *data,
       const void *frame, bool rgb32,
-      unsigned width, unsigned height, float alpha) { }
+      unsigned width, unsigned height, float alpha)
+{
+   xshm_t *xshm             = (xshm_t*)data;
+   settings_t *settings     = config_get_ptr();
+
+   xshm->render.menu_filter = settings->bools.menu_linear_filter
+      ? SOFTRENDER_FILTER_BILINEAR : SOFTRENDER_FILTER_NEAREST;
+   softrender_set_menu(&xshm->render, frame, rgb32, width, height, alpha);
+}
+
 static void xshm_poke_texture_enable(void *data,
-      bool enable, bool full_screen) { }
+      bool enable, bool full_screen)
+{
+   xshm_t *xshm = (xshm_t*)data;
+   softrender_enable_menu(&xshm->render, enable, full_screen);
+}
+
 static void xshm_poke_set_osd_msg(void *data,
       const char *msg,
-      const struct font_params *params, void *font) { }
-static void xshm_show_mouse(void *data, bool state) { }
-static void xshm_grab_mouse_toggle(void *data) { }
+      const struct font_params *params, void *font)
+{
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!params || string_is_empty(msg))
+      return;
+
+   strlcpy(xshm->osd_msg, msg, sizeof(xshm->osd_msg));
+   xshm->osd_params  = *params;
+   xshm->osd_pending = true;
+}
 
 static video_poke_interface_t xshm_video_poke_interface = {
    NULL, /* get_flags */
@@ -203,8 +631,8 @@ static video_poke_interface_t xshm_video_poke_interface = {
    xshm_poke_set_texture_frame,
    xshm_poke_texture_enable,
    xshm_poke_set_osd_msg,
-   xshm_show_mouse,
-   xshm_grab_mouse_toggle,
+   x11_show_mouse,
+   NULL, /* grab_mouse_toggle */
    NULL, /* get_current_shader */
    NULL, /* get_current_software_framebuffer */
    NULL, /* get_hw_render_interface */
@@ -219,6 +647,7 @@ static void xshm_get_poke_interface(void *data,
 {
    *iface = &xshm_video_poke_interface;
 }
+
 static bool xshm_set_shader(void *data,
       enum rarch_shader_type type, const char *path) { return false; }
 
@@ -226,17 +655,17 @@ video_driver_t video_xshm = {
    xshm_init,
    xshm_frame,
    xshm_set_nonblock_state,
-   xshm_alive,
-   xshm_focus,
-   xshm_suppress_screensaver,
-   NULL, /* has_windowed */
+   x11_alive,
+   x11_has_focus_internal,
+   x11_suspend_screensaver,
+   xshm_has_windowed,
    xshm_set_shader,
    xshm_free,
    "x11",
    NULL, /* set_viewport */
    NULL, /* set_rotation */
-   NULL, /* viewport_info */
-   NULL, /* read_viewport */
+   xshm_viewport_info,
+   xshm_read_viewport,
    NULL, /* read_frame_raw */
 #ifdef HAVE_OVERLAY
    NULL, /* get_overlay_interface */
@@ -3770,6 +3770,18 @@ void video_driver_frame(const void *data, unsigned width,
    if (!video_driver_active)
       return;
 
+   /* Turbo fast-forward will not show this frame, keep it
+    * away from conversion, filters and the driver */
+   if (runloop_st->fastforward_skip)
+   {
+      if (data)
+         video_st->frame_cache_data = data;
+      video_st->frame_cache_width   = width;
+      video_st->frame_cache_height  = height;
+      video_st->frame_cache_pitch   = pitch;
+      return;
+   }
+
    new_time                      = cpu_features_get_time_usec();
    runloop_st->core_run_time     = new_time - runloop_st->core_run_time;
 
@@ -420,6 +420,8 @@ static void video_thread_loop(void *data)
    bool updated;
    thread_video_t *thr = (thread_video_t*)data;
 
+   sthread_role_apply(STHREAD_ROLE_VIDEO);
+
    for (;;)
    {
       slock_lock(thr->lock);
@@ -146,6 +146,10 @@ COMPRESSION
 #include "../libretro-common/streams/rzip_stream.c"
 #endif
 
+#ifdef HAVE_ZSTD
+#include "../libretro-common/streams/trans_stream_zstd.c"
+#endif
+
 /*============================================================
 ENCODINGS
 ============================================================ */
@@ -175,6 +179,7 @@ CONFIG FILE
 /*============================================================
 CONTENT METADATA RECORDS
 ============================================================ */
+#include "../runtime_db.c"
 #include "../runtime_file.c"
 #include "../disk_index_file.c"
 
@@ -200,6 +205,7 @@ ACHIEVEMENTS
 
 #include "../cheevos/cheevos.c"
 #include "../cheevos/cheevos_client.c"
+#include "../cheevos/cheevos_memory.c"
 #include "../cheevos/cheevos_menu.c"
 
 #if defined(HAVE_CHEEVOS_RVZ)
@@ -249,6 +255,7 @@ CHEATS
 ============================================================ */
 #ifdef HAVE_CHEATS
 #include "../cheat_manager.c"
+#include "../cheat_program.c"
 #endif
 #include "../libretro-common/hash/lrc_hash.c"
 
@@ -615,6 +622,7 @@ INPUT
 #include "../input/input_keymaps.c"
 #include "../tasks/task_autodetect.c"
 #include "../input/input_autodetect_builtin.c"
+#include "../input/input_autodetect_index.c"
 
 #ifdef HAVE_BLISSBOX
 #include "../tasks/task_autodetect_blissbox.c"
@@ -726,6 +734,9 @@ INPUT
 #endif
 
 #ifdef HAVE_UDEV
+#if defined(__linux__) && defined(HAVE_THREADS)
+#include "../input/common/linux_evdev_reader.c"
+#endif
 #include "../input/drivers/udev_input.c"
 #include "../input/drivers_joypad/udev_joypad.c"
 #endif
@@ -868,6 +879,7 @@ RSOUND
 AUDIO
 ============================================================ */
 #include "../audio/audio_driver.c"
+#include "../audio/audio_rate_control.c"
 #if defined(__PS3__) || defined (__PSL1GHT__)
 #include "../audio/drivers/ps3_audio.c"
 #elif defined(XENON)
@@ -1086,6 +1098,10 @@ FILE
 #include "../libretro-common/vfs/vfs_implementation_saf.c"
 #endif
 
+#if defined(HAVE_VFS_ARCHIVE) && !defined(__WINRT__)
+#include "../libretro-common/vfs/vfs_implementation_archive.c"
+#endif
+
 #include "../libretro-common/string/stdstring.c"
 #include "../libretro-common/file/nbio/nbio_stdio.c"
 #if defined(__linux__)
@@ -1235,6 +1251,10 @@ RECORDING
 ============================================================ */
 #include "../record/record_driver.c"
 #include "../record/drivers/record_wav.c"
+#ifdef HAVE_RECORD_SHM
+#include "../record/record_shm_ring.c"
+#include "../record/drivers/record_shm.c"
+#endif
 #ifdef HAVE_FFMPEG
 #include "../record/drivers/record_ffmpeg.c"
 #endif
@@ -1263,6 +1283,7 @@ NETPLAY
 #include "../network/natt.c"
 #include "../network/netplay/netplay_frontend.c"
 #include "../network/netplay/netplay_room_parse.c"
+#include "../network/netplay/netplay_udp.c"
 #include "../libretro-common/net/net_compat.c"
 #include "../libretro-common/net/net_socket.c"
 #include "../libretro-common/net/net_http.c"
@@ -1283,6 +1304,7 @@ NETPLAY
 DATA RUNLOOP
 ============================================================ */
 #include "../tasks/task_powerstate.c"
+#include "../content_cache.c"
 #include "../tasks/task_content.c"
 #ifdef HAVE_CDROM
 #include "../tasks/task_content_disc.c"
@@ -1305,6 +1327,8 @@ DATA RUNLOOP
 #endif
 #endif
 #include "../save.c"
+#include "../state_writer.c"
+#include "../state_store.c"
 #include "../tasks/task_save.c"
 #include "../tasks/task_movie.c"
 #include "../tasks/task_image.c"
@@ -1313,6 +1337,7 @@ DATA RUNLOOP
 #include "../tasks/task_manual_content_scan.c"
 #include "../tasks/task_core_backup.c"
 #ifdef HAVE_TRANSLATE
+#include "../translation_request.c"
 #include "../tasks/task_translation.c"
 #endif
 #ifdef HAVE_ZLIB
@@ -1324,6 +1349,9 @@ DATA RUNLOOP
 #endif
 #if defined(HAVE_NETWORKING) && defined(HAVE_MENU)
 #include "../tasks/task_core_updater.c"
+#ifdef HAVE_ZSTD
+#include "../core_updater_delta.c"
+#endif
 #endif
 
 /*============================================================
@@ -1379,6 +1407,9 @@ MENU
 #include "../menu/cbs/menu_cbs_sublabel.c"
 #include "../menu/menu_displaylist.c"
 #include "../menu/menu_contentless_cores.c"
+#include "../menu/menu_library_search.c"
+#include "../library_search.c"
+#include "../tasks/task_library_search.c"
 #ifdef HAVE_LIBRETRODB
 #include "../menu/menu_explore.c"
 #include "../tasks/task_menu_explore.c"
@@ -0,0 +1,687 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+
+#include "linux_evdev_reader.h"
+
+/* The rings are the only state shared without the lock:
+ * the reader thread publishes events by storing the head
+ * of a ring, the frontend frees them by storing its tail */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define EVDEV_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define EVDEV_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define EVDEV_ADD(p, v)   __atomic_add_fetch((p), (v), __ATOMIC_RELAXED)
+#else
+#define EVDEV_LOAD(p)     __sync_add_and_fetch((p), 0)
+#define EVDEV_STORE(p, v) do { __sync_synchronize(); *(p) = (v); __sync_synchronize(); } while (0)
+#define EVDEV_ADD(p, v)   __sync_add_and_fetch((p), (v))
+#endif
+
+#ifdef input_event_sec
+#define EVDEV_EVENT_SEC(ev)  (ev)->input_event_sec
+#define EVDEV_EVENT_USEC(ev) (ev)->input_event_usec
+#else
+#define EVDEV_EVENT_SEC(ev)  (ev)->time.tv_sec
+#define EVDEV_EVENT_USEC(ev) (ev)->time.tv_usec
+#endif
+
+#define EVDEV_RING_MASK (EVDEV_READER_RING_SIZE - 1)
+
+/* Events read from a device in one go */
+#define EVDEV_READ_CHUNK 64
+
+enum evdev_reader_state
+{
+   EVDEV_READER_FREE = 0,
+   EVDEV_READER_ACTIVE,
+   EVDEV_READER_REMOVING
+};
+
+typedef struct evdev_reader_event
+{
+   struct input_event event;
+   int64_t read_time;
+} evdev_reader_event_t;
+
+typedef struct evdev_reader_device
+{
+   evdev_reader_event_t *ring;
+   int fd;
+   /* Written under the lock */
+   unsigned state;
+   /* Written by the reader thread only */
+   uint32_t head;
+   /* Written by the frontend only */
+   uint32_t tail;
+   /* Set by the reader thread when the ring is full,
+    * cleared by the frontend once it made room */
+   uint32_t stalled;
+   /* The device failed or hung up: the reader thread
+    * stops polling it until it is added again */
+   bool broken;
+} evdev_reader_device_t;
+
+struct evdev_reader
+{
+   evdev_reader_device_t devices[EVDEV_READER_MAX_DEVICES];
+
+   /* Statistics, only touched by the frontend */
+   uint32_t hist_read[EVDEV_READER_HIST_BUCKETS];
+   uint32_t hist_delivery[EVDEV_READER_HIST_BUCKETS];
+   uint64_t events;
+   uint64_t dropped;
+   int64_t read_sum;
+   int64_t read_max;
+   int64_t delivery_sum;
+   int64_t delivery_max;
+
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+
+   /* Wakes the reader thread up when devices change */
+   int wake[2];
+
+   uint32_t stalls;
+   bool quit;
+};
+
+struct evdev_replay
+{
+   struct input_event *events;
+   size_t count;
+   sthread_t *thread;
+   int fds[2];
+   float speed;
+   uint32_t done;
+   uint32_t dropped;
+   uint32_t quit;
+};
+
+static int64_t evdev_time_usec(clockid_t clock)
+{
+   struct timespec ts;
+   clock_gettime(clock, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t evdev_event_time(const struct input_event *event)
+{
+   return (int64_t)EVDEV_EVENT_SEC(event) * 1000000
+      + EVDEV_EVENT_USEC(event);
+}
+
+static bool evdev_pipe(int *fds)
+{
+   if (pipe(fds) < 0)
+      return false;
+
+   fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+   fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+   fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+   fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+   return true;
+}
+
+static void evdev_reader_wake(evdev_reader_t *reader)
+{
+   /* A full pipe already wakes the thread up */
+   char c = 0;
+   if (write(reader->wake[1], &c, 1) < 0) { }
+}
+
+static void evdev_reader_drain(evdev_reader_t *reader,
+      evdev_reader_device_t *dev)
+{
+   struct input_event events[EVDEV_READ_CHUNK];
+   uint32_t head = dev->head;
+
+   for (;;)
+   {
+      ssize_t len;
+      int64_t now;
+      unsigned i, count;
+      uint32_t space = EVDEV_READER_RING_SIZE
+         - (head - EVDEV_LOAD(&dev->tail));
+
+      if (!space)
+      {
+         /* Leave the rest in the kernel until the frontend catches up */
+         EVDEV_STORE(&dev->stalled, 1);
+         EVDEV_ADD(&reader->stalls, 1);
+         break;
+      }
+
+      count = (space < EVDEV_READ_CHUNK) ? space : EVDEV_READ_CHUNK;
+      len   = read(dev->fd, events, count * sizeof(*events));
+
+      if (len < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         if (errno != EAGAIN && errno != EWOULDBLOCK)
+            dev->broken = true;
+         break;
+      }
+      if (len == 0)
+      {
+         dev->broken = true;
+         break;
+      }
+
+      now   = evdev_time_usec(CLOCK_REALTIME);
+      count = (unsigned)(len / sizeof(*events));
+
+      for (i = 0; i < count; i++, head++)
+      {
+         evdev_reader_event_t *slot = &dev->ring[head & EVDEV_RING_MASK];
+         slot->event     = events[i];
+         slot->read_time = now;
+      }
+
+      EVDEV_STORE(&dev->head, head);
+   }
+}
+
+static void evdev_reader_thread(void *data)
+{
+   struct pollfd fds[EVDEV_READER_MAX_DEVICES + 1];
+   evdev_reader_device_t *polled[EVDEV_READER_MAX_DEVICES + 1];
+   evdev_reader_t *reader = (evdev_reader_t*)data;
+
+   fds[0].fd     = reader->wake[0];
+   fds[0].events = POLLIN;
+
+   for (;;)
+   {
+      unsigned i;
+      int count    = 1;
+      bool removed = false;
+
+      slock_lock(reader->lock);
+
+      if (reader->quit)
+      {
+         slock_unlock(reader->lock);
+         break;
+      }
+
+      for (i = 0; i < EVDEV_READER_MAX_DEVICES; i++)
+      {
+         evdev_reader_device_t *dev = &reader->devices[i];
+
+         if (dev->state == EVDEV_READER_REMOVING)
+         {
+            dev->state = EVDEV_READER_FREE;
+            removed    = true;
+            continue;
+         }
+
+         if (     dev->state != EVDEV_READER_ACTIVE
+               || dev->broken
+               || EVDEV_LOAD(&dev->stalled))
+            continue;
+
+         fds[count].fd     = dev->fd;
+         fds[count].events = POLLIN;
+         polled[count++]   = dev;
+      }
+
+      if (removed)
+         scond_broadcast(reader->cond);
+
+      slock_unlock(reader->lock);
+
+      for (i = 0; i < (unsigned)count; i++)
+         fds[i].revents = 0;
+
+      if (poll(fds, count, -1) < 0)
+         continue;
+
+      if (fds[0].revents & POLLIN)
+      {
+         char buf[64];
+         while (read(reader->wake[0], buf, sizeof(buf)) > 0) { }
+      }
+
+      for (i = 1; i < (unsigned)count; i++)
+      {
+         if (fds[i].revents & POLLIN)
+            evdev_reader_drain(reader, polled[i]);
+         else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+            polled[i]->broken = true;
+      }
+   }
+}
+
+evdev_reader_t *evdev_reader_new(void)
+{
+   evdev_reader_t *reader = (evdev_reader_t*)calloc(1, sizeof(*reader));
+
+   if (!reader)
+      return NULL;
+
+   reader->wake[0] = -1;
+   reader->wake[1] = -1;
+
+   if (!evdev_pipe(reader->wake))
+      goto error;
+
+   if (     !(reader->lock = slock_new())
+         || !(reader->cond = scond_new()))
+      goto error;
+
+   if (!(reader->thread = sthread_create(evdev_reader_thread, reader)))
+      goto error;
+
+   return reader;
+
+error:
+   evdev_reader_free(reader);
+   return NULL;
+}
+
+void evdev_reader_free(evdev_reader_t *reader)
+{
+   unsigned i;
+
+   if (!reader)
+      return;
+
+   if (reader->thread)
+   {
+      slock_lock(reader->lock);
+      reader->quit = true;
+      slock_unlock(reader->lock);
+      evdev_reader_wake(reader);
+      sthread_join(reader->thread);
+   }
+
+   for (i = 0; i < EVDEV_READER_MAX_DEVICES; i++)
+      free(reader->devices[i].ring);
+
+   if (reader->cond)
+      scond_free(reader->cond);
+   if (reader->lock)
+      slock_free(reader->lock);
+   if (reader->wake[0] >= 0)
+      close(reader->wake[0]);
+   if (reader->wake[1] >= 0)
+      close(reader->wake[1]);
+
+   free(reader);
+}
+
+int evdev_reader_add(evdev_reader_t *reader, int fd)
+{
+   int i;
+
+   slock_lock(reader->lock);
+
+   for (i = 0; i < EVDEV_READER_MAX_DEVICES; i++)
+   {
+      evdev_reader_device_t *dev = &reader->devices[i];
+
+      if (dev->state != EVDEV_READER_FREE)
+         continue;
+
+      /* Rings are kept once allocated, slots are reused on hotplug */
+      if (!dev->ring && !(dev->ring = (evdev_reader_event_t*)malloc(
+                  EVDEV_READER_RING_SIZE * sizeof(*dev->ring))))
+         break;
+
+      dev->fd      = fd;
+      dev->head    = 0;
+      dev->tail    = 0;
+      dev->stalled = 0;
+      dev->broken  = false;
+      dev->state   = EVDEV_READER_ACTIVE;
+
+      slock_unlock(reader->lock);
+      evdev_reader_wake(reader);
+      return i;
+   }
+
+   slock_unlock(reader->lock);
+   return -1;
+}
+
+void evdev_reader_remove(evdev_reader_t *reader, int id)
+{
+   evdev_reader_device_t *dev;
+
+   if (id < 0 || id >= EVDEV_READER_MAX_DEVICES)
+      return;
+
+   dev = &reader->devices[id];
+
+   slock_lock(reader->lock);
+   if (dev->state == EVDEV_READER_ACTIVE)
+   {
+      dev->state = EVDEV_READER_REMOVING;
+      evdev_reader_wake(reader);
+      /* The thread lets go of the descriptor
+       * before it polls the devices again */
+      while (dev->state != EVDEV_READER_FREE)
+         scond_wait(reader->cond, reader->lock);
+   }
+   slock_unlock(reader->lock);
+}
+
+static void evdev_reader_count(uint32_t *hist, int64_t *sum,
+      int64_t *max, int64_t latency)
+{
+   size_t bucket;
+
+   /* CLOCK_REALTIME may step backwards */
+   if (latency < 0)
+      latency = 0;
+
+   bucket = (size_t)(latency >> EVDEV_READER_HIST_SHIFT);
+   if (bucket >= EVDEV_READER_HIST_BUCKETS)
+      bucket = EVDEV_READER_HIST_BUCKETS - 1;
+
+   hist[bucket]++;
+   *sum += latency;
+   if (latency > *max)
+      *max = latency;
+}
+
+int evdev_reader_read(evdev_reader_t *reader, int id,
+      struct input_event *events, int count)
+{
+   int i, avail;
+   uint32_t tail;
+   int64_t now;
+   evdev_reader_device_t *dev;
+
+   if (id < 0 || id >= EVDEV_READER_MAX_DEVICES || count <= 0)
+      return 0;
+
+   dev   = &reader->devices[id];
+   tail  = dev->tail;
+   avail = (int)(EVDEV_LOAD(&dev->head) - tail);
+   if (avail > count)
+      avail = count;
+
+   now   = evdev_time_usec(CLOCK_REALTIME);
+
+   for (i = 0; i < avail; i++)
+   {
+      const evdev_reader_event_t *slot = &dev->ring[(tail + i) & EVDEV_RING_MASK];
+      int64_t time                     = evdev_event_time(&slot->event);
+
+      events[i] = slot->event;
+
+      if (     slot->event.type == EV_SYN
+            && slot->event.code == SYN_DROPPED)
+         reader->dropped++;
+
+      evdev_reader_count(reader->hist_read,
+            &reader->read_sum, &reader->read_max,
+            slot->read_time - time);
+      evdev_reader_count(reader->hist_delivery,
+            &reader->delivery_sum, &reader->delivery_max,
+            now - time);
+   }
+
+   reader->events += avail;
+   EVDEV_STORE(&dev->tail, tail + avail);
+
+   if (EVDEV_LOAD(&dev->stalled))
+   {
+      EVDEV_STORE(&dev->stalled, 0);
+      evdev_reader_wake(reader);
+   }
+
+   return avail;
+}
+
+static int64_t evdev_reader_percentile(const uint32_t *hist,
+      uint64_t total, unsigned pct)
+{
+   unsigned i;
+   uint64_t seen   = 0;
+   uint64_t target = (total * pct + 99) / 100;
+
+   for (i = 0; i < EVDEV_READER_HIST_BUCKETS; i++)
+   {
+      seen += hist[i];
+      if (seen >= target)
+         break;
+   }
+
+   /* Upper bound of the bucket */
+   return (int64_t)(i + 1) << EVDEV_READER_HIST_SHIFT;
+}
+
+void evdev_reader_get_stats(const evdev_reader_t *reader,
+      evdev_reader_stats_t *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+
+   stats->stalls  = EVDEV_LOAD((uint32_t*)&reader->stalls);
+   stats->dropped = reader->dropped;
+   stats->events  = reader->events;
+
+   if (!reader->events)
+      return;
+
+   stats->read_avg     = reader->read_sum     / (int64_t)reader->events;
+   stats->read_p99     = evdev_reader_percentile(reader->hist_read,
+         reader->events, 99);
+   stats->read_max     = reader->read_max;
+   stats->delivery_avg = reader->delivery_sum / (int64_t)reader->events;
+   stats->delivery_p50 = evdev_reader_percentile(reader->hist_delivery,
+         reader->events, 50);
+   stats->delivery_p99 = evdev_reader_percentile(reader->hist_delivery,
+         reader->events, 99);
+   stats->delivery_max = reader->delivery_max;
+}
+
+void evdev_reader_reset_stats(evdev_reader_t *reader)
+{
+   memset(reader->hist_read,     0, sizeof(reader->hist_read));
+   memset(reader->hist_delivery, 0, sizeof(reader->hist_delivery));
+   reader->events       = 0;
+   reader->dropped      = 0;
+   reader->read_sum     = 0;
+   reader->read_max     = 0;
+   reader->delivery_sum = 0;
+   reader->delivery_max = 0;
+   EVDEV_STORE(&reader->stalls, 0);
+}
+
+static void evdev_replay_thread(void *data)
+{
+   size_t i, max_report;
+   int64_t start, first;
+   struct input_event *out;
+   evdev_replay_t *replay = (evdev_replay_t*)data;
+   bool lost              = false;
+
+   /* Room for the longest report and a SYN_DROPPED */
+   for (i = 0, max_report = 0; i < replay->count; )
+   {
+      size_t j = i;
+      while (j < replay->count && !(replay->events[j].type == EV_SYN
+               && replay->events[j].code == SYN_REPORT))
+         j++;
+      if (j < replay->count)
+         j++;
+      if (j - i > max_report)
+         max_report = j - i;
+      i = j;
+   }
+
+   if (!(out = (struct input_event*)malloc(
+               (max_report + 1) * sizeof(*out))))
+   {
+      EVDEV_STORE(&replay->done, 1);
+      return;
+   }
+
+   start = evdev_time_usec(CLOCK_MONOTONIC);
+   first = evdev_event_time(&replay->events[0]);
+
+   for (i = 0; i < replay->count && !EVDEV_LOAD(&replay->quit); )
+   {
+      size_t j, len = 0;
+      int64_t now, stamp;
+      int64_t due = start + (int64_t)((double)(
+               evdev_event_time(&replay->events[i]) - first)
+            / replay->speed);
+
+      /* Sleep in short steps so that freeing a replay never waits long */
+      while ((now = evdev_time_usec(CLOCK_MONOTONIC)) < due
+            && !EVDEV_LOAD(&replay->quit))
+      {
+         struct timespec ts;
+         int64_t wait = due - now;
+         if (wait > 10000)
+            wait = 10000;
+         ts.tv_sec  = 0;
+         ts.tv_nsec = (long)wait * 1000;
+         nanosleep(&ts, NULL);
+      }
+
+      stamp = evdev_time_usec(CLOCK_REALTIME);
+
+      if (lost)
+      {
+         memset(&out[len], 0, sizeof(out[len]));
+         out[len].type = EV_SYN;
+         out[len].code = SYN_DROPPED;
+         len++;
+      }
+
+      for (j = i; j < replay->count; )
+      {
+         out[len] = replay->events[j++];
+         len++;
+         if (     out[len - 1].type == EV_SYN
+               && out[len - 1].code == SYN_REPORT)
+            break;
+      }
+      i = j;
+
+      for (j = 0; j < len; j++)
+      {
+         EVDEV_EVENT_SEC(&out[j])  = stamp / 1000000;
+         EVDEV_EVENT_USEC(&out[j]) = stamp % 1000000;
+      }
+
+      /* Reports are small enough for pipe writes to be atomic */
+      if (write(replay->fds[1], out, len * sizeof(*out)) < 0)
+      {
+         lost = true;
+         EVDEV_ADD(&replay->dropped, 1);
+      }
+      else
+         lost = false;
+   }
+
+   free(out);
+   EVDEV_STORE(&replay->done, 1);
+}
+
+evdev_replay_t *evdev_replay_new(const char *path, float speed,
+      unsigned buffer_events)
+{
+   void *buf              = NULL;
+   int64_t len            = 0;
+   evdev_replay_t *replay = NULL;
+
+   if (speed <= 0.0f)
+      return NULL;
+
+   if (     !filestream_read_file(path, &buf, &len)
+         || len < (int64_t)sizeof(struct input_event))
+      goto error;
+
+   if (!(replay = (evdev_replay_t*)calloc(1, sizeof(*replay))))
+      goto error;
+
+   replay->events = (struct input_event*)buf;
+   replay->count  = (size_t)len / sizeof(struct input_event);
+   replay->speed  = speed;
+   replay->fds[0] = -1;
+   replay->fds[1] = -1;
+   buf            = NULL;
+
+   if (!evdev_pipe(replay->fds))
+      goto error;
+
+#ifdef F_SETPIPE_SZ
+   /* Rounded up to whole pages */
+   fcntl(replay->fds[1], F_SETPIPE_SZ,
+         (int)(buffer_events * sizeof(struct input_event)));
+#endif
+
+   if (!(replay->thread = sthread_create(evdev_replay_thread, replay)))
+      goto error;
+
+   return replay;
+
+error:
+   free(buf);
+   evdev_replay_free(replay);
+   return NULL;
+}
+
+int evdev_replay_get_fd(const evdev_replay_t *replay)
+{
+   return replay->fds[0];
+}
+
+bool evdev_replay_is_done(const evdev_replay_t *replay)
+{
+   return EVDEV_LOAD((uint32_t*)&replay->done) != 0;
+}
+
+unsigned evdev_replay_get_dropped(const evdev_replay_t *replay)
+{
+   return EVDEV_LOAD((uint32_t*)&replay->dropped);
+}
+
+void evdev_replay_free(evdev_replay_t *replay)
+{
+   if (!replay)
+      return;
+
+   if (replay->thread)
+   {
+      EVDEV_STORE(&replay->quit, 1);
+      sthread_join(replay->thread);
+   }
+
+   if (replay->fds[0] >= 0)
+      close(replay->fds[0]);
+   if (replay->fds[1] >= 0)
+      close(replay->fds[1]);
+
+   free(replay->events);
+   free(replay);
+}
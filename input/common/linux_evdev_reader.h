@@ -0,0 +1,169 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LINUX_EVDEV_READER_H
+#define _LINUX_EVDEV_READER_H
+
+#include <stdint.h>
+
+#include <linux/input.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Devices a reader can drain at once */
+#define EVDEV_READER_MAX_DEVICES 32
+
+/* Events buffered per device, must be a power of two */
+#define EVDEV_READER_RING_SIZE 1024
+
+/* Latency histograms cover 0 to 32.7 ms in steps of 32 us;
+ * anything later is counted in the last bucket */
+#define EVDEV_READER_HIST_SHIFT   5
+#define EVDEV_READER_HIST_BUCKETS 1024
+
+/**
+ * Drains evdev devices on a thread of its own.
+ *
+ * The thread reads every device as soon as the kernel has events
+ * for it, and queues them with the time they were read in a
+ * lock-free ring per device. The frontend takes them from the
+ * rings with evdev_reader_read() when it polls input, so it sees
+ * everything that happened up to that moment, and the kernel
+ * buffers never overflow between two polls.
+ *
+ * Events keep the timestamp the kernel gave them, which is the
+ * CLOCK_REALTIME time at which the device reported them.
+ *
+ * A full ring is not read any further until the frontend takes
+ * events from it; the events wait in the kernel meanwhile.
+ */
+typedef struct evdev_reader evdev_reader_t;
+
+/** Latencies of the events taken from a reader, in microseconds. */
+typedef struct evdev_reader_stats
+{
+   /** Events taken with evdev_reader_read(). */
+   uint64_t events;
+   /** SYN_DROPPED events: the kernel lost events before they were read. */
+   uint64_t dropped;
+   /** Times a ring was full and its device was left unread. */
+   uint64_t stalls;
+   /** From the kernel timestamp to the reader thread reading the event. */
+   int64_t read_avg;
+   int64_t read_p99;
+   int64_t read_max;
+   /** From the kernel timestamp to evdev_reader_read() returning the event. */
+   int64_t delivery_avg;
+   int64_t delivery_p50;
+   int64_t delivery_p99;
+   int64_t delivery_max;
+} evdev_reader_stats_t;
+
+/**
+ * Starts a reader thread with no device.
+ *
+ * @return The reader, or NULL if the thread could not be started.
+ */
+evdev_reader_t *evdev_reader_new(void);
+
+/**
+ * Stops the reader thread. The file descriptors of the devices
+ * still added are left open.
+ */
+void evdev_reader_free(evdev_reader_t *reader);
+
+/**
+ * Has the reader thread drain a device.
+ *
+ * @param fd Nonblocking file descriptor of the device.
+ * @return Identifier of the device in the reader,
+ * or -1 if the reader is full.
+ */
+int evdev_reader_add(evdev_reader_t *reader, int fd);
+
+/**
+ * Stops reading a device, and drops the events queued for it.
+ *
+ * Returns once the reader thread is done with the file descriptor,
+ * so the caller may close it right away.
+ */
+void evdev_reader_remove(evdev_reader_t *reader, int id);
+
+/**
+ * Takes the oldest events queued for a device.
+ *
+ * Must only be called from one thread at a time, usually the one
+ * polling input.
+ *
+ * @param id Identifier returned by evdev_reader_add().
+ * @param events Where to copy the events.
+ * @param count Size of @events.
+ * @return Number of events copied, 0 if none is queued.
+ */
+int evdev_reader_read(evdev_reader_t *reader, int id,
+      struct input_event *events, int count);
+
+/**
+ * Gets the latencies of the events taken since the reader was
+ * started or its statistics were reset.
+ */
+void evdev_reader_get_stats(const evdev_reader_t *reader,
+      evdev_reader_stats_t *stats);
+
+void evdev_reader_reset_stats(evdev_reader_t *reader);
+
+/**
+ * Plays an evdev recording back as a fake device.
+ *
+ * The recording is a raw dump of struct input_event, such as
+ * `cat /dev/input/eventN > file` makes. Reports, the events up to
+ * each SYN_REPORT, are written to a pipe with the spacing they
+ * were recorded with, stamped with the time they are written at.
+ *
+ * Like an evdev client buffer, the pipe holds a limited number of
+ * events; a report that does not fit is dropped, and the next one
+ * that does is preceded by a SYN_DROPPED.
+ */
+typedef struct evdev_replay evdev_replay_t;
+
+/**
+ * Starts playing a recording.
+ *
+ * @param path Recording to play.
+ * @param speed Playback speed, 1.0 for the recorded one.
+ * @param buffer_events Events the fake device buffers, at least
+ * the size of one memory page worth of events.
+ * @return The replay, or NULL on error.
+ */
+evdev_replay_t *evdev_replay_new(const char *path, float speed,
+      unsigned buffer_events);
+
+/** Nonblocking file descriptor to read the played events from. */
+int evdev_replay_get_fd(const evdev_replay_t *replay);
+
+/** Whether every report of the recording was written or dropped. */
+bool evdev_replay_is_done(const evdev_replay_t *replay);
+
+/** Reports dropped because the buffer was full. */
+unsigned evdev_replay_get_dropped(const evdev_replay_t *replay);
+
+/** Stops playing and closes both ends of the pipe. */
+void evdev_replay_free(evdev_replay_t *replay);
+
+RETRO_END_DECLS
+
+#endif
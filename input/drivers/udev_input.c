@@ -81,6 +81,12 @@
 #define UDEV_XKB_HANDLING
 #endif
 
+/* Devices can be drained on a thread of their own */
+#if defined(__linux__) && defined(HAVE_THREADS)
+#define UDEV_EVDEV_READER
+#include "../common/linux_evdev_reader.h"
+#endif
+
 /* Force UDEV_XKB_HANDLING for Lakka */
 #ifdef HAVE_LAKKA
 #ifndef UDEV_XKB_HANDLING
@@ -533,6 +539,9 @@ typedef struct udev_input_device
          const struct input_event *event,
          struct udev_input_device *dev);
    int fd; /* Device file descriptor */
+#ifdef UDEV_EVDEV_READER
+   int reader_id; /* Identifier in the evdev reader, if any */
+#endif
    dev_t dev; /* Device handle */
    udev_input_mouse_t mouse; /* State tracking for mouse-type devices */
 #ifdef UDEV_TOUCH_SUPPORT
@@ -571,6 +580,10 @@ typedef struct udev_input
 #endif
 
    linux_illuminance_sensor_t *illuminance_sensor;
+#ifdef UDEV_EVDEV_READER
+   /* Drains the devices when threaded reading is on */
+   evdev_reader_t *reader;
+#endif
 } udev_input_t;
 
 #ifdef UDEV_XKB_HANDLING
@@ -3265,15 +3278,38 @@ static int udev_input_add_device(udev_input_t *udev,
          goto end;
    }
 
+#ifdef UDEV_EVDEV_READER
+   if (     udev->reader
+         && (device->reader_id = evdev_reader_add(udev->reader, fd)) < 0)
+   {
+      RARCH_ERR("[udev] Too many devices to read (%s).\n", device->ident);
+      goto end;
+   }
+#endif
+
    tmp = (udev_input_device_t**)realloc(udev->devices,
          (udev->num_devices + 1) * sizeof(*udev->devices));
 
    if (!tmp)
+   {
+#ifdef UDEV_EVDEV_READER
+      if (udev->reader)
+         evdev_reader_remove(udev->reader, device->reader_id);
+#endif
       goto end;
+   }
 
    tmp[udev->num_devices++] = device;
    udev->devices            = tmp;
 
+#ifdef UDEV_EVDEV_READER
+   if (udev->reader)
+   {
+      ret = 1;
+      goto end;
+   }
+#endif
+
 #if defined(HAVE_EPOLL)
    event.events             = EPOLLIN;
    event.data.ptr           = device;
@@ -3317,6 +3353,10 @@ static void udev_input_remove_device(udev_input_t *udev, const char *devnode)
       if (!string_is_equal(devnode, udev->devices[i]->devnode))
          continue;
 
+#ifdef UDEV_EVDEV_READER
+      if (udev->reader)
+         evdev_reader_remove(udev->reader, udev->devices[i]->reader_id);
+#endif
       close(udev->devices[i]->fd);
       free(udev->devices[i]);
       memmove(udev->devices + i, udev->devices + i + 1,
@@ -3526,6 +3566,27 @@ static void udev_input_poll(void *data)
    while (udev->monitor && udev_input_poll_hotplug_available(udev->monitor))
       udev_input_handle_hotplug(udev);
 
+#ifdef UDEV_EVDEV_READER
+   /* Everything the reader thread queued up to now */
+   if (udev->reader)
+   {
+      for (i = 0; i < (int)udev->num_devices; i++)
+      {
+         int j, len;
+         struct input_event input_events[32];
+         udev_input_device_t *device = udev->devices[i];
+
+         while ((len = evdev_reader_read(udev->reader, device->reader_id,
+                     input_events, ARRAY_SIZE(input_events))) > 0)
+         {
+            for (j = 0; j < len; j++)
+               device->handle_cb(udev, &input_events[j], device);
+         }
+      }
+      return;
+   }
+#endif
+
 #if defined(HAVE_EPOLL)
    ret = epoll_wait(udev->fd, events, ARRAY_SIZE(events), 0);
 #elif defined(HAVE_KQUEUE)
@@ -3942,6 +4003,29 @@ static void udev_input_free(void *data)
 
    udev->fd = -1;
 
+#ifdef UDEV_EVDEV_READER
+   if (udev->reader)
+   {
+      evdev_reader_stats_t stats;
+      evdev_reader_get_stats(udev->reader, &stats);
+      if (stats.events)
+         RARCH_LOG("[udev] Input latency over %llu events (usec): "
+               "read avg %lld, p99 %lld, max %lld; "
+               "delivered avg %lld, p50 %lld, p99 %lld, max %lld; "
+               "%llu dropped by the kernel, %llu stalls.\n",
+               (unsigned long long)stats.events,
+               (long long)stats.read_avg, (long long)stats.read_p99,
+               (long long)stats.read_max,
+               (long long)stats.delivery_avg, (long long)stats.delivery_p50,
+               (long long)stats.delivery_p99, (long long)stats.delivery_max,
+               (unsigned long long)stats.dropped,
+               (unsigned long long)stats.stalls);
+      /* Stops the thread before the devices are closed */
+      evdev_reader_free(udev->reader);
+      udev->reader = NULL;
+   }
+#endif
+
    for (i = 0; i < udev->num_devices; i++)
    {
       close(udev->devices[i]->fd);
@@ -4113,6 +4197,16 @@ static void *udev_input_init(const char *joypad_driver)
 
    udev->fd  = fd;
 
+#ifdef UDEV_EVDEV_READER
+   if (config_get_ptr()->bools.input_evdev_thread_enable)
+   {
+      if ((udev->reader = evdev_reader_new()))
+         RARCH_LOG("[udev] Reading input devices on a thread.\n");
+      else
+         RARCH_WARN("[udev] Failed to start input reader thread.\n");
+   }
+#endif
+
    if (!open_devices(udev, UDEV_INPUT_KEYBOARD, udev_handle_keyboard))
       goto error;
 
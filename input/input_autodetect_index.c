@@ -0,0 +1,794 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <retro_miscellaneous.h>
+#include <array/rhmap.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <lists/string_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "input_autodetect_index.h"
+
+/* Index of the autoconfig profiles in one directory.
+ *
+ * Every profile is parsed once when the index is built. What the
+ * affinity check reads (vendor/product ID, device name and physical
+ * location of the main entry and each alternative) is stored as a
+ * flat table of match keys, with two sorted views on it: by ID and by
+ * a hash of the device name. The rest of the profile is stored as
+ * key/value string pairs, so the matching profile can be turned back
+ * into a config_file_t without touching its file.
+ *
+ * The index is a single blob, held in memory as-is and written to the
+ * cache directory in native byte order:
+ *
+ *   header | profiles | keys | by_id | by_name | string pool
+ *
+ * It is only valid for the directory modification time it was built
+ * at. Adding, removing or renaming a profile changes that; rewriting
+ * one in place does not, so the file of the profile that matched is
+ * checked as well before it is used. */
+
+#define AUTODETECT_INDEX_MAGIC   0x58414152 /* "RAAX" */
+#define AUTODETECT_INDEX_VERSION 1
+
+/* One main entry and up to 9 alternatives */
+#define AUTODETECT_INDEX_ALTS    10
+
+/* Directories modified more recently than this may still
+ * change within their timestamp granularity. An index built
+ * from one is used once but neither kept nor saved */
+#define AUTODETECT_INDEX_SETTLE_SEC 2
+
+typedef struct autodetect_index_header
+{
+   uint32_t magic;
+   uint32_t version;
+   int64_t dir_stamp;
+   uint32_t dir;            /* Pool offset of the directory path */
+   uint32_t num_files;
+   uint32_t num_profiles;
+   uint32_t num_keys;
+   uint32_t pool_size;
+   uint32_t pad;
+} autodetect_index_header_t;
+
+typedef struct autodetect_index_profile
+{
+   int64_t stamp;           /* File modification time when indexed */
+   int64_t size;
+   uint32_t path;           /* Pool offset */
+   uint32_t entries;        /* Pool offset of the first key/value pair */
+   uint32_t num_entries;
+   uint32_t first_key;
+   uint32_t num_keys;
+   uint32_t pad;
+} autodetect_index_profile_t;
+
+typedef struct autodetect_index_key
+{
+   uint32_t id;             /* vid << 16 | pid, 0 unless both are set */
+   uint32_t name_hash;
+   uint32_t name;           /* Pool offsets, 0 if not set */
+   uint32_t phys;
+   uint32_t profile;
+   uint32_t alt;
+} autodetect_index_key_t;
+
+typedef struct autodetect_index
+{
+   struct autodetect_index *next;
+   uint8_t *data;
+   const autodetect_index_header_t *hdr;
+   const autodetect_index_profile_t *profiles;
+   const autodetect_index_key_t *keys;
+   const uint32_t *by_id;
+   const uint32_t *by_name;
+   const char *pool;
+   size_t size;
+   unsigned generation;
+   bool settled;
+} autodetect_index_t;
+
+typedef struct autodetect_buf
+{
+   uint8_t *data;
+   size_t len;
+   size_t cap;
+} autodetect_buf_t;
+
+/* Only ever touched by the task thread, except for the
+ * generation which the main thread bumps to throw away
+ * every index after a profile was saved */
+static autodetect_index_t *autodetect_indexes         = NULL;
+static volatile unsigned autodetect_index_generation  = 0;
+
+/******************/
+/* Index building */
+/******************/
+
+static bool autodetect_buf_append(autodetect_buf_t *buf,
+      const void *data, size_t len)
+{
+   if (buf->len + len > buf->cap)
+   {
+      size_t cap    = buf->cap ? buf->cap : 4096;
+      uint8_t *tmp  = NULL;
+      while (cap < buf->len + len)
+         cap       *= 2;
+      if (!(tmp = (uint8_t*)realloc(buf->data, cap)))
+         return false;
+      buf->data     = tmp;
+      buf->cap      = cap;
+   }
+   memcpy(buf->data + buf->len, data, len);
+   buf->len += len;
+   return true;
+}
+
+/* Returns the pool offset of @s, or 0 (the empty
+ * string at the start of the pool) for empty strings */
+static uint32_t autodetect_pool_add(autodetect_buf_t *pool, const char *s)
+{
+   uint32_t offset = (uint32_t)pool->len;
+   if (string_is_empty(s))
+      return 0;
+   if (!autodetect_buf_append(pool, s, strlen(s) + 1))
+      return 0;
+   return offset;
+}
+
+/* Platforms without modification times always scan */
+static bool autodetect_index_stat(const char *path,
+      int64_t *stamp, int64_t *size, time_t *mtime)
+{
+   if (!path_get_stamp(path, stamp, size))
+      return false;
+   if (mtime)
+      *mtime = (time_t)(*stamp / 1000000000);
+   return true;
+}
+
+/* Same keys, in the same way, as
+ * input_autoconfigure_get_config_file_affinity() */
+static bool autodetect_index_add_keys(config_file_t *config,
+      uint32_t profile, autodetect_buf_t *keys, autodetect_buf_t *pool)
+{
+   unsigned i;
+
+   for (i = 0; i < AUTODETECT_INDEX_ALTS; i++)
+   {
+      size_t _len;
+      char config_key[30];
+      char config_key_postfix[7];
+      autodetect_index_key_t key;
+      struct config_entry_list *entry = NULL;
+      uint16_t config_vid             = 0;
+      uint16_t config_pid             = 0;
+      int tmp_int                     = 0;
+
+      if (i == 0)
+         config_key_postfix[0] = '\0';
+      else
+         snprintf(config_key_postfix, sizeof(config_key_postfix),
+                  "_alt%u", i);
+
+      key.id        = 0;
+      key.name_hash = 0;
+      key.name      = 0;
+      key.phys      = 0;
+      key.profile   = profile;
+      key.alt       = i;
+
+      _len = strlcpy(config_key, "input_vendor_id", sizeof(config_key));
+      strlcpy(config_key + _len, config_key_postfix,
+            sizeof(config_key) - _len);
+      if (config_get_int(config, config_key, &tmp_int))
+         config_vid = (uint16_t)tmp_int;
+
+      _len = strlcpy(config_key, "input_product_id", sizeof(config_key));
+      strlcpy(config_key + _len, config_key_postfix,
+            sizeof(config_key) - _len);
+      if (config_get_int(config, config_key, &tmp_int))
+         config_pid = (uint16_t)tmp_int;
+
+      if (config_vid != 0 && config_pid != 0)
+         key.id = ((uint32_t)config_vid << 16) | config_pid;
+
+      _len = strlcpy(config_key, "input_device", sizeof(config_key));
+      strlcpy(config_key + _len, config_key_postfix,
+            sizeof(config_key) - _len);
+      if (     (entry = config_get_entry(config, config_key))
+            && !string_is_empty(entry->value))
+      {
+         key.name      = autodetect_pool_add(pool, entry->value);
+         key.name_hash = rhmap_hash_string(entry->value);
+      }
+
+      /* An alternative that matches on neither
+       * can never have a non-zero affinity */
+      if (!key.id && !key.name)
+         continue;
+
+      _len = strlcpy(config_key, "input_phys", sizeof(config_key));
+      strlcpy(config_key + _len, config_key_postfix,
+            sizeof(config_key) - _len);
+      if (     (entry = config_get_entry(config, config_key))
+            && !string_is_empty(entry->value))
+         key.phys = autodetect_pool_add(pool, entry->value);
+
+      if (!autodetect_buf_append(keys, &key, sizeof(key)))
+         return false;
+   }
+
+   return true;
+}
+
+static bool autodetect_index_add_profile(const char *path,
+      autodetect_buf_t *profiles, autodetect_buf_t *keys,
+      autodetect_buf_t *pool)
+{
+   autodetect_index_profile_t profile;
+   struct config_entry_list *entry = NULL;
+   config_file_t *config           = NULL;
+   bool ret                        = false;
+
+   if (!autodetect_index_stat(path, &profile.stamp, &profile.size, NULL))
+      return true;
+   if (!(config = config_file_new_from_path_to_string(path)))
+      return true;
+
+   profile.path        = autodetect_pool_add(pool, path);
+   profile.entries     = (uint32_t)pool->len;
+   profile.num_entries = 0;
+   profile.first_key   = (uint32_t)(keys->len / sizeof(autodetect_index_key_t));
+   profile.pad         = 0;
+
+   /* Lookups return the first entry for a key,
+    * so later duplicates are dropped */
+   for (entry = config->entries; entry; entry = entry->next)
+   {
+      if (     !entry->key
+            || !entry->value
+            || config_get_entry(config, entry->key) != entry)
+         continue;
+      if (    !autodetect_buf_append(pool, entry->key,   strlen(entry->key)   + 1)
+            || !autodetect_buf_append(pool, entry->value, strlen(entry->value) + 1))
+         goto end;
+      profile.num_entries++;
+   }
+
+   if (!autodetect_index_add_keys(config,
+            (uint32_t)(profiles->len / sizeof(profile)), keys, pool))
+      goto end;
+
+   profile.num_keys = (uint32_t)(keys->len / sizeof(autodetect_index_key_t))
+      - profile.first_key;
+   ret = autodetect_buf_append(profiles, &profile, sizeof(profile));
+
+end:
+   config_file_free(config);
+   return ret;
+}
+
+static int autodetect_index_cmp_u64(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+   return (x > y) - (x < y);
+}
+
+/* Fills @view with the indices of the keys sorted by id
+ * (or by name hash), ties in key order */
+static bool autodetect_index_sort_keys(const autodetect_index_key_t *keys,
+      uint32_t num_keys, bool by_name, uint32_t *view)
+{
+   uint32_t i;
+   uint64_t *tmp = (uint64_t*)malloc((num_keys + 1) * sizeof(uint64_t));
+
+   if (!tmp)
+      return false;
+
+   for (i = 0; i < num_keys; i++)
+      tmp[i] = ((uint64_t)(by_name ? keys[i].name_hash : keys[i].id) << 32) | i;
+   qsort(tmp, num_keys, sizeof(uint64_t), autodetect_index_cmp_u64);
+   for (i = 0; i < num_keys; i++)
+      view[i] = (uint32_t)tmp[i];
+
+   free(tmp);
+   return true;
+}
+
+/* Returns a newly allocated index blob for @dir */
+static uint8_t *autodetect_index_build(const char *dir, int64_t dir_stamp,
+      size_t *size)
+{
+   size_t i;
+   autodetect_index_header_t hdr;
+   autodetect_buf_t profiles;
+   autodetect_buf_t keys;
+   autodetect_buf_t pool;
+   uint8_t *data          = NULL;
+   struct string_list *list = NULL;
+   size_t keys_size, views_size;
+   uint8_t *out;
+
+   memset(&profiles, 0, sizeof(profiles));
+   memset(&keys,     0, sizeof(keys));
+   memset(&pool,     0, sizeof(pool));
+
+   if (!autodetect_buf_append(&pool, "", 1))
+      return NULL;
+
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic     = AUTODETECT_INDEX_MAGIC;
+   hdr.version   = AUTODETECT_INDEX_VERSION;
+   hdr.dir_stamp = dir_stamp;
+   hdr.dir       = autodetect_pool_add(&pool, dir);
+
+   /* Same listing as dir_list_new_special(DIR_LIST_AUTOCONFIG),
+    * profiles keep its order */
+   if ((list = dir_list_new(dir, "cfg", false, false, false, false)))
+   {
+      hdr.num_files = (uint32_t)list->size;
+      for (i = 0; i < list->size; i++)
+      {
+         const char *path = list->elems[i].data;
+         if (string_is_empty(path))
+            continue;
+         if (!autodetect_index_add_profile(path, &profiles, &keys, &pool))
+            goto end;
+      }
+   }
+
+   hdr.num_profiles = (uint32_t)(profiles.len / sizeof(autodetect_index_profile_t));
+   hdr.num_keys     = (uint32_t)(keys.len / sizeof(autodetect_index_key_t));
+   hdr.pool_size    = (uint32_t)pool.len;
+   keys_size        = hdr.num_keys * sizeof(autodetect_index_key_t);
+   views_size       = hdr.num_keys * sizeof(uint32_t);
+   *size            = sizeof(hdr) + profiles.len + keys_size
+      + 2 * views_size + pool.len;
+
+   if (!(data = (uint8_t*)malloc(*size)))
+      goto end;
+
+   out = data;
+   memcpy(out, &hdr, sizeof(hdr));
+   out += sizeof(hdr);
+   if (profiles.len)
+      memcpy(out, profiles.data, profiles.len);
+   out += profiles.len;
+   if (keys_size)
+      memcpy(out, keys.data, keys_size);
+   out += keys_size;
+   if (     !autodetect_index_sort_keys((const autodetect_index_key_t*)keys.data,
+               hdr.num_keys, false, (uint32_t*)out)
+         || !autodetect_index_sort_keys((const autodetect_index_key_t*)keys.data,
+               hdr.num_keys, true,  (uint32_t*)(out + views_size)))
+   {
+      free(data);
+      data = NULL;
+      goto end;
+   }
+   out += 2 * views_size;
+   memcpy(out, pool.data, pool.len);
+
+end:
+   if (list)
+      string_list_free(list);
+   free(profiles.data);
+   free(keys.data);
+   free(pool.data);
+   return data;
+}
+
+/* Points @index at the sections of @data, checking that every
+ * offset stays inside the blob. Takes ownership of @data */
+static bool autodetect_index_attach(autodetect_index_t *index,
+      uint8_t *data, size_t size, const char *dir)
+{
+   uint32_t i;
+   size_t expected;
+   const autodetect_index_header_t *hdr = (const autodetect_index_header_t*)data;
+
+   index->data = data;
+   index->size = size;
+
+   if (     size < sizeof(*hdr)
+         || hdr->magic   != AUTODETECT_INDEX_MAGIC
+         || hdr->version != AUTODETECT_INDEX_VERSION
+         || hdr->num_profiles > size
+         || hdr->num_keys     > size
+         || hdr->pool_size    > size
+         || hdr->pool_size    < 1)
+      return false;
+
+   expected = sizeof(*hdr)
+      + (size_t)hdr->num_profiles * sizeof(autodetect_index_profile_t)
+      + (size_t)hdr->num_keys     * (sizeof(autodetect_index_key_t) + 2 * sizeof(uint32_t))
+      + hdr->pool_size;
+   if (expected != size)
+      return false;
+
+   index->hdr      = hdr;
+   index->profiles = (const autodetect_index_profile_t*)(hdr + 1);
+   index->keys     = (const autodetect_index_key_t*)(index->profiles + hdr->num_profiles);
+   index->by_id    = (const uint32_t*)(index->keys + hdr->num_keys);
+   index->by_name  = index->by_id + hdr->num_keys;
+   index->pool     = (const char*)(index->by_name + hdr->num_keys);
+
+   /* Every string ends inside the pool */
+   if (     index->pool[hdr->pool_size - 1] != '\0'
+         || hdr->dir >= hdr->pool_size
+         || !string_is_equal(index->pool + hdr->dir, dir))
+      return false;
+
+   for (i = 0; i < hdr->num_profiles; i++)
+   {
+      const autodetect_index_profile_t *profile = &index->profiles[i];
+      if (     profile->path      >= hdr->pool_size
+            || profile->entries   >  hdr->pool_size
+            || profile->first_key >  hdr->num_keys
+            || profile->num_keys  >  hdr->num_keys - profile->first_key)
+         return false;
+   }
+
+   for (i = 0; i < hdr->num_keys; i++)
+   {
+      const autodetect_index_key_t *key = &index->keys[i];
+      if (     key->name    >= hdr->pool_size
+            || key->phys    >= hdr->pool_size
+            || key->profile >= hdr->num_profiles
+            || index->by_id[i]   >= hdr->num_keys
+            || index->by_name[i] >= hdr->num_keys)
+         return false;
+   }
+
+   return true;
+}
+
+static void autodetect_index_cache_path(char *s, size_t len,
+      const char *dir, const char *cache_dir)
+{
+   char name[32];
+   snprintf(name, sizeof(name), "autoconfig-%08x.idx",
+         (unsigned)encoding_crc32(0, (const uint8_t*)dir, strlen(dir)));
+   fill_pathname_join_special(s, cache_dir, name, len);
+}
+
+static void autodetect_index_save(const autodetect_index_t *index,
+      const char *dir, const char *cache_dir)
+{
+   size_t _len;
+   char path[PATH_MAX_LENGTH];
+   char tmp[PATH_MAX_LENGTH + 8];
+
+   autodetect_index_cache_path(path, sizeof(path), dir, cache_dir);
+   _len = strlcpy(tmp, path, sizeof(tmp));
+   strlcpy(tmp + _len, ".tmp", sizeof(tmp) - _len);
+
+   if (!path_is_directory(cache_dir))
+      path_mkdir(cache_dir);
+
+   /* Never leave a torn index behind */
+   if (filestream_write_file(tmp, index->data, (int64_t)index->size))
+   {
+      filestream_delete(path);
+      if (filestream_rename(tmp, path) != 0)
+         filestream_delete(tmp);
+   }
+}
+
+static void autodetect_index_free(autodetect_index_t *index)
+{
+   if (!index)
+      return;
+   free(index->data);
+   free(index);
+}
+
+/* Returns a current index for @dir, from memory,
+ * from the cache directory or freshly built */
+static autodetect_index_t *autodetect_index_get(const char *dir,
+      const char *cache_dir, int64_t dir_stamp, time_t dir_mtime,
+      bool rebuild)
+{
+   size_t size;
+   uint8_t *data                = NULL;
+   autodetect_index_t *index    = NULL;
+   autodetect_index_t **prev    = &autodetect_indexes;
+   unsigned generation          = autodetect_index_generation;
+   bool persist                 = !string_is_empty(cache_dir);
+   char path[PATH_MAX_LENGTH];
+
+   for (; *prev; prev = &(*prev)->next)
+   {
+      index = *prev;
+      if (!string_is_equal(index->pool + index->hdr->dir, dir))
+         continue;
+      if (     !rebuild
+            && index->settled
+            && index->generation == generation
+            && index->hdr->dir_stamp == dir_stamp)
+         return index;
+      *prev = index->next;
+      autodetect_index_free(index);
+      break;
+   }
+
+   if (!(index = (autodetect_index_t*)calloc(1, sizeof(*index))))
+      return NULL;
+
+   index->generation = generation;
+   index->settled    = (time(NULL) - dir_mtime) > AUTODETECT_INDEX_SETTLE_SEC;
+
+   if (persist)
+      autodetect_index_cache_path(path, sizeof(path), dir, cache_dir);
+
+   if (     persist
+         && !rebuild
+         && index->settled
+         && path_is_valid(path))
+   {
+      void *buf   = NULL;
+      int64_t len = 0;
+
+      if (     filestream_read_file(path, &buf, &len)
+            && autodetect_index_attach(index, (uint8_t*)buf, (size_t)len, dir)
+            && index->hdr->dir_stamp == dir_stamp)
+         goto done;
+
+      free(index->data);
+      index->data = NULL;
+   }
+
+   if (     !(data = autodetect_index_build(dir, dir_stamp, &size))
+         || !autodetect_index_attach(index, data, size, dir))
+   {
+      autodetect_index_free(index);
+      return NULL;
+   }
+
+   /* A profile may have been saved while building */
+   if (     persist
+         && index->settled
+         && generation == autodetect_index_generation)
+      autodetect_index_save(index, dir, cache_dir);
+
+done:
+   index->next        = autodetect_indexes;
+   autodetect_indexes = index;
+   return index;
+}
+
+/************/
+/* Matching */
+/************/
+
+static unsigned autodetect_index_key_affinity(const autodetect_index_t *index,
+      const autodetect_index_key_t *key, const input_autodetect_device_t *device)
+{
+   unsigned affinity = 0;
+
+   if (key->id && key->id == (((uint32_t)device->vid << 16) | device->pid))
+      affinity += 30;
+
+   if (     key->name
+         && !string_is_empty(device->name)
+         && string_is_equal(index->pool + key->name, device->name))
+      affinity += 20;
+
+   if (affinity >= 20 && key->phys)
+   {
+      if (device->phys && strstr(device->phys, index->pool + key->phys))
+         affinity += 10;
+      else
+         affinity -= 10;
+   }
+
+   if (affinity > 0)
+      affinity += key->alt;
+
+   return affinity;
+}
+
+static void autodetect_index_consider(const autodetect_index_t *index,
+      uint32_t k, const input_autodetect_device_t *device,
+      int64_t *best, unsigned *best_eff)
+{
+   const autodetect_index_key_t *key = &index->keys[k];
+   unsigned eff = autodetect_index_key_affinity(index, key, device);
+
+   /* Scanning stops at the first profile scoring 60 or
+    * more, otherwise the first with the highest score
+    * wins: cap at 60 and prefer earlier profiles */
+   if (eff > 60)
+      eff = 60;
+
+   if (     eff > *best_eff
+         || (eff > 0 && eff == *best_eff && key->profile < *best))
+   {
+      *best     = key->profile;
+      *best_eff = eff;
+   }
+}
+
+static size_t autodetect_index_lower_bound(const autodetect_index_t *index,
+      const uint32_t *view, bool by_name, uint32_t value)
+{
+   size_t lo = 0;
+   size_t hi = index->hdr->num_keys;
+
+   while (lo < hi)
+   {
+      size_t mid                        = lo + (hi - lo) / 2;
+      const autodetect_index_key_t *key = &index->keys[view[mid]];
+      if ((by_name ? key->name_hash : key->id) < value)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+/* Returns the index of the best matching profile, or -1 */
+static int64_t autodetect_index_match(const autodetect_index_t *index,
+      const input_autodetect_device_t *device, unsigned *affinity)
+{
+   size_t i;
+   int64_t best      = -1;
+   unsigned best_eff = 0;
+   uint32_t num_keys = index->hdr->num_keys;
+   uint32_t id       = ((uint32_t)device->vid << 16) | device->pid;
+
+   if (device->vid && device->pid)
+   {
+      for (i = autodetect_index_lower_bound(index, index->by_id, false, id);
+            i < num_keys && index->keys[index->by_id[i]].id == id; i++)
+         autodetect_index_consider(index, index->by_id[i], device,
+               &best, &best_eff);
+   }
+
+   if (!string_is_empty(device->name))
+   {
+      uint32_t hash = rhmap_hash_string(device->name);
+      for (i = autodetect_index_lower_bound(index, index->by_name, true, hash);
+            i < num_keys && index->keys[index->by_name[i]].name_hash == hash; i++)
+         autodetect_index_consider(index, index->by_name[i], device,
+               &best, &best_eff);
+   }
+
+   *affinity = 0;
+   if (best >= 0)
+   {
+      const autodetect_index_profile_t *profile = &index->profiles[best];
+      for (i = 0; i < profile->num_keys; i++)
+      {
+         unsigned a = autodetect_index_key_affinity(index,
+               &index->keys[profile->first_key + i], device);
+         if (a > *affinity)
+            *affinity = a;
+      }
+   }
+
+   return best;
+}
+
+static bool autodetect_index_profile_current(const autodetect_index_t *index,
+      const autodetect_index_profile_t *profile)
+{
+   int64_t stamp, size;
+   return autodetect_index_stat(index->pool + profile->path,
+         &stamp, &size, NULL)
+      && stamp == profile->stamp
+      && size  == profile->size;
+}
+
+static config_file_t *autodetect_index_profile_config(
+      const autodetect_index_t *index,
+      const autodetect_index_profile_t *profile)
+{
+   uint32_t i;
+   const char *s        = index->pool + profile->entries;
+   const char *end      = index->pool + index->hdr->pool_size;
+   config_file_t *conf  = config_file_new_alloc();
+
+   if (!conf)
+      return NULL;
+
+   conf->path   = strdup(index->pool + profile->path);
+   conf->flags |= CONF_FILE_FLG_GUARANTEED_NO_DUPLICATES;
+
+   for (i = 0; i < profile->num_entries && s < end; i++)
+   {
+      const char *key   = s;
+      const char *value = key + strlen(key) + 1;
+      if (value >= end)
+         break;
+      s = value + strlen(value) + 1;
+      config_set_string(conf, key, value);
+   }
+
+   conf->flags &= ~(CONF_FILE_FLG_GUARANTEED_NO_DUPLICATES
+         | CONF_FILE_FLG_MODIFIED);
+   return conf;
+}
+
+size_t input_autodetect_index_find(const char *dir,
+      const char *cache_dir,
+      const input_autodetect_device_t *device,
+      config_file_t **conf, unsigned *affinity)
+{
+   int64_t best;
+   int64_t dir_stamp;
+   time_t dir_mtime;
+   autodetect_index_t *index = NULL;
+
+   *conf     = NULL;
+   *affinity = 0;
+
+   if (     string_is_empty(dir)
+         || !autodetect_index_stat(dir, &dir_stamp, NULL, &dir_mtime)
+         || !(index = autodetect_index_get(dir, cache_dir,
+               dir_stamp, dir_mtime, false)))
+      return INPUT_AUTODETECT_INDEX_NONE;
+
+   /* Rewritten in place since the index was built */
+   if (     (best = autodetect_index_match(index, device, affinity)) >= 0
+         && !autodetect_index_profile_current(index, &index->profiles[best]))
+   {
+      if (!(index = autodetect_index_get(dir, cache_dir,
+               dir_stamp, dir_mtime, true)))
+         return INPUT_AUTODETECT_INDEX_NONE;
+      best = autodetect_index_match(index, device, affinity);
+   }
+
+   if (best >= 0)
+      *conf = autodetect_index_profile_config(index, &index->profiles[best]);
+
+   return index->hdr->num_files;
+}
+
+void input_autodetect_index_invalidate(const char *dir,
+      const char *cache_dir)
+{
+   autodetect_index_generation++;
+
+   if (!string_is_empty(dir) && !string_is_empty(cache_dir))
+   {
+      char path[PATH_MAX_LENGTH];
+      autodetect_index_cache_path(path, sizeof(path), dir, cache_dir);
+      if (path_is_valid(path))
+         filestream_delete(path);
+   }
+}
+
+void input_autodetect_index_free(void)
+{
+   while (autodetect_indexes)
+   {
+      autodetect_index_t *next = autodetect_indexes->next;
+      autodetect_index_free(autodetect_indexes);
+      autodetect_indexes = next;
+   }
+}
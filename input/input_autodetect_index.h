@@ -0,0 +1,82 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INPUT_AUTODETECT_INDEX_H
+#define __INPUT_AUTODETECT_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <file/config_file.h>
+
+RETRO_BEGIN_DECLS
+
+/* Returned by input_autodetect_index_find() when
+ * the directory has to be scanned the slow way */
+#define INPUT_AUTODETECT_INDEX_NONE ((size_t)-1)
+
+/* What a connected device is matched on. Leave
+ * vid/pid at 0 to match by name only */
+typedef struct input_autodetect_device
+{
+   const char *name;
+   const char *phys;
+   uint16_t vid;
+   uint16_t pid;
+} input_autodetect_device_t;
+
+/**
+ * input_autodetect_index_find:
+ * @dir         : Autoconfig directory.
+ * @cache_dir   : Where the index is persisted, may be empty.
+ * @device      : Connected device.
+ * @conf        : Set to the best matching profile, or NULL.
+ * @affinity    : Set to the affinity of @conf, see
+ *                input_autoconfigure_get_config_file_affinity().
+ *
+ * Matches @device against every .cfg file in @dir without
+ * parsing any of them. The index is built on first use,
+ * kept in memory and saved to @cache_dir, and rebuilt
+ * when the modification time of @dir (or of the profile
+ * that matched) changes. Picks the same profile that
+ * parsing the files in directory listing order would.
+ *
+ * @return number of .cfg files in @dir, or
+ * INPUT_AUTODETECT_INDEX_NONE if the index is unavailable.
+ **/
+size_t input_autodetect_index_find(const char *dir,
+      const char *cache_dir,
+      const input_autodetect_device_t *device,
+      config_file_t **conf, unsigned *affinity);
+
+/**
+ * input_autodetect_index_invalidate:
+ * @dir         : Autoconfig directory.
+ * @cache_dir   : Where the index is persisted, may be empty.
+ *
+ * Forces a rebuild after a profile in @dir was
+ * rewritten in place, which does not touch the
+ * directory modification time.
+ **/
+void input_autodetect_index_invalidate(const char *dir,
+      const char *cache_dir);
+
+/* Releases all indexes held in memory */
+void input_autodetect_index_free(void);
+
+RETRO_END_DECLS
+
+#endif
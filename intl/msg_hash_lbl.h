@@ -77,6 +77,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_EXPLORE_INITIALISING_LIST,
    "explore_initialising_list"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_LIBRARY_SEARCH_ENTRY,
+   "library_search_entry"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_LIBRARY_SEARCH_INDEXING,
+   "library_search_indexing"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_CONTENTLESS_CORES_TAB,
    "contentless_cores_tab"
@@ -304,6 +312,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA,
    "audio_rate_control_delta"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_TARGET,
+   "audio_rate_control_target"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_AUDIO_RESAMPLER_DRIVER,
    "audio_resampler_driver"
@@ -1082,6 +1094,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_DEFERRED_CONTENTLESS_CORES_LIST,
    "deferred_contentless_cores_list"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST,
+   "deferred_library_search_list"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_DEFERRED_NETPLAY,
    "deferred_netplay"
@@ -1612,6 +1628,18 @@ MSG_HASH(
    MENU_ENUM_LABEL_CORE_INFO_SAVESTATE_BYPASS,
    "core_info_savestate_bypass"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_CONTENT_CACHE_SIZE,
+   "content_cache_size"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_CONTENT_CACHE_COMPRESS,
+   "content_cache_compress"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_ARCHIVE_VFS_MOUNT,
+   "archive_vfs_mount"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_DUMMY_ON_CORE_SHUTDOWN,
    "dummy_on_core_shutdown"
@@ -1638,6 +1666,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_FASTFORWARD_FRAMESKIP,
    "fastforward_frameskip"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_FASTFORWARD_TURBO,
+   "fastforward_turbo"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_FILE_BROWSER_CORE,
    "file_browser_core"
@@ -2518,6 +2550,22 @@ MSG_HASH(
    MENU_ENUM_LABEL_GEKKONET_LOCAL_DELAY,
    "gekkonet_local_delay"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+   "gekkonet_snapshot_check_interval"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_GEKKONET_ROLLBACK_SPREAD,
+   "gekkonet_rollback_spread"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_GEKKONET_RELAY_SERVER,
+   "gekkonet_relay_server"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_GEKKONET_RELAY_SESSION,
+   "gekkonet_relay_session"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_GEKKONET_DESYNC_DETECTION,
    "gekkonet_desync_detection"
@@ -2582,6 +2630,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL,
    "netplay_nat_traversal"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,
+   "netplay_udp_input"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_NETPLAY_ZSTD_LEVEL,
+   "netplay_zstd_level"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_NETPLAY_NICKNAME,
    "netplay_nickname"
@@ -3630,6 +3686,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_SAVESTATE_MAX_KEEP,
    "savestate_max_keep"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_SAVESTATE_FILE_SYNC,
+   "savestate_file_sync"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_SAVESTATE_DEDUP_STORE,
+   "savestate_dedup_store"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_REPLAY_AUTO_INDEX,
    "replay_auto_index"
@@ -4112,6 +4176,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_UNDO_SAVE_STATE,
    "undo_save_state"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_EXPORT_SAVE_STATE,
+   "export_save_state"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_UPDATER_SETTINGS,
    "updater_settings"
@@ -4476,6 +4544,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
    "video_frame_delay_auto"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_THREAD_ROLES_ENABLE,
+   "thread_roles_enable"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_INPUT_EVDEV_THREAD_ENABLE,
+   "input_evdev_thread_enable"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VIDEO_SHADER_DELAY,
    "video_shader_delay"
@@ -5260,6 +5336,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_GOTO_CONTENTLESS_CORES,
    "goto_contentless_cores"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_GOTO_LIBRARY_SEARCH,
+   "goto_library_search"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_MATERIALUI_ICONS_ENABLE,
    "materialui_icons_enable"
@@ -6574,6 +6654,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_AI_SERVICE_PAUSE,
    "ai_service_pause"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_AI_SERVICE_SEND_REGIONS,
+   "ai_service_send_regions"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_DEFERRED_MANUAL_CONTENT_SCAN_LIST,
    "deferred_manual_content_scan_list"
@@ -330,6 +330,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_GOTO_CONTENTLESS_CORES,
    "Installed cores which can operate without loading content will appear here."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_GOTO_LIBRARY_SEARCH,
+   "Search Library"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_GOTO_LIBRARY_SEARCH,
+   "Find content in all playlists as you type, by title, file name, system or database information such as developer and genre."
+   )
 
 /* Main Menu > Online Updater */
 
@@ -2811,6 +2819,22 @@ MSG_HASH(
    MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTOMATIC,
    "Auto"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_THREAD_ROLES_ENABLE,
+   "Thread Scheduling"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_THREAD_ROLES_ENABLE,
+   "Apply the CPU affinity, priority and timer slack set in the configuration file to the main, audio, video and task threads. Real-time priorities fall back to nice values when the system refuses them. Takes effect on restart."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_INPUT_EVDEV_THREAD_ENABLE,
+   "Threaded Input Reading"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_INPUT_EVDEV_THREAD_ENABLE,
+   "Read keyboards, mice and touch devices on a separate thread as soon as they report events, so that no event is lost between two frames. Only applies to the 'udev' input driver. Takes effect when the input driver is reinitialized."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_EFFECTIVE,
    "effective"
@@ -3189,6 +3213,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_HELP_AUDIO_RATE_CONTROL_DELTA,
    "Setting this to 0 disables rate control. Any other value controls audio rate control delta.\nDefines how much input rate can be adjusted dynamically. Input rate is defined as:\ninput rate * (1.0 +/- (rate control delta))"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_AUDIO_RATE_CONTROL_TARGET,
+   "Dynamic Rate Control Target Latency"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_AUDIO_RATE_CONTROL_TARGET,
+   "Amount of queued audio (in ms) dynamic rate control steers towards. Lower values reduce latency but leave less headroom against underruns. 0 keeps the audio buffer half full."
+   )
 
 /* Settings > Audio > MIDI */
 
@@ -4695,6 +4727,30 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_CORE_INFO_SAVESTATE_BYPASS,
    "Specifies whether to ignore core info save state capabilities, allowing to experiment with related features (run ahead, rewind, etc)."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_CONTENT_CACHE_SIZE,
+   "Content Cache Size (MB)"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_CONTENT_CACHE_SIZE,
+   "Keep recently loaded content in memory, up to this many MB, so reloading it or loading it with another core skips reading, extracting and hashing the file. Only applies to cores that load content from memory. 0 disables the cache."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_CONTENT_CACHE_COMPRESS,
+   "Compress Content Cache"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_ARCHIVE_VFS_MOUNT,
+   "Read Zipped Content In Place"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_ARCHIVE_VFS_MOUNT,
+   "Let cores that need the full content path, and read files through the frontend's VFS interface, read content inside zip archives directly instead of extracting it to a temporary file first. Cores that open files on their own will fail to load such content."
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_CONTENT_CACHE_COMPRESS,
+   "Compress content kept in the content cache, so more of it fits in the same memory. Loading cached content takes slightly longer."
+   )
 #ifndef HAVE_DYNAMIC
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_ALWAYS_RELOAD_CORE_ON_RUN_CONTENT,
@@ -4935,6 +4991,30 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_SAVESTATE_MAX_KEEP,
    "Limit the number of save states that will be created when 'Increment Save State Index Automatically' is enabled. If limit is exceeded when saving a new state, the existing state with the lowest index will be deleted. A value of '0' means unlimited states will be recorded."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC,
+   "Save State Flush"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_SAVESTATE_FILE_SYNC,
+   "How save states are flushed to storage. 'Flush' waits for each state to reach storage before reporting it saved. 'Atomic' also writes to a temporary file first and renames it over the state, so a crash or power loss never leaves a truncated state. Slower on storage with expensive flushes."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_FILE,
+   "Flush"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_ATOMIC,
+   "Atomic"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_DEDUP_STORE,
+   "Deduplicate Save States"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_SAVESTATE_DEDUP_STORE,
+   "Split save states into chunks kept once in a folder shared by all states of the content, so slots and backups of the same game take little space. State files only list their chunks. Chunks are compressed when save state compression is enabled."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_REPLAY_MAX_KEEP,
    "Maximum Auto-Increment Replays to Keep"
@@ -5200,6 +5280,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_FASTFORWARD_FRAMESKIP,
    "Skip frames according to fast-forward rate. This conserves power and allows the use of third party frame limiting."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_FASTFORWARD_TURBO,
+   "Turbo Fast-Forward"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_FASTFORWARD_TURBO,
+   "When fast-forwarding without a rate limit, run the core repeatedly between display refreshes and only present the last frame. Audio and video of skipped frames are dropped before any processing, and cores are told through the audio/video enable flags so they can skip rendering them."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_SLOWMOTION_RATIO,
    "Slow-Motion Rate"
@@ -7316,6 +7404,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_AI_SERVICE_PAUSE,
    "Pause core while screen is translated."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_AI_SERVICE_SEND_REGIONS,
+   "Send Changed Regions Only"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_AI_SERVICE_SEND_REGIONS,
+   "In automatic translation, send only the parts of the screen that changed since the previous request, with their position. The AI service must support it."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_AI_SERVICE_SOURCE_LANG,
    "Source Language"
@@ -7809,6 +7905,38 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_GEKKONET_LOCAL_DELAY,
    "Extra local frames of delay before sending inputs to peers."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+   "GekkoNet Snapshot Check Interval"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+   "For cores that support memory-map rollback snapshots, compare a snapshot against full serialization once every this many saves, falling back to full serialization on mismatch. 0 disables the check."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_GEKKONET_ROLLBACK_SPREAD,
+   "GekkoNet Rollback Spread"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_GEKKONET_ROLLBACK_SPREAD,
+   "When resimulating a rollback would not fit in one frame, spread it over at most this many frames, showing predicted frames meanwhile. 0 or 1 always resimulates at once."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_GEKKONET_RELAY_SERVER,
+   "GekkoNet Relay Server"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_GEKKONET_RELAY_SERVER,
+   "Address (host:port) of a GekkoNet relay server. When set, all GekkoNet traffic goes through the relay, for players that cannot connect directly."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_GEKKONET_RELAY_SESSION,
+   "GekkoNet Relay Session"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_GEKKONET_RELAY_SESSION,
+   "Session name shared by all players using the relay server. Required when a relay server is set. Clients take the slot of the first player they request a device for."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_GEKKONET_DESYNC_DETECTION,
    "GekkoNet Desync Detection"
@@ -7913,6 +8041,22 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_NETPLAY_NAT_TRAVERSAL,
    "When hosting, attempt to listen for connections from the public Internet, using UPnP or similar technologies to escape LANs."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_INPUT,
+   "Netplay UDP Input"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_NETPLAY_UDP_INPUT,
+   "Also send input over UDP, repeating recent frames the other side has not acknowledged. A lost packet then no longer holds back later input. Commands and savestates still go over TCP. Both sides must enable it."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_NETPLAY_ZSTD_LEVEL,
+   "Savestate Compression Level"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_NETPLAY_ZSTD_LEVEL,
+   "Highest zstd level for savestates sent to other players. Higher levels send less data over slow connections, but everyone waits while a state is compressed, so the lowest level of all players is used."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_NETPLAY_SHARE_DIGITAL,
    "Digital Input Sharing"
@@ -9038,6 +9182,16 @@ MSG_HASH(
    "Scan selected content."
    )
 
+/* Library search */
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_LIBRARY_SEARCH_INDEXING,
+   "Indexing library..."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_LIBRARY_SEARCH_HINT,
+   "Use Search to find content in all playlists."
+   )
+
 /* Explore tab */
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_EXPLORE_INITIALISING_LIST,
@@ -9427,6 +9581,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_UNDO_SAVE_STATE,
    "If a state was overwritten, it will roll back to the previous save state."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_EXPORT_SAVE_STATE,
+   "Export Save State"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_EXPORT_SAVE_STATE,
+   "Write the save state of the current slot next to it as a standalone file ending in '.export', which loads without the chunks of deduplicated save states."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_REPLAY_SLOT,
    "Replay Slot"
@@ -15590,6 +15752,14 @@ MSG_HASH(
    MSG_UNDOING_SAVE_STATE,
    "Undoing save state"
    )
+MSG_HASH(
+   MSG_EXPORTED_SAVE_STATE_TO,
+   "Exported save state to"
+   )
+MSG_HASH(
+   MSG_FAILED_TO_EXPORT_SAVE_STATE,
+   "Failed to export save state"
+   )
 MSG_HASH(
    MSG_UNKNOWN,
    "Unknown"
@@ -0,0 +1,864 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_miscellaneous.h>
+#include <array/rbuf.h>
+#include <compat/strl.h>
+#include <compat/posix_string.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "library_search.h"
+
+/* A segment is a single blob, held in memory as-is and written to
+ * the index file in native byte order:
+ *
+ *   header | docs | keys | offsets | postings | string pool
+ *
+ * keys holds the distinct trigrams of the segment, sorted. The
+ * entries containing keys[i] are postings[offsets[i]] up to
+ * postings[offsets[i + 1]], in ascending order.
+ *
+ * The text of an entry is folded to lower case words separated by
+ * single spaces, with a space before the first and after the last
+ * one: " super mario world snes ". Trigrams with a space in the
+ * middle would span two words and are left out, those with a space
+ * at either end mark where words start and end. */
+
+#define LIBRARY_SEARCH_MAGIC      0x534c4152 /* "RALS" */
+#define LIBRARY_SEARCH_VERSION    1
+
+/* Longest query, in folded bytes */
+#define LIBRARY_SEARCH_QUERY_MAX  256
+
+typedef struct library_search_header
+{
+   uint32_t magic;
+   uint32_t version;
+   int64_t stamp;           /* Playlist modification time when indexed */
+   int64_t size;
+   uint32_t path;           /* Pool offset of the playlist path */
+   uint32_t num_docs;
+   uint32_t num_keys;
+   uint32_t num_postings;
+   uint32_t pool_size;
+   uint32_t pad;
+} library_search_header_t;
+
+typedef struct library_search_doc_rec
+{
+   uint32_t entry_idx;
+   uint32_t label;          /* Pool offset of the label as given */
+   uint32_t text;           /* Pool offset of the folded text */
+   uint32_t label_len;      /* Folded label length at the start of text */
+} library_search_doc_rec_t;
+
+struct library_search_segment
+{
+   uint8_t *data;
+   const library_search_header_t *hdr;
+   const library_search_doc_rec_t *docs;
+   const uint32_t *keys;
+   const uint32_t *offsets;
+   const uint32_t *postings;
+   const char *pool;
+   size_t size;
+   unsigned refs;
+};
+
+struct library_search
+{
+   library_search_segment_t **segments;
+   /* Query scratch space, sized for the largest segment */
+   uint8_t *hits;
+   uint32_t *touched;
+   size_t scratch_size;
+};
+
+typedef struct library_search_buf
+{
+   uint8_t *data;
+   size_t len;
+   size_t cap;
+} library_search_buf_t;
+
+/*******************/
+/* Text and blobs  */
+/*******************/
+
+static bool library_search_buf_reserve(library_search_buf_t *buf,
+      size_t len)
+{
+   if (buf->len + len > buf->cap)
+   {
+      size_t cap    = buf->cap ? buf->cap : 4096;
+      uint8_t *tmp  = NULL;
+      while (cap < buf->len + len)
+         cap       *= 2;
+      if (!(tmp = (uint8_t*)realloc(buf->data, cap)))
+         return false;
+      buf->data     = tmp;
+      buf->cap      = cap;
+   }
+   return true;
+}
+
+static bool library_search_buf_append(library_search_buf_t *buf,
+      const void *data, size_t len)
+{
+   if (!library_search_buf_reserve(buf, len))
+      return false;
+   memcpy(buf->data + buf->len, data, len);
+   buf->len += len;
+   return true;
+}
+
+static INLINE bool library_search_is_word_char(unsigned char c)
+{
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+      ||  (c >= '0' && c <= '9') ||  c >= 0x80;
+}
+
+/* Appends the words of @in to @s, which holds @pos bytes and
+ * ends with a space, as lower case words each followed by a
+ * space. Returns the new length, at most @len - 1 */
+static size_t library_search_fold(char *s, size_t pos, size_t len,
+      const char *in)
+{
+   const unsigned char *p = (const unsigned char*)in;
+
+   if (!in)
+      return pos;
+
+   for (; *p && pos + 2 < len; p++)
+   {
+      unsigned char c = *p;
+
+      if (c >= 'A' && c <= 'Z')
+         s[pos++] = (char)(c | 0x20);
+      else if (library_search_is_word_char(c))
+         s[pos++] = (char)c;
+      /* "Yoshi's" is searched for as "yoshis" */
+      else if (c == '\'')
+         continue;
+      else if (s[pos - 1] != ' ')
+         s[pos++] = ' ';
+   }
+
+   if (s[pos - 1] != ' ')
+      s[pos++] = ' ';
+   s[pos] = '\0';
+   return pos;
+}
+
+static INLINE uint32_t library_search_key(const char *s)
+{
+   return ((uint32_t)(unsigned char)s[0] << 16)
+        | ((uint32_t)(unsigned char)s[1] << 8)
+        |  (uint32_t)(unsigned char)s[2];
+}
+
+static uint32_t library_search_pool_add(library_search_buf_t *pool,
+      const char *s, size_t len)
+{
+   uint32_t offset = (uint32_t)pool->len;
+   if (     !library_search_buf_append(pool, s, len)
+         || !library_search_buf_append(pool, "", 1))
+      return 0;
+   return offset;
+}
+
+/* Sorts the (key, doc) pairs by key, keeping docs in order for
+ * each key. Keys are 24 bits: two passes of 12 */
+static bool library_search_sort_pairs(uint32_t *keys, uint32_t *docs,
+      size_t count)
+{
+   unsigned pass;
+   uint32_t *counts   = (uint32_t*)malloc(4096 * sizeof(uint32_t));
+   uint32_t *tmp_keys = (uint32_t*)malloc(count * sizeof(uint32_t) + 1);
+   uint32_t *tmp_docs = (uint32_t*)malloc(count * sizeof(uint32_t) + 1);
+   uint32_t *src_keys = keys;
+   uint32_t *src_docs = docs;
+
+   if (!counts || !tmp_keys || !tmp_docs)
+   {
+      free(counts);
+      free(tmp_keys);
+      free(tmp_docs);
+      return false;
+   }
+
+   for (pass = 0; pass < 2; pass++)
+   {
+      size_t i;
+      uint32_t sum      = 0;
+      unsigned shift    = pass * 12;
+      uint32_t *dst_keys = (pass == 0) ? tmp_keys : keys;
+      uint32_t *dst_docs = (pass == 0) ? tmp_docs : docs;
+
+      memset(counts, 0, 4096 * sizeof(uint32_t));
+      for (i = 0; i < count; i++)
+         counts[(src_keys[i] >> shift) & 0xfff]++;
+      for (i = 0; i < 4096; i++)
+      {
+         uint32_t c = counts[i];
+         counts[i]  = sum;
+         sum       += c;
+      }
+      for (i = 0; i < count; i++)
+      {
+         uint32_t pos   = counts[(src_keys[i] >> shift) & 0xfff]++;
+         dst_keys[pos]  = src_keys[i];
+         dst_docs[pos]  = src_docs[i];
+      }
+
+      src_keys = dst_keys;
+      src_docs = dst_docs;
+   }
+
+   free(counts);
+   free(tmp_keys);
+   free(tmp_docs);
+   return true;
+}
+
+static bool library_search_segment_attach(library_search_segment_t *segment,
+      uint8_t *data, size_t size)
+{
+   size_t i, expected;
+   const library_search_header_t *hdr = (const library_search_header_t*)data;
+
+   segment->data = data;
+   segment->size = size;
+
+   if (     size < sizeof(*hdr)
+         || hdr->magic   != LIBRARY_SEARCH_MAGIC
+         || hdr->version != LIBRARY_SEARCH_VERSION)
+      return false;
+
+   expected = sizeof(*hdr)
+      + (size_t)hdr->num_docs     * sizeof(library_search_doc_rec_t)
+      + (size_t)hdr->num_keys     * sizeof(uint32_t)
+      + ((size_t)hdr->num_keys + 1) * sizeof(uint32_t)
+      + (size_t)hdr->num_postings * sizeof(uint32_t)
+      + (size_t)hdr->pool_size;
+
+   if (     expected != size
+         || !hdr->pool_size
+         || hdr->path >= hdr->pool_size)
+      return false;
+
+   segment->hdr      = hdr;
+   segment->docs     = (const library_search_doc_rec_t*)(hdr + 1);
+   segment->keys     = (const uint32_t*)(segment->docs + hdr->num_docs);
+   segment->offsets  = segment->keys + hdr->num_keys;
+   segment->postings = segment->offsets + hdr->num_keys + 1;
+   segment->pool     = (const char*)(segment->postings + hdr->num_postings);
+
+   /* A damaged file must not send a query out of bounds */
+   if (     segment->pool[hdr->pool_size - 1] != '\0'
+         || segment->offsets[hdr->num_keys] != hdr->num_postings)
+      return false;
+   for (i = 0; i < hdr->num_keys; i++)
+      if (segment->offsets[i] > segment->offsets[i + 1])
+         return false;
+   for (i = 0; i < hdr->num_postings; i++)
+      if (segment->postings[i] >= hdr->num_docs)
+         return false;
+   for (i = 0; i < hdr->num_docs; i++)
+   {
+      const library_search_doc_rec_t *doc = &segment->docs[i];
+      if (     doc->label >= hdr->pool_size
+            || doc->text  >= hdr->pool_size
+            || doc->label_len > strlen(segment->pool + doc->text))
+         return false;
+   }
+
+   return true;
+}
+
+/************/
+/* Segments */
+/************/
+
+library_search_segment_t *library_search_segment_new(
+      const char *playlist_path, int64_t stamp, int64_t size,
+      const library_search_doc_t *docs, size_t count)
+{
+   size_t i;
+   library_search_header_t hdr;
+   char text[2048];
+   library_search_buf_t recs      = {0};
+   library_search_buf_t pool      = {0};
+   library_search_buf_t out       = {0};
+   uint32_t *pair_keys            = NULL;
+   uint32_t *pair_docs            = NULL;
+   uint32_t *keys                 = NULL;
+   uint32_t *offsets              = NULL;
+   size_t num_pairs               = 0;
+   size_t cap_pairs               = 0;
+   size_t num_keys                = 0;
+   size_t num_postings            = 0;
+   library_search_segment_t *segment = NULL;
+
+   memset(&hdr, 0, sizeof(hdr));
+
+   /* Offset 0 is the empty string */
+   if (!library_search_buf_append(&pool, "", 1))
+      goto error;
+   hdr.path = library_search_pool_add(&pool, playlist_path,
+         strlen(playlist_path));
+
+   for (i = 0; i < count; i++)
+   {
+      size_t j, _len;
+      library_search_doc_rec_t rec;
+      const library_search_doc_t *doc = &docs[i];
+      uint32_t doc_id                 = (uint32_t)(recs.len / sizeof(rec));
+
+      text[0]       = ' ';
+      _len          = library_search_fold(text, 1, sizeof(text), doc->label);
+      /* Length of " label words", without the space that follows */
+      rec.label_len = (uint32_t)(_len - 1);
+      _len          = library_search_fold(text, _len, sizeof(text), doc->text);
+
+      rec.entry_idx = doc->entry_idx;
+      rec.label     = string_is_empty(doc->label) ? 0
+         : library_search_pool_add(&pool, doc->label, strlen(doc->label));
+      rec.text      = library_search_pool_add(&pool, text, _len);
+      if (!rec.text || !library_search_buf_append(&recs, &rec, sizeof(rec)))
+         goto error;
+
+      if (num_pairs + _len > cap_pairs)
+      {
+         uint32_t *tmp_keys, *tmp_docs;
+         size_t new_cap = MAX(cap_pairs * 2, num_pairs + _len + 1024);
+         if (!(tmp_keys = (uint32_t*)realloc(pair_keys,
+                     new_cap * sizeof(uint32_t))))
+            goto error;
+         pair_keys = tmp_keys;
+         if (!(tmp_docs = (uint32_t*)realloc(pair_docs,
+                     new_cap * sizeof(uint32_t))))
+            goto error;
+         pair_docs = tmp_docs;
+         cap_pairs = new_cap;
+      }
+
+      for (j = 0; j + 3 <= _len; j++)
+      {
+         if (text[j + 1] == ' ')
+            continue;
+         pair_keys[num_pairs]   = library_search_key(text + j);
+         pair_docs[num_pairs++] = doc_id;
+      }
+   }
+
+   hdr.num_docs = (uint32_t)(recs.len / sizeof(library_search_doc_rec_t));
+
+   if (num_pairs && !library_search_sort_pairs(pair_keys, pair_docs,
+            num_pairs))
+      goto error;
+
+   /* Compact into distinct keys, each with its distinct docs. The
+    * postings are written over the pairs, which are read ahead */
+   keys    = (uint32_t*)malloc((num_pairs + 1) * sizeof(uint32_t));
+   offsets = (uint32_t*)malloc((num_pairs + 1) * sizeof(uint32_t));
+   if (!keys || !offsets)
+      goto error;
+
+   for (i = 0; i < num_pairs; i++)
+   {
+      if (!num_keys || keys[num_keys - 1] != pair_keys[i])
+      {
+         keys[num_keys]    = pair_keys[i];
+         offsets[num_keys] = (uint32_t)num_postings;
+         num_keys++;
+      }
+      else if (pair_docs[num_postings - 1] == pair_docs[i])
+         continue;
+      pair_docs[num_postings++] = pair_docs[i];
+   }
+   offsets[num_keys] = (uint32_t)num_postings;
+
+   hdr.magic        = LIBRARY_SEARCH_MAGIC;
+   hdr.version      = LIBRARY_SEARCH_VERSION;
+   hdr.stamp        = stamp;
+   hdr.size         = size;
+   hdr.num_keys     = (uint32_t)num_keys;
+   hdr.num_postings = (uint32_t)num_postings;
+
+   hdr.pool_size    = (uint32_t)pool.len;
+
+   if (     !library_search_buf_append(&out, &hdr, sizeof(hdr))
+         || !library_search_buf_append(&out, recs.data, recs.len)
+         || !library_search_buf_append(&out, keys,
+            num_keys * sizeof(uint32_t))
+         || !library_search_buf_append(&out, offsets,
+            (num_keys + 1) * sizeof(uint32_t))
+         || !library_search_buf_append(&out, pair_docs,
+            num_postings * sizeof(uint32_t))
+         || !library_search_buf_append(&out, pool.data, pool.len))
+      goto error;
+
+   if (!(segment = (library_search_segment_t*)calloc(1, sizeof(*segment))))
+      goto error;
+   if (!library_search_segment_attach(segment, out.data, out.len))
+   {
+      free(segment);
+      segment = NULL;
+      goto error;
+   }
+   segment->refs = 1;
+   out.data      = NULL;
+
+error:
+   free(out.data);
+   free(recs.data);
+   free(pool.data);
+   free(pair_keys);
+   free(pair_docs);
+   free(keys);
+   free(offsets);
+   return segment;
+}
+
+void library_search_segment_free(library_search_segment_t *segment)
+{
+   if (!segment || --segment->refs)
+      return;
+   free(segment->data);
+   free(segment);
+}
+
+bool library_search_segment_is_current(
+      const library_search_segment_t *segment,
+      int64_t stamp, int64_t size)
+{
+   return segment
+      && segment->hdr->stamp == stamp
+      && segment->hdr->size  == size;
+}
+
+/*********/
+/* Index */
+/*********/
+
+library_search_t *library_search_new(void)
+{
+   return (library_search_t*)calloc(1, sizeof(library_search_t));
+}
+
+void library_search_free(library_search_t *index)
+{
+   size_t i;
+   if (!index)
+      return;
+   for (i = 0; i < RBUF_LEN(index->segments); i++)
+      library_search_segment_free(index->segments[i]);
+   RBUF_FREE(index->segments);
+   free(index->hits);
+   free(index->touched);
+   free(index);
+}
+
+bool library_search_add(library_search_t *index,
+      library_search_segment_t *segment)
+{
+   if (!index || !segment)
+      return false;
+   if (!RBUF_TRYFIT(index->segments, RBUF_LEN(index->segments) + 1))
+      return false;
+   segment->refs++;
+   RBUF_PUSH(index->segments, segment);
+   return true;
+}
+
+library_search_segment_t *library_search_find(
+      const library_search_t *index, const char *playlist_path)
+{
+   size_t i;
+   if (!index)
+      return NULL;
+   for (i = 0; i < RBUF_LEN(index->segments); i++)
+   {
+      library_search_segment_t *segment = index->segments[i];
+      if (string_is_equal(segment->pool + segment->hdr->path, playlist_path))
+         return segment;
+   }
+   return NULL;
+}
+
+size_t library_search_size(const library_search_t *index)
+{
+   size_t i;
+   size_t count = 0;
+   if (!index)
+      return 0;
+   for (i = 0; i < RBUF_LEN(index->segments); i++)
+      count += index->segments[i]->hdr->num_docs;
+   return count;
+}
+
+size_t library_search_num_segments(const library_search_t *index)
+{
+   return index ? RBUF_LEN(index->segments) : 0;
+}
+
+/* Index file: magic, version, segment count, reserved (u32 each),
+ * then for each segment its size (u64) and blob */
+library_search_t *library_search_load(const char *path)
+{
+   uint32_t i, count;
+   const uint8_t *in;
+   size_t pos;
+   void *buf               = NULL;
+   int64_t len             = 0;
+   library_search_t *index = NULL;
+
+   if (     !path_is_valid(path)
+         || !filestream_read_file(path, &buf, &len)
+         || len < 16)
+      goto error;
+
+   in    = (const uint8_t*)buf;
+   count = ((const uint32_t*)in)[2];
+   if (     ((const uint32_t*)in)[0] != LIBRARY_SEARCH_MAGIC
+         || ((const uint32_t*)in)[1] != LIBRARY_SEARCH_VERSION
+         || !(index = library_search_new()))
+      goto error;
+
+   for (i = 0, pos = 16; i < count; i++)
+   {
+      uint64_t size;
+      uint8_t *data;
+      library_search_segment_t *segment;
+
+      if ((uint64_t)len - pos < 8)
+         goto error;
+      memcpy(&size, in + pos, sizeof(size));
+      pos += 8;
+      if (size > (uint64_t)len - pos)
+         goto error;
+
+      if (!(data = (uint8_t*)malloc((size_t)size)))
+         goto error;
+      memcpy(data, in + pos, (size_t)size);
+      pos += (size_t)size;
+
+      if (!(segment = (library_search_segment_t*)calloc(1, sizeof(*segment))))
+      {
+         free(data);
+         goto error;
+      }
+      if (!library_search_segment_attach(segment, data, (size_t)size))
+      {
+         free(data);
+         free(segment);
+         goto error;
+      }
+      segment->refs = 1;
+      library_search_add(index, segment);
+      library_search_segment_free(segment);
+   }
+
+   free(buf);
+   return index;
+
+error:
+   free(buf);
+   library_search_free(index);
+   return NULL;
+}
+
+bool library_search_save(const library_search_t *index, const char *path)
+{
+   size_t i, _len;
+   uint32_t head[4];
+   RFILE *file  = NULL;
+   bool ret     = true;
+   char tmp[PATH_MAX_LENGTH];
+
+   if (!index)
+      return false;
+
+   _len = strlcpy(tmp, path, sizeof(tmp));
+   strlcpy(tmp + _len, ".tmp", sizeof(tmp) - _len);
+
+   if (!(file = filestream_open(tmp, RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   head[0] = LIBRARY_SEARCH_MAGIC;
+   head[1] = LIBRARY_SEARCH_VERSION;
+   head[2] = (uint32_t)RBUF_LEN(index->segments);
+   head[3] = 0;
+   if (filestream_write(file, head, sizeof(head)) != sizeof(head))
+      ret = false;
+
+   for (i = 0; ret && i < RBUF_LEN(index->segments); i++)
+   {
+      const library_search_segment_t *segment = index->segments[i];
+      uint64_t size = segment->size;
+      if (     filestream_write(file, &size, sizeof(size)) != sizeof(size)
+            || filestream_write(file, segment->data, (int64_t)size)
+               != (int64_t)size)
+         ret = false;
+   }
+
+   if (filestream_close(file) != 0)
+      ret = false;
+
+   /* Never leave a torn index behind */
+   if (ret)
+   {
+      filestream_delete(path);
+      ret = (filestream_rename(tmp, path) == 0);
+   }
+   if (!ret)
+      filestream_delete(tmp);
+   return ret;
+}
+
+/***********/
+/* Queries */
+/***********/
+
+static int library_search_cmp_u32(const void *a, const void *b)
+{
+   uint32_t x = *(const uint32_t*)a;
+   uint32_t y = *(const uint32_t*)b;
+   return (x > y) - (x < y);
+}
+
+static int library_search_cmp_results(const void *a, const void *b)
+{
+   const library_search_result_t *x = (const library_search_result_t*)a;
+   const library_search_result_t *y = (const library_search_result_t*)b;
+   if (x->score != y->score)
+      return (x->score < y->score) ? 1 : -1;
+   return strcasecmp(x->label, y->label);
+}
+
+/* Results are kept as a min-heap on score until the end, so the
+ * worst one is at the top when a better one comes along */
+static void library_search_heap_sift(library_search_result_t *heap,
+      size_t count, size_t i)
+{
+   for (;;)
+   {
+      library_search_result_t tmp;
+      size_t min   = i;
+      size_t left  = 2 * i + 1;
+      size_t right = left + 1;
+      if (left < count && heap[left].score < heap[min].score)
+         min = left;
+      if (right < count && heap[right].score < heap[min].score)
+         min = right;
+      if (min == i)
+         return;
+      tmp       = heap[i];
+      heap[i]   = heap[min];
+      heap[min] = tmp;
+      i         = min;
+   }
+}
+
+static void library_search_heap_push(library_search_result_t *heap,
+      size_t *count, size_t max, const library_search_result_t *result)
+{
+   size_t i;
+
+   if (*count == max)
+   {
+      if (result->score <= heap[0].score)
+         return;
+      heap[0] = *result;
+      library_search_heap_sift(heap, *count, 0);
+      return;
+   }
+
+   for (i = (*count)++; i > 0; )
+   {
+      size_t parent = (i - 1) / 2;
+      if (heap[parent].score <= result->score)
+         break;
+      heap[i] = heap[parent];
+      i       = parent;
+   }
+   heap[i] = *result;
+}
+
+static bool library_search_reserve_scratch(library_search_t *index,
+      size_t num_docs)
+{
+   uint8_t *hits;
+   uint32_t *touched;
+
+   if (num_docs <= index->scratch_size)
+      return true;
+   if (!(hits = (uint8_t*)realloc(index->hits, num_docs)))
+      return false;
+   index->hits = hits;
+   if (!(touched = (uint32_t*)realloc(index->touched,
+               num_docs * sizeof(uint32_t))))
+      return false;
+   index->touched      = touched;
+   /* Hit counts are only ever reset for the docs touched */
+   memset(index->hits, 0, num_docs);
+   index->scratch_size = num_docs;
+   return true;
+}
+
+static size_t library_search_lower_bound(const uint32_t *keys,
+      size_t count, uint32_t key)
+{
+   size_t lo = 0;
+   size_t hi = count;
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      if (keys[mid] < key)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+size_t library_search_query(library_search_t *index, const char *query,
+      library_search_result_t *results, size_t max_results)
+{
+   size_t i, _len, seg;
+   unsigned allowed_typos;
+   char q[LIBRARY_SEARCH_QUERY_MAX];
+   uint32_t keys[LIBRARY_SEARCH_QUERY_MAX];
+   size_t num_keys   = 0;
+   size_t letters    = 0;
+   size_t count      = 0;
+   size_t min_hits, q_word_len;
+
+   if (!index || string_is_empty(query) || !max_results)
+      return 0;
+
+   /* The last word is still being typed, unless something other
+    * than a letter follows it: don't require it to end there */
+   q[0] = ' ';
+   _len = library_search_fold(q, 1, sizeof(q), query);
+   if (     _len > 1
+         && (     library_search_is_word_char(
+                  (unsigned char)query[strlen(query) - 1])
+               || query[strlen(query) - 1] == '\''))
+      q[--_len] = '\0';
+
+   for (i = 0; i < _len; i++)
+      if (q[i] != ' ')
+         letters++;
+   if (letters < 2)
+      return 0;
+
+   for (i = 0; i + 3 <= _len; i++)
+      if (q[i + 1] != ' ')
+         keys[num_keys++] = library_search_key(q + i);
+   if (!num_keys)
+      return 0;
+
+   qsort(keys, num_keys, sizeof(uint32_t), library_search_cmp_u32);
+   for (i = 1, _len = 1; i < num_keys; i++)
+      if (keys[i] != keys[_len - 1])
+         keys[_len++] = keys[i];
+   num_keys = _len;
+   _len     = strlen(q);
+   /* A trailing space only says where the word ends */
+   q_word_len = (q[_len - 1] == ' ') ? _len - 1 : _len;
+
+   /* A mistyped letter breaks up to three trigrams. Short queries
+    * must match in full, and at least half of any query must */
+   allowed_typos = (letters >= 9) ? 2 : (letters >= 5) ? 1 : 0;
+   min_hits      = (num_keys > allowed_typos * 3)
+      ? num_keys - allowed_typos * 3 : 1;
+   if (min_hits < (num_keys + 1) / 2)
+      min_hits   = (num_keys + 1) / 2;
+
+   for (seg = 0; seg < RBUF_LEN(index->segments); seg++)
+   {
+      size_t k, num_touched;
+      const library_search_segment_t *segment = index->segments[seg];
+      const library_search_header_t *hdr      = segment->hdr;
+      uint8_t *hits                           = NULL;
+
+      if (!library_search_reserve_scratch(index, hdr->num_docs))
+         break;
+      hits        = index->hits;
+      num_touched = 0;
+
+      for (k = 0; k < num_keys; k++)
+      {
+         const uint32_t *post, *end;
+         size_t key_idx = library_search_lower_bound(segment->keys,
+               hdr->num_keys, keys[k]);
+         if (key_idx == hdr->num_keys || segment->keys[key_idx] != keys[k])
+            continue;
+         post = segment->postings + segment->offsets[key_idx];
+         end  = segment->postings + segment->offsets[key_idx + 1];
+         for (; post < end; post++)
+            if (!hits[*post]++)
+               index->touched[num_touched++] = *post;
+      }
+
+      for (k = 0; k < num_touched; k++)
+      {
+         library_search_result_t result;
+         const library_search_doc_rec_t *doc;
+         const char *text, *pos;
+         uint32_t doc_id   = index->touched[k];
+         uint32_t doc_hits = hits[doc_id];
+         unsigned bonus    = 0;
+
+         hits[doc_id]      = 0;
+         if (doc_hits < min_hits)
+            continue;
+
+         doc  = &segment->docs[doc_id];
+         text = segment->pool + doc->text;
+
+         /* Query as typed, at the start of a word: at the start
+          * of the label, elsewhere in it, or in the other text */
+         if ((pos = strstr(text, q)))
+         {
+            if (pos == text)
+               bonus = 3;
+            else if ((size_t)(pos - text) + q_word_len <= doc->label_len)
+               bonus = 2;
+            else
+               bonus = 1;
+         }
+
+         /* Then by how many trigrams match, then shorter labels */
+         result.score         = (bonus << 17)
+            + ((doc_hits * 1024 / (uint32_t)num_keys) << 6)
+            + (255 - MIN(doc->label_len, 255));
+         result.playlist_path = segment->pool + hdr->path;
+         result.label         = segment->pool + doc->label;
+         result.entry_idx     = doc->entry_idx;
+         library_search_heap_push(results, &count, max_results, &result);
+      }
+   }
+
+   qsort(results, count, sizeof(*results), library_search_cmp_results);
+   return count;
+}
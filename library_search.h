@@ -0,0 +1,147 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBRARY_SEARCH_H
+#define __LIBRARY_SEARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Trigram index over the entries of every playlist.
+ *
+ * Each playlist gets a segment: the text of its entries, folded to
+ * lower case words, and for each trigram of that text the entries it
+ * appears in. A query is folded the same way; entries sharing enough
+ * of its trigrams are candidates, so a mistyped letter still finds
+ * longer words. Candidates are ranked by how much of the query they
+ * contain, whether they contain it as typed and where.
+ *
+ * Segments are immutable once built. Updating the index after a
+ * playlist changed only rebuilds the segment of that playlist; the
+ * others are shared with the previous index. The whole index is
+ * saved to a single file and loaded back on the next run, keeping
+ * the segments whose playlist file did not change. */
+
+/* Maximum number of results a query returns */
+#define LIBRARY_SEARCH_MAX_RESULTS 256
+
+typedef struct library_search library_search_t;
+typedef struct library_search_segment library_search_segment_t;
+
+/* An entry to index */
+typedef struct library_search_doc
+{
+   /* Shown in results and ranked on */
+   const char *label;
+   /* Further text to match, such as the file name, core
+    * and database metadata. May be NULL */
+   const char *text;
+   uint32_t entry_idx;
+} library_search_doc_t;
+
+typedef struct library_search_result
+{
+   const char *playlist_path;
+   const char *label;
+   uint32_t entry_idx;
+   uint32_t score;
+} library_search_result_t;
+
+/**
+ * library_search_segment_new:
+ * @playlist_path : Playlist the entries come from.
+ * @stamp, @size  : File state of @playlist_path, see
+ *                  path_get_stamp().
+ * @docs          : Entries.
+ * @count         : Number of @docs.
+ *
+ * Returns: segment with a single reference, or NULL.
+ **/
+library_search_segment_t *library_search_segment_new(
+      const char *playlist_path, int64_t stamp, int64_t size,
+      const library_search_doc_t *docs, size_t count);
+
+/* Drops a reference to @segment */
+void library_search_segment_free(library_search_segment_t *segment);
+
+/**
+ * library_search_segment_is_current:
+ *
+ * Returns: true if @segment was built from the playlist file
+ * as it is now.
+ **/
+bool library_search_segment_is_current(
+      const library_search_segment_t *segment,
+      int64_t stamp, int64_t size);
+
+library_search_t *library_search_new(void);
+
+void library_search_free(library_search_t *index);
+
+/**
+ * library_search_add:
+ *
+ * Adds @segment to @index, taking a new reference to it.
+ **/
+bool library_search_add(library_search_t *index,
+      library_search_segment_t *segment);
+
+/**
+ * library_search_find:
+ *
+ * Returns: segment of @index built from @playlist_path, or NULL.
+ **/
+library_search_segment_t *library_search_find(
+      const library_search_t *index, const char *playlist_path);
+
+/* Returns: number of entries in @index */
+size_t library_search_size(const library_search_t *index);
+
+/* Returns: number of segments in @index */
+size_t library_search_num_segments(const library_search_t *index);
+
+/**
+ * library_search_load:
+ * @path        : Index file written by library_search_save().
+ *
+ * Returns: index, or NULL if @path is missing or damaged.
+ **/
+library_search_t *library_search_load(const char *path);
+
+bool library_search_save(const library_search_t *index, const char *path);
+
+/**
+ * library_search_query:
+ * @index       : Index.
+ * @query       : Text as typed.
+ * @results     : Filled with up to @max_results results, best first.
+ *                Strings stay valid as long as @index.
+ * @max_results : Size of @results.
+ *
+ * Queries of less than two letters match nothing. Not thread safe:
+ * the scratch space lives in @index.
+ *
+ * Returns: number of results.
+ **/
+size_t library_search_query(library_search_t *index, const char *query,
+      library_search_result_t *results, size_t max_results);
+
+RETRO_END_DECLS
+
+#endif
@@ -33,11 +33,22 @@
 #endif
 
 #include <retro_miscellaneous.h>
+#include <features/features_cpu.h>
 #include <audio/audio_mix.h>
 #include <streams/file_stream.h>
+#include <audio/conversion/conversion_simd.h>
 #include <audio/conversion/float_to_s16.h>
 #include <audio/conversion/s16_to_float.h>
 
+#if defined(CONVERSION_SIMD_NEON) && !defined(HAVE_ARM_NEON_ASM_OPTIMIZATIONS)
+#include <arm_neon.h>
+#define AUDIO_MIX_NEON 1
+#endif
+
+typedef void (*audio_mix_volume_t)(float *s,
+      const float *in, float vol, size_t len);
+typedef void (*audio_mix_clamp_t)(float *s, size_t len);
+
 void audio_mix_volume_C(float *s, const float *in, float vol, size_t len)
 {
    size_t i;
@@ -48,35 +59,194 @@ void audio_mix_volume_C(float *s, const float *in, float vol, size_t len)
 #ifdef __SSE2__
 void audio_mix_volume_SSE2(float *s, const float *in, float vol, size_t len)
 {
-   size_t i, remaining_samples;
+   size_t i;
    __m128 volume = _mm_set1_ps(vol);
 
-   for (i = 0; i + 16 <= len; i += 16, s += 16, in += 16)
+   for (i = 0; i + 16 <= len; i += 16)
    {
       unsigned j;
       __m128 input[4];
       __m128 additive[4];
 
-      input[0]    = _mm_loadu_ps(s +  0);
-      input[1]    = _mm_loadu_ps(s +  4);
-      input[2]    = _mm_loadu_ps(s +  8);
-      input[3]    = _mm_loadu_ps(s + 12);
+      input[0]    = _mm_loadu_ps(s + i +  0);
+      input[1]    = _mm_loadu_ps(s + i +  4);
+      input[2]    = _mm_loadu_ps(s + i +  8);
+      input[3]    = _mm_loadu_ps(s + i + 12);
 
-      additive[0] = _mm_mul_ps(volume, _mm_loadu_ps(in +  0));
-      additive[1] = _mm_mul_ps(volume, _mm_loadu_ps(in +  4));
-      additive[2] = _mm_mul_ps(volume, _mm_loadu_ps(in +  8));
-      additive[3] = _mm_mul_ps(volume, _mm_loadu_ps(in + 12));
+      additive[0] = _mm_mul_ps(volume, _mm_loadu_ps(in + i +  0));
+      additive[1] = _mm_mul_ps(volume, _mm_loadu_ps(in + i +  4));
+      additive[2] = _mm_mul_ps(volume, _mm_loadu_ps(in + i +  8));
+      additive[3] = _mm_mul_ps(volume, _mm_loadu_ps(in + i + 12));
 
       for (j = 0; j < 4; j++)
-         _mm_storeu_ps(s + 4 * j, _mm_add_ps(input[j], additive[j]));
+         _mm_storeu_ps(s + i + 4 * j, _mm_add_ps(input[j], additive[j]));
    }
 
-   remaining_samples = len - i;
+   audio_mix_volume_C(s + i, in + i, vol, len - i);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void audio_mix_volume_AVX2(float *s,
+      const float *in, float vol, size_t len)
+{
+   size_t i;
+   __m256 volume = _mm256_set1_ps(vol);
 
-   for (i = 0; i < remaining_samples; i++)
-      s[i] += in[i] * vol;
+   /* Multiply and add separately, a fused multiply-add
+    * would round differently */
+   for (i = 0; i + 16 <= len; i += 16)
+   {
+      __m256 additive_a = _mm256_mul_ps(volume, _mm256_loadu_ps(in + i + 0));
+      __m256 additive_b = _mm256_mul_ps(volume, _mm256_loadu_ps(in + i + 8));
+
+      _mm256_storeu_ps(s + i + 0,
+            _mm256_add_ps(_mm256_loadu_ps(s + i + 0), additive_a));
+      _mm256_storeu_ps(s + i + 8,
+            _mm256_add_ps(_mm256_loadu_ps(s + i + 8), additive_b));
+   }
+
+   audio_mix_volume_C(s + i, in + i, vol, len - i);
+}
+#endif
+
+#ifdef AUDIO_MIX_NEON
+static void audio_mix_volume_NEON(float *s,
+      const float *in, float vol, size_t len)
+{
+   size_t i;
+   float32x4_t volume = vdupq_n_f32(vol);
+
+   for (i = 0; i + 8 <= len; i += 8)
+   {
+      float32x4_t additive_a = vmulq_f32(volume, vld1q_f32(in + i + 0));
+      float32x4_t additive_b = vmulq_f32(volume, vld1q_f32(in + i + 4));
+
+      vst1q_f32(s + i + 0, vaddq_f32(vld1q_f32(s + i + 0), additive_a));
+      vst1q_f32(s + i + 4, vaddq_f32(vld1q_f32(s + i + 4), additive_b));
+   }
+
+   audio_mix_volume_C(s + i, in + i, vol, len - i);
+}
+#endif
+
+/* Reference for all other implementations. NaN is kept. */
+static void audio_mix_clamp_C(float *s, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      if (s[i] < -1.0f)
+         s[i] = -1.0f;
+      else if (s[i] > 1.0f)
+         s[i] = 1.0f;
+   }
+}
+
+#ifdef __SSE2__
+static void audio_mix_clamp_SSE2(float *s, size_t len)
+{
+   size_t i;
+   __m128 one       = _mm_set1_ps(1.0f);
+   __m128 minus_one = _mm_set1_ps(-1.0f);
+
+   /* min/max return their second operand for NaN */
+   for (i = 0; i + 8 <= len; i += 8)
+   {
+      _mm_storeu_ps(s + i + 0, _mm_max_ps(minus_one,
+               _mm_min_ps(one, _mm_loadu_ps(s + i + 0))));
+      _mm_storeu_ps(s + i + 4, _mm_max_ps(minus_one,
+               _mm_min_ps(one, _mm_loadu_ps(s + i + 4))));
+   }
+
+   audio_mix_clamp_C(s + i, len - i);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void audio_mix_clamp_AVX2(float *s, size_t len)
+{
+   size_t i;
+   __m256 one       = _mm256_set1_ps(1.0f);
+   __m256 minus_one = _mm256_set1_ps(-1.0f);
+
+   for (i = 0; i + 16 <= len; i += 16)
+   {
+      _mm256_storeu_ps(s + i + 0, _mm256_max_ps(minus_one,
+               _mm256_min_ps(one, _mm256_loadu_ps(s + i + 0))));
+      _mm256_storeu_ps(s + i + 8, _mm256_max_ps(minus_one,
+               _mm256_min_ps(one, _mm256_loadu_ps(s + i + 8))));
+   }
+
+   audio_mix_clamp_C(s + i, len - i);
+}
+#endif
+
+#ifdef AUDIO_MIX_NEON
+static void audio_mix_clamp_NEON(float *s, size_t len)
+{
+   size_t i;
+   float32x4_t one       = vdupq_n_f32(1.0f);
+   float32x4_t minus_one = vdupq_n_f32(-1.0f);
+
+   /* min/max propagate NaN */
+   for (i = 0; i + 8 <= len; i += 8)
+   {
+      vst1q_f32(s + i + 0, vmaxq_f32(minus_one,
+               vminq_f32(one, vld1q_f32(s + i + 0))));
+      vst1q_f32(s + i + 4, vmaxq_f32(minus_one,
+               vminq_f32(one, vld1q_f32(s + i + 4))));
+   }
+
+   audio_mix_clamp_C(s + i, len - i);
+}
+#endif
+
+#if defined(__SSE2__)
+static audio_mix_volume_t audio_mix_volume_cb = audio_mix_volume_SSE2;
+static audio_mix_clamp_t  audio_mix_clamp_cb  = audio_mix_clamp_SSE2;
+#else
+static audio_mix_volume_t audio_mix_volume_cb = audio_mix_volume_C;
+static audio_mix_clamp_t  audio_mix_clamp_cb  = audio_mix_clamp_C;
+#endif
+
+void audio_mix_volume(float *s, const float *in, float vol, size_t len)
+{
+   audio_mix_volume_cb(s, in, vol, len);
 }
+
+void audio_mix_clamp(float *s, size_t len)
+{
+   audio_mix_clamp_cb(s, len);
+}
+
+void audio_mix_init_simd(void)
+{
+   uint64_t cpu = cpu_features_get();
+
+#if defined(__SSE2__)
+   audio_mix_volume_cb = audio_mix_volume_SSE2;
+   audio_mix_clamp_cb  = audio_mix_clamp_SSE2;
+#else
+   audio_mix_volume_cb = audio_mix_volume_C;
+   audio_mix_clamp_cb  = audio_mix_clamp_C;
+#endif
+#ifdef CONVERSION_SIMD_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+   {
+      audio_mix_volume_cb = audio_mix_volume_AVX2;
+      audio_mix_clamp_cb  = audio_mix_clamp_AVX2;
+   }
 #endif
+#ifdef AUDIO_MIX_NEON
+   if (cpu & RETRO_SIMD_NEON)
+   {
+      audio_mix_volume_cb = audio_mix_volume_NEON;
+      audio_mix_clamp_cb  = audio_mix_clamp_NEON;
+   }
+#endif
+   (void)cpu;
+}
 
 void audio_mix_free_chunk(audio_chunk_t *chunk)
 {
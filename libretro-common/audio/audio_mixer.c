@@ -24,6 +24,7 @@
 #include "../../config.h"
 #endif
 
+#include <audio/audio_mix.h>
 #include <audio/audio_mixer.h>
 #include <audio/audio_resampler.h>
 
@@ -997,7 +998,6 @@ static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
    unsigned buf_free                = (unsigned)(num_frames * 2);
    const audio_mixer_sound_t* sound = voice->sound;
    unsigned pcm_available           = sound->types.wav.frames
@@ -1008,8 +1008,8 @@ static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
 again:
    if (pcm_available < buf_free)
    {
-      for (i = pcm_available; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mix_volume(buffer, pcm, volume, pcm_available);
+      buffer += pcm_available;
 
       if (voice->repeat)
       {
@@ -1030,8 +1030,7 @@ again:
    }
    else
    {
-      for (i = buf_free; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mix_volume(buffer, pcm, volume, buf_free);
 
       voice->types.wav.position += buf_free;
    }
@@ -1042,7 +1041,6 @@ static void audio_mixer_mix_ogg(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
    float* temp_buffer = NULL;
    unsigned buf_free                = (unsigned)(num_frames * 2);
    unsigned temp_samples            = 0;
@@ -1103,15 +1101,14 @@ again:
 
    if (voice->types.ogg.samples < buf_free)
    {
-      for (i = voice->types.ogg.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mix_volume(buffer, pcm, volume, voice->types.ogg.samples);
+      buffer += voice->types.ogg.samples;
 
       buf_free -= voice->types.ogg.samples;
       goto again;
    }
 
-   for (i = buf_free; i != 0; --i )
-      *buffer++ += *pcm++ * volume;
+   audio_mix_volume(buffer, pcm, volume, buf_free);
 
    voice->types.ogg.position += buf_free;
    voice->types.ogg.samples  -= buf_free;
@@ -1192,7 +1189,6 @@ static void audio_mixer_mix_flac(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
    struct resampler_data info;
    float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
    unsigned buf_free                = (unsigned)(num_frames * 2);
@@ -1240,15 +1236,14 @@ again:
 
    if (voice->types.flac.samples < buf_free)
    {
-      for (i = voice->types.flac.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mix_volume(buffer, pcm, volume, voice->types.flac.samples);
+      buffer += voice->types.flac.samples;
 
       buf_free -= voice->types.flac.samples;
       goto again;
    }
 
-   for (i = buf_free; i != 0; --i )
-      *buffer++ += *pcm++ * volume;
+   audio_mix_volume(buffer, pcm, volume, buf_free);
 
    voice->types.flac.position += buf_free;
    voice->types.flac.samples  -= buf_free;
@@ -1260,7 +1255,6 @@ static void audio_mixer_mix_mp3(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
    struct resampler_data info;
    float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
    unsigned buf_free                = (unsigned)(num_frames * 2);
@@ -1312,15 +1306,14 @@ again:
 
    if (voice->types.mp3.samples < buf_free)
    {
-      for (i = voice->types.mp3.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mix_volume(buffer, pcm, volume, voice->types.mp3.samples);
+      buffer += voice->types.mp3.samples;
 
       buf_free -= voice->types.mp3.samples;
       goto again;
    }
 
-   for (i = buf_free; i != 0; --i )
-      *buffer++ += *pcm++ * volume;
+   audio_mix_volume(buffer, pcm, volume, buf_free);
 
    voice->types.mp3.position += buf_free;
    voice->types.mp3.samples  -= buf_free;
@@ -1331,8 +1324,6 @@ void audio_mixer_mix(float* buffer, size_t num_frames,
       float volume_override, bool override)
 {
    unsigned i;
-   size_t j                   = 0;
-   float* sample              = NULL;
    audio_mixer_voice_t* voice = s_voices;
 
    for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++, voice++)
@@ -1375,13 +1366,7 @@ void audio_mixer_mix(float* buffer, size_t num_frames,
       AUDIO_MIXER_UNLOCK(voice);
    }
 
-   for (j = 0, sample = buffer; j < num_frames * 2; j++, sample++)
-   {
-      if (*sample < -1.0f)
-         *sample = -1.0f;
-      else if (*sample > 1.0f)
-         *sample = 1.0f;
-   }
+   audio_mix_clamp(buffer, num_frames * 2);
 }
 
 float audio_mixer_voice_get_volume(audio_mixer_voice_t *voice)
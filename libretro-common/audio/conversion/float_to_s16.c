@@ -28,113 +28,43 @@
 #include <altivec.h>
 #endif
 
+#include <boolean.h>
 #include <features/features_cpu.h>
+#include <audio/conversion/conversion_simd.h>
 #include <audio/conversion/float_to_s16.h>
 
-#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
-static bool float_to_s16_neon_enabled = false;
+#ifdef CONVERSION_SIMD_NEON
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
 void convert_float_s16_asm(int16_t *s, const float *in, size_t len);
 #else
 #include <arm_neon.h>
 #endif
-
-void convert_float_to_s16(int16_t *s, const float *in, size_t len)
-{
-   size_t i           = 0;
-   if (float_to_s16_neon_enabled)
-   {
-      float        gf = (1<<15);
-      float32x4_t vgf = {gf, gf, gf, gf};
-      while (len >= 8)
-      {
-#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
-         size_t aligned_samples = len & ~7;
-         if (aligned_samples)
-            convert_float_s16_asm(s, in, aligned_samples);
-
-         s        += aligned_samples;
-         in       += aligned_samples;
-         samples  -= aligned_samples;
-         i         = 0;
-#else
-         int16x4x2_t oreg;
-         int32x4x2_t creg;
-         float32x4x2_t inreg = vld2q_f32(in);
-         creg.val[0]         = vcvtq_s32_f32(vmulq_f32(inreg.val[0], vgf));
-         creg.val[1]         = vcvtq_s32_f32(vmulq_f32(inreg.val[1], vgf));
-         oreg.val[0]         = vqmovn_s32(creg.val[0]);
-         oreg.val[1]         = vqmovn_s32(creg.val[1]);
-         vst2_s16(s, oreg);
-         in      += 8;
-         s       += 8;
-         len     -= 8;
 #endif
-      }
-   }
-
-   for (; i < len; i++)
-   {
-      int32_t val = (int32_t)(in[i] * 0x8000);
-      s[i]        = (val > 0x7FFF) ? 0x7FFF :
-         (val < -0x8000 ? -0x8000 : (int16_t)val);
-   }
-}
 
-void convert_float_to_s16_init_simd(void)
-{
-   uint64_t cpu = cpu_features_get();
+typedef void (*convert_float_to_s16_t)(int16_t *s,
+      const float *in, size_t len);
 
-   if (cpu & RETRO_SIMD_NEON)
-      float_to_s16_neon_enabled = true;
-}
-#else
-void convert_float_to_s16(int16_t *s, const float *in, size_t len)
+/* Reference for all other implementations: scales by 32768,
+ * truncates towards zero and saturates, with NaN giving 0,
+ * like the NEON conversion instructions */
+static void convert_float_to_s16_C(int16_t *s, const float *in, size_t len)
 {
    size_t i          = 0;
-#if defined(__SSE2__)
-   __m128 factor     = _mm_set1_ps((float)0x8000);
-   /* Initialize a 4D vector with 32768.0 for its elements */
-
-   for (i = 0; i + 8 <= len; i += 8, in += 8, s += 8)
-   { /* Skip forward 8 samples at a time... */
-      __m128 input_a = _mm_loadu_ps(in + 0); /* Create a 4-float vector from the next four samples... */
-      __m128 input_b = _mm_loadu_ps(in + 4); /* ...and another from the *next* next four. */
-      __m128 res_a   = _mm_mul_ps(input_a, factor);
-      __m128 res_b   = _mm_mul_ps(input_b, factor); /* Multiply these samples by 32768 */
-      __m128i ints_a = _mm_cvtps_epi32(res_a);
-      __m128i ints_b = _mm_cvtps_epi32(res_b); /* Convert the samples to 32-bit integers */
-      __m128i packed = _mm_packs_epi32(ints_a, ints_b); /* Then convert them to 16-bit ints, clamping to [-32768, 32767] */
-
-      _mm_storeu_si128((__m128i *)s, packed); /* Then put the result in the output array */
-   }
-
-   len               = len - i;
-   i                 = 0;
-   /* If there are any stray samples at the end, we need to convert them
-    * (maybe the original array didn't contain a multiple of 8 samples) */
-#elif defined(__ALTIVEC__)
-   int samples_in    = len;
 
+#if defined(__ALTIVEC__)
    /* Unaligned loads/store is a bit expensive,
     * so we optimize for the good path (very likely). */
    if (((uintptr_t)s & 15) + ((uintptr_t)in & 15) == 0)
    {
-      size_t i;
-      for (i = 0; i + 8 <= len; i += 8, in += 8, s += 8)
+      for (i = 0; i + 8 <= len; i += 8)
       {
-         vector float       input0 = vec_ld( 0, in);
-         vector float       input1 = vec_ld(16, in);
+         vector float       input0 = vec_ld( 0, in + i);
+         vector float       input1 = vec_ld(16, in + i);
          vector signed int result0 = vec_cts(input0, 15);
          vector signed int result1 = vec_cts(input1, 15);
-         vec_st(vec_packs(result0, result1), 0, s);
+         vec_st(vec_packs(result0, result1), 0, s + i);
       }
-
-      samples_in    -= i;
    }
-
-   len               = samples_in;
-   i                 = 0;
 #elif defined(_MIPS_ARCH_ALLEGREX)
 #ifdef DEBUG
    /* Make sure the buffers are 16 byte aligned, this should be
@@ -169,12 +99,123 @@ void convert_float_to_s16(int16_t *s, const float *in, size_t len)
     * but it's also a fallback in case no SIMD instructions are available. */
    for (; i < len; i++)
    {
-      int32_t val    = (int32_t)(in[i] * 0x8000);
-      s[i]           = (val > 0x7FFF)
+      float val      = in[i] * 0x8000;
+      s[i]           = (val >= 32767.0f)
          ? 0x7FFF
-         : (val < -0x8000 ? -0x8000 : (int16_t)val);
+         : (val <= -32768.0f)
+         ? -0x8000
+         : (val == val) ? (int16_t)val : 0;
    }
 }
 
-void convert_float_to_s16_init_simd(void) { }
+#if defined(__SSE2__)
+static void convert_float_to_s16_SSE2(int16_t *s, const float *in, size_t len)
+{
+   size_t i          = 0;
+   __m128 factor     = _mm_set1_ps((float)0x8000);
+   __m128 max        = _mm_set1_ps(32767.0f);
+
+   for (; i + 8 <= len; i += 8)
+   {
+      __m128 res_a   = _mm_mul_ps(_mm_loadu_ps(in + i + 0), factor);
+      __m128 res_b   = _mm_mul_ps(_mm_loadu_ps(in + i + 4), factor);
+      /* Zero NaNs, and clamp positive overflow which would
+       * otherwise convert to INT32_MIN. Negative overflow
+       * is saturated by the pack. */
+      res_a          = _mm_min_ps(_mm_and_ps(res_a, _mm_cmpord_ps(res_a, res_a)), max);
+      res_b          = _mm_min_ps(_mm_and_ps(res_b, _mm_cmpord_ps(res_b, res_b)), max);
+
+      _mm_storeu_si128((__m128i *)(s + i), _mm_packs_epi32(
+               _mm_cvttps_epi32(res_a), _mm_cvttps_epi32(res_b)));
+   }
+
+   convert_float_to_s16_C(s + i, in + i, len - i);
+}
 #endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void convert_float_to_s16_AVX2(int16_t *s,
+      const float *in, size_t len)
+{
+   size_t i          = 0;
+   __m256 factor     = _mm256_set1_ps((float)0x8000);
+   __m256 max        = _mm256_set1_ps(32767.0f);
+
+   for (; i + 16 <= len; i += 16)
+   {
+      __m256 res_a   = _mm256_mul_ps(_mm256_loadu_ps(in + i + 0), factor);
+      __m256 res_b   = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), factor);
+      __m256i packed;
+      res_a          = _mm256_min_ps(_mm256_and_ps(res_a,
+               _mm256_cmp_ps(res_a, res_a, _CMP_ORD_Q)), max);
+      res_b          = _mm256_min_ps(_mm256_and_ps(res_b,
+               _mm256_cmp_ps(res_b, res_b, _CMP_ORD_Q)), max);
+      packed         = _mm256_packs_epi32(
+            _mm256_cvttps_epi32(res_a), _mm256_cvttps_epi32(res_b));
+
+      /* The pack works within 128-bit lanes */
+      _mm256_storeu_si256((__m256i *)(s + i),
+            _mm256_permute4x64_epi64(packed, 0xD8));
+   }
+
+   convert_float_to_s16_C(s + i, in + i, len - i);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_NEON
+static void convert_float_to_s16_NEON(int16_t *s, const float *in, size_t len)
+{
+   size_t i               = 0;
+#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
+   size_t aligned_samples = len & ~7;
+   if (aligned_samples)
+      convert_float_s16_asm(s, in, aligned_samples);
+
+   i                      = aligned_samples;
+#else
+   float32x4_t factor     = vdupq_n_f32((float)0x8000);
+
+   for (; i + 8 <= len; i += 8)
+   {
+      /* Truncates, saturates and maps NaN to 0 */
+      int32x4_t res_a     = vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + i + 0), factor));
+      int32x4_t res_b     = vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + i + 4), factor));
+
+      vst1q_s16(s + i, vcombine_s16(vqmovn_s32(res_a), vqmovn_s32(res_b)));
+   }
+#endif
+
+   convert_float_to_s16_C(s + i, in + i, len - i);
+}
+#endif
+
+#if defined(__SSE2__)
+static convert_float_to_s16_t convert_float_to_s16_cb = convert_float_to_s16_SSE2;
+#else
+static convert_float_to_s16_t convert_float_to_s16_cb = convert_float_to_s16_C;
+#endif
+
+void convert_float_to_s16(int16_t *s, const float *in, size_t len)
+{
+   convert_float_to_s16_cb(s, in, len);
+}
+
+void convert_float_to_s16_init_simd(void)
+{
+   uint64_t cpu = cpu_features_get();
+
+#if defined(__SSE2__)
+   convert_float_to_s16_cb = convert_float_to_s16_SSE2;
+#else
+   convert_float_to_s16_cb = convert_float_to_s16_C;
+#endif
+#ifdef CONVERSION_SIMD_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+      convert_float_to_s16_cb = convert_float_to_s16_AVX2;
+#endif
+#ifdef CONVERSION_SIMD_NEON
+   if (cpu & RETRO_SIMD_NEON)
+      convert_float_to_s16_cb = convert_float_to_s16_NEON;
+#endif
+   (void)cpu;
+}
@@ -22,15 +22,25 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <features/features_cpu.h>
+#include <audio/conversion/conversion_simd.h>
 #include <audio/conversion/dual_mono.h>
 
-/* TODO: Use SIMD instructions to make this faster (or show that it's not needed) */
-void convert_to_dual_mono_float(float *s, const float *in, size_t len)
-{
-   unsigned i = 0;
+#if defined(CONVERSION_SIMD_NEON) && !defined(HAVE_ARM_NEON_ASM_OPTIMIZATIONS)
+#include <arm_neon.h>
+#define DUAL_MONO_NEON 1
+#endif
 
-   if (!s || !in || !len)
-      return;
+typedef void (*convert_to_dual_mono_float_t)(float *s,
+      const float *in, size_t len);
+
+static void convert_to_dual_mono_float_C(float *s, const float *in, size_t len)
+{
+   size_t i = 0;
 
    for (; i < len; i++)
    {
@@ -39,6 +49,93 @@ void convert_to_dual_mono_float(float *s, const float *in, size_t len)
    }
 }
 
+#if defined(__SSE2__)
+static void convert_to_dual_mono_float_SSE2(float *s, const float *in, size_t len)
+{
+   size_t i = 0;
+
+   for (; i + 4 <= len; i += 4)
+   {
+      __m128 input = _mm_loadu_ps(in + i);
+      _mm_storeu_ps(s + i * 2 + 0, _mm_unpacklo_ps(input, input));
+      _mm_storeu_ps(s + i * 2 + 4, _mm_unpackhi_ps(input, input));
+   }
+
+   convert_to_dual_mono_float_C(s + i * 2, in + i, len - i);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void convert_to_dual_mono_float_AVX2(
+      float *s, const float *in, size_t len)
+{
+   size_t i = 0;
+
+   for (; i + 8 <= len; i += 8)
+   {
+      __m256 input = _mm256_loadu_ps(in + i);
+      /* Unpacking works within 128-bit lanes */
+      __m256 lo    = _mm256_unpacklo_ps(input, input);
+      __m256 hi    = _mm256_unpackhi_ps(input, input);
+      _mm256_storeu_ps(s + i * 2 + 0, _mm256_permute2f128_ps(lo, hi, 0x20));
+      _mm256_storeu_ps(s + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+   }
+
+   convert_to_dual_mono_float_C(s + i * 2, in + i, len - i);
+}
+#endif
+
+#ifdef DUAL_MONO_NEON
+static void convert_to_dual_mono_float_NEON(float *s, const float *in, size_t len)
+{
+   size_t i = 0;
+
+   for (; i + 4 <= len; i += 4)
+   {
+      float32x4x2_t output;
+      output.val[0] = vld1q_f32(in + i);
+      output.val[1] = output.val[0];
+      vst2q_f32(s + i * 2, output);
+   }
+
+   convert_to_dual_mono_float_C(s + i * 2, in + i, len - i);
+}
+#endif
+
+#if defined(__SSE2__)
+static convert_to_dual_mono_float_t convert_to_dual_mono_float_cb = convert_to_dual_mono_float_SSE2;
+#else
+static convert_to_dual_mono_float_t convert_to_dual_mono_float_cb = convert_to_dual_mono_float_C;
+#endif
+
+void convert_to_dual_mono_float(float *s, const float *in, size_t len)
+{
+   if (!s || !in || !len)
+      return;
+
+   convert_to_dual_mono_float_cb(s, in, len);
+}
+
+void convert_to_dual_mono_float_init_simd(void)
+{
+   uint64_t cpu = cpu_features_get();
+
+#if defined(__SSE2__)
+   convert_to_dual_mono_float_cb = convert_to_dual_mono_float_SSE2;
+#else
+   convert_to_dual_mono_float_cb = convert_to_dual_mono_float_C;
+#endif
+#ifdef CONVERSION_SIMD_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+      convert_to_dual_mono_float_cb = convert_to_dual_mono_float_AVX2;
+#endif
+#ifdef DUAL_MONO_NEON
+   if (cpu & RETRO_SIMD_NEON)
+      convert_to_dual_mono_float_cb = convert_to_dual_mono_float_NEON;
+#endif
+   (void)cpu;
+}
+
 /* Why is there no equivalent for int16_t samples?
  * No inherent reason, I just didn't need one.
  * If you do, open a pull request. */
@@ -19,6 +19,9 @@
  * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <stdint.h>
+#include <stddef.h>
+
 #if defined(__SSE2__)
 #include <emmintrin.h>
 #elif defined(__ALTIVEC__)
@@ -27,11 +30,10 @@
 
 #include <boolean.h>
 #include <features/features_cpu.h>
+#include <audio/conversion/conversion_simd.h>
 #include <audio/conversion/s16_to_float.h>
 
-#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
-static bool s16_to_float_neon_enabled = false;
-
+#ifdef CONVERSION_SIMD_NEON
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
 /* Avoid potential hard-float/soft-float ABI issues. */
 void convert_s16_float_asm(float *s, const int16_t *in,
@@ -39,83 +41,20 @@ void convert_s16_float_asm(float *s, const int16_t *in,
 #else
 #include <arm_neon.h>
 #endif
-
-void convert_s16_to_float(float *s,
-      const int16_t *in, size_t len, float gain)
-{
-   unsigned i      = 0;
-
-   if (s16_to_float_neon_enabled)
-   {
-#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
-      size_t aligned_samples = len & ~7;
-      if (aligned_samples)
-         convert_s16_float_asm(s, in, aligned_samples, &gain);
-
-      /* Could do all conversion in ASM, but keep it simple for now. */
-      s                 += aligned_samples;
-      in                += aligned_samples;
-      len               -= aligned_samples;
-      i                  = 0;
-#else
-      float        gf    = gain / (1 << 15);
-      float32x4_t vgf    = {gf, gf, gf, gf};
-      while (len >= 8)
-      {
-         float32x4x2_t oreg;
-         int16x4x2_t inreg   = vld2_s16(in);
-         int32x4_t      p1   = vmovl_s16(inreg.val[0]);
-         int32x4_t      p2   = vmovl_s16(inreg.val[1]);
-         oreg.val[0]         = vmulq_f32(vcvtq_f32_s32(p1), vgf);
-         oreg.val[1]         = vmulq_f32(vcvtq_f32_s32(p2), vgf);
-         vst2q_f32(s, oreg);
-         in                 += 8;
-         s                  += 8;
-         len                -= 8;
-      }
 #endif
-   }
-
-   gain /= 0x8000;
 
-   for (; i < len; i++)
-      s[i] = (float)in[i] * gain;
-}
+typedef void (*convert_s16_to_float_t)(float *s,
+      const int16_t *in, size_t len, float gain);
 
-void convert_s16_to_float_init_simd(void)
-{
-   uint64_t cpu = cpu_features_get();
-
-   if (cpu & RETRO_SIMD_NEON)
-      s16_to_float_neon_enabled = true;
-}
-#else
-void convert_s16_to_float(float *s,
+/* Reference for all other implementations */
+static void convert_s16_to_float_C(float *s,
       const int16_t *in, size_t len, float gain)
 {
-   unsigned i      = 0;
-
-#if defined(__SSE2__)
-   float fgain   = gain / UINT32_C(0x80000000);
-   __m128 factor = _mm_set1_ps(fgain);
-
-   for (i = 0; i + 8 <= len; i += 8, in += 8, s += 8)
-   {
-      __m128i input    = _mm_loadu_si128((const __m128i *)in);
-      __m128i regs_l   = _mm_unpacklo_epi16(_mm_setzero_si128(), input);
-      __m128i regs_r   = _mm_unpackhi_epi16(_mm_setzero_si128(), input);
-      __m128 output_l  = _mm_mul_ps(_mm_cvtepi32_ps(regs_l), factor);
-      __m128 output_r  = _mm_mul_ps(_mm_cvtepi32_ps(regs_r), factor);
-
-      _mm_storeu_ps(s + 0, output_l);
-      _mm_storeu_ps(s + 4, output_r);
-   }
+   size_t i = 0;
 
-   len     = len - i;
-   i       = 0;
-#elif defined(__ALTIVEC__)
-   size_t samples_in = len;
+   gain /= 0x8000;
 
+#if defined(__ALTIVEC__)
    /* Unaligned loads/store is a bit expensive, so we
     * optimize for the good path (very likely). */
    if (((uintptr_t)s & 15) + ((uintptr_t)in & 15) == 0)
@@ -123,28 +62,19 @@ void convert_s16_to_float(float *s,
       const vector float gain_vec = { gain, gain , gain, gain };
       const vector float zero_vec = { 0.0f, 0.0f, 0.0f, 0.0f};
 
-      for (i = 0; i + 8 <= len; i += 8, in += 8, s += 8)
+      for (i = 0; i + 8 <= len; i += 8)
       {
-         vector signed short input = vec_ld(0, in);
+         vector signed short input = vec_ld(0, in + i);
          vector signed int hi      = vec_unpackh(input);
          vector signed int lo      = vec_unpackl(input);
-         vector float out_hi       = vec_madd(vec_ctf(hi, 15), gain_vec, zero_vec);
-         vector float out_lo       = vec_madd(vec_ctf(lo, 15), gain_vec, zero_vec);
+         vector float out_hi       = vec_madd(vec_ctf(hi, 0), gain_vec, zero_vec);
+         vector float out_lo       = vec_madd(vec_ctf(lo, 0), gain_vec, zero_vec);
 
-         vec_st(out_hi,  0, s);
-         vec_st(out_lo, 16, s);
+         vec_st(out_hi,  0, s + i);
+         vec_st(out_lo, 16, s + i);
       }
-
-      samples_in -= i;
    }
-
-   len     = samples_in;
-   i       = 0;
-#endif
-
-   gain   /= 0x8000;
-
-#if defined(_MIPS_ARCH_ALLEGREX)
+#elif defined(_MIPS_ARCH_ALLEGREX)
 #ifdef DEBUG
    /* Make sure the buffer is 16 byte aligned, this should be the
     * default behaviour of malloc in the PSPSDK.
@@ -200,6 +130,108 @@ void convert_s16_to_float(float *s,
       s[i] = (float)in[i] * gain;
 }
 
-void convert_s16_to_float_init_simd(void) { }
+#if defined(__SSE2__)
+static void convert_s16_to_float_SSE2(float *s,
+      const int16_t *in, size_t len, float gain)
+{
+   size_t i      = 0;
+   __m128 factor = _mm_set1_ps(gain / 0x8000);
+
+   for (; i + 8 <= len; i += 8)
+   {
+      __m128i input    = _mm_loadu_si128((const __m128i *)(in + i));
+      /* Sign extend to 32-bit */
+      __m128i regs_l   = _mm_srai_epi32(_mm_unpacklo_epi16(input, input), 16);
+      __m128i regs_r   = _mm_srai_epi32(_mm_unpackhi_epi16(input, input), 16);
+
+      _mm_storeu_ps(s + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(regs_l), factor));
+      _mm_storeu_ps(s + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(regs_r), factor));
+   }
+
+   convert_s16_to_float_C(s + i, in + i, len - i, gain);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void convert_s16_to_float_AVX2(float *s,
+      const int16_t *in, size_t len, float gain)
+{
+   size_t i         = 0;
+   __m256 factor    = _mm256_set1_ps(gain / 0x8000);
+
+   for (; i + 16 <= len; i += 16)
+   {
+      __m128i input_l  = _mm_loadu_si128((const __m128i *)(in + i + 0));
+      __m128i input_r  = _mm_loadu_si128((const __m128i *)(in + i + 8));
+      __m256 output_l  = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(input_l));
+      __m256 output_r  = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(input_r));
+
+      _mm256_storeu_ps(s + i + 0, _mm256_mul_ps(output_l, factor));
+      _mm256_storeu_ps(s + i + 8, _mm256_mul_ps(output_r, factor));
+   }
+
+   convert_s16_to_float_C(s + i, in + i, len - i, gain);
+}
 #endif
 
+#ifdef CONVERSION_SIMD_NEON
+static void convert_s16_to_float_NEON(float *s,
+      const int16_t *in, size_t len, float gain)
+{
+   size_t i               = 0;
+#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
+   size_t aligned_samples = len & ~7;
+   if (aligned_samples)
+      convert_s16_float_asm(s, in, aligned_samples, &gain);
+
+   /* Could do all conversion in ASM, but keep it simple for now. */
+   i                      = aligned_samples;
+#else
+   float32x4_t factor     = vdupq_n_f32(gain / 0x8000);
+
+   for (; i + 8 <= len; i += 8)
+   {
+      int16x8_t input     = vld1q_s16(in + i);
+      int32x4_t regs_l    = vmovl_s16(vget_low_s16(input));
+      int32x4_t regs_r    = vmovl_s16(vget_high_s16(input));
+
+      vst1q_f32(s + i + 0, vmulq_f32(vcvtq_f32_s32(regs_l), factor));
+      vst1q_f32(s + i + 4, vmulq_f32(vcvtq_f32_s32(regs_r), factor));
+   }
+#endif
+
+   convert_s16_to_float_C(s + i, in + i, len - i, gain);
+}
+#endif
+
+#if defined(__SSE2__)
+static convert_s16_to_float_t convert_s16_to_float_cb = convert_s16_to_float_SSE2;
+#else
+static convert_s16_to_float_t convert_s16_to_float_cb = convert_s16_to_float_C;
+#endif
+
+void convert_s16_to_float(float *s,
+      const int16_t *in, size_t len, float gain)
+{
+   convert_s16_to_float_cb(s, in, len, gain);
+}
+
+void convert_s16_to_float_init_simd(void)
+{
+   uint64_t cpu = cpu_features_get();
+
+#if defined(__SSE2__)
+   convert_s16_to_float_cb = convert_s16_to_float_SSE2;
+#else
+   convert_s16_to_float_cb = convert_s16_to_float_C;
+#endif
+#ifdef CONVERSION_SIMD_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+      convert_s16_to_float_cb = convert_s16_to_float_AVX2;
+#endif
+#ifdef CONVERSION_SIMD_NEON
+   if (cpu & RETRO_SIMD_NEON)
+      convert_s16_to_float_cb = convert_s16_to_float_NEON;
+#endif
+   (void)cpu;
+}
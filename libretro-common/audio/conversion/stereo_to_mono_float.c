@@ -22,20 +22,115 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <features/features_cpu.h>
+#include <audio/conversion/conversion_simd.h>
 #include <audio/conversion/dual_mono.h>
 
-/* TODO: Use SIMD instructions to make this faster (or show that it's not needed) */
-void convert_to_mono_float_left(float *out, const float *in, size_t frames)
-{
-   unsigned i = 0;
+#if defined(CONVERSION_SIMD_NEON) && !defined(HAVE_ARM_NEON_ASM_OPTIMIZATIONS)
+#include <arm_neon.h>
+#define MONO_LEFT_NEON 1
+#endif
 
-   if (!out || !in || !frames)
-      return;
+typedef void (*convert_to_mono_float_left_t)(float *out,
+      const float *in, size_t frames);
+
+static void convert_to_mono_float_left_C(float *out, const float *in, size_t frames)
+{
+   size_t i = 0;
 
    for (; i < frames; i++)
-   {
       out[i] = in[i * 2];
+}
+
+#if defined(__SSE2__)
+static void convert_to_mono_float_left_SSE2(float *out,
+      const float *in, size_t frames)
+{
+   size_t i = 0;
+
+   for (; i + 4 <= frames; i += 4)
+   {
+      __m128 input_a = _mm_loadu_ps(in + i * 2 + 0);
+      __m128 input_b = _mm_loadu_ps(in + i * 2 + 4);
+      _mm_storeu_ps(out + i, _mm_shuffle_ps(input_a, input_b,
+               _MM_SHUFFLE(2, 0, 2, 0)));
+   }
+
+   convert_to_mono_float_left_C(out + i, in + i * 2, frames - i);
+}
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+static CONVERSION_SIMD_TARGET_AVX2 void convert_to_mono_float_left_AVX2(
+      float *out, const float *in, size_t frames)
+{
+   size_t i = 0;
+
+   for (; i + 8 <= frames; i += 8)
+   {
+      __m256 input_a = _mm256_loadu_ps(in + i * 2 + 0);
+      __m256 input_b = _mm256_loadu_ps(in + i * 2 + 8);
+      /* Shuffling works within 128-bit lanes,
+       * giving frames 0-1, 4-5, 2-3, 6-7 */
+      __m256 left    = _mm256_shuffle_ps(input_a, input_b,
+            _MM_SHUFFLE(2, 0, 2, 0));
+      _mm256_storeu_ps(out + i, _mm256_castpd_ps(_mm256_permute4x64_pd(
+                  _mm256_castps_pd(left), 0xD8)));
    }
+
+   convert_to_mono_float_left_C(out + i, in + i * 2, frames - i);
+}
+#endif
+
+#ifdef MONO_LEFT_NEON
+static void convert_to_mono_float_left_NEON(float *out,
+      const float *in, size_t frames)
+{
+   size_t i = 0;
+
+   for (; i + 4 <= frames; i += 4)
+      vst1q_f32(out + i, vld2q_f32(in + i * 2).val[0]);
+
+   convert_to_mono_float_left_C(out + i, in + i * 2, frames - i);
+}
+#endif
+
+#if defined(__SSE2__)
+static convert_to_mono_float_left_t convert_to_mono_float_left_cb = convert_to_mono_float_left_SSE2;
+#else
+static convert_to_mono_float_left_t convert_to_mono_float_left_cb = convert_to_mono_float_left_C;
+#endif
+
+void convert_to_mono_float_left(float *out, const float *in, size_t frames)
+{
+   if (!out || !in || !frames)
+      return;
+
+   convert_to_mono_float_left_cb(out, in, frames);
+}
+
+void convert_to_mono_float_left_init_simd(void)
+{
+   uint64_t cpu = cpu_features_get();
+
+#if defined(__SSE2__)
+   convert_to_mono_float_left_cb = convert_to_mono_float_left_SSE2;
+#else
+   convert_to_mono_float_left_cb = convert_to_mono_float_left_C;
+#endif
+#ifdef CONVERSION_SIMD_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+      convert_to_mono_float_left_cb = convert_to_mono_float_left_AVX2;
+#endif
+#ifdef MONO_LEFT_NEON
+   if (cpu & RETRO_SIMD_NEON)
+      convert_to_mono_float_left_cb = convert_to_mono_float_left_NEON;
+#endif
+   (void)cpu;
 }
 
 /* Why is there no equivalent for int16_t samples?
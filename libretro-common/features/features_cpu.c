@@ -720,7 +720,9 @@ uint64_t cpu_features_get(void)
          && ((xgetbv_x86(0) & 0x6) == 0x6))
       cpu |= RETRO_SIMD_AVX;
 
-   if (max_flag >= 7)
+   /* AVX2 uses the same YMM state, so it is only usable
+    * once the xgetbv check above has passed. */
+   if ((cpu & RETRO_SIMD_AVX) && max_flag >= 7)
    {
       x86_cpuid(7, flags);
       if (flags[1] & (1 << 5))
@@ -98,6 +98,34 @@ int32_t path_get_size(const char *path)
    return -1;
 }
 
+bool path_get_stamp(const char *path, int64_t *stamp, int64_t *size)
+{
+#if defined(_WIN32)
+   struct _stat64 st;
+   if (_stat64(path, &st) != 0)
+      return false;
+   *stamp = (int64_t)st.st_mtime * 1000000000;
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+   struct stat st;
+   if (stat(path, &st) != 0)
+      return false;
+#if defined(__linux__)
+   *stamp = (int64_t)st.st_mtime * 1000000000 + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+   *stamp = (int64_t)st.st_mtime * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+   *stamp = (int64_t)st.st_mtime * 1000000000;
+#endif
+#else
+   return false;
+#endif
+#if defined(_WIN32) || defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+   if (size)
+      *size = (int64_t)st.st_size;
+   return true;
+#endif
+}
+
 /**
  * path_mkdir:
  * @dir                : directory
@@ -172,16 +172,15 @@ static void sha256_subhash(struct sha256_ctx *p, uint32_t *t)
 }
 
 /**
- * sha256_hash:
- * @s                 : Output.
+ * sha256_digest:
  * @in                : Input.
- * @size              : Size of @s.
+ * @len               : Size of @in.
+ * @digest            : Output.
  *
- * Hashes SHA256 and outputs a human readable string.
+ * Hashes SHA256.
  **/
-void sha256_hash(char *s, const uint8_t *in, size_t len)
+void sha256_digest(const uint8_t *in, size_t len, uint8_t digest[32])
 {
-   unsigned i;
    struct sha256_ctx sha;
 
    union
@@ -195,8 +194,26 @@ void sha256_hash(char *s, const uint8_t *in, size_t len)
    sha256_final(&sha);
    sha256_subhash(&sha, shahash.u32);
 
+   memcpy(digest, shahash.u8, 32);
+}
+
+/**
+ * sha256_hash:
+ * @s                 : Output.
+ * @in                : Input.
+ * @size              : Size of @s.
+ *
+ * Hashes SHA256 and outputs a human readable string.
+ **/
+void sha256_hash(char *s, const uint8_t *in, size_t len)
+{
+   unsigned i;
+   uint8_t digest[32];
+
+   sha256_digest(in, len, digest);
+
    for (i = 0; i < 32; i++)
-      snprintf(s + 2 * i, 3, "%02x", (unsigned)shahash.u8[i]);
+      snprintf(s + 2 * i, 3, "%02x", (unsigned)digest[i]);
 }
 
 #ifndef HAVE_ZLIB
@@ -55,13 +55,38 @@ typedef struct
    bool resample;
 } audio_chunk_t;
 
-#if defined(__SSE2__)
-#define audio_mix_volume           audio_mix_volume_SSE2
+/**
+ * audio_mix_volume:
+ * @dst                : samples to mix into
+ * @src                : samples to mix
+ * @vol                : gain applied to @src
+ * @samples            : number of samples
+ *
+ * Adds @src, scaled by @vol, to @dst, using the
+ * implementation selected by audio_mix_init_simd().
+ **/
+void audio_mix_volume(float *dst, const float *src, float vol, size_t samples);
+
+/**
+ * audio_mix_clamp:
+ * @dst                : samples to clamp
+ * @samples            : number of samples
+ *
+ * Saturates mixed samples to [-1.0, 1.0].
+ **/
+void audio_mix_clamp(float *dst, size_t samples);
 
+/**
+ * audio_mix_init_simd:
+ *
+ * Selects the fastest implementations of the mixing
+ * functions the CPU supports. They work without it.
+ **/
+void audio_mix_init_simd(void);
+
+#if defined(__SSE2__)
 void audio_mix_volume_SSE2(float *out,
       const float *in, float vol, size_t samples);
-#else
-#define audio_mix_volume           audio_mix_volume_C
 #endif
 
 void audio_mix_volume_C(float *dst, const float *src, float vol, size_t samples);
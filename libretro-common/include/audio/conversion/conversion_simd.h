@@ -0,0 +1,58 @@
+/* Copyright  (C) 2010-2021 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (conversion_simd.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __LIBRETRO_SDK_CONVERSION_SIMD_H__
+#define __LIBRETRO_SDK_CONVERSION_SIMD_H__
+
+/* Shared by the audio conversion and mixing kernels.
+ *
+ * SSE2 kernels are used whenever the compiler targets SSE2, and
+ * NEON kernels are enabled at runtime, as before. AVX2 kernels are
+ * built for AVX2 with a function attribute, so they can be selected
+ * at runtime by the *_init_simd() functions without building
+ * everything else for AVX2.
+ *
+ * All kernels of an operation give the same results as its C
+ * implementation, bit for bit, on IEEE conforming SIMD units (ARMv7
+ * NEON flushes denormals to zero and does not keep NaN payloads). */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+/* MinGW GCC cannot align the stack for spilled AVX registers */
+#if !defined(_WIN32) || defined(__clang__)
+#define CONVERSION_SIMD_AVX2 1
+#define CONVERSION_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1700
+#define CONVERSION_SIMD_AVX2 1
+#define CONVERSION_SIMD_TARGET_AVX2
+#endif
+#endif
+
+#ifdef CONVERSION_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(HAVE_NEON)
+#define CONVERSION_SIMD_NEON 1
+#endif
+
+#endif
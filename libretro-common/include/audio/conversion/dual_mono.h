@@ -47,6 +47,14 @@ RETRO_BEGIN_DECLS
  */
 void convert_to_dual_mono_float(float *out, const float *in, size_t frames);
 
+/**
+ * Selects the fastest implementation of \c convert_to_dual_mono_float
+ * the CPU supports. It works without calling this function.
+ *
+ * @see convert_to_dual_mono_float
+ */
+void convert_to_dual_mono_float_init_simd(void);
+
 /**
  * Downmixes 2-channel (stereo) frames into 1-channel (mono) frames.
  * This is intended for dual-mono audio (i.e. where both channels are identical),
@@ -64,6 +72,14 @@ void convert_to_dual_mono_float(float *out, const float *in, size_t frames);
  */
 void convert_to_mono_float_left(float *out, const float *in, size_t frames);
 
+/**
+ * Selects the fastest implementation of \c convert_to_mono_float_left
+ * the CPU supports. It works without calling this function.
+ *
+ * @see convert_to_mono_float_left
+ */
+void convert_to_mono_float_left_init_simd(void);
+
 RETRO_END_DECLS
 
 #endif
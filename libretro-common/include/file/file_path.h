@@ -683,6 +683,22 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+/**
+ * path_get_stamp:
+ * @path               : path
+ * @stamp              : modification time, in nanoseconds
+ * @size               : size in bytes, or NULL
+ *
+ * Reads the modification time and size of @path, so that callers
+ * can tell whether it changed since they last read it. Goes straight
+ * to stat(), not through the VFS. Only Linux and Apple platforms
+ * provide the nanoseconds; elsewhere @stamp is in whole seconds.
+ *
+ * @return true on success, false if @path could not be read or the
+ * platform has no modification times.
+ **/
+bool path_get_stamp(const char *path, int64_t *stamp, int64_t *size);
+
 bool is_path_accessible_using_standard_io(const char *path);
 
 RETRO_END_DECLS
@@ -2587,6 +2587,26 @@ enum retro_mod
 */
 #define RETRO_ENVIRONMENT_GET_TARGET_SAMPLE_RATE (81 | RETRO_ENVIRONMENT_EXPERIMENTAL)
 
+/**
+ * Declares that all of the core's mutable state lives in the writable
+ * regions passed to \c RETRO_ENVIRONMENT_SET_MEMORY_MAPS,
+ * plus a small residue blob that the core saves and restores
+ * through the given callbacks.
+ *
+ * Rollback netplay may then snapshot those regions directly
+ * instead of calling \c retro_serialize.
+ * The frontend periodically checks snapshots against full serialization,
+ * and stops using them if they ever disagree.
+ *
+ * @param[in] data <tt>const struct retro_rollback_snapshot_interface *</tt>.
+ * The interface to use, or \c NULL to clear it.
+ * It is also cleared when \c retro_unload_game is called.
+ * @return \c true if the frontend accepted the interface.
+ * @see retro_rollback_snapshot_interface
+ * @see RETRO_ENVIRONMENT_SET_MEMORY_MAPS
+ */
+#define RETRO_ENVIRONMENT_SET_ROLLBACK_SNAPSHOT_INTERFACE (82 | RETRO_ENVIRONMENT_EXPERIMENTAL)
+
 /**@}*/
 
 /**
@@ -3789,6 +3809,35 @@ struct retro_memory_map
    unsigned num_descriptors;
 };
 
+/** The current version of \c retro_rollback_snapshot_interface. */
+#define RETRO_ROLLBACK_SNAPSHOT_INTERFACE_VERSION 1
+
+/**
+ * Callbacks for the state that is not in the core's memory map.
+ *
+ * @see RETRO_ENVIRONMENT_SET_ROLLBACK_SNAPSHOT_INTERFACE
+ */
+struct retro_rollback_snapshot_interface
+{
+   /** Set to \c RETRO_ROLLBACK_SNAPSHOT_INTERFACE_VERSION. */
+   unsigned interface_version;
+
+   /** Upper bound for the residue blob, in bytes. */
+   size_t residue_max_size;
+
+   /**
+    * Returns the current residue size.
+    * May be \c NULL if it is always \c residue_max_size.
+    */
+   size_t (RETRO_CALLCONV *residue_size)(void);
+
+   /** Saves the residue into \c data, which holds \c size bytes. */
+   bool (RETRO_CALLCONV *residue_serialize)(void *data, size_t size);
+
+   /** Restores the residue from \c data. */
+   bool (RETRO_CALLCONV *residue_unserialize)(const void *data, size_t size);
+};
+
 /** @} */
 
 /** @defgroup SET_CONTROLLER_INFO Controller Info
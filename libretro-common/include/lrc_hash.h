@@ -51,6 +51,16 @@ RETRO_BEGIN_DECLS
  **/
 void sha256_hash(char *s, const uint8_t *in, size_t len);
 
+/**
+ * sha256_digest:
+ * @in                : Input.
+ * @len               : Size of @in.
+ * @digest            : Output.
+ *
+ * Hashes SHA256.
+ **/
+void sha256_digest(const uint8_t *in, size_t len, uint8_t digest[32]);
+
 /**
  * SHA1Digest:
  * @data              : Input.
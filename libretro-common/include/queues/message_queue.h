@@ -47,6 +47,10 @@ typedef struct queue_elem
 {
    char *msg;
    char *title;
+   /* Allocated sizes of msg and title, kept when the
+    * element is recycled */
+   size_t msg_size;
+   size_t title_size;
    unsigned duration;
    unsigned prio;
    enum message_queue_icon icon;
@@ -57,7 +61,13 @@ typedef struct msg_queue
 {
    char *tmp_msg;
    queue_elem_t **elems;
+   /* Elements pulled or cleared from the queue, with their
+    * strings, reused by later pushes so that a queue showing
+    * the same messages every frame does not allocate */
+   queue_elem_t **spare;
+   size_t tmp_msg_size;
    size_t ptr;
+   size_t spare_ptr;
    size_t size;
 } msg_queue_t;
 
@@ -303,6 +303,101 @@ uintptr_t sthread_get_thread_id(sthread_t *thread);
  */
 uintptr_t sthread_get_current_thread_id(void);
 
+/** Roles of long-lived threads, each with its own scheduling settings. */
+enum sthread_role
+{
+   STHREAD_ROLE_MAIN = 0,
+   STHREAD_ROLE_AUDIO,
+   STHREAD_ROLE_VIDEO,
+   STHREAD_ROLE_TASK,
+   STHREAD_ROLE_LAST
+};
+
+/** Scheduling policies a thread role can ask for. */
+enum sthread_sched
+{
+   /** Keep the default scheduling, see \c sthread_role_set_config. */
+   STHREAD_SCHED_DEFAULT = 0,
+   /** Normal scheduling, with \c priority as a nice value from -20 to 19. */
+   STHREAD_SCHED_NICE,
+   /** Real-time FIFO scheduling, with \c priority from 1 to 99. */
+   STHREAD_SCHED_FIFO,
+   /** Real-time round-robin scheduling, with \c priority from 1 to 99. */
+   STHREAD_SCHED_RR
+};
+
+/** What \c sthread_role_apply managed to change. */
+enum sthread_role_flags
+{
+   STHREAD_ROLE_FLAG_AFFINITY      = (1 << 0),
+   STHREAD_ROLE_FLAG_SCHED         = (1 << 1),
+   /** Real-time scheduling was refused, \c fallback_nice was applied instead. */
+   STHREAD_ROLE_FLAG_SCHED_FALLBACK = (1 << 2),
+   STHREAD_ROLE_FLAG_TIMER_SLACK   = (1 << 3)
+};
+
+/** Scheduling settings of a thread role. */
+struct sthread_role_config
+{
+   /** CPUs the thread may run on, one bit per CPU, or 0 for the default. */
+   uint64_t cpu_mask;
+   /** Timer slack in nanoseconds, or 0 to leave the default. Linux only. */
+   unsigned timer_slack_ns;
+   /** One of \c sthread_sched. */
+   unsigned sched;
+   /** Nice value or real-time priority, depending on \c sched. */
+   int priority;
+   /** Nice value to use if real-time scheduling is refused. */
+   int fallback_nice;
+};
+
+/**
+ * Sets the scheduling settings of a thread role.
+ *
+ * Threads pick them up when they call \c sthread_role_apply,
+ * usually once when they start,
+ * so roles should be configured before creating their threads.
+ *
+ * The first call records the affinity, scheduling and timer slack
+ * of the calling thread as the defaults. While any role is configured,
+ * threads created by \c sthread_create start from these defaults
+ * instead of inheriting the settings of the thread that created them.
+ *
+ * @param role The role to configure.
+ * @param config The settings of the role,
+ * or \c NULL to leave threads of this role untouched.
+ */
+void sthread_role_set_config(enum sthread_role role,
+      const struct sthread_role_config *config);
+
+/**
+ * Applies the settings of a role to the calling thread.
+ *
+ * Settings that are not supported on the platform,
+ * or that the process is not allowed to use, are skipped.
+ * Real-time priorities are capped to \c RLIMIT_RTPRIO where it is set,
+ * and fall back to \c fallback_nice when refused.
+ * Affinity, nice values and timer slack are only supported on Linux;
+ * affinity and priorities on Windows;
+ * real-time priorities on other POSIX systems.
+ *
+ * Whatever the role leaves unset is reset to the defaults.
+ *
+ * @param role The role of the calling thread.
+ * @return The \c sthread_role_flags of the settings that were applied,
+ * or 0 if the role is not configured.
+ * @warning A real-time thread that never blocks can starve
+ * every other thread on its CPUs.
+ */
+unsigned sthread_role_apply(enum sthread_role role);
+
+/**
+ * Resets the calling thread to the defaults
+ * recorded by the first \c sthread_role_set_config call.
+ * Does nothing if no role was ever configured.
+ */
+void sthread_role_restore(void);
+
 RETRO_END_DECLS
 
 #endif
@@ -91,6 +91,91 @@ bool tpool_add_work(tpool_t *tp, thread_func_t func, void *arg);
  */
 void tpool_wait(tpool_t *tp);
 
+/* Fork-join pool for splitting short, per-frame jobs (filtering,
+ * scaling, DSP) across threads.
+ *
+ * Unlike tpool_add_work(), dispatching a job allocates nothing and
+ * takes no lock while the workers are awake: the job lives in a slot
+ * preallocated with the pool and workers claim chunks of it with an
+ * atomic counter. The calling thread processes chunks too, and only
+ * waits for chunks that were claimed by workers. Idle workers spin
+ * for a while before parking on a condition variable, so jobs issued
+ * back to back do not pay for a wake up. */
+struct tpool_parallel;
+typedef struct tpool_parallel tpool_parallel_t;
+
+/* Spin iterations before an idle worker parks, suitable for jobs
+ * issued several times per frame */
+#define TPOOL_PARALLEL_SPIN_DEFAULT 4096
+
+/**
+ * (*tpool_range_func_t):
+ * @userdata      : Argument passed to tpool_parallel_for().
+ * @begin         : First index of the chunk.
+ * @end           : One past the last index of the chunk.
+ * @worker        : Index of the calling thread, 0 for the thread
+ *                  that called tpool_parallel_for(), from 1 to the
+ *                  number of workers otherwise. Can be used to index
+ *                  preallocated scratch buffers.
+ *
+ * Callback processing indices [begin, end) of a job.
+ **/
+typedef void (*tpool_range_func_t)(void *userdata,
+      size_t begin, size_t end, unsigned worker);
+
+/**
+ * tpool_parallel_create:
+ * @workers       : Number of worker threads, besides the thread
+ *                  calling tpool_parallel_for(). Usually one less than
+ *                  the number of cores. If 0, jobs run on the caller.
+ * @spin          : Spin iterations before an idle worker parks, see
+ *                  TPOOL_PARALLEL_SPIN_DEFAULT. If 0, workers park as
+ *                  soon as they are idle.
+ * @cpus          : If not NULL, the CPU to pin each worker to, or
+ *                  -1 to leave a worker unpinned. Only honoured on
+ *                  Linux and Windows.
+ *
+ * Create a fork-join pool.
+ *
+ * Returns: pool, or NULL on failure.
+ **/
+tpool_parallel_t *tpool_parallel_create(unsigned workers, unsigned spin,
+      const int *cpus);
+
+/**
+ * tpool_parallel_free:
+ * @pp            : Fork-join pool.
+ *
+ * Stop the workers and free the pool.
+ **/
+void tpool_parallel_free(tpool_parallel_t *pp);
+
+/**
+ * tpool_parallel_get_threads:
+ * @pp            : Fork-join pool.
+ *
+ * Returns: the number of threads that can run chunks of a job, that
+ * is the workers plus the calling thread.
+ **/
+unsigned tpool_parallel_get_threads(const tpool_parallel_t *pp);
+
+/**
+ * tpool_parallel_for:
+ * @pp            : Fork-join pool, or NULL to run on the caller.
+ * @count         : Number of indices to process.
+ * @grain         : Indices per chunk. If 0, the job is split into a
+ *                  few chunks per thread.
+ * @func          : Function processing a chunk.
+ * @userdata      : Argument to pass to func.
+ *
+ * Call @func on chunks of [0, @count) from the calling thread and the
+ * workers, and return once every index has been processed. Each index
+ * is processed exactly once. Must not be called from several threads
+ * at once, nor from within @func.
+ **/
+void tpool_parallel_for(tpool_parallel_t *pp, size_t count, size_t grain,
+      tpool_range_func_t func, void *userdata);
+
 RETRO_END_DECLS
 
 #endif
@@ -95,10 +95,28 @@ bool trans_stream_trans_full(
 
 const struct trans_stream_backend* trans_stream_get_zlib_deflate_backend(void);
 const struct trans_stream_backend* trans_stream_get_zlib_inflate_backend(void);
+const struct trans_stream_backend* trans_stream_get_zstd_compress_backend(void);
+const struct trans_stream_backend* trans_stream_get_zstd_decompress_backend(void);
 const struct trans_stream_backend* trans_stream_get_pipe_backend(void);
 
+/**
+ * trans_stream_zstd_set_dictionary:
+ * @data                        : zstd compress or decompress stream
+ * @dict                        : dictionary, NULL to stop using one
+ * @dict_size                   : dictionary size
+ *
+ * Use a dictionary from the next frame on. Both a dictionary trained by
+ * zstd and any raw sample of similar data (such as an earlier savestate of
+ * the same core) work; both sides must use the same one. A raw dictionary
+ * is referenced, not copied, and has to stay valid while the stream is used.
+ */
+bool trans_stream_zstd_set_dictionary(void *data,
+      const void *dict, size_t dict_size);
+
 extern const struct trans_stream_backend zlib_deflate_backend;
 extern const struct trans_stream_backend zlib_inflate_backend;
+extern const struct trans_stream_backend zstd_compress_backend;
+extern const struct trans_stream_backend zstd_decompress_backend;
 extern const struct trans_stream_backend pipe_backend;
 
 RETRO_END_DECLS
@@ -60,9 +60,14 @@ enum vfs_scheme
 {
    VFS_SCHEME_NONE = 0,
    VFS_SCHEME_CDROM,
-   VFS_SCHEME_SAF
+   VFS_SCHEME_SAF,
+   VFS_SCHEME_ARCHIVE
 };
 
+#ifdef HAVE_VFS_ARCHIVE
+struct vfs_archive_stream;
+#endif
+
 #if !(defined(__WINRT__) && defined(__cplusplus_winrt))
 #ifdef VFS_FRONTEND
 struct retro_vfs_file_handle
@@ -83,6 +88,9 @@ struct libretro_vfs_implementation_file
    char *buf;
    char* orig_path;
    uint8_t *mapped;
+#ifdef HAVE_VFS_ARCHIVE
+   struct vfs_archive_stream *archive;
+#endif
    int fd;
    unsigned hints;
    enum vfs_scheme scheme;
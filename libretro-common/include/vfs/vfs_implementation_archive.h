@@ -0,0 +1,72 @@
+/* Copyright  (C) 2010-2021 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (vfs_implementation_archive.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_VFS_IMPLEMENTATION_ARCHIVE_H
+#define __LIBRETRO_SDK_VFS_IMPLEMENTATION_ARCHIVE_H
+
+#include <stdint.h>
+
+#include <vfs/vfs.h>
+
+RETRO_BEGIN_DECLS
+
+/* Read-only access to members of zip archives, addressed as
+ * "<archive>.zip#<member>", without extracting them.
+ *
+ * The central directory of an archive is parsed once and kept in
+ * a small process-wide cache, until the archive changes on disk.
+ * Stored members are read directly. For deflated members, seek
+ * points (the decompressor state and the last 32 KiB of output)
+ * are recorded at block boundaries as a member is read, so later
+ * random reads resume from the nearest point instead of from the
+ * start of the member. Seek points are kept with the cached index
+ * and shared by all handles. */
+
+/* Must be called before using archive paths from several threads */
+void retro_vfs_archive_init(void);
+
+/* Must be called upon program termination */
+void retro_vfs_archive_deinit(void);
+
+bool retro_vfs_path_is_archive_member(const char *path);
+
+void retro_vfs_file_open_archive(
+      libretro_vfs_implementation_file *stream,
+      const char *path, unsigned mode, unsigned hints);
+
+int retro_vfs_file_close_archive(libretro_vfs_implementation_file *stream);
+
+int64_t retro_vfs_file_seek_archive(libretro_vfs_implementation_file *stream,
+      int64_t offset, int whence);
+
+int64_t retro_vfs_file_tell_archive(libretro_vfs_implementation_file *stream);
+
+int64_t retro_vfs_file_read_archive(libretro_vfs_implementation_file *stream,
+      void *s, uint64_t len);
+
+int retro_vfs_file_error_archive(libretro_vfs_implementation_file *stream);
+
+int retro_vfs_stat_archive(const char *path, int32_t *size);
+
+RETRO_END_DECLS
+
+#endif
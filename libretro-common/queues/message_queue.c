@@ -26,7 +26,6 @@
 #include <boolean.h>
 #include <queues/message_queue.h>
 #include <compat/strl.h>
-#include <compat/posix_string.h>
 
 bool msg_queue_initialize(msg_queue_t *queue, size_t len)
 {
@@ -35,13 +34,17 @@ bool msg_queue_initialize(msg_queue_t *queue, size_t len)
    if (!queue)
       return false;
 
+   /* The spare elements share the allocation */
    if (!(elems = (struct queue_elem**)
-            calloc(len + 1, sizeof(struct queue_elem*))))
+            calloc(2 * (len + 1), sizeof(struct queue_elem*))))
       return false;
 
    queue->tmp_msg            = NULL;
+   queue->tmp_msg_size       = 0;
    queue->elems              = elems;
+   queue->spare              = elems + len + 1;
    queue->ptr                = 1;
+   queue->spare_ptr          = 0;
    queue->size               = len + 1;
 
    return true;
@@ -70,6 +73,20 @@ msg_queue_t *msg_queue_new(size_t len)
    return queue;
 }
 
+static void msg_queue_free_spare(msg_queue_t *queue)
+{
+   while (queue->spare_ptr)
+   {
+      struct queue_elem *elem = queue->spare[--queue->spare_ptr];
+      free(elem->msg);
+      free(elem->title);
+      free(elem);
+   }
+   free(queue->tmp_msg);
+   queue->tmp_msg      = NULL;
+   queue->tmp_msg_size = 0;
+}
+
 /**
  * msg_queue_free:
  * @queue             : pointer to queue object
@@ -81,6 +98,7 @@ void msg_queue_free(msg_queue_t *queue)
    if (!queue)
       return;
    msg_queue_clear(queue);
+   msg_queue_free_spare(queue);
    free(queue->elems);
    free(queue);
 }
@@ -90,14 +108,42 @@ bool msg_queue_deinitialize(msg_queue_t *queue)
    if (!queue)
       return false;
    msg_queue_clear(queue);
+   msg_queue_free_spare(queue);
    free(queue->elems);
    queue->elems   = NULL;
-   queue->tmp_msg = NULL;
+   queue->spare   = NULL;
    queue->ptr     = 0;
    queue->size    = 0;
    return true;
 }
 
+/* Copies a string into a buffer of an element,
+ * growing it only when it is too small */
+static bool msg_queue_set_str(char **s, size_t *s_size, const char *src)
+{
+   size_t len;
+
+   if (!src)
+   {
+      free(*s);
+      *s      = NULL;
+      *s_size = 0;
+      return true;
+   }
+
+   len = strlen(src) + 1;
+   if (len > *s_size)
+   {
+      char *tmp = (char*)realloc(*s, len);
+      if (!tmp)
+         return false;
+      *s        = tmp;
+      *s_size   = len;
+   }
+   memcpy(*s, src, len);
+   return true;
+}
+
 /**
  * msg_queue_push:
  * @queue             : pointer to queue object
@@ -120,13 +166,21 @@ void msg_queue_push(msg_queue_t *queue, const char *msg,
    if (!queue || queue->ptr >= queue->size)
       return;
 
-   if (!(new_elem = (struct queue_elem*)malloc(sizeof(struct queue_elem))))
+   if (queue->spare_ptr)
+      new_elem = queue->spare[--queue->spare_ptr];
+   else if (!(new_elem = (struct queue_elem*)
+            calloc(1, sizeof(struct queue_elem))))
+      return;
+
+   if (     !msg_queue_set_str(&new_elem->msg, &new_elem->msg_size, msg)
+         || !msg_queue_set_str(&new_elem->title, &new_elem->title_size, title))
+   {
+      queue->spare[queue->spare_ptr++] = new_elem;
       return;
+   }
 
    new_elem->duration            = duration;
    new_elem->prio                = prio;
-   new_elem->msg                 = msg   ? strdup(msg)   : NULL;
-   new_elem->title               = title ? strdup(title) : NULL;
    new_elem->icon                = icon;
    new_elem->category            = category;
 
@@ -166,15 +220,11 @@ void msg_queue_clear(msg_queue_t *queue)
    {
       if (queue->elems[i])
       {
-         free(queue->elems[i]->msg);
-         free(queue->elems[i]->title);
-         free(queue->elems[i]);
+         queue->spare[queue->spare_ptr++] = queue->elems[i];
          queue->elems[i] = NULL;
       }
    }
    queue->ptr     = 1;
-   free(queue->tmp_msg);
-   queue->tmp_msg = NULL;
 }
 
 /**
@@ -200,14 +250,20 @@ const char *msg_queue_pull(msg_queue_t *queue)
    if (front->duration > 0)
       return front->msg;
 
-   free(queue->tmp_msg);
-   queue->tmp_msg = front->msg;
-   front->msg = NULL;
+   /* The pulled message stays valid until the next pull,
+    * the element gets the buffer it replaces */
+   {
+      char *tmp_msg       = queue->tmp_msg;
+      size_t tmp_msg_size = queue->tmp_msg_size;
+      queue->tmp_msg      = front->msg;
+      queue->tmp_msg_size = front->msg_size;
+      front->msg          = tmp_msg;
+      front->msg_size     = tmp_msg_size;
+   }
 
    last  = (struct queue_elem*)queue->elems[--queue->ptr];
    queue->elems[1] = last;
-   free(front->title);
-   free(front);
+   queue->spare[queue->spare_ptr++] = front;
 
    for (;;)
    {
@@ -283,10 +339,8 @@ bool msg_queue_extract(msg_queue_t *queue, msg_queue_entry_t *queue_entry)
    if (front->title)
       strlcpy(queue_entry->title, front->title, sizeof(queue_entry->title));
 
-   /* Delete element */
-   free(front->msg);
-   free(front->title);
-   free(front);
+   /* Recycle element */
+   queue->spare[queue->spare_ptr++] = front;
 
    for (;;)
    {
@@ -490,6 +490,8 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
 
 static void threaded_worker(void *userdata)
 {
+   sthread_role_apply(STHREAD_ROLE_TASK);
+
    for (;;)
    {
       retro_task_t *task  = NULL;
@@ -20,6 +20,10 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* CPU_SET(), syscall() */
+#endif
+
 #ifdef __unix__
 #ifndef __sun__
 #ifndef _POSIX_C_SOURCE
@@ -71,10 +75,24 @@
 #include <mach/mach.h>
 #endif
 
+#if !defined(USE_WIN32_THREADS) && (defined(__linux__) || defined(__APPLE__))
+#define HAVE_THREAD_RT_SCHED
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__) && !defined(USE_WIN32_THREADS)
+#define HAVE_THREAD_ROLE_LINUX
+#include <sched.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
 struct thread_data
 {
    void (*func)(void*);
    void *userdata;
+   bool role_reset;
 };
 
 struct sthread
@@ -138,6 +156,8 @@ struct scond
 #endif
 };
 
+static void sthread_role_reset(void);
+
 #ifdef USE_WIN32_THREADS
 static DWORD CALLBACK thread_wrap(void *data_)
 #else
@@ -147,6 +167,9 @@ static void *thread_wrap(void *data_)
    struct thread_data *data = (struct thread_data*)data_;
    if (!data)
 	   return 0;
+   /* Do not inherit the role of the creating thread */
+   if (data->role_reset)
+      sthread_role_reset();
    data->func(data->userdata);
    free(data);
    return 0;
@@ -183,6 +206,7 @@ sthread_t *sthread_create_with_priority(void (*thread_func)(void*), void *userda
 
    data->func               = thread_func;
    data->userdata           = userdata;
+   data->role_reset         = thread_priority == 0;
 
    thread->id               = 0;
 #ifdef USE_WIN32_THREADS
@@ -809,3 +833,284 @@ uintptr_t sthread_get_current_thread_id(void)
    return (uintptr_t)pthread_self();
 #endif
 }
+
+/* Thread roles.
+ *
+ * The settings of each role are written before the threads of the
+ * role are created, and only read afterwards. The defaults are those
+ * of the thread that configures the roles first, recorded before any
+ * role is applied. */
+static struct sthread_role_config sthread_role_configs[STHREAD_ROLE_LAST];
+static bool sthread_role_configured[STHREAD_ROLE_LAST];
+
+static struct
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(CPU_SET)
+   cpu_set_t cpus;
+   bool cpus_valid;
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   DWORD_PTR cpus;
+   int priority;
+#endif
+#if defined(HAVE_THREAD_ROLE_LINUX)
+   int nice_value;
+   int timer_slack;
+#endif
+#if defined(HAVE_THREAD_RT_SCHED)
+   struct sched_param param;
+   int policy;
+   bool sched_valid;
+#endif
+   bool saved;
+} sthread_role_defaults;
+
+static void sthread_role_save_defaults(void)
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(CPU_SET)
+   CPU_ZERO(&sthread_role_defaults.cpus);
+   sthread_role_defaults.cpus_valid = sched_getaffinity(0,
+         sizeof(sthread_role_defaults.cpus),
+         &sthread_role_defaults.cpus) == 0;
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   {
+      DWORD_PTR system_cpus           = 0;
+      if (!GetProcessAffinityMask(GetCurrentProcess(),
+               &sthread_role_defaults.cpus, &system_cpus))
+         sthread_role_defaults.cpus   = 0;
+      sthread_role_defaults.priority  = GetThreadPriority(GetCurrentThread());
+   }
+#endif
+#if defined(HAVE_THREAD_ROLE_LINUX)
+   /* -1 is a valid nice value, so a failure leaves 0 behind */
+   sthread_role_defaults.nice_value   = getpriority(PRIO_PROCESS,
+         (id_t)syscall(SYS_gettid));
+   if (     sthread_role_defaults.nice_value < -20
+         || sthread_role_defaults.nice_value > 19)
+      sthread_role_defaults.nice_value = 0;
+#if defined(PR_GET_TIMERSLACK)
+   sthread_role_defaults.timer_slack  = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+#endif
+#endif
+#if defined(HAVE_THREAD_RT_SCHED)
+   sthread_role_defaults.sched_valid  = pthread_getschedparam(pthread_self(),
+         &sthread_role_defaults.policy, &sthread_role_defaults.param) == 0;
+#endif
+   sthread_role_defaults.saved        = true;
+}
+
+static void sthread_role_reset_affinity(void)
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(CPU_SET)
+   if (sthread_role_defaults.cpus_valid)
+      sched_setaffinity(0, sizeof(sthread_role_defaults.cpus),
+            &sthread_role_defaults.cpus);
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   if (sthread_role_defaults.cpus)
+      SetThreadAffinityMask(GetCurrentThread(), sthread_role_defaults.cpus);
+#endif
+}
+
+static void sthread_role_reset_sched(void)
+{
+#if defined(HAVE_THREAD_RT_SCHED)
+   /* Leaving a real-time policy is always allowed */
+   if (sthread_role_defaults.sched_valid)
+      pthread_setschedparam(pthread_self(), sthread_role_defaults.policy,
+            &sthread_role_defaults.param);
+#endif
+#if defined(HAVE_THREAD_ROLE_LINUX)
+   setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid),
+         sthread_role_defaults.nice_value);
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   if (sthread_role_defaults.priority != THREAD_PRIORITY_ERROR_RETURN)
+      SetThreadPriority(GetCurrentThread(), sthread_role_defaults.priority);
+#endif
+}
+
+static void sthread_role_reset_timer_slack(void)
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(PR_SET_TIMERSLACK)
+   if (sthread_role_defaults.timer_slack > 0)
+      prctl(PR_SET_TIMERSLACK,
+            (unsigned long)sthread_role_defaults.timer_slack, 0, 0, 0);
+#endif
+}
+
+/* Brings a new thread back to the defaults, since it inherits
+ * the affinity and scheduling of the thread that created it.
+ * Nothing to undo while no role is configured. */
+static void sthread_role_reset(void)
+{
+   unsigned i;
+
+   if (!sthread_role_defaults.saved)
+      return;
+
+   for (i = 0; i < STHREAD_ROLE_LAST; i++)
+   {
+      if (sthread_role_configured[i])
+      {
+         sthread_role_restore();
+         return;
+      }
+   }
+}
+
+void sthread_role_set_config(enum sthread_role role,
+      const struct sthread_role_config *config)
+{
+   if ((unsigned)role >= STHREAD_ROLE_LAST)
+      return;
+   if (!sthread_role_defaults.saved)
+      sthread_role_save_defaults();
+   if (config)
+      sthread_role_configs[role]  = *config;
+   sthread_role_configured[role]  = !!config;
+}
+
+void sthread_role_restore(void)
+{
+   if (!sthread_role_defaults.saved)
+      return;
+   sthread_role_reset_sched();
+   sthread_role_reset_affinity();
+   sthread_role_reset_timer_slack();
+}
+
+static bool sthread_set_affinity(uint64_t cpu_mask)
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(CPU_SET)
+   unsigned i;
+   cpu_set_t set;
+
+   CPU_ZERO(&set);
+   for (i = 0; i < 64 && i < CPU_SETSIZE; i++)
+      if (cpu_mask & ((uint64_t)1 << i))
+         CPU_SET(i, &set);
+   /* Applies to the calling thread only */
+   return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   DWORD_PTR mask = (DWORD_PTR)cpu_mask;
+   return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+   return false;
+#endif
+}
+
+static bool sthread_set_nice(int nice_value)
+{
+   if (nice_value < -20)
+      nice_value = -20;
+   else if (nice_value > 19)
+      nice_value = 19;
+#if defined(HAVE_THREAD_ROLE_LINUX)
+   /* Nice values are per thread on Linux */
+   return setpriority(PRIO_PROCESS,
+         (id_t)syscall(SYS_gettid), nice_value) == 0;
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   {
+      int priority = THREAD_PRIORITY_NORMAL;
+      if (nice_value <= -10)
+         priority  = THREAD_PRIORITY_HIGHEST;
+      else if (nice_value < 0)
+         priority  = THREAD_PRIORITY_ABOVE_NORMAL;
+      else if (nice_value >= 10)
+         priority  = THREAD_PRIORITY_LOWEST;
+      else if (nice_value > 0)
+         priority  = THREAD_PRIORITY_BELOW_NORMAL;
+      return SetThreadPriority(GetCurrentThread(), priority) != 0;
+   }
+#else
+   return false;
+#endif
+}
+
+static bool sthread_set_realtime(bool fifo, int priority)
+{
+#if defined(HAVE_THREAD_RT_SCHED)
+   struct sched_param sp;
+   int policy = fifo ? SCHED_FIFO : SCHED_RR;
+   int min    = sched_get_priority_min(policy);
+   int max    = sched_get_priority_max(policy);
+#ifdef RLIMIT_RTPRIO
+   struct rlimit limit;
+
+   /* Unprivileged processes may use priorities up to the soft limit */
+   if (     getrlimit(RLIMIT_RTPRIO, &limit) == 0
+         && limit.rlim_cur != RLIM_INFINITY
+         && limit.rlim_cur > 0
+         && (rlim_t)priority > limit.rlim_cur)
+      priority = (int)limit.rlim_cur;
+#endif
+
+   if (priority < min)
+      priority = min;
+   else if (priority > max)
+      priority = max;
+
+   memset(&sp, 0, sizeof(sp));
+   sp.sched_priority = priority;
+   return pthread_setschedparam(pthread_self(), policy, &sp) == 0;
+#elif defined(USE_WIN32_THREADS) && !defined(_XBOX) && !defined(__WINRT__)
+   return SetThreadPriority(GetCurrentThread(), priority >= 50
+         ? THREAD_PRIORITY_TIME_CRITICAL
+         : THREAD_PRIORITY_HIGHEST) != 0;
+#else
+   return false;
+#endif
+}
+
+static bool sthread_set_timer_slack(unsigned slack_ns)
+{
+#if defined(HAVE_THREAD_ROLE_LINUX) && defined(PR_SET_TIMERSLACK)
+   return prctl(PR_SET_TIMERSLACK, (unsigned long)slack_ns, 0, 0, 0) == 0;
+#else
+   return false;
+#endif
+}
+
+unsigned sthread_role_apply(enum sthread_role role)
+{
+   unsigned flags = 0;
+   const struct sthread_role_config *config;
+
+   if ((unsigned)role >= STHREAD_ROLE_LAST || !sthread_role_configured[role])
+      return 0;
+
+   config = &sthread_role_configs[role];
+
+   /* What the role leaves unset goes back to the defaults,
+    * rather than staying as inherited from the creating thread */
+   if (!config->cpu_mask)
+      sthread_role_reset_affinity();
+   else if (sthread_set_affinity(config->cpu_mask))
+      flags |= STHREAD_ROLE_FLAG_AFFINITY;
+
+   sthread_role_reset_sched();
+
+   switch (config->sched)
+   {
+      case STHREAD_SCHED_NICE:
+         if (sthread_set_nice(config->priority))
+            flags |= STHREAD_ROLE_FLAG_SCHED;
+         break;
+      case STHREAD_SCHED_FIFO:
+      case STHREAD_SCHED_RR:
+         /* Usually refused without CAP_SYS_NICE or RLIMIT_RTPRIO */
+         if (sthread_set_realtime(config->sched == STHREAD_SCHED_FIFO,
+                  config->priority))
+            flags |= STHREAD_ROLE_FLAG_SCHED;
+         else if (sthread_set_nice(config->fallback_nice))
+            flags |= STHREAD_ROLE_FLAG_SCHED_FALLBACK;
+         break;
+      default:
+         break;
+   }
+
+   if (!config->timer_slack_ns)
+      sthread_role_reset_timer_slack();
+   else if (sthread_set_timer_slack(config->timer_slack_ns))
+      flags |= STHREAD_ROLE_FLAG_TIMER_SLACK;
+
+   return flags;
+}
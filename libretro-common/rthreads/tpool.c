@@ -25,9 +25,20 @@
  * THE SOFTWARE
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* CPU_SET() */
+#endif
+
 #include <stdlib.h>
+#include <stdint.h>
 #include <boolean.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#endif
+
 #include <rthreads/rthreads.h>
 #include <rthreads/tpool.h>
 
@@ -257,8 +268,11 @@ void tpool_wait(tpool_t *tp)
    {
       /* working_cond is dual use. It signals when we're not stopping but the
        * working_cnt is 0 indicating there isn't any work processing. If we
-       * are stopping it will trigger when there aren't any threads running. */
-      if ((!tp->stop && tp->working_cnt != 0) || (tp->stop && tp->thread_cnt != 0))
+       * are stopping it will trigger when there aren't any threads running.
+       * Work still in the queue counts as processing, it may not have been
+       * picked up by any thread yet. */
+      if (     (!tp->stop && (tp->working_cnt != 0 || tp->work_first))
+            || (tp->stop && tp->thread_cnt != 0))
          scond_wait(tp->working_cond, tp->work_mutex);
       else
          break;
@@ -266,3 +280,334 @@ void tpool_wait(tpool_t *tp)
 
    slock_unlock(tp->work_mutex);
 }
+
+/* Fork-join pool.
+ *
+ * The state of the current job is packed into one 32-bit word, the
+ * generation of the job in the high half and the number of chunks
+ * left to claim in the low half, so a worker that is late for a job
+ * can never claim a chunk of the next one. Completion is tracked in
+ * chunks, so the caller never waits for workers that did not take
+ * part in a job. */
+
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define TPOOL_HAVE_ATOMICS 1
+typedef uint32_t tpool_atomic_t;
+#define TPOOL_LOAD(p)        __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define TPOOL_STORE(p, v)    __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define TPOOL_ADD(p, v)      __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define TPOOL_CAS(p, o, n)   __sync_bool_compare_and_swap((p), (o), (n))
+#elif defined(__GNUC__)
+#define TPOOL_HAVE_ATOMICS 1
+typedef uint32_t tpool_atomic_t;
+#define TPOOL_LOAD(p)        __sync_add_and_fetch((p), 0)
+#define TPOOL_STORE(p, v)    do { __sync_synchronize(); *(p) = (v); __sync_synchronize(); } while (0)
+#define TPOOL_ADD(p, v)      __sync_add_and_fetch((p), (v))
+#define TPOOL_CAS(p, o, n)   __sync_bool_compare_and_swap((p), (o), (n))
+#elif defined(_MSC_VER)
+#define TPOOL_HAVE_ATOMICS 1
+typedef LONG tpool_atomic_t;
+#define TPOOL_LOAD(p)        ((uint32_t)InterlockedCompareExchange((p), 0, 0))
+#define TPOOL_STORE(p, v)    InterlockedExchange((p), (LONG)(v))
+#define TPOOL_ADD(p, v)      ((uint32_t)InterlockedExchangeAdd((p), (LONG)(v)) + (uint32_t)(v))
+#define TPOOL_CAS(p, o, n)   (InterlockedCompareExchange((p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#define TPOOL_RELAX() __asm__ __volatile__("pause")
+#elif defined(_MSC_VER)
+#define TPOOL_RELAX() YieldProcessor()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#define TPOOL_RELAX() __asm__ __volatile__("yield")
+#else
+#define TPOOL_RELAX() ((void)0)
+#endif
+
+#define TPOOL_CHUNK_BITS  16
+#define TPOOL_CHUNK_MASK  ((1u << TPOOL_CHUNK_BITS) - 1)
+#define TPOOL_MAX_CHUNKS  TPOOL_CHUNK_MASK
+/* Chunks per thread when the caller does not pick a grain */
+#define TPOOL_AUTO_CHUNKS 4
+
+struct tpool_parallel;
+
+struct tpool_parallel_worker
+{
+   struct tpool_parallel *pp;
+   sthread_t             *thread;
+   unsigned               index;
+   int                    cpu;
+};
+
+struct tpool_parallel
+{
+   struct tpool_parallel_worker *workers;
+   slock_t            *park_mutex; /* Protects parking and stop. */
+   scond_t            *park_cond;  /* Signalled when a job is issued or on stop. */
+
+   /* Current job, only written by the caller between jobs. */
+   tpool_range_func_t  func;
+   void               *userdata;
+   size_t              count;
+   size_t              grain;
+   uint32_t            chunks;
+
+#ifdef TPOOL_HAVE_ATOMICS
+   tpool_atomic_t      state;      /* Generation << TPOOL_CHUNK_BITS | chunks left. */
+   tpool_atomic_t      done;       /* Chunks of the current job completed. */
+   tpool_atomic_t      parked;     /* Workers waiting on park_cond. */
+#endif
+   uint32_t            generation;
+   unsigned            num_workers;
+   unsigned            spin;
+   volatile bool       stop;
+};
+
+static void tpool_parallel_yield(void)
+{
+#if defined(_WIN32)
+   SwitchToThread();
+#elif defined(__unix__) || defined(__APPLE__)
+   sched_yield();
+#endif
+}
+
+static void tpool_parallel_pin(int cpu)
+{
+   if (cpu < 0)
+      return;
+#if defined(__linux__) && defined(CPU_SET)
+   {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      sched_setaffinity(0, sizeof(set), &set);
+   }
+#elif defined(_WIN32) && !defined(__WINRT__) && !defined(_XBOX)
+   if (cpu < (int)(sizeof(DWORD_PTR) * 8))
+      SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#endif
+}
+
+#ifdef TPOOL_HAVE_ATOMICS
+/* Claim and process chunks of the job of generation @gen until
+ * there are none left. The job fields are only rewritten once all
+ * of its chunks are done, so whenever a claim succeeds, the fields
+ * read after seeing @gen were those of the job. */
+static void tpool_parallel_run(tpool_parallel_t *pp, uint32_t gen,
+      unsigned worker)
+{
+   tpool_range_func_t func = pp->func;
+   void *userdata          = pp->userdata;
+   size_t count            = pp->count;
+   size_t grain            = pp->grain;
+   uint32_t chunks         = pp->chunks;
+
+   for (;;)
+   {
+      size_t begin, end;
+      uint32_t state = TPOOL_LOAD(&pp->state);
+      uint32_t left  = state & TPOOL_CHUNK_MASK;
+
+      if ((state >> TPOOL_CHUNK_BITS) != gen || left == 0)
+         break;
+      if (!TPOOL_CAS(&pp->state, state, state - 1))
+         continue;
+
+      begin = (size_t)(chunks - left) * grain;
+      end   = begin + grain;
+      if (end > count)
+         end = count;
+      func(userdata, begin, end, worker);
+      TPOOL_ADD(&pp->done, 1);
+   }
+}
+
+static void tpool_parallel_worker(void *arg)
+{
+   struct tpool_parallel_worker *w = (struct tpool_parallel_worker*)arg;
+   tpool_parallel_t *pp            = w->pp;
+   uint32_t last                   = 0;
+
+   tpool_parallel_pin(w->cpu);
+
+   for (;;)
+   {
+      unsigned spins = 0;
+      uint32_t gen;
+
+      /* Spin for a while, then park until the next job. */
+      while ((gen = TPOOL_LOAD(&pp->state) >> TPOOL_CHUNK_BITS) == last)
+      {
+         if (pp->stop)
+            return;
+         if (spins++ < pp->spin)
+         {
+            TPOOL_RELAX();
+            continue;
+         }
+
+         slock_lock(pp->park_mutex);
+         TPOOL_ADD(&pp->parked, 1);
+         while (!pp->stop
+               && (TPOOL_LOAD(&pp->state) >> TPOOL_CHUNK_BITS) == last)
+            scond_wait(pp->park_cond, pp->park_mutex);
+         TPOOL_ADD(&pp->parked, (uint32_t)-1);
+         slock_unlock(pp->park_mutex);
+         spins = 0;
+      }
+
+      tpool_parallel_run(pp, gen, w->index);
+      last = gen;
+   }
+}
+#endif
+
+tpool_parallel_t *tpool_parallel_create(unsigned workers, unsigned spin,
+      const int *cpus)
+{
+#ifdef TPOOL_HAVE_ATOMICS
+   unsigned i;
+#endif
+   tpool_parallel_t *pp = (tpool_parallel_t*)calloc(1, sizeof(*pp));
+
+   if (!pp)
+      return NULL;
+
+   pp->spin = spin;
+
+#ifdef TPOOL_HAVE_ATOMICS
+   if (workers == 0)
+      return pp;
+
+   pp->park_mutex = slock_new();
+   pp->park_cond  = scond_new();
+   pp->workers    = (struct tpool_parallel_worker*)
+      calloc(workers, sizeof(*pp->workers));
+
+   if (!pp->park_mutex || !pp->park_cond || !pp->workers)
+   {
+      tpool_parallel_free(pp);
+      return NULL;
+   }
+
+   for (i = 0; i < workers; i++)
+   {
+      struct tpool_parallel_worker *w = &pp->workers[i];
+
+      w->pp     = pp;
+      w->index  = i + 1;
+      w->cpu    = cpus ? cpus[i] : -1;
+      w->thread = sthread_create(tpool_parallel_worker, w);
+      if (!w->thread)
+         break;
+      pp->num_workers++;
+   }
+#endif
+
+   return pp;
+}
+
+void tpool_parallel_free(tpool_parallel_t *pp)
+{
+   unsigned i;
+
+   if (!pp)
+      return;
+
+   if (pp->park_mutex)
+   {
+      slock_lock(pp->park_mutex);
+      pp->stop = true;
+      if (pp->park_cond)
+         scond_broadcast(pp->park_cond);
+      slock_unlock(pp->park_mutex);
+   }
+
+   for (i = 0; i < pp->num_workers; i++)
+      sthread_join(pp->workers[i].thread);
+
+   if (pp->park_mutex)
+      slock_free(pp->park_mutex);
+   if (pp->park_cond)
+      scond_free(pp->park_cond);
+   free(pp->workers);
+   free(pp);
+}
+
+unsigned tpool_parallel_get_threads(const tpool_parallel_t *pp)
+{
+   return pp ? pp->num_workers + 1 : 1;
+}
+
+void tpool_parallel_for(tpool_parallel_t *pp, size_t count, size_t grain,
+      tpool_range_func_t func, void *userdata)
+{
+#ifdef TPOOL_HAVE_ATOMICS
+   size_t chunks;
+   unsigned spins = 0;
+#endif
+
+   if (!func || count == 0)
+      return;
+
+#ifdef TPOOL_HAVE_ATOMICS
+   if (!pp || pp->num_workers == 0)
+#endif
+   {
+      func(userdata, 0, count, 0);
+      return;
+   }
+
+#ifdef TPOOL_HAVE_ATOMICS
+   if (grain == 0)
+      grain  = count / ((pp->num_workers + 1) * TPOOL_AUTO_CHUNKS);
+   if (grain == 0)
+      grain  = 1;
+   chunks    = (count + grain - 1) / grain;
+   if (chunks > TPOOL_MAX_CHUNKS)
+   {
+      grain  = (count + TPOOL_MAX_CHUNKS - 1) / TPOOL_MAX_CHUNKS;
+      chunks = (count + grain - 1) / grain;
+   }
+
+   if (chunks == 1)
+   {
+      func(userdata, 0, count, 0);
+      return;
+   }
+
+   pp->func       = func;
+   pp->userdata   = userdata;
+   pp->count      = count;
+   pp->grain      = grain;
+   pp->chunks     = (uint32_t)chunks;
+   TPOOL_STORE(&pp->done, 0);
+
+   /* Generation 0 is the state workers start from, skip it so they
+    * never mistake a job for the lack of one. */
+   pp->generation = (pp->generation + 1) & TPOOL_CHUNK_MASK;
+   if (pp->generation == 0)
+      pp->generation = 1;
+   TPOOL_STORE(&pp->state,
+         (pp->generation << TPOOL_CHUNK_BITS) | (uint32_t)chunks);
+
+   if (TPOOL_LOAD(&pp->parked))
+   {
+      slock_lock(pp->park_mutex);
+      scond_broadcast(pp->park_cond);
+      slock_unlock(pp->park_mutex);
+   }
+
+   tpool_parallel_run(pp, pp->generation, 0);
+
+   /* Only chunks claimed by workers can still be running. */
+   while (TPOOL_LOAD(&pp->done) != (uint32_t)chunks)
+   {
+      if (spins++ < pp->spin)
+         TPOOL_RELAX();
+      else
+         tpool_parallel_yield();
+   }
+#endif
+}
@@ -0,0 +1,371 @@
+/* Copyright  (C) 2010-2024 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (trans_stream_zstd.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zstd.h>
+#include <string/stdstring.h>
+#include <streams/trans_stream.h>
+
+struct zstd_trans_stream
+{
+   ZSTD_CCtx *cctx;
+   ZSTD_DCtx *dctx;
+   ZSTD_inBuffer in;
+   ZSTD_outBuffer out;
+   const void *dict;
+   size_t dict_size;
+   int level;
+   int window_log;
+   bool long_distance;
+   bool inited;
+   bool in_frame;
+};
+
+static void *zstd_compress_stream_new(void)
+{
+   struct zstd_trans_stream *ret = (struct zstd_trans_stream*)
+      calloc(1, sizeof(*ret));
+   if (!ret)
+      return NULL;
+   if (!(ret->cctx = ZSTD_createCCtx()))
+   {
+      free(ret);
+      return NULL;
+   }
+   ret->level = ZSTD_CLEVEL_DEFAULT;
+   return (void *)ret;
+}
+
+static void *zstd_decompress_stream_new(void)
+{
+   struct zstd_trans_stream *ret = (struct zstd_trans_stream*)
+      calloc(1, sizeof(*ret));
+   if (!ret)
+      return NULL;
+   if (!(ret->dctx = ZSTD_createDCtx()))
+   {
+      free(ret);
+      return NULL;
+   }
+   return (void *)ret;
+}
+
+static void zstd_stream_free(void *data)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream *) data;
+   if (!z)
+      return;
+   if (z->cctx)
+      ZSTD_freeCCtx(z->cctx);
+   if (z->dctx)
+      ZSTD_freeDCtx(z->dctx);
+   free(z);
+}
+
+static bool zstd_compress_define(void *data, const char *prop, uint32_t val)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream*)data;
+   if (!data)
+      return false;
+
+   if (string_is_equal(prop, "level"))
+   {
+      if ((int)val < ZSTD_minCLevel() || (int)val > ZSTD_maxCLevel())
+         return false;
+      z->level = (int) val;
+   }
+   else if (string_is_equal(prop, "window_log"))
+      z->window_log = (int) val;
+   /* Finds matches far back in large states and dictionaries */
+   else if (string_is_equal(prop, "long_distance"))
+      z->long_distance = val != 0;
+   else
+      return false;
+
+   /* Takes effect with the next frame */
+   z->inited = false;
+   return true;
+}
+
+static bool zstd_decompress_define(void *data, const char *prop, uint32_t val)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream*)data;
+   if (!data)
+      return false;
+
+   /* Largest window we accept from the compressing side */
+   if (string_is_equal(prop, "window_log"))
+   {
+      z->window_log = (int) val;
+      z->inited     = false;
+      return true;
+   }
+   return false;
+}
+
+static bool zstd_compress_init(struct zstd_trans_stream *z)
+{
+   ZSTD_CCtx_reset(z->cctx, ZSTD_reset_session_and_parameters);
+   if (ZSTD_isError(ZSTD_CCtx_setParameter(z->cctx,
+            ZSTD_c_compressionLevel, z->level)))
+      return false;
+   if (z->window_log && ZSTD_isError(ZSTD_CCtx_setParameter(z->cctx,
+            ZSTD_c_windowLog, z->window_log)))
+      return false;
+   if (z->long_distance && ZSTD_isError(ZSTD_CCtx_setParameter(z->cctx,
+            ZSTD_c_enableLongDistanceMatching, 1)))
+      return false;
+   if (     z->dict && ZSTD_getDictID_fromDict(z->dict, z->dict_size)
+         && ZSTD_isError(ZSTD_CCtx_loadDictionary(
+               z->cctx, z->dict, z->dict_size)))
+      return false;
+   z->inited   = true;
+   z->in_frame = false;
+   return true;
+}
+
+static bool zstd_decompress_init(struct zstd_trans_stream *z)
+{
+   ZSTD_DCtx_reset(z->dctx, ZSTD_reset_session_and_parameters);
+   if (z->window_log && ZSTD_isError(ZSTD_DCtx_setParameter(z->dctx,
+            ZSTD_d_windowLogMax, z->window_log)))
+      return false;
+   if (     z->dict && ZSTD_getDictID_fromDict(z->dict, z->dict_size)
+         && ZSTD_isError(ZSTD_DCtx_loadDictionary(
+               z->dctx, z->dict, z->dict_size)))
+      return false;
+   z->inited   = true;
+   z->in_frame = false;
+   return true;
+}
+
+static void zstd_set_in(void *data, const uint8_t *in, uint32_t in_size)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream *) data;
+
+   if (!z)
+      return;
+
+   z->in.src  = in;
+   z->in.size = in_size;
+   z->in.pos  = 0;
+}
+
+static void zstd_set_out(void *data, uint8_t *out, uint32_t out_size)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream *) data;
+
+   if (!z)
+      return;
+
+   z->out.dst  = out;
+   z->out.size = out_size;
+   z->out.pos  = 0;
+}
+
+static bool zstd_compress_trans(
+   void *data, bool flush,
+   uint32_t *rd, uint32_t *wn,
+   enum trans_stream_error *err)
+{
+   size_t zret;
+   bool ret                     = true;
+   size_t pre_in_pos            = 0;
+   size_t pre_out_pos           = 0;
+   struct zstd_trans_stream *zt = (struct zstd_trans_stream *) data;
+
+   if (!zt->inited && !zstd_compress_init(zt))
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_INVALID;
+      return false;
+   }
+
+   /* Raw content dictionaries go in as a prefix, which only lasts one
+    * frame but lets long distance matching see them */
+   if (!zt->in_frame)
+   {
+      if (     zt->dict && !ZSTD_getDictID_fromDict(zt->dict, zt->dict_size)
+            && ZSTD_isError(ZSTD_CCtx_refPrefix(zt->cctx,
+                  zt->dict, zt->dict_size)))
+      {
+         if (err)
+            *err = TRANS_STREAM_ERROR_INVALID;
+         return false;
+      }
+      zt->in_frame = true;
+   }
+
+   pre_in_pos  = zt->in.pos;
+   pre_out_pos = zt->out.pos;
+   zret        = ZSTD_compressStream2(zt->cctx, &zt->out, &zt->in,
+         flush ? ZSTD_e_end : ZSTD_e_continue);
+
+   if (ZSTD_isError(zret))
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_OTHER;
+      /* Start over with the next frame */
+      zt->inited = false;
+      return false;
+   }
+
+   /* With ZSTD_e_end, zero means the frame is complete. Otherwise it's
+    * only a hint, and any input left over needs another call. */
+   if (flush && zret == 0)
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_NONE;
+   }
+   else if (zt->out.pos == zt->out.size
+         && (zt->in.pos != zt->in.size || flush))
+   {
+      /* Filled buffer */
+      ret = false;
+      if (err)
+         *err = TRANS_STREAM_ERROR_BUFFER_FULL;
+   }
+   else if (err)
+      *err = TRANS_STREAM_ERROR_AGAIN;
+
+   *rd = (uint32_t)(zt->in.pos  - pre_in_pos);
+   *wn = (uint32_t)(zt->out.pos - pre_out_pos);
+
+   /* Parameters and a trained dictionary stay loaded for the next frame */
+   if (flush && zret == 0)
+   {
+      ZSTD_CCtx_reset(zt->cctx, ZSTD_reset_session_only);
+      zt->in_frame = false;
+   }
+
+   return ret;
+}
+
+static bool zstd_decompress_trans(
+   void *data, bool flush,
+   uint32_t *rd, uint32_t *wn,
+   enum trans_stream_error *err)
+{
+   size_t zret;
+   bool ret                     = true;
+   size_t pre_in_pos            = 0;
+   size_t pre_out_pos           = 0;
+   struct zstd_trans_stream *zt = (struct zstd_trans_stream *) data;
+
+   if (!zt->inited && !zstd_decompress_init(zt))
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_INVALID;
+      return false;
+   }
+
+   if (!zt->in_frame)
+   {
+      if (     zt->dict && !ZSTD_getDictID_fromDict(zt->dict, zt->dict_size)
+            && ZSTD_isError(ZSTD_DCtx_refPrefix(zt->dctx,
+                  zt->dict, zt->dict_size)))
+      {
+         if (err)
+            *err = TRANS_STREAM_ERROR_INVALID;
+         return false;
+      }
+      zt->in_frame = true;
+   }
+
+   pre_in_pos  = zt->in.pos;
+   pre_out_pos = zt->out.pos;
+   zret        = ZSTD_decompressStream(zt->dctx, &zt->out, &zt->in);
+
+   if (ZSTD_isError(zret))
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_OTHER;
+      zt->inited = false;
+      return false;
+   }
+
+   if (zret == 0)
+   {
+      zt->in_frame = false;
+      if (err)
+         *err = TRANS_STREAM_ERROR_NONE;
+   }
+   else if (zt->out.pos == zt->out.size)
+   {
+      /* Filled buffer, there may be more to come */
+      ret = false;
+      if (err)
+         *err = TRANS_STREAM_ERROR_BUFFER_FULL;
+   }
+   else if (flush)
+   {
+      /* Asked to finish a frame we don't have all of */
+      ret        = false;
+      zt->inited = false;
+      if (err)
+         *err = TRANS_STREAM_ERROR_INVALID;
+   }
+   else if (err)
+      *err = TRANS_STREAM_ERROR_AGAIN;
+
+   *rd = (uint32_t)(zt->in.pos  - pre_in_pos);
+   *wn = (uint32_t)(zt->out.pos - pre_out_pos);
+
+   return ret;
+}
+
+bool trans_stream_zstd_set_dictionary(void *data,
+      const void *dict, size_t dict_size)
+{
+   struct zstd_trans_stream *z = (struct zstd_trans_stream *) data;
+   if (!z)
+      return false;
+   z->dict      = dict_size ? dict : NULL;
+   z->dict_size = dict_size;
+   z->inited    = false;
+   return true;
+}
+
+const struct trans_stream_backend zstd_compress_backend = {
+   "zstd_compress",
+   &zstd_decompress_backend,
+   zstd_compress_stream_new,
+   zstd_stream_free,
+   zstd_compress_define,
+   zstd_set_in,
+   zstd_set_out,
+   zstd_compress_trans
+};
+
+const struct trans_stream_backend zstd_decompress_backend = {
+   "zstd_decompress",
+   &zstd_compress_backend,
+   zstd_decompress_stream_new,
+   zstd_stream_free,
+   zstd_decompress_define,
+   zstd_set_in,
+   zstd_set_out,
+   zstd_decompress_trans
+};
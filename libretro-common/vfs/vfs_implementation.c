@@ -217,6 +217,10 @@
 #include <vfs/vfs_implementation_saf.h>
 #endif
 
+#ifdef HAVE_VFS_ARCHIVE
+#include <vfs/vfs_implementation_archive.h>
+#endif
+
 #if (defined(_POSIX_C_SOURCE) && (_POSIX_C_SOURCE - 0) >= 200112) || (defined(__POSIX_VISIBLE) && __POSIX_VISIBLE >= 200112) || (defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112) || __USE_LARGEFILE || (defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS == 64)
 #ifndef HAVE_64BIT_OFFSETS
 #define HAVE_64BIT_OFFSETS
@@ -240,6 +244,10 @@ int64_t retro_vfs_file_seek_internal(
       if (stream->scheme == VFS_SCHEME_CDROM)
          return retro_vfs_file_seek_cdrom(stream, offset, whence);
 #endif
+#ifdef HAVE_VFS_ARCHIVE
+      if (stream->scheme == VFS_SCHEME_ARCHIVE)
+         return retro_vfs_file_seek_archive(stream, offset, whence);
+#endif
 #ifdef ATLEAST_VC2005
       /* VC2005 and up have a special 64-bit fseek */
       return _fseeki64(stream->fp, offset, whence);
@@ -331,6 +339,9 @@ libretro_vfs_implementation_file *retro_vfs_file_open_impl(
    stream->mapsize                = 0;
    stream->mapped                 = NULL;
    stream->scheme                 = VFS_SCHEME_NONE;
+#ifdef HAVE_VFS_ARCHIVE
+   stream->archive                = NULL;
+#endif
 
 #ifdef VFS_FRONTEND
    if (     path
@@ -401,6 +412,19 @@ libretro_vfs_implementation_file *retro_vfs_file_open_impl(
 #endif
       stream->hints &= ~RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS;
 
+#ifdef HAVE_VFS_ARCHIVE
+   /* Members of zip archives are read in place */
+   if (     path
+         && mode == RETRO_VFS_FILE_ACCESS_READ
+         && stream->scheme == VFS_SCHEME_NONE
+         && retro_vfs_path_is_archive_member(path))
+   {
+      stream->scheme  = VFS_SCHEME_ARCHIVE;
+      stream->hints  &= ~(RFILE_HINT_UNBUFFERED
+            | RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS);
+   }
+#endif
+
    switch (mode)
    {
       case RETRO_VFS_FILE_ACCESS_READ:
@@ -467,6 +491,14 @@ libretro_vfs_implementation_file *retro_vfs_file_open_impl(
             break;
 #endif
 
+#ifdef HAVE_VFS_ARCHIVE
+         case VFS_SCHEME_ARCHIVE:
+            retro_vfs_file_open_archive(stream, path, mode, hints);
+            if (!stream->archive)
+               goto error;
+            break;
+#endif
+
 #if defined(ANDROID) && defined(HAVE_SAF)
          case VFS_SCHEME_SAF:
             {
@@ -598,6 +630,11 @@ libretro_vfs_implementation_file *retro_vfs_file_open_impl(
       }
 #endif
    }
+#ifdef HAVE_VFS_ARCHIVE
+   /* Size is known from the central directory */
+   if (stream->scheme == VFS_SCHEME_ARCHIVE)
+      return stream;
+#endif
 #ifdef HAVE_CDROM
    if (stream->scheme == VFS_SCHEME_CDROM)
    {
@@ -637,6 +674,10 @@ int retro_vfs_file_close_impl(libretro_vfs_implementation_file *stream)
       goto end;
    }
 #endif
+#ifdef HAVE_VFS_ARCHIVE
+   if (stream->archive)
+      retro_vfs_file_close_archive(stream);
+#endif
 
    if ((stream->hints & RFILE_HINT_UNBUFFERED) == 0)
    {
@@ -674,6 +715,10 @@ int retro_vfs_file_error_impl(libretro_vfs_implementation_file *stream)
 #ifdef HAVE_CDROM
    if (stream->scheme == VFS_SCHEME_CDROM)
       return retro_vfs_file_error_cdrom(stream);
+#endif
+#ifdef HAVE_VFS_ARCHIVE
+   if (stream->scheme == VFS_SCHEME_ARCHIVE)
+      return retro_vfs_file_error_archive(stream);
 #endif
    return ferror(stream->fp);
 }
@@ -687,6 +732,11 @@ int64_t retro_vfs_file_size_impl(libretro_vfs_implementation_file *stream)
 
 int64_t retro_vfs_file_truncate_impl(libretro_vfs_implementation_file *stream, int64_t len)
 {
+#ifdef HAVE_VFS_ARCHIVE
+   /* Archive members are read-only */
+   if (stream && stream->scheme == VFS_SCHEME_ARCHIVE)
+      return -1;
+#endif
 #ifdef _WIN32
    if (stream && _chsize(_fileno(stream->fp), len) == 0)
    {
@@ -716,6 +766,10 @@ int64_t retro_vfs_file_tell_impl(libretro_vfs_implementation_file *stream)
       if (stream->scheme == VFS_SCHEME_CDROM)
          return retro_vfs_file_tell_cdrom(stream);
 #endif
+#ifdef HAVE_VFS_ARCHIVE
+      if (stream->scheme == VFS_SCHEME_ARCHIVE)
+         return retro_vfs_file_tell_archive(stream);
+#endif
 #ifdef ATLEAST_VC2005
       /* VC2005 and up have a special 64-bit ftell */
       return _ftelli64(stream->fp);
@@ -755,6 +809,10 @@ int64_t retro_vfs_file_read_impl(libretro_vfs_implementation_file *stream,
 #ifdef HAVE_CDROM
       if (stream->scheme == VFS_SCHEME_CDROM)
          return retro_vfs_file_read_cdrom(stream, s, len);
+#endif
+#ifdef HAVE_VFS_ARCHIVE
+      if (stream->scheme == VFS_SCHEME_ARCHIVE)
+         return retro_vfs_file_read_archive(stream, s, len);
 #endif
       return fread(s, 1, (size_t)len, stream->fp);
    }
@@ -785,6 +843,12 @@ int64_t retro_vfs_file_write_impl(libretro_vfs_implementation_file *stream, cons
    if (!stream)
       return -1;
 
+#ifdef HAVE_VFS_ARCHIVE
+   /* Archive members are read-only */
+   if (stream->scheme == VFS_SCHEME_ARCHIVE)
+      return -1;
+#endif
+
    if ((stream->hints & RFILE_HINT_UNBUFFERED) == 0)
    {
       pos = retro_vfs_file_tell_impl(stream);
@@ -811,6 +875,11 @@ int64_t retro_vfs_file_write_impl(libretro_vfs_implementation_file *stream, cons
 
 int retro_vfs_file_flush_impl(libretro_vfs_implementation_file *stream)
 {
+#ifdef HAVE_VFS_ARCHIVE
+   /* Archive members are read-only */
+   if (stream && stream->scheme == VFS_SCHEME_ARCHIVE)
+      return -1;
+#endif
    if (stream && fflush(stream->fp) == 0)
       return 0;
    return -1;
@@ -984,6 +1053,11 @@ int retro_vfs_stat_impl(const char *path, int32_t *size)
    if (!path || !*path)
       return 0;
 
+#ifdef HAVE_VFS_ARCHIVE
+   if (retro_vfs_path_is_archive_member(path))
+      return retro_vfs_stat_archive(path, size);
+#endif
+
 #if defined(ANDROID) && defined(HAVE_SAF)
    if (path[0] == 's'
          && path[1] == 'a'
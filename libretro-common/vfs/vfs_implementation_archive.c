@@ -0,0 +1,979 @@
+/* Copyright  (C) 2010-2021 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (vfs_implementation_archive.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libretro.h>
+#include <retro_miscellaneous.h>
+#include <array/rhmap.h>
+#include <file/file_path.h>
+#include <string/stdstring.h>
+#include <vfs/vfs_implementation.h>
+#include <vfs/vfs_implementation_archive.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include <zlib.h>
+
+#define VFS_ARCHIVE_WINDOW      32768
+#define VFS_ARCHIVE_CHUNK       65536
+/* Seek points are at least this far apart... */
+#define VFS_ARCHIVE_MIN_SPAN    (1 << 20)
+/* ...and at most this many are kept per member */
+#define VFS_ARCHIVE_MAX_POINTS  256
+#define VFS_ARCHIVE_MAX_INDEXES 8
+
+#define VFS_ARCHIVE_LOCAL_SIG   0x04034b50
+#define VFS_ARCHIVE_CENTRAL_SIG 0x02014b50
+#define VFS_ARCHIVE_EOCD_SIG    0x06054b50
+#define VFS_ARCHIVE_EOCD64_SIG  0x06064b50
+#define VFS_ARCHIVE_LOC64_SIG   0x07064b50
+
+struct vfs_archive_point
+{
+   uint64_t out;    /* Offset in the member */
+   uint64_t in;     /* Offset of the next compressed byte */
+   uint8_t *window; /* Last 32 KiB of output before 'out' */
+   int bits;        /* Unused bits of the byte before 'in' */
+};
+
+struct vfs_archive_entry
+{
+   struct vfs_archive_point *points;
+   uint64_t size;
+   uint64_t comp_size;
+   uint64_t header_offset;
+   uint64_t span;
+   int64_t data_offset; /* -1 until the local header is read */
+   size_t num_points;
+   unsigned method;
+};
+
+struct vfs_archive_index
+{
+   char *path;
+   struct vfs_archive_entry *entries;
+   struct vfs_archive_entry **map; /* rhmap, member name to entry */
+   int64_t file_size;
+   int64_t file_stamp;
+   size_t num_entries;
+   unsigned refs;
+   unsigned last_use;
+   bool cached;
+};
+
+struct vfs_archive_stream
+{
+   z_stream zs;
+   uint8_t window[VFS_ARCHIVE_WINDOW];
+   uint8_t in[VFS_ARCHIVE_CHUNK];
+   struct vfs_archive_index *index;
+   struct vfs_archive_entry *entry;
+   libretro_vfs_implementation_file *file; /* The archive itself */
+   uint64_t pos;        /* Read position */
+   uint64_t out;        /* Decompressor position */
+   uint64_t in_pos;     /* Compressed bytes handed to the decompressor */
+   uint64_t next_point; /* Output position of the next seek point */
+   uint64_t data_offset;
+   size_t win_pos;
+   bool zs_init;
+   bool error;
+};
+
+/* TODO/FIXME - static globals */
+static struct vfs_archive_index *vfs_archive_indexes[VFS_ARCHIVE_MAX_INDEXES];
+static unsigned vfs_archive_clock = 0;
+static bool vfs_archive_inited    = false;
+#ifdef HAVE_THREADS
+static slock_t *vfs_archive_lock  = NULL;
+#endif
+
+static void vfs_archive_lock_acquire(void)
+{
+#ifdef HAVE_THREADS
+   if (vfs_archive_lock)
+      slock_lock(vfs_archive_lock);
+#endif
+}
+
+static void vfs_archive_lock_release(void)
+{
+#ifdef HAVE_THREADS
+   if (vfs_archive_lock)
+      slock_unlock(vfs_archive_lock);
+#endif
+}
+
+static uint16_t vfs_archive_le16(const uint8_t *p)
+{
+   return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t vfs_archive_le32(const uint8_t *p)
+{
+   return (uint32_t)p[0]         | ((uint32_t)p[1] << 8)
+       | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t vfs_archive_le64(const uint8_t *p)
+{
+   return (uint64_t)vfs_archive_le32(p)
+       | ((uint64_t)vfs_archive_le32(p + 4) << 32);
+}
+
+static bool vfs_archive_read_at(libretro_vfs_implementation_file *file,
+      uint64_t offset, void *s, uint64_t len)
+{
+   if (retro_vfs_file_seek_impl(file, (int64_t)offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return false;
+   return retro_vfs_file_read_impl(file, s, len) == (int64_t)len;
+}
+
+/* Splits "<archive>.zip#<member>" into its parts. 7z archives
+ * are not handled: LZMA state is as large as the dictionary,
+ * which makes seek points impractical, and solid archives
+ * would have to be decompressed from the start of a block. */
+static const char *vfs_archive_split(const char *path,
+      char *archive, size_t archive_len)
+{
+   const char *delim = path_get_archive_delim(path);
+   size_t _len;
+
+   if (!delim || !delim[1])
+      return NULL;
+
+   _len = (size_t)(delim - path);
+   if (_len >= archive_len)
+      return NULL;
+
+   memcpy(archive, path, _len);
+   archive[_len] = '\0';
+
+   if (string_is_equal_noncase(path_get_extension(archive), "7z"))
+      return NULL;
+
+   return delim + 1;
+}
+
+bool retro_vfs_path_is_archive_member(const char *path)
+{
+   char archive[PATH_MAX_LENGTH];
+   return path && vfs_archive_split(path, archive, sizeof(archive)) != NULL;
+}
+
+static void vfs_archive_index_free(struct vfs_archive_index *index)
+{
+   if (index->entries)
+   {
+      size_t i;
+      for (i = 0; i < index->num_entries; i++)
+      {
+         size_t j;
+         for (j = 0; j < index->entries[i].num_points; j++)
+            free(index->entries[i].points[j].window);
+         free(index->entries[i].points);
+      }
+      free(index->entries);
+   }
+
+   RHMAP_FREE(index->map);
+   free(index->path);
+   free(index);
+}
+
+/* Must be called with the lock held */
+static void vfs_archive_index_release(struct vfs_archive_index *index)
+{
+   if (--index->refs == 0 && !index->cached)
+      vfs_archive_index_free(index);
+}
+
+/* Must be called with the lock held */
+static void vfs_archive_index_uncache(size_t i)
+{
+   struct vfs_archive_index *index = vfs_archive_indexes[i];
+
+   vfs_archive_indexes[i] = NULL;
+   index->cached          = false;
+   if (index->refs == 0)
+      vfs_archive_index_free(index);
+}
+
+/* Finds the end of central directory record, returning the
+ * offset, size and number of entries of the central directory */
+static bool vfs_archive_find_directory(
+      libretro_vfs_implementation_file *file, int64_t file_size,
+      uint64_t *cd_offset, uint64_t *cd_size, uint64_t *cd_entries)
+{
+   uint8_t *tail;
+   int64_t i;
+   /* The record is 22 bytes, followed by up to 64 KiB of comment */
+   int64_t tail_len = MIN(file_size, 22 + 65535);
+   int64_t eocd     = -1;
+
+   if (tail_len < 22 || !(tail = (uint8_t*)malloc((size_t)tail_len)))
+      return false;
+
+   if (!vfs_archive_read_at(file, (uint64_t)(file_size - tail_len),
+            tail, (uint64_t)tail_len))
+   {
+      free(tail);
+      return false;
+   }
+
+   for (i = tail_len - 22; i >= 0; i--)
+   {
+      if (vfs_archive_le32(tail + i) == VFS_ARCHIVE_EOCD_SIG)
+      {
+         eocd = i;
+         break;
+      }
+   }
+
+   if (eocd < 0)
+   {
+      free(tail);
+      return false;
+   }
+
+   *cd_entries = vfs_archive_le16(tail + eocd + 10);
+   *cd_size    = vfs_archive_le32(tail + eocd + 12);
+   *cd_offset  = vfs_archive_le32(tail + eocd + 16);
+
+   /* Zip64 archives keep the real values in another record,
+    * pointed to by a locator right before this one */
+   if (     *cd_entries == 0xFFFF
+         || *cd_size    == 0xFFFFFFFF
+         || *cd_offset  == 0xFFFFFFFF)
+   {
+      uint8_t rec[56];
+      int64_t loc = file_size - tail_len + eocd - 20;
+
+      if (     loc < 0
+            || !vfs_archive_read_at(file, (uint64_t)loc, rec, 20)
+            || vfs_archive_le32(rec) != VFS_ARCHIVE_LOC64_SIG
+            || !vfs_archive_read_at(file, vfs_archive_le64(rec + 8), rec, 56)
+            || vfs_archive_le32(rec) != VFS_ARCHIVE_EOCD64_SIG)
+      {
+         free(tail);
+         return false;
+      }
+
+      *cd_entries = vfs_archive_le64(rec + 32);
+      *cd_size    = vfs_archive_le64(rec + 40);
+      *cd_offset  = vfs_archive_le64(rec + 48);
+   }
+
+   free(tail);
+   return *cd_offset + *cd_size <= (uint64_t)file_size;
+}
+
+static struct vfs_archive_index *vfs_archive_index_build(
+      const char *path, int64_t file_size, int64_t file_stamp)
+{
+   uint64_t cd_offset, cd_size, cd_entries;
+   const uint8_t *p, *end;
+   uint8_t *cd                             = NULL;
+   struct vfs_archive_index *index         = NULL;
+   libretro_vfs_implementation_file *file  = retro_vfs_file_open_impl(
+         path, RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return NULL;
+
+   if (file_size < 0)
+      file_size = retro_vfs_file_size_impl(file);
+
+   if (     !vfs_archive_find_directory(file, file_size,
+               &cd_offset, &cd_size, &cd_entries)
+         /* Every entry takes at least 46 bytes */
+         || cd_entries > cd_size / 46
+         || !(cd = (uint8_t*)malloc((size_t)cd_size + 1))
+         || !vfs_archive_read_at(file, cd_offset, cd, cd_size)
+         || !(index = (struct vfs_archive_index*)calloc(1, sizeof(*index)))
+         || !(index->entries = (struct vfs_archive_entry*)calloc(
+               (size_t)cd_entries + 1, sizeof(*index->entries))))
+      goto error;
+
+   index->path       = strdup(path);
+   index->file_size  = file_size;
+   index->file_stamp = file_stamp;
+
+   for (p = cd, end = cd + cd_size; p + 46 <= end; )
+   {
+      char name[PATH_MAX_LENGTH];
+      struct vfs_archive_entry *entry;
+      uint16_t flags, name_len, extra_len, comment_len;
+
+      if (vfs_archive_le32(p) != VFS_ARCHIVE_CENTRAL_SIG)
+         break;
+
+      flags       = vfs_archive_le16(p + 8);
+      name_len    = vfs_archive_le16(p + 28);
+      extra_len   = vfs_archive_le16(p + 30);
+      comment_len = vfs_archive_le16(p + 32);
+
+      if (p + 46 + name_len + extra_len + comment_len > end)
+         break;
+
+      /* Directories, encrypted members and unreasonable names */
+      if (     index->num_entries >= cd_entries
+            || (flags & 1)
+            || name_len == 0
+            || name_len >= sizeof(name)
+            || p[46 + name_len - 1] == '/')
+      {
+         p += 46 + name_len + extra_len + comment_len;
+         continue;
+      }
+
+      entry                = &index->entries[index->num_entries];
+      entry->method        = vfs_archive_le16(p + 10);
+      entry->comp_size     = vfs_archive_le32(p + 20);
+      entry->size          = vfs_archive_le32(p + 24);
+      entry->header_offset = vfs_archive_le32(p + 42);
+      entry->data_offset   = -1;
+
+      /* Zip64 extended information, holding the fields
+       * set to 0xFFFFFFFF above, in this order */
+      {
+         const uint8_t *extra     = p + 46 + name_len;
+         const uint8_t *extra_end = extra + extra_len;
+
+         while (extra + 4 <= extra_end)
+         {
+            uint16_t id           = vfs_archive_le16(extra);
+            uint16_t len          = vfs_archive_le16(extra + 2);
+            const uint8_t *field  = extra + 4;
+            const uint8_t *fields = field + len;
+
+            if (fields > extra_end)
+               break;
+
+            if (id == 0x0001)
+            {
+               if (entry->size == 0xFFFFFFFF && field + 8 <= fields)
+               {
+                  entry->size = vfs_archive_le64(field);
+                  field      += 8;
+               }
+               if (entry->comp_size == 0xFFFFFFFF && field + 8 <= fields)
+               {
+                  entry->comp_size = vfs_archive_le64(field);
+                  field           += 8;
+               }
+               if (entry->header_offset == 0xFFFFFFFF && field + 8 <= fields)
+                  entry->header_offset = vfs_archive_le64(field);
+               break;
+            }
+
+            extra = fields;
+         }
+      }
+
+      entry->span = MAX(VFS_ARCHIVE_MIN_SPAN,
+            entry->size / VFS_ARCHIVE_MAX_POINTS + 1);
+
+      memcpy(name, p + 46, name_len);
+      name[name_len] = '\0';
+      RHMAP_SET_STR(index->map, name, entry);
+
+      index->num_entries++;
+      p += 46 + name_len + extra_len + comment_len;
+   }
+
+   free(cd);
+   retro_vfs_file_close_impl(file);
+   return index;
+
+error:
+   if (index)
+      vfs_archive_index_free(index);
+   free(cd);
+   retro_vfs_file_close_impl(file);
+   return NULL;
+}
+
+/* Returns a referenced index of the archive at @path,
+ * from the cache while the archive is unchanged */
+static struct vfs_archive_index *vfs_archive_index_get(const char *path)
+{
+   size_t i;
+   int64_t file_size                = -1;
+   int64_t file_stamp               = 0;
+   struct vfs_archive_index *index  = NULL;
+   /* Size and modification time of the archive, to tell
+    * whether a cached index still describes it */
+   bool cacheable                   = vfs_archive_inited
+      && path_get_stamp(path, &file_stamp, &file_size);
+
+   if (cacheable)
+   {
+      vfs_archive_lock_acquire();
+      for (i = 0; i < VFS_ARCHIVE_MAX_INDEXES; i++)
+      {
+         struct vfs_archive_index *cached = vfs_archive_indexes[i];
+
+         if (!cached || !string_is_equal(cached->path, path))
+            continue;
+
+         if (     cached->file_size  == file_size
+               && cached->file_stamp == file_stamp)
+         {
+            cached->refs++;
+            cached->last_use = ++vfs_archive_clock;
+            vfs_archive_lock_release();
+            return cached;
+         }
+
+         /* Changed on disk */
+         vfs_archive_index_uncache(i);
+      }
+      vfs_archive_lock_release();
+   }
+
+   /* Parsed without the lock held, this reads the whole
+    * central directory */
+   if (!(index = vfs_archive_index_build(path, file_size, file_stamp)))
+      return NULL;
+
+   index->refs = 1;
+
+   if (cacheable)
+   {
+      size_t slot = 0;
+
+      vfs_archive_lock_acquire();
+      for (i = 0; i < VFS_ARCHIVE_MAX_INDEXES; i++)
+      {
+         struct vfs_archive_index *cached = vfs_archive_indexes[i];
+
+         /* Another thread got here first */
+         if (     cached
+               && string_is_equal(cached->path, path)
+               && cached->file_size  == file_size
+               && cached->file_stamp == file_stamp)
+         {
+            cached->refs++;
+            cached->last_use = ++vfs_archive_clock;
+            vfs_archive_lock_release();
+            vfs_archive_index_free(index);
+            return cached;
+         }
+      }
+
+      /* Take a free slot, or the least recently used one */
+      for (i = 0; i < VFS_ARCHIVE_MAX_INDEXES; i++)
+      {
+         if (!vfs_archive_indexes[i])
+         {
+            slot = i;
+            break;
+         }
+         if (vfs_archive_indexes[i]->last_use
+               < vfs_archive_indexes[slot]->last_use)
+            slot = i;
+      }
+
+      if (vfs_archive_indexes[slot])
+         vfs_archive_index_uncache(slot);
+
+      index->cached             = true;
+      index->last_use           = ++vfs_archive_clock;
+      vfs_archive_indexes[slot] = index;
+      vfs_archive_lock_release();
+   }
+
+   return index;
+}
+
+static struct vfs_archive_entry *vfs_archive_index_find(
+      struct vfs_archive_index *index, const char *member)
+{
+   ptrdiff_t idx = RHMAP_IDX_STR(index->map, member);
+   if (idx < 0)
+      return NULL;
+   return index->map[idx];
+}
+
+/* Must be called with the lock held */
+static void vfs_archive_update_next_point(struct vfs_archive_stream *as)
+{
+   struct vfs_archive_entry *entry = as->entry;
+
+   if (entry->num_points >= VFS_ARCHIVE_MAX_POINTS)
+      as->next_point = UINT64_MAX;
+   else if (entry->num_points)
+      as->next_point = entry->points[entry->num_points - 1].out
+         + entry->span;
+   else
+      as->next_point = entry->span;
+}
+
+/* Records a seek point at the current position, which
+ * must be the end of a deflate block */
+static void vfs_archive_add_point(struct vfs_archive_stream *as)
+{
+   struct vfs_archive_entry *entry = as->entry;
+
+   vfs_archive_lock_acquire();
+
+   /* Another handle may have recorded points past here */
+   vfs_archive_update_next_point(as);
+
+   if (as->out >= as->next_point)
+   {
+      struct vfs_archive_point *points = (struct vfs_archive_point*)
+         realloc(entry->points,
+               (entry->num_points + 1) * sizeof(*entry->points));
+      uint8_t *window                  = (uint8_t*)
+         malloc(VFS_ARCHIVE_WINDOW);
+
+      if (points)
+         entry->points = points;
+
+      if (points && window)
+      {
+         struct vfs_archive_point *point = &points[entry->num_points++];
+         size_t tail                     = VFS_ARCHIVE_WINDOW - as->win_pos;
+
+         point->out    = as->out;
+         point->in     = as->in_pos - as->zs.avail_in;
+         point->bits   = as->zs.data_type & 7;
+         point->window = window;
+
+         /* Unwrap, oldest byte first. Points are never closer to the
+          * start than the window size, so the window is full */
+         memcpy(window,        as->window + as->win_pos, tail);
+         memcpy(window + tail, as->window,               as->win_pos);
+      }
+      else
+         free(window);
+
+      vfs_archive_update_next_point(as);
+   }
+
+   vfs_archive_lock_release();
+}
+
+/* Restarts decompression from the closest seek point at or before
+ * @target, or from the start of the member */
+static bool vfs_archive_restart(struct vfs_archive_stream *as,
+      uint64_t target)
+{
+   struct vfs_archive_entry *entry = as->entry;
+   struct vfs_archive_point point;
+   bool found                      = false;
+
+   vfs_archive_lock_acquire();
+   if (entry->num_points && entry->points[0].out <= target)
+   {
+      size_t lo = 0;
+      size_t hi = entry->num_points - 1;
+
+      while (lo < hi)
+      {
+         size_t mid = (lo + hi + 1) / 2;
+         if (entry->points[mid].out <= target)
+            lo = mid;
+         else
+            hi = mid - 1;
+      }
+
+      point = entry->points[lo];
+      /* Windows are never freed while the index is referenced */
+      memcpy(as->window, point.window, VFS_ARCHIVE_WINDOW);
+      found = true;
+   }
+   vfs_archive_update_next_point(as);
+   vfs_archive_lock_release();
+
+   if (inflateReset(&as->zs) != Z_OK)
+      return false;
+
+   as->zs.avail_in = 0;
+   as->win_pos     = 0;
+   as->error       = false;
+
+   if (!found)
+   {
+      as->out    = 0;
+      as->in_pos = 0;
+      return true;
+   }
+
+   if (point.bits)
+   {
+      uint8_t byte;
+      if (!vfs_archive_read_at(as->file,
+               as->data_offset + point.in - 1, &byte, 1))
+         return false;
+      inflatePrime(&as->zs, point.bits, byte >> (8 - point.bits));
+   }
+
+   if (inflateSetDictionary(&as->zs, as->window, VFS_ARCHIVE_WINDOW) != Z_OK)
+      return false;
+
+   as->out    = point.out;
+   as->in_pos = point.in;
+   return true;
+}
+
+/* Decompresses up to @len bytes at the decompressor position into
+ * @s, or skips them when @s is NULL */
+static uint64_t vfs_archive_inflate(struct vfs_archive_stream *as,
+      uint8_t *s, uint64_t len)
+{
+   struct vfs_archive_entry *entry = as->entry;
+   uint64_t done                   = 0;
+
+   while (done < len)
+   {
+      int ret;
+      size_t have;
+      size_t avail;
+
+      if (as->zs.avail_in == 0)
+      {
+         uint64_t left = entry->comp_size - as->in_pos;
+         size_t _len   = (size_t)MIN(left, VFS_ARCHIVE_CHUNK);
+
+         /* Truncated stream */
+         if (     _len == 0
+               || !vfs_archive_read_at(as->file,
+                  as->data_offset + as->in_pos, as->in, _len))
+         {
+            as->error = true;
+            break;
+         }
+
+         as->in_pos     += _len;
+         as->zs.next_in  = as->in;
+         as->zs.avail_in = (uInt)_len;
+      }
+
+      if (as->win_pos == VFS_ARCHIVE_WINDOW)
+         as->win_pos = 0;
+
+      avail            = (size_t)MIN(len - done,
+            VFS_ARCHIVE_WINDOW - as->win_pos);
+      as->zs.next_out  = as->window + as->win_pos;
+      as->zs.avail_out = (uInt)avail;
+
+      ret = inflate(&as->zs, Z_BLOCK);
+
+      if (     ret != Z_OK
+            && ret != Z_STREAM_END
+            && ret != Z_BUF_ERROR)
+      {
+         as->error = true;
+         break;
+      }
+
+      have = avail - as->zs.avail_out;
+      if (s)
+         memcpy(s + done, as->window + as->win_pos, have);
+      as->win_pos += have;
+      as->out     += have;
+      done        += have;
+
+      if (ret == Z_STREAM_END)
+         break;
+
+      /* At the end of a block, but not of the last one */
+      if (     (as->zs.data_type & 128)
+            && !(as->zs.data_type & 64)
+            && as->out >= as->next_point)
+         vfs_archive_add_point(as);
+   }
+
+   return done;
+}
+
+void retro_vfs_file_open_archive(
+      libretro_vfs_implementation_file *stream,
+      const char *path, unsigned mode, unsigned hints)
+{
+   char archive[PATH_MAX_LENGTH];
+   uint8_t header[30];
+   struct vfs_archive_entry *entry = NULL;
+   struct vfs_archive_stream *as   = NULL;
+   int64_t data_offset             = -1;
+   const char *member              = vfs_archive_split(path,
+         archive, sizeof(archive));
+
+   stream->archive = NULL;
+
+   if (!member || mode != RETRO_VFS_FILE_ACCESS_READ)
+      return;
+
+   if (!(as = (struct vfs_archive_stream*)calloc(1, sizeof(*as))))
+      return;
+
+   if (     !(as->index = vfs_archive_index_get(archive))
+         || !(entry     = vfs_archive_index_find(as->index, member))
+         || (entry->method != 0 && entry->method != Z_DEFLATED)
+         || !(as->file  = retro_vfs_file_open_impl(archive,
+               RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto error;
+
+   as->entry = entry;
+
+   vfs_archive_lock_acquire();
+   data_offset = entry->data_offset;
+   vfs_archive_lock_release();
+
+   /* The local header may have other extra fields than
+    * the central directory, so its size must be read */
+   if (data_offset < 0)
+   {
+      if (     !vfs_archive_read_at(as->file, entry->header_offset,
+                  header, sizeof(header))
+            || vfs_archive_le32(header) != VFS_ARCHIVE_LOCAL_SIG)
+         goto error;
+
+      data_offset = (int64_t)(entry->header_offset + sizeof(header)
+         + vfs_archive_le16(header + 26) + vfs_archive_le16(header + 28));
+
+      vfs_archive_lock_acquire();
+      entry->data_offset = data_offset;
+      vfs_archive_lock_release();
+   }
+
+   as->data_offset = (uint64_t)data_offset;
+
+   if (     as->data_offset + entry->comp_size
+         > (uint64_t)retro_vfs_file_size_impl(as->file))
+      goto error;
+
+   if (entry->method == Z_DEFLATED)
+   {
+      /* Raw deflate data, without zlib header */
+      if (inflateInit2(&as->zs, -MAX_WBITS) != Z_OK)
+         goto error;
+      as->zs_init = true;
+
+      vfs_archive_lock_acquire();
+      vfs_archive_update_next_point(as);
+      vfs_archive_lock_release();
+   }
+
+   stream->archive = as;
+   stream->size    = (int64_t)entry->size;
+   return;
+
+error:
+   if (as->file)
+      retro_vfs_file_close_impl(as->file);
+   if (as->index)
+   {
+      vfs_archive_lock_acquire();
+      vfs_archive_index_release(as->index);
+      vfs_archive_lock_release();
+   }
+   free(as);
+}
+
+int retro_vfs_file_close_archive(libretro_vfs_implementation_file *stream)
+{
+   struct vfs_archive_stream *as = stream->archive;
+
+   if (!as)
+      return -1;
+
+   if (as->zs_init)
+      inflateEnd(&as->zs);
+   retro_vfs_file_close_impl(as->file);
+
+   vfs_archive_lock_acquire();
+   vfs_archive_index_release(as->index);
+   vfs_archive_lock_release();
+
+   free(as);
+   stream->archive = NULL;
+   return 0;
+}
+
+int64_t retro_vfs_file_seek_archive(libretro_vfs_implementation_file *stream,
+      int64_t offset, int whence)
+{
+   struct vfs_archive_stream *as = stream->archive;
+   int64_t pos;
+
+   switch (whence)
+   {
+      case SEEK_SET:
+         pos = offset;
+         break;
+      case SEEK_CUR:
+         pos = (int64_t)as->pos + offset;
+         break;
+      case SEEK_END:
+         pos = (int64_t)as->entry->size + offset;
+         break;
+      default:
+         return -1;
+   }
+
+   if (pos < 0)
+      return -1;
+
+   /* Decompression only moves on when reading */
+   as->pos = (uint64_t)pos;
+   return 0;
+}
+
+int64_t retro_vfs_file_tell_archive(libretro_vfs_implementation_file *stream)
+{
+   return (int64_t)stream->archive->pos;
+}
+
+int64_t retro_vfs_file_read_archive(libretro_vfs_implementation_file *stream,
+      void *s, uint64_t len)
+{
+   struct vfs_archive_stream *as   = stream->archive;
+   struct vfs_archive_entry *entry = as->entry;
+   uint64_t done;
+
+   if (as->pos >= entry->size)
+      return 0;
+
+   if (len > entry->size - as->pos)
+      len = entry->size - as->pos;
+
+   if (entry->method == 0)
+   {
+      if (retro_vfs_file_seek_impl(as->file,
+               (int64_t)(as->data_offset + as->pos),
+               RETRO_VFS_SEEK_POSITION_START) < 0)
+         return -1;
+      if ((done = (uint64_t)retro_vfs_file_read_impl(as->file, s, len))
+            > len)
+         return -1;
+      as->pos += done;
+      return (int64_t)done;
+   }
+
+   /* Going back, or far enough ahead that a seek point
+    * is closer than the decompressor */
+   if (as->pos < as->out || as->error)
+   {
+      if (!vfs_archive_restart(as, as->pos))
+         return -1;
+   }
+   else if (as->pos - as->out > VFS_ARCHIVE_WINDOW)
+   {
+      bool closer = false;
+
+      vfs_archive_lock_acquire();
+      if (entry->num_points)
+      {
+         size_t i;
+         for (i = entry->num_points; i-- > 0; )
+         {
+            if (entry->points[i].out <= as->pos)
+            {
+               closer = entry->points[i].out > as->out;
+               break;
+            }
+         }
+      }
+      vfs_archive_lock_release();
+
+      if (closer && !vfs_archive_restart(as, as->pos))
+         return -1;
+   }
+
+   if (as->pos > as->out)
+   {
+      uint64_t skip = as->pos - as->out;
+      if (vfs_archive_inflate(as, NULL, skip) != skip)
+         return -1;
+   }
+
+   done     = vfs_archive_inflate(as, (uint8_t*)s, len);
+   as->pos += done;
+
+   if (done == 0 && as->error)
+      return -1;
+   return (int64_t)done;
+}
+
+int retro_vfs_file_error_archive(libretro_vfs_implementation_file *stream)
+{
+   return stream->archive->error ? 1 : 0;
+}
+
+int retro_vfs_stat_archive(const char *path, int32_t *size)
+{
+   char archive[PATH_MAX_LENGTH];
+   struct vfs_archive_index *index = NULL;
+   struct vfs_archive_entry *entry = NULL;
+   const char *member              = vfs_archive_split(path,
+         archive, sizeof(archive));
+
+   if (!member || !(index = vfs_archive_index_get(archive)))
+      return 0;
+
+   if ((entry = vfs_archive_index_find(index, member)) && size)
+      *size = (int32_t)entry->size;
+
+   vfs_archive_lock_acquire();
+   vfs_archive_index_release(index);
+   vfs_archive_lock_release();
+
+   return entry ? RETRO_VFS_STAT_IS_VALID : 0;
+}
+
+void retro_vfs_archive_init(void)
+{
+   retro_vfs_archive_deinit();
+#ifdef HAVE_THREADS
+   vfs_archive_lock   = slock_new();
+#endif
+   vfs_archive_inited = true;
+}
+
+void retro_vfs_archive_deinit(void)
+{
+   size_t i;
+
+   vfs_archive_lock_acquire();
+   for (i = 0; i < VFS_ARCHIVE_MAX_INDEXES; i++)
+      if (vfs_archive_indexes[i])
+         vfs_archive_index_uncache(i);
+   vfs_archive_inited = false;
+   vfs_archive_lock_release();
+
+#ifdef HAVE_THREADS
+   if (vfs_archive_lock)
+   {
+      slock_free(vfs_archive_lock);
+      vfs_archive_lock = NULL;
+   }
+#endif
+}
@@ -758,6 +758,15 @@ int generic_action_ok_displaylist_push(
          info.enum_idx      = MENU_ENUM_LABEL_DEFERRED_CONTENTLESS_CORES_LIST;
          dl_type            = DISPLAYLIST_GENERIC;
          break;
+      case ACTION_OK_DL_LIBRARY_SEARCH_LIST:
+         info.type          = type;
+         info.directory_ptr = idx;
+         info_path          = label;
+         info_label         = msg_hash_to_str(
+               MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST);
+         info.enum_idx      = MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST;
+         dl_type            = DISPLAYLIST_GENERIC;
+         break;
       case ACTION_OK_DL_REMAPPINGS_PORT_LIST:
          info.type          = type;
          info.directory_ptr = idx;
@@ -4934,6 +4943,12 @@ static int action_ok_undo_save_state(const char *path,
    return generic_action_ok_command(CMD_EVENT_RESUME);
 }
 
+static int action_ok_export_save_state(const char *path,
+      const char *label, unsigned type, size_t idx, size_t entry_idx)
+{
+   return generic_action_ok_command(CMD_EVENT_EXPORT_SAVE_STATE);
+}
+
 #ifdef HAVE_NETWORKING
 
 #ifdef HAVE_ZLIB
@@ -6509,6 +6524,7 @@ STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_goto_video, ACTION_OK_DL_VIDEO_LIST)
 STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_goto_music, ACTION_OK_DL_MUSIC_LIST)
 STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_goto_explore, ACTION_OK_DL_EXPLORE_LIST)
 STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_goto_contentless_cores, ACTION_OK_DL_CONTENTLESS_CORES_LIST)
+STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_goto_library_search, ACTION_OK_DL_LIBRARY_SEARCH_LIST)
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
 STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_shader_preset_manager, ACTION_OK_DL_SHADER_PRESET_MANAGER_LIST)
 STATIC_DEFAULT_ACTION_OK_FUNC(action_ok_shader_parameters, ACTION_OK_DL_SHADER_PARAMETERS)
@@ -9104,6 +9120,7 @@ static int menu_cbs_init_bind_ok_compare_label(menu_file_list_cbs_t *cbs,
          {MENU_ENUM_LABEL_GOTO_VIDEO,                          action_ok_goto_video},
          {MENU_ENUM_LABEL_GOTO_EXPLORE,                        action_ok_goto_explore},
          {MENU_ENUM_LABEL_GOTO_CONTENTLESS_CORES,              action_ok_goto_contentless_cores},
+         {MENU_ENUM_LABEL_GOTO_LIBRARY_SEARCH,                 action_ok_goto_library_search},
          {MENU_ENUM_LABEL_BROWSE_START,                        action_ok_browse_url_start},
          {MENU_ENUM_LABEL_FILE_BROWSER_CORE,                   action_ok_load_core},
          {MENU_ENUM_LABEL_FILE_BROWSER_CORE_SELECT_FROM_COLLECTION,action_ok_core_deferred_set},
@@ -9121,6 +9138,7 @@ static int menu_cbs_init_bind_ok_compare_label(menu_file_list_cbs_t *cbs,
          {MENU_ENUM_LABEL_LOAD_STATE,                          action_ok_load_state},
          {MENU_ENUM_LABEL_UNDO_LOAD_STATE,                     action_ok_undo_load_state},
          {MENU_ENUM_LABEL_UNDO_SAVE_STATE,                     action_ok_undo_save_state},
+         {MENU_ENUM_LABEL_EXPORT_SAVE_STATE,                   action_ok_export_save_state},
          {MENU_ENUM_LABEL_RECORD_REPLAY,                       action_ok_record_replay},
          {MENU_ENUM_LABEL_PLAY_REPLAY,                         action_ok_play_replay},
          {MENU_ENUM_LABEL_HALT_REPLAY,                         action_ok_halt_replay},
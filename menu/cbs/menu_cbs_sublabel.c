@@ -277,6 +277,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_settings_list,  MENU_ENUM
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_accessibility_settings_list,  MENU_ENUM_SUBLABEL_ACCESSIBILITY_SETTINGS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_mode,  MENU_ENUM_SUBLABEL_AI_SERVICE_MODE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_pause,  MENU_ENUM_SUBLABEL_AI_SERVICE_PAUSE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_send_regions, MENU_ENUM_SUBLABEL_AI_SERVICE_SEND_REGIONS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_target_lang,  MENU_ENUM_SUBLABEL_AI_SERVICE_TARGET_LANG)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_source_lang,  MENU_ENUM_SUBLABEL_AI_SERVICE_SOURCE_LANG)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_ai_service_url,  MENU_ENUM_SUBLABEL_AI_SERVICE_URL)
@@ -515,6 +516,8 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_materialui_thumbnail_background_enab
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_add_content_list,              MENU_ENUM_SUBLABEL_ADD_CONTENT_LIST)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_frame_delay,             MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_frame_delay_auto,        MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY_AUTO)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_thread_roles_enable,            MENU_ENUM_SUBLABEL_THREAD_ROLES_ENABLE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_input_evdev_thread_enable,      MENU_ENUM_SUBLABEL_INPUT_EVDEV_THREAD_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_shader_delay,            MENU_ENUM_SUBLABEL_VIDEO_SHADER_DELAY)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_black_frame_insertion,   MENU_ENUM_SUBLABEL_VIDEO_BLACK_FRAME_INSERTION)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_bfi_dark_frames,         MENU_ENUM_SUBLABEL_VIDEO_BFI_DARK_FRAMES)
@@ -541,6 +544,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_video_shared_context,          MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_driver_switch_enable,          MENU_ENUM_SUBLABEL_DRIVER_SWITCH_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_latency,                 MENU_ENUM_SUBLABEL_AUDIO_LATENCY)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_rate_control_delta,      MENU_ENUM_SUBLABEL_AUDIO_RATE_CONTROL_DELTA)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_rate_control_target,     MENU_ENUM_SUBLABEL_AUDIO_RATE_CONTROL_TARGET)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_mute,                    MENU_ENUM_SUBLABEL_AUDIO_MUTE)
 #ifdef HAVE_AUDIOMIXER
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_mixer_mute,              MENU_ENUM_SUBLABEL_AUDIO_MIXER_MUTE)
@@ -596,6 +600,9 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_dummy_check_missing_firmware,  MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_core_option_category_enable,   MENU_ENUM_SUBLABEL_CORE_OPTION_CATEGORY_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_core_info_cache_enable,        MENU_ENUM_SUBLABEL_CORE_INFO_CACHE_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_core_info_savestate_bypass,    MENU_ENUM_SUBLABEL_CORE_INFO_SAVESTATE_BYPASS)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_content_cache_size,            MENU_ENUM_SUBLABEL_CONTENT_CACHE_SIZE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_content_cache_compress,        MENU_ENUM_SUBLABEL_CONTENT_CACHE_COMPRESS)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_archive_vfs_mount,             MENU_ENUM_SUBLABEL_ARCHIVE_VFS_MOUNT)
 #ifndef HAVE_DYNAMIC
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_always_reload_core_on_run_content, MENU_ENUM_SUBLABEL_ALWAYS_RELOAD_CORE_ON_RUN_CONTENT)
 #endif
@@ -757,6 +764,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_replay_auto_index,             MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_block_sram_overwrite,          MENU_ENUM_SUBLABEL_BLOCK_SRAM_OVERWRITE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_fastforward_ratio,             MENU_ENUM_SUBLABEL_FASTFORWARD_RATIO)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_fastforward_frameskip,         MENU_ENUM_SUBLABEL_FASTFORWARD_FRAMESKIP)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_fastforward_turbo,             MENU_ENUM_SUBLABEL_FASTFORWARD_TURBO)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_vrr_runloop_enable,            MENU_ENUM_SUBLABEL_VRR_RUNLOOP_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_menu_throttle_framerate,       MENU_ENUM_SUBLABEL_MENU_ENUM_THROTTLE_FRAMERATE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_slowmotion_ratio,              MENU_ENUM_SUBLABEL_SLOWMOTION_RATIO)
@@ -820,6 +828,8 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_auto_load,           MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_thumbnail_enable,    MENU_ENUM_SUBLABEL_SAVESTATE_THUMBNAIL_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_save_file_compression,         MENU_ENUM_SUBLABEL_SAVE_FILE_COMPRESSION)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_file_compression,    MENU_ENUM_SUBLABEL_SAVESTATE_FILE_COMPRESSION)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_file_sync,           MENU_ENUM_SUBLABEL_SAVESTATE_FILE_SYNC)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_dedup_store,         MENU_ENUM_SUBLABEL_SAVESTATE_DEDUP_STORE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_savestate_max_keep,            MENU_ENUM_SUBLABEL_SAVESTATE_MAX_KEEP)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_autosave_interval,             MENU_ENUM_SUBLABEL_AUTOSAVE_INTERVAL)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_replay_max_keep,               MENU_ENUM_SUBLABEL_REPLAY_MAX_KEEP)
@@ -941,6 +951,8 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_allow_slaves,          MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_require_slaves,        MENU_ENUM_SUBLABEL_NETPLAY_REQUIRE_SLAVES)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_check_frames,          MENU_ENUM_SUBLABEL_NETPLAY_CHECK_FRAMES)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_nat_traversal,         MENU_ENUM_SUBLABEL_NETPLAY_NAT_TRAVERSAL)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_udp_input,             MENU_ENUM_SUBLABEL_NETPLAY_UDP_INPUT)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_netplay_zstd_level,            MENU_ENUM_SUBLABEL_NETPLAY_ZSTD_LEVEL)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_stdin_cmd_enable,              MENU_ENUM_SUBLABEL_STDIN_CMD_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_mouse_enable,                  MENU_ENUM_SUBLABEL_MOUSE_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_pointer_enable,                MENU_ENUM_SUBLABEL_POINTER_ENABLE)
@@ -1027,6 +1039,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_goto_music,
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_goto_video,                            MENU_ENUM_SUBLABEL_GOTO_VIDEO)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_goto_explore,                          MENU_ENUM_SUBLABEL_GOTO_EXPLORE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_goto_contentless_cores,                MENU_ENUM_SUBLABEL_GOTO_CONTENTLESS_CORES)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_goto_library_search,                   MENU_ENUM_SUBLABEL_GOTO_LIBRARY_SEARCH)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_menu_filebrowser_settings,             MENU_ENUM_SUBLABEL_MENU_FILE_BROWSER_SETTINGS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_menu_filebrowser_open_uwp_permissions, MENU_ENUM_SUBLABEL_FILE_BROWSER_OPEN_UWP_PERMISSIONS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_menu_filebrowser_open_picker,          MENU_ENUM_SUBLABEL_FILE_BROWSER_OPEN_PICKER)
@@ -1047,6 +1060,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_load_state,
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_save_state,                            MENU_ENUM_SUBLABEL_SAVE_STATE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_undo_load_state,                       MENU_ENUM_SUBLABEL_UNDO_LOAD_STATE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_undo_save_state,                       MENU_ENUM_SUBLABEL_UNDO_SAVE_STATE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_export_save_state,                     MENU_ENUM_SUBLABEL_EXPORT_SAVE_STATE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_record_replay,                         MENU_ENUM_SUBLABEL_RECORD_REPLAY)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_play_replay,                           MENU_ENUM_SUBLABEL_PLAY_REPLAY)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_halt_replay,                           MENU_ENUM_SUBLABEL_HALT_REPLAY)
@@ -2047,10 +2061,11 @@ static int action_bind_sublabel_playlist_entry(
        && !string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_HORIZONTAL_MENU)))
       return 0;
 
-   /* Check whether runtime info should be loaded from log file */
+   /* Check whether runtime info should be loaded from runtime
+    * log - looks up all entries of the playlist at once */
    if (entry->runtime_status == PLAYLIST_RUNTIME_UNKNOWN)
-      runtime_update_playlist(
-            playlist, playlist_index,
+      runtime_update_playlist_all(
+            playlist,
             directory_runtime_log,
             directory_playlist,
             (playlist_sublabel_runtime_type == PLAYLIST_RUNTIME_PER_CORE),
@@ -2942,6 +2957,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_GOTO_CONTENTLESS_CORES:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_goto_contentless_cores);
             break;
+         case MENU_ENUM_LABEL_GOTO_LIBRARY_SEARCH:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_goto_library_search);
+            break;
          case MENU_ENUM_LABEL_GOTO_FAVORITES:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_goto_favorites);
             break;
@@ -3582,6 +3600,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_UNDO_SAVE_STATE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_undo_save_state);
             break;
+         case MENU_ENUM_LABEL_EXPORT_SAVE_STATE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_export_save_state);
+            break;
          case MENU_ENUM_LABEL_UNDO_LOAD_STATE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_undo_load_state);
             break;
@@ -3844,6 +3865,12 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_nat_traversal);
             break;
+         case MENU_ENUM_LABEL_NETPLAY_UDP_INPUT:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_udp_input);
+            break;
+         case MENU_ENUM_LABEL_NETPLAY_ZSTD_LEVEL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_zstd_level);
+            break;
          case MENU_ENUM_LABEL_NETPLAY_CHECK_FRAMES:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_check_frames);
             break;
@@ -4181,6 +4208,12 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_savestate_file_compression);
             break;
+         case MENU_ENUM_LABEL_SAVESTATE_FILE_SYNC:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_savestate_file_sync);
+            break;
+         case MENU_ENUM_LABEL_SAVESTATE_DEDUP_STORE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_savestate_dedup_store);
+            break;
          case MENU_ENUM_LABEL_SAVESTATE_AUTO_SAVE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_savestate_auto_save);
             break;
@@ -4360,6 +4393,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_FASTFORWARD_FRAMESKIP:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_fastforward_frameskip);
             break;
+         case MENU_ENUM_LABEL_FASTFORWARD_TURBO:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_fastforward_turbo);
+            break;
          case MENU_ENUM_LABEL_VRR_RUNLOOP_ENABLE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_vrr_runloop_enable);
             break;
@@ -4724,6 +4760,15 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_CORE_INFO_SAVESTATE_BYPASS:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_core_info_savestate_bypass);
             break;
+         case MENU_ENUM_LABEL_CONTENT_CACHE_SIZE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_content_cache_size);
+            break;
+         case MENU_ENUM_LABEL_CONTENT_CACHE_COMPRESS:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_content_cache_compress);
+            break;
+         case MENU_ENUM_LABEL_ARCHIVE_VFS_MOUNT:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_archive_vfs_mount);
+            break;
 #ifndef HAVE_DYNAMIC
          case MENU_ENUM_LABEL_ALWAYS_RELOAD_CORE_ON_RUN_CONTENT:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_always_reload_core_on_run_content);
@@ -4834,6 +4879,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_rate_control_delta);
             break;
+         case MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_TARGET:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_rate_control_target);
+            break;
          case MENU_ENUM_LABEL_AUDIO_MUTE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_mute);
             break;
@@ -5077,6 +5125,12 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_video_frame_delay_auto);
             break;
+         case MENU_ENUM_LABEL_THREAD_ROLES_ENABLE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_thread_roles_enable);
+            break;
+         case MENU_ENUM_LABEL_INPUT_EVDEV_THREAD_ENABLE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_input_evdev_thread_enable);
+            break;
          case MENU_ENUM_LABEL_VIDEO_SHADER_DELAY:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_video_shader_delay);
             break;
@@ -5385,6 +5439,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_AI_SERVICE_PAUSE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_ai_service_pause);
             break;
+         case MENU_ENUM_LABEL_AI_SERVICE_SEND_REGIONS:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_ai_service_send_regions);
+            break;
          case MENU_ENUM_LABEL_AI_SERVICE_ENABLE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_ai_service_enable);
             break;
@@ -3666,8 +3666,8 @@ static bool materialui_render_process_entry_playlist_desktop(
             if (content_runtime_log || content_runtime_log_aggregate)
             {
                if (entry->runtime_status == PLAYLIST_RUNTIME_UNKNOWN)
-                  runtime_update_playlist(
-                        mui->playlist, playlist_idx,
+                  runtime_update_playlist_all(
+                        mui->playlist,
                         directory_runtime_log,
                         directory_playlist,
                         (runtime_type == PLAYLIST_RUNTIME_PER_CORE),
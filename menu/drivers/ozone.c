@@ -4360,8 +4360,15 @@ static void ozone_update_content_metadata(ozone_handle_t *ozone)
 
       if (entry)
       {
-         if (     (entry->runtime_status == PLAYLIST_RUNTIME_UNKNOWN)
-               || (ozone->flags2 & OZONE_FLAG2_IS_QUICK_MENU))
+         if (entry->runtime_status == PLAYLIST_RUNTIME_UNKNOWN)
+            runtime_update_playlist_all(
+                  playlist,
+                  directory_runtime_log,
+                  directory_playlist,
+                  (runtime_type == PLAYLIST_RUNTIME_PER_CORE),
+                  runtime_last_played_style,
+                  runtime_date_separator);
+         else if (ozone->flags2 & OZONE_FLAG2_IS_QUICK_MENU)
             runtime_update_playlist(
                   playlist, playlist_index,
                   directory_runtime_log,
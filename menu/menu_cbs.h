@@ -88,6 +88,7 @@ enum
    ACTION_OK_DL_VIDEO_LIST,
    ACTION_OK_DL_EXPLORE_LIST,
    ACTION_OK_DL_CONTENTLESS_CORES_LIST,
+   ACTION_OK_DL_LIBRARY_SEARCH_LIST,
    ACTION_OK_DL_MUSIC_LIST,
    ACTION_OK_DL_SHADER_PARAMETERS,
    ACTION_OK_DL_SHADER_PRESET_MANAGER_LIST,
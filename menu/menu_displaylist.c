@@ -3787,6 +3787,16 @@ static int menu_displaylist_parse_load_content_settings(
                      count++;
                }
             }
+
+            if (settings->bools.savestate_dedup_store)
+            {
+               if (menu_entries_append(list,
+                        msg_hash_to_str(MENU_ENUM_LABEL_VALUE_EXPORT_SAVE_STATE),
+                        msg_hash_to_str(MENU_ENUM_LABEL_EXPORT_SAVE_STATE),
+                        MENU_ENUM_LABEL_EXPORT_SAVE_STATE,
+                        MENU_SETTING_ACTION, 0, 0, NULL))
+                  count++;
+            }
          }
       }
 
@@ -4525,6 +4535,13 @@ static unsigned menu_displaylist_parse_playlists(
             count++;
 #endif
 
+      if (menu_entries_append(info_list,
+               msg_hash_to_str(MENU_ENUM_LABEL_VALUE_GOTO_LIBRARY_SEARCH),
+               msg_hash_to_str(MENU_ENUM_LABEL_GOTO_LIBRARY_SEARCH),
+               MENU_ENUM_LABEL_GOTO_LIBRARY_SEARCH,
+               MENU_SETTING_ACTION, 0, 0, NULL))
+         count++;
+
 #if defined(HAVE_LIBRETRODB)
       if (settings->bools.menu_content_show_explore)
          if (menu_entries_append(info_list,
@@ -8010,6 +8027,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_AUDIO_SYNC,                      PARSE_ONLY_BOOL,     true  },
                {MENU_ENUM_LABEL_AUDIO_MAX_TIMING_SKEW,           PARSE_ONLY_FLOAT,    true  },
                {MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA,        PARSE_ONLY_FLOAT,    true  },
+               {MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_TARGET,       PARSE_ONLY_UINT,     true  },
             };
 
             for (i = 0; i < ARRAY_SIZE(build_list); i++)
@@ -8438,6 +8456,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_AI_SERVICE_MODE,          PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_AI_SERVICE_URL,           PARSE_ONLY_STRING, false},
                {MENU_ENUM_LABEL_AI_SERVICE_PAUSE,         PARSE_ONLY_BOOL,   false},
+               {MENU_ENUM_LABEL_AI_SERVICE_SEND_REGIONS,  PARSE_ONLY_BOOL,   false},
                {MENU_ENUM_LABEL_AI_SERVICE_SOURCE_LANG,   PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_AI_SERVICE_TARGET_LANG,   PARSE_ONLY_UINT,   false},
             };
@@ -8449,6 +8468,7 @@ unsigned menu_displaylist_build_list(
                   case MENU_ENUM_LABEL_AI_SERVICE_MODE:
                   case MENU_ENUM_LABEL_AI_SERVICE_URL:
                   case MENU_ENUM_LABEL_AI_SERVICE_PAUSE:
+                  case MENU_ENUM_LABEL_AI_SERVICE_SEND_REGIONS:
                   case MENU_ENUM_LABEL_AI_SERVICE_SOURCE_LANG:
                   case MENU_ENUM_LABEL_AI_SERVICE_TARGET_LANG:
                      if (ai_service_enable)
@@ -9204,12 +9224,20 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_NETPLAY_INPUT_LATENCY_FRAMES_MIN,   PARSE_ONLY_INT,    true},
                {MENU_ENUM_LABEL_NETPLAY_INPUT_LATENCY_FRAMES_RANGE, PARSE_ONLY_INT,    true},
                {MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL,              PARSE_ONLY_BOOL,   true},
+               {MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,                  PARSE_ONLY_BOOL,   true},
+#ifdef HAVE_ZSTD
+               {MENU_ENUM_LABEL_NETPLAY_ZSTD_LEVEL,                 PARSE_ONLY_UINT,   true},
+#endif
                {MENU_ENUM_LABEL_NETPLAY_SHARE_DIGITAL,              PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_NETPLAY_SHARE_ANALOG,               PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_GEKKONET_INPUT_PREDICTION,          PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_GEKKONET_SPECTATOR_DELAY,           PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_GEKKONET_MAX_SPECTATORS,            PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_GEKKONET_LOCAL_DELAY,               PARSE_ONLY_UINT,   true},
+               {MENU_ENUM_LABEL_GEKKONET_SNAPSHOT_CHECK_INTERVAL,   PARSE_ONLY_UINT,   true},
+               {MENU_ENUM_LABEL_GEKKONET_ROLLBACK_SPREAD,           PARSE_ONLY_UINT,   true},
+               {MENU_ENUM_LABEL_GEKKONET_RELAY_SERVER,              PARSE_ONLY_STRING, true},
+               {MENU_ENUM_LABEL_GEKKONET_RELAY_SESSION,             PARSE_ONLY_STRING, true},
                {MENU_ENUM_LABEL_GEKKONET_DESYNC_DETECTION,          PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_GEKKONET_LIMITED_SAVING,            PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_GEKKONET_ALLOW_LATE_JOIN,           PARSE_ONLY_BOOL,   true},
@@ -10668,6 +10696,12 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_AUDIO_LATENCY,                         PARSE_ONLY_UINT, true },
 #ifdef HAVE_MICROPHONE
                {MENU_ENUM_LABEL_MICROPHONE_LATENCY,                    PARSE_ONLY_UINT, true },
+#endif
+#ifdef HAVE_THREADS
+               {MENU_ENUM_LABEL_THREAD_ROLES_ENABLE,                   PARSE_ONLY_BOOL, true },
+#endif
+#if defined(HAVE_UDEV) && defined(HAVE_THREADS)
+               {MENU_ENUM_LABEL_INPUT_EVDEV_THREAD_ENABLE,             PARSE_ONLY_BOOL, true },
 #endif
             };
 
@@ -11070,6 +11104,8 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_SAVESTATE_AUTO_LOAD,                PARSE_ONLY_BOOL, true},
                {MENU_ENUM_LABEL_SAVESTATE_AUTO_INDEX,               PARSE_ONLY_BOOL, true},
                {MENU_ENUM_LABEL_SAVESTATE_MAX_KEEP,                 PARSE_ONLY_UINT, false},
+               {MENU_ENUM_LABEL_SAVESTATE_FILE_SYNC,                PARSE_ONLY_UINT, true},
+               {MENU_ENUM_LABEL_SAVESTATE_DEDUP_STORE,              PARSE_ONLY_BOOL, true},
                {MENU_ENUM_LABEL_REPLAY_AUTO_INDEX,                  PARSE_ONLY_BOOL, true},
                {MENU_ENUM_LABEL_REPLAY_MAX_KEEP,                    PARSE_ONLY_UINT, false},
                {MENU_ENUM_LABEL_REPLAY_CHECKPOINT_INTERVAL,         PARSE_ONLY_UINT, true},
@@ -11549,6 +11585,13 @@ unsigned menu_displaylist_build_list(
             static const menu_displaylist_build_info_t build_list[] = {
                {MENU_ENUM_LABEL_CORE_INFO_CACHE_ENABLE,            PARSE_ONLY_BOOL},
                {MENU_ENUM_LABEL_CORE_INFO_SAVESTATE_BYPASS,        PARSE_ONLY_BOOL},
+               {MENU_ENUM_LABEL_CONTENT_CACHE_SIZE,                PARSE_ONLY_UINT},
+#ifdef HAVE_ZSTD
+               {MENU_ENUM_LABEL_CONTENT_CACHE_COMPRESS,            PARSE_ONLY_BOOL},
+#endif
+#ifdef HAVE_VFS_ARCHIVE
+               {MENU_ENUM_LABEL_ARCHIVE_VFS_MOUNT,                 PARSE_ONLY_BOOL},
+#endif
                {MENU_ENUM_LABEL_CHECK_FOR_MISSING_FIRMWARE,        PARSE_ONLY_BOOL},
                {MENU_ENUM_LABEL_SYSTEMFILES_IN_CONTENT_DIR_ENABLE, PARSE_ONLY_BOOL},
                {MENU_ENUM_LABEL_CORE_OPTION_CATEGORY_ENABLE,       PARSE_ONLY_BOOL},
@@ -11787,6 +11830,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_FRAME_TIME_COUNTER_SETTINGS, PARSE_ACTION,     true },
                {MENU_ENUM_LABEL_FASTFORWARD_RATIO,           PARSE_ONLY_FLOAT, true },
                {MENU_ENUM_LABEL_FASTFORWARD_FRAMESKIP,       PARSE_ONLY_BOOL,  true },
+               {MENU_ENUM_LABEL_FASTFORWARD_TURBO,           PARSE_ONLY_BOOL,  true },
                {MENU_ENUM_LABEL_AUDIO_FASTFORWARD_MUTE,      PARSE_ONLY_BOOL,  true },
                {MENU_ENUM_LABEL_AUDIO_FASTFORWARD_SPEEDUP,   PARSE_ONLY_BOOL,  true },
                {MENU_ENUM_LABEL_SLOWMOTION_RATIO,            PARSE_ONLY_FLOAT, true },
@@ -12380,10 +12424,18 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type,
                   {MENU_ENUM_LABEL_NETPLAY_ALLOW_SLAVES,       PARSE_ONLY_BOOL,   true},
                   {MENU_ENUM_LABEL_NETPLAY_REQUIRE_SLAVES,     PARSE_ONLY_BOOL,   false},
                   {MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL,      PARSE_ONLY_BOOL,   true},
+                  {MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,          PARSE_ONLY_BOOL,   true},
+#ifdef HAVE_ZSTD
+                  {MENU_ENUM_LABEL_NETPLAY_ZSTD_LEVEL,         PARSE_ONLY_UINT,   true},
+#endif
                   {MENU_ENUM_LABEL_GEKKONET_INPUT_PREDICTION,   PARSE_ONLY_UINT,   true},
                   {MENU_ENUM_LABEL_GEKKONET_SPECTATOR_DELAY,    PARSE_ONLY_UINT,   true},
                   {MENU_ENUM_LABEL_GEKKONET_MAX_SPECTATORS,     PARSE_ONLY_UINT,   true},
                   {MENU_ENUM_LABEL_GEKKONET_LOCAL_DELAY,        PARSE_ONLY_UINT,   true},
+                  {MENU_ENUM_LABEL_GEKKONET_SNAPSHOT_CHECK_INTERVAL, PARSE_ONLY_UINT, true},
+                  {MENU_ENUM_LABEL_GEKKONET_ROLLBACK_SPREAD, PARSE_ONLY_UINT, true},
+                  {MENU_ENUM_LABEL_GEKKONET_RELAY_SERVER, PARSE_ONLY_STRING, true},
+                  {MENU_ENUM_LABEL_GEKKONET_RELAY_SESSION, PARSE_ONLY_STRING, true},
                   {MENU_ENUM_LABEL_GEKKONET_DESYNC_DETECTION,   PARSE_ONLY_BOOL,   true},
                   {MENU_ENUM_LABEL_GEKKONET_LIMITED_SAVING,     PARSE_ONLY_BOOL,   true},
                   {MENU_ENUM_LABEL_GEKKONET_ALLOW_LATE_JOIN,    PARSE_ONLY_BOOL,   true},
@@ -14142,6 +14194,14 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type,
                info->flags    |=  MD_FLAG_NEED_PUSH;
             }
             break;
+         case DISPLAYLIST_LIBRARY_SEARCH:
+            menu_entries_clear(info->list);
+            /* Results come ranked, never sort them */
+            count          = menu_displaylist_library_search(info->list,
+                  settings);
+            info->flags   &= ~MD_FLAG_NEED_SORT;
+            info->flags   |=  MD_FLAG_NEED_PUSH;
+            break;
          case DISPLAYLIST_SAVESTATE_LIST:
             {
                bool savestates_enabled = core_info_current_supports_savestate();
@@ -14193,6 +14253,18 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type,
                         count++;
                   }
                }
+
+               if (     savestates_enabled
+                     && settings->bools.quick_menu_show_save_load_state
+                     && settings->bools.savestate_dedup_store)
+               {
+                  if (menu_entries_append(info->list,
+                           msg_hash_to_str(MENU_ENUM_LABEL_VALUE_EXPORT_SAVE_STATE),
+                           msg_hash_to_str(MENU_ENUM_LABEL_EXPORT_SAVE_STATE),
+                           MENU_ENUM_LABEL_EXPORT_SAVE_STATE,
+                           MENU_SETTING_ACTION, 0, 0, NULL))
+                     count++;
+               }
 #ifdef HAVE_BSV_MOVIE
                if (     savestates_enabled
                      && settings->bools.quick_menu_show_replay)
@@ -99,6 +99,7 @@ enum menu_displaylist_ctl_state
    DISPLAYLIST_HISTORY,
    DISPLAYLIST_EXPLORE,
    DISPLAYLIST_CONTENTLESS_CORES,
+   DISPLAYLIST_LIBRARY_SEARCH,
    DISPLAYLIST_FAVORITES,
    DISPLAYLIST_PLAYLIST,
    DISPLAYLIST_VIDEO_HISTORY,
@@ -374,6 +375,8 @@ unsigned menu_displaylist_explore(file_list_t *list, settings_t *settings);
 #endif
 unsigned menu_displaylist_contentless_cores(file_list_t *list,
       enum menu_contentless_cores_display_type core_display_type);
+unsigned menu_displaylist_library_search(file_list_t *list,
+      settings_t *settings);
 
 enum filebrowser_enums filebrowser_get_type(void);
 
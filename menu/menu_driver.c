@@ -3358,6 +3358,8 @@ bool menu_driver_search_filter_enabled(const char *label, unsigned type)
                        || string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_IMAGES_LIST))
                        || string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_MUSIC_LIST))
                        || string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_VIDEO_LIST))
+                       /* > Library search */
+                       || string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST))
                        /* > Core updater */
                        || string_is_equal(label, msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_CORE_UPDATER_LIST))
                        /* > File browser (Load Content) */
@@ -6822,6 +6824,7 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
          menu_explore_free();
 #endif
          menu_contentless_cores_free();
+         menu_library_search_free();
 #endif
 
          if (menu_st->driver_data)
@@ -7259,6 +7262,8 @@ static int generic_menu_iterate(
 
    menu->menu_state_msg[0]         = '\0';
 
+   menu_library_search_iterate(menu_st, label);
+
    iterate_type                    = action_iterate_type(label);
    menu_st->flags                 &= ~MENU_ST_FLAG_IS_BINDING;
 
@@ -44,6 +44,7 @@
 #include "../gfx/gfx_thumbnail_path.h"
 #include "../gfx/font_driver.h"
 #include "../performance_counters.h"
+#include "../library_search.h"
 
 
 RETRO_BEGIN_DECLS
@@ -648,6 +649,11 @@ void menu_contentless_cores_get_info(const char *core_id,
       const contentless_core_info_entry_t **info);
 void menu_contentless_cores_flush_runtime(void);
 
+void menu_library_search_set_index(library_search_t *index);
+void menu_library_search_iterate(struct menu_state *menu_st,
+      const char *label);
+void menu_library_search_free(void);
+
 /* Returns true if search filter is enabled
  * for the specified menu list */
 bool menu_driver_search_filter_enabled(const char *label, unsigned type);
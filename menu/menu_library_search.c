@@ -0,0 +1,213 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <string/stdstring.h>
+
+#include "menu_driver.h"
+#include "menu_cbs.h"
+#include "menu_displaylist.h"
+#include "../configuration.h"
+#include "../file_path_special.h"
+#include "../playlist.h"
+#include "../tasks/tasks_internal.h"
+
+/* Index searched by the 'Search Library' list, built and kept
+ * up to date by task_library_search.c */
+static library_search_t *library_search_index = NULL;
+/* Text typed so far while the search keyboard is open */
+static char library_search_typed[MENU_SEARCH_FILTER_MAX_LENGTH] = {0};
+
+static bool menu_library_search_is_top(void)
+{
+   struct menu_state *menu_st = menu_state_get_ptr();
+   file_list_t *menu_stack    = MENU_LIST_GET(menu_st->entries.list, 0);
+
+   return menu_stack
+      && menu_stack->size
+      && string_is_equal(menu_stack->list[menu_stack->size - 1].label,
+            msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST));
+}
+
+static void menu_library_search_refresh(struct menu_state *menu_st)
+{
+   menu_st->selection_ptr = 0;
+   menu_st->flags        |=  MENU_ST_FLAG_ENTRIES_NEED_REFRESH
+                          |  MENU_ST_FLAG_PREVENT_POPULATE;
+}
+
+void menu_library_search_set_index(library_search_t *index)
+{
+   library_search_free(library_search_index);
+   library_search_index = index;
+
+   /* Results shown so far may point to entries
+    * that moved, the list must be refreshed */
+   if (menu_library_search_is_top())
+      menu_library_search_refresh(menu_state_get_ptr());
+}
+
+void menu_library_search_free(void)
+{
+   /* The update task reads the current index */
+   library_search_wait_for_update_task();
+   library_search_free(library_search_index);
+   library_search_index    = NULL;
+   library_search_typed[0] = '\0';
+}
+
+/* Refreshes results on every key typed into the search
+ * keyboard, instead of once the search is entered */
+void menu_library_search_iterate(struct menu_state *menu_st,
+      const char *label)
+{
+   const char *buffer;
+
+   if (     !(menu_st->flags & MENU_ST_FLAG_INP_DLG_KB_DISPLAY)
+         || !string_is_equal(label,
+            msg_hash_to_str(MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST)))
+   {
+      library_search_typed[0] = '\0';
+      return;
+   }
+
+   buffer = menu_input_dialog_get_buffer();
+   if (string_is_equal(buffer, library_search_typed))
+      return;
+
+   strlcpy(library_search_typed, buffer, sizeof(library_search_typed));
+   menu_library_search_refresh(menu_st);
+}
+
+static int action_sublabel_library_search_entry(
+      file_list_t *list, unsigned type, unsigned i,
+      const char *label, const char *path, char *s, size_t len)
+{
+   /* Label is the playlist the entry comes from */
+   fill_pathname(s, path_basename(label), "", len);
+   return 1;
+}
+
+static int action_ok_library_search_entry(const char *path,
+      const char *label, unsigned type, size_t idx, size_t entry_idx)
+{
+   playlist_config_t playlist_config;
+   playlist_t *playlist               = NULL;
+   const struct playlist_entry *entry = NULL;
+   settings_t *settings               = config_get_ptr();
+
+   playlist_config_set_path(&playlist_config, label);
+   playlist_config.capacity            = COLLECTION_SIZE;
+   playlist_config.old_format          = settings->bools.playlist_use_old_format;
+   playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
+   playlist_config_set_base_content_directory(&playlist_config,
+           settings->bools.playlist_portable_paths
+         ? settings->paths.directory_menu_content : NULL);
+
+   /* Entry actions work on the cached playlist. It is
+    * left unsorted: result indices follow the file */
+   if (playlist_get_cached())
+      playlist_free_cached();
+   if (!playlist_init_cached(&playlist_config))
+      return -1;
+
+   playlist = playlist_get_cached();
+   if (entry_idx >= playlist_size(playlist))
+      return -1;
+   playlist_get_index(playlist, entry_idx, &entry);
+
+   return generic_action_ok_displaylist_push(path, NULL,
+         (entry && entry->path) ? entry->path : label,
+         type, idx, entry_idx, ACTION_OK_DL_RPL_ENTRY);
+}
+
+unsigned menu_displaylist_library_search(file_list_t *list,
+      settings_t *settings)
+{
+   size_t i, count, _len;
+   char query[MENU_SEARCH_FILTER_MAX_LENGTH * (MENU_SEARCH_FILTER_MAX_TERMS + 1)];
+   library_search_result_t results[LIBRARY_SEARCH_MAX_RESULTS];
+   menu_search_terms_t *search = menu_entries_search_get_terms();
+
+   if (!library_search_index)
+   {
+      if (!library_search_update_in_progress(NULL))
+         task_push_library_search_update(NULL,
+               settings->paths.directory_playlist,
+               settings->paths.path_content_database,
+               settings->paths.directory_cache);
+
+      menu_entries_append(list,
+            msg_hash_to_str(MENU_ENUM_LABEL_VALUE_LIBRARY_SEARCH_INDEXING),
+            msg_hash_to_str(MENU_ENUM_LABEL_LIBRARY_SEARCH_INDEXING),
+            MENU_ENUM_LABEL_LIBRARY_SEARCH_INDEXING,
+            FILE_TYPE_NONE, 0, 0, NULL);
+      return (unsigned)list->size;
+   }
+
+   /* Search terms entered so far, then the one being typed */
+   query[0] = '\0';
+   _len     = 0;
+   if (search)
+      for (i = 0; i < search->size; i++)
+      {
+         _len += strlcpy(query + _len, search->terms[i],
+               sizeof(query) - _len);
+         _len += strlcpy(query + _len, " ", sizeof(query) - _len);
+      }
+   strlcpy(query + _len, library_search_typed, sizeof(query) - _len);
+
+   /* Pick up playlists changed since the list was last opened,
+    * only those are indexed again */
+   if (string_is_empty(query) && !library_search_update_in_progress(NULL))
+      task_push_library_search_update(library_search_index,
+            settings->paths.directory_playlist,
+            settings->paths.path_content_database,
+            settings->paths.directory_cache);
+
+   count = library_search_query(library_search_index, query,
+         results, ARRAY_SIZE(results));
+
+   for (i = 0; i < count; i++)
+   {
+      menu_file_list_cbs_t *cbs = NULL;
+
+      if (!menu_entries_append(list,
+               results[i].label,
+               results[i].playlist_path,
+               MENU_ENUM_LABEL_LIBRARY_SEARCH_ENTRY,
+               MENU_SETTING_ACTION, 0, results[i].entry_idx, NULL))
+         continue;
+
+      if ((cbs = (menu_file_list_cbs_t*)list->list[list->size - 1].actiondata))
+      {
+         cbs->action_ok       = action_ok_library_search_entry;
+         cbs->action_sublabel = action_sublabel_library_search_entry;
+      }
+   }
+
+   if (!list->size)
+      menu_entries_append(list,
+            msg_hash_to_str(string_is_empty(query)
+               ? MENU_ENUM_LABEL_VALUE_LIBRARY_SEARCH_HINT
+               : MENU_ENUM_LABEL_VALUE_NO_ENTRIES_TO_DISPLAY),
+            msg_hash_to_str(MENU_ENUM_LABEL_NO_ENTRIES_TO_DISPLAY),
+            MENU_ENUM_LABEL_NO_ENTRIES_TO_DISPLAY,
+            FILE_TYPE_NONE, 0, 0, NULL);
+
+   return (unsigned)list->size;
+}
@@ -103,6 +103,7 @@
 #include "../ui/ui_companion_driver.h"
 #include "../performance_counters.h"
 #include "../setting_list.h"
+#include "../state_writer.h"
 #include "../lakka.h"
 #ifdef HAVE_LAKKA_SWITCH
 #include "../lakka-switch.h"
@@ -7088,6 +7089,26 @@ static size_t setting_get_string_representation_uint_quit_on_close_content(
    return 0;
 }
 
+static size_t setting_get_string_representation_uint_savestate_file_sync(
+      rarch_setting_t *setting, char *s, size_t len)
+{
+   if (setting)
+   {
+      switch (*setting->value.target.unsigned_integer)
+      {
+         case STATE_WRITER_SYNC_NONE:
+            return strlcpy(s, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_OFF), len);
+         case STATE_WRITER_SYNC_FILE:
+            return strlcpy(s, msg_hash_to_str(
+                     MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_FILE), len);
+         case STATE_WRITER_SYNC_ATOMIC:
+            return strlcpy(s, msg_hash_to_str(
+                     MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_ATOMIC), len);
+      }
+   }
+   return 0;
+}
+
 static size_t setting_get_string_representation_uint_video_scale_integer_axis(
       rarch_setting_t *setting, char *s, size_t len)
 {
@@ -11147,6 +11168,57 @@ static bool setting_append_list(
                      bool_entries[i].flags);
             }
 
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.content_cache_size,
+                  MENU_ENUM_LABEL_CONTENT_CACHE_SIZE,
+                  MENU_ENUM_LABEL_VALUE_CONTENT_CACHE_SIZE,
+                  DEFAULT_CONTENT_CACHE_SIZE,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].ui_type   = ST_UI_TYPE_UINT_SPINBOX;
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            (*list)[list_info->index - 1].offset_by = 0;
+            menu_settings_list_current_add_range(list, list_info, 0, 4096, 32, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_ZSTD
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.content_cache_compress,
+                  MENU_ENUM_LABEL_CONTENT_CACHE_COMPRESS,
+                  MENU_ENUM_LABEL_VALUE_CONTENT_CACHE_COMPRESS,
+                  DEFAULT_CONTENT_CACHE_COMPRESS,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_ADVANCED);
+#endif
+
+#ifdef HAVE_VFS_ARCHIVE
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.archive_vfs_mount,
+                  MENU_ENUM_LABEL_ARCHIVE_VFS_MOUNT,
+                  MENU_ENUM_LABEL_VALUE_ARCHIVE_VFS_MOUNT,
+                  DEFAULT_ARCHIVE_VFS_MOUNT,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_ADVANCED);
+#endif
+
             END_SUB_GROUP(list, list_info, parent_group);
             END_GROUP(list, list_info, parent_group);
          }
@@ -11588,6 +11660,38 @@ static bool setting_append_list(
             (*list)[list_info->index - 1].action_ok     = &setting_action_ok_uint;
             menu_settings_list_current_add_range(list, list_info, 0, 999, 1, true, true);
 
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.savestate_file_sync,
+                  MENU_ENUM_LABEL_SAVESTATE_FILE_SYNC,
+                  MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC,
+                  DEFAULT_SAVESTATE_FILE_SYNC,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            (*list)[list_info->index - 1].get_string_representation =
+                  &setting_get_string_representation_uint_savestate_file_sync;
+            menu_settings_list_current_add_range(list, list_info, 0, STATE_WRITER_SYNC_LAST - 1, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.savestate_dedup_store,
+                  MENU_ENUM_LABEL_SAVESTATE_DEDUP_STORE,
+                  MENU_ENUM_LABEL_VALUE_SAVESTATE_DEDUP_STORE,
+                  DEFAULT_SAVESTATE_DEDUP_STORE,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_ADVANCED);
+
 #ifdef HAVE_BSV_MOVIE
             CONFIG_BOOL(
                   list, list_info,
@@ -14045,6 +14149,42 @@ static bool setting_append_list(
                   );
             SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_LAKKA_ADVANCED);
 
+#ifdef HAVE_THREADS
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.thread_roles_enable,
+                  MENU_ENUM_LABEL_THREAD_ROLES_ENABLE,
+                  MENU_ENUM_LABEL_VALUE_THREAD_ROLES_ENABLE,
+                  DEFAULT_THREAD_ROLES_ENABLE,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_ADVANCED
+                  );
+#endif
+
+#if defined(HAVE_UDEV) && defined(HAVE_THREADS)
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.input_evdev_thread_enable,
+                  MENU_ENUM_LABEL_INPUT_EVDEV_THREAD_ENABLE,
+                  MENU_ENUM_LABEL_VALUE_INPUT_EVDEV_THREAD_ENABLE,
+                  DEFAULT_INPUT_EVDEV_THREAD_ENABLE,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_ADVANCED
+                  );
+#endif
+
             /* Unlike all other shader-related menu entries
              * (which appear in the shaders quick menu, and
              * are thus hidden automatically on platforms
@@ -14728,6 +14868,22 @@ static bool setting_append_list(
          MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_AUDIO_REINIT);
          SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
 
+         CONFIG_UINT(
+               list, list_info,
+               &settings->uints.audio_rate_control_target,
+               MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_TARGET,
+               MENU_ENUM_LABEL_VALUE_AUDIO_RATE_CONTROL_TARGET,
+               DEFAULT_RATE_CONTROL_TARGET,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler);
+         (*list)[list_info->index - 1].action_ok     = &setting_action_ok_uint;
+         menu_settings_list_current_add_range(list, list_info, 0, 512, 1.0, true, true);
+         MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_AUDIO_REINIT);
+         SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
          CONFIG_FLOAT(
                list, list_info,
                &settings->floats.audio_max_timing_skew,
@@ -16457,6 +16613,22 @@ static bool setting_append_list(
                SD_FLAG_NONE
                );
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.fastforward_turbo,
+               MENU_ENUM_LABEL_FASTFORWARD_TURBO,
+               MENU_ENUM_LABEL_VALUE_FASTFORWARD_TURBO,
+               DEFAULT_FASTFORWARD_TURBO,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_NONE);
+         SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
          CONFIG_BOOL(
                list, list_info,
                &settings->bools.vrr_runloop_enable,
@@ -20780,6 +20952,21 @@ static bool setting_append_list(
                general_read_handler,
                SD_FLAG_NONE);
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.ai_service_send_regions,
+               MENU_ENUM_LABEL_AI_SERVICE_SEND_REGIONS,
+               MENU_ENUM_LABEL_VALUE_AI_SERVICE_SEND_REGIONS,
+               DEFAULT_AI_SERVICE_SEND_REGIONS,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_ADVANCED);
+
          CONFIG_UINT(
                list, list_info,
                &settings->uints.ai_service_source_lang,
@@ -23288,6 +23475,40 @@ static bool setting_append_list(
                   SD_FLAG_NONE);
             SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
 
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.netplay_udp_input,
+                  MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_INPUT,
+                  DEFAULT_NETPLAY_UDP_INPUT,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_ZSTD
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.netplay_zstd_level,
+                  MENU_ENUM_LABEL_NETPLAY_ZSTD_LEVEL,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_ZSTD_LEVEL,
+                  DEFAULT_NETPLAY_ZSTD_LEVEL,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].ui_type   = ST_UI_TYPE_UINT_SPINBOX;
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 1, 19, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
             CONFIG_UINT(
                   list, list_info,
                   &settings->uints.gekkonet_input_prediction,
@@ -23352,6 +23573,70 @@ static bool setting_append_list(
             menu_settings_list_current_add_range(list, list_info, 0, 30, 1, true, true);
             SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
 
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.gekkonet_snapshot_check_interval,
+                  MENU_ENUM_LABEL_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+                  MENU_ENUM_LABEL_VALUE_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+                  DEFAULT_GEKKONET_SNAPSHOT_CHECK_INTERVAL,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].ui_type   = ST_UI_TYPE_UINT_SPINBOX;
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 3600, 60, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.gekkonet_rollback_spread,
+                  MENU_ENUM_LABEL_GEKKONET_ROLLBACK_SPREAD,
+                  MENU_ENUM_LABEL_VALUE_GEKKONET_ROLLBACK_SPREAD,
+                  DEFAULT_GEKKONET_ROLLBACK_SPREAD,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].ui_type   = ST_UI_TYPE_UINT_SPINBOX;
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 8, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+
+            CONFIG_STRING(
+                  list, list_info,
+                  settings->paths.gekkonet_relay_server,
+                  sizeof(settings->paths.gekkonet_relay_server),
+                  MENU_ENUM_LABEL_GEKKONET_RELAY_SERVER,
+                  MENU_ENUM_LABEL_VALUE_GEKKONET_RELAY_SERVER,
+                  "",
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ALLOW_INPUT | SD_FLAG_ADVANCED);
+            (*list)[list_info->index - 1].ui_type       = ST_UI_TYPE_STRING_LINE_EDIT;
+            (*list)[list_info->index - 1].action_start  = setting_generic_action_start_default;
+
+            CONFIG_STRING(
+                  list, list_info,
+                  settings->paths.gekkonet_relay_session,
+                  sizeof(settings->paths.gekkonet_relay_session),
+                  MENU_ENUM_LABEL_GEKKONET_RELAY_SESSION,
+                  MENU_ENUM_LABEL_VALUE_GEKKONET_RELAY_SESSION,
+                  "",
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ALLOW_INPUT | SD_FLAG_ADVANCED);
+            (*list)[list_info->index - 1].ui_type       = ST_UI_TYPE_STRING_LINE_EDIT;
+            (*list)[list_info->index - 1].action_start  = setting_generic_action_start_default;
+
             CONFIG_BOOL(
                   list, list_info,
                   &settings->bools.gekkonet_desync_detection,
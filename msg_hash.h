@@ -467,6 +467,8 @@ enum msg_hash_enums
    MSG_CUSTOM_TIMING_GIVEN,
    MSG_SAVING_STATE,
    MSG_UNDOING_SAVE_STATE,
+   MSG_EXPORTED_SAVE_STATE_TO,
+   MSG_FAILED_TO_EXPORT_SAVE_STATE,
    MSG_LOADING_STATE,
    MSG_FAILED_TO_SAVE_STATE_TO,
    MSG_FAILED_TO_SAVE_SRAM,
@@ -1839,6 +1841,7 @@ enum msg_hash_enums
    MENU_LABEL(GOTO_VIDEO),
    MENU_LABEL(GOTO_EXPLORE),
    MENU_LABEL(GOTO_CONTENTLESS_CORES),
+   MENU_LABEL(GOTO_LIBRARY_SEARCH),
    MENU_LABEL(ADD_TO_FAVORITES),
    MENU_LABEL(ADD_TO_FAVORITES_PLAYLIST),
    MENU_LABEL(SET_CORE_ASSOCIATION),
@@ -2042,6 +2045,7 @@ enum msg_hash_enums
    MENU_ENUM_LABEL_DEFERRED_VIDEO_LIST,
    MENU_ENUM_LABEL_DEFERRED_EXPLORE_LIST,
    MENU_ENUM_LABEL_DEFERRED_CONTENTLESS_CORES_LIST,
+   MENU_ENUM_LABEL_DEFERRED_LIBRARY_SEARCH_LIST,
    MENU_ENUM_LABEL_DEFERRED_NETPLAY,
    MENU_ENUM_LABEL_DEFERRED_MUSIC,
    MENU_ENUM_LABEL_DEFERRED_BROWSE_URL_START,
@@ -2322,6 +2326,7 @@ enum msg_hash_enums
    MENU_LBL_H(AUDIO_VOLUME),
    MENU_LABEL(AUDIO_MIXER_VOLUME),
    MENU_LBL_H(AUDIO_RATE_CONTROL_DELTA),
+   MENU_LABEL(AUDIO_RATE_CONTROL_TARGET),
    MENU_LABEL(AUDIO_LATENCY),
    MENU_LABEL(AUDIO_RESAMPLER_QUALITY),
    MENU_LABEL(AUDIO_WASAPI_EXCLUSIVE_MODE),
@@ -2346,6 +2351,7 @@ enum msg_hash_enums
    MENU_LBL_H(LOAD_STATE),
    MENU_LABEL(UNDO_LOAD_STATE),
    MENU_LABEL(UNDO_SAVE_STATE),
+   MENU_LABEL(EXPORT_SAVE_STATE),
 
    MENU_LABEL(PLAY_REPLAY),
    MENU_LABEL(RECORD_REPLAY),
@@ -2485,6 +2491,10 @@ enum msg_hash_enums
 
    MENU_LABEL(SAVESTATE_AUTO_INDEX),
    MENU_LABEL(SAVESTATE_MAX_KEEP),
+   MENU_LABEL(SAVESTATE_FILE_SYNC),
+   MENU_LABEL(SAVESTATE_DEDUP_STORE),
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_FILE,
+   MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_SYNC_ATOMIC,
    MENU_LABEL(REPLAY_AUTO_INDEX),
    MENU_LABEL(REPLAY_MAX_KEEP),
    MENU_LABEL(SAVESTATE_AUTO_SAVE),
@@ -2539,6 +2549,8 @@ enum msg_hash_enums
    MENU_LABEL(NETPLAY_MAX_CONNECTIONS),
    MENU_LABEL(NETPLAY_MAX_PING),
    MENU_LABEL(NETPLAY_NAT_TRAVERSAL),
+   MENU_LABEL(NETPLAY_UDP_INPUT),
+   MENU_LABEL(NETPLAY_ZSTD_LEVEL),
    MENU_LABEL(NETPLAY_REQUEST_DEVICE_I),
    MENU_LABEL(NETPLAY_PING_SHOW),
    MENU_ENUM_LABEL_NETPLAY_REQUEST_DEVICE_1,
@@ -2557,6 +2569,10 @@ enum msg_hash_enums
    MENU_LABEL(GEKKONET_SPECTATOR_DELAY),
    MENU_LABEL(GEKKONET_MAX_SPECTATORS),
    MENU_LABEL(GEKKONET_LOCAL_DELAY),
+   MENU_LABEL(GEKKONET_SNAPSHOT_CHECK_INTERVAL),
+   MENU_LABEL(GEKKONET_ROLLBACK_SPREAD),
+   MENU_LABEL(GEKKONET_RELAY_SERVER),
+   MENU_LABEL(GEKKONET_RELAY_SESSION),
    MENU_LABEL(GEKKONET_DESYNC_DETECTION),
    MENU_LABEL(GEKKONET_LIMITED_SAVING),
    MENU_LABEL(GEKKONET_ALLOW_LATE_JOIN),
@@ -2602,6 +2618,7 @@ enum msg_hash_enums
 
    MENU_LBL_H(FASTFORWARD_RATIO),
    MENU_LABEL(FASTFORWARD_FRAMESKIP),
+   MENU_LABEL(FASTFORWARD_TURBO),
    MENU_LBL_H(VRR_RUNLOOP_ENABLE),
    MENU_LABEL(REWIND_ENABLE),
    MENU_LABEL(CHEAT_APPLY_AFTER_TOGGLE),
@@ -2880,6 +2897,11 @@ enum msg_hash_enums
    MENU_LABEL(RDB_ENTRY_CRC32),
    MENU_LABEL(RDB_ENTRY_DETAIL),
 
+   /* Library search */
+   MENU_LABEL(LIBRARY_SEARCH_ENTRY),
+   MENU_LABEL(LIBRARY_SEARCH_INDEXING),
+   MENU_ENUM_LABEL_VALUE_LIBRARY_SEARCH_HINT,
+
    /* Explore tab */
    MENU_LABEL(EXPLORE_INITIALISING_LIST),
    MENU_ENUM_LABEL_VALUE_EXPLORE_CATEGORY_RELEASE_YEAR,
@@ -2975,6 +2997,7 @@ enum msg_hash_enums
    MENU_LABEL(AI_SERVICE_URL),
    MENU_LABEL(AI_SERVICE_ENABLE),
    MENU_LABEL(AI_SERVICE_PAUSE),
+   MENU_LABEL(AI_SERVICE_SEND_REGIONS),
 
    MSG_ACCESSIBILITY_STARTUP,
    MSG_AI_SERVICE_STOPPED,
@@ -3029,6 +3052,11 @@ enum msg_hash_enums
    MENU_LBL_H(DUMMY_ON_CORE_SHUTDOWN),
    MENU_LBL_H(CHECK_FOR_MISSING_FIRMWARE),
    MENU_LABEL(CORE_INFO_SAVESTATE_BYPASS),
+   MENU_LABEL(CONTENT_CACHE_SIZE),
+   MENU_LABEL(CONTENT_CACHE_COMPRESS),
+   MENU_LABEL(ARCHIVE_VFS_MOUNT),
+   MENU_LABEL(THREAD_ROLES_ENABLE),
+   MENU_LABEL(INPUT_EVDEV_THREAD_ENABLE),
    MENU_LABEL(CORE_OPTION_CATEGORY_ENABLE),
    MENU_LABEL(CORE_INFO_CACHE_ENABLE),
 #ifndef HAVE_DYNAMIC
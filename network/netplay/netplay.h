@@ -33,6 +33,7 @@
 
 #include "netplay_defines.h"
 #include "netplay_gekkonet.h"
+#include "netplay_snapshot.h"
 
 #include "../../msg_hash.h"
 #include "../../retroarch_types.h"
@@ -163,12 +164,22 @@ typedef struct
    ra_gekkonet_ctx_t    gekkonet;
    ra_gekkonet_input_t  gekkonet_input;
    retro_callbacks_t    gekkonet_cbs;
+   /* Memory-map snapshots, for cores that declare them safe */
+   netplay_snapshot_t   gekkonet_snapshot;
+   /* Frame costs, for spreading rollbacks over several frames */
+   ra_gekkonet_budget_t gekkonet_budget;
    int                  gekkonet_local_actor;
    bool                 gekkonet_frame_consumed;
    bool                 gekkonet_running_frame;
    bool                 gekkonet_has_frame;
    bool                 gekkonet_needs_run;
    bool                 gekkonet_active;
+   bool                 gekkonet_use_snapshot;
+   /* Running a rolled back frame; audio and video are discarded */
+   bool                 gekkonet_resimulating;
+   /* A spread out rollback is still being resimulated; predicted
+    * frames are shown meanwhile */
+   bool                 gekkonet_catching_up;
    netplay_backend_t    backend;
    netplay_client_info_t *client_info;
    size_t client_info_count;
@@ -85,6 +85,7 @@
 #endif
 
 #include "netplay_private.h"
+#include "netplay_gekkonet_relay.h"
 
 #ifdef TCP_NODELAY
 #define SET_TCP_NODELAY(fd) \
@@ -235,6 +236,11 @@ static void netplay_gekkonet_reset(net_driver_state_t *net_st)
 
    memset(&net_st->gekkonet, 0, sizeof(net_st->gekkonet));
    memset(&net_st->gekkonet_input, 0, sizeof(net_st->gekkonet_input));
+   netplay_snapshot_free(&net_st->gekkonet_snapshot);
+   net_st->gekkonet_use_snapshot   = false;
+   net_st->gekkonet_resimulating   = false;
+   net_st->gekkonet_catching_up    = false;
+   memset(&net_st->gekkonet_budget, 0, sizeof(net_st->gekkonet_budget));
    net_st->gekkonet_local_actor = -1;
    net_st->gekkonet_frame_consumed = false;
    net_st->gekkonet_running_frame  = false;
@@ -243,18 +249,121 @@ static void netplay_gekkonet_reset(net_driver_state_t *net_st)
    net_st->gekkonet_active      = false;
 }
 
+static size_t netplay_gekkonet_full_size(void)
+{
+   return core_serialize_size();
+}
+
+static bool netplay_gekkonet_full_save(void *data, size_t len)
+{
+   retro_ctx_serialize_info_t serial_info = {0};
+   serial_info.data = data;
+   serial_info.size = len;
+   return core_serialize(&serial_info);
+}
+
+static bool netplay_gekkonet_full_load(const void *data, size_t len)
+{
+   retro_ctx_serialize_info_t serial_info = {0};
+   serial_info.data_const = data;
+   serial_info.size       = len;
+   return core_unserialize(&serial_info);
+}
+
+/**
+ * netplay_gekkonet_init_snapshot
+ *
+ * Sets up memory-map snapshots if the core declared them safe through
+ * RETRO_ENVIRONMENT_SET_ROLLBACK_SNAPSHOT_INTERFACE.
+ *
+ * Returns: size of a snapshot blob, or 0 if full serialization must be used.
+ **/
+static size_t netplay_gekkonet_init_snapshot(net_driver_state_t *net_st,
+      unsigned check_interval)
+{
+   unsigned i;
+   netplay_snapshot_cbs_t cbs;
+   rarch_system_info_t *sys_info = &runloop_state_get_ptr()->system;
+   const struct retro_rollback_snapshot_interface *iface =
+      &sys_info->rollback_snapshot;
+   netplay_snapshot_t *snap      = &net_st->gekkonet_snapshot;
+
+   if (!iface->residue_serialize || !sys_info->mmaps.num_descriptors)
+      return 0;
+
+   cbs.residue_size = iface->residue_size;
+   cbs.residue_save = iface->residue_serialize;
+   cbs.residue_load = iface->residue_unserialize;
+   cbs.full_size    = netplay_gekkonet_full_size;
+   cbs.full_save    = netplay_gekkonet_full_save;
+   cbs.full_load    = netplay_gekkonet_full_load;
+
+   if (!netplay_snapshot_init(snap, &cbs,
+            iface->residue_max_size, check_interval))
+      return 0;
+
+   for (i = 0; i < sys_info->mmaps.num_descriptors; i++)
+   {
+      const struct retro_memory_descriptor *desc =
+         &sys_info->mmaps.descriptors[i].core;
+
+      if (!desc->ptr || !desc->len || (desc->flags & RETRO_MEMDESC_CONST))
+         continue;
+
+      if (!netplay_snapshot_add_region(snap,
+               (uint8_t*)desc->ptr + desc->offset, desc->len))
+      {
+         netplay_snapshot_free(snap);
+         return 0;
+      }
+   }
+
+   netplay_snapshot_finalize(snap);
+   net_st->gekkonet_use_snapshot = true;
+
+   RARCH_LOG("[GekkoNet] Using memory-map snapshots (%u regions, %u bytes, residue %u bytes, check every %u saves).\n",
+         snap->num_regions, (unsigned)snap->regions_size,
+         (unsigned)snap->residue_cap, snap->check_interval);
+
+   return netplay_snapshot_size(snap);
+}
+
 static bool netplay_gekkonet_save_state_cb(void *dst,
       unsigned int capacity, unsigned int *out_size, unsigned int *out_crc)
 {
-   retro_ctx_serialize_info_t serial_info = {0};
-   serial_info.data = dst;
-   serial_info.size = capacity;
+   net_driver_state_t *net_st = &networking_driver_st;
+   size_t len                 = 0;
 
-   if (!core_serialize(&serial_info))
-      return false;
+   if (net_st->gekkonet_use_snapshot)
+   {
+      netplay_snapshot_t *snap = &net_st->gekkonet_snapshot;
+
+      if (!netplay_snapshot_save(snap, dst, capacity, &len))
+         return false;
+
+      /* Snapshots already handed to GekkoNet remain loadable, but from
+       * now on only trust full serialization. */
+      if (snap->failed)
+      {
+         RARCH_WARN("[GekkoNet] Memory-map snapshot does not match full serialization; "
+               "falling back to retro_serialize().\n");
+         net_st->gekkonet_use_snapshot = false;
+      }
+   }
+   else
+   {
+      retro_ctx_serialize_info_t serial_info = {0};
+      serial_info.data = dst;
+      serial_info.size = capacity;
+
+      if (!core_serialize(&serial_info))
+         return false;
+
+      len = serial_info.size;
+   }
 
    if (out_size)
-      *out_size = (unsigned int)serial_info.size;
+      *out_size = (unsigned int)len;
 
    if (out_crc)
    {
@@ -262,7 +371,7 @@ static bool netplay_gekkonet_save_state_cb(void *dst,
       const unsigned char *p = (const unsigned char*)dst;
       size_t i, j;
 
-      for (i = 0; i < serial_info.size; i++)
+      for (i = 0; i < len; i++)
       {
          crc ^= p[i];
          for (j = 0; j < 8; j++)
@@ -277,10 +386,13 @@ static bool netplay_gekkonet_save_state_cb(void *dst,
 static bool netplay_gekkonet_load_state_cb(const void *src,
       unsigned int size)
 {
-   retro_ctx_serialize_info_t serial_info = {0};
-   serial_info.data_const = src;
-   serial_info.size       = size;
-   return core_unserialize(&serial_info);
+   net_driver_state_t *net_st = &networking_driver_st;
+
+   if (     net_st->gekkonet_snapshot.cbs.residue_load
+         && netplay_snapshot_is_blob(src, size))
+      return netplay_snapshot_load(&net_st->gekkonet_snapshot, src, size);
+
+   return netplay_gekkonet_full_load(src, size);
 }
 
 static void netplay_gekkonet_run_frame_cb(void)
@@ -291,6 +403,27 @@ static void netplay_gekkonet_run_frame_cb(void)
       net_st->gekkonet_needs_run = true;
 }
 
+/* Runs a rolled back frame right away, with audio and video discarded. */
+static void netplay_gekkonet_resim_frame_cb(void)
+{
+   net_driver_state_t *net_st  = networking_state_get_ptr();
+   runloop_state_t *runloop_st = runloop_state_get_ptr();
+   retro_time_t start          = cpu_features_get_time_usec();
+
+   net_st->gekkonet_resimulating = true;
+#ifdef HAVE_THREADS
+   autosave_lock();
+#endif
+   runloop_st->current_core.retro_run();
+#ifdef HAVE_THREADS
+   autosave_unlock();
+#endif
+   net_st->gekkonet_resimulating = false;
+
+   ra_gekkonet_budget_record(&net_st->gekkonet_budget,
+         cpu_features_get_time_usec() - start, true);
+}
+
 static void netplay_gekkonet_session_event_cb(
       const GekkoSessionEvent *ev, void *userdata)
 {
@@ -362,12 +495,20 @@ static void netplay_gekkonet_pack_inputs(net_driver_state_t *net_st,
 static bool netplay_gekkonet_frame(net_driver_state_t *net_st)
 {
    static bool logged_frame_entry = false;
+   ra_gekkonet_ctx_t *ctx;
+   video_driver_state_t *video_st;
+   retro_time_t start;
+   unsigned pending;
+
    if (!netplay_backend_is_gekkonet(net_st))
       return false;
 
    if (net_st->gekkonet_running_frame)
       return true;
 
+   ctx      = &net_st->gekkonet;
+   video_st = video_state_get_ptr();
+
    net_st->gekkonet_running_frame = true;
    net_st->gekkonet_frame_consumed = false;
    net_st->gekkonet_has_frame      = false;
@@ -377,15 +518,45 @@ static bool netplay_gekkonet_frame(net_driver_state_t *net_st)
       RARCH_LOG("[GekkoNet] netplay_gekkonet_frame first entry\n");
       logged_frame_entry = true;
    }
+
+   if (video_st->av_info.timing.fps > 0.0)
+      net_st->gekkonet_budget.frame_period =
+         (int64_t)(1000000.0 / video_st->av_info.timing.fps);
+
+   /* GekkoNet keeps advancing while a spread out rollback is replayed,
+    * and predicted frames are presented meanwhile. */
    netplay_gekkonet_pack_inputs(net_st, &net_st->gekkonet_input);
 
    if (net_st->gekkonet_local_actor >= 0)
-      ra_gekkonet_push_local_input(&net_st->gekkonet,
+      ra_gekkonet_push_local_input(ctx,
             net_st->gekkonet_local_actor, &net_st->gekkonet_input);
 
-   ra_gekkonet_update(&net_st->gekkonet);
+   ra_gekkonet_update(ctx);
+
+   /* The window is not restarted by rollbacks arriving while catching
+    * up, so the replay always converges within it. */
+   pending = ra_gekkonet_pending_resim(ctx);
+   if (!net_st->gekkonet_catching_up && pending)
+      ra_gekkonet_budget_begin(&net_st->gekkonet_budget);
+
+   start = cpu_features_get_time_usec();
+   ra_gekkonet_process_events(ctx,
+         ra_gekkonet_budget_allow(&net_st->gekkonet_budget, pending));
+   ra_gekkonet_budget_record_events(&net_st->gekkonet_budget,
+         cpu_features_get_time_usec() - start);
+
+   if (ra_gekkonet_is_predicting(ctx))
+   {
+      if (!net_st->gekkonet_catching_up)
+         RARCH_DBG("[GekkoNet] Spreading a %u frame rollback (%lld usec per frame).\n",
+               pending, (long long)net_st->gekkonet_budget.resim_cost);
+      net_st->gekkonet_catching_up = true;
+   }
+   else
+      net_st->gekkonet_catching_up = false;
+
    /* Align with builtin netplay timing: let the main runloop decide if it should skip. */
-   net_st->gekkonet_has_frame      = net_st->gekkonet.advanced_frame;
+   net_st->gekkonet_has_frame      = ctx->advanced_frame;
    net_st->gekkonet_frame_consumed = net_st->gekkonet_has_frame;
    net_st->gekkonet_running_frame  = false;
    return true;
@@ -400,6 +571,8 @@ static bool netplay_gekkonet_init_session(net_driver_state_t *net_st,
    unsigned max_players = 2;
    unsigned max_specs   = settings ? settings->uints.gekkonet_max_spectators : 0;
    size_t state_sz      = core_serialize_size();
+   const char *relay    = settings ? settings->paths.gekkonet_relay_server : NULL;
+   char relay_addr[NAME_MAX_LENGTH + 8];
 
    if (!state_sz)
    {
@@ -439,8 +612,49 @@ static bool netplay_gekkonet_init_session(net_driver_state_t *net_st,
    params.post_sync_joining       = settings ? settings->bools.gekkonet_allow_late_join : false;
    params.desync_detection        = settings ? settings->bools.gekkonet_desync_detection : false;
 
+   /* Through a relay, every member uses its player index as its slot:
+    * the host is player 1, a client the first player it requests a
+    * device for, or player 2. */
+   if (relay && *relay)
+   {
+      if (string_is_empty(settings->paths.gekkonet_relay_session))
+      {
+         RARCH_ERR("[GekkoNet] A relay needs a session name.\n");
+         core_unset_netplay_callbacks();
+         return false;
+      }
+      if (strchr(relay, ':'))
+         strlcpy(relay_addr, relay, sizeof(relay_addr));
+      else
+         snprintf(relay_addr, sizeof(relay_addr), "%s:%u", relay,
+               (unsigned)GEKKONET_RELAY_DEFAULT_PORT);
+      params.relay_server  = relay_addr;
+      params.relay_session = settings->paths.gekkonet_relay_session;
+      params.relay_slot    = 0;
+      if (net_st->flags & NET_DRIVER_ST_FLAG_NETPLAY_IS_CLIENT)
+      {
+         unsigned i;
+         params.relay_slot = 1;
+         for (i = 1; i < params.num_players; i++)
+         {
+            if (settings->bools.netplay_request_devices[i])
+            {
+               params.relay_slot = (unsigned char)i;
+               break;
+            }
+         }
+      }
+   }
+
    netplay_gekkonet_reset(net_st);
 
+   {
+      size_t snap_sz = netplay_gekkonet_init_snapshot(net_st,
+            settings ? settings->uints.gekkonet_snapshot_check_interval : 0);
+      if (snap_sz > params.state_size)
+         params.state_size = (unsigned int)snap_sz;
+   }
+
    if (!params.num_players)
       params.num_players = 1;
 
@@ -457,18 +671,45 @@ static bool netplay_gekkonet_init_session(net_driver_state_t *net_st,
 
    ra_gekkonet_set_run_frame_cb(&net_st->gekkonet,
          netplay_gekkonet_run_frame_cb);
+   ra_gekkonet_set_resim_frame_cb(&net_st->gekkonet,
+         netplay_gekkonet_resim_frame_cb);
+   ra_gekkonet_budget_init(&net_st->gekkonet_budget, 0,
+         settings ? settings->uints.gekkonet_rollback_spread : 0);
    ra_gekkonet_set_session_event_cb(&net_st->gekkonet,
          netplay_gekkonet_session_event_cb, NULL);
 
-   net_st->gekkonet_local_actor = ra_gekkonet_add_actor(
-         &net_st->gekkonet, LocalPlayer, NULL);
+   /* Every relayed peer is known by its slot up front. All players are
+    * added in slot order, so that every member agrees on the player
+    * handles. */
+   if (params.relay_server)
+   {
+      unsigned slot;
+      for (slot = 0; slot < params.num_players; slot++)
+      {
+         char addr[32];
+         int remote;
+         if (slot == params.relay_slot)
+         {
+            net_st->gekkonet_local_actor = ra_gekkonet_add_actor(
+                  &net_st->gekkonet, LocalPlayer, NULL);
+            continue;
+         }
+         snprintf(addr, sizeof(addr), RA_GEKKONET_RELAY_PREFIX "%u", slot);
+         remote = ra_gekkonet_add_actor(&net_st->gekkonet, RemotePlayer, addr);
+         RARCH_LOG("[GekkoNet] add relayed peer %s handle=%d\n", addr, remote);
+      }
+   }
+   else
+      net_st->gekkonet_local_actor = ra_gekkonet_add_actor(
+            &net_st->gekkonet, LocalPlayer, NULL);
+
    if (net_st->gekkonet_local_actor < 0)
    {
       netplay_gekkonet_reset(net_st);
       return false;
    }
 
-   if (server && *server)
+   if (!params.relay_server && server && *server)
    {
       char addr[96];
       snprintf(addr, sizeof(addr), "%s:%hu", server,
@@ -1061,7 +1302,10 @@ static bool netplay_handshake_init_send(netplay_t *netplay,
 
    header[0] = htonl(NETPLAY_MAGIC);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED
+         | (netplay->udp_input ? NETPLAY_CAP_UDP_INPUT : 0)
+         | (NETPLAY_COMPRESSION_SUPPORTED_ZSTD
+            ? netplay->zstd_level << NETPLAY_CAP_ZSTD_LEVEL_SHIFT : 0));
 
    if (netplay->is_server)
    {
@@ -1198,7 +1442,16 @@ static int select_compression(netplay_t *netplay, uint32_t compression)
 
    compression &= NETPLAY_COMPRESSION_SUPPORTED;
 
-   if (compression & NETPLAY_COMPRESSION_ZLIB)
+   /* Prefer zstd, it's both faster and smaller */
+   if (compression & NETPLAY_COMPRESSION_ZSTD)
+   {
+      ctrans = &netplay->compress_zstd;
+      if (!ctrans->compression_backend)
+         ctrans->compression_backend =
+            trans_stream_get_zstd_compress_backend();
+      ret = NETPLAY_COMPRESSION_ZSTD;
+   }
+   else if (compression & NETPLAY_COMPRESSION_ZLIB)
    {
       ctrans = &netplay->compress_zlib;
       if (!ctrans->compression_backend)
@@ -1407,6 +1660,15 @@ bool netplay_handshake_init(netplay_t *netplay,
       return false;
    connection->compression_supported = (uint32_t)compression;
 
+   connection->zstd_level = (ntohl(header[2]) >> NETPLAY_CAP_ZSTD_LEVEL_SHIFT)
+      & NETPLAY_CAP_ZSTD_LEVEL_MASK;
+   if (!connection->zstd_level)
+      connection->zstd_level = netplay->zstd_level;
+
+   /* Input also goes over UDP only if both sides offer it */
+   if (netplay->udp_input && (ntohl(header[2]) & NETPLAY_CAP_UDP_INPUT))
+      connection->flags |= NETPLAY_CONN_FLAG_UDP_CAPABLE;
+
    if (!netplay->is_server)
    {
       /* If a password is demanded, ask for it */
@@ -1705,6 +1967,40 @@ static bool netplay_handshake_sync(netplay_t *netplay,
          return false;
    }
 
+   /* Offer the datagram input channel. Datagrams are only taken from
+    * the host this connection comes from. */
+   connection->udp_token    = 0;
+   connection->udp_addr_len = sizeof(connection->udp_addr);
+   if (     (connection->flags & NETPLAY_CONN_FLAG_UDP_CAPABLE)
+         && getpeername(connection->fd,
+               (struct sockaddr*)&connection->udp_addr,
+               &connection->udp_addr_len) == 0)
+   {
+      do
+      {
+         if (!netplay_udp_random(&connection->udp_token,
+                  sizeof(connection->udp_token)))
+         {
+            RARCH_WARN("[Netplay] No entropy source, not offering UDP input.\n");
+            connection->udp_token = 0;
+            break;
+         }
+      } while (!connection->udp_token);
+   }
+
+   if (connection->udp_token)
+   {
+      uint32_t payload[2];
+
+      connection->udp_acked = 0;
+
+      payload[0] = htonl(netplay->udp_port);
+      payload[1] = htonl(connection->udp_token);
+      if (!netplay_send_raw_cmd(netplay, connection,
+            NETPLAY_CMD_UDP_INPUT, payload, sizeof(payload)))
+         return false;
+   }
+
    if (!netplay_send_flush(&connection->send_packet_buffer,
          connection->fd, false))
       return false;
@@ -4524,7 +4820,9 @@ static void netplay_hangup(netplay_t *netplay,
          MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
 
    socket_close(connection->fd);
-   connection->flags &= ~NETPLAY_CONN_FLAG_ACTIVE;
+   connection->flags &= ~(NETPLAY_CONN_FLAG_ACTIVE
+         | NETPLAY_CONN_FLAG_UDP_CAPABLE | NETPLAY_CONN_FLAG_UDP_ACTIVE);
+   connection->udp_token = 0;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
    netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
 
@@ -5625,6 +5923,350 @@ static void netplay_answer_ping(netplay_t *netplay,
          false);
 }
 
+/**
+ * netplay_udp_addr_port
+ *
+ * Get or, if 'port' is nonzero, set the port of a socket address.
+ */
+static uint16_t netplay_udp_addr_port(struct sockaddr_storage *addr,
+      uint16_t port)
+{
+   switch (((struct sockaddr*)addr)->sa_family)
+   {
+      case AF_INET:
+         if (port)
+            ((struct sockaddr_in*)addr)->sin_port = htons(port);
+         return ntohs(((struct sockaddr_in*)addr)->sin_port);
+#ifdef HAVE_INET6
+      case AF_INET6:
+         if (port)
+            ((struct sockaddr_in6*)addr)->sin6_port = htons(port);
+         return ntohs(((struct sockaddr_in6*)addr)->sin6_port);
+#endif
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+/**
+ * netplay_udp_addr_match
+ *
+ * Whether two socket addresses are the same host, and if 'port' is set,
+ * the same port.
+ */
+static bool netplay_udp_addr_match(const struct sockaddr_storage *a,
+      const struct sockaddr_storage *b, bool port)
+{
+   if (((const struct sockaddr*)a)->sa_family
+         != ((const struct sockaddr*)b)->sa_family)
+      return false;
+
+   switch (((const struct sockaddr*)a)->sa_family)
+   {
+      case AF_INET:
+         {
+            const struct sockaddr_in *a4 = (const struct sockaddr_in*)a;
+            const struct sockaddr_in *b4 = (const struct sockaddr_in*)b;
+            return a4->sin_addr.s_addr == b4->sin_addr.s_addr
+               && (!port || a4->sin_port == b4->sin_port);
+         }
+#ifdef HAVE_INET6
+      case AF_INET6:
+         {
+            const struct sockaddr_in6 *a6 = (const struct sockaddr_in6*)a;
+            const struct sockaddr_in6 *b6 = (const struct sockaddr_in6*)b;
+            return !memcmp(&a6->sin6_addr, &b6->sin6_addr,
+                     sizeof(a6->sin6_addr))
+               && (!port || a6->sin6_port == b6->sin6_port);
+         }
+#endif
+      default:
+         break;
+   }
+
+   return false;
+}
+
+/**
+ * netplay_udp_init_client
+ *
+ * Accept the server's offer of a datagram input channel. Datagrams go
+ * to the address we're already connected to over TCP.
+ */
+static bool netplay_udp_init_client(netplay_t *netplay,
+      struct netplay_connection *connection, uint16_t port, uint32_t token)
+{
+   int fd;
+
+   connection->udp_addr_len = sizeof(connection->udp_addr);
+   if (getpeername(connection->fd, (struct sockaddr*)&connection->udp_addr,
+            &connection->udp_addr_len) < 0
+         || !port
+         || !netplay_udp_addr_port(&connection->udp_addr, port))
+      return false;
+
+   if (netplay->udp_fd < 0)
+   {
+      fd = socket(((struct sockaddr*)&connection->udp_addr)->sa_family,
+            SOCK_DGRAM, 0);
+      if (fd < 0)
+         return false;
+      if (!socket_nonblock(fd))
+      {
+         socket_close(fd);
+         return false;
+      }
+      SET_FD_CLOEXEC(fd)
+      netplay->udp_fd = fd;
+   }
+
+   connection->udp_token = token;
+   connection->udp_acked = 0;
+   netplay_udp_window_reset(&netplay->udp_window, 0, 0);
+
+   RARCH_LOG("[Netplay] Sending input over UDP to port %hu as well.\n",
+         (unsigned short)port);
+   return true;
+}
+
+/**
+ * netplay_udp_pack_input
+ *
+ * Flatten our input for this frame the way send_input_frame does.
+ *
+ * Returns the number of words, or 0 if it can't be sent as a datagram.
+ */
+static uint32_t netplay_udp_pack_input(netplay_t *netplay,
+      struct delta_frame *dframe, uint32_t devices, uint32_t *input)
+{
+   uint32_t device;
+   uint32_t words = 0;
+
+   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   {
+      netplay_input_state_t istate;
+      if (!(devices & (1<<device)))
+         continue;
+      istate = dframe->real_input[device];
+      while (istate && (!istate->used
+               || istate->client_num != netplay->self_client_num))
+         istate = istate->next;
+      if (!istate || words + istate->size > NETPLAY_UDP_MAX_WORDS)
+         return 0;
+      memcpy(input + words, istate->data, istate->size * sizeof(uint32_t));
+      words += istate->size;
+   }
+
+   return words;
+}
+
+/**
+ * netplay_udp_send_input
+ *
+ * Send every peer on the datagram channel our input frames it has not
+ * acknowledged yet, along with our own acknowledgement. Their TCP copy
+ * has already been queued.
+ */
+static void netplay_udp_send_input(netplay_t *netplay,
+      struct delta_frame *dframe)
+{
+   size_t i;
+   uint8_t buf[NETPLAY_UDP_MAX_PACKET];
+
+   if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
+   {
+      uint32_t input[NETPLAY_UDP_MAX_WORDS];
+      uint32_t devices = netplay->client_devices[netplay->self_client_num];
+      uint32_t words   = netplay_udp_pack_input(netplay, dframe, devices,
+            input);
+
+      netplay_udp_window_push(&netplay->udp_window, dframe->frame,
+            devices, words, input);
+   }
+   else
+      netplay_udp_window_reset(&netplay->udp_window, 0, 0);
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      size_t _len;
+      uint32_t peer;
+      struct netplay_connection *connection = &netplay->connections[i];
+
+      if (     !(connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+            || !(connection->flags & NETPLAY_CONN_FLAG_UDP_CAPABLE)
+            ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED)
+            || !connection->udp_token)
+         continue;
+
+      /* We learn a client's address from its first datagram */
+      if (netplay->is_server
+            && !(connection->flags & NETPLAY_CONN_FLAG_UDP_ACTIVE))
+         continue;
+
+      peer = netplay->is_server ? (uint32_t)(i + 1) : 0;
+      _len = netplay_udp_encode(&netplay->udp_window, connection->udp_acked,
+            connection->udp_token, netplay->read_frame_count[peer],
+            (uint16_t)netplay->self_client_num, buf, sizeof(buf));
+      if (_len)
+         sendto(netplay->udp_fd, (const char*)buf, _len, 0,
+               (struct sockaddr*)&connection->udp_addr,
+               connection->udp_addr_len);
+   }
+}
+
+/**
+ * netplay_udp_handle_input
+ *
+ * Take the frames from a datagram that are next in line for their client,
+ * exactly as if NETPLAY_CMD_INPUT had delivered them. Anything else is
+ * left for the TCP stream.
+ */
+static void netplay_udp_handle_input(netplay_t *netplay,
+      struct netplay_connection *connection, const netplay_udp_packet_t *pkt)
+{
+   uint32_t i, client_num;
+
+   if (connection->mode != NETPLAY_CONNECTION_PLAYING)
+      return;
+
+   if (netplay->is_server)
+      client_num = (uint32_t)(connection - netplay->connections + 1);
+   /* Only the server's own input reaches clients this way */
+   else if (pkt->client_num)
+      return;
+   else
+      client_num = 0;
+
+   if (     !(netplay->connected_players & (1<<client_num))
+         || pkt->devices != netplay->client_devices[client_num]
+         || pkt->words   != netplay_expected_input_size(netplay, pkt->devices))
+      return;
+
+   for (i = 0; i < pkt->count; i++)
+   {
+      uint32_t input[NETPLAY_UDP_MAX_WORDS];
+      uint32_t device;
+      uint32_t words = 0;
+      uint32_t frame = pkt->first_frame + i;
+      struct delta_frame *dframe;
+
+      /* Already have it? */
+      if ((int32_t)(frame - netplay->read_frame_count[client_num]) < 0)
+         continue;
+      /* A gap; wait for the next datagram or TCP */
+      if (frame != netplay->read_frame_count[client_num])
+         break;
+
+      dframe = &netplay->buffer[netplay->read_ptr[client_num]];
+      if (!netplay_delta_frame_ready(netplay, dframe, frame))
+         break;
+
+      netplay_udp_packet_input(pkt, i, input);
+      for (device = 0; device < MAX_INPUT_DEVICES; device++)
+      {
+         netplay_input_state_t istate;
+         uint32_t dsize;
+         if (!(pkt->devices & (1<<device)))
+            continue;
+
+         dsize  = netplay_expected_input_size(netplay, 1 << device);
+         istate = netplay_input_state_for(&dframe->real_input[device],
+               client_num, dsize, false, false);
+         if (!istate)
+            return;
+         memcpy(istate->data, input + words, dsize * sizeof(uint32_t));
+         words += dsize;
+      }
+      dframe->have_real[client_num] = true;
+
+      netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
+      netplay->read_frame_count[client_num]++;
+
+      if (netplay->is_server)
+      {
+         /* Forward it on if it's past data */
+         if (dframe->frame <= netplay->self_frame_count)
+            send_input_frame(netplay, dframe, NULL, connection, client_num,
+                  false);
+      }
+      else
+      {
+         netplay->server_ptr         = netplay->read_ptr[0];
+         netplay->server_frame_count = netplay->read_frame_count[0];
+      }
+   }
+}
+
+/**
+ * netplay_udp_poll
+ *
+ * Read everything waiting on the datagram input channel.
+ */
+static void netplay_udp_poll(netplay_t *netplay)
+{
+   uint8_t buf[NETPLAY_UDP_MAX_PACKET];
+
+   for (;;)
+   {
+      size_t i;
+      netplay_udp_packet_t pkt;
+      struct sockaddr_storage addr;
+      socklen_t addr_len                    = sizeof(addr);
+      struct netplay_connection *connection = NULL;
+      ssize_t recvd = recvfrom(netplay->udp_fd, (char*)buf, sizeof(buf), 0,
+            (struct sockaddr*)&addr, &addr_len);
+
+      if (recvd < 0)
+         break;
+
+      if (!netplay_udp_decode(buf, (size_t)recvd, &pkt) || !pkt.token)
+         continue;
+
+      for (i = 0; i < netplay->connections_size; i++)
+      {
+         struct netplay_connection *conn = &netplay->connections[i];
+         if (     (conn->flags & NETPLAY_CONN_FLAG_ACTIVE)
+               && (conn->flags & NETPLAY_CONN_FLAG_UDP_CAPABLE)
+               && (conn->mode >= NETPLAY_CONNECTION_CONNECTED)
+               &&  conn->udp_token == pkt.token)
+         {
+            connection = conn;
+            break;
+         }
+      }
+      if (!connection)
+         continue;
+
+      /* Only the host at the other end of the TCP connection may use its
+       * token. The server follows a client to a new port, e.g. if its
+       * NAT rebinds; a client only listens to the server's port. */
+      if (!netplay_udp_addr_match(&addr, &connection->udp_addr,
+               !netplay->is_server))
+         continue;
+
+      if (netplay->is_server)
+      {
+         memcpy(&connection->udp_addr, &addr, sizeof(addr));
+         connection->udp_addr_len = addr_len;
+      }
+
+      if (!(connection->flags & NETPLAY_CONN_FLAG_UDP_ACTIVE))
+      {
+         connection->flags |= NETPLAY_CONN_FLAG_UDP_ACTIVE;
+         RARCH_LOG("[Netplay] Receiving input over UDP from %s.\n",
+               connection->nick);
+      }
+
+      if ((int32_t)(pkt.ack - connection->udp_acked) > 0)
+         connection->udp_acked = pkt.ack;
+
+      if (pkt.count)
+         netplay_udp_handle_input(netplay, connection, &pkt);
+   }
+}
+
 #undef RECV
 #define RECV(buf, sz) \
    recvd = netplay_recv(&connection->recv_packet_buffer, connection->fd, (buf), (sz)); \
@@ -6302,6 +6944,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
             size_t   load_ptr;
             uint32_t load_frame_count;
             uint32_t rd, wn;
+            uint32_t zstd_flags = 0;
             struct compression_transcoder *ctrans = NULL;
             NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
 
@@ -6375,6 +7018,19 @@ static bool netplay_get_cmd(netplay_t *netplay,
             state_size     = ntohl(state_size);
             state_size_raw = cmd_size - (sizeof(frame) + sizeof(state_size));
 
+            if (connection->compression_supported == NETPLAY_COMPRESSION_ZSTD)
+            {
+               if (state_size_raw < sizeof(zstd_flags))
+               {
+                  RARCH_ERR("[Netplay] Received invalid payload size for NETPLAY_CMD_LOAD_SAVESTATE.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+               RECV(&zstd_flags, sizeof(zstd_flags))
+                  return false;
+               zstd_flags      = ntohl(zstd_flags);
+               state_size_raw -= sizeof(zstd_flags);
+            }
+
             if (state_size_raw > netplay->zbuffer_size)
             {
                RARCH_ERR("[Netplay] Netplay state load with an unexpected save state size.\n");
@@ -6389,6 +7045,9 @@ static bool netplay_get_cmd(netplay_t *netplay,
                case NETPLAY_COMPRESSION_ZLIB:
                   ctrans = &netplay->compress_zlib;
                   break;
+               case NETPLAY_COMPRESSION_ZSTD:
+                  ctrans = &netplay->compress_zstd;
+                  break;
                default:
                   ctrans = &netplay->compress_nil;
                   break;
@@ -6406,6 +7065,19 @@ static bool netplay_get_cmd(netplay_t *netplay,
                }
             }
 
+#ifdef HAVE_ZSTD
+            if (zstd_flags & NETPLAY_ZSTD_PREV_STATE_DICT)
+            {
+               if (!netplay->zstd_dict)
+               {
+                  RARCH_ERR("[Netplay] Netplay state load against a state we never received.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+               trans_stream_zstd_set_dictionary(ctrans->decompression_stream,
+                     netplay->zstd_dict, netplay->zstd_dict_size);
+            }
+#endif
+
             ctrans->decompression_backend->set_in(
                ctrans->decompression_stream,
                netplay->zbuffer, state_size_raw);
@@ -6416,6 +7088,26 @@ static bool netplay_get_cmd(netplay_t *netplay,
                ctrans->decompression_stream,
                true, &rd, &wn, NULL);
 
+#ifdef HAVE_ZSTD
+            /* The server compresses the next state against this one */
+            if (ctrans == &netplay->compress_zstd)
+            {
+               trans_stream_zstd_set_dictionary(ctrans->decompression_stream,
+                     NULL, 0);
+               if (netplay->zstd_dict_size != state_size)
+               {
+                  uint8_t *dict = (uint8_t*)realloc(netplay->zstd_dict,
+                        state_size);
+                  if (!dict)
+                     return false;
+                  netplay->zstd_dict      = dict;
+                  netplay->zstd_dict_size = state_size;
+               }
+               memcpy(netplay->zstd_dict, netplay->buffer[load_ptr].state,
+                     state_size);
+            }
+#endif
+
             if (memcmp(netplay->buffer[load_ptr].state, "NETPLAY", 7) != 0)
             {
                if (state_size != netplay->coremem_size)
@@ -6811,6 +7503,36 @@ static bool netplay_get_cmd(netplay_t *netplay,
          }
          break;
 
+      case NETPLAY_CMD_UDP_INPUT:
+         {
+            uint32_t payload[2];
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_UDP_INPUT from client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (cmd_size != sizeof(payload))
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_UDP_INPUT with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+               return false;
+
+            /* Failing here only means input keeps going over TCP alone */
+            if (     (connection->flags & NETPLAY_CONN_FLAG_UDP_CAPABLE)
+                  && !netplay_udp_init_client(netplay, connection,
+                        (uint16_t)ntohl(payload[0]), ntohl(payload[1])))
+            {
+               connection->flags &= ~NETPLAY_CONN_FLAG_UDP_CAPABLE;
+               RARCH_WARN("[Netplay] Could not set up UDP input.\n");
+            }
+         }
+         break;
+
       case NETPLAY_CMD_SETTING_ALLOW_PAUSING:
          {
             uint32_t allow_pausing;
@@ -6907,6 +7629,10 @@ static void netplay_poll_net_input(netplay_t *netplay)
    bool had_input;
    struct netplay_connection *connection;
 
+   /* Datagrams first, so input they carry beats its TCP copy */
+   if (netplay->udp_fd >= 0)
+      netplay_udp_poll(netplay);
+
    do
    {
       had_input = false;
@@ -7318,6 +8044,74 @@ try_ipv4:
    return true;
 }
 
+/**
+ * netplay_init_udp_socket
+ *
+ * Open the server's datagram input socket, on the TCP port if it's free.
+ */
+static bool netplay_init_udp_socket(netplay_t *netplay)
+{
+   struct sockaddr_storage addr;
+   socklen_t addr_len = sizeof(addr);
+   int fd;
+
+   if (getsockname(netplay->listen_fd, (struct sockaddr*)&addr,
+            &addr_len) < 0)
+      return false;
+
+   fd = socket(((struct sockaddr*)&addr)->sa_family, SOCK_DGRAM, 0);
+   if (fd < 0)
+      return false;
+
+#if defined(HAVE_INET6) && defined(IPV6_V6ONLY)
+   if (((struct sockaddr*)&addr)->sa_family == AF_INET6)
+   {
+      int on = 0;
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&on, sizeof(on));
+   }
+#endif
+
+   /* LAN discovery may already hold the default port for UDP */
+   if (bind(fd, (struct sockaddr*)&addr, addr_len) < 0)
+   {
+      switch (((struct sockaddr*)&addr)->sa_family)
+      {
+         case AF_INET:
+            ((struct sockaddr_in*)&addr)->sin_port = 0;
+            break;
+#ifdef HAVE_INET6
+         case AF_INET6:
+            ((struct sockaddr_in6*)&addr)->sin6_port = 0;
+            break;
+#endif
+         default:
+            break;
+      }
+      if (bind(fd, (struct sockaddr*)&addr, addr_len) < 0)
+         goto failure;
+   }
+
+   if (!socket_nonblock(fd))
+      goto failure;
+   SET_FD_CLOEXEC(fd)
+
+   addr_len = sizeof(addr);
+   if (getsockname(fd, (struct sockaddr*)&addr, &addr_len) < 0)
+      goto failure;
+
+   netplay->udp_fd   = fd;
+   netplay->udp_port = netplay_udp_addr_port(&addr, 0);
+   RARCH_LOG("[Netplay] Accepting input over UDP on port %hu.\n",
+         (unsigned short)netplay->udp_port);
+
+   return true;
+
+failure:
+   socket_close(fd);
+   RARCH_WARN("[Netplay] Failed to set up UDP input, using TCP only.\n");
+   return false;
+}
+
 static bool netplay_init_socket_buffers(netplay_t *netplay)
 {
    /* Make our packet buffer big enough for a save state and stall-frames-many
@@ -7532,6 +8326,9 @@ static void netplay_free(netplay_t *netplay)
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   if (netplay->udp_fd >= 0)
+      socket_close(netplay->udp_fd);
+
    if (netplay->mitm_handler)
    {
       for (i = 0; i < ARRAY_SIZE(netplay->mitm_handler->pending); i++)
@@ -7583,6 +8380,13 @@ static void netplay_free(netplay_t *netplay)
    if (netplay->compress_zlib.decompression_stream)
       netplay->compress_zlib.decompression_backend->stream_free(
          netplay->compress_zlib.decompression_stream);
+   if (netplay->compress_zstd.compression_stream)
+      netplay->compress_zstd.compression_backend->stream_free(
+         netplay->compress_zstd.compression_stream);
+   if (netplay->compress_zstd.decompression_stream)
+      netplay->compress_zstd.decompression_backend->stream_free(
+         netplay->compress_zstd.decompression_stream);
+   free(netplay->zstd_dict);
 
    free(netplay);
 }
@@ -7611,6 +8415,7 @@ static netplay_t *netplay_new(const char *server, const char *mitm,
       enum netplay_modus modus)
 {
    netplay_t *netplay        = (netplay_t*)calloc(1, sizeof(*netplay));
+   settings_t *settings      = config_get_ptr();
 
    if (!netplay)
       return NULL;
@@ -7622,6 +8427,7 @@ static netplay_t *netplay_new(const char *server, const char *mitm,
    netplay->modus            = modus;
    netplay->crcs_valid       = true;
    netplay->listen_fd        = -1;
+   netplay->udp_fd           = -1;
    netplay->next_announce    = -1;
    netplay->next_ping        = -1;
    netplay->simple_rand_next = 1;
@@ -7632,10 +8438,20 @@ static netplay_t *netplay_new(const char *server, const char *mitm,
 
    netplay_key_init(netplay);
 
+   /* The datagram input channel needs a direct path to the host */
+   netplay->udp_input        = settings->bools.netplay_udp_input
+      && modus == NETPLAY_MODUS_INPUT_FRAME_SYNC
+      && !mitm && string_is_empty(mitm_session);
+
+   netplay->zstd_level       = settings->uints.netplay_zstd_level;
+   if (!netplay->zstd_level)
+      netplay->zstd_level    = 1;
+   else if (netplay->zstd_level > NETPLAY_CAP_ZSTD_LEVEL_MASK)
+      netplay->zstd_level    = NETPLAY_CAP_ZSTD_LEVEL_MASK;
+
    if (netplay->is_server)
    {
       unsigned i;
-      settings_t *settings = config_get_ptr();
 
       netplay->tcp_port     = port;
       netplay->ext_tcp_port = port;
@@ -7715,6 +8531,9 @@ static netplay_t *netplay_new(const char *server, const char *mitm,
          || !netplay_init_buffers(netplay))
       goto failure;
 
+   if (netplay->is_server && netplay->udp_input)
+      netplay->udp_input = netplay_init_udp_socket(netplay);
+
    return netplay;
 
 failure:
@@ -7733,6 +8552,146 @@ failure:
  * Send a loaded savestate to those connected peers using the given compression
  * scheme.
  */
+#ifdef HAVE_ZSTD
+/**
+ * netplay_send_savestate_zstd
+ *
+ * Send a savestate to the peers using zstd. Peers that were sent the
+ * previous state get it compressed against that one, the others get a
+ * copy without a dictionary.
+ */
+static void netplay_send_savestate_zstd(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info,
+   struct compression_transcoder *z)
+{
+   size_t i;
+   unsigned pass;
+   unsigned level = netplay->zstd_level;
+   bool     sent  = false;
+
+   /* Everyone waits for the state, take the lowest level asked for */
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (     (connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+            && (connection->mode >= NETPLAY_CONNECTION_CONNECTED)
+            && (connection->compression_supported == NETPLAY_COMPRESSION_ZSTD)
+            && (connection->zstd_level < level))
+         level = connection->zstd_level;
+   }
+   z->compression_backend->define(z->compression_stream, "level", level);
+
+   for (pass = 0; pass < 2; pass++)
+   {
+      uint32_t header[5];
+      uint32_t rd, wn;
+      bool     use_dict   = !pass;
+      bool     compressed = false;
+
+      if (use_dict && !netplay->zstd_dict)
+         continue;
+
+      for (i = 0; i < netplay->connections_size; i++)
+      {
+         struct netplay_connection *connection = &netplay->connections[i];
+
+         if (     !(connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+               ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED)
+               ||  (connection->compression_supported
+                     != NETPLAY_COMPRESSION_ZSTD)
+               ||  (!!(connection->flags & NETPLAY_CONN_FLAG_ZSTD_DICT)
+                     != use_dict))
+            continue;
+
+         if (!compressed)
+         {
+            /* Long distance matching, with a window that covers both,
+             * finds the unchanged parts of a large state in the
+             * previous one. The receiver accepts windows up to 2^27. */
+            uint32_t window_log = 0;
+            if (use_dict)
+            {
+               window_log = 10;
+               while (window_log < 27 && ((size_t)1 << window_log)
+                     < netplay->zstd_dict_size + serial_info->size)
+                  window_log++;
+            }
+            trans_stream_zstd_set_dictionary(z->compression_stream,
+                  use_dict ? netplay->zstd_dict      : NULL,
+                  use_dict ? netplay->zstd_dict_size : 0);
+            z->compression_backend->define(z->compression_stream,
+                  "window_log", window_log);
+            z->compression_backend->define(z->compression_stream,
+                  "long_distance", use_dict);
+            z->compression_backend->set_in(z->compression_stream,
+               (const uint8_t*)serial_info->data_const,
+               (uint32_t)serial_info->size);
+            z->compression_backend->set_out(z->compression_stream,
+               netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
+            if (!z->compression_backend->trans(z->compression_stream, true,
+                  &rd, &wn, NULL))
+            {
+               /* Catastrophe! */
+               trans_stream_zstd_set_dictionary(z->compression_stream,
+                     NULL, 0);
+               for (i = 0; i < netplay->connections_size; i++)
+                  netplay_hangup(netplay, &netplay->connections[i]);
+               return;
+            }
+
+            header[0]  = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
+            header[1]  = htonl(wn + 3*sizeof(uint32_t));
+            header[2]  = htonl(netplay->run_frame_count);
+            header[3]  = htonl(serial_info->size);
+            header[4]  = htonl(use_dict ? NETPLAY_ZSTD_PREV_STATE_DICT : 0);
+            compressed = true;
+         }
+
+         if (  !netplay_send(&connection->send_packet_buffer,
+                 connection->fd, header, sizeof(header))
+            || !netplay_send(&connection->send_packet_buffer,
+                 connection->fd, netplay->zbuffer, wn))
+            netplay_hangup(netplay, connection);
+         else
+            sent = true;
+      }
+   }
+
+   trans_stream_zstd_set_dictionary(z->compression_stream, NULL, 0);
+
+   if (!sent)
+      return;
+
+   /* Whoever was sent this state can use it as the next dictionary */
+   if (netplay->zstd_dict_size != serial_info->size)
+   {
+      uint8_t *dict = (uint8_t*)realloc(netplay->zstd_dict,
+            serial_info->size);
+      if (!dict)
+      {
+         free(netplay->zstd_dict);
+         netplay->zstd_dict      = NULL;
+         netplay->zstd_dict_size = 0;
+         return;
+      }
+      netplay->zstd_dict      = dict;
+      netplay->zstd_dict_size = serial_info->size;
+   }
+   memcpy(netplay->zstd_dict, serial_info->data_const, serial_info->size);
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (     (connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+            && (connection->mode >= NETPLAY_CONNECTION_CONNECTED)
+            && (connection->compression_supported == NETPLAY_COMPRESSION_ZSTD))
+         connection->flags |=  NETPLAY_CONN_FLAG_ZSTD_DICT;
+      else
+         connection->flags &= ~NETPLAY_CONN_FLAG_ZSTD_DICT;
+   }
+}
+#endif
+
 static void netplay_send_savestate(netplay_t *netplay,
    retro_ctx_serialize_info_t *serial_info, uint32_t cx,
    struct compression_transcoder *z, bool is_legacy_data)
@@ -8127,6 +9086,11 @@ void netplay_load_savestate(netplay_t *netplay,
       if (netplay->compress_zlib.compression_backend)
          netplay_send_savestate(netplay, serial_info, NETPLAY_COMPRESSION_ZLIB,
             &netplay->compress_zlib, false);
+#ifdef HAVE_ZSTD
+      if (netplay->compress_zstd.compression_backend)
+         netplay_send_savestate_zstd(netplay, serial_info,
+            &netplay->compress_zstd);
+#endif
    }
 }
 
@@ -8401,6 +9365,8 @@ static bool get_self_input_state(
             && (connection->mode >= NETPLAY_CONNECTION_CONNECTED))
          netplay_send_cur_input(netplay, &netplay->connections[i]);
    }
+   if (netplay->udp_fd >= 0)
+      netplay_udp_send_input(netplay, ptr);
 
    /* Handle any delayed state changes */
    if (netplay->is_server)
@@ -8769,7 +9735,8 @@ void video_frame_net(const void *data, unsigned width,
    if (netplay_backend_is_gekkonet(net_st))
    {
       /* Use the standard video path to mirror builtin netplay behavior. */
-      video_driver_frame(data, width, height, pitch);
+      if (!net_st->gekkonet_resimulating)
+         video_driver_frame(data, width, height, pitch);
       return;
    }
    if (!netplay)
@@ -8785,7 +9752,8 @@ void audio_sample_net(int16_t left, int16_t right)
    netplay_t          *netplay = net_st->data;
    if (netplay_backend_is_gekkonet(net_st))
    {
-      audio_driver_sample(left, right);
+      if (!net_st->gekkonet_resimulating)
+         audio_driver_sample(left, right);
       return;
    }
    if (!netplay)
@@ -8801,6 +9769,8 @@ size_t audio_sample_batch_net(const int16_t *data, size_t frames)
    netplay_t          *netplay = net_st->data;
    if (netplay_backend_is_gekkonet(net_st))
    {
+      if (net_st->gekkonet_resimulating)
+         return frames;
       return audio_driver_sample_batch(data, frames);
    }
    if (!netplay)
@@ -9434,20 +10404,24 @@ bool init_netplay_gekkonet(const char *server, unsigned port, const char *mitm_s
 {
    net_driver_state_t *net_st = &networking_driver_st;
    settings_t *settings       = config_get_ptr();
+   bool use_relay             = settings
+      && *settings->paths.gekkonet_relay_server;
+   bool want_client;
    (void)mitm_session;
 
    /* Resolve server from settings if not provided. */
    if (!server || !*server)
       server = settings ? settings->paths.netplay_server : NULL;
 
-   /* Decide role before overriding flags: if caller intended client or provided a server, require server. */
+   /* Decide role before overriding flags: if caller intended client or provided a server, require server.
+    * Through a relay, the client needs no server address. */
+   want_client = (net_st->flags & NET_DRIVER_ST_FLAG_NETPLAY_IS_CLIENT) || (server && *server);
    {
-      bool want_client = (net_st->flags & NET_DRIVER_ST_FLAG_NETPLAY_IS_CLIENT) || (server && *server);
       net_st->backend = NETPLAY_BACKEND_GEKKONET;
 
       if (want_client)
       {
-         if (!server || !*server)
+         if ((!server || !*server) && !use_relay)
          {
             RARCH_ERR("[GekkoNet] No server provided for client join; aborting init.\n");
             return false;
@@ -9476,7 +10450,7 @@ bool init_netplay_gekkonet(const char *server, unsigned port, const char *mitm_s
 
    /* Reinstate flags after successful init in case they were cleared elsewhere. */
    net_st->flags |= NET_DRIVER_ST_FLAG_NETPLAY_ENABLED;
-   if (server && *server)
+   if (want_client)
       net_st->flags |= NET_DRIVER_ST_FLAG_NETPLAY_IS_CLIENT;
    else
       net_st->flags &= ~NET_DRIVER_ST_FLAG_NETPLAY_IS_CLIENT;
@@ -9989,7 +10963,8 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
          break;
 
       case RARCH_NETPLAY_CTL_IS_REPLAYING:
-         ret = (netplay && netplay->is_replay);
+         ret = (netplay && netplay->is_replay)
+            || (using_gekkonet && net_st->gekkonet_resimulating);
          break;
 
       case RARCH_NETPLAY_CTL_IS_SERVER:
@@ -10025,8 +11000,9 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
 
       case RARCH_NETPLAY_CTL_POST_FRAME:
          if (using_gekkonet)
-            /* GekkoNet drives frame timing internally. */
-            ret = true;
+            /* GekkoNet drives frame timing internally; just take the
+             * saves that were waiting for the presented frame. */
+            ra_gekkonet_flush_events(&net_st->gekkonet);
          else if (netplay)
             netplay_post_frame(netplay);
          break;
@@ -19,7 +19,8 @@
  *   4. Each frame:
  *        - Pack local input into a blob of size params->input_size.
  *        - Call ra_gekkonet_push_local_input().
- *        - Call ra_gekkonet_update().
+ *        - Call ra_gekkonet_update(), then ra_gekkonet_process_events().
+ *        - Run the presented frame, then call ra_gekkonet_flush_events().
  *        - In your input callback, read current frame input from
  *          ra_gekkonet_get_current_input().
  *
@@ -34,20 +35,24 @@
 #include <errno.h>
 #include <stdio.h>
 
-#include "../../encodings/crc32.h"
+#include <encodings/crc32.h>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <wincrypt.h>
 #pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "advapi32.lib")
 #else
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netdb.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #endif
 
 #include "netplay_gekkonet.h"
+#include "netplay_gekkonet_relay.h"
 
 /* Simple logging macros. You can override these via compiler flags
  * or by defining GEKKONET_LOG/GEKKONET_WARN/GEKKONET_ERR before
@@ -60,12 +65,29 @@
 #define GEKKONET_ERR(fmt, ...)  fprintf(stderr, "[gekkonet ERROR] " fmt "\n", ##__VA_ARGS__)
 #endif
 
+/* Resend REGISTER every this many polls (about once a second at 60 Hz),
+ * more often until the relay has answered. */
+#define RA_GEKKONET_RELAY_KEEPALIVE      60
+#define RA_GEKKONET_RELAY_KEEPALIVE_INIT 10
+
 typedef struct ra_gekkonet_udp_adapter
 {
     GekkoNetAdapter api;
     int             sockfd;
     unsigned short  port;
     struct ra_gekkonet_ctx *owner;
+
+    /* Relay mode: everything goes to relay_addr, wrapped in the
+     * netplay_gekkonet_relay.h framing. */
+    struct sockaddr_in relay_addr;
+    uint64_t           relay_session;
+    uint64_t           relay_nonce;
+    unsigned           relay_polls;
+    uint8_t            relay_slot;
+    bool               relay;
+    bool               relay_registered;
+    bool               relay_rejected;
+    uint8_t            relay_buf[GEKKONET_RELAY_MAX_PACKET];
 } ra_gekkonet_udp_adapter_t;
 
 static void ra_gekkonet_udp_adapter_destroy(ra_gekkonet_udp_adapter_t *adapter);
@@ -363,6 +385,64 @@ static bool ra_gekkonet_normalize_addr(const char *addr_in,
     }
 }
 
+/* Peers behind a relay are addressed as RA_GEKKONET_RELAY_PREFIX "<slot>". */
+static bool ra_gekkonet_relay_parse_addr(const char *addr, size_t len,
+                                         uint8_t    *slot)
+{
+    const size_t prefix_len = sizeof(RA_GEKKONET_RELAY_PREFIX) - 1;
+    unsigned     val        = 0;
+    size_t       i;
+
+    if (!addr || len <= prefix_len
+          || strncmp(addr, RA_GEKKONET_RELAY_PREFIX, prefix_len))
+        return false;
+
+    for (i = prefix_len; i < len && addr[i]; i++)
+    {
+        if (addr[i] < '0' || addr[i] > '9')
+            return false;
+        val = val * 10 + (unsigned)(addr[i] - '0');
+        if (val >= GEKKONET_RELAY_MAX_SLOTS)
+            return false;
+    }
+
+    *slot = (uint8_t)val;
+    return true;
+}
+
+static void ra_gekkonet_relay_register(ra_gekkonet_udp_adapter_t *adapter)
+{
+    uint8_t pkt[GEKKONET_RELAY_REGISTER_SIZE];
+
+    gekkonet_relay_write_register(pkt, GEKKONET_RELAY_REGISTER,
+            adapter->relay_session, adapter->relay_slot, adapter->relay_nonce);
+    sendto(adapter->sockfd, (const char*)pkt, sizeof(pkt), 0,
+           (struct sockaddr*)&adapter->relay_addr,
+           (socklen_t)sizeof(adapter->relay_addr));
+}
+
+static void ra_gekkonet_relay_send(ra_gekkonet_udp_adapter_t *adapter,
+                                   const GekkoNetAddress     *addr,
+                                   const char                *data,
+                                   int                        length)
+{
+    uint8_t slot;
+
+    if (!ra_gekkonet_relay_parse_addr((const char*)addr->data,
+                addr->size, &slot))
+        return;
+    if (length > GEKKONET_RELAY_MAX_PACKET - GEKKONET_RELAY_DATA_SIZE)
+        return;
+
+    gekkonet_relay_write_header(adapter->relay_buf, GEKKONET_RELAY_DATA);
+    adapter->relay_buf[GEKKONET_RELAY_HEADER_SIZE] = slot;
+    memcpy(adapter->relay_buf + GEKKONET_RELAY_DATA_SIZE, data, (size_t)length);
+    sendto(adapter->sockfd, (const char*)adapter->relay_buf,
+           GEKKONET_RELAY_DATA_SIZE + length, 0,
+           (struct sockaddr*)&adapter->relay_addr,
+           (socklen_t)sizeof(adapter->relay_addr));
+}
+
 static void ra_gekkonet_udp_send(GekkoNetAddress *addr,
                                  const char      *data,
                                  int              length)
@@ -374,6 +454,12 @@ static void ra_gekkonet_udp_send(GekkoNetAddress *addr,
    if (!g_udp_adapter || !addr || !data || length <= 0)
        return;
 
+   if (g_udp_adapter->relay)
+   {
+       ra_gekkonet_relay_send(g_udp_adapter, addr, data, length);
+       return;
+   }
+
    memset(&dst, 0, sizeof(dst));
    if (!ra_gekkonet_parse_addr(addr, host, sizeof(host), &port))
        return;
@@ -420,6 +506,18 @@ static GekkoNetResult **ra_gekkonet_udp_receive(int *length)
     if (!g_udp_adapter || !length)
         return NULL;
 
+    if (g_udp_adapter->relay)
+    {
+        unsigned interval = g_udp_adapter->relay_registered
+            ? RA_GEKKONET_RELAY_KEEPALIVE
+            : RA_GEKKONET_RELAY_KEEPALIVE_INIT;
+        if (++g_udp_adapter->relay_polls >= interval)
+        {
+            g_udp_adapter->relay_polls = 0;
+            ra_gekkonet_relay_register(g_udp_adapter);
+        }
+    }
+
     for (;;)
     {
         unsigned char buffer[2048];
@@ -463,17 +561,60 @@ static GekkoNetResult **ra_gekkonet_udp_receive(int *length)
             char addrbuf[96];
             const char *ip = inet_ntop(AF_INET, &src.sin_addr, ipbuf, sizeof(ipbuf));
             unsigned short port = ntohs(src.sin_port);
-            GekkoNetResult *res = (GekkoNetResult*)malloc(sizeof(*res));
+            const unsigned char *payload = buffer;
+            GekkoNetResult *res;
             size_t addr_len;
 
+            /* Behind a relay, only accept its DATA packets and report
+             * them as coming from the sending slot. */
+            if (g_udp_adapter->relay)
+            {
+                uint8_t type;
+
+                if (     src.sin_addr.s_addr != g_udp_adapter->relay_addr.sin_addr.s_addr
+                      || src.sin_port        != g_udp_adapter->relay_addr.sin_port)
+                    continue;
+
+                type = gekkonet_relay_read_header(buffer, (size_t)recvd);
+                if (type == GEKKONET_RELAY_REGISTERED)
+                {
+                    if (!g_udp_adapter->relay_registered)
+                        GEKKONET_LOG("Registered with relay as slot %u",
+                                     (unsigned)g_udp_adapter->relay_slot);
+                    g_udp_adapter->relay_registered = true;
+                    g_udp_adapter->relay_rejected   = false;
+                    continue;
+                }
+                if (type == GEKKONET_RELAY_REJECTED)
+                {
+                    if (!g_udp_adapter->relay_rejected)
+                        GEKKONET_ERR("Relay refused slot %u, it is held by another member",
+                                     (unsigned)g_udp_adapter->relay_slot);
+                    g_udp_adapter->relay_rejected = true;
+                    continue;
+                }
+                if (type != GEKKONET_RELAY_DATA || recvd <= GEKKONET_RELAY_DATA_SIZE)
+                    continue;
+
+                ip      = RA_GEKKONET_RELAY_PREFIX;
+                payload = buffer + GEKKONET_RELAY_DATA_SIZE;
+                recvd  -= GEKKONET_RELAY_DATA_SIZE;
+                snprintf(addrbuf, sizeof(addrbuf), "%s%u", ip,
+                         (unsigned)buffer[GEKKONET_RELAY_HEADER_SIZE]);
+            }
+            else if (ip)
+                snprintf(addrbuf, sizeof(addrbuf), "%s:%hu", ip, port);
+
+            res = (GekkoNetResult*)malloc(sizeof(*res));
             if (!res || !ip)
             {
                 free(res);
                 break;
             }
 
-            snprintf(addrbuf, sizeof(addrbuf), "%s:%hu", ip, port);
-            addr_len      = strlen(addrbuf);
+            /* Sized like the addresses ra_gekkonet_add_actor() registers,
+             * terminator included, since GekkoNet compares them bytewise. */
+            addr_len      = strlen(addrbuf) + 1;
             res->addr.data = malloc(addr_len);
             if (!res->addr.data)
             {
@@ -490,7 +631,7 @@ static GekkoNetResult **ra_gekkonet_udp_receive(int *length)
                 free(res);
                 break;
             }
-            memcpy(res->data, buffer, (size_t)recvd);
+            memcpy(res->data, payload, (size_t)recvd);
             res->data_len = (unsigned int)recvd;
 
             if (g_udp_adapter && g_udp_adapter->owner)
@@ -524,6 +665,102 @@ const void *ra_gekkonet_get_current_input(const ra_gekkonet_ctx_t *ctx)
     return ctx ? ctx->current_input : NULL;
 }
 
+/* Fills buf from the system's entropy source. */
+static bool ra_gekkonet_random(void *buf, size_t len)
+{
+#ifdef _WIN32
+    HCRYPTPROV prov;
+    bool       ok;
+
+    if (!CryptAcquireContext(&prov, NULL, NULL, PROV_RSA_FULL,
+                CRYPT_VERIFYCONTEXT | CRYPT_SILENT))
+        return false;
+    ok = CryptGenRandom(prov, (DWORD)len, (BYTE*)buf) != 0;
+    CryptReleaseContext(prov, 0);
+    return ok;
+#else
+    size_t got = 0;
+    int    fd  = open("/dev/urandom", O_RDONLY);
+
+    if (fd < 0)
+        return false;
+    while (got < len)
+    {
+        ssize_t n = read(fd, (uint8_t*)buf + got, len - got);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+                continue;
+            break;
+        }
+        got += (size_t)n;
+    }
+    close(fd);
+    return got == len;
+#endif
+}
+
+static bool ra_gekkonet_relay_init(ra_gekkonet_udp_adapter_t  *adapter,
+                                   const ra_gekkonet_params_t *params)
+{
+    char     normalized[128];
+    char     host[64];
+    unsigned short port = 0;
+    GekkoNetAddress addr;
+
+    /* Everyone without a session name would share one session */
+    if (!params->relay_session || !*params->relay_session)
+    {
+        GEKKONET_ERR("a relay needs a session name");
+        return false;
+    }
+    if (params->relay_slot >= params->num_players)
+    {
+        GEKKONET_ERR("relay slot %u is not a player of this session",
+                     (unsigned)params->relay_slot);
+        return false;
+    }
+
+    /* Proves to the relay that a later REGISTER from another address
+     * (e.g. after a NAT rebinding) still comes from us */
+    do
+    {
+        if (!ra_gekkonet_random(&adapter->relay_nonce,
+                    sizeof(adapter->relay_nonce)))
+        {
+            GEKKONET_ERR("no entropy source for the relay nonce");
+            return false;
+        }
+    } while (!adapter->relay_nonce);
+
+    if (!ra_gekkonet_normalize_addr(params->relay_server,
+                normalized, sizeof(normalized)))
+        return false;
+
+    addr.data = normalized;
+    addr.size = (unsigned int)strlen(normalized);
+    if (!ra_gekkonet_parse_addr(&addr, host, sizeof(host), &port))
+        return false;
+
+    memset(&adapter->relay_addr, 0, sizeof(adapter->relay_addr));
+    adapter->relay_addr.sin_family = AF_INET;
+    adapter->relay_addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host, &adapter->relay_addr.sin_addr) != 1)
+        return false;
+
+    adapter->relay_session    = gekkonet_relay_session_id(params->relay_session);
+    adapter->relay_slot       = params->relay_slot;
+    adapter->relay_polls      = 0;
+    adapter->relay_registered = false;
+    adapter->relay_rejected   = false;
+    adapter->relay            = true;
+
+    GEKKONET_LOG("Using relay %s (slot %u)", normalized,
+                 (unsigned)adapter->relay_slot);
+    ra_gekkonet_relay_register(adapter);
+    return true;
+}
+
 /* Initialize GekkoNet session with given parameters and callbacks.
  * Returns true on success, false on failure.
  */
@@ -590,10 +827,23 @@ bool ra_gekkonet_init(ra_gekkonet_ctx_t              *ctx,
    }
    ctx->owns_adapter = true;
    ((ra_gekkonet_udp_adapter_t*)ctx->adapter)->owner = ctx;
+
+   if (params->relay_server && *params->relay_server
+         && !ra_gekkonet_relay_init((ra_gekkonet_udp_adapter_t*)ctx->adapter,
+            params))
+   {
+       GEKKONET_ERR("could not set up relay %s", params->relay_server);
+       ra_gekkonet_udp_adapter_destroy((ra_gekkonet_udp_adapter_t*)ctx->adapter);
+       ctx->adapter = NULL;
+       gekko_destroy(ctx->session);
+       ctx->session = NULL;
+       return false;
+   }
    ctx->bound_port = ((ra_gekkonet_udp_adapter_t*)ctx->adapter)->port;
 
-   gekko_net_adapter_set(ctx->session, ctx->adapter);
+   /* gekko_start() resets the session, including its adapter. */
    gekko_start(ctx->session, &ctx->cfg);
+   gekko_net_adapter_set(ctx->session, ctx->adapter);
 
    ctx->active = true;
     GEKKONET_LOG("GekkoNet session started: %u players, %u spectators (port=%hu)",
@@ -612,6 +862,15 @@ void ra_gekkonet_set_run_frame_cb(ra_gekkonet_ctx_t       *ctx,
     ctx->run_frame_cb = cb;
 }
 
+/* Set callback used for rolled back frames, which run immediately. */
+void ra_gekkonet_set_resim_frame_cb(ra_gekkonet_ctx_t         *ctx,
+                                    ra_gekkonet_resim_frame_cb cb)
+{
+    if (!ctx)
+        return;
+    ctx->resim_frame_cb = cb;
+}
+
 /* Set optional callback for high-level session events (connect/disconnect/etc). */
 void ra_gekkonet_set_session_event_cb(ra_gekkonet_ctx_t            *ctx,
                                       ra_gekkonet_session_event_cb  cb,
@@ -654,6 +913,25 @@ void ra_gekkonet_deinit(ra_gekkonet_ctx_t *ctx)
     ctx->current_input_buf  = NULL;
     ctx->current_input      = NULL;
 
+    free(ctx->queue);
+    free(ctx->queue_inputs);
+    free(ctx->queue_lens);
+    ctx->queue              = NULL;
+    ctx->queue_inputs       = NULL;
+    ctx->queue_lens         = NULL;
+    ctx->queue_count        = 0;
+    ctx->queue_pos          = 0;
+    ctx->queue_cap          = 0;
+    ctx->queue_advances     = 0;
+
+    free(ctx->ahead_state);
+    free(ctx->behind_state);
+    ctx->ahead_state        = NULL;
+    ctx->behind_state       = NULL;
+    ctx->ahead_valid        = false;
+    ctx->ahead_loaded       = false;
+    ctx->ahead_running      = false;
+
     ctx->session       = NULL;
     ctx->owns_adapter  = false;
     ctx->active        = false;
@@ -689,7 +967,10 @@ int ra_gekkonet_add_actor(ra_gekkonet_ctx_t *ctx,
         return -1;
     }
 
-    if (addr_string && ra_gekkonet_normalize_addr(addr_string, normalized, sizeof(normalized)))
+    if (     addr_string
+          && strncmp(addr_string, RA_GEKKONET_RELAY_PREFIX,
+                     sizeof(RA_GEKKONET_RELAY_PREFIX) - 1)
+          && ra_gekkonet_normalize_addr(addr_string, normalized, sizeof(normalized)))
         addr_to_use = normalized;
 
     memset(&addr, 0, sizeof(addr));
@@ -820,8 +1101,9 @@ static void ra_gekkonet_handle_load(ra_gekkonet_ctx_t    *ctx,
     GEKKONET_LOG("load frame=%d len=%u", ev->data.load.frame, ev->data.load.state_len);
 }
 
-static void ra_gekkonet_handle_advance(ra_gekkonet_ctx_t    *ctx,
-                                       const GekkoGameEvent *ev)
+static void ra_gekkonet_handle_advance(ra_gekkonet_ctx_t        *ctx,
+                                       const GekkoGameEvent     *ev,
+                                       ra_gekkonet_run_frame_cb  cb)
 {
    if (!ctx || !ev)
        return;
@@ -847,53 +1129,334 @@ static void ra_gekkonet_handle_advance(ra_gekkonet_ctx_t    *ctx,
     GEKKONET_LOG("advance frame=%d len=%u rollback=%d",
         ev->data.adv.frame, ev->data.adv.input_len, ev->data.adv.rolling_back);
 
-    if (ctx->run_frame_cb)
-        ctx->run_frame_cb();
+    if (cb)
+        cb();
 
    /* After the first successful advance/run, we can safely serialize. */
    ctx->ready_for_state = true;
-   ctx->advanced_frame  = true;
 }
 
-static void ra_gekkonet_process_game_events(ra_gekkonet_ctx_t *ctx)
+/* Points queued advances at their copied inputs again, after the
+ * queue has been moved or grown. */
+static void ra_gekkonet_queue_repoint(ra_gekkonet_ctx_t *ctx)
 {
-   int count = 0;
-   GekkoGameEvent **events;
+    size_t i;
 
-   if (!ctx || !ctx->session)
-       return;
+    for (i = 0; i < ctx->queue_count; i++)
+        if (ctx->queue[i].type == AdvanceEvent && ctx->queue[i].data.adv.inputs)
+            ctx->queue[i].data.adv.inputs = ctx->queue_inputs + i * ctx->input_size;
+}
 
-   ctx->current_input = NULL;
-   ctx->advanced_frame = false;
+bool ra_gekkonet_queue_events(ra_gekkonet_ctx_t *ctx,
+                              GekkoGameEvent   **events,
+                              int                count)
+{
+    int i;
 
-   events = gekko_update_session(ctx->session, &count);
-   if (!events || count <= 0)
-       return;
+    if (!ctx)
+        return false;
 
-    for (int i = 0; i < count; i++)
+    /* Drop what has been handled, keeping the rest in order */
+    if (ctx->queue_pos)
     {
-        const GekkoGameEvent *ev = events[i];
-        if (!ev)
+        size_t left = ctx->queue_count - ctx->queue_pos;
+
+        memmove(ctx->queue, ctx->queue + ctx->queue_pos,
+                left * sizeof(*ctx->queue));
+        memmove(ctx->queue_inputs,
+                ctx->queue_inputs + ctx->queue_pos * ctx->input_size,
+                left * ctx->input_size);
+        memmove(ctx->queue_lens, ctx->queue_lens + ctx->queue_pos,
+                left * sizeof(*ctx->queue_lens));
+        ctx->queue_count = left;
+        ctx->queue_pos   = 0;
+        ra_gekkonet_queue_repoint(ctx);
+    }
+
+    if (!events || count <= 0)
+        return true;
+
+    if (ctx->queue_count + (size_t)count > ctx->queue_cap)
+    {
+        size_t          new_cap = ctx->queue_cap ? ctx->queue_cap : 16;
+        GekkoGameEvent *queue;
+        unsigned char  *inputs;
+        unsigned int  **lens;
+
+        while (new_cap < ctx->queue_count + (size_t)count)
+            new_cap *= 2;
+
+        queue = (GekkoGameEvent*)realloc(ctx->queue,
+                new_cap * sizeof(*queue));
+        if (!queue)
+            return false;
+        ctx->queue = queue;
+
+        inputs = (unsigned char*)realloc(ctx->queue_inputs,
+                new_cap * ctx->input_size);
+        if (!inputs)
+            return false;
+        ctx->queue_inputs = inputs;
+
+        lens = (unsigned int**)realloc(ctx->queue_lens,
+                new_cap * sizeof(*lens));
+        if (!lens)
+            return false;
+        ctx->queue_lens = lens;
+        ctx->queue_cap  = new_cap;
+
+        ra_gekkonet_queue_repoint(ctx);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        GekkoGameEvent *ev;
+
+        if (!events[i] || events[i]->type == EmptyGameEvent)
             continue;
 
-        switch (ev->type)
+        ev  = &ctx->queue[ctx->queue_count];
+        *ev = *events[i];
+        ctx->queue_lens[ctx->queue_count] = NULL;
+
+        /* GekkoNet reuses its event buffer on the next update, which
+         * comes before a spread out rollback has been fully replayed. */
+        if (ev->type == AdvanceEvent && ev->data.adv.inputs)
         {
-            case SaveEvent:
-                ra_gekkonet_handle_save(ctx, ev);
-                break;
-            case LoadEvent:
-                ra_gekkonet_handle_load(ctx, ev);
-                break;
-            case AdvanceEvent:
-                ra_gekkonet_handle_advance(ctx, ev);
+            unsigned char *dst = ctx->queue_inputs
+                               + ctx->queue_count * ctx->input_size;
+            unsigned int   len = ev->data.adv.input_len;
+
+            if (len > ctx->input_size)
+                len = ctx->input_size;
+            memcpy(dst, ev->data.adv.inputs, len);
+            ev->data.adv.inputs    = dst;
+            ev->data.adv.input_len = len;
+            ctx->queue_advances++;
+        }
+        else if (ev->type == LoadEvent)
+        {
+            size_t j;
+
+            /* The latest save to this state may not have been taken yet */
+            for (j = ctx->queue_count; j-- > ctx->queue_pos; )
+            {
+                if (     ctx->queue[j].type == SaveEvent
+                      && ctx->queue[j].data.save.state == ev->data.load.state)
+                {
+                    ctx->queue_lens[ctx->queue_count] = ctx->queue[j].data.save.state_len;
+                    break;
+                }
+            }
+        }
+
+        ctx->queue_count++;
+    }
+
+    return true;
+}
+
+static void ra_gekkonet_run_queue(ra_gekkonet_ctx_t *ctx,
+                                  unsigned           max_resim,
+                                  bool               allow_advance)
+{
+    unsigned resim = 0;
+
+    while (ctx->queue_pos < ctx->queue_count)
+    {
+        GekkoGameEvent *ev = &ctx->queue[ctx->queue_pos];
+
+        if (ev->type == AdvanceEvent)
+        {
+            if (!allow_advance)
                 break;
-            case EmptyGameEvent:
-            default:
+
+            /* Frames before the last one are not presented, even those
+             * that were new when they were queued: the player saw the
+             * predicted branch instead. */
+            if (ctx->queue_advances > 1 && ctx->resim_frame_cb)
+            {
+                if (resim >= max_resim)
+                    break;
+                resim++;
+                ctx->queue_advances--;
+                ctx->queue_pos++;
+                ra_gekkonet_handle_advance(ctx, ev, ctx->resim_frame_cb);
+                continue;
+            }
+
+            /* The presented frame is run by the frontend after we return;
+             * anything queued behind it has to wait for that. */
+            ctx->queue_pos++;
+            ctx->queue_advances--;
+            ra_gekkonet_handle_advance(ctx, ev, ctx->run_frame_cb);
+            ctx->advanced_frame = true;
+            if (!ctx->queue_advances)
                 break;
+            continue;
+        }
+
+        if (ev->type == SaveEvent)
+            ra_gekkonet_handle_save(ctx, ev);
+        else if (ev->type == LoadEvent)
+        {
+            if (ctx->queue_lens[ctx->queue_pos])
+                ev->data.load.state_len = *ctx->queue_lens[ctx->queue_pos];
+            ra_gekkonet_handle_load(ctx, ev);
         }
+        ctx->queue_pos++;
+    }
+
+    if (ctx->queue_pos >= ctx->queue_count)
+    {
+        ctx->queue_pos      = 0;
+        ctx->queue_count    = 0;
+        ctx->queue_advances = 0;
     }
 }
 
+static bool ra_gekkonet_branch_save(ra_gekkonet_ctx_t *ctx,
+                                    unsigned char     *buf,
+                                    unsigned int      *len)
+{
+    unsigned int crc = 0;
+    return buf && ctx->save_cb
+        && ctx->save_cb(buf, ctx->state_size, len, &crc);
+}
+
+static bool ra_gekkonet_branch_load(ra_gekkonet_ctx_t   *ctx,
+                                    const unsigned char *buf,
+                                    unsigned int         len)
+{
+    return ctx->load_cb && ctx->load_cb(buf, len);
+}
+
+/* Stops presenting predicted frames. The core is left on the replay. */
+static void ra_gekkonet_branch_drop(ra_gekkonet_ctx_t *ctx)
+{
+    if (     ctx->ahead_loaded
+          && !ra_gekkonet_branch_load(ctx, ctx->behind_state, ctx->behind_len))
+        GEKKONET_WARN("could not return to the rollback being replayed");
+    ctx->ahead_valid   = false;
+    ctx->ahead_loaded  = false;
+    ctx->ahead_running = false;
+}
+
+static const GekkoGameEvent *ra_gekkonet_last_advance(
+      const ra_gekkonet_ctx_t *ctx)
+{
+    size_t i;
+
+    for (i = ctx->queue_count; i-- > ctx->queue_pos; )
+        if (ctx->queue[i].type == AdvanceEvent)
+            return &ctx->queue[i];
+    return NULL;
+}
+
+void ra_gekkonet_process_events(ra_gekkonet_ctx_t *ctx, unsigned max_resim)
+{
+    const GekkoGameEvent *last;
+
+    if (!ctx)
+        return;
+
+    ctx->advanced_frame = false;
+
+    /* Back to the replay left off last frame */
+    if (ctx->ahead_loaded)
+    {
+        if (!ra_gekkonet_branch_load(ctx, ctx->behind_state, ctx->behind_len))
+            GEKKONET_WARN("could not return to the rollback being replayed");
+        ctx->ahead_loaded = false;
+    }
+
+    /* A rollback that will not be replayed this frame: keep the state the
+     * player is seeing, to go on presenting predicted frames from it. */
+    if (     !ctx->ahead_valid
+          && ctx->resim_frame_cb
+          && ra_gekkonet_pending_resim(ctx) > max_resim
+          && (last = ra_gekkonet_last_advance(ctx)))
+    {
+        if (!ctx->ahead_state)
+            ctx->ahead_state  = (unsigned char*)malloc(ctx->state_size);
+        if (!ctx->behind_state)
+            ctx->behind_state = (unsigned char*)malloc(ctx->state_size);
+
+        if (     ctx->behind_state
+              && ra_gekkonet_branch_save(ctx, ctx->ahead_state, &ctx->ahead_len))
+        {
+            ctx->ahead_valid = true;
+            ctx->ahead_frame = last->data.adv.frame - 1;
+        }
+    }
+
+    ra_gekkonet_run_queue(ctx, max_resim, true);
+
+    if (!ctx->ahead_valid)
+        return;
+
+    /* Caught up: the last frame came out of the replay */
+    if (ctx->advanced_frame)
+    {
+        ctx->ahead_valid = false;
+        return;
+    }
+
+    /* Nothing new from GekkoNet, the frontend repeats the frame */
+    if (     !(last = ra_gekkonet_last_advance(ctx))
+          || last->data.adv.frame <= ctx->ahead_frame)
+        return;
+
+    if (!ra_gekkonet_branch_save(ctx, ctx->behind_state, &ctx->behind_len))
+    {
+        ctx->ahead_valid = false;
+        return;
+    }
+    ctx->ahead_loaded = true;
+    if (!ra_gekkonet_branch_load(ctx, ctx->ahead_state, ctx->ahead_len))
+    {
+        ra_gekkonet_branch_drop(ctx);
+        return;
+    }
+
+    ctx->ahead_frame    = last->data.adv.frame;
+    ctx->ahead_running  = true;
+    ctx->advanced_frame = true;
+    ra_gekkonet_handle_advance(ctx, last, ctx->run_frame_cb);
+}
+
+void ra_gekkonet_flush_events(ra_gekkonet_ctx_t *ctx)
+{
+    if (!ctx)
+        return;
+
+    if (ctx->ahead_running)
+    {
+        ctx->ahead_running = false;
+        if (!ra_gekkonet_branch_save(ctx, ctx->ahead_state, &ctx->ahead_len))
+            ra_gekkonet_branch_drop(ctx);
+        return;
+    }
+
+    ra_gekkonet_run_queue(ctx, 0, false);
+}
+
+bool ra_gekkonet_has_pending_events(const ra_gekkonet_ctx_t *ctx)
+{
+    return ctx && ctx->queue_pos < ctx->queue_count;
+}
+
+unsigned ra_gekkonet_pending_resim(const ra_gekkonet_ctx_t *ctx)
+{
+    return (ctx && ctx->queue_advances > 1)
+        ? (unsigned)(ctx->queue_advances - 1) : 0;
+}
+
+bool ra_gekkonet_is_predicting(const ra_gekkonet_ctx_t *ctx)
+{
+    return ctx && ctx->ahead_valid;
+}
+
 static void ra_gekkonet_process_session_events(ra_gekkonet_ctx_t *ctx)
 {
     int count = 0;
@@ -931,22 +1494,119 @@ static void ra_gekkonet_process_session_events(ra_gekkonet_ctx_t *ctx)
  *   1. Pack inputs.
  *   2. ra_gekkonet_push_local_input(...).
  *   3. ra_gekkonet_update(...).
+ *   4. ra_gekkonet_process_events(...), run the presented frame, then
+ *      ra_gekkonet_flush_events(...).
  *
- * Inside this call, GekkoNet might emit Save/Load/Advance events. Once you
- * fill in the TODOs above, those events will call back into your save/load/
- * run_frame callbacks.
+ * GekkoNet keeps advancing while a rollback is spread over several
+ * frames; its events are queued behind the ones being replayed. Until the
+ * replay catches up, saves are taken later than GekkoNet expects, so
+ * desync detection may compare a checksum that is not written yet.
  */
 void ra_gekkonet_update(ra_gekkonet_ctx_t *ctx)
 {
     if (!ctx || !ctx->session || !ctx->active)
         return;
 
+    ctx->advanced_frame = false;
+
     /* Let GekkoNet process incoming/outgoing packets. */
     gekko_network_poll(ctx->session);
 
     /* Deliver high-level session events to the frontend. */
     ra_gekkonet_process_session_events(ctx);
 
-    /* Deliver game events (save/load/advance). */
-    ra_gekkonet_process_game_events(ctx);
+    /* Queue the next batch of game events (save/load/advance). */
+    {
+        int count = 0;
+        GekkoGameEvent **events;
+
+        if (!ra_gekkonet_has_pending_events(ctx))
+            ctx->current_input = NULL;
+        events = gekko_update_session(ctx->session, &count);
+        if (!ra_gekkonet_queue_events(ctx, events, count))
+            GEKKONET_WARN("could not queue %d game events", count);
+    }
+}
+
+/* --- Rollback budget ----------------------------------------------------- */
+
+/* Moving averages use a 1/8 weight for new samples. */
+#define RA_GEKKONET_BUDGET_EMA(avg, sample) \
+    ((avg) ? (avg) + ((sample) - (avg)) / 8 : (sample))
+
+void ra_gekkonet_budget_init(ra_gekkonet_budget_t *budget,
+                             int64_t frame_period, unsigned window)
+{
+    if (!budget)
+        return;
+    memset(budget, 0, sizeof(*budget));
+    budget->frame_period = frame_period;
+    budget->window       = window;
+}
+
+void ra_gekkonet_budget_record(ra_gekkonet_budget_t *budget,
+                               int64_t usec, bool resim)
+{
+    if (!budget || usec < 0)
+        return;
+    if (resim)
+    {
+        budget->resim_cost   = RA_GEKKONET_BUDGET_EMA(budget->resim_cost, usec);
+        budget->frame_resim += usec;
+    }
+    else
+        budget->run_cost     = RA_GEKKONET_BUDGET_EMA(budget->run_cost, usec);
+}
+
+void ra_gekkonet_budget_record_events(ra_gekkonet_budget_t *budget,
+                                      int64_t usec)
+{
+    int64_t overhead;
+
+    if (!budget)
+        return;
+    overhead            = usec - budget->frame_resim;
+    budget->frame_resim = 0;
+    if (overhead >= 0)
+        budget->overhead = RA_GEKKONET_BUDGET_EMA(budget->overhead, overhead);
+}
+
+void ra_gekkonet_budget_begin(ra_gekkonet_budget_t *budget)
+{
+    if (budget)
+        budget->frames_left = budget->window;
+}
+
+unsigned ra_gekkonet_budget_allow(ra_gekkonet_budget_t *budget,
+                                  unsigned pending)
+{
+    int64_t  cost;
+    int64_t  spare;
+    unsigned allow;
+    unsigned needed;
+
+    if (!budget || !pending)
+        return 0;
+
+    /* Nothing to go on yet, or on the last frame of the window */
+    cost = budget->resim_cost ? budget->resim_cost : budget->run_cost;
+    if (     budget->window <= 1
+          || budget->frames_left <= 1
+          || budget->frame_period <= 0
+          || cost <= 0)
+    {
+        budget->frames_left = 0;
+        return pending;
+    }
+
+    /* Keep a quarter of the period for the rest of the host frame */
+    spare  = budget->frame_period - budget->frame_period / 4
+           - budget->run_cost - budget->overhead;
+    allow  = spare > 0 ? (unsigned)(spare / cost) : 0;
+    needed = (pending + budget->frames_left - 1) / budget->frames_left;
+    if (allow < needed)
+        allow = needed;
+
+    budget->frames_left--;
+    return allow < pending ? allow : pending;
 }
@@ -47,8 +47,16 @@ typedef struct ra_gekkonet_params
    bool limited_saving;
    bool post_sync_joining;
    bool desync_detection;
+   /* Optional relay: "host:port" of a gekkonet-relay server and the
+    * session name shared by all players. Peers are then addressed as
+    * RA_GEKKONET_RELAY_PREFIX "<slot>" instead of "ip:port". */
+   const char   *relay_server;
+   const char   *relay_session;
+   unsigned char relay_slot;
 } ra_gekkonet_params_t;
 
+#define RA_GEKKONET_RELAY_PREFIX "relay:"
+
 typedef bool (*ra_gekkonet_save_state_cb)(
       void         *dst,
       unsigned int  capacity,
@@ -61,10 +69,27 @@ typedef bool (*ra_gekkonet_load_state_cb)(
 
 typedef void (*ra_gekkonet_run_frame_cb)(void);
 
+/* Runs one resimulated (rolled back) frame immediately, without
+ * presenting it. */
+typedef void (*ra_gekkonet_resim_frame_cb)(void);
+
 typedef void (*ra_gekkonet_session_event_cb)(
       const GekkoSessionEvent *event,
       void                    *userdata);
 
+/* Frame cost accounting used to spread long rollbacks over several
+ * host frames. Times are in microseconds; costs are moving averages. */
+typedef struct ra_gekkonet_budget
+{
+   int64_t  frame_period; /* Host frame period (0 = unknown) */
+   int64_t  run_cost;     /* Cost of a presented frame */
+   int64_t  resim_cost;   /* Cost of a resimulated frame */
+   int64_t  overhead;     /* Saves, loads and branch swaps per host frame */
+   int64_t  frame_resim;  /* Resimulation time of the current host frame */
+   unsigned window;       /* Converge within this many host frames (<= 1 = never spread) */
+   unsigned frames_left;  /* Host frames left in the current window */
+} ra_gekkonet_budget_t;
+
 typedef struct ra_gekkonet_ctx
 {
    GekkoSession    *session;
@@ -75,6 +100,7 @@ typedef struct ra_gekkonet_ctx
    ra_gekkonet_save_state_cb      save_cb;
    ra_gekkonet_load_state_cb      load_cb;
    ra_gekkonet_run_frame_cb       run_frame_cb;
+   ra_gekkonet_resim_frame_cb     resim_frame_cb;
    ra_gekkonet_session_event_cb   session_event_cb;
    void                          *session_event_userdata;
 
@@ -84,6 +110,33 @@ typedef struct ra_gekkonet_ctx
    void       *current_input_buf;
    const void *current_input;
 
+   /* Game events that have not been handled yet, in order. Updates
+    * append to it while a spread out rollback is still being replayed.
+    * Advance inputs are copied into queue_inputs. Save/load events point
+    * into GekkoNet's state storage, which GekkoNet only hands out and
+    * never writes, so they are still valid when their turn comes.
+    * queue_lens holds, for a load, the length of a save to the same
+    * state that is still queued, since GekkoNet copied a stale one. */
+   GekkoGameEvent *queue;
+   unsigned char  *queue_inputs;
+   unsigned int  **queue_lens;
+   size_t          queue_count;
+   size_t          queue_pos;
+   size_t          queue_cap;
+   size_t          queue_advances;
+
+   /* While a spread out rollback is replayed, the player keeps seeing
+    * the predicted branch: its state is kept in ahead_state, and the
+    * replay's in behind_state while a predicted frame runs. */
+   unsigned char  *ahead_state;
+   unsigned char  *behind_state;
+   unsigned int    ahead_len;
+   unsigned int    behind_len;
+   int             ahead_frame;
+   bool            ahead_valid;   /* The predicted branch is in use */
+   bool            ahead_loaded;  /* The core holds the predicted branch */
+   bool            ahead_running; /* A predicted frame is being presented */
+
    char       **remote_addrs;
    size_t       remote_addrs_count;
    size_t       remote_addrs_cap;
@@ -106,6 +159,11 @@ bool ra_gekkonet_init(ra_gekkonet_ctx_t              *ctx,
 void ra_gekkonet_set_run_frame_cb(ra_gekkonet_ctx_t       *ctx,
                                   ra_gekkonet_run_frame_cb cb);
 
+/* Set callback used for rolled back frames. Without it, rollback
+ * advances go through the run frame callback like any other. */
+void ra_gekkonet_set_resim_frame_cb(ra_gekkonet_ctx_t         *ctx,
+                                    ra_gekkonet_resim_frame_cb cb);
+
 void ra_gekkonet_set_session_event_cb(ra_gekkonet_ctx_t            *ctx,
                                       ra_gekkonet_session_event_cb  cb,
                                       void                         *userdata);
@@ -124,8 +182,61 @@ bool ra_gekkonet_push_local_input(ra_gekkonet_ctx_t *ctx,
                                   int                actor_handle,
                                   const void        *input_blob);
 
+/* Polls the network, delivers session events and queues the next batch
+ * of game events behind any still unhandled. Queued events are handled
+ * by ra_gekkonet_process_events(). */
 void ra_gekkonet_update(ra_gekkonet_ctx_t *ctx);
 
+/* Appends a batch of game events to the queue. Called by
+ * ra_gekkonet_update(); exposed so tools can feed synthetic event
+ * streams. */
+bool ra_gekkonet_queue_events(ra_gekkonet_ctx_t *ctx,
+                              GekkoGameEvent   **events,
+                              int                count);
+
+/* Handles queued events in order. Every advance but the last queued one
+ * is resimulated, at most max_resim of them. The last one is presented:
+ * handling stops after it, so that the saves following it happen once
+ * the frontend has run that frame.
+ *
+ * When the resimulations do not all fit, the state the player was seeing
+ * is kept aside, and each host frame until the replay catches up presents
+ * the newest advance on top of it with GekkoNet's predicted inputs. */
+void ra_gekkonet_process_events(ra_gekkonet_ctx_t *ctx, unsigned max_resim);
+
+/* Handles queued save/load events up to the next advance, or keeps the
+ * predicted branch. Call after the presented frame has run. */
+void ra_gekkonet_flush_events(ra_gekkonet_ctx_t *ctx);
+
+bool ra_gekkonet_has_pending_events(const ra_gekkonet_ctx_t *ctx);
+
+/* Number of queued frames to resimulate before the presented one. */
+unsigned ra_gekkonet_pending_resim(const ra_gekkonet_ctx_t *ctx);
+
+/* Whether predicted frames are presented while a rollback is replayed. */
+bool ra_gekkonet_is_predicting(const ra_gekkonet_ctx_t *ctx);
+
+void ra_gekkonet_budget_init(ra_gekkonet_budget_t *budget,
+                             int64_t frame_period, unsigned window);
+
+/* Feeds one measured frame into the moving averages. */
+void ra_gekkonet_budget_record(ra_gekkonet_budget_t *budget,
+                               int64_t usec, bool resim);
+
+/* Feeds the time spent handling this host frame's events. The part not
+ * spent resimulating goes into the overhead. */
+void ra_gekkonet_budget_record_events(ra_gekkonet_budget_t *budget,
+                                      int64_t usec);
+
+/* Starts the convergence window for a freshly queued rollback. */
+void ra_gekkonet_budget_begin(ra_gekkonet_budget_t *budget);
+
+/* How many of 'pending' rolled back frames to run this host frame. Uses
+ * whatever is left of the frame period after the presented frame and the
+ * overhead, but never less than needed to finish inside the window. */
+unsigned ra_gekkonet_budget_allow(ra_gekkonet_budget_t *budget,
+                                  unsigned pending);
+
 /* Fire a one-shot UDP probe to a given "ip:port" string using the current adapter. */
 void ra_gekkonet_send_probe(const char *addr_string);
 
@@ -0,0 +1,131 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_NETPLAY_GEKKONET_RELAY_H
+#define __RARCH_NETPLAY_GEKKONET_RELAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <retro_inline.h>
+
+/* Wire format shared by the GekkoNet relay client (netplay_gekkonet.c)
+ * and the standalone relay server (tools/gekkonet-relay).
+ *
+ * Every relay datagram starts with a 5 byte header:
+ *   uint32_t magic   GEKKONET_RELAY_MAGIC, big endian
+ *   uint8_t  type    GEKKONET_RELAY_*
+ *
+ * REGISTER (client -> relay) / REGISTERED, REJECTED (relay -> client):
+ *   uint64_t session  big endian, see gekkonet_relay_session_id()
+ *   uint8_t  slot     member slot within the session, the player index
+ *   uint64_t nonce    big endian, random, chosen by the member once
+ *   Clients repeat REGISTER as a keepalive; the relay forgets members it
+ *   has not heard from in GEKKONET_RELAY_TIMEOUT_MS. A slot that is held
+ *   is only rebound to a new address (e.g. after a NAT rebinding) by a
+ *   REGISTER carrying the same nonce, anything else is REJECTED. The
+ *   session id of the empty name and a zero nonce are always REJECTED.
+ *
+ * DATA:
+ *   uint8_t  slot     client -> relay: destination slot
+ *                     relay -> client: source slot
+ *   uint8_t  payload[]  one GekkoNet datagram
+ *   The relay only rewrites the slot byte, so packets are forwarded
+ *   straight out of its receive buffers. */
+
+#define GEKKONET_RELAY_MAGIC          0x474B524C /* "GKRL" */
+#define GEKKONET_RELAY_HEADER_SIZE    5
+#define GEKKONET_RELAY_DATA_SIZE      (GEKKONET_RELAY_HEADER_SIZE + 1)
+#define GEKKONET_RELAY_REGISTER_SIZE  (GEKKONET_RELAY_HEADER_SIZE + 17)
+#define GEKKONET_RELAY_MAX_SLOTS      16
+#define GEKKONET_RELAY_MAX_PACKET     2048
+#define GEKKONET_RELAY_DEFAULT_PORT   55436
+#define GEKKONET_RELAY_TIMEOUT_MS     30000
+
+enum gekkonet_relay_type
+{
+   GEKKONET_RELAY_REGISTER = 1,
+   GEKKONET_RELAY_REGISTERED,
+   GEKKONET_RELAY_DATA,
+   GEKKONET_RELAY_REJECTED
+};
+
+/* Session names are hashed to 64 bits with FNV-1a so that every member
+ * can derive the same id from the name both players entered. The empty
+ * name hashes to GEKKONET_RELAY_EMPTY_SESSION, which is not a session. */
+#define GEKKONET_RELAY_EMPTY_SESSION  0xcbf29ce484222325ULL
+
+static INLINE uint64_t gekkonet_relay_session_id(const char *name)
+{
+   uint64_t hash = GEKKONET_RELAY_EMPTY_SESSION;
+   if (name)
+      for (; *name; name++)
+         hash = (hash ^ (uint8_t)*name) * 0x100000001b3ULL;
+   return hash;
+}
+
+static INLINE void gekkonet_relay_write_header(uint8_t *buf, uint8_t type)
+{
+   buf[0] = (uint8_t)(GEKKONET_RELAY_MAGIC >> 24);
+   buf[1] = (uint8_t)(GEKKONET_RELAY_MAGIC >> 16);
+   buf[2] = (uint8_t)(GEKKONET_RELAY_MAGIC >> 8);
+   buf[3] = (uint8_t)(GEKKONET_RELAY_MAGIC);
+   buf[4] = type;
+}
+
+/* Returns the packet type, or 0 if this is not a relay packet. */
+static INLINE uint8_t gekkonet_relay_read_header(const uint8_t *buf, size_t len)
+{
+   if (len < GEKKONET_RELAY_HEADER_SIZE)
+      return 0;
+   if (     buf[0] != (uint8_t)(GEKKONET_RELAY_MAGIC >> 24)
+         || buf[1] != (uint8_t)(GEKKONET_RELAY_MAGIC >> 16)
+         || buf[2] != (uint8_t)(GEKKONET_RELAY_MAGIC >> 8)
+         || buf[3] != (uint8_t)(GEKKONET_RELAY_MAGIC))
+      return 0;
+   return buf[4];
+}
+
+static INLINE void gekkonet_relay_write_register(uint8_t *buf, uint8_t type,
+      uint64_t session, uint8_t slot, uint64_t nonce)
+{
+   unsigned i;
+   gekkonet_relay_write_header(buf, type);
+   for (i = 0; i < 8; i++)
+   {
+      buf[GEKKONET_RELAY_HEADER_SIZE + i]     = (uint8_t)(session >> (56 - 8 * i));
+      buf[GEKKONET_RELAY_HEADER_SIZE + 9 + i] = (uint8_t)(nonce   >> (56 - 8 * i));
+   }
+   buf[GEKKONET_RELAY_HEADER_SIZE + 8] = slot;
+}
+
+static INLINE uint64_t gekkonet_relay_read_session(const uint8_t *buf)
+{
+   unsigned i;
+   uint64_t session = 0;
+   for (i = 0; i < 8; i++)
+      session = (session << 8) | buf[GEKKONET_RELAY_HEADER_SIZE + i];
+   return session;
+}
+
+static INLINE uint64_t gekkonet_relay_read_nonce(const uint8_t *buf)
+{
+   unsigned i;
+   uint64_t nonce = 0;
+   for (i = 0; i < 8; i++)
+      nonce = (nonce << 8) | buf[GEKKONET_RELAY_HEADER_SIZE + 9 + i];
+   return nonce;
+}
+
+#endif
@@ -20,6 +20,7 @@
 
 #include "netplay.h"
 #include "netplay_protocol.h"
+#include "netplay_udp.h"
 
 #include <libretro.h>
 
@@ -73,11 +74,33 @@
 
 /* Compression protocols supported */
 #define NETPLAY_COMPRESSION_ZLIB (1<<0)
+#define NETPLAY_COMPRESSION_ZSTD (1<<1)
 #if HAVE_ZLIB
-#define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_ZLIB
+#define NETPLAY_COMPRESSION_SUPPORTED_ZLIB NETPLAY_COMPRESSION_ZLIB
 #else
-#define NETPLAY_COMPRESSION_SUPPORTED 0
+#define NETPLAY_COMPRESSION_SUPPORTED_ZLIB 0
 #endif
+#if HAVE_ZSTD
+#define NETPLAY_COMPRESSION_SUPPORTED_ZSTD NETPLAY_COMPRESSION_ZSTD
+#else
+#define NETPLAY_COMPRESSION_SUPPORTED_ZSTD 0
+#endif
+#define NETPLAY_COMPRESSION_SUPPORTED \
+   (NETPLAY_COMPRESSION_SUPPORTED_ZLIB | NETPLAY_COMPRESSION_SUPPORTED_ZSTD)
+
+/* Capabilities, sent alongside the compression protocols in the header.
+ * Older peers mask these off along with any compression they don't know. */
+#define NETPLAY_CAP_UDP_INPUT    (1<<16)
+/* Highest zstd level a peer is willing to wait for; both sides stall
+ * while a state is compressed, so the lowest level of all peers wins. */
+#define NETPLAY_CAP_ZSTD_LEVEL_SHIFT 24
+#define NETPLAY_CAP_ZSTD_LEVEL_MASK  0x1F
+
+/* Flags in front of a zstd compressed NETPLAY_CMD_LOAD_SAVESTATE payload */
+/* Compressed with the previous zstd state on this connection as a raw
+ * prefix dictionary. TCP delivers states in order, so the receiver has
+ * decoded that one before. */
+#define NETPLAY_ZSTD_PREV_STATE_DICT (1<<0)
 
 /* The keys supported by netplay */
 enum netplay_keys
@@ -176,6 +199,11 @@ enum netplay_cmd
       each one individually */
    NETPLAY_CMD_CFG_ACK        = 0x0062,
 
+   /* Offers the datagram input channel (server to client):
+    * UDP port and connection token. Only sent to clients that
+    * advertised NETPLAY_CAP_UDP_INPUT. */
+   NETPLAY_CMD_UDP_INPUT      = 0x0063,
+
    /* Chat commands */
 
    /* Sends a player chat message.
@@ -364,7 +392,13 @@ enum netplay_connection_flags
    /* Is this connection allowed to play (server only)? */
    NETPLAY_CONN_FLAG_CAN_PLAY       = (1 << 2),
    /* Did we request a ping response? */
-   NETPLAY_CONN_FLAG_PING_REQUESTED = (1 << 3)
+   NETPLAY_CONN_FLAG_PING_REQUESTED = (1 << 3),
+   /* Did both sides advertise NETPLAY_CAP_UDP_INPUT? */
+   NETPLAY_CONN_FLAG_UDP_CAPABLE    = (1 << 4),
+   /* Has a datagram arrived from this peer? */
+   NETPLAY_CONN_FLAG_UDP_ACTIVE     = (1 << 5),
+   /* Was this peer sent the state in zstd_dict? */
+   NETPLAY_CONN_FLAG_ZSTD_DICT      = (1 << 6)
 };
 
 /* Each connection gets a connection struct */
@@ -376,6 +410,10 @@ struct netplay_connection
    /* Connection's address */
    netplay_address_t addr;
 
+   /* Where datagram input goes, once known */
+   struct sockaddr_storage udp_addr;
+   socklen_t udp_addr_len;
+
    /* Buffers for sending and receiving data */
    struct socket_buffer send_packet_buffer;
    struct socket_buffer recv_packet_buffer;
@@ -383,12 +421,21 @@ struct netplay_connection
    /* What compression does this peer support? */
    uint32_t compression_supported;
 
+   /* Highest zstd level this peer accepts */
+   uint32_t zstd_level;
+
    /* Salt associated with password transaction */
    uint32_t salt;
 
    /* Which netplay protocol is this connection running? */
    uint32_t netplay_protocol;
 
+   /* Token identifying this connection's datagrams */
+   uint32_t udp_token;
+
+   /* First of our frames this peer has not acknowledged over UDP */
+   uint32_t udp_acked;
+
    /* If the mode is a DELAYED_DISCONNECT or SPECTATOR,
     * the transmission of the mode change may have to
     * wait for data to be forwarded.
@@ -501,6 +548,14 @@ struct netplay
    /* Compression transcoder */
    struct compression_transcoder compress_nil;
    struct compression_transcoder compress_zlib;
+   struct compression_transcoder compress_zstd;
+
+   /* The last zstd state sent (server) or received (client), used as
+    * the dictionary for the next one */
+   uint8_t *zstd_dict;
+   size_t   zstd_dict_size;
+   /* Highest zstd level we accept, from the settings */
+   unsigned zstd_level;
 
    /* MITM session id */
    mitm_id_t mitm_session_id;
@@ -612,6 +667,9 @@ struct netplay
    /* TCP connection for listening (server only) */
    int listen_fd;
 
+   /* Datagram input channel, -1 if unused */
+   int udp_fd;
+
    int frame_run_time_ptr;
 
    /* Latency frames; positive to hide network latency,
@@ -627,6 +685,9 @@ struct netplay
    /* Netplay mode of operation (cannot change at runtime) */
    enum netplay_modus modus;
 
+   /* Our recent input frames, for the datagram channel */
+   netplay_udp_window_t udp_window;
+
    /* Keyboard mapping (network and host) */
    uint16_t mapping_hton[RETROK_LAST];
    uint16_t mapping_ntoh[NETPLAY_KEY_LAST];
@@ -635,6 +696,9 @@ struct netplay
    uint16_t tcp_port;
    uint16_t ext_tcp_port;
 
+   /* Port of our datagram input socket (only set if serving) */
+   uint16_t udp_port;
+
    /* The sharing mode for each device */
    uint8_t device_share_modes[MAX_INPUT_DEVICES];
 
@@ -686,6 +750,9 @@ struct netplay
 
    /* Host settings */
    bool allow_pausing;
+
+   /* Offer/accept the datagram input channel? */
+   bool udp_input;
 };
 
 void video_frame_net(const void *data,
@@ -0,0 +1,293 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "netplay_snapshot.h"
+
+static int netplay_snapshot_region_cmp(const void *a, const void *b)
+{
+   const netplay_snapshot_region_t *ra = (const netplay_snapshot_region_t*)a;
+   const netplay_snapshot_region_t *rb = (const netplay_snapshot_region_t*)b;
+   if (ra->ptr < rb->ptr)
+      return -1;
+   if (ra->ptr > rb->ptr)
+      return 1;
+   return 0;
+}
+
+static void netplay_snapshot_write_u32(uint8_t *dst, uint32_t val)
+{
+   dst[0] = (uint8_t)(val);
+   dst[1] = (uint8_t)(val >> 8);
+   dst[2] = (uint8_t)(val >> 16);
+   dst[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t netplay_snapshot_read_u32(const uint8_t *src)
+{
+   return  (uint32_t)src[0]
+        | ((uint32_t)src[1] << 8)
+        | ((uint32_t)src[2] << 16)
+        | ((uint32_t)src[3] << 24);
+}
+
+bool netplay_snapshot_init(netplay_snapshot_t *snap,
+      const netplay_snapshot_cbs_t *cbs, size_t residue_cap,
+      unsigned check_interval)
+{
+   if (!snap || !cbs || !cbs->residue_save || !cbs->residue_load)
+      return false;
+
+   memset(snap, 0, sizeof(*snap));
+   snap->cbs         = *cbs;
+   snap->residue_cap = residue_cap;
+
+   if (     check_interval
+         && cbs->full_size
+         && cbs->full_save
+         && cbs->full_load)
+   {
+      size_t full_size = cbs->full_size();
+
+      if (full_size)
+      {
+         snap->check_full = (uint8_t*)malloc(full_size);
+         snap->check_cur  = (uint8_t*)malloc(full_size);
+         snap->check_cmp  = (uint8_t*)malloc(full_size);
+
+         if (!snap->check_full || !snap->check_cur || !snap->check_cmp)
+         {
+            netplay_snapshot_free(snap);
+            return false;
+         }
+
+         snap->full_size      = full_size;
+         snap->check_interval = check_interval;
+      }
+   }
+
+   return true;
+}
+
+void netplay_snapshot_free(netplay_snapshot_t *snap)
+{
+   if (!snap)
+      return;
+
+   free(snap->regions);
+   free(snap->check_full);
+   free(snap->check_snap);
+   free(snap->check_cur);
+   free(snap->check_cmp);
+
+   memset(snap, 0, sizeof(*snap));
+}
+
+bool netplay_snapshot_add_region(netplay_snapshot_t *snap,
+      void *ptr, size_t len)
+{
+   if (!snap || !ptr || !len)
+      return false;
+
+   if (snap->num_regions >= snap->cap_regions)
+   {
+      unsigned new_cap = snap->cap_regions ? snap->cap_regions * 2 : 8;
+      netplay_snapshot_region_t *tmp = (netplay_snapshot_region_t*)
+         realloc(snap->regions, new_cap * sizeof(*tmp));
+      if (!tmp)
+         return false;
+      snap->regions     = tmp;
+      snap->cap_regions = new_cap;
+   }
+
+   snap->regions[snap->num_regions].ptr = (uint8_t*)ptr;
+   snap->regions[snap->num_regions].len = len;
+   snap->num_regions++;
+   return true;
+}
+
+void netplay_snapshot_finalize(netplay_snapshot_t *snap)
+{
+   unsigned i, out;
+
+   if (!snap)
+      return;
+
+   if (snap->num_regions)
+   {
+      qsort(snap->regions, snap->num_regions,
+            sizeof(*snap->regions), netplay_snapshot_region_cmp);
+
+      /* Memory maps routinely describe the same host buffer several
+       * times (mirrors, banked windows), so merge overlapping and
+       * adjacent ranges to copy every byte exactly once. */
+      out = 0;
+      for (i = 1; i < snap->num_regions; i++)
+      {
+         netplay_snapshot_region_t *cur  = &snap->regions[out];
+         netplay_snapshot_region_t *next = &snap->regions[i];
+         uint8_t *cur_end                = cur->ptr + cur->len;
+
+         if (next->ptr <= cur_end)
+         {
+            uint8_t *next_end = next->ptr + next->len;
+            if (next_end > cur_end)
+               cur->len = (size_t)(next_end - cur->ptr);
+         }
+         else
+            snap->regions[++out] = *next;
+      }
+      snap->num_regions = out + 1;
+   }
+
+   snap->regions_size = 0;
+   for (i = 0; i < snap->num_regions; i++)
+      snap->regions_size += snap->regions[i].len;
+
+   free(snap->check_snap);
+   snap->check_snap     = NULL;
+   snap->check_pending  = false;
+   if (snap->check_interval)
+      snap->check_snap  = (uint8_t*)malloc(netplay_snapshot_size(snap));
+}
+
+size_t netplay_snapshot_size(const netplay_snapshot_t *snap)
+{
+   if (!snap)
+      return 0;
+   return NETPLAY_SNAPSHOT_HEADER_SIZE + snap->regions_size + snap->residue_cap;
+}
+
+bool netplay_snapshot_is_blob(const void *data, size_t len)
+{
+   return data
+      && len >= NETPLAY_SNAPSHOT_HEADER_SIZE
+      && netplay_snapshot_read_u32((const uint8_t*)data)
+         == NETPLAY_SNAPSHOT_MAGIC;
+}
+
+static bool netplay_snapshot_restore(netplay_snapshot_t *snap,
+      const uint8_t *src, size_t len)
+{
+   unsigned i;
+   size_t residue_len;
+
+   if (!netplay_snapshot_is_blob(src, len))
+      return false;
+
+   residue_len = netplay_snapshot_read_u32(src + 4);
+   if (NETPLAY_SNAPSHOT_HEADER_SIZE + snap->regions_size + residue_len > len)
+      return false;
+
+   src += NETPLAY_SNAPSHOT_HEADER_SIZE;
+   for (i = 0; i < snap->num_regions; i++)
+   {
+      memcpy(snap->regions[i].ptr, src, snap->regions[i].len);
+      src += snap->regions[i].len;
+   }
+
+   return snap->cbs.residue_load(src, residue_len);
+}
+
+/* Checks that a snapshot taken some saves ago restores the same state
+ * as full serialization did at that point. The current state is saved
+ * and put back afterwards, so this is invisible to the caller. */
+static void netplay_snapshot_check(netplay_snapshot_t *snap)
+{
+   bool ok;
+
+   if (!snap->cbs.full_save(snap->check_cur, snap->full_size))
+      return;
+
+   ok =     netplay_snapshot_restore(snap, snap->check_snap,
+               snap->check_snap_len)
+         && snap->cbs.full_save(snap->check_cmp, snap->full_size)
+         && !memcmp(snap->check_cmp, snap->check_full, snap->full_size);
+
+   /* If the current state cannot be put back, the core is left in
+    * the checked one, so full serialization must take over */
+   if (!snap->cbs.full_load(snap->check_cur, snap->full_size))
+      ok = false;
+
+   if (ok)
+      snap->checks_passed++;
+   else
+      snap->failed = true;
+}
+
+bool netplay_snapshot_save(netplay_snapshot_t *snap,
+      void *data, size_t cap, size_t *out_len)
+{
+   unsigned i;
+   size_t residue_len = 0;
+   uint8_t *dst       = (uint8_t*)data;
+   size_t len;
+
+   if (!snap || !dst)
+      return false;
+
+   if (snap->cbs.residue_size)
+      residue_len = snap->cbs.residue_size();
+   if (residue_len > snap->residue_cap)
+      return false;
+
+   len = NETPLAY_SNAPSHOT_HEADER_SIZE + snap->regions_size + residue_len;
+   if (len > cap)
+      return false;
+
+   netplay_snapshot_write_u32(dst,     NETPLAY_SNAPSHOT_MAGIC);
+   netplay_snapshot_write_u32(dst + 4, (uint32_t)residue_len);
+   dst += NETPLAY_SNAPSHOT_HEADER_SIZE;
+
+   for (i = 0; i < snap->num_regions; i++)
+   {
+      memcpy(dst, snap->regions[i].ptr, snap->regions[i].len);
+      dst += snap->regions[i].len;
+   }
+
+   if (!snap->cbs.residue_save(dst, residue_len))
+      return false;
+
+   if (out_len)
+      *out_len = len;
+
+   if (snap->check_interval && snap->check_snap && !snap->failed)
+   {
+      if (snap->check_pending)
+      {
+         netplay_snapshot_check(snap);
+         snap->check_pending     = false;
+         snap->saves_since_check = 0;
+      }
+      else if (++snap->saves_since_check >= snap->check_interval
+            && snap->cbs.full_save(snap->check_full, snap->full_size))
+      {
+         memcpy(snap->check_snap, data, len);
+         snap->check_snap_len = len;
+         snap->check_pending  = true;
+      }
+   }
+
+   return true;
+}
+
+bool netplay_snapshot_load(netplay_snapshot_t *snap,
+      const void *data, size_t len)
+{
+   if (!snap)
+      return false;
+   return netplay_snapshot_restore(snap, (const uint8_t*)data, len);
+}
@@ -0,0 +1,134 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_NETPLAY_SNAPSHOT_H
+#define __RARCH_NETPLAY_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Lightweight rollback snapshots.
+ *
+ * Instead of going through retro_serialize(), a snapshot copies the
+ * writable regions a core exposes through SET_MEMORY_MAPS plus a small
+ * core-supplied 'residue' blob (CPU registers, timers, anything that
+ * does not live in a mapped region).
+ *
+ * Blob layout:
+ *   uint32_t magic       NETPLAY_SNAPSHOT_MAGIC
+ *   uint32_t residue_len
+ *   uint8_t  regions[regions_size]  (in region order)
+ *   uint8_t  residue[residue_len]
+ *
+ * Like netplay_gekkonet.c, this module does not depend on RetroArch
+ * internals; the frontend supplies the callbacks. */
+
+#define NETPLAY_SNAPSHOT_MAGIC       0x4E534252 /* "RBSN" */
+#define NETPLAY_SNAPSHOT_HEADER_SIZE 8
+
+typedef size_t (*netplay_snapshot_size_t)(void);
+typedef bool   (*netplay_snapshot_save_t)(void *data, size_t len);
+typedef bool   (*netplay_snapshot_load_t)(const void *data, size_t len);
+
+typedef struct netplay_snapshot_region
+{
+   uint8_t *ptr;
+   size_t   len;
+} netplay_snapshot_region_t;
+
+typedef struct netplay_snapshot_cbs
+{
+   /* Core residue (required) */
+   netplay_snapshot_size_t residue_size;
+   netplay_snapshot_save_t residue_save;
+   netplay_snapshot_load_t residue_load;
+   /* Full serialization (optional, only needed for validation) */
+   netplay_snapshot_size_t full_size;
+   netplay_snapshot_save_t full_save;
+   netplay_snapshot_load_t full_load;
+} netplay_snapshot_cbs_t;
+
+typedef struct netplay_snapshot
+{
+   netplay_snapshot_cbs_t     cbs;             /* ptr alignment */
+   netplay_snapshot_region_t *regions;
+   /* Validation buffers: the full state and the snapshot captured at
+    * the same frame, plus scratch space for the comparison. */
+   uint8_t *check_full;
+   uint8_t *check_snap;
+   uint8_t *check_cur;
+   uint8_t *check_cmp;
+   size_t   regions_size;
+   size_t   residue_cap;
+   size_t   full_size;
+   size_t   check_snap_len;
+   unsigned num_regions;
+   unsigned cap_regions;
+   /* Validate once every 'check_interval' saves; 0 disables it */
+   unsigned check_interval;
+   unsigned saves_since_check;
+   unsigned checks_passed;
+   bool     check_pending;
+   /* Set once validation has shown that the snapshot misses state */
+   bool     failed;
+} netplay_snapshot_t;
+
+/**
+ * netplay_snapshot_init:
+ * @snap           : Snapshot context to initialise.
+ * @cbs            : Core residue and (optional) full serialization callbacks.
+ * @residue_cap    : Upper bound for the residue blob, in bytes.
+ * @check_interval : Validate against full serialization every N saves (0 = never).
+ *
+ * Returns: true if the context is usable.
+ **/
+bool netplay_snapshot_init(netplay_snapshot_t *snap,
+      const netplay_snapshot_cbs_t *cbs, size_t residue_cap,
+      unsigned check_interval);
+
+void netplay_snapshot_free(netplay_snapshot_t *snap);
+
+/**
+ * netplay_snapshot_add_region:
+ *
+ * Registers a writable memory region. Overlapping and adjacent regions
+ * (e.g. mirrors of the same buffer) are merged by
+ * netplay_snapshot_finalize().
+ **/
+bool netplay_snapshot_add_region(netplay_snapshot_t *snap,
+      void *ptr, size_t len);
+
+/* Sorts and merges the registered regions. Must be called before the
+ * first save, and again whenever regions are added. */
+void netplay_snapshot_finalize(netplay_snapshot_t *snap);
+
+/* Size of a snapshot blob, in bytes. */
+size_t netplay_snapshot_size(const netplay_snapshot_t *snap);
+
+bool netplay_snapshot_is_blob(const void *data, size_t len);
+
+bool netplay_snapshot_save(netplay_snapshot_t *snap,
+      void *data, size_t cap, size_t *out_len);
+
+bool netplay_snapshot_load(netplay_snapshot_t *snap,
+      const void *data, size_t len);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,172 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(_XBOX)
+#include <windows.h>
+#include <wincrypt.h>
+#endif
+
+#include "netplay_udp.h"
+
+static void netplay_udp_write_u32(uint8_t *dst, uint32_t val)
+{
+   dst[0] = (uint8_t)(val >> 24);
+   dst[1] = (uint8_t)(val >> 16);
+   dst[2] = (uint8_t)(val >> 8);
+   dst[3] = (uint8_t)(val);
+}
+
+static uint32_t netplay_udp_read_u32(const uint8_t *src)
+{
+   return ((uint32_t)src[0] << 24)
+        | ((uint32_t)src[1] << 16)
+        | ((uint32_t)src[2] << 8)
+        |  (uint32_t)src[3];
+}
+
+bool netplay_udp_random(void *buf, size_t len)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   HCRYPTPROV prov;
+   bool       ok;
+
+   if (!CryptAcquireContext(&prov, NULL, NULL, PROV_RSA_FULL,
+            CRYPT_VERIFYCONTEXT | CRYPT_SILENT))
+      return false;
+   ok = CryptGenRandom(prov, (DWORD)len, (BYTE*)buf) != 0;
+   CryptReleaseContext(prov, 0);
+   return ok;
+#else
+   size_t got;
+   FILE  *fp = fopen("/dev/urandom", "rb");
+
+   if (!fp)
+      return false;
+   got = fread(buf, 1, len, fp);
+   fclose(fp);
+   return got == len;
+#endif
+}
+
+void netplay_udp_window_reset(netplay_udp_window_t *window,
+      uint32_t devices, uint32_t words)
+{
+   window->end_frame = 0;
+   window->devices   = devices;
+   window->words     = words;
+   window->count     = 0;
+}
+
+void netplay_udp_window_push(netplay_udp_window_t *window,
+      uint32_t frame, uint32_t devices, uint32_t words,
+      const uint32_t *input)
+{
+   if (words > NETPLAY_UDP_MAX_WORDS)
+   {
+      /* Too large to carry, leave it to TCP */
+      netplay_udp_window_reset(window, devices, 0);
+      return;
+   }
+
+   if (     window->devices != devices
+         || window->words   != words
+         || (window->count && frame != window->end_frame))
+      netplay_udp_window_reset(window, devices, words);
+
+   memcpy(window->input[frame % NETPLAY_UDP_MAX_FRAMES], input,
+         words * sizeof(uint32_t));
+   window->end_frame = frame + 1;
+   if (window->count < NETPLAY_UDP_MAX_FRAMES)
+      window->count++;
+}
+
+size_t netplay_udp_encode(const netplay_udp_window_t *window,
+      uint32_t from_frame, uint32_t token, uint32_t ack,
+      uint16_t client_num, uint8_t *buf, size_t len)
+{
+   uint32_t first = window->end_frame - window->count;
+   uint32_t count, i, j;
+   size_t   _len;
+
+   /* Frame numbers wrap, so compare through the difference */
+   if ((int32_t)(from_frame - first) > 0)
+      first = from_frame;
+   count = ((int32_t)(window->end_frame - first) > 0)
+      ? window->end_frame - first : 0;
+   if (!window->words)
+      count = 0;
+
+   _len = NETPLAY_UDP_HEADER_SIZE + count * window->words * sizeof(uint32_t);
+   if (len < _len)
+      return 0;
+
+   netplay_udp_write_u32(buf,      NETPLAY_UDP_MAGIC);
+   netplay_udp_write_u32(buf +  4, token);
+   netplay_udp_write_u32(buf +  8, ack);
+   netplay_udp_write_u32(buf + 12, ((uint32_t)client_num << 16) | count);
+   netplay_udp_write_u32(buf + 16, window->devices);
+   netplay_udp_write_u32(buf + 20, window->words);
+   netplay_udp_write_u32(buf + 24, first);
+
+   buf += NETPLAY_UDP_HEADER_SIZE;
+   for (i = 0; i < count; i++)
+   {
+      const uint32_t *input =
+         window->input[(first + i) % NETPLAY_UDP_MAX_FRAMES];
+      for (j = 0; j < window->words; j++, buf += 4)
+         netplay_udp_write_u32(buf, input[j]);
+   }
+
+   return _len;
+}
+
+bool netplay_udp_decode(const uint8_t *buf, size_t len,
+      netplay_udp_packet_t *pkt)
+{
+   uint32_t val;
+
+   if (len < NETPLAY_UDP_HEADER_SIZE
+         || netplay_udp_read_u32(buf) != NETPLAY_UDP_MAGIC)
+      return false;
+
+   pkt->token       = netplay_udp_read_u32(buf +  4);
+   pkt->ack         = netplay_udp_read_u32(buf +  8);
+   val              = netplay_udp_read_u32(buf + 12);
+   pkt->client_num  = (uint16_t)(val >> 16);
+   pkt->count       = (uint16_t)(val & 0xFFFF);
+   pkt->devices     = netplay_udp_read_u32(buf + 16);
+   pkt->words       = netplay_udp_read_u32(buf + 20);
+   pkt->first_frame = netplay_udp_read_u32(buf + 24);
+   pkt->input       = buf + NETPLAY_UDP_HEADER_SIZE;
+
+   if (     pkt->words > NETPLAY_UDP_MAX_WORDS
+         || pkt->count > NETPLAY_UDP_MAX_FRAMES)
+      return false;
+
+   return len == NETPLAY_UDP_HEADER_SIZE
+      + (size_t)pkt->count * pkt->words * sizeof(uint32_t);
+}
+
+void netplay_udp_packet_input(const netplay_udp_packet_t *pkt,
+      unsigned idx, uint32_t *input)
+{
+   uint32_t i;
+   const uint8_t *src = pkt->input + (size_t)idx * pkt->words * 4;
+
+   for (i = 0; i < pkt->words; i++, src += 4)
+      input[i] = netplay_udp_read_u32(src);
+}
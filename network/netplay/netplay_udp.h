@@ -0,0 +1,128 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_NETPLAY_UDP_H
+#define __RARCH_NETPLAY_UDP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Datagram channel for input frames.
+ *
+ * Input still goes over the TCP stream, which stays the reliable path;
+ * the datagram copy only lets a frame arrive before a lost TCP segment
+ * has been retransmitted. Both copies carry the same input, so whichever
+ * arrives first is used and the other is dropped as a duplicate. Each
+ * datagram repeats every frame the peer has not acknowledged yet (up to
+ * NETPLAY_UDP_MAX_FRAMES), so a single lost datagram costs nothing as
+ * long as the next one gets through.
+ *
+ * A datagram is only accepted with the token the server drew for the
+ * connection from the system's entropy source, and only from the host
+ * the TCP connection comes from. The server follows a client to a new
+ * port on that host, e.g. after a NAT rebinding; a client only accepts
+ * the server's datagram port.
+ *
+ * Datagram layout, all fields big endian:
+ *   uint32_t magic        NETPLAY_UDP_MAGIC
+ *   uint32_t token        connection token handed out by the server
+ *   uint32_t ack          next frame the sender expects from the receiver
+ *   uint16_t client_num   whose input this is
+ *   uint16_t count        number of frames that follow, may be 0
+ *   uint32_t devices      device bitmap the input was packed for
+ *   uint32_t words        input words per frame
+ *   uint32_t first_frame
+ *   uint32_t input[count][words]
+ *
+ * Like netplay_snapshot.c, this module does not depend on RetroArch
+ * internals. */
+
+#define NETPLAY_UDP_MAGIC       0x52414450 /* "RADP" */
+#define NETPLAY_UDP_HEADER_SIZE 28
+#define NETPLAY_UDP_MAX_FRAMES  8
+#define NETPLAY_UDP_MAX_WORDS   16
+#define NETPLAY_UDP_MAX_PACKET  (NETPLAY_UDP_HEADER_SIZE \
+      + NETPLAY_UDP_MAX_FRAMES * NETPLAY_UDP_MAX_WORDS * 4)
+
+/* The most recent input frames of one sender */
+typedef struct netplay_udp_window
+{
+   uint32_t input[NETPLAY_UDP_MAX_FRAMES][NETPLAY_UDP_MAX_WORDS];
+   /* One past the newest frame held */
+   uint32_t end_frame;
+   uint32_t devices;
+   uint32_t words;
+   unsigned count;
+} netplay_udp_window_t;
+
+typedef struct netplay_udp_packet
+{
+   const uint8_t *input;
+   uint32_t token;
+   uint32_t ack;
+   uint32_t devices;
+   uint32_t words;
+   uint32_t first_frame;
+   uint16_t client_num;
+   uint16_t count;
+} netplay_udp_packet_t;
+
+/* Fills 'buf' from the system's entropy source. Returns false if there
+ * is none, the datagram channel is not offered then. */
+bool netplay_udp_random(void *buf, size_t len);
+
+void netplay_udp_window_reset(netplay_udp_window_t *window,
+      uint32_t devices, uint32_t words);
+
+/**
+ * netplay_udp_window_push
+ *
+ * Adds the input of 'frame' (host byte order, window->words words).
+ * Frames must be pushed in order; a gap or a change of layout restarts
+ * the window.
+ */
+void netplay_udp_window_push(netplay_udp_window_t *window,
+      uint32_t frame, uint32_t devices, uint32_t words,
+      const uint32_t *input);
+
+/**
+ * netplay_udp_encode
+ *
+ * Writes a datagram carrying every held frame from 'from_frame' on.
+ * Returns the datagram size, or 0 if 'len' is too small.
+ */
+size_t netplay_udp_encode(const netplay_udp_window_t *window,
+      uint32_t from_frame, uint32_t token, uint32_t ack,
+      uint16_t client_num, uint8_t *buf, size_t len);
+
+/**
+ * netplay_udp_decode
+ *
+ * Validates a received datagram. The packet points into 'buf'.
+ */
+bool netplay_udp_decode(const uint8_t *buf, size_t len,
+      netplay_udp_packet_t *pkt);
+
+/* Copies frame 'idx' of a decoded packet out in host byte order. */
+void netplay_udp_packet_input(const netplay_udp_packet_t *pkt,
+      unsigned idx, uint32_t *input);
+
+RETRO_END_DECLS
+
+#endif
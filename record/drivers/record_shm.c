@@ -0,0 +1,174 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+
+#include "record_shm.h"
+#include "../record_shm_ring.h"
+#include "../../verbosity.h"
+
+/* Publishes frames and audio to a shared memory ring instead of encoding
+ * them; see record_shm_ring.h for the layout and the reader side.
+ *
+ * The object is named after the recording file without directory and
+ * extension, so "--record foo" exports to /dev/shm/foo on Linux. */
+
+/* Half a second of audio at most rates */
+#define RECORD_SHM_AUDIO_FRAMES 32768
+
+typedef struct record_shm_handle
+{
+   record_shm_ring_t ring;
+   bool warned;
+} record_shm_handle_t;
+
+static void record_shm_name(char *s, size_t len, const char *filename)
+{
+   size_t i;
+   size_t _len     = 1;
+   const char *src = path_basename(filename);
+
+   s[0] = '/';
+   for (i = 0; src && src[i] && src[i] != '.' && _len < len - 1; i++)
+   {
+      char c = src[i];
+      if (     (c >= 'a' && c <= 'z')
+            || (c >= 'A' && c <= 'Z')
+            || (c >= '0' && c <= '9')
+            || c == '-' || c == '_')
+         s[_len++] = c;
+      else
+         s[_len++] = '_';
+   }
+   if (_len == 1)
+   {
+      strlcpy(s, "/retroarch", len);
+      return;
+   }
+   s[_len] = '\0';
+}
+
+static void *record_shm_new(const struct record_params *params)
+{
+   char name[128];
+   unsigned format;
+   record_shm_handle_t *handle = (record_shm_handle_t*)
+      calloc(1, sizeof(*handle));
+
+   if (!handle)
+      return NULL;
+
+   switch (params->pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         format = RECORD_SHM_PIX_RGB565;
+         break;
+      case FFEMU_PIX_BGR24:
+         format = RECORD_SHM_PIX_BGR24;
+         break;
+      default:
+         format = RECORD_SHM_PIX_XRGB8888;
+         break;
+   }
+
+   record_shm_name(name, sizeof(name), params->filename);
+
+   if (!record_shm_create(&handle->ring, name,
+            params->fb_width, params->fb_height, format,
+            params->channels, (unsigned)params->samplerate,
+            RECORD_SHM_AUDIO_FRAMES, params->fps))
+   {
+      RARCH_ERR("[SHM] Cannot create \"%s\": %s.\n", name, strerror(errno));
+      free(handle);
+      return NULL;
+   }
+
+   RARCH_LOG("[SHM] Exporting %ux%u video and %u Hz audio to \"%s\".\n",
+         params->fb_width, params->fb_height,
+         (unsigned)params->samplerate, name);
+   return handle;
+}
+
+static bool record_shm_push_video(void *data,
+      const struct record_video_data *video_data)
+{
+   record_shm_handle_t *handle = (record_shm_handle_t*)data;
+
+   if (!handle)
+      return false;
+
+   if (video_data->is_dupe || !video_data->data)
+   {
+      record_shm_publish_dupe(&handle->ring);
+      return true;
+   }
+
+   if (!record_shm_publish_video(&handle->ring, video_data->data,
+            video_data->width, video_data->height, video_data->pitch,
+            (uint64_t)cpu_features_get_time_usec()))
+   {
+      if (!handle->warned)
+         RARCH_WARN("[SHM] Dropping %ux%u frames, larger than the export.\n",
+               video_data->width, video_data->height);
+      handle->warned = true;
+      return false;
+   }
+
+   return true;
+}
+
+static bool record_shm_push_audio(void *data,
+      const struct record_audio_data *audio_data)
+{
+   record_shm_handle_t *handle = (record_shm_handle_t*)data;
+
+   if (!handle)
+      return false;
+
+   record_shm_publish_audio(&handle->ring,
+         (const int16_t*)audio_data->data, audio_data->frames,
+         (uint64_t)cpu_features_get_time_usec());
+   return true;
+}
+
+static bool record_shm_finalize(void *data)
+{
+   return true;
+}
+
+static void record_shm_free(void *data)
+{
+   record_shm_handle_t *handle = (record_shm_handle_t*)data;
+
+   if (!handle)
+      return;
+
+   record_shm_destroy(&handle->ring);
+   free(handle);
+}
+
+const record_driver_t record_shm = {
+   record_shm_new,
+   record_shm_free,
+   record_shm_push_video,
+   record_shm_push_audio,
+   record_shm_finalize,
+   "shm",
+};
@@ -33,6 +33,9 @@
 #include "record_driver.h"
 #include "drivers/record_ffmpeg.h"
 #include "drivers/record_wav.h"
+#ifdef HAVE_RECORD_SHM
+#include "drivers/record_shm.h"
+#endif
 
 static recording_state_t recording_state = {0};
 
@@ -50,6 +53,9 @@ const record_driver_t *record_drivers[] = {
    &record_ffmpeg,
 #endif
    &record_wav,
+#ifdef HAVE_RECORD_SHM
+   &record_shm,
+#endif
    &record_null,
    NULL,
 };
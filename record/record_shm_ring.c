@@ -0,0 +1,453 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "record_shm_ring.h"
+
+/* Full barrier; the writer and the readers are separate processes */
+#define RECORD_SHM_BARRIER() __sync_synchronize()
+
+/* Gives up on a busy slot after this many attempts */
+#define RECORD_SHM_RETRIES 64
+
+static record_shm_slot_t *record_shm_slot(const record_shm_ring_t *ring,
+      uint64_t frame)
+{
+   return (record_shm_slot_t*)(ring->base + ring->hdr->header_size
+         + (size_t)(frame % ring->hdr->video_slots)
+         * ring->hdr->video_slot_size);
+}
+
+static int16_t *record_shm_audio(const record_shm_ring_t *ring)
+{
+   return (int16_t*)(ring->base + ring->hdr->header_size
+         + (size_t)ring->hdr->video_slots * ring->hdr->video_slot_size);
+}
+
+unsigned record_shm_bytes_per_pixel(unsigned format)
+{
+   switch (format)
+   {
+      case RECORD_SHM_PIX_RGB565:
+         return 2;
+      case RECORD_SHM_PIX_BGR24:
+         return 3;
+      default:
+         break;
+   }
+   return 4;
+}
+
+bool record_shm_create(record_shm_ring_t *ring, const char *name,
+      unsigned max_width, unsigned max_height, unsigned format,
+      unsigned audio_channels, unsigned audio_rate,
+      unsigned audio_capacity, double fps)
+{
+   int fd;
+   void *map;
+   size_t size;
+   unsigned capacity = 1;
+   uint64_t slot_size = RECORD_SHM_SLOT_HEADER + (((uint64_t)max_width
+            * max_height * record_shm_bytes_per_pixel(format) + 63) & ~63);
+
+   memset(ring, 0, sizeof(*ring));
+
+   while (capacity < audio_capacity)
+      capacity <<= 1;
+   if (!audio_channels)
+      capacity = 0;
+
+   size = RECORD_SHM_HEADER_SIZE
+      + RECORD_SHM_VIDEO_SLOTS * slot_size
+      + (size_t)capacity * audio_channels * sizeof(int16_t);
+
+   /* A stale object from a crashed run would have the wrong size */
+   shm_unlink(name);
+   fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return false;
+
+   if (ftruncate(fd, (off_t)size) < 0)
+   {
+      close(fd);
+      shm_unlink(name);
+      return false;
+   }
+
+   map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED)
+   {
+      shm_unlink(name);
+      return false;
+   }
+
+   ring->base                = (uint8_t*)map;
+   ring->hdr                 = (record_shm_header_t*)map;
+   ring->size                = size;
+   ring->next_frame          = 1;
+   ring->writer              = true;
+   strncpy(ring->name, name, sizeof(ring->name) - 1);
+
+   /* ftruncate zero-filled everything else */
+   ring->hdr->video_slot_size = slot_size;
+   ring->hdr->fps             = fps;
+   ring->hdr->header_size     = RECORD_SHM_HEADER_SIZE;
+   ring->hdr->video_slots     = RECORD_SHM_VIDEO_SLOTS;
+   ring->hdr->max_width       = max_width;
+   ring->hdr->max_height      = max_height;
+   ring->hdr->format          = format;
+   ring->hdr->audio_channels  = audio_channels;
+   ring->hdr->audio_rate      = audio_rate;
+   ring->hdr->audio_capacity  = capacity;
+   ring->hdr->writer_pid      = (uint32_t)getpid();
+   ring->hdr->version         = RECORD_SHM_VERSION;
+   RECORD_SHM_BARRIER();
+   /* Readers check the magic last */
+   ring->hdr->magic           = RECORD_SHM_MAGIC;
+
+   return true;
+}
+
+bool record_shm_publish_video(record_shm_ring_t *ring, const void *data,
+      unsigned width, unsigned height, int pitch, uint64_t time_usec)
+{
+   unsigned y;
+   uint8_t *dst;
+   const uint8_t *src;
+   record_shm_slot_t *slot;
+   uint64_t frame   = ring->next_frame;
+   unsigned bpp     = record_shm_bytes_per_pixel(ring->hdr->format);
+   size_t row_bytes = (size_t)width * bpp;
+
+   if (     width  > ring->hdr->max_width
+         || height > ring->hdr->max_height)
+      return false;
+
+   slot = record_shm_slot(ring, frame);
+   dst  = (uint8_t*)slot + RECORD_SHM_SLOT_HEADER;
+   src  = (const uint8_t*)data;
+
+   slot->lock++;
+   RECORD_SHM_BARRIER();
+
+   slot->frame     = frame;
+   slot->time_usec = time_usec;
+   slot->width     = width;
+   slot->height    = height;
+   slot->pitch     = (uint32_t)row_bytes;
+   slot->format    = ring->hdr->format;
+   slot->dupes     = ring->dupes;
+
+   if ((size_t)pitch == row_bytes)
+      memcpy(dst, src, row_bytes * height);
+   else
+      for (y = 0; y < height; y++, dst += row_bytes, src += pitch)
+         memcpy(dst, src, row_bytes);
+
+   RECORD_SHM_BARRIER();
+   slot->lock++;
+   RECORD_SHM_BARRIER();
+
+   ring->hdr->video_frame = frame;
+   ring->next_frame       = frame + 1;
+   ring->dupes            = 0;
+   return true;
+}
+
+void record_shm_publish_dupe(record_shm_ring_t *ring)
+{
+   ring->dupes++;
+}
+
+void record_shm_publish_audio(record_shm_ring_t *ring,
+      const int16_t *samples, size_t frames, uint64_t time_usec)
+{
+   record_shm_header_t *hdr = ring->hdr;
+   unsigned channels        = hdr->audio_channels;
+   size_t capacity          = hdr->audio_capacity;
+   int16_t *audio           = record_shm_audio(ring);
+   uint64_t pos             = hdr->audio_pos;
+
+   if (!capacity || !frames)
+      return;
+
+   /* Only the newest ring's worth can be kept anyway */
+   if (frames > capacity)
+   {
+      samples += (frames - capacity) * channels;
+      pos     += frames - capacity;
+      frames   = capacity;
+   }
+
+   /* Announce the frames about to be overwritten */
+   hdr->audio_lock++;
+   RECORD_SHM_BARRIER();
+   hdr->audio_reserve = pos + frames;
+   RECORD_SHM_BARRIER();
+   hdr->audio_lock++;
+   RECORD_SHM_BARRIER();
+
+   {
+      size_t start = (size_t)(pos & (capacity - 1));
+      size_t first = capacity - start;
+      if (first > frames)
+         first = frames;
+      memcpy(audio + start * channels, samples,
+            first * channels * sizeof(int16_t));
+      memcpy(audio, samples + first * channels,
+            (frames - first) * channels * sizeof(int16_t));
+   }
+
+   RECORD_SHM_BARRIER();
+   hdr->audio_lock++;
+   RECORD_SHM_BARRIER();
+   hdr->audio_pos       = pos + frames;
+   hdr->audio_time_usec = time_usec;
+   RECORD_SHM_BARRIER();
+   hdr->audio_lock++;
+}
+
+void record_shm_destroy(record_shm_ring_t *ring)
+{
+   if (!ring->base)
+      return;
+
+   ring->hdr->closed = 1;
+   RECORD_SHM_BARRIER();
+   munmap(ring->base, ring->size);
+   /* Attached readers keep their mapping */
+   shm_unlink(ring->name);
+   memset(ring, 0, sizeof(*ring));
+}
+
+bool record_shm_attach(record_shm_ring_t *ring, const char *name)
+{
+   struct stat st;
+   void *map;
+   const record_shm_header_t *hdr;
+   int fd = shm_open(name, O_RDONLY, 0);
+
+   memset(ring, 0, sizeof(*ring));
+
+   if (fd < 0)
+      return false;
+
+   if (     fstat(fd, &st) < 0
+         || (size_t)st.st_size < RECORD_SHM_HEADER_SIZE)
+   {
+      close(fd);
+      return false;
+   }
+
+   map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED)
+      return false;
+
+   hdr = (const record_shm_header_t*)map;
+   RECORD_SHM_BARRIER();
+   if (     hdr->magic       != RECORD_SHM_MAGIC
+         || hdr->version     != RECORD_SHM_VERSION
+         || hdr->video_slots == 0
+         || (size_t)st.st_size < hdr->header_size
+            + (size_t)hdr->video_slots * hdr->video_slot_size
+            + (size_t)hdr->audio_capacity * hdr->audio_channels
+            * sizeof(int16_t))
+   {
+      munmap(map, (size_t)st.st_size);
+      return false;
+   }
+
+   ring->base = (uint8_t*)map;
+   ring->hdr  = (record_shm_header_t*)map;
+   ring->size = (size_t)st.st_size;
+   strncpy(ring->name, name, sizeof(ring->name) - 1);
+   return true;
+}
+
+void record_shm_detach(record_shm_ring_t *ring)
+{
+   if (ring->base)
+      munmap(ring->base, ring->size);
+   memset(ring, 0, sizeof(*ring));
+}
+
+int record_shm_peek_video(const record_shm_ring_t *ring, uint64_t after,
+      record_shm_frame_t *frame)
+{
+   unsigned i;
+
+   for (i = 0; i < RECORD_SHM_RETRIES; i++)
+   {
+      const record_shm_slot_t *slot;
+      uint64_t newest = ring->hdr->video_frame;
+
+      if (newest <= after)
+         return ring->hdr->closed ? -1 : 0;
+
+      slot        = record_shm_slot(ring, newest);
+      frame->lock = slot->lock;
+      RECORD_SHM_BARRIER();
+
+      /* Being rewritten, or already holding a later frame */
+      if ((frame->lock & 1) || slot->frame != newest)
+         continue;
+
+      frame->slot      = slot;
+      frame->frame     = newest;
+      frame->time_usec = slot->time_usec;
+      frame->width     = slot->width;
+      frame->height    = slot->height;
+      frame->pitch     = slot->pitch;
+      frame->format    = slot->format;
+      frame->dupes     = slot->dupes;
+      frame->data      = (const uint8_t*)slot + RECORD_SHM_SLOT_HEADER;
+
+      if (     frame->width  > ring->hdr->max_width
+            || frame->height > ring->hdr->max_height
+            || !record_shm_frame_valid(frame))
+         continue;
+      return 1;
+   }
+
+   return 0;
+}
+
+bool record_shm_frame_valid(const record_shm_frame_t *frame)
+{
+   RECORD_SHM_BARRIER();
+   return frame->slot->lock == frame->lock;
+}
+
+int record_shm_read_video(const record_shm_ring_t *ring, uint64_t after,
+      record_shm_frame_t *frame, void *buf, size_t len)
+{
+   unsigned i;
+
+   for (i = 0; i < RECORD_SHM_RETRIES; i++)
+   {
+      size_t size;
+      int ret = record_shm_peek_video(ring, after, frame);
+
+      if (ret <= 0)
+         return ret;
+
+      size = (size_t)frame->pitch * frame->height;
+      if (size > len)
+         return 0;
+
+      memcpy(buf, frame->data, size);
+      if (record_shm_frame_valid(frame))
+      {
+         frame->data = buf;
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static void record_shm_audio_state(const record_shm_ring_t *ring,
+      uint64_t *pos, uint64_t *reserve, uint64_t *time_usec)
+{
+   const record_shm_header_t *hdr = ring->hdr;
+
+   for (;;)
+   {
+      uint32_t lock = hdr->audio_lock;
+      RECORD_SHM_BARRIER();
+      if (lock & 1)
+         continue;
+      *pos       = hdr->audio_pos;
+      *reserve   = hdr->audio_reserve;
+      *time_usec = hdr->audio_time_usec;
+      RECORD_SHM_BARRIER();
+      if (hdr->audio_lock == lock)
+         return;
+   }
+}
+
+void record_shm_audio_clock(const record_shm_ring_t *ring,
+      uint64_t *pos, uint64_t *time_usec)
+{
+   uint64_t reserve;
+   record_shm_audio_state(ring, pos, &reserve, time_usec);
+}
+
+size_t record_shm_read_audio(const record_shm_ring_t *ring, uint64_t *pos,
+      int16_t *buf, size_t max_frames, uint64_t *dropped)
+{
+   uint64_t written, reserve, time_usec, lost;
+   size_t frames, start, first;
+   unsigned channels     = ring->hdr->audio_channels;
+   uint64_t capacity     = ring->hdr->audio_capacity;
+   const int16_t *audio  = record_shm_audio(ring);
+
+   if (!capacity)
+      return 0;
+
+   record_shm_audio_state(ring, &written, &reserve, &time_usec);
+
+   if (*pos > written)
+      *pos = written;
+   if (reserve - *pos > capacity)
+   {
+      lost     = reserve - capacity - *pos;
+      *pos    += lost;
+      *dropped += lost;
+   }
+
+   frames = (size_t)(written - *pos);
+   if (frames > max_frames)
+      frames = max_frames;
+   if (!frames)
+      return 0;
+
+   start = (size_t)(*pos & (capacity - 1));
+   first = (size_t)capacity - start;
+   if (first > frames)
+      first = frames;
+   memcpy(buf, audio + start * channels, first * channels * sizeof(int16_t));
+   memcpy(buf + first * channels, audio,
+         (frames - first) * channels * sizeof(int16_t));
+
+   /* Anything the writer started overwriting meanwhile is lost */
+   record_shm_audio_state(ring, &written, &reserve, &time_usec);
+   if (reserve - *pos > capacity)
+   {
+      lost = reserve - capacity - *pos;
+      if (lost >= frames)
+      {
+         *pos     += lost;
+         *dropped += lost;
+         return 0;
+      }
+      memmove(buf, buf + lost * channels,
+            (frames - lost) * channels * sizeof(int16_t));
+      frames   -= lost;
+      *pos     += lost;
+      *dropped += lost;
+   }
+
+   *pos += frames;
+   return frames;
+}
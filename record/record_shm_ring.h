@@ -0,0 +1,205 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RECORD_SHM_RING_H
+#define __RARCH_RECORD_SHM_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Frame and audio export through a POSIX shared memory object.
+ *
+ * The "shm" record driver is the only writer; any number of readers may
+ * map the object read-only. Readers never hold the writer up: a reader
+ * that falls behind loses frames or audio, and is told so.
+ *
+ * Layout, native endian:
+ *   record_shm_header_t                     header_size bytes
+ *   video slot [video_slots]                video_slot_size bytes each
+ *      record_shm_slot_t, then the pixels (rows packed, pitch bytes apart)
+ *   audio ring                              audio_capacity frames of
+ *                                           int16_t[audio_channels]
+ *
+ * Video frame N (counting from 1) goes to slot N % video_slots. Each slot
+ * is guarded by a sequence lock that is odd while the slot is written, so
+ * a reader checks the lock before and after touching the pixels and
+ * drops the frame if it changed. With the default four slots a reader has
+ * about three frame times to consume a frame in place.
+ *
+ * Audio is a plain ring; audio_pos counts every frame ever written and a
+ * reader keeps its own position. Timestamps are microseconds of the
+ * writer's monotonic clock (CLOCK_MONOTONIC on POSIX).
+ *
+ * This module only depends on libc and POSIX, so tools can build it
+ * directly as the reader library. */
+
+#define RECORD_SHM_MAGIC        0x48534152 /* "RASH" */
+#define RECORD_SHM_VERSION      1
+#define RECORD_SHM_VIDEO_SLOTS  4
+#define RECORD_SHM_HEADER_SIZE  256
+#define RECORD_SHM_SLOT_HEADER  64
+
+enum record_shm_pix_fmt
+{
+   RECORD_SHM_PIX_RGB565 = 0,
+   RECORD_SHM_PIX_BGR24,
+   RECORD_SHM_PIX_XRGB8888
+};
+
+typedef struct record_shm_header
+{
+   uint64_t video_slot_size;
+   double   fps;
+
+   /* Written by the producer while running */
+   volatile uint64_t video_frame;      /* Newest complete frame, 0 = none */
+   volatile uint64_t audio_pos;        /* Audio frames written in total */
+   volatile uint64_t audio_reserve;    /* Written up to, once done */
+   volatile uint64_t audio_time_usec;  /* When audio_pos was reached */
+   volatile uint32_t audio_lock;       /* Guards the three above */
+   volatile uint32_t closed;           /* Producer went away */
+
+   uint32_t magic;
+   uint32_t version;
+   uint32_t header_size;
+   uint32_t video_slots;
+   uint32_t max_width;
+   uint32_t max_height;
+   uint32_t format;                    /* enum record_shm_pix_fmt */
+   uint32_t audio_channels;
+   uint32_t audio_rate;
+   uint32_t audio_capacity;            /* Frames, a power of two */
+   uint32_t writer_pid;
+} record_shm_header_t;
+
+typedef struct record_shm_slot
+{
+   uint64_t frame;
+   uint64_t time_usec;
+   volatile uint32_t lock;
+   uint32_t width;
+   uint32_t height;
+   uint32_t pitch;
+   uint32_t format;
+   /* Duplicated frames skipped since the previous one */
+   uint32_t dupes;
+} record_shm_slot_t;
+
+typedef struct record_shm_ring
+{
+   record_shm_header_t *hdr;
+   uint8_t *base;
+   size_t size;
+   /* Next frame number, writer only */
+   uint64_t next_frame;
+   uint32_t dupes;
+   char name[128];
+   bool writer;
+} record_shm_ring_t;
+
+/* A frame as seen in place, valid until the slot is reused */
+typedef struct record_shm_frame
+{
+   const void *data;
+   const record_shm_slot_t *slot;
+   uint64_t frame;
+   uint64_t time_usec;
+   uint32_t lock;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned format;
+   unsigned dupes;
+} record_shm_frame_t;
+
+unsigned record_shm_bytes_per_pixel(unsigned format);
+
+/**
+ * record_shm_create:
+ *
+ * Creates (replacing any stale object of that name) and maps the shared
+ * memory object @name, which must start with '/'.
+ **/
+bool record_shm_create(record_shm_ring_t *ring, const char *name,
+      unsigned max_width, unsigned max_height, unsigned format,
+      unsigned audio_channels, unsigned audio_rate,
+      unsigned audio_capacity, double fps);
+
+/* Copies a frame into the next slot; @pitch may be negative. */
+bool record_shm_publish_video(record_shm_ring_t *ring, const void *data,
+      unsigned width, unsigned height, int pitch, uint64_t time_usec);
+
+/* Counts a duplicated frame against the next published one. */
+void record_shm_publish_dupe(record_shm_ring_t *ring);
+
+void record_shm_publish_audio(record_shm_ring_t *ring,
+      const int16_t *samples, size_t frames, uint64_t time_usec);
+
+/* Marks the export closed, unmaps it and removes the name. */
+void record_shm_destroy(record_shm_ring_t *ring);
+
+/* Maps an existing export read-only. */
+bool record_shm_attach(record_shm_ring_t *ring, const char *name);
+
+void record_shm_detach(record_shm_ring_t *ring);
+
+/**
+ * record_shm_peek_video:
+ *
+ * Looks up the newest frame if it is newer than @after, without copying.
+ * Once done with frame->data, record_shm_frame_valid() tells whether the
+ * writer reused the slot in the meantime.
+ *
+ * Returns 1 with a frame, 0 if there is nothing new, -1 once the writer
+ * has closed the export.
+ **/
+int record_shm_peek_video(const record_shm_ring_t *ring, uint64_t after,
+      record_shm_frame_t *frame);
+
+bool record_shm_frame_valid(const record_shm_frame_t *frame);
+
+/**
+ * record_shm_read_video:
+ *
+ * Like record_shm_peek_video(), but copies the frame to @buf (packed
+ * rows) and retries when it was overwritten during the copy. frame->data
+ * points to @buf on success.
+ **/
+int record_shm_read_video(const record_shm_ring_t *ring, uint64_t after,
+      record_shm_frame_t *frame, void *buf, size_t len);
+
+/**
+ * record_shm_read_audio:
+ *
+ * Copies up to @max_frames audio frames from *@pos on and advances *@pos.
+ * A reader that fell more than a ring behind is moved forward first and
+ * the skipped frames are added to *@dropped.
+ *
+ * Returns the number of frames copied.
+ **/
+size_t record_shm_read_audio(const record_shm_ring_t *ring, uint64_t *pos,
+      int16_t *buf, size_t max_frames, uint64_t *dropped);
+
+/* Audio position and time of the newest audio, read consistently. */
+void record_shm_audio_clock(const record_shm_ring_t *ring,
+      uint64_t *pos, uint64_t *time_usec);
+
+RETRO_END_DECLS
+
+#endif
@@ -71,6 +71,9 @@
 #include <libretro.h>
 #define VFS_FRONTEND
 #include <vfs/vfs_implementation.h>
+#ifdef HAVE_VFS_ARCHIVE
+#include <vfs/vfs_implementation_archive.h>
+#endif
 
 #include <features/features_cpu.h>
 
@@ -117,6 +120,11 @@
 #include "location_driver.h"
 
 #include "runloop.h"
+#include "runtime_file.h"
+#include "content_cache.h"
+#ifdef HAVE_ALLOC_COUNTER
+#include "alloc_counter.h"
+#endif
 #include "camera/camera_driver.h"
 #include "location_driver.h"
 #include "record/record_driver.h"
@@ -143,6 +151,7 @@
 #endif
 
 #include "input/input_remapping.h"
+#include "input/input_autodetect_index.h"
 
 #ifdef HAVE_CHEEVOS
 #include "cheevos/cheevos.h"
@@ -3405,6 +3414,7 @@ bool command_event(enum event_command cmd, void *data)
          break;
       case CMD_EVENT_UNDO_LOAD_STATE:
       case CMD_EVENT_UNDO_SAVE_STATE:
+      case CMD_EVENT_EXPORT_SAVE_STATE:
       case CMD_EVENT_LOAD_STATE_FROM_RAM:
          if (!command_event_main_state(cmd))
             return false;
@@ -5907,6 +5917,8 @@ void main_exit(void *args)
       menu_st->flags &= ~MENU_ST_FLAG_DATA_OWN;
 #endif
    retroarch_ctl(RARCH_CTL_MAIN_DEINIT, NULL);
+   runtime_log_deinit();
+   content_cache_deinit();
 
    if (runloop_st->perfcnt_enable)
    {
@@ -5943,6 +5955,7 @@ void main_exit(void *args)
    retroarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
    global_free(p_rarch);
    task_queue_deinit();
+   input_autodetect_index_free();
 
    ui_companion_driver_deinit();
    retroarch_config_deinit();
@@ -5954,6 +5967,9 @@ void main_exit(void *args)
    frontend_driver_free();
 
    rtime_deinit();
+#ifdef HAVE_VFS_ARCHIVE
+   retro_vfs_archive_deinit();
+#endif
 
 #if defined(ANDROID)
    play_feature_delivery_deinit();
@@ -5989,6 +6005,9 @@ int rarch_main(int argc, char *argv[], void *data)
    struct rarch_state *p_rarch         = &rarch_st;
    runloop_state_t *runloop_st         = runloop_state_get_ptr();
    video_driver_state_t *video_st      = video_state_get_ptr();
+#ifdef HAVE_ALLOC_COUNTER
+   bool alloc_counter_passed           = true;
+#endif
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
    video_st->flags   |= VIDEO_FLAG_SHADER_PRESETS_NEED_RELOAD;
 #endif
@@ -6020,6 +6039,9 @@ int rarch_main(int argc, char *argv[], void *data)
 #endif
 
    rtime_init();
+#ifdef HAVE_VFS_ARCHIVE
+   retro_vfs_archive_init();
+#endif
 
 #if defined(ANDROID)
    play_feature_delivery_init();
@@ -6101,8 +6123,14 @@ int rarch_main(int argc, char *argv[], void *data)
       bool app_exit     = false;
 #ifdef HAVE_QT
       ui_companion_qt.application->process_events();
+#endif
+#ifdef HAVE_ALLOC_COUNTER
+      alloc_counter_frame_begin();
 #endif
       ret = runloop_iterate();
+#ifdef HAVE_ALLOC_COUNTER
+      alloc_counter_frame_end();
+#endif
 
       task_queue_check();
 
@@ -6123,9 +6151,16 @@ int rarch_main(int argc, char *argv[], void *data)
       }
    }
 
+#ifdef HAVE_ALLOC_COUNTER
+   alloc_counter_passed = alloc_counter_report();
+#endif
    main_exit(data);
 #endif
 
+#ifdef HAVE_ALLOC_COUNTER
+   if (!alloc_counter_passed)
+      return 1;
+#endif
    return 0;
 }
 
@@ -7803,6 +7838,90 @@ static void retroarch_validate_cpu_features(void)
 #endif
 }
 
+#ifdef HAVE_THREADS
+/* Parses a list of CPUs such as "0,2-3" into a mask,
+ * 0 when empty */
+static uint64_t retroarch_parse_cpu_list(const char *list)
+{
+   uint64_t mask = 0;
+
+   while (*list)
+   {
+      char *end;
+      unsigned long first = strtoul(list, &end, 10);
+      unsigned long last  = first;
+
+      if (end == list)
+         break;
+      if (*end == '-')
+      {
+         const char *next = end + 1;
+         last = strtoul(next, &end, 10);
+         if (end == next)
+            break;
+      }
+      for (; first <= last && first < 64; first++)
+         mask |= (uint64_t)1 << first;
+
+      for (list = end; *list == ',' || *list == ' '; list++);
+   }
+
+   return mask;
+}
+
+/**
+ * retroarch_init_thread_roles:
+ *
+ * Registers the scheduling settings of the main, audio,
+ * video and task threads, and applies those of the main
+ * thread. The other threads apply theirs when they start,
+ * from the defaults rather than from the main thread settings.
+ * When disabled, the main thread gets its defaults back.
+ **/
+static void retroarch_init_thread_roles(settings_t *settings)
+{
+   unsigned i, flags;
+   struct sthread_role_config roles[STHREAD_ROLE_LAST];
+
+   if (!settings->bools.thread_roles_enable)
+   {
+      for (i = 0; i < STHREAD_ROLE_LAST; i++)
+         sthread_role_set_config((enum sthread_role)i, NULL);
+      sthread_role_restore();
+      return;
+   }
+
+   roles[STHREAD_ROLE_MAIN].cpu_mask  = retroarch_parse_cpu_list(settings->arrays.thread_main_cpus);
+   roles[STHREAD_ROLE_MAIN].sched     = settings->uints.thread_main_policy;
+   roles[STHREAD_ROLE_MAIN].priority  = settings->ints.thread_main_priority;
+   roles[STHREAD_ROLE_AUDIO].cpu_mask = retroarch_parse_cpu_list(settings->arrays.thread_audio_cpus);
+   roles[STHREAD_ROLE_AUDIO].sched    = settings->uints.thread_audio_policy;
+   roles[STHREAD_ROLE_AUDIO].priority = settings->ints.thread_audio_priority;
+   roles[STHREAD_ROLE_VIDEO].cpu_mask = retroarch_parse_cpu_list(settings->arrays.thread_video_cpus);
+   roles[STHREAD_ROLE_VIDEO].sched    = settings->uints.thread_video_policy;
+   roles[STHREAD_ROLE_VIDEO].priority = settings->ints.thread_video_priority;
+   roles[STHREAD_ROLE_TASK].cpu_mask  = retroarch_parse_cpu_list(settings->arrays.thread_task_cpus);
+   roles[STHREAD_ROLE_TASK].sched     = settings->uints.thread_task_policy;
+   roles[STHREAD_ROLE_TASK].priority  = settings->ints.thread_task_priority;
+
+   for (i = 0; i < STHREAD_ROLE_LAST; i++)
+   {
+      roles[i].fallback_nice  = DEFAULT_THREAD_RT_FALLBACK_NICE;
+      /* Background tasks do not need precise wake-ups */
+      roles[i].timer_slack_ns = (i == STHREAD_ROLE_TASK)
+         ? 0 : settings->uints.thread_timer_slack;
+      sthread_role_set_config((enum sthread_role)i, &roles[i]);
+   }
+
+   flags = sthread_role_apply(STHREAD_ROLE_MAIN);
+   RARCH_LOG("[Threads] Main thread: affinity %s, scheduling %s, timer slack %s.\n",
+         (flags & STHREAD_ROLE_FLAG_AFFINITY)       ? "set" : "unchanged",
+         (flags & STHREAD_ROLE_FLAG_SCHED)          ? "set"
+         : (flags & STHREAD_ROLE_FLAG_SCHED_FALLBACK) ? "fallback nice" : "unchanged",
+         (flags & STHREAD_ROLE_FLAG_TIMER_SLACK)    ? "set" : "unchanged");
+}
+#endif
+
 /**
  * retroarch_main_init:
  * @argc                 : Count of (commandline) arguments.
@@ -7945,6 +8064,9 @@ bool retroarch_main_init(int argc, char *argv[])
 #endif
 
    retroarch_validate_cpu_features();
+#ifdef HAVE_THREADS
+   retroarch_init_thread_roles(settings);
+#endif
    retroarch_init_task_queue();
 
    {
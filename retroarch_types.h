@@ -171,6 +171,7 @@ typedef struct rarch_system_info
    disk_control_interface_t disk_control;      /* ptr alignment */
    struct retro_system_info info;              /* ptr alignment */
    rarch_memory_map_t mmaps;                   /* ptr alignment */
+   struct retro_rollback_snapshot_interface rollback_snapshot; /* ptr alignment */
    const char *input_desc_btn[MAX_USERS][RARCH_FIRST_META_KEY];
    struct
    {
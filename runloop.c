@@ -243,6 +243,10 @@
 #include "ai/game_ai.h"
 #endif
 
+#ifdef HAVE_ALLOC_COUNTER
+#include "alloc_counter.h"
+#endif
+
 #define SHADER_FILE_WATCH_DELAY_MSEC 500
 
 #define QUIT_DELAY_USEC 3 * 1000000 /* 3 seconds */
@@ -3131,6 +3135,10 @@ bool runloop_environment_cb(unsigned cmd, void *data)
             result &= ~(RETRO_AV_ENABLE_VIDEO|RETRO_AV_ENABLE_AUDIO);
 #endif
 
+         /* Turbo fast-forward drops this frame */
+         if (runloop_st->fastforward_skip)
+            result &= ~(RETRO_AV_ENABLE_VIDEO|RETRO_AV_ENABLE_AUDIO);
+
 #if defined(HAVE_RUNAHEAD) || defined(HAVE_NETWORKING)
          /* Deprecated.
             Use RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT instead. */
@@ -3374,6 +3382,32 @@ bool runloop_environment_cb(unsigned cmd, void *data)
          }
          break;
 
+      case RETRO_ENVIRONMENT_SET_ROLLBACK_SNAPSHOT_INTERFACE:
+         {
+            const struct retro_rollback_snapshot_interface *snap_iface =
+                  (const struct retro_rollback_snapshot_interface*)data;
+
+            if (!sys_info)
+               return false;
+
+            memset(&sys_info->rollback_snapshot, 0,
+                  sizeof(sys_info->rollback_snapshot));
+
+            if (snap_iface)
+            {
+               if (     snap_iface->interface_version < RETRO_ROLLBACK_SNAPSHOT_INTERFACE_VERSION
+                     || !snap_iface->residue_serialize
+                     || !snap_iface->residue_unserialize)
+                  return false;
+               sys_info->rollback_snapshot = *snap_iface;
+            }
+
+            RARCH_LOG("[Environ] SET_ROLLBACK_SNAPSHOT_INTERFACE: %s (residue: %u bytes).\n",
+                  snap_iface ? "yes" : "no",
+                  snap_iface ? (unsigned)snap_iface->residue_max_size : 0);
+         }
+         break;
+
       case RETRO_ENVIRONMENT_GET_CLEAR_ALL_THREAD_WAITS_CB:
          *(retro_environment_t *)data = runloop_clear_all_thread_waits;
          break;
@@ -3977,6 +4011,8 @@ static bool core_unload_game(void)
       runloop_st->current_core.retro_unload_game();
       runloop_st->core_poll_type_override  = POLL_TYPE_OVERRIDE_DONTCARE;
       runloop_st->current_core.flags      &= ~RETRO_CORE_FLAG_GAME_LOADED;
+      memset(&runloop_st->system.rollback_snapshot, 0,
+            sizeof(runloop_st->system.rollback_snapshot));
    }
 
    audio_driver_stop();
@@ -7155,6 +7191,71 @@ end:
 
 
 
+#define RUNLOOP_FASTFORWARD_TURBO_MAX_FRAMES 64
+
+/**
+ * runloop_fastforward_turbo_run:
+ *
+ * Turbo fast-forward. Presenting a frame (pixel conversion,
+ * filters, the video driver) and processing its audio cost far
+ * more than many cores take to emulate it, so only the frames
+ * the display can actually show are presented. The others are
+ * run with audio and video disabled; cores that check
+ * RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE can skip rendering
+ * them entirely.
+ *
+ * Without a fast-forward rate limit, frames are run back to back
+ * until the display is due for the next one, skipping the
+ * per-iteration overhead of the runloop as well.
+ **/
+static void runloop_fastforward_turbo_run(runloop_state_t *runloop_st,
+      settings_t *settings, bool batch)
+{
+   unsigned frames             = 0;
+   float refresh_rate          = settings->floats.video_refresh_rate;
+   retro_time_t interval       = (refresh_rate > 0.0f)
+      ? (retro_time_t)(1000000.0f / refresh_rate)
+      : 16667;
+#ifdef HAVE_CHEEVOS
+   bool cheevos_enable         = settings->bools.cheevos_enable;
+#endif
+
+   for (;;)
+   {
+      retro_time_t now         = cpu_features_get_time_usec();
+      bool present             =
+            (now - runloop_st->fastforward_present_time >= interval)
+         || (now < runloop_st->fastforward_present_time)
+         || (++frames >= RUNLOOP_FASTFORWARD_TURBO_MAX_FRAMES);
+
+      runloop_st->fastforward_skip = !present;
+      core_run();
+      runloop_st->fastforward_skip = false;
+
+      if (present)
+      {
+         runloop_st->fastforward_present_time = now;
+         break;
+      }
+
+      if (!batch)
+         break;
+
+      /* The caller does this for the last frame of the batch */
+#ifdef HAVE_CHEEVOS
+      if (cheevos_enable)
+         rcheevos_test();
+#endif
+#ifdef HAVE_CHEATS
+      cheat_manager_apply_retro_cheats();
+#endif
+
+      /* Fast-forward runs with a locked frame time */
+      if (runloop_st->frame_time.callback)
+         runloop_st->frame_time.callback(runloop_st->frame_time.reference);
+   }
+}
+
 /**
  * runloop_iterate:
  *
@@ -7402,6 +7503,29 @@ int runloop_iterate(void)
          preempt_run(runloop_st->preempt_data, runloop_st);
       else
 #endif
+      if (     settings->bools.fastforward_turbo
+            && (runloop_st->flags & RUNLOOP_FLAG_FASTMOTION)
+            && !vrr_runloop_enable
+            && !rec_st->data
+#ifdef HAVE_NETWORKING
+            && !netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL)
+#endif
+#ifdef HAVE_MENU
+            && !(menu_state_get_ptr()->flags & MENU_ST_FLAG_ALIVE)
+#endif
+         )
+      {
+         /* Movies are stepped once per iteration, and a frame
+          * limit counts iterations, so only batch without them */
+         bool batch = runloop_get_fastforward_ratio(settings,
+                  &runloop_st->fastmotion_override.current) < 1.0f
+#ifdef HAVE_BSV_MOVIE
+            && !input_st->bsv_movie_state_handle
+#endif
+            ;
+         runloop_fastforward_turbo_run(runloop_st, settings, batch);
+      }
+      else
          core_run();
    }
 
@@ -8048,7 +8172,15 @@ void core_run(void)
    net_driver_state_t *net_st  = networking_state_get_ptr();
    bool in_gekkonet_frame      = net_st && net_st->gekkonet_running_frame;
    bool using_gekkonet         = net_st && net_st->backend == NETPLAY_BACKEND_GEKKONET && net_st->gekkonet_active;
-   bool netplay_preframe       = in_gekkonet_frame ? true :
+   bool netplay_preframe;
+#endif
+
+#ifdef HAVE_ALLOC_COUNTER
+   alloc_counter_core_run_begin();
+#endif
+
+#ifdef HAVE_NETWORKING
+   netplay_preframe            = in_gekkonet_frame ? true :
          netplay_driver_ctl(RARCH_NETPLAY_CTL_PRE_FRAME, NULL);
 
    if (!netplay_preframe)
@@ -8057,6 +8189,9 @@ void core_run(void)
        * netplay peer pausing doesn't just hang. */
       input_driver_poll();
       video_driver_cached_frame();
+#ifdef HAVE_ALLOC_COUNTER
+      alloc_counter_core_run_end();
+#endif
       return;
    }
 
@@ -8075,10 +8210,17 @@ void core_run(void)
 
    if (using_gekkonet && net_st->gekkonet_needs_run)
    {
+      retro_time_t start         = cpu_features_get_time_usec();
       net_st->gekkonet_needs_run = false;
       current_core->retro_run();
+      /* Presented frame cost, budgets how much of a rollback can be
+       * resimulated alongside it */
+      ra_gekkonet_budget_record(&net_st->gekkonet_budget,
+            cpu_features_get_time_usec() - start, false);
       net_st->gekkonet_has_frame = true;
    }
+   else if (using_gekkonet && net_st->gekkonet_catching_up)
+      video_driver_cached_frame();
    else if (!skip_retro_run)
       current_core->retro_run();
    else
@@ -8107,6 +8249,9 @@ void core_run(void)
 #ifdef HAVE_NETWORKING
    netplay_driver_ctl(RARCH_NETPLAY_CTL_POST_FRAME, NULL);
 #endif
+#ifdef HAVE_ALLOC_COUNTER
+   alloc_counter_core_run_end();
+#endif
 }
 
 bool core_has_set_input_descriptor(void)
@@ -171,6 +171,7 @@ struct runloop
    retro_time_t core_run_time;
    retro_time_t frame_limit_minimum_time;
    retro_time_t frame_limit_last_time;
+   retro_time_t fastforward_present_time;
    retro_usec_t frame_time_last;                /* int64_t alignment */
 
    struct retro_core_t        current_core;     /* uint64_t alignment */
@@ -301,6 +302,9 @@ struct runloop
 
    bool missing_bios;
    bool perfcnt_enable;
+   /* Turbo fast-forward: the frame being run will not be
+    * presented, drop its audio and video on arrival */
+   bool fastforward_skip;
 };
 
 typedef struct runloop runloop_state_t;
@@ -0,0 +1,376 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <array/rhmap.h>
+#include <file/file_path.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "runtime_db.h"
+
+#define RUNTIME_DB_HEADER "# RetroArch runtime log database 1\n"
+
+/* Line format, after the escaped key and a tab */
+#define RUNTIME_DB_ENTRY_FORMAT_STR "%u:%02u:%02u\t%04u-%02u-%02u %02u:%02u:%02u\t%u\t%u\n"
+
+/* Superseded lines tolerated before the journal is rewritten */
+#define RUNTIME_DB_SLACK 64
+
+struct runtime_db
+{
+   runtime_db_entry_t *index;      /* rhmap, keyed by entry key */
+   size_t lines;                   /* entry lines in the journal */
+   char path[PATH_MAX_LENGTH];
+};
+
+static size_t runtime_db_escape_key(const char *key, char *s, size_t len)
+{
+   size_t _len = 0;
+
+   for (; *key && _len + 2 < len; key++)
+   {
+      switch (*key)
+      {
+         case '\\':
+            s[_len++] = '\\';
+            s[_len++] = '\\';
+            break;
+         case '\t':
+            s[_len++] = '\\';
+            s[_len++] = 't';
+            break;
+         case '\n':
+            s[_len++] = '\\';
+            s[_len++] = 'n';
+            break;
+         case '\r':
+            s[_len++] = '\\';
+            s[_len++] = 'r';
+            break;
+         default:
+            s[_len++] = *key;
+            break;
+      }
+   }
+
+   s[_len] = '\0';
+   return _len;
+}
+
+/* Unescapes in place */
+static void runtime_db_unescape_key(char *s)
+{
+   char *out = s;
+
+   for (; *s; s++)
+   {
+      if (*s == '\\' && s[1])
+      {
+         switch (*++s)
+         {
+            case 't':
+               *out++ = '\t';
+               break;
+            case 'n':
+               *out++ = '\n';
+               break;
+            case 'r':
+               *out++ = '\r';
+               break;
+            default:
+               *out++ = *s;
+               break;
+         }
+      }
+      else
+         *out++ = *s;
+   }
+
+   *out = '\0';
+}
+
+static size_t runtime_db_format_line(const char *key,
+      const runtime_db_entry_t *entry, char *s, size_t len)
+{
+   size_t _len = runtime_db_escape_key(key, s, len);
+
+   if (_len + 1 >= len)
+      return 0;
+   s[_len++] = '\t';
+   _len     += snprintf(s + _len, len - _len, RUNTIME_DB_ENTRY_FORMAT_STR,
+         entry->runtime_hours,
+         entry->runtime_minutes,
+         entry->runtime_seconds,
+         entry->last_played_year,
+         entry->last_played_month,
+         entry->last_played_day,
+         entry->last_played_hour,
+         entry->last_played_minute,
+         entry->last_played_second,
+         entry->play_count,
+         entry->state_slot);
+
+   return (_len < len) ? _len : 0;
+}
+
+/* Reads the next number of an entry line, which must be
+ * followed by the specified separator */
+static bool runtime_db_parse_uint(char **s, char sep, unsigned *value)
+{
+   char *end;
+   unsigned long val = strtoul(*s, &end, 10);
+
+   if (end == *s || *end != sep)
+      return false;
+
+   *value = (unsigned)val;
+   *s     = end + 1;
+   return true;
+}
+
+static bool runtime_db_parse_line(runtime_db_t *db, char *line)
+{
+   runtime_db_entry_t entry;
+   char *tab = strchr(line, '\t');
+   char *s;
+
+   if (!tab || tab == line)
+      return false;
+
+   *tab = '\0';
+   s    = tab + 1;
+
+   /* Same fields as RUNTIME_DB_ENTRY_FORMAT_STR - scanned
+    * by hand, since sscanf() dominates opening large
+    * journals */
+   if (     !runtime_db_parse_uint(&s, ':',  &entry.runtime_hours)
+         || !runtime_db_parse_uint(&s, ':',  &entry.runtime_minutes)
+         || !runtime_db_parse_uint(&s, '\t', &entry.runtime_seconds)
+         || !runtime_db_parse_uint(&s, '-',  &entry.last_played_year)
+         || !runtime_db_parse_uint(&s, '-',  &entry.last_played_month)
+         || !runtime_db_parse_uint(&s, ' ',  &entry.last_played_day)
+         || !runtime_db_parse_uint(&s, ':',  &entry.last_played_hour)
+         || !runtime_db_parse_uint(&s, ':',  &entry.last_played_minute)
+         || !runtime_db_parse_uint(&s, '\t', &entry.last_played_second)
+         || !runtime_db_parse_uint(&s, '\t', &entry.play_count)
+         || !runtime_db_parse_uint(&s, '\0', &entry.state_slot))
+      return false;
+
+   runtime_db_unescape_key(line);
+   RHMAP_SET_STR(db->index, line, entry);
+   return true;
+}
+
+/* Returns false if the journal has a damaged tail */
+static bool runtime_db_read(runtime_db_t *db)
+{
+   void *buf   = NULL;
+   int64_t len = 0;
+   char *line;
+   char *end;
+
+   if (!filestream_read_file(db->path, &buf, &len) || !buf)
+      return true;
+
+   /* filestream_read_file() NUL terminates the buffer */
+   line = (char*)buf;
+   end  = line + len;
+
+   while (line < end)
+   {
+      char *eol = (char*)memchr(line, '\n', end - line);
+
+      /* A write cut short by a crash or power loss */
+      if (!eol)
+         break;
+
+      *eol = '\0';
+      if (eol > line && eol[-1] == '\r')
+         eol[-1] = '\0';
+
+      if (*line != '#' && *line != '\0')
+      {
+         if (runtime_db_parse_line(db, line))
+            db->lines++;
+      }
+
+      line = eol + 1;
+   }
+
+   free(buf);
+   return line >= end;
+}
+
+runtime_db_t *runtime_db_open(const char *path)
+{
+   runtime_db_t *db = NULL;
+
+   if (string_is_empty(path))
+      return NULL;
+
+   if (!(db = (runtime_db_t*)calloc(1, sizeof(*db))))
+      return NULL;
+
+   strlcpy(db->path, path, sizeof(db->path));
+
+   /* Rewrite the journal if it has a damaged tail, so later
+    * lines are not appended to a partial one, or if it has
+    * grown well past its live entries */
+   if (     !runtime_db_read(db)
+         || db->lines > RHMAP_LEN(db->index) * 2 + RUNTIME_DB_SLACK)
+      runtime_db_compact(db);
+
+   return db;
+}
+
+void runtime_db_free(runtime_db_t *db)
+{
+   if (!db)
+      return;
+
+   RHMAP_FREE(db->index);
+   free(db);
+}
+
+const char *runtime_db_get_path(runtime_db_t *db)
+{
+   return db ? db->path : NULL;
+}
+
+size_t runtime_db_count(runtime_db_t *db)
+{
+   return db ? RHMAP_LEN(db->index) : 0;
+}
+
+bool runtime_db_get(runtime_db_t *db, const char *key,
+      runtime_db_entry_t *entry)
+{
+   ptrdiff_t idx;
+
+   if (!db || string_is_empty(key))
+      return false;
+
+   if ((idx = RHMAP_IDX_STR(db->index, key)) < 0)
+      return false;
+
+   *entry = db->index[idx];
+   return true;
+}
+
+void runtime_db_set(runtime_db_t *db, const char *key,
+      const runtime_db_entry_t *entry)
+{
+   if (!db || string_is_empty(key))
+      return;
+
+   RHMAP_SET_STR(db->index, key, *entry);
+}
+
+bool runtime_db_put(runtime_db_t *db, const char *key,
+      const runtime_db_entry_t *entry)
+{
+   char line[PATH_MAX_LENGTH + 128];
+   size_t _len;
+   bool ret;
+   RFILE *file;
+
+   if (!db || string_is_empty(key))
+      return false;
+
+   RHMAP_SET_STR(db->index, key, *entry);
+
+   if (db->lines + 1 > RHMAP_LEN(db->index) * 2 + RUNTIME_DB_SLACK)
+      return runtime_db_compact(db);
+
+   if (!(_len = runtime_db_format_line(key, entry, line, sizeof(line))))
+      return false;
+
+   if (!path_is_valid(db->path))
+      return runtime_db_compact(db);
+
+   if (!(file = filestream_open(db->path,
+         RETRO_VFS_FILE_ACCESS_READ_WRITE
+         | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END);
+   ret = filestream_write(file, line, _len) == (int64_t)_len;
+   filestream_close(file);
+
+   if (ret)
+      db->lines++;
+   return ret;
+}
+
+bool runtime_db_compact(runtime_db_t *db)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   char line[PATH_MAX_LENGTH + 128];
+   size_t i, cap;
+   size_t _len;
+   bool ret = true;
+   RFILE *file;
+
+   if (!db)
+      return false;
+
+   _len = strlcpy(tmp_path, db->path, sizeof(tmp_path));
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+   if (!(file = filestream_open(tmp_path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   filestream_write(file, RUNTIME_DB_HEADER, STRLEN_CONST(RUNTIME_DB_HEADER));
+
+   for (i = 0, cap = RHMAP_CAP(db->index); i != cap; i++)
+   {
+      if (!RHMAP_KEY(db->index, i))
+         continue;
+      if (!(_len = runtime_db_format_line(RHMAP_KEY_STR(db->index, i),
+            &db->index[i], line, sizeof(line))))
+         continue;
+      if (filestream_write(file, line, _len) != (int64_t)_len)
+      {
+         ret = false;
+         break;
+      }
+   }
+
+   if (filestream_close(file) != 0)
+      ret = false;
+
+   if (ret && filestream_rename(tmp_path, db->path) != 0)
+   {
+      /* Renaming over an existing file fails on some platforms */
+      filestream_delete(db->path);
+      ret = filestream_rename(tmp_path, db->path) == 0;
+   }
+
+   if (!ret)
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   db->lines = RHMAP_LEN(db->index);
+   return true;
+}
@@ -0,0 +1,112 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RUNTIME_DB_H
+#define __RUNTIME_DB_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Single file store for content runtime logs.
+ *
+ * The file is a journal with one line per saved session. Opening it
+ * reads the journal once into an in-memory index, so looking up an
+ * entry never touches the disk; saving appends a line. The latest line
+ * for a key wins, and a line cut short by a crash is ignored. Once the
+ * journal holds too many superseded lines it is rewritten with one line
+ * per key.
+ *
+ * A database is not thread-safe. */
+
+typedef struct
+{
+   unsigned runtime_hours;
+   unsigned runtime_minutes;
+   unsigned runtime_seconds;
+   unsigned last_played_year;
+   unsigned last_played_month;
+   unsigned last_played_day;
+   unsigned last_played_hour;
+   unsigned last_played_minute;
+   unsigned last_played_second;
+   unsigned play_count;
+   unsigned state_slot;
+} runtime_db_entry_t;
+
+typedef struct runtime_db runtime_db_t;
+
+/**
+ * runtime_db_open:
+ * @path        : Journal file. Does not need to exist.
+ *
+ * Returns: database indexed from @path, or NULL on allocation failure.
+ **/
+runtime_db_t *runtime_db_open(const char *path);
+
+void runtime_db_free(runtime_db_t *db);
+
+const char *runtime_db_get_path(runtime_db_t *db);
+
+/**
+ * runtime_db_count:
+ *
+ * Returns: number of keys in @db.
+ **/
+size_t runtime_db_count(runtime_db_t *db);
+
+/**
+ * runtime_db_get:
+ * @key         : Entry key.
+ * @entry       : Set to the entry, if found.
+ *
+ * Returns: true if @db holds an entry for @key.
+ **/
+bool runtime_db_get(runtime_db_t *db, const char *key,
+      runtime_db_entry_t *entry);
+
+/**
+ * runtime_db_put:
+ *
+ * Stores @entry for @key and appends it to the journal.
+ *
+ * Returns: true if the journal was written.
+ **/
+bool runtime_db_put(runtime_db_t *db, const char *key,
+      const runtime_db_entry_t *entry);
+
+/**
+ * runtime_db_set:
+ *
+ * Stores @entry for @key in memory only, e.g. while importing many
+ * entries that are written out together by runtime_db_compact().
+ **/
+void runtime_db_set(runtime_db_t *db, const char *key,
+      const runtime_db_entry_t *entry);
+
+/**
+ * runtime_db_compact:
+ *
+ * Rewrites the journal with one line per key.
+ *
+ * Returns: true on success.
+ **/
+bool runtime_db_compact(runtime_db_t *db);
+
+RETRO_END_DECLS
+
+#endif
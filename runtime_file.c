@@ -30,6 +30,7 @@
 #include <streams/file_stream.h>
 #include <formats/rjson.h>
 #include <string/stdstring.h>
+#include <lists/dir_list.h>
 #include <encodings/utf.h>
 #include <time/rtime.h>
 
@@ -43,6 +44,7 @@
 #include "menu/menu_driver.h"
 #endif
 
+#include "runtime_db.h"
 #include "runtime_file.h"
 
 #define LOG_FILE_RUNTIME_FORMAT_STR "%u:%02u:%02u"
@@ -101,11 +103,13 @@ static bool RtlJSONStringHandler(void *ctx, const char *s, size_t len)
    return true;
 }
 
-/* Initialisation */
+/* Legacy log files */
 
-/* Parses log file referenced by runtime_log->path.
- * Does nothing if log file does not exist. */
-static void runtime_log_read_file(runtime_log_t *runtime_log)
+/* Parses the per-file log at the specified path,
+ * as written before the runtime database existed.
+ * Returns false if the file cannot be read. */
+static bool runtime_log_read_file(const char *path,
+      runtime_log_t *runtime_log)
 {
    rjson_t* parser;
    unsigned runtime_hours      = 0;
@@ -123,15 +127,16 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
 
    unsigned state_slot         = 0;
 
+   bool ret                    = false;
    RtlJSONContext context      = {0};
    /* Attempt to open log file */
-   RFILE *file                 = filestream_open(runtime_log->path,
+   RFILE *file                 = filestream_open(path,
          RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
    if (!file)
    {
-      RARCH_ERR("[Runtime] Failed to open runtime log file: \"%s\".\n", runtime_log->path);
-      return;
+      RARCH_ERR("[Runtime] Failed to open runtime log file: \"%s\".\n", path);
+      return false;
    }
 
    /* Initialise JSON parser */
@@ -156,11 +161,11 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
       if (rjson_get_source_context_len(parser))
       {
          RARCH_ERR("[Runtime] Error parsing chunk of runtime log file: %s\n---snip---\n%.*s\n---snip---\n",
-               runtime_log->path,
+               path,
                rjson_get_source_context_len(parser),
                rjson_get_source_context_buf(parser));
       }
-      RARCH_ERR("[Runtime] Error parsing runtime log file: \"%s\".\n", runtime_log->path);
+      RARCH_ERR("[Runtime] Error parsing runtime log file: \"%s\".\n", path);
       RARCH_ERR("[Runtime] Error: Invalid JSON at line %d, column %d - %s.\n",
             (int)rjson_get_source_line(parser),
             (int)rjson_get_source_column(parser),
@@ -181,7 +186,7 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
                &runtime_minutes,
                &runtime_seconds) != 3)
       {
-         RARCH_ERR("[Runtime] Invalid \"runtime\" entry detected: \"%s\".\n", runtime_log->path);
+         RARCH_ERR("[Runtime] Invalid \"runtime\" entry detected: \"%s\".\n", path);
          goto end;
       }
    }
@@ -198,7 +203,7 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
                &last_played_minute,
                &last_played_second) != 6)
       {
-         RARCH_ERR("[Runtime] Invalid \"last played\" entry detected: \"%s\".\n", runtime_log->path);
+         RARCH_ERR("[Runtime] Invalid \"last played\" entry detected: \"%s\".\n", path);
          goto end;
       }
    }
@@ -210,7 +215,7 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
                "%u",
                &play_count) != 1)
       {
-         RARCH_ERR("[Runtime] Invalid \"play count\" entry detected: \"%s\".\n", runtime_log->path);
+         RARCH_ERR("[Runtime] Invalid \"play count\" entry detected: \"%s\".\n", path);
          goto end;
       }
    }
@@ -222,18 +227,11 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
                "%04u",
                &state_slot) != 1)
       {
-         RARCH_ERR("[Runtime] Invalid \"state slot\" entry detected: \"%s\".\n", runtime_log->path);
+         RARCH_ERR("[Runtime] Invalid \"state slot\" entry detected: \"%s\".\n", path);
          goto end;
       }
    }
 
-   if (     state_slot > 0
-         && state_slot < 1000)
-   {
-      runloop_state_t *runloop_st  = runloop_state_get_ptr();
-      runloop_st->entry_state_slot = state_slot;
-   }
-
    /* If we reach this point then all is well
     * > Assign values to runtime_log object */
    runtime_log->runtime.hours      = runtime_hours;
@@ -251,6 +249,8 @@ static void runtime_log_read_file(runtime_log_t *runtime_log)
 
    runtime_log->state_slot         = state_slot;
 
+   ret                             = true;
+
 end:
    /* Clean up leftover strings */
    if (context.runtime_string)
@@ -264,31 +264,226 @@ end:
 
    /* Close log file */
    filestream_close(file);
+
+   return ret;
 }
 
-/* Initialise runtime log, loading current parameters
- * if log file exists. Returned object must be free()'d.
- * Returns NULL if core_path is invalid, or content_path
- * is invalid and core does not support contentless
- * operation */
-runtime_log_t *runtime_log_init(
+/* Runtime database */
+
+/* Database of the runtime log directory last used */
+static runtime_db_t *runtime_db                = NULL;
+static char runtime_db_dir[DIR_MAX_LENGTH]     = {0};
+
+static void runtime_log_entry_to_db(const runtime_log_t *runtime_log,
+      runtime_db_entry_t *entry)
+{
+   entry->runtime_hours      = runtime_log->runtime.hours;
+   entry->runtime_minutes    = runtime_log->runtime.minutes;
+   entry->runtime_seconds    = runtime_log->runtime.seconds;
+   entry->last_played_year   = runtime_log->last_played.year;
+   entry->last_played_month  = runtime_log->last_played.month;
+   entry->last_played_day    = runtime_log->last_played.day;
+   entry->last_played_hour   = runtime_log->last_played.hour;
+   entry->last_played_minute = runtime_log->last_played.minute;
+   entry->last_played_second = runtime_log->last_played.second;
+   entry->play_count         = runtime_log->play_count;
+   entry->state_slot         = runtime_log->state_slot;
+}
+
+static void runtime_log_entry_from_db(runtime_log_t *runtime_log,
+      const runtime_db_entry_t *entry)
+{
+   runtime_log->runtime.hours      = entry->runtime_hours;
+   runtime_log->runtime.minutes    = entry->runtime_minutes;
+   runtime_log->runtime.seconds    = entry->runtime_seconds;
+   runtime_log->last_played.year   = entry->last_played_year;
+   runtime_log->last_played.month  = entry->last_played_month;
+   runtime_log->last_played.day    = entry->last_played_day;
+   runtime_log->last_played.hour   = entry->last_played_hour;
+   runtime_log->last_played.minute = entry->last_played_minute;
+   runtime_log->last_played.second = entry->last_played_second;
+   runtime_log->play_count         = entry->play_count;
+   runtime_log->state_slot         = entry->state_slot;
+}
+
+/* Imports the log files of one directory, prefixing
+ * their keys with the specified core name, if any.
+ * Returns number of imported logs */
+static size_t runtime_log_import_dir(runtime_db_t *db,
+      const char *dir, const char *core_name)
+{
+   size_t i;
+   size_t count              = 0;
+   struct string_list *files = dir_list_new(dir,
+         FILE_PATH_RUNTIME_EXTENSION + 1, false, false, false, false);
+
+   if (!files)
+      return 0;
+
+   for (i = 0; i < files->size; i++)
+   {
+      char key[PATH_MAX_LENGTH];
+      runtime_db_entry_t entry;
+      runtime_log_t runtime_log = {0};
+      const char *file_path     = files->elems[i].data;
+
+      if (!runtime_log_read_file(file_path, &runtime_log))
+         continue;
+
+      if (core_name)
+      {
+         size_t _len = strlcpy(key, core_name, sizeof(key));
+         key[  _len] = '/';
+         key[++_len] = '\0';
+         strlcpy(key + _len, path_basename(file_path), sizeof(key) - _len);
+      }
+      else
+         strlcpy(key, path_basename(file_path), sizeof(key));
+
+      runtime_log_entry_to_db(&runtime_log, &entry);
+      runtime_db_set(db, key, &entry);
+      count++;
+   }
+
+   string_list_free(files);
+   return count;
+}
+
+/* Imports all per-file logs (aggregate logs in the
+ * runtime log directory, per core logs in one sub
+ * directory per core) into a new database. Log
+ * files are left in place. */
+static void runtime_log_import(runtime_db_t *db, const char *dir)
+{
+   size_t i;
+   size_t count             = 0;
+   struct string_list *dirs = dir_list_new(dir,
+         FILE_PATH_RUNTIME_EXTENSION + 1, true, false, false, false);
+
+   if (!dirs)
+      return;
+
+   for (i = 0; i < dirs->size; i++)
+   {
+      if (dirs->elems[i].attr.i == RARCH_DIRECTORY)
+         count += runtime_log_import_dir(db, dirs->elems[i].data,
+               path_basename_nocompression(dirs->elems[i].data));
+   }
+
+   count += runtime_log_import_dir(db, dir, NULL);
+
+   string_list_free(dirs);
+
+   if (count)
+   {
+      RARCH_LOG("[Runtime] Imported %u runtime log files into \"%s\".\n",
+            (unsigned)count, runtime_db_get_path(db));
+      if (!runtime_db_compact(db))
+         RARCH_ERR("[Runtime] Failed to write runtime database: \"%s\".\n",
+               runtime_db_get_path(db));
+   }
+}
+
+/* Returns database of the specified runtime log
+ * directory, opening it if required */
+static runtime_db_t *runtime_log_get_db(const char *dir)
+{
+   char db_path[PATH_MAX_LENGTH];
+   bool exists;
+
+   if (runtime_db && string_is_equal(runtime_db_dir, dir))
+      return runtime_db;
+
+   runtime_log_deinit();
+
+   fill_pathname_join_special(db_path, dir,
+         FILE_PATH_RUNTIME_DATABASE, sizeof(db_path));
+
+   exists = path_is_valid(db_path);
+
+   if (!(runtime_db = runtime_db_open(db_path)))
+      return NULL;
+
+   strlcpy(runtime_db_dir, dir, sizeof(runtime_db_dir));
+
+   /* First use: pick up existing log files */
+   if (!exists)
+      runtime_log_import(runtime_db, dir);
+
+   return runtime_db;
+}
+
+/* Closes the runtime database */
+void runtime_log_deinit(void)
+{
+   runtime_db_free(runtime_db);
+   runtime_db        = NULL;
+   runtime_db_dir[0] = '\0';
+}
+
+/* Initialisation */
+
+typedef struct
+{
+   char core_path[PATH_MAX_LENGTH];
+   char core_name[NAME_MAX_LENGTH];
+   bool supports_no_game;
+} runtime_log_core_t;
+
+/* Gets core info required to generate runtime log keys,
+ * reusing the previous lookup for the same core.
+ * Returns false if the core is unknown */
+static bool runtime_log_find_core(const char *core_path,
+      runtime_log_core_t *core)
+{
+   core_info_t *core_info = NULL;
+
+   if (string_is_equal(core->core_path, core_path))
+      return !string_is_empty(core->core_name);
+
+   strlcpy(core->core_path, core_path, sizeof(core->core_path));
+   core->core_name[0]     = '\0';
+   core->supports_no_game = false;
+
+   /* Get core info:
+    * - Need to know if core supports contentless operation
+    * - Need core name in order to generate key when
+    *   per-core logging is enabled
+    * Note: An annoyance - core name is required even when
+    * we are performing aggregate logging, since content
+    * name is sometimes dependent upon core
+    * (e.g. see TyrQuake below) */
+   if (core_info_find(core_path, &core_info))
+   {
+      core->supports_no_game = core_info->supports_no_game;
+      if (!string_is_empty(core_info->core_name))
+         strlcpy(core->core_name, core_info->core_name,
+               sizeof(core->core_name));
+   }
+
+   return !string_is_empty(core->core_name);
+}
+
+/* Creates runtime log object and loads current parameters
+ * from the runtime database, if an entry exists */
+static runtime_log_t *runtime_log_new(
       const char *content_path,
       const char *core_path,
       const char *dir_runtime_log,
       const char *dir_playlist,
-      bool log_per_core)
+      bool log_per_core,
+      runtime_log_core_t *core)
 {
-   char log_file_dir[DIR_MAX_LENGTH];
+   runtime_db_entry_t entry;
    char content_name[NAME_MAX_LENGTH];
-   char core_name[NAME_MAX_LENGTH];
-   char log_file_path[PATH_MAX_LENGTH];
+   char log_dir[DIR_MAX_LENGTH];
+   char key[PATH_MAX_LENGTH];
    char tmp_buf[PATH_MAX_LENGTH];
-   bool supports_no_game      = false;
-   core_info_t *core_info     = NULL;
+   size_t _len                = 0;
+   runtime_db_t *db           = NULL;
    runtime_log_t *runtime_log = NULL;
 
    content_name[0]            = '\0';
-   core_name[0]               = '\0';
 
    if (     string_is_empty(dir_runtime_log)
          && string_is_empty(dir_playlist))
@@ -303,22 +498,7 @@ runtime_log_t *runtime_log_init(
          || string_is_equal(core_path, "DETECT"))
       return NULL;
 
-   /* Get core info:
-    * - Need to know if core supports contentless operation
-    * - Need core name in order to generate file path when
-    *   per-core logging is enabled
-    * Note: An annoyance - core name is required even when
-    * we are performing aggregate logging, since content
-    * name is sometimes dependent upon core
-    * (e.g. see TyrQuake below) */
-   if (core_info_find(core_path, &core_info))
-   {
-      supports_no_game = core_info->supports_no_game;
-      if (!string_is_empty(core_info->core_name))
-         strlcpy(core_name, core_info->core_name, sizeof(core_name));
-   }
-
-   if (string_is_empty(core_name))
+   if (!runtime_log_find_core(core_path, core))
       return NULL;
 
    /* Get runtime log directory
@@ -326,64 +506,41 @@ runtime_log_t *runtime_log_init(
     * use default 'playlists/logs' directory... */
    if (string_is_empty(dir_runtime_log))
       fill_pathname_join_special(
-            tmp_buf,
+            log_dir,
             dir_playlist,
             "logs",
-            sizeof(tmp_buf));
-   else
-      strlcpy(tmp_buf, dir_runtime_log, sizeof(tmp_buf));
-
-   if (string_is_empty(tmp_buf))
-      return NULL;
-
-   if (log_per_core)
-      fill_pathname_join_special(
-            log_file_dir,
-            tmp_buf,
-            core_name,
-            sizeof(log_file_dir));
+            sizeof(log_dir));
    else
-      strlcpy(log_file_dir, tmp_buf, sizeof(log_file_dir));
+      strlcpy(log_dir, dir_runtime_log, sizeof(log_dir));
 
-   if (string_is_empty(log_file_dir))
+   if (string_is_empty(log_dir))
       return NULL;
 
-   /* Create directory, if required */
-   if (!path_is_directory(log_file_dir))
-   {
-      if (!path_mkdir(log_file_dir))
-      {
-         RARCH_ERR("[Runtime] Failed to create directory for"
-               " runtime log: \"%s\".\n", log_file_dir);
-         return NULL;
-      }
-   }
-
    /* Get content name */
    if (string_is_empty(content_path))
    {
       /* If core supports contentless operation and
        * no content is provided, 'content' is simply
        * the name of the core itself */
-      if (supports_no_game)
+      if (core->supports_no_game)
          fill_pathname(content_name,
-               core_name,
+               core->core_name,
                FILE_PATH_RUNTIME_EXTENSION,
                sizeof(content_name));
    }
    /* NOTE: TyrQuake requires a specific hack, since all
     * content has the same name... */
-   else if (string_is_equal(core_name, "TyrQuake"))
+   else if (string_is_equal(core->core_name, "TyrQuake"))
    {
       char *last_slash = find_last_slash(content_path);
       if (last_slash)
       {
-         size_t _len = last_slash + 1 - content_path;
-         if (_len < PATH_MAX_LENGTH)
+         size_t __len = last_slash + 1 - content_path;
+         if (__len < PATH_MAX_LENGTH)
          {
             memset(tmp_buf, 0, sizeof(tmp_buf));
             strlcpy(tmp_buf,
-                  content_path, _len * sizeof(char));
+                  content_path, __len * sizeof(char));
             fill_pathname(content_name,
                   path_basename(tmp_buf),
                   FILE_PATH_RUNTIME_EXTENSION,
@@ -400,41 +557,60 @@ runtime_log_t *runtime_log_init(
    if (string_is_empty(content_name))
       return NULL;
 
-   /* Build final log file path */
-   fill_pathname_join_special(log_file_path, log_file_dir,
-         content_name, sizeof(log_file_path));
-
-   if (string_is_empty(log_file_path))
-      return NULL;
+   /* Build key - this is the path of the log file
+    * relative to the runtime log directory, as it
+    * was before the runtime database existed */
+   if (log_per_core)
+   {
+      _len        = strlcpy(key, core->core_name, sizeof(key));
+      key[  _len] = '/';
+      key[++_len] = '\0';
+   }
+   strlcpy(key + _len, content_name, sizeof(key) - _len);
 
    /* Phew... If we get this far then all is well.
     * > Create 'runtime_log' object */
-   if (!(runtime_log = (runtime_log_t*)malloc(sizeof(*runtime_log))))
+   if (!(runtime_log = (runtime_log_t*)calloc(1, sizeof(*runtime_log))))
       return NULL;
 
-   /* > Populate default values */
-   runtime_log->runtime.hours      = 0;
-   runtime_log->runtime.minutes    = 0;
-   runtime_log->runtime.seconds    = 0;
+   strlcpy(runtime_log->dir, log_dir, sizeof(runtime_log->dir));
+   strlcpy(runtime_log->key, key, sizeof(runtime_log->key));
 
-   runtime_log->last_played.year   = 0;
-   runtime_log->last_played.month  = 0;
-   runtime_log->last_played.day    = 0;
-   runtime_log->last_played.hour   = 0;
-   runtime_log->last_played.minute = 0;
-   runtime_log->last_played.second = 0;
+   /* Load existing entry, if it exists */
+   if (     (db = runtime_log_get_db(log_dir))
+         && runtime_db_get(db, key, &entry))
+      runtime_log_entry_from_db(runtime_log, &entry);
 
-   runtime_log->play_count         = 0;
+   return runtime_log;
+}
 
-   runtime_log->state_slot         = 0;
+/* Initialise runtime log, loading current parameters
+ * if an entry exists. Returned object must be free()'d.
+ * Returns NULL if core_path is invalid, or content_path
+ * is invalid and core does not support contentless
+ * operation */
+runtime_log_t *runtime_log_init(
+      const char *content_path,
+      const char *core_path,
+      const char *dir_runtime_log,
+      const char *dir_playlist,
+      bool log_per_core)
+{
+   runtime_log_core_t core;
+   runtime_log_t *runtime_log = NULL;
 
-   runtime_log->path[0]            = '\0';
+   core.core_path[0]          = '\0';
 
-   strlcpy(runtime_log->path, log_file_path, sizeof(runtime_log->path));
+   if (!(runtime_log = runtime_log_new(content_path, core_path,
+         dir_runtime_log, dir_playlist, log_per_core, &core)))
+      return NULL;
 
-   /* Load existing log file, if it exists */
-   if (path_is_valid(runtime_log->path))
-      runtime_log_read_file(runtime_log);
+   if (     runtime_log->state_slot > 0
+         && runtime_log->state_slot < 1000)
+   {
+      runloop_state_t *runloop_st  = runloop_state_get_ptr();
+      runloop_st->entry_state_slot = runtime_log->state_slot;
+   }
 
    return runtime_log;
 }
@@ -1105,119 +1281,36 @@ bool runtime_log_has_runtime(runtime_log_t *runtime_log)
 
 /* Saving */
 
-/* Saves specified runtime log to disk */
+/* Saves specified runtime log to the runtime database */
 void runtime_log_save(runtime_log_t *runtime_log)
 {
-   char value_string[64]; /* 64 characters should be
-                             enough for a very long runtime... :) */
-   RFILE *file            = NULL;
-   rjsonwriter_t* writer;
+   runtime_db_entry_t entry;
+   runtime_db_t *db = NULL;
 
    if (!runtime_log)
       return;
 
-   RARCH_LOG("[Runtime] Saving runtime log file: \"%s\".\n", runtime_log->path);
+   RARCH_LOG("[Runtime] Saving runtime log: \"%s\".\n", runtime_log->key);
 
-   /* Attempt to open log file */
-   if (!(file = filestream_open(runtime_log->path,
-         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
-   {
-      RARCH_ERR("[Runtime] Failed to open runtime log file: \"%s\".\n", runtime_log->path);
-      return;
-   }
-
-   /* Initialise JSON writer */
-   if (!(writer = rjsonwriter_open_rfile(file)))
+   /* Create directory, if required */
+   if (!path_is_directory(runtime_log->dir))
    {
-      RARCH_ERR("[Runtime] Failed to create JSON writer.\n");
-      goto end;
+      if (!path_mkdir(runtime_log->dir))
+      {
+         RARCH_ERR("[Runtime] Failed to create directory for"
+               " runtime log: \"%s\".\n", runtime_log->dir);
+         return;
+      }
    }
 
-   /* Write output file */
-   rjsonwriter_raw(writer, "{", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Version entry */
-   rjsonwriter_add_spaces(writer, 2);
-   rjsonwriter_add_string(writer, "version");
-   rjsonwriter_raw(writer, ":", 1);
-   rjsonwriter_raw(writer, " ", 1);
-   rjsonwriter_add_string(writer, "1.0");
-   rjsonwriter_raw(writer, ",", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Runtime entry */
-   snprintf(value_string,
-         sizeof(value_string),
-         LOG_FILE_RUNTIME_FORMAT_STR,
-         runtime_log->runtime.hours, runtime_log->runtime.minutes,
-         runtime_log->runtime.seconds);
+   if (!(db = runtime_log_get_db(runtime_log->dir)))
+      return;
 
-   rjsonwriter_add_spaces(writer, 2);
-   rjsonwriter_add_string(writer, "runtime");
-   rjsonwriter_raw(writer, ":", 1);
-   rjsonwriter_raw(writer, " ", 1);
-   rjsonwriter_add_string(writer, value_string);
-   rjsonwriter_raw(writer, ",", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Last played entry */
-   value_string[0] = '\0';
-   snprintf(value_string, sizeof(value_string),
-         LOG_FILE_LAST_PLAYED_FORMAT_STR,
-         runtime_log->last_played.year, runtime_log->last_played.month,
-         runtime_log->last_played.day,
-         runtime_log->last_played.hour, runtime_log->last_played.minute,
-         runtime_log->last_played.second);
-
-   rjsonwriter_add_spaces(writer, 2);
-   rjsonwriter_add_string(writer, "last_played");
-   rjsonwriter_raw(writer, ":", 1);
-   rjsonwriter_raw(writer, " ", 1);
-   rjsonwriter_add_string(writer, value_string);
-   rjsonwriter_raw(writer, ",", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Play count */
-   value_string[0] = '\0';
-   snprintf(value_string, sizeof(value_string),
-         "%u",
-         runtime_log->play_count);
-
-   rjsonwriter_add_spaces(writer, 2);
-   rjsonwriter_add_string(writer, "play_count");
-   rjsonwriter_raw(writer, ":", 1);
-   rjsonwriter_raw(writer, " ", 1);
-   rjsonwriter_add_string(writer, value_string);
-   rjsonwriter_raw(writer, ",", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Current state slot */
-   value_string[0] = '\0';
-   snprintf(value_string, sizeof(value_string),
-         "%u",
-         runtime_log->state_slot);
-
-   rjsonwriter_add_spaces(writer, 2);
-   rjsonwriter_add_string(writer, "state_slot");
-   rjsonwriter_raw(writer, ":", 1);
-   rjsonwriter_raw(writer, " ", 1);
-   rjsonwriter_add_string(writer, value_string);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* > Finalise */
-   rjsonwriter_raw(writer, "}", 1);
-   rjsonwriter_raw(writer, "\n", 1);
-
-   /* Free JSON writer */
-   if (!rjsonwriter_free(writer))
-   {
-      RARCH_ERR("[Runtime] Error writing runtime log file: \"%s\".\n", runtime_log->path);
-   }
+   runtime_log_entry_to_db(runtime_log, &entry);
 
-end:
-   /* Close log file */
-   filestream_close(file);
+   if (!runtime_db_put(db, runtime_log->key, &entry))
+      RARCH_ERR("[Runtime] Failed to write runtime database: \"%s\".\n",
+            runtime_db_get_path(db));
 }
 
 /* Utility functions */
@@ -1236,29 +1329,35 @@ void runtime_log_convert_usec2hms(retro_time_t usec,
 
 /* Playlist manipulation */
 
-/* Updates specified playlist entry runtime values with
- * contents of associated log file */
-void runtime_update_playlist(
+/* Ozone and GLUI require runtime/last played strings
+ * to be populated even when no runtime is recorded */
+static bool runtime_update_always_set_str(void)
+{
+#if defined(HAVE_MENU) && (defined(HAVE_OZONE) || defined(HAVE_MATERIALUI))
+   const char *menu_ident = menu_driver_ident();
+   return string_is_equal(menu_ident, "ozone")
+       || string_is_equal(menu_ident, "glui");
+#else
+   return false;
+#endif
+}
+
+static void runtime_update_playlist_entry(
       playlist_t *playlist, size_t idx,
+      const struct playlist_entry *entry,
       const char *dir_runtime_log,
       const char *dir_playlist,
       bool log_per_core,
       enum playlist_sublabel_last_played_style_type timedate_style,
-      enum playlist_sublabel_last_played_date_separator_type date_separator)
+      enum playlist_sublabel_last_played_date_separator_type date_separator,
+      runtime_log_core_t *core,
+      bool always_set_str)
 {
    char runtime_str[64];
    char last_played_str[64];
    runtime_log_t *runtime_log             = NULL;
-   const struct playlist_entry *entry     = NULL;
    struct playlist_entry update_entry     = {0};
 
-   /* Sanity check */
-   if (!playlist)
-      return;
-
-   if (idx >= playlist_get_size(playlist))
-      return;
-
    /* Set fallback playlist 'runtime_status'
     * (saves 'if' checks later...) */
    update_entry.runtime_status = PLAYLIST_RUNTIME_MISSING;
@@ -1269,16 +1368,14 @@ void runtime_update_playlist(
    update_entry.runtime_str     = runtime_str;
    update_entry.last_played_str = last_played_str;
 
-   /* Read current playlist entry */
-   playlist_get_index(playlist, idx, &entry);
-
-   /* Attempt to open log file */
-   if ((runtime_log = runtime_log_init(
+   /* Attempt to look up runtime log */
+   if ((runtime_log = runtime_log_new(
          entry->path,
          entry->core_path,
          dir_runtime_log,
          dir_playlist,
-         log_per_core)))
+         log_per_core,
+         core)))
    {
       /* Check whether a non-zero runtime has been recorded */
       if (runtime_log_has_runtime(runtime_log))
@@ -1313,37 +1410,93 @@ void runtime_update_playlist(
       free(runtime_log);
    }
 
-#if defined(HAVE_MENU) && (defined(HAVE_OZONE) || defined(HAVE_MATERIALUI))
-   /* Ozone and GLUI require runtime/last played strings
-    * to be populated even when no runtime is recorded */
-   if (update_entry.runtime_status != PLAYLIST_RUNTIME_VALID)
+   if (     always_set_str
+         && update_entry.runtime_status != PLAYLIST_RUNTIME_VALID)
    {
-      const char *menu_ident = menu_driver_ident();
-      if (   string_is_equal(menu_ident, "ozone")
-          || string_is_equal(menu_ident, "glui"))
-      {
-         runtime_log_get_runtime_str(NULL,
-               runtime_str, sizeof(runtime_str));
-         runtime_log_get_last_played_str(NULL,
-               last_played_str, sizeof(last_played_str),
-               timedate_style, date_separator);
-
-         /* While runtime data does not exist, the playlist
-          * entry does now contain valid information... */
-         update_entry.runtime_status = PLAYLIST_RUNTIME_VALID;
-      }
+      runtime_log_get_runtime_str(NULL,
+            runtime_str, sizeof(runtime_str));
+      runtime_log_get_last_played_str(NULL,
+            last_played_str, sizeof(last_played_str),
+            timedate_style, date_separator);
+
+      /* While runtime data does not exist, the playlist
+       * entry does now contain valid information... */
+      update_entry.runtime_status = PLAYLIST_RUNTIME_VALID;
    }
-#endif
 
    /* Update playlist */
    playlist_update_runtime(playlist, idx, &update_entry, false);
 }
 
+/* Updates specified playlist entry runtime values with
+ * contents of associated runtime log */
+void runtime_update_playlist(
+      playlist_t *playlist, size_t idx,
+      const char *dir_runtime_log,
+      const char *dir_playlist,
+      bool log_per_core,
+      enum playlist_sublabel_last_played_style_type timedate_style,
+      enum playlist_sublabel_last_played_date_separator_type date_separator)
+{
+   runtime_log_core_t core;
+   const struct playlist_entry *entry = NULL;
+
+   /* Sanity check */
+   if (!playlist)
+      return;
+
+   if (idx >= playlist_get_size(playlist))
+      return;
+
+   core.core_path[0] = '\0';
+
+   /* Read current playlist entry */
+   playlist_get_index(playlist, idx, &entry);
+
+   runtime_update_playlist_entry(playlist, idx, entry,
+         dir_runtime_log, dir_playlist, log_per_core,
+         timedate_style, date_separator,
+         &core, runtime_update_always_set_str());
+}
+
+/* Updates runtime values of all playlist entries that
+ * have not been read yet in a single pass */
+void runtime_update_playlist_all(
+      playlist_t *playlist,
+      const char *dir_runtime_log,
+      const char *dir_playlist,
+      bool log_per_core,
+      enum playlist_sublabel_last_played_style_type timedate_style,
+      enum playlist_sublabel_last_played_date_separator_type date_separator)
+{
+   size_t i, size;
+   runtime_log_core_t core;
+   bool always_set_str = runtime_update_always_set_str();
+
+   if (!playlist)
+      return;
+
+   core.core_path[0]   = '\0';
+
+   for (i = 0, size = playlist_get_size(playlist); i < size; i++)
+   {
+      const struct playlist_entry *entry = NULL;
+
+      playlist_get_index(playlist, i, &entry);
+
+      if (entry->runtime_status == PLAYLIST_RUNTIME_UNKNOWN)
+         runtime_update_playlist_entry(playlist, i, entry,
+               dir_runtime_log, dir_playlist, log_per_core,
+               timedate_style, date_separator,
+               &core, always_set_str);
+   }
+}
+
 #if defined(HAVE_MENU)
 /* Contentless cores manipulation */
 
 /* Updates specified contentless core runtime values with
- * contents of associated log file */
+ * contents of associated runtime log */
 void runtime_update_contentless_core(
       const char *core_path,
       const char *dir_runtime_log,
@@ -1374,7 +1527,7 @@ void runtime_update_contentless_core(
    runtime_info.runtime_str     = runtime_str;
    runtime_info.last_played_str = last_played_str;
 
-   /* Attempt to open log file */
+   /* Attempt to look up runtime log */
    runtime_log = runtime_log_init(
          NULL,
          core_path,
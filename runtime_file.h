@@ -59,13 +59,17 @@ typedef struct
    rtl_last_played_t last_played;   /* unsigned alignment */
    unsigned play_count;
    unsigned state_slot;
-   char path[PATH_MAX_LENGTH];
+   /* Runtime log directory, holding the runtime database */
+   char dir[DIR_MAX_LENGTH];
+   /* Database key: log file name, prefixed with the
+    * core name when logging per core */
+   char key[PATH_MAX_LENGTH];
 } runtime_log_t;
 
 /* Initialisation */
 
 /* Initialise runtime log, loading current parameters
- * if log file exists. Returned object must be free()'d.
+ * if an entry exists. Returned object must be free()'d.
  * Returns NULL if core_path is invalid, or content_path
  * is invalid and core does not support contentless
  * operation */
@@ -118,9 +122,12 @@ bool runtime_log_has_runtime(runtime_log_t *runtime_log);
 
 /* Saving */
 
-/* Saves specified runtime log to disk */
+/* Saves specified runtime log to the runtime database */
 void runtime_log_save(runtime_log_t *runtime_log);
 
+/* Closes the runtime database */
+void runtime_log_deinit(void);
+
 /* Utility functions */
 
 /* Convert from microseconds to hours, minutes, seconds */
@@ -129,7 +136,7 @@ void runtime_log_convert_usec2hms(retro_time_t usec, unsigned *hours, unsigned *
 /* Playlist manipulation */
 
 /* Updates specified playlist entry runtime values with
- * contents of associated log file */
+ * contents of associated runtime log */
 void runtime_update_playlist(
       playlist_t *playlist, size_t idx,
       const char *dir_runtime_log,
@@ -138,11 +145,21 @@ void runtime_update_playlist(
       enum playlist_sublabel_last_played_style_type timedate_style,
       enum playlist_sublabel_last_played_date_separator_type date_separator);
 
+/* Updates runtime values of all playlist entries that
+ * have not been read yet in a single pass */
+void runtime_update_playlist_all(
+      playlist_t *playlist,
+      const char *dir_runtime_log,
+      const char *dir_playlist,
+      bool log_per_core,
+      enum playlist_sublabel_last_played_style_type timedate_style,
+      enum playlist_sublabel_last_played_date_separator_type date_separator);
+
 #if defined(HAVE_MENU)
 /* Contentless cores manipulation */
 
 /* Updates specified contentless core runtime values with
- * contents of associated log file */
+ * contents of associated runtime log */
 void runtime_update_contentless_core(
       const char *core_path,
       const char *dir_runtime_log,
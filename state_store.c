@@ -0,0 +1,913 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <lrc_hash.h>
+#include <retro_dirent.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "state_store.h"
+#include "state_writer.h"
+
+/* Chunk sizes. Boundaries are harder to hit before the average size
+ * and easier after it, which keeps most chunks close to it */
+#define STATE_STORE_MIN_CHUNK    2048
+#define STATE_STORE_AVG_CHUNK    8192
+#define STATE_STORE_MAX_CHUNK    65536
+#define STATE_STORE_MASK_HARD    (UINT64_C(0x7fff) << 49)
+#define STATE_STORE_MASK_EASY    (UINT64_C(0x07ff) << 53)
+
+#define STATE_STORE_ZSTD_LEVEL   3
+
+#define STATE_STORE_DIGEST_SIZE  32
+
+/* Manifest: magic, state size (u64), chunk count (u32), reserved
+ * (u32), then for each chunk its SHA-256 and size (u32) */
+#define STATE_STORE_MANIFEST_MAGIC  "RASTMAN1"
+#define STATE_STORE_MANIFEST_HEADER 24
+#define STATE_STORE_MANIFEST_ENTRY  (STATE_STORE_DIGEST_SIZE + 4)
+
+/* Chunk file: magic, method (u8), 3 reserved bytes, size (u32),
+ * CRC-32 of the chunk (u32), then the chunk, compressed or not */
+#define STATE_STORE_CHUNK_MAGIC     "RACK"
+#define STATE_STORE_CHUNK_HEADER    16
+
+#define STATE_STORE_CHUNK_EXT       ".chunks"
+
+enum state_store_method
+{
+   STATE_STORE_METHOD_RAW = 0,
+   STATE_STORE_METHOD_ZSTD
+};
+
+/* Chunks used by a write or read in progress. Collection keeps them
+ * even though no manifest may refer to them yet */
+struct state_store_pin
+{
+   struct state_store_pin *next;
+   /* Sorted */
+   uint8_t *digests;
+   size_t count;
+};
+
+/* What a single write needs for itself, so that chunking, hashing,
+ * compression and I/O run without the lock */
+typedef struct state_store_job
+{
+#ifdef HAVE_ZSTD
+   ZSTD_CCtx *cctx;
+#endif
+   uint8_t *buf;
+   size_t buf_size;
+   state_store_stats_t stats;
+   unsigned seq;
+} state_store_job_t;
+
+static struct
+{
+#ifdef HAVE_THREADS
+   /* Guards the pins, the cached contexts, the counters and the stats.
+    * Held for those updates only */
+   slock_t *lock;
+   /* Serializes collections */
+   slock_t *collect_lock;
+#endif
+#ifdef HAVE_ZSTD
+   ZSTD_CCtx *cctx;
+   ZSTD_DCtx *dctx;
+#endif
+   struct state_store_pin *pins;
+   uint64_t gear[256];
+   state_store_stats_t stats;
+   /* Bumped when a write publishes its manifest */
+   unsigned epoch;
+   /* Names the temporary files of each write */
+   unsigned seq;
+   bool inited;
+} state_store_st;
+
+#ifdef HAVE_THREADS
+#define STATE_STORE_LOCK()           slock_lock(state_store_st.lock)
+#define STATE_STORE_UNLOCK()         slock_unlock(state_store_st.lock)
+#define STATE_STORE_COLLECT_LOCK()   slock_lock(state_store_st.collect_lock)
+#define STATE_STORE_COLLECT_UNLOCK() slock_unlock(state_store_st.collect_lock)
+#else
+#define STATE_STORE_LOCK()
+#define STATE_STORE_UNLOCK()
+#define STATE_STORE_COLLECT_LOCK()
+#define STATE_STORE_COLLECT_UNLOCK()
+#endif
+
+void state_store_init(void)
+{
+   unsigned i;
+   /* The table must never change, chunk boundaries depend on it */
+   uint64_t seed = UINT64_C(0x5241535453544f52);
+
+   if (state_store_st.inited)
+      return;
+
+   for (i = 0; i < 256; i++)
+   {
+      /* splitmix64 */
+      uint64_t z = (seed += UINT64_C(0x9e3779b97f4a7c15));
+      z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+      z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+      state_store_st.gear[i] = z ^ (z >> 31);
+   }
+
+#ifdef HAVE_THREADS
+   state_store_st.lock         = slock_new();
+   state_store_st.collect_lock = slock_new();
+#endif
+   state_store_st.inited = true;
+}
+
+static void state_store_put32(uint8_t *s, uint32_t val)
+{
+   s[0] = (uint8_t)val;
+   s[1] = (uint8_t)(val >> 8);
+   s[2] = (uint8_t)(val >> 16);
+   s[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t state_store_get32(const uint8_t *s)
+{
+   return (uint32_t)s[0]         | ((uint32_t)s[1] << 8)
+      |  ((uint32_t)s[2] << 16)  | ((uint32_t)s[3] << 24);
+}
+
+/* Returns the size of the chunk starting at @data */
+static size_t state_store_cut(const uint8_t *data, size_t len)
+{
+   size_t i;
+   size_t normal;
+   uint64_t hash = 0;
+
+   if (len <= STATE_STORE_MIN_CHUNK)
+      return len;
+   if (len > STATE_STORE_MAX_CHUNK)
+      len    = STATE_STORE_MAX_CHUNK;
+   normal    = MIN(len, STATE_STORE_AVG_CHUNK);
+
+   for (i = STATE_STORE_MIN_CHUNK; i < normal; i++)
+   {
+      hash = (hash << 1) + state_store_st.gear[data[i]];
+      if (!(hash & STATE_STORE_MASK_HARD))
+         return i + 1;
+   }
+   for (; i < len; i++)
+   {
+      hash = (hash << 1) + state_store_st.gear[data[i]];
+      if (!(hash & STATE_STORE_MASK_EASY))
+         return i + 1;
+   }
+   return len;
+}
+
+/* "dir/Game.state3" -> "Game", the part shared by all states of
+ * the content */
+static void state_store_content_name(char *s, const char *path, size_t len)
+{
+   const char *base = path_basename(path);
+   const char *ext  = NULL;
+   const char *pos  = base;
+
+   while ((pos = strstr(pos, ".state")))
+      ext = pos++;
+
+   strlcpy(s, base, len);
+   if (ext && (size_t)(ext - base) < len)
+      s[ext - base] = '\0';
+   else
+      path_remove_extension(s);
+}
+
+static void state_store_chunk_dir(char *s, const char *path, size_t len)
+{
+   char name[NAME_MAX_LENGTH];
+   size_t _len = fill_pathname_basedir(s, path, len);
+   state_store_content_name(name, path, sizeof(name));
+   _len       += strlcpy(s + _len, name, len - _len);
+   strlcpy(s + _len, STATE_STORE_CHUNK_EXT, len - _len);
+}
+
+static void state_store_chunk_path(char *s, const char *chunk_dir,
+      const uint8_t *digest, size_t len)
+{
+   unsigned i;
+   char name[STATE_STORE_DIGEST_SIZE * 2 + 1];
+   for (i = 0; i < STATE_STORE_DIGEST_SIZE; i++)
+      snprintf(name + 2 * i, 3, "%02x", (unsigned)digest[i]);
+   fill_pathname_join_special(s, chunk_dir, name, len);
+}
+
+static bool state_store_reserve(state_store_job_t *job, size_t len)
+{
+   uint8_t *buf;
+   if (len <= job->buf_size)
+      return true;
+   if (!(buf = (uint8_t*)realloc(job->buf, len)))
+      return false;
+   job->buf      = buf;
+   job->buf_size = len;
+   return true;
+}
+
+/* Writes through a temporary file, so a chunk or manifest that
+ * exists is always complete. @seq keeps the temporary files of
+ * concurrent writes apart */
+static bool state_store_write_file(const char *path,
+      const void *data, size_t len, bool sync, unsigned seq)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.%u.tmp", path, seq)
+         >= (int)sizeof(tmp_path))
+      return false;
+
+   if (!filestream_write_file(tmp_path, data, (int64_t)len))
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   if (sync)
+      state_writer_sync_path(tmp_path, false);
+
+   if (filestream_rename(tmp_path, path) != 0)
+   {
+      /* Renaming over an existing file fails on some platforms */
+      filestream_delete(path);
+      if (filestream_rename(tmp_path, path) != 0)
+      {
+         filestream_delete(tmp_path);
+         return false;
+      }
+   }
+   return true;
+}
+
+static bool state_store_put_chunk(state_store_job_t *job,
+      const char *chunk_dir, const uint8_t *data, size_t len,
+      const uint8_t *digest, unsigned flags)
+{
+   size_t stored_len              = len;
+   enum state_store_method method = STATE_STORE_METHOD_RAW;
+   uint8_t *out;
+   char chunk_path[PATH_MAX_LENGTH];
+
+   state_store_chunk_path(chunk_path, chunk_dir, digest, sizeof(chunk_path));
+
+   /* Pinned, so it cannot be collected once seen */
+   if (path_is_valid(chunk_path))
+   {
+      job->stats.chunks_reused++;
+      return true;
+   }
+
+#ifdef HAVE_ZSTD
+   if (flags & STATE_STORE_FLAG_COMPRESS)
+   {
+      size_t bound = ZSTD_compressBound(len);
+
+      if (!state_store_reserve(job, STATE_STORE_CHUNK_HEADER + bound))
+         return false;
+      if (!job->cctx && !(job->cctx = ZSTD_createCCtx()))
+         return false;
+
+      stored_len = ZSTD_compressCCtx(job->cctx,
+            job->buf + STATE_STORE_CHUNK_HEADER, bound,
+            data, len, STATE_STORE_ZSTD_LEVEL);
+
+      /* Chunks that don't shrink are stored as they are */
+      if (!ZSTD_isError(stored_len) && stored_len < len)
+         method     = STATE_STORE_METHOD_ZSTD;
+      else
+         stored_len = len;
+   }
+#endif
+
+   if (!state_store_reserve(job, STATE_STORE_CHUNK_HEADER + stored_len))
+      return false;
+
+   out = job->buf;
+   memcpy(out, STATE_STORE_CHUNK_MAGIC, 4);
+   out[4] = (uint8_t)method;
+   out[5] = out[6] = out[7] = 0;
+   state_store_put32(out + 8, (uint32_t)len);
+   state_store_put32(out + 12, encoding_crc32(0, data, len));
+   if (method == STATE_STORE_METHOD_RAW)
+      memcpy(out + STATE_STORE_CHUNK_HEADER, data, len);
+
+   if (!state_store_write_file(chunk_path, out,
+            STATE_STORE_CHUNK_HEADER + stored_len,
+            (flags & STATE_STORE_FLAG_SYNC) ? true : false, job->seq))
+      return false;
+
+   job->stats.bytes_stored += STATE_STORE_CHUNK_HEADER + stored_len;
+   return true;
+}
+
+/* Reads a chunk into @dst, which has room for @len bytes */
+static bool state_store_get_chunk(
+#ifdef HAVE_ZSTD
+      ZSTD_DCtx **dctx,
+#endif
+      const char *chunk_dir, const uint8_t *digest, uint8_t *dst, size_t len)
+{
+   void *buf       = NULL;
+   int64_t buf_len = 0;
+   bool ret        = false;
+   const uint8_t *in;
+   char chunk_path[PATH_MAX_LENGTH];
+
+   state_store_chunk_path(chunk_path, chunk_dir, digest, sizeof(chunk_path));
+
+   if (!filestream_read_file(chunk_path, &buf, &buf_len))
+      return false;
+
+   in = (const uint8_t*)buf;
+   if (     buf_len < STATE_STORE_CHUNK_HEADER
+         || memcmp(in, STATE_STORE_CHUNK_MAGIC, 4)
+         || state_store_get32(in + 8) != len)
+      goto end;
+
+   switch (in[4])
+   {
+      case STATE_STORE_METHOD_RAW:
+         if ((size_t)buf_len - STATE_STORE_CHUNK_HEADER != len)
+            goto end;
+         memcpy(dst, in + STATE_STORE_CHUNK_HEADER, len);
+         break;
+#ifdef HAVE_ZSTD
+      case STATE_STORE_METHOD_ZSTD:
+         if (!*dctx && !(*dctx = ZSTD_createDCtx()))
+            goto end;
+         if (ZSTD_decompressDCtx(*dctx, dst, len,
+                  in + STATE_STORE_CHUNK_HEADER,
+                  (size_t)buf_len - STATE_STORE_CHUNK_HEADER) != len)
+            goto end;
+         break;
+#endif
+      default:
+         goto end;
+   }
+
+   /* A damaged chunk would otherwise be handed to the core. A CRC
+    * catches damage for much less than hashing the chunk again */
+   ret = encoding_crc32(0, dst, len) == state_store_get32(in + 12);
+
+end:
+   free(buf);
+   return ret;
+}
+
+bool state_store_is_manifest(const void *data, size_t len)
+{
+   const uint8_t *in = (const uint8_t*)data;
+   uint32_t count;
+
+   if (     !data
+         || len < STATE_STORE_MANIFEST_HEADER
+         || memcmp(in, STATE_STORE_MANIFEST_MAGIC, 8))
+      return false;
+
+   count = state_store_get32(in + 16);
+   return (len - STATE_STORE_MANIFEST_HEADER) / STATE_STORE_MANIFEST_ENTRY
+      >= count;
+}
+
+/* Reads the manifest in @path, if it is one */
+static uint8_t *state_store_read_manifest(const char *path, size_t *len)
+{
+   char magic[8];
+   void *buf       = NULL;
+   int64_t buf_len = 0;
+   RFILE *file     = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return NULL;
+   /* Most files in a states directory are not manifests, only read
+    * the rest of those that are */
+   if (     filestream_read(file, magic, sizeof(magic)) != sizeof(magic)
+         || memcmp(magic, STATE_STORE_MANIFEST_MAGIC, sizeof(magic)))
+   {
+      filestream_close(file);
+      return NULL;
+   }
+   filestream_close(file);
+
+   if (!filestream_read_file(path, &buf, &buf_len))
+      return NULL;
+   if (!state_store_is_manifest(buf, (size_t)buf_len))
+   {
+      free(buf);
+      return NULL;
+   }
+   *len = (size_t)buf_len;
+   return (uint8_t*)buf;
+}
+
+static int state_store_digest_cmp(const void *a, const void *b)
+{
+   return memcmp(a, b, STATE_STORE_DIGEST_SIZE);
+}
+
+/* Returns the end of the digest @name starts with, or NULL */
+static const char *state_store_parse_digest(uint8_t *digest,
+      const char *name)
+{
+   unsigned i;
+   for (i = 0; i < STATE_STORE_DIGEST_SIZE * 2; i++)
+   {
+      char c = name[i];
+      unsigned v;
+      if (c >= '0' && c <= '9')
+         v = c - '0';
+      else if (c >= 'a' && c <= 'f')
+         v = c - 'a' + 10;
+      else
+         return NULL;
+      if (i & 1)
+         digest[i >> 1] |= v;
+      else
+         digest[i >> 1]  = v << 4;
+   }
+   return name + i;
+}
+
+/* Sorts a copy of the digests of @manifest into @pin */
+static bool state_store_pin_init(struct state_store_pin *pin,
+      const uint8_t *manifest, size_t count)
+{
+   size_t i;
+
+   pin->next    = NULL;
+   pin->count   = count;
+   if (!(pin->digests = (uint8_t*)malloc(
+               MAX(count, 1) * STATE_STORE_DIGEST_SIZE)))
+      return false;
+
+   for (i = 0; i < count; i++)
+      memcpy(pin->digests + i * STATE_STORE_DIGEST_SIZE,
+            manifest + STATE_STORE_MANIFEST_HEADER
+            + i * STATE_STORE_MANIFEST_ENTRY,
+            STATE_STORE_DIGEST_SIZE);
+   if (count)
+      qsort(pin->digests, count, STATE_STORE_DIGEST_SIZE,
+            state_store_digest_cmp);
+   return true;
+}
+
+/* Must be called with the lock held */
+static void state_store_pin_add(struct state_store_pin *pin)
+{
+   pin->next           = state_store_st.pins;
+   state_store_st.pins = pin;
+}
+
+/* Must be called with the lock held */
+static void state_store_pin_remove(struct state_store_pin *pin)
+{
+   struct state_store_pin **p = &state_store_st.pins;
+   while (*p && *p != pin)
+      p = &(*p)->next;
+   if (*p)
+      *p = pin->next;
+}
+
+/* Must be called with the lock held */
+static bool state_store_is_pinned(const uint8_t *digest)
+{
+   struct state_store_pin *pin;
+   for (pin = state_store_st.pins; pin; pin = pin->next)
+      if (     pin->count
+            && bsearch(digest, pin->digests, pin->count,
+               STATE_STORE_DIGEST_SIZE, state_store_digest_cmp))
+         return true;
+   return false;
+}
+
+unsigned state_store_collect(const char *path)
+{
+   size_t _len;
+   struct RDIR *dir;
+   unsigned epoch;
+   unsigned deleted  = 0;
+   uint8_t *digests  = NULL;
+   size_t count      = 0;
+   size_t cap        = 0;
+   bool failed       = false;
+   char state_dir[PATH_MAX_LENGTH];
+   char chunk_dir[PATH_MAX_LENGTH];
+   char prefix[NAME_MAX_LENGTH];
+   char file[PATH_MAX_LENGTH];
+
+   state_store_chunk_dir(chunk_dir, path, sizeof(chunk_dir));
+   if (!path_is_directory(chunk_dir))
+      return 0;
+
+   STATE_STORE_COLLECT_LOCK();
+
+   STATE_STORE_LOCK();
+   epoch = state_store_st.epoch;
+   STATE_STORE_UNLOCK();
+
+   /* Mark: the chunks referenced by the manifests of the content.
+    * Files of other contents sharing the prefix only keep more
+    * chunks alive, never fewer */
+   fill_pathname_basedir(state_dir, path, sizeof(state_dir));
+   state_store_content_name(prefix, path, sizeof(prefix));
+   strlcat(prefix, ".", sizeof(prefix));
+   _len = strlen(prefix);
+
+   if (!(dir = retro_opendir(string_is_empty(state_dir) ? "." : state_dir)))
+   {
+      STATE_STORE_COLLECT_UNLOCK();
+      return 0;
+   }
+   while (retro_readdir(dir))
+   {
+      size_t i, manifest_len;
+      uint8_t *manifest;
+      uint32_t entries;
+      const char *name = retro_dirent_get_name(dir);
+
+      if (strncmp(name, prefix, _len) || retro_dirent_is_dir(dir, NULL))
+         continue;
+
+      fill_pathname_join_special(file, state_dir, name, sizeof(file));
+      if (!(manifest = state_store_read_manifest(file, &manifest_len)))
+         continue;
+
+      entries = state_store_get32(manifest + 16);
+      if (count + entries > cap)
+      {
+         size_t new_cap   = MAX(cap * 2, count + entries);
+         uint8_t *tmp     = (uint8_t*)realloc(digests,
+               new_cap * STATE_STORE_DIGEST_SIZE);
+         if (!tmp)
+         {
+            free(manifest);
+            failed = true;
+            break;
+         }
+         digests = tmp;
+         cap     = new_cap;
+      }
+
+      for (i = 0; i < entries; i++)
+         memcpy(digests + (count++) * STATE_STORE_DIGEST_SIZE,
+               manifest + STATE_STORE_MANIFEST_HEADER
+               + i * STATE_STORE_MANIFEST_ENTRY,
+               STATE_STORE_DIGEST_SIZE);
+      free(manifest);
+   }
+   if (retro_dirent_error(dir))
+      failed = true;
+   retro_closedir(dir);
+
+   /* Deleting chunks of a manifest that could not be read would
+    * lose that state */
+   if (failed)
+   {
+      free(digests);
+      STATE_STORE_COLLECT_UNLOCK();
+      return 0;
+   }
+
+   if (count)
+      qsort(digests, count, STATE_STORE_DIGEST_SIZE, state_store_digest_cmp);
+
+   /* Sweep: everything else in the chunk directory, including
+    * temporary files left behind by a crash */
+   if ((dir = retro_opendir(chunk_dir)))
+   {
+      while (retro_readdir(dir))
+      {
+         bool stop = false;
+         uint8_t digest[STATE_STORE_DIGEST_SIZE];
+         const char *name = retro_dirent_get_name(dir);
+         const char *end;
+
+         if (     string_is_equal(name, ".")
+               || string_is_equal(name, "..")
+               || retro_dirent_is_dir(dir, NULL))
+            continue;
+
+         end = state_store_parse_digest(digest, name);
+         if (     end
+               && *end == '\0'
+               && count
+               && bsearch(digest, digests, count, STATE_STORE_DIGEST_SIZE,
+                  state_store_digest_cmp))
+            continue;
+
+         fill_pathname_join_special(file, chunk_dir, name, sizeof(file));
+
+         /* A write that published its manifest since the mark may use
+          * chunks that were not marked, leave them to the next
+          * collection. Chunks and temporary files of writes in
+          * progress are pinned. Checking and deleting under the lock
+          * keeps a write from seeing a chunk that is about to go */
+         STATE_STORE_LOCK();
+         if (state_store_st.epoch != epoch)
+            stop = true;
+         else if (!(end && (*end == '\0' || *end == '.')
+                  && state_store_is_pinned(digest)))
+         {
+            if (filestream_delete(file) == 0)
+               deleted++;
+         }
+         STATE_STORE_UNLOCK();
+
+         if (stop)
+            break;
+      }
+      retro_closedir(dir);
+   }
+
+   free(digests);
+
+   STATE_STORE_LOCK();
+   state_store_st.stats.chunks_collected += deleted;
+   STATE_STORE_UNLOCK();
+
+   STATE_STORE_COLLECT_UNLOCK();
+   return deleted;
+}
+
+bool state_store_write(const char *path, const void *data, size_t len,
+      unsigned flags)
+{
+   size_t pos;
+   state_store_job_t job;
+   struct state_store_pin pin;
+   size_t count       = 0;
+   size_t cap         = 0;
+   uint8_t *manifest  = NULL;
+   const uint8_t *in  = (const uint8_t*)data;
+   bool pinned        = false;
+   bool ret           = false;
+   char chunk_dir[PATH_MAX_LENGTH];
+
+   memset(&job, 0, sizeof(job));
+   pin.digests = NULL;
+
+   state_store_chunk_dir(chunk_dir, path, sizeof(chunk_dir));
+
+   /* Chunk and hash the whole state first, the digests are needed
+    * to pin the chunks before looking for them in the store */
+   for (pos = 0; pos < len; )
+   {
+      uint8_t *entry;
+      size_t chunk_len = state_store_cut(in + pos, len - pos);
+
+      if (count == cap)
+      {
+         size_t new_cap = cap ? cap * 2
+            : len / STATE_STORE_AVG_CHUNK + 16;
+         uint8_t *tmp   = (uint8_t*)realloc(manifest,
+               STATE_STORE_MANIFEST_HEADER
+               + new_cap * STATE_STORE_MANIFEST_ENTRY);
+         if (!tmp)
+            goto end;
+         manifest = tmp;
+         cap      = new_cap;
+      }
+
+      entry = manifest + STATE_STORE_MANIFEST_HEADER
+         + count * STATE_STORE_MANIFEST_ENTRY;
+      sha256_digest(in + pos, chunk_len, entry);
+      state_store_put32(entry + STATE_STORE_DIGEST_SIZE,
+            (uint32_t)chunk_len);
+
+      count++;
+      pos += chunk_len;
+   }
+
+   if (!manifest && !(manifest = (uint8_t*)malloc(
+               STATE_STORE_MANIFEST_HEADER)))
+      goto end;
+
+   memcpy(manifest, STATE_STORE_MANIFEST_MAGIC, 8);
+   state_store_put32(manifest + 8,  (uint32_t)((uint64_t)len));
+   state_store_put32(manifest + 12, (uint32_t)((uint64_t)len >> 32));
+   state_store_put32(manifest + 16, (uint32_t)count);
+   state_store_put32(manifest + 20, 0);
+
+   if (!state_store_pin_init(&pin, manifest, count))
+      goto end;
+
+   STATE_STORE_LOCK();
+   state_store_pin_add(&pin);
+   job.seq             = ++state_store_st.seq;
+#ifdef HAVE_ZSTD
+   job.cctx            = state_store_st.cctx;
+   state_store_st.cctx = NULL;
+#endif
+   STATE_STORE_UNLOCK();
+   pinned              = true;
+
+   if (!path_is_directory(chunk_dir) && !path_mkdir(chunk_dir))
+      goto end;
+
+   for (pos = 0; pos < count; pos++)
+   {
+      const uint8_t *entry = manifest + STATE_STORE_MANIFEST_HEADER
+         + pos * STATE_STORE_MANIFEST_ENTRY;
+      size_t chunk_len     = state_store_get32(
+            entry + STATE_STORE_DIGEST_SIZE);
+
+      if (!state_store_put_chunk(&job, chunk_dir, in, chunk_len, entry,
+               flags))
+         goto end;
+
+      job.stats.chunks++;
+      in += chunk_len;
+   }
+
+   if (flags & STATE_STORE_FLAG_SYNC)
+      state_writer_sync_path(chunk_dir, true);
+
+   if (!state_store_write_file(path, manifest,
+            STATE_STORE_MANIFEST_HEADER + count * STATE_STORE_MANIFEST_ENTRY,
+            (flags & STATE_STORE_FLAG_SYNC) ? true : false, job.seq))
+      goto end;
+
+   job.stats.bytes_in += len;
+   ret = true;
+
+end:
+   if (pinned)
+   {
+      STATE_STORE_LOCK();
+      state_store_pin_remove(&pin);
+      if (ret)
+         state_store_st.epoch++;
+      state_store_st.stats.bytes_in      += job.stats.bytes_in;
+      state_store_st.stats.bytes_stored  += job.stats.bytes_stored;
+      state_store_st.stats.chunks        += job.stats.chunks;
+      state_store_st.stats.chunks_reused += job.stats.chunks_reused;
+#ifdef HAVE_ZSTD
+      if (!state_store_st.cctx)
+      {
+         state_store_st.cctx = job.cctx;
+         job.cctx            = NULL;
+      }
+#endif
+      STATE_STORE_UNLOCK();
+   }
+#ifdef HAVE_ZSTD
+   ZSTD_freeCCtx(job.cctx);
+#endif
+   free(job.buf);
+   free(pin.digests);
+   free(manifest);
+
+   /* The state this manifest replaced may have been the last one
+    * using some chunks */
+   if (ret)
+      state_store_collect(path);
+   return ret;
+}
+
+void *state_store_read(const char *path, const void *manifest,
+      size_t manifest_len, size_t *len)
+{
+   uint32_t i, count;
+   uint64_t total, pos = 0;
+   uint8_t *out;
+   struct state_store_pin pin;
+#ifdef HAVE_ZSTD
+   ZSTD_DCtx *dctx;
+#endif
+   const uint8_t *in = (const uint8_t*)manifest;
+   char chunk_dir[PATH_MAX_LENGTH];
+
+   if (!state_store_is_manifest(manifest, manifest_len))
+      return NULL;
+
+   total = state_store_get32(in + 8)
+      | ((uint64_t)state_store_get32(in + 12) << 32);
+   count = state_store_get32(in + 16);
+
+   if (total >= SIZE_MAX || !(out = (uint8_t*)malloc((size_t)total + 1)))
+      return NULL;
+   if (!state_store_pin_init(&pin, in, count))
+   {
+      free(out);
+      return NULL;
+   }
+
+   state_store_chunk_dir(chunk_dir, path, sizeof(chunk_dir));
+
+   STATE_STORE_LOCK();
+   state_store_pin_add(&pin);
+#ifdef HAVE_ZSTD
+   dctx                = state_store_st.dctx;
+   state_store_st.dctx = NULL;
+#endif
+   STATE_STORE_UNLOCK();
+
+   for (i = 0; i < count; i++)
+   {
+      const uint8_t *entry = in + STATE_STORE_MANIFEST_HEADER
+         + (size_t)i * STATE_STORE_MANIFEST_ENTRY;
+      uint32_t chunk_len   = state_store_get32(
+            entry + STATE_STORE_DIGEST_SIZE);
+
+      if (     chunk_len > total - pos
+            || !state_store_get_chunk(
+#ifdef HAVE_ZSTD
+               &dctx,
+#endif
+               chunk_dir, entry, out + pos, chunk_len))
+         break;
+      pos += chunk_len;
+   }
+
+   STATE_STORE_LOCK();
+   state_store_pin_remove(&pin);
+#ifdef HAVE_ZSTD
+   if (!state_store_st.dctx)
+   {
+      state_store_st.dctx = dctx;
+      dctx                = NULL;
+   }
+#endif
+   STATE_STORE_UNLOCK();
+#ifdef HAVE_ZSTD
+   ZSTD_freeDCtx(dctx);
+#endif
+   free(pin.digests);
+
+   if (i != count || pos != total)
+   {
+      free(out);
+      return NULL;
+   }
+
+   out[total] = '\0';
+   *len       = (size_t)total;
+   return out;
+}
+
+bool state_store_export(const char *path, const char *out_path)
+{
+   bool ret        = false;
+   void *buf       = NULL;
+   int64_t buf_len = 0;
+
+   if (!filestream_read_file(path, &buf, &buf_len))
+      return false;
+
+   if (state_store_is_manifest(buf, (size_t)buf_len))
+   {
+      size_t _len = 0;
+      void *state = state_store_read(path, buf, (size_t)buf_len, &_len);
+      if (state)
+      {
+         ret = filestream_write_file(out_path, state, (int64_t)_len);
+         free(state);
+      }
+   }
+   else
+      ret = filestream_write_file(out_path, buf, buf_len);
+
+   free(buf);
+   return ret;
+}
+
+void state_store_get_stats(state_store_stats_t *stats)
+{
+   STATE_STORE_LOCK();
+   *stats = state_store_st.stats;
+   memset(&state_store_st.stats, 0, sizeof(state_store_st.stats));
+   STATE_STORE_UNLOCK();
+}
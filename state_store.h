@@ -0,0 +1,141 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STATE_STORE_H
+#define __STATE_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Deduplicating store for save state files.
+ *
+ * A state is split into chunks at boundaries picked from its bytes
+ * (a rolling gear hash), so data moving around within a state only
+ * changes the chunks where it was inserted or removed. Chunks are
+ * named by their SHA-256 and kept once in a directory shared by all
+ * states of a content, next to them: "Game.state", "Game.state1" and
+ * "Game.state.auto" keep their chunks in "Game.chunks". With zstd
+ * support, chunks can be stored compressed.
+ *
+ * The state file itself holds a small manifest listing its chunks,
+ * so slot rotation, renames and backups keep working on it as on any
+ * state file. Chunks that no manifest refers to any more are deleted
+ * when a state of the content is written.
+ *
+ * Calls may be made from any thread once state_store_init() has
+ * returned. Writes and reads run concurrently: they pin the chunks
+ * they use, which collection leaves alone, and only take the lock of
+ * the store for that and for the stats. Collections run one at a
+ * time. */
+
+enum state_store_flags
+{
+   /* Compress new chunks, if supported */
+   STATE_STORE_FLAG_COMPRESS = (1 << 0),
+   /* Flush chunks and manifest to storage before returning */
+   STATE_STORE_FLAG_SYNC     = (1 << 1)
+};
+
+typedef struct state_store_stats
+{
+   /* State bytes written */
+   uint64_t bytes_in;
+   /* Chunk bytes written to storage, after compression */
+   uint64_t bytes_stored;
+   unsigned chunks;
+   /* Chunks already in the store */
+   unsigned chunks_reused;
+   /* Unreferenced chunks deleted */
+   unsigned chunks_collected;
+} state_store_stats_t;
+
+/**
+ * state_store_init:
+ *
+ * Sets up the store. Must be called on one thread, in RetroArch the
+ * main thread, before the other functions are used from any other.
+ **/
+void state_store_init(void);
+
+/**
+ * state_store_is_manifest:
+ *
+ * Returns: true if @data, read from a state file, is a manifest
+ * rather than a state.
+ **/
+bool state_store_is_manifest(const void *data, size_t len);
+
+/**
+ * state_store_write:
+ * @path        : State file to write the manifest to.
+ * @data        : State.
+ * @len         : Size of @data.
+ * @flags       : Bitmask of enum state_store_flags.
+ *
+ * Adds the chunks of @data missing from the store of the content,
+ * then replaces @path with a manifest for @data and collects the
+ * chunks no state refers to any more.
+ *
+ * Returns: true on success. On failure @path is left as it was.
+ **/
+bool state_store_write(const char *path, const void *data, size_t len,
+      unsigned flags);
+
+/**
+ * state_store_read:
+ * @path        : State file the manifest was read from.
+ * @manifest    : Manifest.
+ * @manifest_len: Size of @manifest.
+ * @len         : Set to the size of the state.
+ *
+ * Returns: malloc()ed state, with a terminating NUL byte like
+ * filestream_read_file(), or NULL if a chunk is missing or damaged.
+ **/
+void *state_store_read(const char *path, const void *manifest,
+      size_t manifest_len, size_t *len);
+
+/**
+ * state_store_export:
+ * @path        : State file, manifest or plain state.
+ * @out_path    : File to write the plain state to.
+ *
+ * Returns: true if the state was written to @out_path.
+ **/
+bool state_store_export(const char *path, const char *out_path);
+
+/**
+ * state_store_collect:
+ * @path        : Any state file of the content.
+ *
+ * Deletes the chunks of the content that no manifest refers to.
+ *
+ * Returns: number of chunks deleted.
+ **/
+unsigned state_store_collect(const char *path);
+
+/**
+ * state_store_get_stats:
+ *
+ * Copies the totals since the last call to @stats and resets them.
+ **/
+void state_store_get_stats(state_store_stats_t *stats);
+
+RETRO_END_DECLS
+
+#endif
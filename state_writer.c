@@ -0,0 +1,559 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(_XBOX)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define STATE_WRITER_HAVE_FSYNC
+#endif
+
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+#include <streams/interface_stream.h>
+#include <string/stdstring.h>
+
+#include "state_store.h"
+#include "state_writer.h"
+
+typedef struct state_writer_job
+{
+   struct state_writer_job *next;
+   void *data;
+   size_t len;
+   uint32_t ticket;
+   unsigned flags;
+   enum state_writer_sync sync;
+   bool running;
+   char path[PATH_MAX_LENGTH];
+} state_writer_job_t;
+
+typedef struct state_writer_result
+{
+   uint32_t ticket;
+   enum state_writer_status status;
+} state_writer_result_t;
+
+struct state_writer
+{
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond;
+#endif
+   state_writer_job_t *head;
+   state_writer_job_t *tail;
+   state_writer_result_t *results;
+   size_t num_results;
+   size_t cap_results;
+   unsigned max_workers;
+   unsigned num_workers;
+   uint32_t next_ticket;
+};
+
+void state_writer_sync_path(const char *path, bool is_dir)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   HANDLE h;
+   /* Directory entries are flushed with the file on Windows */
+   if (is_dir)
+      return;
+   h = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+         NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (h == INVALID_HANDLE_VALUE)
+      return;
+   FlushFileBuffers(h);
+   CloseHandle(h);
+#elif defined(STATE_WRITER_HAVE_FSYNC)
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return;
+   fsync(fd);
+   close(fd);
+#endif
+}
+
+static bool state_writer_write_file(const char *path,
+      const void *data, size_t len, unsigned flags)
+{
+   int64_t written;
+   intfstream_t *file = NULL;
+
+#if defined(HAVE_ZLIB)
+   if (flags & STATE_WRITER_FLAG_COMPRESS)
+      file = intfstream_open_rzip_file(path, RETRO_VFS_FILE_ACCESS_WRITE);
+   else
+#endif
+      file = intfstream_open_file(path, RETRO_VFS_FILE_ACCESS_WRITE,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   written = intfstream_write(file, data, len);
+   intfstream_flush(file);
+   intfstream_close(file);
+   free(file);
+
+   return written == (int64_t)len;
+}
+
+static bool state_writer_write_job(const state_writer_job_t *job)
+{
+   size_t _len;
+   char tmp_path[PATH_MAX_LENGTH];
+
+   if (job->sync != STATE_WRITER_SYNC_ATOMIC)
+   {
+      if (!state_writer_write_file(job->path, job->data, job->len,
+               job->flags))
+         return false;
+      if (job->sync == STATE_WRITER_SYNC_FILE)
+         state_writer_sync_path(job->path, false);
+      return true;
+   }
+
+   _len = strlcpy(tmp_path, job->path, sizeof(tmp_path));
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+   if (!state_writer_write_file(tmp_path, job->data, job->len, job->flags))
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   state_writer_sync_path(tmp_path, false);
+
+   if (filestream_rename(tmp_path, job->path) != 0)
+   {
+      /* Renaming over an existing file fails on some platforms */
+      filestream_delete(job->path);
+      if (filestream_rename(tmp_path, job->path) != 0)
+      {
+         filestream_delete(tmp_path);
+         return false;
+      }
+   }
+
+   {
+      char dir[PATH_MAX_LENGTH];
+      fill_pathname_basedir(dir, job->path, sizeof(dir));
+      if (!string_is_empty(dir))
+         state_writer_sync_path(dir, true);
+   }
+
+   return true;
+}
+
+static bool state_writer_run_job(const state_writer_job_t *job)
+{
+   /* Chunks and manifests always go through temporary files */
+   if (job->flags & STATE_WRITER_FLAG_STORE)
+      return state_store_write(job->path, job->data, job->len,
+              ((job->flags & STATE_WRITER_FLAG_COMPRESS)
+               ? STATE_STORE_FLAG_COMPRESS : 0)
+            | ((job->sync != STATE_WRITER_SYNC_NONE)
+               ? STATE_STORE_FLAG_SYNC : 0));
+
+   if (!state_writer_write_job(job))
+      return false;
+
+   /* The file may have been a manifest, holding on to chunks */
+   state_store_collect(job->path);
+   return true;
+}
+
+static void state_writer_set_result(state_writer_t *writer,
+      uint32_t ticket, enum state_writer_status status)
+{
+   size_t i;
+
+   if (!ticket)
+      return;
+
+   for (i = 0; i < writer->num_results; i++)
+   {
+      if (writer->results[i].ticket == ticket)
+      {
+         writer->results[i].status = status;
+         return;
+      }
+   }
+
+   if (writer->num_results == writer->cap_results)
+   {
+      size_t cap                     = writer->cap_results
+         ? writer->cap_results * 2 : 16;
+      state_writer_result_t *results = (state_writer_result_t*)
+         realloc(writer->results, cap * sizeof(*results));
+      if (!results)
+         return;
+      writer->results     = results;
+      writer->cap_results = cap;
+   }
+
+   writer->results[writer->num_results].ticket   = ticket;
+   writer->results[writer->num_results++].status = status;
+}
+
+static void state_writer_unlink_job(state_writer_t *writer,
+      state_writer_job_t *job)
+{
+   state_writer_job_t *prev = NULL;
+   state_writer_job_t *cur  = writer->head;
+
+   while (cur && cur != job)
+   {
+      prev = cur;
+      cur  = cur->next;
+   }
+
+   if (!cur)
+      return;
+
+   if (prev)
+      prev->next   = job->next;
+   else
+      writer->head = job->next;
+   if (writer->tail == job)
+      writer->tail = prev;
+}
+
+/* Oldest waiting job whose file is not being written already */
+static state_writer_job_t *state_writer_next_job(state_writer_t *writer)
+{
+   state_writer_job_t *job;
+
+   for (job = writer->head; job; job = job->next)
+   {
+      state_writer_job_t *other;
+
+      if (job->running)
+         continue;
+
+      for (other = writer->head; other; other = other->next)
+         if (other->running && string_is_equal(other->path, job->path))
+            break;
+
+      if (!other)
+         return job;
+   }
+
+   return NULL;
+}
+
+static void state_writer_finish_job(state_writer_t *writer,
+      state_writer_job_t *job, bool ok)
+{
+   state_writer_unlink_job(writer, job);
+   if (!(job->flags & STATE_WRITER_FLAG_DETACH))
+      state_writer_set_result(writer, job->ticket,
+            ok ? STATE_WRITER_STATUS_DONE : STATE_WRITER_STATUS_FAILED);
+   free(job->data);
+   free(job);
+}
+
+#ifdef HAVE_THREADS
+static void state_writer_thread(void *data)
+{
+   state_writer_t *writer = (state_writer_t*)data;
+
+   slock_lock(writer->lock);
+
+   for (;;)
+   {
+      bool ok;
+      state_writer_job_t *job = state_writer_next_job(writer);
+
+      if (!job)
+         break;
+
+      job->running = true;
+      slock_unlock(writer->lock);
+
+      ok = state_writer_run_job(job);
+
+      slock_lock(writer->lock);
+      state_writer_finish_job(writer, job, ok);
+      scond_broadcast(writer->cond);
+   }
+
+   writer->num_workers--;
+   scond_broadcast(writer->cond);
+   slock_unlock(writer->lock);
+}
+#endif
+
+state_writer_t *state_writer_new(unsigned max_workers)
+{
+   state_writer_t *writer = (state_writer_t*)calloc(1, sizeof(*writer));
+
+   if (!writer)
+      return NULL;
+
+   writer->max_workers = max_workers ? max_workers : 1;
+   writer->next_ticket = 1;
+
+   state_store_init();
+
+#ifdef HAVE_THREADS
+   writer->lock        = slock_new();
+   writer->cond        = scond_new();
+
+   if (!writer->lock || !writer->cond)
+   {
+      if (writer->lock)
+         slock_free(writer->lock);
+      if (writer->cond)
+         scond_free(writer->cond);
+      free(writer);
+      return NULL;
+   }
+#endif
+
+   return writer;
+}
+
+void state_writer_free(state_writer_t *writer)
+{
+   if (!writer)
+      return;
+
+   state_writer_wait(writer, NULL);
+
+#ifdef HAVE_THREADS
+   /* Workers touch the lock on their way out */
+   slock_lock(writer->lock);
+   while (writer->num_workers)
+      scond_wait(writer->cond, writer->lock);
+   slock_unlock(writer->lock);
+
+   slock_free(writer->lock);
+   scond_free(writer->cond);
+#endif
+
+   free(writer->results);
+   free(writer);
+}
+
+uint32_t state_writer_submit(state_writer_t *writer, const char *path,
+      void *data, size_t len, unsigned flags, enum state_writer_sync sync)
+{
+   uint32_t ticket;
+   state_writer_job_t *job = NULL;
+
+   if (!writer || string_is_empty(path) || !data)
+   {
+      free(data);
+      return 0;
+   }
+
+#ifdef HAVE_THREADS
+   slock_lock(writer->lock);
+#endif
+
+   ticket = writer->next_ticket++;
+   if (!writer->next_ticket)
+      writer->next_ticket = 1;
+
+   /* A write to the same file that has not started yet only gets
+    * newer data */
+   for (job = writer->head; job; job = job->next)
+   {
+      if (!job->running && string_is_equal(job->path, path))
+      {
+         if (!(job->flags & STATE_WRITER_FLAG_DETACH))
+            state_writer_set_result(writer, job->ticket,
+                  STATE_WRITER_STATUS_SUPERSEDED);
+         free(job->data);
+         break;
+      }
+   }
+
+   if (!job)
+   {
+      if (!(job = (state_writer_job_t*)calloc(1, sizeof(*job))))
+      {
+#ifdef HAVE_THREADS
+         slock_unlock(writer->lock);
+#endif
+         free(data);
+         return 0;
+      }
+
+      strlcpy(job->path, path, sizeof(job->path));
+
+      if (writer->tail)
+         writer->tail->next = job;
+      else
+         writer->head       = job;
+      writer->tail          = job;
+   }
+
+   job->data   = data;
+   job->len    = len;
+   job->ticket = ticket;
+   job->flags  = flags;
+   job->sync   = sync;
+
+   if (!(flags & STATE_WRITER_FLAG_DETACH))
+      state_writer_set_result(writer, ticket, STATE_WRITER_STATUS_PENDING);
+
+#ifdef HAVE_THREADS
+   if (writer->num_workers < writer->max_workers)
+   {
+      sthread_t *thread = sthread_create(state_writer_thread, writer);
+      if (thread)
+      {
+         sthread_detach(thread);
+         writer->num_workers++;
+      }
+   }
+
+   /* Without a worker there is nothing to wait for, write it here */
+   if (!writer->num_workers)
+   {
+      bool ok;
+      job->running = true;
+      slock_unlock(writer->lock);
+      ok = state_writer_run_job(job);
+      slock_lock(writer->lock);
+      state_writer_finish_job(writer, job, ok);
+      scond_broadcast(writer->cond);
+   }
+
+   slock_unlock(writer->lock);
+#else
+   state_writer_finish_job(writer, job, state_writer_run_job(job));
+#endif
+
+   return (flags & STATE_WRITER_FLAG_DETACH) ? 0 : ticket;
+}
+
+enum state_writer_status state_writer_poll(state_writer_t *writer,
+      uint32_t ticket)
+{
+   size_t i;
+   enum state_writer_status status = STATE_WRITER_STATUS_UNKNOWN;
+
+   if (!writer || !ticket)
+      return status;
+
+#ifdef HAVE_THREADS
+   slock_lock(writer->lock);
+#endif
+
+   for (i = 0; i < writer->num_results; i++)
+   {
+      if (writer->results[i].ticket != ticket)
+         continue;
+
+      status = writer->results[i].status;
+      if (status != STATE_WRITER_STATUS_PENDING)
+         writer->results[i] = writer->results[--writer->num_results];
+      break;
+   }
+
+#ifdef HAVE_THREADS
+   slock_unlock(writer->lock);
+#endif
+
+   return status;
+}
+
+static bool state_writer_pending_locked(state_writer_t *writer,
+      const char *path)
+{
+   state_writer_job_t *job;
+
+   if (!path)
+      return writer->head != NULL;
+
+   for (job = writer->head; job; job = job->next)
+      if (string_is_equal(job->path, path))
+         return true;
+
+   return false;
+}
+
+bool state_writer_pending(state_writer_t *writer, const char *path)
+{
+   bool pending;
+
+   if (!writer)
+      return false;
+
+#ifdef HAVE_THREADS
+   slock_lock(writer->lock);
+#endif
+   pending = state_writer_pending_locked(writer, path);
+#ifdef HAVE_THREADS
+   slock_unlock(writer->lock);
+#endif
+
+   return pending;
+}
+
+void state_writer_wait(state_writer_t *writer, const char *path)
+{
+#ifdef HAVE_THREADS
+   if (!writer)
+      return;
+
+   slock_lock(writer->lock);
+   while (state_writer_pending_locked(writer, path))
+      scond_wait(writer->cond, writer->lock);
+   slock_unlock(writer->lock);
+#endif
+}
+
+void *state_writer_copy_pending(state_writer_t *writer, const char *path,
+      size_t *len)
+{
+   state_writer_job_t *job;
+   state_writer_job_t *latest = NULL;
+   void *copy                 = NULL;
+
+   if (!writer || !path)
+      return NULL;
+
+#ifdef HAVE_THREADS
+   slock_lock(writer->lock);
+#endif
+
+   /* A running write and a waiting one can exist for the same file,
+    * the waiting one is newer */
+   for (job = writer->head; job; job = job->next)
+      if (string_is_equal(job->path, path))
+         if (!latest || !job->running)
+            latest = job;
+
+   if (latest && (copy = malloc(latest->len)))
+   {
+      memcpy(copy, latest->data, latest->len);
+      *len = latest->len;
+   }
+
+#ifdef HAVE_THREADS
+   slock_unlock(writer->lock);
+#endif
+
+   return copy;
+}
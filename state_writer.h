@@ -0,0 +1,152 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STATE_WRITER_H
+#define __STATE_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Write-behind queue for save state files.
+ *
+ * Serialized states are handed over together with their buffer and
+ * written by worker threads, which are started on demand and exit once
+ * the queue is empty. Writes to different files run in parallel, writes
+ * to the same file never do: a state submitted for a file that still
+ * has a write waiting replaces that write's data instead of queueing
+ * another one, so saving repeatedly to a slot on slow storage only
+ * writes the latest state.
+ *
+ * Without thread support, states are written as they are submitted. */
+
+enum state_writer_sync
+{
+   /* Leave flushing to the OS */
+   STATE_WRITER_SYNC_NONE = 0,
+   /* Flush the file to storage before reporting it written */
+   STATE_WRITER_SYNC_FILE,
+   /* Write to a temporary file, flush it and rename it over the
+    * state, so a crash never leaves a truncated state behind */
+   STATE_WRITER_SYNC_ATOMIC,
+   STATE_WRITER_SYNC_LAST
+};
+
+enum state_writer_status
+{
+   STATE_WRITER_STATUS_UNKNOWN = 0,
+   STATE_WRITER_STATUS_PENDING,
+   STATE_WRITER_STATUS_DONE,
+   STATE_WRITER_STATUS_FAILED,
+   /* Replaced by a later state for the same file before it was written */
+   STATE_WRITER_STATUS_SUPERSEDED
+};
+
+enum state_writer_flags
+{
+   STATE_WRITER_FLAG_COMPRESS = (1 << 0),
+   /* Don't keep a status for the ticket, it will never be polled */
+   STATE_WRITER_FLAG_DETACH   = (1 << 1),
+   /* Write to the deduplicating store (state_store.h), leaving a
+    * manifest in the file */
+   STATE_WRITER_FLAG_STORE    = (1 << 2)
+};
+
+typedef struct state_writer state_writer_t;
+
+/**
+ * state_writer_new:
+ * @max_workers : Number of files written at the same time.
+ *
+ * Returns: new writer, or NULL on allocation failure.
+ **/
+state_writer_t *state_writer_new(unsigned max_workers);
+
+/**
+ * state_writer_free:
+ *
+ * Waits for all queued writes, then frees @writer.
+ **/
+void state_writer_free(state_writer_t *writer);
+
+/**
+ * state_writer_submit:
+ * @writer      : Writer.
+ * @path        : File to write.
+ * @data        : State, allocated with malloc(). The writer takes
+ *                ownership of it, also on failure.
+ * @len         : Size of @data.
+ * @flags       : Bitmask of enum state_writer_flags.
+ * @sync        : enum state_writer_sync policy for this write.
+ *
+ * Returns: ticket to poll the write with, 0 on failure or when
+ * STATE_WRITER_FLAG_DETACH is set.
+ **/
+uint32_t state_writer_submit(state_writer_t *writer, const char *path,
+      void *data, size_t len, unsigned flags, enum state_writer_sync sync);
+
+/**
+ * state_writer_poll:
+ *
+ * Returns: status of the write behind @ticket. Once a final status
+ * has been returned, the ticket is forgotten and polls as
+ * STATE_WRITER_STATUS_UNKNOWN.
+ **/
+enum state_writer_status state_writer_poll(state_writer_t *writer,
+      uint32_t ticket);
+
+/**
+ * state_writer_pending:
+ * @path        : File to check, NULL for any.
+ *
+ * Returns: true if a write to @path is queued or in progress.
+ **/
+bool state_writer_pending(state_writer_t *writer, const char *path);
+
+/**
+ * state_writer_wait:
+ * @path        : File to wait for, NULL for all.
+ *
+ * Blocks until no write to @path is queued or in progress.
+ **/
+void state_writer_wait(state_writer_t *writer, const char *path);
+
+/**
+ * state_writer_copy_pending:
+ * @path        : File to look up.
+ * @len         : Set to the size of the returned copy.
+ *
+ * Returns: malloc()ed copy of the latest state submitted for @path
+ * that is not written yet, or NULL if there is none.
+ **/
+void *state_writer_copy_pending(state_writer_t *writer, const char *path,
+      size_t *len);
+
+/**
+ * state_writer_sync_path:
+ * @path        : Closed file or directory.
+ * @is_dir      : Whether @path is a directory.
+ *
+ * Flushes @path to storage. Platforms without a way to do so rely
+ * on the OS.
+ **/
+void state_writer_sync_path(const char *path, bool is_dir);
+
+RETRO_END_DECLS
+
+#endif
@@ -32,6 +32,7 @@
 #include "../verbosity.h"
 #include "../input/input_driver.h"
 #include "../input/input_remapping.h"
+#include "../input/input_autodetect_index.h"
 
 #include "tasks_internal.h"
 #ifdef HAVE_BLISSBOX
@@ -55,6 +56,7 @@ typedef struct
 {
    char *dir_autoconfig;
    char *dir_driver_autoconfig;
+   char *dir_cache;
    config_file_t *autoconfig_file;
    unsigned port;
    input_device_info_t device_info; /* unsigned alignment */
@@ -82,6 +84,12 @@ static void free_autoconfig_handle(autoconfig_handle_t *autoconfig_handle)
       autoconfig_handle->dir_driver_autoconfig = NULL;
    }
 
+   if (autoconfig_handle->dir_cache)
+   {
+      free(autoconfig_handle->dir_cache);
+      autoconfig_handle->dir_cache = NULL;
+   }
+
    if (autoconfig_handle->autoconfig_file)
    {
       config_file_free(autoconfig_handle->autoconfig_file);
@@ -251,6 +259,57 @@ static void input_autoconfigure_set_config_file(
    autoconfig_handle->device_info.autoconfigured = true;
 }
 
+/* Looks up the connected input device in the
+ * profile index of the specified autoconfig directory
+ * > Returns the number of config files in the
+ *   directory, or INPUT_AUTODETECT_INDEX_NONE if
+ *   it has to be scanned instead */
+static size_t input_autoconfigure_find_config_file_indexed(
+      autoconfig_handle_t *autoconfig_handle,
+      const char *dir, bool *match_found)
+{
+   input_autodetect_device_t device;
+   config_file_t *config = NULL;
+   unsigned affinity     = 0;
+   size_t num_files      = 0;
+
+   device.name = autoconfig_handle->device_info.name;
+   device.phys = autoconfig_handle->device_info.phys;
+   device.vid  = autoconfig_handle->device_info.vid;
+   device.pid  = autoconfig_handle->device_info.pid;
+
+#ifdef HAVE_BLISSBOX
+   /* > Bliss-Box devices never match on VID+PID,
+    *   see input_autoconfigure_get_config_file_affinity() */
+   if (     (device.vid == BLISSBOX_VID)
+         || (device.pid == BLISSBOX_PID))
+   {
+      device.vid = 0;
+      device.pid = 0;
+   }
+#endif
+
+   num_files = input_autodetect_index_find(dir,
+         autoconfig_handle->dir_cache, &device, &config, &affinity);
+
+   if (config)
+   {
+      input_autoconfigure_set_config_file(
+            autoconfig_handle, config, affinity % 10);
+      *match_found = true;
+   }
+
+   if (num_files != INPUT_AUTODETECT_INDEX_NONE && num_files > 0)
+      RARCH_DBG("[Autoconf] Profile index searched: driver %s, pad name %s (%04x/%04x), phys %s, affinity %d\n",
+                autoconfig_handle->device_info.joypad_driver,
+                autoconfig_handle->device_info.name,
+                autoconfig_handle->device_info.vid, autoconfig_handle->device_info.pid,
+                autoconfig_handle->device_info.phys,
+                affinity);
+
+   return num_files;
+}
+
 /* Attempts to find an 'external' autoconfig file
  * (in the autoconfig directory) matching the connected
  * input device
@@ -262,6 +321,24 @@ static bool input_autoconfigure_scan_config_files_external(
    const char *dir_driver_autoconfig    = autoconfig_handle->dir_driver_autoconfig;
    struct string_list *config_file_list = NULL;
    unsigned max_affinity                = 0;
+   size_t num_files                     = 0;
+   bool index_match_found               = false;
+
+   /* Use the profile indexes where available, same
+    * directory order as below */
+   if (  !string_is_empty(dir_driver_autoconfig)
+       && path_is_directory(dir_driver_autoconfig))
+      num_files = input_autoconfigure_find_config_file_indexed(
+            autoconfig_handle, dir_driver_autoconfig, &index_match_found);
+
+   if (     num_files == 0
+         && !string_is_empty(dir_autoconfig)
+         && path_is_directory(dir_autoconfig))
+      num_files = input_autoconfigure_find_config_file_indexed(
+            autoconfig_handle, dir_autoconfig, &index_match_found);
+
+   if (num_files != INPUT_AUTODETECT_INDEX_NONE)
+      return index_match_found;
 
    /* Attempt to fetch file listing from driver-specific
     * autoconfig directory */
@@ -848,6 +925,8 @@ bool input_autoconfigure_connect(
          settings->bools.input_autodetect_enable : false;
    const char *dir_autoconfig             = settings ?
          settings->paths.directory_autoconfig : NULL;
+   const char *dir_cache                  = settings ?
+         settings->paths.directory_cache : NULL;
    bool notification_show_autoconfig      = settings ?
          settings->bools.notification_show_autoconfig : true;
    bool notification_show_autoconfig_fails = settings ?
@@ -887,6 +966,7 @@ bool input_autoconfigure_connect(
       autoconfig_handle->flags |= AUTOCONF_FLAG_SUPPRESS_FAILURE_NOTIF;
    autoconfig_handle->dir_autoconfig               = NULL;
    autoconfig_handle->dir_driver_autoconfig        = NULL;
+   autoconfig_handle->dir_cache                    = NULL;
    autoconfig_handle->autoconfig_file              = NULL;
 
    if (!string_is_empty(name))
@@ -931,6 +1011,9 @@ bool input_autoconfigure_connect(
       }
    }
 
+   if (!string_is_empty(dir_cache))
+      autoconfig_handle->dir_cache = strdup(dir_cache);
+
 #ifdef HAVE_BLISSBOX
    /* Bliss-Box shenanigans... */
    if (autoconfig_handle->device_info.vid == BLISSBOX_VID)
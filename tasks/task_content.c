@@ -58,6 +58,9 @@
 #include <lists/string_list.h>
 #include <lists/dir_list.h>
 #include <vfs/vfs_implementation.h>
+#ifdef HAVE_VFS_ARCHIVE
+#include <vfs/vfs_implementation_archive.h>
+#endif
 #include <array/rbuf.h>
 
 #include <retro_miscellaneous.h>
@@ -84,6 +87,7 @@
 #include "../command.h"
 #include "../core_info.h"
 #include "../content.h"
+#include "../content_cache.h"
 #include "../core.h"
 #include "../configuration.h"
 #include "../defaults.h"
@@ -668,23 +672,39 @@ static size_t content_file_load_into_memory(
 {
    uint8_t *content_data = NULL;
    int64_t content_size  = 0;
+   settings_t *settings  = config_get_ptr();
 
    RARCH_LOG("[Content] %s: \"%s\".\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), content_path);
 
-   /* Read content from file into memory buffer */
-#ifdef HAVE_COMPRESSION
-   if (content_compressed)
-   {
-      if (!file_archive_compressed_read(content_path,
-            (void**)&content_data, NULL, &content_size))
-         return 0;
-   }
+   content_cache_set_limits(
+         (size_t)settings->uints.content_cache_size << 20,
+         settings->bools.content_cache_compress);
+
+   /* Read content from the cache, or from file
+    * into memory buffer */
+   if (content_cache_get(content_path,
+            (void**)&content_data, &content_size))
+      RARCH_LOG("[Content] Loaded from content cache.\n");
    else
+   {
+#ifdef HAVE_COMPRESSION
+      if (content_compressed)
+      {
+         if (!file_archive_compressed_read(content_path,
+               (void**)&content_data, NULL, &content_size))
+            return 0;
+      }
+      else
 #endif
-      if (!filestream_read_file(content_path,
-            (void**)&content_data, &content_size))
-         return 0;
+         if (!filestream_read_file(content_path,
+               (void**)&content_data, &content_size))
+            return 0;
+
+      /* Cache the content as read, before any patching */
+      if (content_size > 0)
+         content_cache_put(content_path, content_data, content_size);
+   }
 
    if (content_size < 0)
       return 0;
@@ -721,12 +741,18 @@ static size_t content_file_load_into_memory(
           * In all other cases, cache the content path
           * and defer CRC calculation until the value is
           * actually needed */
-         if (content_compressed || has_patch)
+         if (     !has_patch
+               && content_cache_get_crc(content_path, &p_content->rom_crc))
+            RARCH_LOG("[Content] CRC32: 0x%x.\n",
+                  (unsigned)p_content->rom_crc);
+         else if (content_compressed || has_patch)
          {
             p_content->rom_crc = encoding_crc32(0, content_data,
                   (size_t)content_size);
             RARCH_LOG("[Content] CRC32: 0x%x.\n",
                   (unsigned)p_content->rom_crc);
+            if (!has_patch)
+               content_cache_set_crc(content_path, p_content->rom_crc);
          }
          else
          {
@@ -795,6 +821,29 @@ static bool content_file_extract_from_archive(
 
    return true;
 }
+
+#ifdef HAVE_VFS_ARCHIVE
+/* Cores reading files through the VFS interface can be
+ * given the path inside a zip archive as is, see
+ * vfs_implementation_archive.c */
+static bool content_file_mount_archive(const char *content_path)
+{
+   settings_t *settings          = config_get_ptr();
+   rarch_system_info_t *sys_info = &runloop_state_get_ptr()->system;
+
+   if (   !settings->bools.archive_vfs_mount
+       || !sys_info->supports_vfs
+       || !retro_vfs_path_is_archive_member(content_path)
+       || !(retro_vfs_stat_impl(content_path, NULL) & RETRO_VFS_STAT_IS_VALID))
+      return false;
+
+   /* TODO/FIXME - localize */
+   RARCH_LOG("[Content] Core reads content through VFS - "
+         "reading archive in place: \"%s\".\n", content_path);
+
+   return true;
+}
+#endif
 #endif
 
 static void content_file_get_path(
@@ -988,9 +1037,13 @@ static bool content_file_load(
          {
 #ifdef HAVE_COMPRESSION
             /* If this is compressed content and need_fullpath
-             * is true, extract it to a temporary file */
+             * is true, extract it to a temporary file, unless
+             * the core can read it in place */
             if (    content_compressed
                 && !((content->elems[i].attr.i & BLCK_BLOCK_EXTRACT) != 0)
+#ifdef HAVE_VFS_ARCHIVE
+                && !content_file_mount_archive(content_path)
+#endif
                 && !content_file_extract_from_archive(content_ctx, p_content,
                      valid_exts, &content_path, err_string))
                return false;
@@ -2965,6 +3018,8 @@ uint32_t content_get_crc(void)
             (const char*)p_content->pending_rom_crc_path);
       RARCH_LOG("[Content] CRC32: 0x%x.\n",
             (unsigned)p_content->rom_crc);
+      content_cache_set_crc(p_content->pending_rom_crc_path,
+            p_content->rom_crc);
    }
    return p_content->rom_crc;
 }
@@ -2985,6 +3040,7 @@ void content_deinit(void)
 {
    content_state_t *p_content = content_state_get_ptr();
 
+   content_state_writer_deinit();
    content_file_override_free(p_content);
    content_file_list_free(p_content->content_list);
 
@@ -3094,6 +3150,9 @@ bool content_init(void)
 
    p_content->flags |= CONTENT_ST_FLAG_IS_INITED;
 
+   /* States can be saved and loaded from here on */
+   content_state_writer_init();
+
    if (string_list_initialize(&content))
    {
       if (!content_file_init(&content_ctx, p_content,
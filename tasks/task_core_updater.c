@@ -38,6 +38,10 @@
 #include "../verbosity.h"
 #include "../core_updater_list.h"
 
+#ifdef HAVE_ZSTD
+#include "../core_updater_delta.h"
+#endif
+
 #if defined(ANDROID)
 #include "../file_path_special.h"
 #include "../play_feature_delivery/play_feature_delivery.h"
@@ -74,6 +78,9 @@ enum core_updater_download_status
    CORE_UPDATER_DOWNLOAD_BEGIN = 0,
    CORE_UPDATER_DOWNLOAD_START_BACKUP,
    CORE_UPDATER_DOWNLOAD_WAIT_BACKUP,
+   CORE_UPDATER_DOWNLOAD_START_DELTA,
+   CORE_UPDATER_DOWNLOAD_WAIT_DELTA,
+   CORE_UPDATER_DOWNLOAD_APPLY_DELTA,
    CORE_UPDATER_DOWNLOAD_START_TRANSFER,
    CORE_UPDATER_DOWNLOAD_WAIT_TRANSFER,
    CORE_UPDATER_DOWNLOAD_WAIT_DECOMPRESS,
@@ -89,6 +96,7 @@ typedef struct core_updater_download_handle
    char *remote_core_path;
    char *local_download_path;
    char *local_core_path;
+   char *local_delta_path;
    char *display_name;
    retro_task_t *http_task;
    retro_task_t *decompress_task;
@@ -104,6 +112,7 @@ typedef struct core_updater_download_handle
    bool decompress_task_finished;
    bool decompress_task_complete;
    bool backup_enabled;
+   bool delta_enabled;
 } core_updater_download_handle_t;
 
 /* Update installed cores */
@@ -639,6 +648,35 @@ finish:
       download_handle->decompress_task_complete = true;
 }
 
+#ifdef HAVE_ZSTD
+static void cb_http_task_core_updater_download_delta(
+      retro_task_t *task, void *task_data,
+      void *user_data, const char *err)
+{
+   http_transfer_data_t *data                      = (http_transfer_data_t*)task_data;
+   file_transfer_t *transf                         = (file_transfer_t*)user_data;
+   core_updater_download_handle_t *download_handle = NULL;
+
+   if (!transf)
+      return;
+
+   if ((download_handle = (core_updater_download_handle_t*)transf->user_data))
+   {
+      /* A missing delta is not an error, the
+       * full archive is downloaded instead */
+      if (     !data
+            || !data->data
+            || (data->status != 200)
+            || !filestream_write_file(transf->path, data->data, data->len))
+         download_handle->delta_enabled = false;
+
+      download_handle->http_task_complete = true;
+   }
+
+   free(transf);
+}
+#endif
+
 static void free_core_updater_download_handle(core_updater_download_handle_t *download_handle)
 {
    if (download_handle->path_dir_libretro)
@@ -659,6 +697,9 @@ static void free_core_updater_download_handle(core_updater_download_handle_t *do
    if (download_handle->local_core_path)
       free(download_handle->local_core_path);
 
+   if (download_handle->local_delta_path)
+      free(download_handle->local_delta_path);
+
    if (download_handle->display_name)
       free(download_handle->display_name);
 
@@ -666,6 +707,57 @@ static void free_core_updater_download_handle(core_updater_download_handle_t *do
    download_handle = NULL;
 }
 
+/* Once any backup is done, a delta from the installed
+ * build is tried first if one may exist */
+static enum core_updater_download_status
+task_core_updater_download_transfer_status(
+      const core_updater_download_handle_t *download_handle)
+{
+#ifdef HAVE_ZSTD
+   if (download_handle->delta_enabled)
+      return CORE_UPDATER_DOWNLOAD_START_DELTA;
+#endif
+   return CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+}
+
+static void task_core_updater_download_wait_http(retro_task_t *task,
+      core_updater_download_handle_t *download_handle)
+{
+   /* If HTTP task is NULL, then it either finished
+    * or an error occurred - in either case,
+    * just move on to the next state */
+   if (!download_handle->http_task)
+      download_handle->http_task_complete = true;
+   /* Otherwise, check if HTTP task is still running */
+   else if (!download_handle->http_task_finished)
+   {
+      uint8_t _flg = task_get_flags(download_handle->http_task);
+
+      if ((_flg & RETRO_TASK_FLG_FINISHED) > 0)
+         download_handle->http_task_finished = true;
+      else
+         download_handle->http_task_finished = false;
+
+      /* If HTTP task is running, copy current
+       * progress value to *this* task */
+      if (!download_handle->http_task_finished)
+      {
+         /* > If backups are enabled, download accounts
+          *   for second third of task progress
+          * > Otherwise, download accounts for first half
+          *   of task progress */
+         int8_t progress = task_get_progress(download_handle->http_task);
+
+         if (download_handle->backup_enabled)
+            progress = (int8_t)(((float)progress * (1.0f / 3.0f)) + (100.0f / 3.0f) + 0.5f);
+         else
+            progress = progress >> 1;
+
+         task_set_progress(task, progress);
+      }
+   }
+}
+
 static void task_core_updater_download_handler(retro_task_t *task)
 {
    uint8_t flg;
@@ -715,9 +807,16 @@ static void task_core_updater_download_handler(retro_task_t *task)
             download_handle->backup_enabled = download_handle->auto_backup &&
                   path_is_valid(download_handle->local_core_path);
 
+#ifdef HAVE_ZSTD
+            /* A delta can only be published against a known build */
+            download_handle->delta_enabled  = (download_handle->local_crc != 0)
+                  && (download_handle->remote_crc != 0)
+                  && path_is_valid(download_handle->local_core_path);
+#endif
+
             download_handle->status = download_handle->backup_enabled ?
                   CORE_UPDATER_DOWNLOAD_START_BACKUP :
-                        CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+                        task_core_updater_download_transfer_status(download_handle);
          }
          break;
       case CORE_UPDATER_DOWNLOAD_START_BACKUP:
@@ -756,7 +855,8 @@ static void task_core_updater_download_handler(retro_task_t *task)
                RARCH_ERR("[Core Updater] Failed to backup core: \"%s\".\n",
                      download_handle->local_core_path);
                download_handle->backup_enabled = false;
-               download_handle->status         = CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+               download_handle->status         =
+                     task_core_updater_download_transfer_status(download_handle);
             }
          }
          break;
@@ -795,31 +895,50 @@ static void task_core_updater_download_handler(retro_task_t *task)
             if (backup_complete)
             {
                download_handle->backup_task = NULL;
-               download_handle->status      = CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+               download_handle->status      =
+                     task_core_updater_download_transfer_status(download_handle);
             }
          }
          break;
-      case CORE_UPDATER_DOWNLOAD_START_TRANSFER:
+#ifdef HAVE_ZSTD
+      case CORE_UPDATER_DOWNLOAD_START_DELTA:
          {
             size_t _len;
             file_transfer_t *transf = NULL;
+            char delta_url[PATH_MAX_LENGTH];
             char task_title[128];
 
+            if (!core_updater_delta_get_url(delta_url, sizeof(delta_url),
+                     download_handle->remote_core_path,
+                     download_handle->local_crc,
+                     download_handle->remote_crc))
+            {
+               download_handle->delta_enabled = false;
+               download_handle->status        = CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+               break;
+            }
+
             /* Configure file transfer object */
             if (!(transf = (file_transfer_t*)calloc(1,
                         sizeof(file_transfer_t))))
                goto task_finished;
 
             strlcpy(
-                  transf->path, download_handle->local_download_path,
+                  transf->path, download_handle->local_delta_path,
                   sizeof(transf->path));
 
             transf->user_data = (void*)download_handle;
 
             /* Push HTTP transfer task */
             download_handle->http_task = (retro_task_t*)task_push_http_transfer_file(
-                  download_handle->remote_core_path, true, NULL,
-                  cb_http_task_core_updater_download, transf);
+                  delta_url, true, NULL,
+                  cb_http_task_core_updater_download_delta, transf);
+
+            if (!download_handle->http_task)
+            {
+               free(transf);
+               download_handle->delta_enabled = false;
+            }
 
             /* Update task title */
             task_free_title(task);
@@ -832,44 +951,109 @@ static void task_core_updater_download_handler(retro_task_t *task)
             task_set_title(task, strdup(task_title));
 
             /* Start waiting for HTTP transfer to complete */
-            download_handle->status = CORE_UPDATER_DOWNLOAD_WAIT_TRANSFER;
+            download_handle->status = CORE_UPDATER_DOWNLOAD_WAIT_DELTA;
          }
          break;
-      case CORE_UPDATER_DOWNLOAD_WAIT_TRANSFER:
+      case CORE_UPDATER_DOWNLOAD_WAIT_DELTA:
          {
-            /* If HTTP task is NULL, then it either finished
-             * or an error occurred - in either case,
-             * just move on to the next state */
-            if (!download_handle->http_task)
-               download_handle->http_task_complete = true;
-            /* Otherwise, check if HTTP task is still running */
-            else if (!download_handle->http_task_finished)
+            task_core_updater_download_wait_http(task, download_handle);
+
+            /* Wait for task_push_http_transfer_file()
+             * callback to trigger */
+            if (download_handle->http_task_complete)
             {
-               uint8_t _flg = task_get_flags(download_handle->http_task);
+               /* Full archive is downloaded by a new HTTP task */
+               download_handle->http_task          = NULL;
+               download_handle->http_task_finished = false;
+               download_handle->http_task_complete = false;
+
+               download_handle->status = download_handle->delta_enabled ?
+                     CORE_UPDATER_DOWNLOAD_APPLY_DELTA :
+                           CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+            }
+         }
+         break;
+      case CORE_UPDATER_DOWNLOAD_APPLY_DELTA:
+         {
+            size_t _len;
+            char task_title[128];
 
-               if ((_flg & RETRO_TASK_FLG_FINISHED) > 0)
-                  download_handle->http_task_finished = true;
-               else
-                  download_handle->http_task_finished = false;
+            /* Update task title */
+            task_free_title(task);
 
-               /* If HTTP task is running, copy current
-                * progress value to *this* task */
-               if (!download_handle->http_task_finished)
-               {
-                  /* > If backups are enabled, download accounts
-                   *   for second third of task progress
-                   * > Otherwise, download accounts for first half
-                   *   of task progress */
-                  int8_t progress = task_get_progress(download_handle->http_task);
+            _len = strlcpy(
+                  task_title, msg_hash_to_str(MSG_EXTRACTING_CORE),
+                  sizeof(task_title));
+            strlcpy(task_title + _len, download_handle->display_name, sizeof(task_title) - _len);
 
-                  if (download_handle->backup_enabled)
-                     progress = (int8_t)(((float)progress * (1.0f / 3.0f)) + (100.0f / 3.0f) + 0.5f);
-                  else
-                     progress = progress >> 1;
+            task_set_title(task, strdup(task_title));
 
-                  task_set_progress(task, progress);
-               }
+            /* Rebuilt core is checked against the CRC of the
+             * list entry, anything else keeps the installed
+             * core and falls back to the full archive */
+            if (core_updater_delta_apply(
+                     download_handle->local_core_path,
+                     download_handle->local_delta_path,
+                     download_handle->local_core_path,
+                     download_handle->remote_crc))
+            {
+               RARCH_LOG("[Core Updater] Updated \"%s\" from delta %08lx-%08lx.\n",
+                     download_handle->local_core_path,
+                     (unsigned long)download_handle->local_crc,
+                     (unsigned long)download_handle->remote_crc);
+               download_handle->status = CORE_UPDATER_DOWNLOAD_END;
             }
+            else
+            {
+               RARCH_WARN("[Core Updater] Delta update of \"%s\" failed, downloading full core.\n",
+                     download_handle->local_core_path);
+               download_handle->delta_enabled = false;
+               download_handle->status        = CORE_UPDATER_DOWNLOAD_START_TRANSFER;
+            }
+
+            filestream_delete(download_handle->local_delta_path);
+         }
+         break;
+#endif
+      case CORE_UPDATER_DOWNLOAD_START_TRANSFER:
+         {
+            size_t _len;
+            file_transfer_t *transf = NULL;
+            char task_title[128];
+
+            /* Configure file transfer object */
+            if (!(transf = (file_transfer_t*)calloc(1,
+                        sizeof(file_transfer_t))))
+               goto task_finished;
+
+            strlcpy(
+                  transf->path, download_handle->local_download_path,
+                  sizeof(transf->path));
+
+            transf->user_data = (void*)download_handle;
+
+            /* Push HTTP transfer task */
+            download_handle->http_task = (retro_task_t*)task_push_http_transfer_file(
+                  download_handle->remote_core_path, true, NULL,
+                  cb_http_task_core_updater_download, transf);
+
+            /* Update task title */
+            task_free_title(task);
+
+            _len = strlcpy(
+                  task_title, msg_hash_to_str(MSG_DOWNLOADING_CORE),
+                  sizeof(task_title));
+            strlcpy(task_title + _len, download_handle->display_name, sizeof(task_title) - _len);
+
+            task_set_title(task, strdup(task_title));
+
+            /* Start waiting for HTTP transfer to complete */
+            download_handle->status = CORE_UPDATER_DOWNLOAD_WAIT_TRANSFER;
+         }
+         break;
+      case CORE_UPDATER_DOWNLOAD_WAIT_TRANSFER:
+         {
+            task_core_updater_download_wait_http(task, download_handle);
 
             /* Wait for task_push_http_transfer_file()
              * callback to trigger */
@@ -1008,6 +1192,7 @@ void *task_push_core_updater_download(
    task_finder_data_t find_data;
    char task_title[128];
    char local_download_path[PATH_MAX_LENGTH];
+   char local_delta_path[PATH_MAX_LENGTH];
    const core_updater_list_entry_t *list_entry     = NULL;
    retro_task_t *task                              = NULL;
    core_updater_download_handle_t *download_handle = (core_updater_download_handle_t*)
@@ -1015,6 +1200,7 @@ void *task_push_core_updater_download(
 
    task_title[0]          = '\0';
    local_download_path[0] = '\0';
+   local_delta_path[0]    = '\0';
 
 #if defined(ANDROID)
    /* Regular core updater is disabled in
@@ -1072,6 +1258,12 @@ void *task_push_core_updater_download(
          list_entry->remote_filename,
          sizeof(local_download_path));
 
+   /* Delta is downloaded next to the core it patches */
+   _len = strlcpy(local_delta_path, list_entry->local_core_path,
+         sizeof(local_delta_path));
+   strlcpy(local_delta_path + _len, ".zst",
+         sizeof(local_delta_path) - _len);
+
    /* Configure handle */
    download_handle->auto_backup              = auto_backup;
    download_handle->auto_backup_history_size = auto_backup_history_size;
@@ -1081,6 +1273,7 @@ void *task_push_core_updater_download(
    download_handle->remote_core_path         = strdup(list_entry->remote_core_path);
    download_handle->local_download_path      = strdup(local_download_path);
    download_handle->local_core_path          = strdup(list_entry->local_core_path);
+   download_handle->local_delta_path         = strdup(local_delta_path);
    download_handle->display_name             = strdup(list_entry->display_name);
    download_handle->local_crc                = crc;
    download_handle->remote_crc               = list_entry->crc;
@@ -1092,6 +1285,7 @@ void *task_push_core_updater_download(
    download_handle->decompress_task_finished = false;
    download_handle->decompress_task_complete = false;
    download_handle->backup_enabled           = false;
+   download_handle->delta_enabled            = false;
    download_handle->backup_task              = NULL;
    download_handle->status                   = CORE_UPDATER_DOWNLOAD_BEGIN;
 
@@ -0,0 +1,548 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <array/rbuf.h>
+#include <array/rhmap.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <retro_endianness.h>
+#include <string/stdstring.h>
+#include <vfs/vfs_implementation.h>
+
+#include "tasks_internal.h"
+
+#include "../file_path_special.h"
+#include "../library_search.h"
+#include "../playlist.h"
+#include "../verbosity.h"
+#include "../menu/menu_driver.h"
+#ifdef HAVE_LIBRETRODB
+#include "../libretro-db/libretrodb.h"
+#endif
+
+typedef struct library_search_handle
+{
+   /* Index the menu currently searches, only read from here */
+   const library_search_t *current;
+   library_search_t *index;
+   char *directory_playlist;
+   char *directory_database;
+   char *directory_cache;
+   bool changed;
+} library_search_handle_t;
+
+/*********************/
+/* Utility Functions */
+/*********************/
+
+static void library_search_cache_path(char *s, size_t len,
+      const char *directory_playlist, const char *directory_cache)
+{
+   char name[32];
+   snprintf(name, sizeof(name), "library-%08x.idx",
+         (unsigned)encoding_crc32(0, (const uint8_t*)directory_playlist,
+            strlen(directory_playlist)));
+   fill_pathname_join_special(s, directory_cache, name, len);
+}
+
+static void free_library_search_handle(library_search_handle_t *handle)
+{
+   if (!handle)
+      return;
+
+   free(handle->directory_playlist);
+   free(handle->directory_database);
+   free(handle->directory_cache);
+   library_search_free(handle->index);
+   free(handle);
+}
+
+/* Appends " @s" to the text of an entry */
+static void library_search_text_append(char **text, const char *s)
+{
+   size_t _len, add;
+   char *tmp;
+
+   if (string_is_empty(s))
+      return;
+
+   _len = *text ? strlen(*text) : 0;
+   add  = strlen(s);
+   if (!(tmp = (char*)realloc(*text, _len + add + 2)))
+      return;
+   tmp[_len] = ' ';
+   memcpy(tmp + _len + 1, s, add + 1);
+   *text     = tmp;
+}
+
+#ifdef HAVE_LIBRETRODB
+/* Adds the metadata the database @db_name has for entries of
+ * @playlist to their text. Entries are matched by CRC, or by name
+ * when they have none, the same way as the explore menu */
+static void library_search_add_metadata(playlist_t *playlist,
+      const char *db_name, const char *directory_database, char **texts)
+{
+   static const char *keys[] = {
+      "developer", "publisher", "genre", "franchise", "releaseyear" };
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   struct rmsgpack_dom_value item;
+   char *ext_path               = NULL;
+   uint32_t *by_crc             = NULL;
+   uint32_t *by_name            = NULL;
+   libretrodb_t *db             = NULL;
+   libretrodb_cursor_t *cur     = NULL;
+   size_t remaining             = 0;
+   bool more                    = false;
+
+   for (i = 0; i < playlist_size(playlist); i++)
+   {
+      uint32_t crc32;
+      const struct playlist_entry *entry = NULL;
+
+      playlist_get_index(playlist, i, &entry);
+      if (     !entry
+            || string_is_empty(entry->label)
+            || !string_is_equal_case_insensitive(
+               entry->db_name ? entry->db_name : "", db_name))
+         continue;
+
+      /* Indices are stored plus one, so that zero means none */
+      if ((crc32 = (uint32_t)strtoul(entry->crc32 ? entry->crc32 : "",
+                  NULL, 16)))
+         RHMAP_SET(by_crc, crc32, (uint32_t)i + 1);
+      else
+         RHMAP_SET_STR(by_name, entry->label, (uint32_t)i + 1);
+      remaining++;
+   }
+
+   if (!remaining)
+      goto end;
+
+   fill_pathname_join_special(path, directory_database, db_name,
+         sizeof(path));
+   /* Replace the extension - change 'lpl' to 'rdb' */
+   if (     (ext_path = path_get_extension_mutable(path))
+         && ext_path[0] == '.'
+         && ext_path[1] == 'l'
+         && ext_path[2] == 'p'
+         && ext_path[3] == 'l')
+   {
+      ext_path[1] = 'r';
+      ext_path[2] = 'd';
+      ext_path[3] = 'b';
+   }
+
+   if (!(db = libretrodb_new()))
+      goto end;
+   if (libretrodb_open(path, db, false) != 0)
+   {
+      libretrodb_free(db);
+      db = NULL;
+      goto end;
+   }
+   if (!(cur = libretrodb_cursor_new()))
+      goto end;
+
+   more = (   libretrodb_cursor_open(db, cur, NULL) == 0
+           && libretrodb_cursor_read_item(cur, &item) == 0);
+
+   for (; more; more = (rmsgpack_dom_value_free(&item),
+            libretrodb_cursor_read_item(cur, &item) == 0))
+   {
+      size_t k;
+      char year[16];
+      const char *fields[ARRAY_SIZE(keys)];
+      uint32_t crc32    = 0;
+      uint32_t idx      = 0;
+      const char *name  = NULL;
+
+      if (item.type != RDT_MAP)
+         continue;
+
+      for (k = 0; k < ARRAY_SIZE(keys); k++)
+         fields[k] = NULL;
+
+      for (k = 0; k < item.val.map.len; k++)
+      {
+         size_t f;
+         const char *key_str;
+         struct rmsgpack_dom_value *key = &item.val.map.items[k].key;
+         struct rmsgpack_dom_value *val = &item.val.map.items[k].value;
+
+         if (key->type != RDT_STRING)
+            continue;
+         key_str = key->val.string.buff;
+
+         if (string_is_equal(key_str, "crc"))
+         {
+            if (val->type == RDT_BINARY && val->val.binary.len == 4)
+               crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
+            continue;
+         }
+         if (string_is_equal(key_str, "name"))
+         {
+            if (val->type == RDT_STRING)
+               name = val->val.string.buff;
+            continue;
+         }
+
+         for (f = 0; f < ARRAY_SIZE(keys); f++)
+         {
+            if (!string_is_equal(key_str, keys[f]))
+               continue;
+            if (val->type == RDT_STRING)
+               fields[f] = val->val.string.buff;
+            else if (val->type == RDT_INT || val->type == RDT_UINT)
+            {
+               snprintf(year, sizeof(year), "%d", (int)val->val.int_);
+               fields[f] = year;
+            }
+            break;
+         }
+      }
+
+      /* Each entry takes the first record found for it */
+      if (crc32 && (idx = RHMAP_GET(by_crc, crc32)))
+         RHMAP_SET(by_crc, crc32, 0);
+      else if (name && (idx = RHMAP_GET_STR(by_name, name)))
+         RHMAP_SET_STR(by_name, name, 0);
+      if (!idx || idx > playlist_size(playlist))
+         continue;
+
+      for (k = 0; k < ARRAY_SIZE(keys); k++)
+         library_search_text_append(&texts[idx - 1], fields[k]);
+
+      /* Stop once every entry has been found */
+      if (--remaining == 0)
+      {
+         rmsgpack_dom_value_free(&item);
+         break;
+      }
+   }
+
+end:
+   if (cur)
+   {
+      libretrodb_cursor_close(cur);
+      libretrodb_cursor_free(cur);
+   }
+   if (db)
+   {
+      libretrodb_close(db);
+      libretrodb_free(db);
+   }
+   RHMAP_FREE(by_crc);
+   RHMAP_FREE(by_name);
+}
+#endif
+
+static library_search_segment_t *library_search_build_segment(
+      const char *path, int64_t stamp, int64_t size,
+      const char *directory_database)
+{
+   size_t i, count;
+   playlist_config_t playlist_config;
+   library_search_segment_t *segment = NULL;
+   library_search_doc_t *docs        = NULL;
+   char **texts                      = NULL;
+   playlist_t *playlist              = NULL;
+
+   playlist_config.path[0]                   = '\0';
+   playlist_config.base_content_directory[0] = '\0';
+   playlist_config.capacity                  = COLLECTION_SIZE;
+   playlist_config.old_format                = false;
+   playlist_config.compress                  = false;
+   playlist_config.fuzzy_archive_match       = false;
+   playlist_config.autofix_paths             = false;
+   playlist_config_set_path(&playlist_config, path);
+
+   /* Entry indices refer to the playlist as saved, never sort it */
+   if (!(playlist = playlist_init(&playlist_config)))
+      return NULL;
+
+   count = playlist_size(playlist);
+   docs  = (library_search_doc_t*)calloc(count + 1, sizeof(*docs));
+   texts = (char**)calloc(count + 1, sizeof(*texts));
+   if (!docs || !texts)
+      goto end;
+
+   for (i = 0; i < count; i++)
+   {
+      char name[NAME_MAX_LENGTH];
+      const struct playlist_entry *entry = NULL;
+
+      playlist_get_index(playlist, i, &entry);
+      if (!entry)
+         continue;
+
+      /* File name, core and system are searched as well */
+      if (!string_is_empty(entry->path))
+      {
+         fill_pathname(name, path_basename(entry->path), "", sizeof(name));
+         library_search_text_append(&texts[i], name);
+      }
+      if (     !string_is_empty(entry->core_name)
+            && !string_is_equal(entry->core_name, "DETECT"))
+         library_search_text_append(&texts[i], entry->core_name);
+      if (!string_is_empty(entry->db_name))
+      {
+         fill_pathname(name, entry->db_name, "", sizeof(name));
+         library_search_text_append(&texts[i], name);
+      }
+
+      if (!string_is_empty(entry->label))
+         docs[i].label  = entry->label;
+      else if (!string_is_empty(entry->path))
+         docs[i].label  = path_basename(entry->path);
+      docs[i].entry_idx = (uint32_t)i;
+   }
+
+#ifdef HAVE_LIBRETRODB
+   if (!string_is_empty(directory_database))
+   {
+      char **db_names = NULL;
+
+      for (i = 0; i < count; i++)
+      {
+         size_t j;
+         const struct playlist_entry *entry = NULL;
+
+         playlist_get_index(playlist, i, &entry);
+         if (!entry || string_is_empty(entry->db_name))
+            continue;
+         for (j = 0; j < RBUF_LEN(db_names); j++)
+            if (string_is_equal_case_insensitive(db_names[j], entry->db_name))
+               break;
+         if (j == RBUF_LEN(db_names))
+            RBUF_PUSH(db_names, entry->db_name);
+      }
+
+      for (i = 0; i < RBUF_LEN(db_names); i++)
+         library_search_add_metadata(playlist, db_names[i],
+               directory_database, texts);
+      RBUF_FREE(db_names);
+   }
+#endif
+
+   for (i = 0; i < count; i++)
+      docs[i].text = texts[i];
+
+   segment = library_search_segment_new(path, stamp, size, docs, count);
+
+end:
+   if (texts)
+      for (i = 0; i < count; i++)
+         free(texts[i]);
+   free(texts);
+   free(docs);
+   playlist_free(playlist);
+   return segment;
+}
+
+static void cb_task_library_search_update(
+      retro_task_t *task, void *task_data,
+      void *user_data, const char *err)
+{
+   library_search_handle_t *handle = NULL;
+
+   if (!task || !(handle = (library_search_handle_t*)task->state))
+      return;
+
+   if (handle->changed && handle->index)
+   {
+      menu_library_search_set_index(handle->index);
+      handle->index = NULL;
+   }
+}
+
+static void task_library_search_update_free(retro_task_t *task)
+{
+   if (task)
+      free_library_search_handle((library_search_handle_t*)task->state);
+}
+
+/*******************************/
+/* Library Search Index Update */
+/*******************************/
+
+static void task_library_search_update_handler(retro_task_t *task)
+{
+   library_search_handle_t *handle = NULL;
+   library_search_t *loaded        = NULL;
+   const library_search_t *base    = NULL;
+   libretro_vfs_implementation_dir *dir = NULL;
+   char cache_path[PATH_MAX_LENGTH];
+   size_t reused                   = 0;
+
+   if (!task)
+      return;
+
+   if (     !(handle = (library_search_handle_t*)task->state)
+         || (task_get_flags(task) & RETRO_TASK_FLG_CANCELLED)
+         || !(handle->index = library_search_new()))
+      goto end;
+
+   library_search_cache_path(cache_path, sizeof(cache_path),
+         handle->directory_playlist, handle->directory_cache);
+
+   /* Start from the index of the last run */
+   if (!(base = handle->current))
+      base = loaded = library_search_load(cache_path);
+
+   for (dir = retro_vfs_opendir_impl(handle->directory_playlist, false); dir;)
+   {
+      int64_t stamp, size;
+      char path[PATH_MAX_LENGTH];
+      library_search_segment_t *segment = NULL;
+      const char *fname                 = NULL;
+
+      if (!retro_vfs_readdir_impl(dir))
+      {
+         retro_vfs_closedir_impl(dir);
+         break;
+      }
+
+      fname = retro_vfs_dirent_get_name_impl(dir);
+      if (     !fname
+            || !string_ends_with_size(fname, FILE_PATH_LPL_EXTENSION,
+               strlen(fname), STRLEN_CONST(FILE_PATH_LPL_EXTENSION))
+            /* History and favourites only repeat other entries */
+            || string_ends_with_size(fname, "_history.lpl",
+               strlen(fname), STRLEN_CONST("_history.lpl"))
+            || string_is_equal(fname, FILE_PATH_CONTENT_FAVORITES))
+         continue;
+
+      fill_pathname_join_special(path, handle->directory_playlist, fname,
+            sizeof(path));
+      if (!path_get_stamp(path, &stamp, &size))
+         stamp = size = -1;
+
+      /* Taking a reference to a segment of the current index is
+       * safe: it is only ever released once this task is done */
+      segment = library_search_find(base, path);
+      if (library_search_segment_is_current(segment, stamp, size))
+      {
+         library_search_add(handle->index, segment);
+         reused++;
+         continue;
+      }
+
+      if ((segment = library_search_build_segment(path, stamp, size,
+                  handle->directory_database)))
+      {
+         library_search_add(handle->index, segment);
+         library_search_segment_free(segment);
+      }
+      handle->changed = true;
+   }
+
+   /* Any playlist removed? */
+   if (reused != library_search_num_segments(base))
+      handle->changed = true;
+
+   if (handle->changed && !string_is_empty(handle->directory_cache))
+   {
+      if (!path_is_directory(handle->directory_cache))
+         path_mkdir(handle->directory_cache);
+      if (!library_search_save(handle->index, cache_path))
+         RARCH_WARN("[Library Search] Failed to save \"%s\".\n",
+               cache_path);
+   }
+
+   /* Nothing is searched yet, hand over even an unchanged index */
+   if (!handle->current)
+      handle->changed = true;
+
+end:
+   library_search_free(loaded);
+   task_set_progress(task, 100);
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static bool task_library_search_update_finder(retro_task_t *task,
+      void *user_data)
+{
+   return (task && task->handler == task_library_search_update_handler);
+}
+
+bool task_push_library_search_update(const library_search_t *current,
+      const char *directory_playlist, const char *directory_database,
+      const char *directory_cache)
+{
+   task_finder_data_t find_data;
+   retro_task_t *task              = NULL;
+   library_search_handle_t *handle = NULL;
+
+   if (string_is_empty(directory_playlist))
+      return false;
+
+   /* The index is singular - one update at a time */
+   find_data.func     = task_library_search_update_finder;
+   find_data.userdata = NULL;
+
+   if (task_queue_find(&find_data))
+      return false;
+
+   task   = task_init();
+   handle = (library_search_handle_t*)calloc(1, sizeof(*handle));
+
+   if (!task || !handle)
+      goto error;
+
+   handle->current            = current;
+   handle->directory_playlist = strdup(directory_playlist);
+   handle->directory_database = strdup(
+         directory_database ? directory_database : "");
+   handle->directory_cache    = strdup(
+         directory_cache ? directory_cache : "");
+
+   /* Silent task, with no title and no user notification messages */
+   task->handler  = task_library_search_update_handler;
+   task->state    = handle;
+   task->title    = NULL;
+   task->progress = 0;
+   task->callback = cb_task_library_search_update;
+   task->cleanup  = task_library_search_update_free;
+   task->flags   |= RETRO_TASK_FLG_MUTE;
+
+   task_queue_push(task);
+
+   return true;
+
+error:
+   free(task);
+   free_library_search_handle(handle);
+   return false;
+}
+
+bool library_search_update_in_progress(void *data)
+{
+   task_finder_data_t find_data;
+
+   find_data.func     = task_library_search_update_finder;
+   find_data.userdata = NULL;
+
+   return task_queue_find(&find_data);
+}
+
+void library_search_wait_for_update_task(void)
+{
+   task_queue_wait(library_search_update_in_progress, NULL);
+}
@@ -20,6 +20,7 @@
 #include <time.h>
 
 #include <compat/strl.h>
+#include <features/features_cpu.h>
 #include <lists/string_list.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
@@ -46,6 +47,8 @@
 #include "../gfx/video_driver.h"
 #include "../msg_hash.h"
 #include "../runloop.h"
+#include "../state_store.h"
+#include "../state_writer.h"
 #include "../verbosity.h"
 #include "tasks_internal.h"
 
@@ -67,6 +70,11 @@
 #define SAVE_STATE_CHUNK 100 * 1024
 #endif
 
+/* State files written at the same time by the write-behind queue */
+#define SAVE_STATE_WRITERS 2
+/* How often a save task checks on its write */
+#define SAVE_STATE_POLL_USEC 5000
+
 #define RASTATE_VERSION 1
 #define RASTATE_MEM_BLOCK "MEM "
 #define RASTATE_CHEEVOS_BLOCK "ACHV"
@@ -115,6 +123,7 @@ typedef struct
    ssize_t written;
    ssize_t bytes_read;
    int state_slot;
+   uint32_t ticket;
    uint8_t flags;
    char path[PATH_MAX_LENGTH];
 } save_task_state_t;
@@ -135,6 +144,10 @@ static struct ram_save_state_buf ram_buf;
 
 static bool save_state_in_background       = false;
 
+/* Write-behind queue for state files, created and freed on the
+ * main thread along with the content */
+static state_writer_t *save_state_writer   = NULL;
+
 typedef struct rastate_size_info
 {
    size_t total_size;
@@ -311,8 +324,11 @@ static void task_save_handler_finished(retro_task_t *task,
 
    task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
 
-   intfstream_close(state->file);
-   free(state->file);
+   if (state->file)
+   {
+      intfstream_close(state->file);
+      free(state->file);
+   }
 
    flg = task_get_flags(task);
 
@@ -495,54 +511,82 @@ static void *content_get_serialized_data(size_t *serial_size)
    return data;
 }
 
+static unsigned content_get_state_writer_flags(bool compress)
+{
+   unsigned flags = 0;
+   if (compress)
+      flags |= STATE_WRITER_FLAG_COMPRESS;
+   if (config_get_ptr()->bools.savestate_dedup_store)
+      flags |= STATE_WRITER_FLAG_STORE;
+   return flags;
+}
+
+static enum state_writer_sync content_get_state_sync(void)
+{
+   unsigned sync = config_get_ptr()->uints.savestate_file_sync;
+   if (sync >= STATE_WRITER_SYNC_LAST)
+      return STATE_WRITER_SYNC_NONE;
+   return (enum state_writer_sync)sync;
+}
+
 /**
  * task_save_handler:
  * @task : the task being worked on
  *
- * Write a chunk of data to the save state file.
+ * Hand the state over to the write-behind queue, then wait for
+ * it to be written.
  **/
 static void task_save_handler(retro_task_t *task)
 {
    uint8_t flg;
-   ssize_t remaining;
-   int written              = 0;
+   enum state_writer_status status;
    save_task_state_t *state = (save_task_state_t*)task->state;
 
-   if (!state->file)
+   if (!state->ticket)
    {
-      if (state->flags & SAVE_TASK_FLAG_COMPRESS_FILES)
-         state->file   = intfstream_open_rzip_file(
-               state->path, RETRO_VFS_FILE_ACCESS_WRITE);
-      else
-         state->file   = intfstream_open_file(
-               state->path, RETRO_VFS_FILE_ACCESS_WRITE,
-               RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      state_writer_t *writer = save_state_writer;
 
-      if (!state->file)
-         return;
-   }
+      if (!state->data)
+      {
+         size_t _len = 0;
+         state->data = content_get_serialized_data(&_len);
+         state->size = (ssize_t)_len;
+      }
 
-   if (!state->data)
-   {
-      size_t _len = 0;
-      state->data = content_get_serialized_data(&_len);
-      state->size = (ssize_t)_len;
+      /* The writer owns the data from here on */
+      if (state->data && writer)
+      {
+         if (     (state->flags & SAVE_TASK_FLAG_UNDO_SAVE)
+               && (state->data == undo_save_buf.data))
+            undo_save_buf.data = NULL;
+         state->ticket = state_writer_submit(writer, state->path,
+               state->data, state->size,
+               content_get_state_writer_flags(
+                  (state->flags & SAVE_TASK_FLAG_COMPRESS_FILES) ? true : false),
+               content_get_state_sync());
+         state->data   = NULL;
+      }
    }
 
-   remaining       = MIN(state->size - state->written, SAVE_STATE_CHUNK);
+   status = state_writer_poll(save_state_writer, state->ticket);
 
-   if (state->data)
+   if (status == STATE_WRITER_STATUS_PENDING)
    {
-      written         = (int)intfstream_write(state->file,
-         (uint8_t*)state->data + state->written, remaining);
-      state->written += written;
+      task->when = cpu_features_get_time_usec() + SAVE_STATE_POLL_USEC;
+      return;
    }
 
-   task_set_progress(task, (state->written / (float)state->size) * 100);
+   flg    = task_get_flags(task);
 
-   flg = task_get_flags(task);
-
-   if (((flg & RETRO_TASK_FLG_CANCELLED) > 0) || written != remaining)
+   /* A newer state for the same file replaced this one, the task
+    * writing that one reports it */
+   if (status == STATE_WRITER_STATUS_SUPERSEDED)
+   {
+      task_free_title(task);
+      task_set_flags(task, RETRO_TASK_FLG_MUTE, true);
+      task_save_handler_finished(task, state);
+   }
+   else if (status != STATE_WRITER_STATUS_DONE)
    {
       char msg[128];
 
@@ -567,10 +611,12 @@ static void task_save_handler(retro_task_t *task)
       task_set_error(task, strdup(msg));
       task_save_handler_finished(task, state);
    }
-   else if (state->written == state->size)
+   else
    {
       char       *msg      = NULL;
 
+      state->written       = state->size;
+      task_set_progress(task, 100);
       task_free_title(task);
 
       if (state->flags & SAVE_TASK_FLAG_UNDO_SAVE)
@@ -783,6 +829,31 @@ static void task_load_handler(retro_task_t *task)
 
    if (state->bytes_read == state->size)
    {
+      /* Saved to the deduplicating store, put the state together */
+      if (state_store_is_manifest(state->data, (size_t)state->size))
+      {
+         size_t _len = 0;
+         void *data  = NULL;
+
+         data        = state_store_read(state->path, state->data,
+               (size_t)state->size, &_len);
+         free(state->data);
+         state->data = data;
+
+         if (!data)
+         {
+            RARCH_ERR("[State] Missing or damaged chunks for \"%s\".\n",
+                  state->path);
+            task_set_error(task,
+                  strdup(msg_hash_to_str(MSG_FAILED_TO_LOAD_STATE)));
+            task_load_handler_finished(task, state);
+            return;
+         }
+
+         state->size       = (ssize_t)_len;
+         state->bytes_read = (ssize_t)_len;
+      }
+
       task_free_title(task);
 
       if (!((flg & RETRO_TASK_FLG_MUTE) > 0))
@@ -1123,23 +1194,13 @@ error:
 /**
  * save_state_cb:
  *
- * Called after the save state is done. Takes a screenshot if needed.
+ * Called after the save state is done.
  **/
 static void save_state_cb(retro_task_t *task,
       void *task_data,
       void *user_data, const char *error)
 {
-   save_task_state_t *state   = (save_task_state_t*)task_data;
-#ifdef HAVE_SCREENSHOTS
-   char               *path   = strdup(state->path);
-   if (state->flags & SAVE_TASK_FLAG_THUMBNAIL_ENABLE)
-      take_screenshot(config_get_ptr()->paths.directory_screenshot,
-            path, true,
-            state->flags & SAVE_TASK_FLAG_HAS_VALID_FB, false, true);
-   free(path);
-#endif
-
-   free(state);
+   free(task_data);
 }
 
 /**
@@ -1148,7 +1209,9 @@ static void save_state_cb(retro_task_t *task,
  * @data : the save state data to write
  * @size : the total size of the save state
  *
- * Create a new task to save the content state.
+ * Create a new task to save the content state. The state file is
+ * written by the write-behind queue while the thumbnail is encoded
+ * on the task queue, so any number of saves can be in flight.
  **/
 static void task_push_save_state(const char *path, void *data, size_t len, bool autosave)
 {
@@ -1185,7 +1248,7 @@ static void task_push_save_state(const char *path, void *data, size_t len, bool
    if (!settings->bools.notification_show_save_state)
       state->flags              |= SAVE_TASK_FLAG_MUTE;
 
-   task->type                    = TASK_TYPE_BLOCKING;
+   task->type                    = TASK_TYPE_NONE;
    task->state                   = state;
    task->handler                 = task_save_handler;
    task->callback                = save_state_cb;
@@ -1196,16 +1259,16 @@ static void task_push_save_state(const char *path, void *data, size_t len, bool
    else
       task->flags               &= ~RETRO_TASK_FLG_MUTE;
 
-   if (!task_queue_push(task))
-   {
-      /* Another blocking task is already active. */
-      if (data)
-         free(data);
-      if (task->title)
-         task_free_title(task);
-      free(task);
-      free(state);
-   }
+#ifdef HAVE_SCREENSHOTS
+   /* Capture the frame the state was taken on, its encode runs
+    * alongside the state write */
+   if (state->flags & SAVE_TASK_FLAG_THUMBNAIL_ENABLE)
+      take_screenshot(settings->paths.directory_screenshot,
+            state->path, true,
+            state->flags & SAVE_TASK_FLAG_HAS_VALID_FB, false, true);
+#endif
+
+   task_queue_push(task);
 
    return;
 
@@ -1308,13 +1371,13 @@ static void task_push_load_and_save_state(const char *path, void *data,
 
    if (!task_queue_push(task))
    {
-      /* Another blocking task is already active. */
-      if (data)
-         free(data);
+      /* Another blocking task is already active, save
+       * without the backup rather than dropping the state */
       if (task->title)
          task_free_title(task);
       free(task);
       free(state);
+      task_push_save_state(path, data, len, autosave);
    }
 }
 
@@ -1323,16 +1386,19 @@ static void task_push_load_and_save_state(const char *path, void *data,
  * @path      : path of saved state that shall be written to.
  * Save a state from memory to disk. This is used for automatic saving right
  * before a core unload/deinit or content closing. The save is a blocking
- * operation (does not use the task queue).
+ * operation (does not use the task queue), but the thumbnail is encoded
+ * while the state is written.
  *
  * Returns: true if successful, false otherwise.
  **/
 bool content_auto_save_state(const char *path)
 {
    size_t _len;
-   settings_t *settings = config_get_ptr();
-   void *serial_data  = NULL;
-   intfstream_t *file = NULL;
+   uint32_t ticket;
+   unsigned flags         = 0;
+   settings_t *settings   = config_get_ptr();
+   void *serial_data      = NULL;
+   state_writer_t *writer = NULL;
 
    if (!core_info_current_supports_savestate())
    {
@@ -1349,31 +1415,21 @@ bool content_auto_save_state(const char *path)
    if (!serial_data)
       return false;
 
-#if defined(HAVE_ZLIB)
-   if (settings->bools.savestate_file_compression)
-      file = intfstream_open_rzip_file(path, RETRO_VFS_FILE_ACCESS_WRITE);
-   else
-#endif
-      file = intfstream_open_file(path, RETRO_VFS_FILE_ACCESS_WRITE,
-                                  RETRO_VFS_FILE_ACCESS_HINT_NONE);
-
-   if (!file)
+   if (!(writer = save_state_writer))
    {
       free(serial_data);
       return false;
    }
 
-   if (_len != (size_t)intfstream_write(file, serial_data, _len))
-   {
-      intfstream_close(file);
-      free(serial_data);
-      free(file);
-      return false;
-   }
+#if defined(HAVE_ZLIB)
+   flags = content_get_state_writer_flags(
+         settings->bools.savestate_file_compression);
+#else
+   flags = content_get_state_writer_flags(false);
+#endif
 
-   intfstream_close(file);
-   free(serial_data);
-   free(file);
+   ticket = state_writer_submit(writer, path, serial_data, _len,
+         flags, content_get_state_sync());
 
 #ifdef HAVE_SCREENSHOTS
    if (settings->bools.savestate_thumbnail_enable)
@@ -1386,7 +1442,9 @@ bool content_auto_save_state(const char *path)
       take_screenshot(dir_screenshot, path, true, validfb, false, false);
    }
 #endif
-   return true;
+
+   state_writer_wait(writer, path);
+   return state_writer_poll(writer, ticket) == STATE_WRITER_STATUS_DONE;
 }
 
 /**
@@ -1433,7 +1491,21 @@ bool content_save_state(const char *path, bool save_to_disk)
 
    if (save_to_disk)
    {
-      if (path_is_valid(path))
+      size_t pending_len = 0;
+      void *pending      = state_writer_copy_pending(save_state_writer,
+            path, &pending_len);
+
+      /* The file is still being replaced by an earlier save, which
+       * is what an undo should bring back */
+      if (pending)
+      {
+         free(undo_save_buf.data);
+         undo_save_buf.data = pending;
+         undo_save_buf.size = pending_len;
+         strlcpy(undo_save_buf.path, path, sizeof(undo_save_buf.path));
+         task_push_save_state(path, data, _len, false);
+      }
+      else if (path_is_valid(path))
       {
          /* Before overwriting the savestate file, load it into a buffer
          to allow undo_save_state() to work */
@@ -1513,6 +1585,33 @@ static bool content_save_state_in_progress(void* data)
 void content_wait_for_save_state_task(void)
 {
    task_queue_wait(content_save_state_in_progress, NULL);
+   state_writer_wait(save_state_writer, NULL);
+}
+
+bool content_export_state(const char *path, const char *out_path)
+{
+   task_queue_wait(content_save_state_in_progress, NULL);
+   if (save_state_writer)
+      state_writer_wait(save_state_writer, path);
+   return state_store_export(path, out_path);
+}
+
+void content_state_writer_init(void)
+{
+   state_store_init();
+   if (!save_state_writer)
+      save_state_writer = state_writer_new(SAVE_STATE_WRITERS);
+}
+
+void content_state_writer_deinit(void)
+{
+   /* Nothing was created, the task queue may not even be up yet */
+   if (!save_state_writer)
+      return;
+
+   content_wait_for_save_state_task();
+   state_writer_free(save_state_writer);
+   save_state_writer = NULL;
 }
 
 
@@ -1560,6 +1659,9 @@ bool content_load_state(const char *path,
       goto error;
    }
 
+   /* Never read a state that is still being written */
+   state_writer_wait(save_state_writer, path);
+
    task  = task_init();
    state = (save_task_state_t*)calloc(1, sizeof(*state));
 
@@ -1607,6 +1709,8 @@ error:
 
 bool content_rename_state(const char *origin, const char *dest)
 {
+   state_writer_wait(save_state_writer, NULL);
+
    if (filestream_exists(dest))
       filestream_delete(dest);
 
@@ -26,13 +26,14 @@
 #endif
 
 #include <encodings/base64.h>
-#include <formats/rbmp.h>
+#include <features/features_cpu.h>
 #include <formats/rpng.h>
 #include <formats/rjson.h>
 #include <gfx/scaler/pixconv.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
 #include "../translation_defines.h"
+#include "../translation_request.h"
 
 #ifdef HAVE_GFX_WIDGETS
 #include "../gfx/gfx_widgets.h"
@@ -775,387 +776,443 @@ static const char *ai_service_get_str(enum translation_lang id)
    return "";
 }
 
-bool run_translation_service(settings_t *settings, bool paused)
+/* How long automatic mode waits before looking at the
+ * screen again, when it had not changed */
+#define TRANSLATION_RECHECK_USEC 250000
+
+typedef struct translation_request_state
 {
-   struct video_viewport vp;
+   struct scaler_ctx scaler;
+   char url[PATH_MAX_LENGTH];
+   int gamepad[TRANSLATION_GAMEPAD_BUTTONS];
+   uint8_t *frame;
+   char *label;
+   char *json;
    size_t pitch;
-   unsigned width, height;
-   const void *data                  = NULL;
-   uint8_t *bit24_image              = NULL;
-   uint8_t *bit24_image_prev         = NULL;
-   struct scaler_ctx *scaler         = (struct scaler_ctx*)
-      calloc(1, sizeof(struct scaler_ctx));
-   bool error                        = false;
-
-   uint8_t *bmp_buffer               = NULL;
-   uint64_t buffer_bytes             = 0;
-   char *bmp64_buffer                = NULL;
-   rjsonwriter_t *jsonwriter         = NULL;
-   const char *json_buffer           = NULL;
-   int bmp64_len                     = 0;
-   bool TRANSLATE_USE_BMP            = false;
-   char *sys_lbl                     = NULL;
-   core_info_t *core_info            = NULL;
-   video_driver_state_t *video_st    = video_state_get_ptr();
-   access_state_t *access_st         = access_state_get_ptr();
-#ifdef HAVE_ACCESSIBILITY
-   input_driver_state_t *input_st    = input_state_get_ptr();
-#endif
+   unsigned width;
+   unsigned height;
+   unsigned frame_width;
+   unsigned frame_height;
+   enum retro_pixel_format pix_fmt;
+   bool viewport;
+   bool paused;
+   bool compare;
+   bool send_regions;
+   bool unchanged;
+} translation_request_state_t;
+
+/* Only touched by task_translation_request_handler, which
+ * the task queue never runs twice at once */
+static translation_diff_t *translation_diff = NULL;
+
+static void ai_service_get_url(settings_t *settings,
+      char *s, size_t len)
+{
+   char separator                  = '?';
+   unsigned ai_service_source_lang = settings->uints.ai_service_source_lang;
+   unsigned ai_service_target_lang = settings->uints.ai_service_target_lang;
+   unsigned ai_service_mode        = settings->uints.ai_service_mode;
+   const char *ai_service_url      = settings->arrays.ai_service_url;
 #ifdef HAVE_GFX_WIDGETS
-   dispgfx_widget_t *p_dispwidget    = dispwidget_get_ptr();
-   /* For the case when ai service pause is disabled. */
-   if (     (p_dispwidget->ai_service_overlay_state != 0)
-         && (access_st->ai_service_auto == 1))
-   {
-      gfx_widgets_ai_service_overlay_unload();
-      goto finish;
-   }
+   video_driver_state_t *video_st  = video_state_get_ptr();
 #endif
+   size_t _len                     = strlcpy(s, ai_service_url, len);
 
+   /* if query already exists in url, then use &'s instead */
+   if (strrchr(s, '?'))
+      separator = '&';
 
-   /* get the core info here so we can pass long the game name */
-   core_info_get_current_core(&core_info);
-
-   if (core_info)
+   /* source lang */
+   if (ai_service_source_lang != TRANSLATION_LANG_DONT_CARE)
    {
-      size_t lbl_len;
-      const char *lbl                     = NULL;
-      const char *sys_id                  = core_info->system_id
-         ? core_info->system_id : "core";
-      size_t sys_id_len                   = strlen(sys_id);
-      const struct playlist_entry *entry  = NULL;
-      playlist_t *current_playlist        = playlist_get_cached();
+      const char *lang_source = ai_service_get_str(
+            (enum translation_lang)ai_service_source_lang);
 
-      if (current_playlist)
+      if (!string_is_empty(lang_source))
       {
-         playlist_get_index_by_path(
-            current_playlist, path_get(RARCH_PATH_CONTENT), &entry);
-
-         if (entry && !string_is_empty(entry->label))
-            lbl = entry->label;
+         s[  _len]  = separator;
+         s[++_len]  = '\0';
+         _len      += strlcpy(s + _len, "source_lang=", len - _len);
+         _len      += strlcpy(s + _len, lang_source,    len - _len);
+         separator  = '&';
       }
+   }
 
-      if (!lbl)
-         lbl       = path_basename(path_get(RARCH_PATH_BASENAME));
-      lbl_len      = strlen(lbl);
-      sys_lbl      = (char*)malloc(lbl_len + sys_id_len + 3);
+   /* target lang */
+   if (ai_service_target_lang != TRANSLATION_LANG_DONT_CARE)
+   {
+      const char *lang_target = ai_service_get_str(
+            (enum translation_lang)ai_service_target_lang);
 
-      if (sys_lbl)
+      if (!string_is_empty(lang_target))
       {
-         memcpy(sys_lbl, sys_id, sys_id_len);
-         memcpy(sys_lbl + sys_id_len, "__", 2);
-         memcpy(sys_lbl + 2 + sys_id_len, lbl, lbl_len);
-         sys_lbl[sys_id_len + 2 + lbl_len] = '\0';
+         s[  _len]  = separator;
+         s[++_len]  = '\0';
+         _len      += strlcpy(s + _len, "target_lang=", len - _len);
+         _len      += strlcpy(s + _len, lang_target,    len - _len);
+         separator  = '&';
       }
    }
 
-   if (!scaler)
-      goto finish;
+   /* mode */
+   /*"image" is included for backwards compatibility with
+    * vgtranslate < 1.04 */
+   s[  _len]  = separator;
+   s[++_len]  = '\0';
+   _len      += strlcpy(s + _len, "output=", len - _len);
 
-   data       = video_st->frame_cache_data;
-   width      = video_st->frame_cache_width;
-   height     = video_st->frame_cache_height;
-   pitch      = video_st->frame_cache_pitch;
+   switch (ai_service_mode)
+   {
+      case 2:
+         strlcpy(s + _len, "text", len - _len);
+         break;
+      case 1:
+      case 3:
+         _len += strlcpy(s + _len, "sound,wav", len - _len);
+         if (ai_service_mode == 1)
+            break;
+         /* fall-through intentional for ai_service_mode == 3 */
+      case 0:
+         _len += strlcpy(s + _len, "image,png", len - _len);
+#ifdef HAVE_GFX_WIDGETS
+         if (     video_st->poke
+               && video_st->poke->load_texture
+               && video_st->poke->unload_texture)
+            strlcpy(s + _len, ",png-a", len - _len);
+#endif
+         break;
+      default:
+         break;
+   }
+}
 
-   if (!data)
-      goto finish;
+static void task_translation_recheck_handler(retro_task_t *task)
+{
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
 
-   if (data == RETRO_HW_FRAME_BUFFER_VALID)
+static void task_translation_recheck_cb(
+      retro_task_t *task, void *task_data,
+      void *user_data, const char *error)
+{
+   /* Automatic mode may have been turned off meanwhile */
+   if (access_state_get_ptr()->ai_service_auto == 2)
    {
-      /*
-        The direct frame capture didn't work, so try getting it
-        from the viewport instead.  This isn't as good as the
-        raw frame buffer, since the viewport may us bilinear
-        filtering, or other shaders that will completely trash
-        the OCR, but it's better than nothing.
-      */
-      vp.x                           = 0;
-      vp.y                           = 0;
-      vp.width                       = 0;
-      vp.height                      = 0;
-      vp.full_width                  = 0;
-      vp.full_height                 = 0;
+      bool was_paused = (runloop_get_flags() & RUNLOOP_FLAG_PAUSED)
+         ? true : false;
+      command_event(CMD_EVENT_AI_SERVICE_CALL, &was_paused);
+   }
+}
 
-      video_driver_get_viewport_info(&vp);
+static void task_push_translation_recheck(void)
+{
+   retro_task_t *task = task_init();
+   if (!task)
+      return;
 
-      if (!vp.width || !vp.height)
-         goto finish;
+   task->handler  = task_translation_recheck_handler;
+   task->callback = task_translation_recheck_cb;
+   task->when     = cpu_features_get_time_usec() + TRANSLATION_RECHECK_USEC;
+   task->flags   |= RETRO_TASK_FLG_MUTE;
 
-      bit24_image_prev = (uint8_t*)malloc(vp.width * vp.height * 3);
-      bit24_image      = (uint8_t*)malloc(width * height * 3);
+   task_queue_push(task);
+}
 
-      if (!bit24_image_prev || !bit24_image)
-         goto finish;
+static void task_translation_request_handler(retro_task_t *task)
+{
+   translation_region_t regions[TRANSLATION_DIFF_MAX_REGIONS];
+   translation_request_state_t *st =
+      (translation_request_state_t*)task->state;
+   struct scaler_ctx *scaler       = &st->scaler;
+   unsigned width                  = st->width;
+   unsigned height                 = st->height;
+   int count                       = -1;
+   const uint8_t *top              = NULL;
+   uint8_t *bit24_image            = (uint8_t*)malloc(width * height * 3);
 
-      if (!(      video_st->current_video->read_viewport
-               && video_st->current_video->read_viewport(
-                  video_st->data, bit24_image_prev, false)))
-      {
-         RARCH_LOG("[Translation] Could not read viewport for translation service.\n");
-         goto finish;
-      }
+   if (!bit24_image)
+   {
+      task_set_error(task, strdup("Out of memory"));
+      goto end;
+   }
 
+   /* Either way, the image comes out bottom-up */
+   if (st->viewport)
+   {
       /* TODO: Rescale down to regular resolution */
       scaler->in_fmt      = SCALER_FMT_BGR24;
       scaler->out_fmt     = SCALER_FMT_BGR24;
       scaler->scaler_type = SCALER_TYPE_POINT;
-      scaler->in_width    = vp.width;
-      scaler->in_height   = vp.height;
+      scaler->in_width    = st->frame_width;
+      scaler->in_height   = st->frame_height;
       scaler->out_width   = width;
       scaler->out_height  = height;
       scaler_ctx_gen_filter(scaler);
 
-      scaler->in_stride   = vp.width*3;
-      scaler->out_stride  = width*3;
-      scaler_ctx_scale_direct(scaler, bit24_image, bit24_image_prev);
+      scaler->in_stride   = st->frame_width * 3;
+      scaler->out_stride  = width * 3;
+      scaler_ctx_scale_direct(scaler, bit24_image, st->frame);
    }
    else
    {
-      const enum retro_pixel_format
-         video_driver_pix_fmt           = video_st->pix_fmt;
       /* This is a software core, so just change the pixel format to 24-bit. */
-      if (!(bit24_image = (uint8_t*)malloc(width * height * 3)))
-          goto finish;
-
-      if (video_driver_pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+      if (st->pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
          scaler->in_fmt = SCALER_FMT_ARGB8888;
       else
          scaler->in_fmt = SCALER_FMT_RGB565;
       video_frame_convert_to_bgr24(
          scaler,
-         (uint8_t *)bit24_image,
-         (const uint8_t*)data + ((int)height - 1)*pitch,
+         bit24_image,
+         st->frame + ((int)height - 1) * st->pitch,
          width, height,
-         (int)-pitch);
+         (int)-st->pitch);
    }
    scaler_ctx_gen_reset(scaler);
 
-   if (!bit24_image)
+   top = bit24_image + width * (height - 1) * 3;
+
+   if (!translation_diff)
+      translation_diff = translation_diff_new();
+
+   if (translation_diff)
    {
-      error = true;
-      goto finish;
+      /* Requests outside automatic mode always send the
+       * whole frame, and become what the next one is
+       * compared with */
+      if (!st->compare)
+         translation_diff_reset(translation_diff);
+      count = translation_diff_update(translation_diff,
+            top, width, height, -(int)(width * 3),
+            regions, ARRAY_SIZE(regions));
    }
 
-   if (TRANSLATE_USE_BMP)
+   if (st->compare && count == 0)
+      st->unchanged = true;
+   else if (!(st->json = translation_request_encode(
+               top, width, height, -(int)(width * 3),
+               (st->send_regions && count > 0) ? regions : NULL,
+               (count > 0) ? (unsigned)count : 0,
+               st->label, st->paused, st->gamepad)))
+      task_set_error(task, strdup("Could not encode request"));
+
+   free(bit24_image);
+
+end:
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static void task_translation_request_cb(
+      retro_task_t *task, void *task_data,
+      void *user_data, const char *error)
+{
+   translation_request_state_t *st =
+      (translation_request_state_t*)task->state;
+   access_state_t *access_st       = access_state_get_ptr();
+
+   if (error)
    {
-      /*
-        At this point, we should have a screenshot in the buffer,
-        so allocate an array to contain the BMP image along with
-        the BMP header as bytes, and then covert that to a
-        b64 encoded array for transport in JSON.
-      */
-      if (!(bmp_buffer  = (uint8_t*)malloc(width * height * 3 + 54)))
-         goto finish;
-
-      form_bmp_header(bmp_buffer, width, height, false);
-      memcpy(bmp_buffer + 54,
-            bit24_image,
-            width * height * 3 * sizeof(uint8_t));
-      buffer_bytes = sizeof(uint8_t) * (width * height * 3 + 54);
+      RARCH_ERR("[Translation] %s.\n", error);
+      return;
    }
-   else
+
+   if (st->unchanged)
    {
-      pitch        = width * 3;
-      bmp_buffer   = rpng_save_image_bgr24_string(
-            bit24_image + width * (height-1) * 3,
-            width, height, (signed)-pitch, &buffer_bytes);
+      /* Nothing new to translate, and the previous result
+       * still stands; look again in a moment */
+      if (access_st->ai_service_auto == 2)
+         task_push_translation_recheck();
+      return;
    }
 
-   if (!(bmp64_buffer = base64((void *)bmp_buffer,
-         (int)(sizeof(uint8_t) * buffer_bytes),
-         &bmp64_len)))
-      goto finish;
-
-   if (!(jsonwriter = rjsonwriter_open_memory()))
-      goto finish;
-
-   rjsonwriter_raw(jsonwriter, "{", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_add_string(jsonwriter, "image");
-   rjsonwriter_raw(jsonwriter, ":", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_add_string_len(jsonwriter, bmp64_buffer, bmp64_len);
+   if (!st->json)
+      return;
 
-   /* Form request... */
-   if (sys_lbl)
+#ifdef DEBUG
+   if (access_st->ai_service_auto != 2)
    {
-      rjsonwriter_raw(jsonwriter, ",", 1);
-      rjsonwriter_raw(jsonwriter, " ", 1);
-      rjsonwriter_add_string(jsonwriter, "label");
-      rjsonwriter_raw(jsonwriter, ":", 1);
-      rjsonwriter_raw(jsonwriter, " ", 1);
-      rjsonwriter_add_string(jsonwriter, sys_lbl);
+      RARCH_LOG("[Translation] Request size: %u\n",
+            (unsigned)strlen(st->json));
+      RARCH_LOG("[Translation] SENDING... %s\n", st->url);
    }
+#endif
+   task_push_http_post_transfer(st->url,
+         st->json, true, NULL, handle_translation_cb, NULL);
+}
 
-   rjsonwriter_raw(jsonwriter, ",", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_add_string(jsonwriter, "state");
-   rjsonwriter_raw(jsonwriter, ":", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_raw(jsonwriter, "{", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_add_string(jsonwriter, "paused");
-   rjsonwriter_raw(jsonwriter, ":", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_rawf(jsonwriter, "%u", (paused ? 1 : 0));
-   {
-      static const char* state_labels[] = { "b", "y", "select", "start", "up", "down", "left", "right", "a", "x", "l", "r", "l2", "r2", "l3", "r3" };
-      int i;
-      for (i = 0; i < (int)ARRAY_SIZE(state_labels); i++)
-      {
-         rjsonwriter_raw(jsonwriter, ",", 1);
-         rjsonwriter_raw(jsonwriter, " ", 1);
-         rjsonwriter_add_string(jsonwriter, state_labels[i]);
-         rjsonwriter_raw(jsonwriter, ":", 1);
-         rjsonwriter_raw(jsonwriter, " ", 1);
+static void task_translation_request_cleanup(retro_task_t *task)
+{
+   translation_request_state_t *st =
+      (translation_request_state_t*)task->state;
+
+   if (!st)
+      return;
+
+   if (st->frame)
+      free(st->frame);
+   if (st->label)
+      free(st->label);
+   if (st->json)
+      free(st->json);
+   free(st);
+   task->state = NULL;
+}
+
+bool run_translation_service(settings_t *settings, bool paused)
+{
+   struct video_viewport vp;
+   unsigned i;
+   retro_task_t *task                = NULL;
+   core_info_t *core_info            = NULL;
+   translation_request_state_t *st   = NULL;
+   video_driver_state_t *video_st    = video_state_get_ptr();
+   access_state_t *access_st         = access_state_get_ptr();
+   const void *data                  = video_st->frame_cache_data;
 #ifdef HAVE_ACCESSIBILITY
-         rjsonwriter_rawf(jsonwriter, "%u",
-               (input_st->ai_gamepad_state[i] ? 1 : 0));
-#else
-         rjsonwriter_rawf(jsonwriter, "%u", 0);
+   input_driver_state_t *input_st    = input_state_get_ptr();
 #endif
-      }
+#ifdef HAVE_GFX_WIDGETS
+   dispgfx_widget_t *p_dispwidget    = dispwidget_get_ptr();
+   /* For the case when ai service pause is disabled. */
+   if (     (p_dispwidget->ai_service_overlay_state != 0)
+         && (access_st->ai_service_auto == 1))
+   {
+      gfx_widgets_ai_service_overlay_unload();
+      return true;
    }
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_raw(jsonwriter, "}", 1);
-   rjsonwriter_raw(jsonwriter, " ", 1);
-   rjsonwriter_raw(jsonwriter, "}", 1);
+#endif
 
-   if ((json_buffer = rjsonwriter_get_memory_buffer(jsonwriter, NULL)))
+   if (!data)
+      return true;
+
+   if (!(st = (translation_request_state_t*)
+            calloc(1, sizeof(*st))))
+      return false;
+
+   st->width        = video_st->frame_cache_width;
+   st->height       = video_st->frame_cache_height;
+   st->pitch        = video_st->frame_cache_pitch;
+   st->pix_fmt      = video_st->pix_fmt;
+   st->paused       = paused;
+   /* Only automatic mode skips frames that did not change */
+   st->compare      = (access_st->ai_service_auto == 2);
+   st->send_regions = settings->bools.ai_service_send_regions;
+
+   if (!st->width || !st->height)
+      goto error;
+
+   /* Only what has to happen on the main thread is done
+    * here; converting, comparing and encoding the frame
+    * are left to task_translation_request_handler. */
+   if (data == RETRO_HW_FRAME_BUFFER_VALID)
    {
-#ifdef DEBUG
-      if (access_st->ai_service_auto != 2)
-         RARCH_LOG("[Translation] Request size: %d\n", bmp64_len);
-#endif
+      /*
+        The direct frame capture didn't work, so try getting it
+        from the viewport instead.  This isn't as good as the
+        raw frame buffer, since the viewport may us bilinear
+        filtering, or other shaders that will completely trash
+        the OCR, but it's better than nothing.
+      */
+      vp.x                           = 0;
+      vp.y                           = 0;
+      vp.width                       = 0;
+      vp.height                      = 0;
+      vp.full_width                  = 0;
+      vp.full_height                 = 0;
+
+      video_driver_get_viewport_info(&vp);
+
+      if (!vp.width || !vp.height)
+         goto error;
+
+      if (!(st->frame = (uint8_t*)malloc(vp.width * vp.height * 3)))
+         goto error;
+
+      if (!(      video_st->current_video->read_viewport
+               && video_st->current_video->read_viewport(
+                  video_st->data, st->frame, false)))
       {
-         char new_ai_service_url[PATH_MAX_LENGTH];
-         char separator                  = '?';
-         unsigned ai_service_source_lang = settings->uints.ai_service_source_lang;
-         unsigned ai_service_target_lang = settings->uints.ai_service_target_lang;
-         const char *ai_service_url      = settings->arrays.ai_service_url;
-         size_t _len                     = strlcpy(new_ai_service_url,
-               ai_service_url, sizeof(new_ai_service_url));
-
-         /* if query already exists in url, then use &'s instead */
-         if (strrchr(new_ai_service_url, '?'))
-            separator = '&';
-
-         /* source lang */
-         if (ai_service_source_lang != TRANSLATION_LANG_DONT_CARE)
-         {
-            const char *lang_source = ai_service_get_str(
-                  (enum translation_lang)ai_service_source_lang);
+         RARCH_LOG("[Translation] Could not read viewport for translation service.\n");
+         goto error;
+      }
 
-            if (!string_is_empty(lang_source))
-            {
-               new_ai_service_url[  _len] = separator;
-               new_ai_service_url[++_len] = '\0';
-               _len += strlcpy(new_ai_service_url + _len,
-                     "source_lang=",
-                     sizeof(new_ai_service_url)   - _len);
-               _len += strlcpy(new_ai_service_url + _len,
-                     lang_source,
-                     sizeof(new_ai_service_url)   - _len);
-               separator                  = '&';
-            }
-         }
+      st->viewport     = true;
+      st->frame_width  = vp.width;
+      st->frame_height = vp.height;
+   }
+   else
+   {
+      /* The core may overwrite its frame once it runs again */
+      if (!(st->frame = (uint8_t*)malloc(st->height * st->pitch)))
+         goto error;
+      memcpy(st->frame, data, st->height * st->pitch);
+   }
 
-         /* target lang */
-         if (ai_service_target_lang != TRANSLATION_LANG_DONT_CARE)
-         {
-            const char *lang_target = ai_service_get_str(
-                  (enum translation_lang)ai_service_target_lang);
+   /* get the core info here so we can pass long the game name */
+   core_info_get_current_core(&core_info);
 
-            if (!string_is_empty(lang_target))
-            {
-               new_ai_service_url[  _len] = separator;
-               new_ai_service_url[++_len] = '\0';
-               _len += strlcpy(new_ai_service_url + _len,
-                     "target_lang=",
-                     sizeof(new_ai_service_url)   - _len);
-               _len += strlcpy(new_ai_service_url + _len,
-                     lang_target,
-                     sizeof(new_ai_service_url)   - _len);
-               separator                  = '&';
-            }
-         }
+   if (core_info)
+   {
+      size_t lbl_len;
+      const char *lbl                     = NULL;
+      const char *sys_id                  = core_info->system_id
+         ? core_info->system_id : "core";
+      size_t sys_id_len                   = strlen(sys_id);
+      const struct playlist_entry *entry  = NULL;
+      playlist_t *current_playlist        = playlist_get_cached();
 
-         /* mode */
-         {
-            unsigned ai_service_mode   = settings->uints.ai_service_mode;
-            /*"image" is included for backwards compatibility with
-             * vgtranslate < 1.04 */
+      if (current_playlist)
+      {
+         playlist_get_index_by_path(
+            current_playlist, path_get(RARCH_PATH_CONTENT), &entry);
 
-            new_ai_service_url[  _len] = separator;
-            new_ai_service_url[++_len] = '\0';
-            _len += strlcpy(new_ai_service_url          + _len,
-                  "output=",
-                  sizeof(new_ai_service_url)            - _len);
+         if (entry && !string_is_empty(entry->label))
+            lbl = entry->label;
+      }
 
-            switch (ai_service_mode)
-            {
-               case 2:
-                  strlcpy(new_ai_service_url       + _len,
-                        "text",
-                        sizeof(new_ai_service_url) - _len);
-                  break;
-               case 1:
-               case 3:
-                  _len += strlcpy(new_ai_service_url    + _len,
-                        "sound,wav",
-                        sizeof(new_ai_service_url)      - _len);
-                  if (ai_service_mode == 1)
-                     break;
-                  /* fall-through intentional for ai_service_mode == 3 */
-               case 0:
-                  _len += strlcpy(new_ai_service_url    + _len,
-                        "image,png",
-                        sizeof(new_ai_service_url)      - _len);
-#ifdef HAVE_GFX_WIDGETS
-                  if (     video_st->poke
-                        && video_st->poke->load_texture
-                        && video_st->poke->unload_texture)
-                     strlcpy(new_ai_service_url       + _len,
-                           ",png-a",
-                           sizeof(new_ai_service_url) - _len);
-#endif
-                  break;
-               default:
-                  break;
-            }
+      if (!lbl)
+         lbl       = path_basename(path_get(RARCH_PATH_BASENAME));
+      lbl_len      = strlen(lbl);
+      st->label    = (char*)malloc(lbl_len + sys_id_len + 3);
 
-         }
-#ifdef DEBUG
-         if (access_st->ai_service_auto != 2)
-            RARCH_LOG("[Translation] SENDING... %s\n", new_ai_service_url);
-#endif
-         task_push_http_post_transfer(new_ai_service_url,
-               json_buffer, true, NULL, handle_translation_cb, NULL);
+      if (st->label)
+      {
+         memcpy(st->label, sys_id, sys_id_len);
+         memcpy(st->label + sys_id_len, "__", 2);
+         memcpy(st->label + 2 + sys_id_len, lbl, lbl_len);
+         st->label[sys_id_len + 2 + lbl_len] = '\0';
       }
+   }
 
-      error = false;
+   for (i = 0; i < TRANSLATION_GAMEPAD_BUTTONS; i++)
+   {
+#ifdef HAVE_ACCESSIBILITY
+      st->gamepad[i] = input_st->ai_gamepad_state[i] ? 1 : 0;
+#else
+      st->gamepad[i] = 0;
+#endif
    }
 
-finish:
-   if (bit24_image_prev)
-      free(bit24_image_prev);
-   if (bit24_image)
-      free(bit24_image);
+   ai_service_get_url(settings, st->url, sizeof(st->url));
 
-   if (scaler)
-      free(scaler);
+   if (!(task = task_init()))
+      goto error;
+
+   task->handler  = task_translation_request_handler;
+   task->callback = task_translation_request_cb;
+   task->cleanup  = task_translation_request_cleanup;
+   task->state    = st;
+   task->flags   |= RETRO_TASK_FLG_MUTE;
+
+   task_queue_push(task);
+   return true;
 
-   if (bmp_buffer)
-      free(bmp_buffer);
-
-   if (bmp64_buffer)
-      free(bmp64_buffer);
-   if (sys_lbl)
-      free(sys_lbl);
-   sys_lbl = NULL;
-   if (jsonwriter)
-      rjsonwriter_free(jsonwriter);
-   return !error;
+error:
+   if (st->frame)
+      free(st->frame);
+   if (st->label)
+      free(st->label);
+   free(st);
+   return false;
 }
 
 #ifdef HAVE_ACCESSIBILITY
@@ -38,6 +38,7 @@
 
 /* Required for task_push_core_backup() */
 #include "../core_backup.h"
+#include "../library_search.h"
 
 #if defined(HAVE_OVERLAY)
 #include "../input/input_overlay.h"
@@ -270,6 +271,15 @@ bool menu_explore_init_in_progress(void *data);
 void menu_explore_wait_for_init_task(void);
 #endif
 
+/* Library search tasks */
+#if defined(HAVE_MENU)
+bool task_push_library_search_update(const library_search_t *current,
+      const char *directory_playlist, const char *directory_database,
+      const char *directory_cache);
+bool library_search_update_in_progress(void *data);
+void library_search_wait_for_update_task(void);
+#endif
+
 extern const char* const input_builtin_autoconfs[];
 
 /* cloud sync tasks */
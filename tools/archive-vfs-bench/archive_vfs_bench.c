@@ -0,0 +1,598 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares reading a member of a zip archive through
+ * vfs_implementation_archive.c with extracting it first, as
+ * task_content.c does for cores that need a full path.
+ *
+ * A synthetic disc image, part random data and part padding, is
+ * stored deflated in a zip, with a small stored member next to it.
+ * A core reading it is modelled as random 2352 byte sector reads.
+ * For extraction, the time to first byte is the extraction itself;
+ * through the VFS it is the time to open the member and the first
+ * read. Reads through the VFS are timed twice: on a cold index,
+ * when seek points are built as the member is read, and after
+ * reopening, when the cached index and seek points are reused.
+ *
+ * Peak heap use is tracked by wrapping malloc() and friends, zlib
+ * included (it is linked from deps/libz). Every read must return
+ * the data as stored, and a rewritten archive must be reindexed.
+ *
+ * Usage: archive_vfs_bench [-s image MB] [-r reads] [-d dir] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <vfs/vfs_implementation.h>
+#include <vfs/vfs_implementation_archive.h>
+
+#include <zlib.h>
+
+#define SECTOR 2352
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+   if (!cond)
+   {
+      printf("FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* Heap accounting, see the Makefile */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static size_t heap_used = 0;
+static size_t heap_peak = 0;
+static size_t heap_base = 0;
+
+static void heap_add(void *ptr)
+{
+   if (ptr)
+   {
+      heap_used += malloc_usable_size(ptr);
+      if (heap_used > heap_peak)
+         heap_peak = heap_used;
+   }
+}
+
+void *__wrap_malloc(size_t size)
+{
+   void *ptr = __real_malloc(size);
+   heap_add(ptr);
+   return ptr;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+   void *ptr = __real_calloc(n, size);
+   heap_add(ptr);
+   return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   void *ret;
+   size_t old = ptr ? malloc_usable_size(ptr) : 0;
+   if ((ret = __real_realloc(ptr, size)))
+   {
+      heap_used -= old;
+      heap_add(ret);
+   }
+   return ret;
+}
+
+void __wrap_free(void *ptr)
+{
+   if (ptr)
+      heap_used -= malloc_usable_size(ptr);
+   __real_free(ptr);
+}
+
+char *__wrap_strdup(const char *s)
+{
+   size_t _len = strlen(s) + 1;
+   char *ret   = (char*)__wrap_malloc(_len);
+   if (ret)
+      memcpy(ret, s, _len);
+   return ret;
+}
+
+static void heap_reset_peak(void)
+{
+   heap_base = heap_used;
+   heap_peak = heap_used;
+}
+
+/* Sectors of random data mixed with runs of padding */
+static uint8_t *make_image(size_t len)
+{
+   size_t i, j;
+   uint8_t *data = (uint8_t*)malloc(len);
+
+   if (!data)
+      return NULL;
+
+   for (i = 0; i < len; i += 2048)
+   {
+      size_t sector = MIN(len - i, 2048);
+
+      if (rng() % 100 < 45)
+      {
+         for (j = 0; j < sector; j += 4)
+         {
+            uint32_t v = rng();
+            memcpy(data + i + j, &v, MIN(sector - j, 4));
+         }
+      }
+      else
+         memset(data + i, (rng() % 4) ? 0x00 : 0xFF, sector);
+   }
+
+   return data;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+   p[0] = (uint8_t)v;
+   p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+   put16(p,     (uint16_t)v);
+   put16(p + 2, (uint16_t)(v >> 16));
+}
+
+struct member
+{
+   const char *name;
+   const uint8_t *data;
+   size_t len;
+   bool deflate;
+};
+
+/* Writes a zip archive of @members */
+static bool write_zip(const char *path, const struct member *members,
+      int count)
+{
+   int i;
+   uint8_t hdr[46];
+   uint32_t offsets[4];
+   uint32_t crcs[4];
+   uint32_t comp_sizes[4];
+   uint32_t cd_offset, cd_size = 0;
+   FILE *fp = fopen(path, "wb");
+
+   if (!fp)
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      const struct member *m = &members[i];
+      uint8_t *comp          = NULL;
+      size_t comp_len        = m->len;
+      size_t name_len        = strlen(m->name);
+
+      if (m->deflate)
+      {
+         z_stream zs;
+         memset(&zs, 0, sizeof(zs));
+         comp_len = compressBound((uLong)m->len);
+         if (     !(comp = (uint8_t*)malloc(comp_len))
+               || deflateInit2(&zs, 6, Z_DEFLATED, -MAX_WBITS, 8,
+                  Z_DEFAULT_STRATEGY) != Z_OK)
+         {
+            free(comp);
+            fclose(fp);
+            return false;
+         }
+         zs.next_in   = (Bytef*)m->data;
+         zs.avail_in  = (uInt)m->len;
+         zs.next_out  = comp;
+         zs.avail_out = (uInt)comp_len;
+         deflate(&zs, Z_FINISH);
+         comp_len     = zs.total_out;
+         deflateEnd(&zs);
+      }
+
+      offsets[i]    = (uint32_t)ftell(fp);
+      crcs[i]       = (uint32_t)crc32(0, m->data, (uInt)m->len);
+      comp_sizes[i] = (uint32_t)comp_len;
+
+      memset(hdr, 0, 30);
+      put32(hdr,      0x04034b50);
+      put16(hdr + 4,  20);
+      put16(hdr + 8,  m->deflate ? 8 : 0);
+      put16(hdr + 12, 0x21);
+      put32(hdr + 14, crcs[i]);
+      put32(hdr + 18, comp_sizes[i]);
+      put32(hdr + 22, (uint32_t)m->len);
+      put16(hdr + 26, (uint16_t)name_len);
+      fwrite(hdr, 1, 30, fp);
+      fwrite(m->name, 1, name_len, fp);
+      fwrite(comp ? comp : m->data, 1, comp_len, fp);
+      free(comp);
+   }
+
+   cd_offset = (uint32_t)ftell(fp);
+   for (i = 0; i < count; i++)
+   {
+      size_t name_len = strlen(members[i].name);
+
+      memset(hdr, 0, 46);
+      put32(hdr,      0x02014b50);
+      put16(hdr + 4,  20);
+      put16(hdr + 6,  20);
+      put16(hdr + 10, members[i].deflate ? 8 : 0);
+      put16(hdr + 14, 0x21);
+      put32(hdr + 16, crcs[i]);
+      put32(hdr + 20, comp_sizes[i]);
+      put32(hdr + 24, (uint32_t)members[i].len);
+      put16(hdr + 28, (uint16_t)name_len);
+      put32(hdr + 42, offsets[i]);
+      fwrite(hdr, 1, 46, fp);
+      fwrite(members[i].name, 1, name_len, fp);
+      cd_size += (uint32_t)(46 + name_len);
+   }
+
+   memset(hdr, 0, 22);
+   put32(hdr,      0x06054b50);
+   put16(hdr + 8,  (uint16_t)count);
+   put16(hdr + 10, (uint16_t)count);
+   put32(hdr + 12, cd_size);
+   put32(hdr + 16, cd_offset);
+   fwrite(hdr, 1, 22, fp);
+
+   return fclose(fp) == 0;
+}
+
+struct read_stats
+{
+   int64_t first_usec; /* Until the first sector is read */
+   int64_t total_usec;
+   int64_t max_usec;
+   int reads;
+};
+
+static void print_stats(const char *method, const struct read_stats *st)
+{
+   printf("%-16s %12.1f %12.1f %12.2f %10.1f\n", method,
+         st->first_usec / 1000.0,
+         (double)st->total_usec / st->reads,
+         st->max_usec / 1000.0,
+         (heap_peak - heap_base) / 1048576.0);
+}
+
+/* Random sector reads through a VFS handle, @offsets[0] first */
+static void read_sectors_vfs(libretro_vfs_implementation_file *fp,
+      const uint8_t *image, const size_t *offsets, int reads,
+      struct read_stats *st)
+{
+   int r;
+   uint8_t sector[SECTOR];
+
+   for (r = 0; r < reads; r++)
+   {
+      int64_t n;
+      int64_t t = bench_usec();
+
+      retro_vfs_file_seek_impl(fp, (int64_t)offsets[r],
+            RETRO_VFS_SEEK_POSITION_START);
+      n = retro_vfs_file_read_impl(fp, sector, SECTOR);
+      t = bench_usec() - t;
+
+      check(n == SECTOR && !memcmp(sector, image + offsets[r], SECTOR),
+            "sector matches");
+
+      st->total_usec += t;
+      if (t > st->max_usec)
+         st->max_usec = t;
+   }
+   st->reads = reads;
+}
+
+int main(int argc, char **argv)
+{
+   int r;
+   char dir[256];
+   char zip_path[PATH_MAX_LENGTH];
+   char member_path[PATH_MAX_LENGTH];
+   char extract_path[PATH_MAX_LENGTH];
+   struct member members[2];
+   size_t *offsets;
+   uint8_t *image;
+   uint8_t small[3000];
+   size_t image_mb  = 64;
+   int reads        = 2000;
+   size_t vfs_heap  = 0;
+   size_t heap_start;
+   size_t image_len;
+   size_t i;
+
+   snprintf(dir, sizeof(dir), "/tmp/archive_vfs_bench.%d", (int)getpid());
+
+   for (r = 1; r < argc; r++)
+   {
+      if (!strcmp(argv[r], "-s") && r + 1 < argc)
+         image_mb = (size_t)atoi(argv[++r]);
+      else if (!strcmp(argv[r], "-r") && r + 1 < argc)
+         reads    = atoi(argv[++r]);
+      else if (!strcmp(argv[r], "-d") && r + 1 < argc)
+         strlcpy(dir, argv[++r], sizeof(dir));
+      else
+      {
+         fprintf(stderr, "Usage: %s [-s image MB] [-r reads] [-d dir]\n",
+               argv[0]);
+         return 1;
+      }
+   }
+
+   if (image_mb < 2)
+      image_mb = 2;
+   if (reads < 1)
+      reads = 1;
+
+   image_len = image_mb << 20;
+   path_mkdir(dir);
+   snprintf(zip_path,     sizeof(zip_path),     "%s/game.zip", dir);
+   strlcpy(member_path, zip_path, sizeof(member_path));
+   strlcat(member_path, "#disc/game.bin", sizeof(member_path));
+   snprintf(extract_path, sizeof(extract_path), "%s/game.bin", dir);
+
+   if (!(image = make_image(image_len)))
+      return 1;
+   for (i = 0; i < sizeof(small); i++)
+      small[i] = (uint8_t)rng();
+
+   members[0].name    = "disc/game.bin";
+   members[0].data    = image;
+   members[0].len     = image_len;
+   members[0].deflate = true;
+   members[1].name    = "game.cue";
+   members[1].data    = small;
+   members[1].len     = sizeof(small);
+   members[1].deflate = false;
+
+   if (!write_zip(zip_path, members, 2))
+   {
+      fprintf(stderr, "Cannot write %s\n", zip_path);
+      return 1;
+   }
+
+   /* The same sector offsets for every method */
+   offsets = (size_t*)malloc(reads * sizeof(*offsets));
+   for (r = 0; r < reads; r++)
+      offsets[r] = (size_t)(rng() % (image_len / SECTOR)) * SECTOR;
+
+   heap_start = heap_used;
+   retro_vfs_archive_init();
+
+   printf("%u MB image, %.1f MB zipped, %d random sector reads\n\n",
+         (unsigned)image_mb,
+         path_get_size(zip_path) / 1048576.0, reads);
+   printf("%-16s %12s %12s %12s %10s\n", "method",
+         "first ms", "us/read", "max read ms", "heap MB");
+
+   /* Extracting to a temporary file, then reading it */
+   {
+      struct read_stats st;
+      RFILE *fp;
+      uint8_t sector[SECTOR];
+      int64_t len = 0;
+      int64_t t;
+
+      memset(&st, 0, sizeof(st));
+      heap_reset_peak();
+
+      t = bench_usec();
+      check(file_archive_compressed_read(member_path, NULL,
+               extract_path, &len) && path_is_valid(extract_path),
+            "member extracted");
+      fp = filestream_open(extract_path, RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      filestream_seek(fp, (int64_t)offsets[0], RETRO_VFS_SEEK_POSITION_START);
+      filestream_read(fp, sector, SECTOR);
+      st.first_usec = bench_usec() - t;
+
+      for (r = 0; r < reads; r++)
+      {
+         int64_t n;
+         t = bench_usec();
+         filestream_seek(fp, (int64_t)offsets[r],
+               RETRO_VFS_SEEK_POSITION_START);
+         n = filestream_read(fp, sector, SECTOR);
+         t = bench_usec() - t;
+         check(n == SECTOR && !memcmp(sector, image + offsets[r], SECTOR),
+               "extracted sector matches");
+         st.total_usec += t;
+         if (t > st.max_usec)
+            st.max_usec = t;
+      }
+      st.reads = reads;
+      filestream_close(fp);
+      filestream_delete(extract_path);
+      print_stats("extract", &st);
+   }
+
+   /* In place, on a cold index, then after reopening */
+   for (r = 0; r < 2; r++)
+   {
+      struct read_stats st;
+      uint8_t sector[SECTOR];
+      libretro_vfs_implementation_file *fp;
+      int64_t t;
+
+      memset(&st, 0, sizeof(st));
+      heap_reset_peak();
+
+      t  = bench_usec();
+      fp = retro_vfs_file_open_impl(member_path,
+            RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      check(fp != NULL, "member opened in place");
+      if (!fp)
+         break;
+      retro_vfs_file_seek_impl(fp, (int64_t)offsets[0],
+            RETRO_VFS_SEEK_POSITION_START);
+      retro_vfs_file_read_impl(fp, sector, SECTOR);
+      st.first_usec = bench_usec() - t;
+
+      read_sectors_vfs(fp, image, offsets, reads, &st);
+      check(retro_vfs_file_size_impl(fp) == (int64_t)image_len,
+            "member size");
+      check(retro_vfs_file_error_impl(fp) == 0, "no read error");
+      retro_vfs_file_close_impl(fp);
+      print_stats(r ? "vfs (reopened)" : "vfs (cold)", &st);
+      vfs_heap = MAX(vfs_heap, heap_peak - heap_base);
+   }
+
+   /* At worst one 32 KiB window per 1 MiB, plus a handle */
+   check(vfs_heap < image_len / 16, "reading in place stays small");
+
+   /* Sequential reads, seeking and the end of a member */
+   {
+      int64_t n;
+      uint8_t *buf = (uint8_t*)malloc(image_len);
+      libretro_vfs_implementation_file *fp = retro_vfs_file_open_impl(
+            member_path, RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      size_t done = 0;
+
+      while (fp && done < image_len)
+      {
+         size_t chunk = MIN(image_len - done, 100000 + rng() % 100000);
+         if ((n = retro_vfs_file_read_impl(fp, buf + done, chunk)) <= 0)
+            break;
+         done += (size_t)n;
+      }
+      check(done == image_len && !memcmp(buf, image, image_len),
+            "sequential read matches");
+      check(fp && retro_vfs_file_read_impl(fp, buf, 16) == 0,
+            "read at end returns nothing");
+      check(fp && retro_vfs_file_seek_impl(fp, -100,
+               RETRO_VFS_SEEK_POSITION_END) == 0
+            && retro_vfs_file_tell_impl(fp) == (int64_t)image_len - 100
+            && retro_vfs_file_read_impl(fp, buf, 1000) == 100
+            && !memcmp(buf, image + image_len - 100, 100),
+            "read from the end");
+      check(fp && retro_vfs_file_seek_impl(fp, 5,
+               RETRO_VFS_SEEK_POSITION_START) == 0
+            && retro_vfs_file_read_impl(fp, buf, 10) == 10
+            && !memcmp(buf, image + 5, 10),
+            "read back from the start");
+      check(fp && retro_vfs_file_write_impl(fp, buf, 10) < 0,
+            "members are read-only");
+      retro_vfs_file_close_impl(fp);
+      free(buf);
+   }
+
+   /* Stored members, lookups and paths that are not members */
+   {
+      int32_t size = 0;
+      uint8_t buf[sizeof(small)];
+      char path[PATH_MAX_LENGTH];
+      libretro_vfs_implementation_file *fp;
+
+      strlcpy(path, zip_path, sizeof(path));
+      strlcat(path, "#game.cue", sizeof(path));
+      fp = retro_vfs_file_open_impl(path, RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      check(fp && retro_vfs_file_seek_impl(fp, 1000,
+               RETRO_VFS_SEEK_POSITION_START) == 0
+            && retro_vfs_file_read_impl(fp, buf, sizeof(buf)) == 2000
+            && !memcmp(buf, small + 1000, 2000),
+            "stored member read");
+      retro_vfs_file_close_impl(fp);
+
+      check(retro_vfs_stat_impl(member_path, &size)
+            == RETRO_VFS_STAT_IS_VALID && size == (int32_t)image_len,
+            "member stat");
+      strlcpy(path, zip_path, sizeof(path));
+      strlcat(path, "#missing.bin", sizeof(path));
+      check(!retro_vfs_stat_impl(path, NULL), "missing member stat");
+      check(!retro_vfs_file_open_impl(path, RETRO_VFS_FILE_ACCESS_READ,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE), "missing member open");
+      check(!retro_vfs_path_is_archive_member("game.7z#game.bin"),
+            "7z is extracted");
+      check(!retro_vfs_path_is_archive_member("game.zip#"),
+            "archive without member");
+   }
+
+   /* A rewritten archive must not be read from a stale index */
+   {
+      uint8_t buf[SECTOR];
+      libretro_vfs_implementation_file *fp;
+
+      sleep(1);
+      members[0].len = image_len / 2;
+      image[0]      ^= 0xFF;
+      write_zip(zip_path, members, 2);
+
+      fp = retro_vfs_file_open_impl(member_path, RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      check(fp && retro_vfs_file_size_impl(fp) == (int64_t)image_len / 2
+            && retro_vfs_file_read_impl(fp, buf, SECTOR) == SECTOR
+            && !memcmp(buf, image, SECTOR),
+            "rewritten archive reindexed");
+      retro_vfs_file_close_impl(fp);
+   }
+
+   retro_vfs_archive_deinit();
+   check(heap_used - heap_start < 65536, "index freed");
+
+   filestream_delete(zip_path);
+   rmdir(dir);
+   free(offsets);
+   free(image);
+
+   if (failures)
+   {
+      printf("\n%d checks failed\n", failures);
+      return 1;
+   }
+
+   printf("\nAll checks passed\n");
+   return 0;
+}
@@ -0,0 +1,452 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks and times the audio conversion and mixing kernels.
+ *
+ * Every implementation the CPU supports is selected in turn through
+ * the *_init_simd() functions, by standing in for cpu_features_get(),
+ * and compared bit for bit against plain C loops implementing the
+ * documented behaviour: random samples, values at and beyond the
+ * limits of the formats, infinities, NaNs and denormals, for every
+ * length up to a few vector widths and every misalignment.
+ *
+ * Each operation is then timed on buffers the size the audio driver
+ * flushes at a time, against the scalar loops used before.
+ *
+ * Usage: audio_convert_bench [-s samples] [-i iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <features/features_cpu.h>
+#include <audio/audio_mix.h>
+#include <audio/conversion/float_to_s16.h>
+#include <audio/conversion/s16_to_float.h>
+#include <audio/conversion/dual_mono.h>
+
+#define MAX_TEST_LEN 80
+
+static uint64_t bench_cpu = 0;
+
+/* Stands in for features_cpu.c, to pick the implementations */
+uint64_t cpu_features_get(void)
+{
+   return bench_cpu;
+}
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int failures = 0;
+
+static void check(bool cond, const char *what, const char *impl, size_t len)
+{
+   if (!cond)
+   {
+      if (failures < 20)
+         printf("FAIL: %s (%s, %u samples)\n", what, impl, (unsigned)len);
+      failures++;
+   }
+}
+
+static void select_simd(uint64_t cpu)
+{
+   bench_cpu = cpu;
+   convert_s16_to_float_init_simd();
+   convert_float_to_s16_init_simd();
+   convert_to_dual_mono_float_init_simd();
+   convert_to_mono_float_left_init_simd();
+   audio_mix_init_simd();
+}
+
+/* Reference behaviour */
+
+static void ref_s16_to_float(float *s, const int16_t *in,
+      size_t len, float gain)
+{
+   size_t i;
+   gain /= 0x8000;
+   for (i = 0; i < len; i++)
+      s[i] = (float)in[i] * gain;
+}
+
+static void ref_float_to_s16(int16_t *s, const float *in, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      float val = in[i] * 0x8000;
+      if (isnan(val))
+         s[i] = 0;
+      else if (val >= 32767.0f)
+         s[i] = 32767;
+      else if (val <= -32768.0f)
+         s[i] = -32768;
+      else
+         s[i] = (int16_t)truncf(val);
+   }
+}
+
+static void ref_mix_volume(float *s, const float *in, float vol, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      float additive = in[i] * vol;
+      s[i]           = s[i] + additive;
+   }
+}
+
+static void ref_mix_clamp(float *s, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+      s[i] = isnan(s[i]) ? s[i] : fminf(fmaxf(s[i], -1.0f), 1.0f);
+}
+
+static void ref_dual_mono(float *s, const float *in, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+      s[i * 2] = s[i * 2 + 1] = in[i];
+}
+
+static void ref_mono_left(float *s, const float *in, size_t frames)
+{
+   size_t i;
+   for (i = 0; i < frames; i++)
+      s[i] = in[i * 2];
+}
+
+/* Scalar loops as they were before the SIMD kernels,
+ * timed instead of the slower reference above */
+
+static void scalar_float_to_s16(int16_t *s, const float *in, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      int32_t val = (int32_t)(in[i] * 0x8000);
+      s[i]        = (val > 0x7FFF) ? 0x7FFF :
+         (val < -0x8000 ? -0x8000 : (int16_t)val);
+   }
+}
+
+static void scalar_mix_clamp(float *s, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      if (s[i] < -1.0f)
+         s[i] = -1.0f;
+      else if (s[i] > 1.0f)
+         s[i] = 1.0f;
+   }
+}
+
+/* Test data */
+
+static float random_float(void)
+{
+   static const float specials[] = {
+      0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f,
+      32767.0f / 32768.0f, 32767.5f / 32768.0f, -32768.5f / 32768.0f,
+      1.0000001f, -1.0000001f, 2.0f, -2.0f, 70000.0f, -70000.0f,
+      3e9f, -3e9f, 1e-40f, -1e-40f, 1e-30f,
+   };
+   uint32_t r = rng();
+
+   switch (r % 16)
+   {
+      case 0:
+         return specials[(r >> 8) % (sizeof(specials) / sizeof(specials[0]))];
+      case 1:
+         return (r & 256) ? INFINITY : -INFINITY;
+      case 2:
+         return (r & 256) ? NAN : -NAN;
+      default:
+         break;
+   }
+
+   /* Mostly in range, some clipping */
+   return ((float)(rng() & 0xFFFFFF) / 0x800000 - 1.0f) * 1.25f;
+}
+
+static void fill_s16(int16_t *buf, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+   {
+      uint32_t r = rng();
+      buf[i]     = (r % 8 == 0) ? ((r & 8) ? 32767 : -32768) : (int16_t)(r >> 16);
+   }
+}
+
+static void fill_float(float *buf, size_t len)
+{
+   size_t i;
+   for (i = 0; i < len; i++)
+      buf[i] = random_float();
+}
+
+/* Runs every operation on every length and misalignment
+ * and compares with the reference */
+static void test_impl(const char *impl)
+{
+   static const float gains[] = { 1.0f, 0.5f, 0.0f, 0.7943282f, 1.9952623f, 0.0001f };
+   int16_t s16_in[MAX_TEST_LEN * 2 + 8];
+   int16_t s16_out[MAX_TEST_LEN * 2 + 8], s16_ref[MAX_TEST_LEN * 2 + 8];
+   float f_in[MAX_TEST_LEN * 2 + 8], f_in2[MAX_TEST_LEN * 2 + 8];
+   float f_out[MAX_TEST_LEN * 2 + 8], f_ref[MAX_TEST_LEN * 2 + 8];
+   size_t len, off;
+   unsigned g;
+
+   for (len = 0; len <= MAX_TEST_LEN; len++)
+   {
+      for (off = 0; off < 4; off++)
+      {
+         fill_s16(s16_in, sizeof(s16_in) / sizeof(s16_in[0]));
+         fill_float(f_in, sizeof(f_in) / sizeof(f_in[0]));
+         fill_float(f_in2, sizeof(f_in2) / sizeof(f_in2[0]));
+
+         for (g = 0; g < sizeof(gains) / sizeof(gains[0]); g++)
+         {
+            memset(f_out, 0x55, sizeof(f_out));
+            memset(f_ref, 0x55, sizeof(f_ref));
+            convert_s16_to_float(f_out + off, s16_in + off, len, gains[g]);
+            ref_s16_to_float(f_ref + off, s16_in + off, len, gains[g]);
+            check(!memcmp(f_out, f_ref, sizeof(f_out)),
+                  "convert_s16_to_float", impl, len);
+         }
+
+         memset(s16_out, 0x55, sizeof(s16_out));
+         memset(s16_ref, 0x55, sizeof(s16_ref));
+         convert_float_to_s16(s16_out + off, f_in + off, len);
+         ref_float_to_s16(s16_ref + off, f_in + off, len);
+         check(!memcmp(s16_out, s16_ref, sizeof(s16_out)),
+               "convert_float_to_s16", impl, len);
+
+         for (g = 0; g < sizeof(gains) / sizeof(gains[0]); g++)
+         {
+            memcpy(f_out, f_in2, sizeof(f_out));
+            memcpy(f_ref, f_in2, sizeof(f_ref));
+            audio_mix_volume(f_out + off, f_in + off, gains[g], len);
+            ref_mix_volume(f_ref + off, f_in + off, gains[g], len);
+            check(!memcmp(f_out, f_ref, sizeof(f_out)),
+                  "audio_mix_volume", impl, len);
+         }
+
+         memcpy(f_out, f_in, sizeof(f_out));
+         memcpy(f_ref, f_in, sizeof(f_ref));
+         audio_mix_clamp(f_out + off, len);
+         ref_mix_clamp(f_ref + off, len);
+         check(!memcmp(f_out, f_ref, sizeof(f_out)),
+               "audio_mix_clamp", impl, len);
+
+         memset(f_out, 0x55, sizeof(f_out));
+         memset(f_ref, 0x55, sizeof(f_ref));
+         convert_to_dual_mono_float(f_out + off, f_in + off, len);
+         ref_dual_mono(f_ref + off, f_in + off, len);
+         check(!memcmp(f_out, f_ref, sizeof(f_out)),
+               "convert_to_dual_mono_float", impl, len);
+
+         memset(f_out, 0x55, sizeof(f_out));
+         memset(f_ref, 0x55, sizeof(f_ref));
+         convert_to_mono_float_left(f_out + off, f_in + off, len);
+         ref_mono_left(f_ref + off, f_in + off, len);
+         check(!memcmp(f_out, f_ref, sizeof(f_out)),
+               "convert_to_mono_float_left", impl, len);
+      }
+   }
+}
+
+/* Timing */
+
+typedef struct
+{
+   int16_t *s16_in;
+   int16_t *s16_out;
+   float *f_in;
+   float *f_out;
+   size_t len;
+} bench_bufs_t;
+
+static double time_op(int op, bool ref, const bench_bufs_t *b, int iterations)
+{
+   int i;
+   int64_t t = bench_usec();
+
+   for (i = 0; i < iterations; i++)
+   {
+      switch (op)
+      {
+         case 0:
+            if (ref)
+               ref_s16_to_float(b->f_out, b->s16_in, b->len, 0.5f);
+            else
+               convert_s16_to_float(b->f_out, b->s16_in, b->len, 0.5f);
+            break;
+         case 1:
+            if (ref)
+               scalar_float_to_s16(b->s16_out, b->f_in, b->len);
+            else
+               convert_float_to_s16(b->s16_out, b->f_in, b->len);
+            break;
+         case 2:
+            if (ref)
+               ref_mix_volume(b->f_out, b->f_in, 0.5f, b->len);
+            else
+               audio_mix_volume(b->f_out, b->f_in, 0.5f, b->len);
+            break;
+         case 3:
+            if (ref)
+               scalar_mix_clamp(b->f_out, b->len);
+            else
+               audio_mix_clamp(b->f_out, b->len);
+            break;
+         case 4:
+            if (ref)
+               ref_dual_mono(b->f_out, b->f_in, b->len / 2);
+            else
+               convert_to_dual_mono_float(b->f_out, b->f_in, b->len / 2);
+            break;
+         case 5:
+            if (ref)
+               ref_mono_left(b->f_out, b->f_in, b->len / 2);
+            else
+               convert_to_mono_float_left(b->f_out, b->f_in, b->len / 2);
+            break;
+      }
+   }
+
+   t = bench_usec() - t;
+   /* Nanoseconds per sample */
+   return (double)t * 1000.0 / ((double)iterations * b->len);
+}
+
+int main(int argc, char **argv)
+{
+   static const char *ops[] = {
+      "s16_to_float", "float_to_s16", "mix_volume",
+      "mix_clamp", "dual_mono", "mono_left",
+   };
+   struct
+   {
+      const char *name;
+      uint64_t cpu;
+      bool supported;
+   } impls[3];
+   size_t num_impls = 0;
+   size_t samples   = 4096;
+   int iterations   = 20000;
+   bench_bufs_t b;
+   size_t i, j;
+
+   for (i = 1; i < (size_t)argc; i++)
+   {
+      if (!strcmp(argv[i], "-s") && i + 1 < (size_t)argc)
+         samples    = (size_t)atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-i") && i + 1 < (size_t)argc)
+         iterations = atoi(argv[++i]);
+      else
+      {
+         fprintf(stderr, "Usage: %s [-s samples] [-i iterations]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   /* Without any flags, the implementation the
+    * compiler targets (SSE2 on x86-64) is used */
+#if defined(__SSE2__)
+   impls[num_impls].name = "SSE2";
+#else
+   impls[num_impls].name = "C";
+#endif
+   impls[num_impls++].cpu = 0;
+#if defined(__x86_64__) || defined(__i386__)
+   if (__builtin_cpu_supports("avx2"))
+   {
+      impls[num_impls].name  = "AVX2";
+      impls[num_impls++].cpu = RETRO_SIMD_AVX2;
+   }
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+   impls[num_impls].name  = "NEON";
+   impls[num_impls++].cpu = RETRO_SIMD_NEON;
+#endif
+
+   for (j = 0; j < num_impls; j++)
+   {
+      select_simd(impls[j].cpu);
+      test_impl(impls[j].name);
+   }
+
+   b.len     = samples;
+   b.s16_in  = (int16_t*)malloc(samples * sizeof(int16_t));
+   b.s16_out = (int16_t*)malloc(samples * sizeof(int16_t));
+   b.f_in    = (float*)malloc(samples * sizeof(float));
+   b.f_out   = (float*)calloc(samples, sizeof(float));
+   fill_s16(b.s16_in, samples);
+   for (i = 0; i < samples; i++)
+      b.f_in[i] = ((float)(rng() & 0xFFFFFF) / 0x800000 - 1.0f) * 1.1f;
+
+   printf("%u samples per call, %d calls, ns/sample\n\n",
+         (unsigned)samples, iterations);
+   printf("%-14s %8s", "operation", "scalar");
+   for (j = 0; j < num_impls; j++)
+      printf(" %8s", impls[j].name);
+   printf("\n");
+
+   for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+   {
+      printf("%-14s %8.3f", ops[i], time_op((int)i, true, &b, iterations));
+      for (j = 0; j < num_impls; j++)
+      {
+         select_simd(impls[j].cpu);
+         printf(" %8.3f", time_op((int)i, false, &b, iterations));
+      }
+      printf("\n");
+   }
+
+   free(b.s16_in);
+   free(b.s16_out);
+   free(b.f_in);
+   free(b.f_out);
+
+   if (failures)
+   {
+      printf("\n%d checks failed\n", failures);
+      return 1;
+   }
+
+   printf("\nAll checks passed\n");
+   return 0;
+}
@@ -0,0 +1,309 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline simulation of dynamic audio rate control.
+ *
+ * An audio device drains a buffer in whole periods at its own clock,
+ * which may be off from nominal. Video frames arrive at the real
+ * refresh rate with jitter and the occasional hitch; each one writes
+ * the frame's worth of audio for the refresh rate the frontend
+ * assumed, scaled by the controller's adjustment. Writes block while
+ * the buffer is full, as with audio sync enabled.
+ *
+ * Every profile is run with the old proportional rule from
+ * audio_driver.c and with audio_rate_control.c, reporting:
+ *
+ *   underruns   device periods that found the buffer short (crackles)
+ *   blocked     time spent waiting for the buffer to drain (stutter)
+ *   latency     mean and standard deviation of the queued audio
+ *   pitch       standard deviation and peak of the rate adjustment,
+ *               and RMS frame-to-frame change (audible as wobble)
+ *
+ * Usage: drc_sim [-t seconds] [-p profile] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../../audio/audio_rate_control.h"
+
+#define SIM_RATE       48000.0
+#define SIM_DELTA      0.005    /* audio_rate_control_delta default */
+#define SIM_WARMUP     10.0     /* Seconds left out of the statistics */
+
+typedef struct sim_profile
+{
+   const char *name;
+   const char *desc;
+   double refresh;        /* What the frontend assumes */
+   double refresh_real;   /* What the display does */
+   double wander;         /* Relative amplitude of refresh wander */
+   double wander_period;  /* Seconds */
+   double step;           /* Relative refresh change ... */
+   double step_at;        /* ... at this time */
+   double device_ppm;     /* Device clock error */
+   double jitter_ms;      /* Frame time jitter, standard deviation */
+   double hitch_ms;       /* Late frames ... */
+   double hitch_every;    /* ... on average every this many seconds */
+   unsigned period;       /* Device period, frames */
+   double latency_ms;     /* Buffer size */
+   double target_ms;      /* Controller target, 0 for half the buffer */
+} sim_profile_t;
+
+static const sim_profile_t sim_profiles[] = {
+   { "matched",   "60 Hz display, exact clocks",
+      60.0,   60.0,   0.0,    0.0,   0.0,   0.0,    0.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+   { "ntsc",      "59.94 Hz display taken for 60 Hz",
+      60.0,   59.94,  0.0,    0.0,   0.0,   0.0,    0.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+   { "devclock",  "sound card clock 300 ppm fast",
+      60.0,   60.0,   0.0,    0.0,   0.0,   0.0,  300.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+   { "wander",    "refresh wandering +-0.08% over 40 s",
+      60.0,   60.0,   0.0008, 40.0,  0.0,   0.0,    0.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+   { "step",      "refresh drops 0.2% after 60 s",
+      60.0,   60.0,   0.0,    0.0,  -0.002, 60.0,   0.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+   { "jittery",   "4 ms frame jitter, 25 ms hitches, 1024 frame periods",
+      60.0,   59.97,  0.0,    0.0,   0.0,   0.0,  100.0, 4.0, 25.0, 15.0, 1024, 64.0,  0.0 },
+   { "bigperiod", "2048 frame device periods",
+      60.0,   59.95,  0.0,    0.0,   0.0,   0.0,    0.0, 1.0,  0.0, 0.0, 2048, 96.0,  0.0 },
+   { "highhz",    "144 Hz display taken for 144 Hz, 100 ppm device",
+      144.0,  143.98, 0.0,    0.0,   0.0,   0.0,  100.0, 0.5,  0.0, 0.0,  256, 32.0,  0.0 },
+   { "lowlat",    "59.94 Hz display, 64 ms buffer, 24 ms target",
+      60.0,   59.94,  0.0,    0.0,   0.0,   0.0,    0.0, 1.0,  0.0, 0.0,  256, 64.0, 24.0 },
+   { "edge",      "0.4% mismatch, close to the limit",
+      60.0,   59.76,  0.0,    0.0,   0.0,   0.0,    0.0, 1.0,  0.0, 0.0,  512, 64.0,  0.0 },
+};
+
+#define SIM_NUM_PROFILES (sizeof(sim_profiles) / sizeof(sim_profiles[0]))
+
+enum sim_controller
+{
+   SIM_LEGACY = 0,
+   SIM_KALMAN
+};
+
+typedef struct sim_result
+{
+   unsigned underruns;
+   double blocked_ms;
+   double lat_mean_ms;
+   double lat_std_ms;
+   double pitch_std_cents;
+   double pitch_max_cents;
+   double wobble_cents;
+   double drift_est;
+   double drift_true;
+} sim_result_t;
+
+static uint64_t sim_rng_state;
+
+static double sim_uniform(void)
+{
+   sim_rng_state ^= sim_rng_state << 13;
+   sim_rng_state ^= sim_rng_state >> 7;
+   sim_rng_state ^= sim_rng_state << 17;
+   return (double)(sim_rng_state >> 11) / 9007199254740992.0;
+}
+
+static double sim_gauss(void)
+{
+   double u = sim_uniform();
+   double v = sim_uniform();
+   if (u < 1e-12)
+      u = 1e-12;
+   return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static double sim_cents(double adjust)
+{
+   return 1200.0 * log(1.0 + adjust) / log(2.0);
+}
+
+static double sim_refresh_at(const sim_profile_t *p, double t)
+{
+   double hz = p->refresh_real;
+   if (p->wander > 0.0)
+      hz *= 1.0 + p->wander * sin(2.0 * M_PI * t / p->wander_period);
+   if (p->step != 0.0 && t >= p->step_at)
+      hz *= 1.0 + p->step;
+   return hz;
+}
+
+static void sim_run(const sim_profile_t *p, enum sim_controller ctl,
+      double duration, sim_result_t *res)
+{
+   audio_rate_control_t rc;
+   double buffer       = p->latency_ms * SIM_RATE / 1000.0;
+   double target       = (p->target_ms > 0.0 ? p->target_ms / 1000.0
+         : buffer / SIM_RATE / 2.0);
+   double dev_rate     = SIM_RATE * (1.0 + p->device_ppm / 1000000.0);
+   double dev_t        = (double)p->period / dev_rate;
+   double frame_grid   = 0.0;
+   double fill         = target * SIM_RATE;
+   double adjust       = 0.0;
+   double prev_cents   = 0.0;
+   double n            = 0.0;
+   double lat_sum      = 0.0, lat_sq  = 0.0;
+   double pitch_sum    = 0.0, pitch_sq = 0.0;
+   double wobble_sq    = 0.0;
+   double carry        = 0.0;
+   double next_hitch   = p->hitch_every > 0.0
+      ? p->hitch_every * (0.5 + sim_uniform()) : 1e30;
+
+   memset(res, 0, sizeof(*res));
+   audio_rate_control_init(&rc, SIM_DELTA);
+   sim_rng_state = 0x9E3779B97F4A7C15ull;
+
+   while (frame_grid < duration)
+   {
+      double hz      = sim_refresh_at(p, frame_grid);
+      double t       = frame_grid + p->jitter_ms / 1000.0 * fabs(sim_gauss());
+      double out;
+      double queued;
+
+      if (t >= next_hitch)
+      {
+         t          += p->hitch_ms / 1000.0;
+         next_hitch += p->hitch_every * (0.5 + sim_uniform());
+      }
+
+      /* Device periods up to this frame */
+      while (dev_t <= t)
+      {
+         if (fill < p->period)
+         {
+            if (frame_grid > 1.0)
+               res->underruns++;
+            fill = 0.0;
+         }
+         else
+            fill -= p->period;
+         dev_t += (double)p->period / dev_rate;
+      }
+
+      /* Measure, as write_avail() before writing the frame */
+      queued = fill / SIM_RATE;
+
+      if (ctl == SIM_LEGACY)
+      {
+         double avail     = buffer - fill;
+         double half_size = buffer / 2.0;
+         adjust           = SIM_DELTA * (avail - half_size) / half_size;
+      }
+      else
+         adjust = audio_rate_control_update(&rc, queued, target,
+               (int64_t)(t * 1000000.0));
+
+      /* The frame's audio, for the assumed refresh rate */
+      out    = SIM_RATE / p->refresh * (1.0 + adjust) + carry;
+      carry  = out - floor(out);
+      out    = floor(out);
+
+      /* Block while the buffer is full */
+      while (fill + out > buffer)
+      {
+         res->blocked_ms += (dev_t - t) * 1000.0;
+         t                = dev_t;
+         if (fill < p->period)
+            fill = 0.0;
+         else
+            fill -= p->period;
+         dev_t += (double)p->period / dev_rate;
+      }
+      fill += out;
+
+      if (frame_grid >= SIM_WARMUP)
+      {
+         double cents = sim_cents(adjust);
+         n           += 1.0;
+         lat_sum     += queued * 1000.0;
+         lat_sq      += queued * queued * 1000000.0;
+         pitch_sum   += cents;
+         pitch_sq    += cents * cents;
+         wobble_sq   += (cents - prev_cents) * (cents - prev_cents);
+         if (fabs(cents) > res->pitch_max_cents)
+            res->pitch_max_cents = fabs(cents);
+      }
+      prev_cents = sim_cents(adjust);
+
+      /* Next vblank after the frame went out */
+      frame_grid += 1.0 / hz;
+      while (frame_grid < t)
+         frame_grid += 1.0 / hz;
+   }
+
+   if (n > 1.0)
+   {
+      res->lat_mean_ms     = lat_sum / n;
+      res->lat_std_ms      = sqrt(fmax(0.0, lat_sq / n
+               - res->lat_mean_ms * res->lat_mean_ms));
+      res->pitch_std_cents = sqrt(fmax(0.0, pitch_sq / n
+               - (pitch_sum / n) * (pitch_sum / n)));
+      res->wobble_cents    = sqrt(wobble_sq / n);
+   }
+   res->drift_est  = rc.drift;
+   res->drift_true = dev_rate / SIM_RATE
+      * p->refresh / sim_refresh_at(p, duration) - 1.0;
+}
+
+static void sim_print(const char *ctl, const sim_result_t *r, bool kalman)
+{
+   printf("  %-7s %5u %9.1f %7.1f %6.2f %8.2f %8.2f %8.3f",
+         ctl, r->underruns, r->blocked_ms, r->lat_mean_ms, r->lat_std_ms,
+         r->pitch_std_cents, r->pitch_max_cents, r->wobble_cents);
+   if (kalman)
+      printf("   %+5.0f/%+5.0f ppm", r->drift_est * 1e6, r->drift_true * 1e6);
+   printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   unsigned p;
+   double duration     = 600.0;
+   const char *only    = NULL;
+
+   for (i = 1; i + 1 < argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-t"))
+         duration = atof(argv[i + 1]);
+      else if (!strcmp(argv[i], "-p"))
+         only     = argv[i + 1];
+   }
+
+   printf("%.0f s per run, statistics after %.0f s\n\n", duration, SIM_WARMUP);
+   printf("  %-7s %5s %9s %7s %6s %8s %8s %8s   %s\n",
+         "", "under", "blocked", "latency", "+-", "pitch sd", "max", "wobble",
+         "drift est/true");
+   printf("  %-7s %5s %9s %7s %6s %8s %8s %8s\n",
+         "", "runs", "ms", "ms", "ms", "cents", "cents", "cents");
+
+   for (p = 0; p < SIM_NUM_PROFILES; p++)
+   {
+      sim_result_t legacy, kalman;
+      const sim_profile_t *prof = &sim_profiles[p];
+
+      if (only && strcmp(only, prof->name))
+         continue;
+
+      sim_run(prof, SIM_LEGACY, duration, &legacy);
+      sim_run(prof, SIM_KALMAN, duration, &kalman);
+
+      printf("\n%s: %s\n", prof->name, prof->desc);
+      sim_print("old", &legacy, false);
+      sim_print("new", &kalman, true);
+   }
+
+   return 0;
+}
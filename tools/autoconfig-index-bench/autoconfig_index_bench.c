@@ -0,0 +1,597 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times autoconfig profile lookup on device connect.
+ *
+ * Either generates a directory of synthetic profiles shaped like the
+ * udev ones in the autoconfig pack (shared device names, alternatives,
+ * physical locations), or uses an existing autoconfig directory.
+ * Each simulated connect is resolved both the way task_autodetect.c
+ * used to, parsing every file, and through input_autodetect_index.c.
+ * Both must pick the same profile with the same affinity.
+ *
+ * The index is timed when built from scratch, when loaded from the
+ * cache directory on startup, and when already in memory. Adding a
+ * profile to the directory must be picked up.
+ *
+ * Usage: autoconfig_index_bench [-n profiles] [-c connects] [-d dir] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <lists/string_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "../../input/input_autodetect_index.h"
+
+#define BENCH_BUTTONS 16
+
+typedef struct bench_query
+{
+   char name[64];
+   char phys[64];
+   uint16_t vid;
+   uint16_t pid;
+} bench_query_t;
+
+static const char *bench_buttons[BENCH_BUTTONS] = {
+   "b", "y", "select", "start", "up", "down", "left", "right",
+   "a", "x", "l", "r", "l2", "r2", "l3", "r3"
+};
+
+static const char *bench_shared_names[] = {
+   "Generic   USB  Joystick  ",
+   "USB Gamepad ",
+   "Xbox 360 Wireless Receiver",
+   "Sony PLAYSTATION(R)3 Controller"
+};
+
+static uint64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t bench_rng_state = 0x12345678;
+
+static uint32_t bench_rng(void)
+{
+   bench_rng_state ^= bench_rng_state << 13;
+   bench_rng_state ^= bench_rng_state >> 17;
+   bench_rng_state ^= bench_rng_state << 5;
+   return bench_rng_state;
+}
+
+/* Profile @i of the synthetic set. Every 5th shares a device
+ * name with others, every 7th has no IDs, every 11th carries
+ * alternatives and every 13th pins a physical location, with
+ * the next one claiming the same device */
+static void bench_profile_device(unsigned i, char *name, size_t len,
+      uint16_t *vid, uint16_t *pid)
+{
+   if (i % 5 == 0)
+      strlcpy(name, bench_shared_names[(i / 5) % 4], len);
+   else
+      snprintf(name, len, "Synthetic Pad %u", i);
+   *vid = (i % 7 == 0) ? 0 : (uint16_t)(0x1000 + i / 3);
+   *pid = (i % 7 == 0) ? 0 : (uint16_t)(0x2000 + i % 3);
+}
+
+static bool bench_write_profile(const char *dir, unsigned i)
+{
+   unsigned b;
+   char path[PATH_MAX_LENGTH];
+   char name[64];
+   uint16_t vid, pid;
+   FILE *f;
+
+   snprintf(path, sizeof(path), "%s/Synthetic_%05u.cfg", dir, i);
+   if (!(f = fopen(path, "w")))
+      return false;
+
+   bench_profile_device(i, name, sizeof(name), &vid, &pid);
+
+   fprintf(f, "# Synthetic profile %u\n", i);
+   fprintf(f, "input_driver = \"udev\"\n");
+   fprintf(f, "input_device = \"%s\"\n", name);
+   fprintf(f, "input_device_display_name = \"Synthetic %u\"\n", i);
+   if (vid)
+   {
+      fprintf(f, "input_vendor_id = \"%u\"\n", vid);
+      fprintf(f, "input_product_id = \"%u\"\n", pid);
+   }
+   if (i % 11 == 0)
+   {
+      fprintf(f, "input_device_alt1 = \"Synthetic Alt %u\"\n", i);
+      fprintf(f, "input_vendor_id_alt2 = \"%u\"\n", 0x7000 + i);
+      fprintf(f, "input_product_id_alt2 = \"%u\"\n", 0x7001);
+      fprintf(f, "input_device_display_name_alt2 = \"Synthetic %u alt\"\n", i);
+   }
+   if (i % 13 == 0)
+      fprintf(f, "input_phys = \"usb-%u\"\n", i % 4);
+   /* Same device as the previous profile, through an alternative
+    * scoring higher: the earlier profile must still win */
+   if (i % 13 == 1 && i > 1)
+   {
+      bench_profile_device(i - 1, name, sizeof(name), &vid, &pid);
+      fprintf(f, "input_device_alt1 = \"%s\"\n", name);
+      fprintf(f, "input_vendor_id_alt1 = \"%u\"\n", vid);
+      fprintf(f, "input_product_id_alt1 = \"%u\"\n", pid);
+      fprintf(f, "input_phys_alt1 = \"usb-%u\"\n", (i - 1) % 4);
+   }
+
+   for (b = 0; b < BENCH_BUTTONS; b++)
+   {
+      fprintf(f, "input_%s_btn = \"%u\"\n", bench_buttons[b], b);
+      fprintf(f, "input_%s_btn_label = \"Button %s\"\n",
+            bench_buttons[b], bench_buttons[b]);
+   }
+   fprintf(f, "input_l_x_plus_axis = \"+0\"\ninput_l_x_minus_axis = \"-0\"\n");
+   fprintf(f, "input_l_y_plus_axis = \"+1\"\ninput_l_y_minus_axis = \"-1\"\n");
+   fprintf(f, "input_r_x_plus_axis = \"+3\"\ninput_r_x_minus_axis = \"-3\"\n");
+   fprintf(f, "input_r_y_plus_axis = \"+4\"\ninput_r_y_minus_axis = \"-4\"\n");
+   fprintf(f, "input_menu_toggle_btn = \"10\"\n");
+   fclose(f);
+   return true;
+}
+
+/* input_autoconfigure_get_config_file_affinity() */
+static unsigned bench_affinity(config_file_t *config,
+      const input_autodetect_device_t *device)
+{
+   int i;
+   char config_key[30];
+   unsigned max_affinity = 0;
+
+   for (i = 0; i < 10; i++)
+   {
+      size_t _len;
+      char postfix[7];
+      struct config_entry_list *entry = NULL;
+      uint16_t config_vid = 0;
+      uint16_t config_pid = 0;
+      int tmp_int         = 0;
+      unsigned affinity   = 0;
+
+      if (i == 0)
+         postfix[0] = '\0';
+      else
+         snprintf(postfix, sizeof(postfix), "_alt%d", i);
+
+      _len = strlcpy(config_key, "input_vendor_id", sizeof(config_key));
+      strlcpy(config_key + _len, postfix, sizeof(config_key) - _len);
+      if (config_get_int(config, config_key, &tmp_int))
+         config_vid = (uint16_t)tmp_int;
+
+      _len = strlcpy(config_key, "input_product_id", sizeof(config_key));
+      strlcpy(config_key + _len, postfix, sizeof(config_key) - _len);
+      if (config_get_int(config, config_key, &tmp_int))
+         config_pid = (uint16_t)tmp_int;
+
+      if (     device->vid == config_vid
+            && device->pid == config_pid
+            && config_vid != 0
+            && config_pid != 0)
+         affinity += 30;
+
+      _len = strlcpy(config_key, "input_device", sizeof(config_key));
+      strlcpy(config_key + _len, postfix, sizeof(config_key) - _len);
+      if (     (entry = config_get_entry(config, config_key))
+            && !string_is_empty(entry->value)
+            &&  string_is_equal(entry->value, device->name))
+         affinity += 20;
+
+      _len = strlcpy(config_key, "input_phys", sizeof(config_key));
+      strlcpy(config_key + _len, postfix, sizeof(config_key) - _len);
+      if (     affinity >= 20
+            && (entry = config_get_entry(config, config_key))
+            && !string_is_empty(entry->value))
+      {
+         if (strstr(device->phys, entry->value))
+            affinity += 10;
+         else
+            affinity -= 10;
+      }
+
+      if (affinity > 0)
+         affinity += i;
+
+      if (max_affinity < affinity)
+         max_affinity = affinity;
+   }
+
+   return max_affinity;
+}
+
+/* input_autoconfigure_scan_config_files_external() */
+static config_file_t *bench_scan(const char *dir,
+      const input_autodetect_device_t *device, unsigned *max_affinity)
+{
+   size_t i;
+   config_file_t *best_config = NULL;
+   struct string_list *list   = dir_list_new(dir, "cfg",
+         false, false, false, false);
+
+   *max_affinity = 0;
+   if (!list)
+      return NULL;
+
+   for (i = 0; i < list->size; i++)
+   {
+      unsigned affinity;
+      config_file_t *config = config_file_new_from_path_to_string(
+            list->elems[i].data);
+
+      if (!config)
+         continue;
+
+      affinity = bench_affinity(config, device);
+      if (affinity > *max_affinity)
+      {
+         if (best_config)
+            config_file_free(best_config);
+         best_config   = config;
+         *max_affinity = affinity;
+         if (affinity >= 60)
+            break;
+      }
+      else
+         config_file_free(config);
+   }
+
+   string_list_free(list);
+   return best_config;
+}
+
+static void bench_make_queries(bench_query_t *queries, unsigned count,
+      unsigned profiles)
+{
+   unsigned q;
+
+   for (q = 0; q < count; q++)
+   {
+      bench_query_t *query = &queries[q];
+      unsigned i           = bench_rng() % (profiles + profiles / 8);
+
+      query->phys[0] = '\0';
+      snprintf(query->phys, sizeof(query->phys), "usb-%u/input0",
+            bench_rng() % 4);
+
+      /* Some unknown devices, some that only match by
+       * name, by IDs or through an alternative */
+      if (i >= profiles)
+      {
+         snprintf(query->name, sizeof(query->name), "Unknown Pad %u", i);
+         query->vid = (uint16_t)(0x9000 + i);
+         query->pid = 1;
+         continue;
+      }
+
+      bench_profile_device(i, query->name, sizeof(query->name),
+            &query->vid, &query->pid);
+
+      switch (bench_rng() % 6)
+      {
+         case 0:
+            query->vid = query->pid = 0;
+            break;
+         case 1:
+            snprintf(query->name, sizeof(query->name), "Renamed Pad %u", i);
+            break;
+         case 2:
+            if (i % 11 == 0)
+            {
+               snprintf(query->name, sizeof(query->name),
+                     "Synthetic Alt %u", i);
+               query->vid = (uint16_t)(0x7000 + i);
+               query->pid = 0x7001;
+            }
+            break;
+         default:
+            break;
+      }
+   }
+}
+
+static const char *bench_config_name(config_file_t *conf)
+{
+   return conf ? path_basename(conf->path) : "(none)";
+}
+
+/* Checks that the index picks what the scan picks, including
+ * the bindings it hands back */
+static unsigned bench_verify(const char *dir, const char *cache_dir,
+      const bench_query_t *queries, unsigned count)
+{
+   unsigned q;
+   unsigned bad = 0;
+
+   for (q = 0; q < count; q++)
+   {
+      input_autodetect_device_t device;
+      config_file_t *scanned  = NULL;
+      config_file_t *indexed  = NULL;
+      unsigned scan_affinity  = 0;
+      unsigned index_affinity = 0;
+      bool same;
+
+      device.name = queries[q].name;
+      device.phys = queries[q].phys;
+      device.vid  = queries[q].vid;
+      device.pid  = queries[q].pid;
+
+      scanned = bench_scan(dir, &device, &scan_affinity);
+      input_autodetect_index_find(dir, cache_dir, &device,
+            &indexed, &index_affinity);
+
+      same = (!scanned == !indexed) && scan_affinity == index_affinity;
+      if (same && scanned)
+      {
+         struct config_file_entry entry;
+         same = string_is_equal(scanned->path, indexed->path);
+         if (config_get_entry_list_head(scanned, &entry))
+         {
+            do
+            {
+               struct config_entry_list *e = config_get_entry(indexed, entry.key);
+               struct config_entry_list *s = config_get_entry(scanned, entry.key);
+               if (!e || !string_is_equal(e->value, s->value))
+                  same = false;
+            } while (config_get_entry_list_next(&entry));
+         }
+      }
+
+      if (!same)
+      {
+         if (bad < 10)
+            printf("  mismatch for \"%s\" %04x:%04x: scan %s (%u), index %s (%u)\n",
+                  device.name, device.vid, device.pid,
+                  bench_config_name(scanned), scan_affinity,
+                  bench_config_name(indexed), index_affinity);
+         bad++;
+      }
+
+      if (scanned)
+         config_file_free(scanned);
+      if (indexed)
+         config_file_free(indexed);
+   }
+
+   return bad;
+}
+
+static double bench_index_connects(const char *dir, const char *cache_dir,
+      const bench_query_t *queries, unsigned count)
+{
+   unsigned q;
+   uint64_t start = bench_usec();
+
+   for (q = 0; q < count; q++)
+   {
+      input_autodetect_device_t device;
+      config_file_t *conf = NULL;
+      unsigned affinity   = 0;
+
+      device.name = queries[q].name;
+      device.phys = queries[q].phys;
+      device.vid  = queries[q].vid;
+      device.pid  = queries[q].pid;
+
+      input_autodetect_index_find(dir, cache_dir, &device, &conf, &affinity);
+      if (conf)
+         config_file_free(conf);
+   }
+
+   return (double)(bench_usec() - start) / count;
+}
+
+static double bench_scan_connects(const char *dir,
+      const bench_query_t *queries, unsigned count)
+{
+   unsigned q;
+   uint64_t start = bench_usec();
+
+   for (q = 0; q < count; q++)
+   {
+      input_autodetect_device_t device;
+      config_file_t *conf;
+      unsigned affinity = 0;
+
+      device.name = queries[q].name;
+      device.phys = queries[q].phys;
+      device.vid  = queries[q].vid;
+      device.pid  = queries[q].pid;
+
+      if ((conf = bench_scan(dir, &device, &affinity)))
+         config_file_free(conf);
+   }
+
+   return (double)(bench_usec() - start) / count;
+}
+
+/* Returns the time of a single connect with the
+ * index in the given state */
+static double bench_index_once(const char *dir, const char *cache_dir,
+      const bench_query_t *query)
+{
+   input_autodetect_device_t device;
+   config_file_t *conf = NULL;
+   unsigned affinity   = 0;
+   uint64_t start;
+
+   device.name = query->name;
+   device.phys = query->phys;
+   device.vid  = query->vid;
+   device.pid  = query->pid;
+
+   start = bench_usec();
+   input_autodetect_index_find(dir, cache_dir, &device, &conf, &affinity);
+   start = bench_usec() - start;
+   if (conf)
+      config_file_free(conf);
+   return (double)start;
+}
+
+static void bench_remove_dir(const char *dir)
+{
+   size_t i;
+   struct string_list *list = dir_list_new(dir, NULL,
+         false, true, false, false);
+
+   if (list)
+   {
+      for (i = 0; i < list->size; i++)
+         filestream_delete(list->elems[i].data);
+      string_list_free(list);
+   }
+   rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   char root[]    = "/tmp/autoconfig-bench-XXXXXX";
+   char dir[PATH_MAX_LENGTH];
+   char cache_dir[PATH_MAX_LENGTH];
+   const char *user_dir = NULL;
+   unsigned profiles    = 2500;
+   unsigned connects    = 200;
+   unsigned bad         = 0;
+   size_t num_files;
+   bench_query_t *queries;
+   double scan, cold, warm, hot;
+
+   for (i = 1; i + 1 < argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-n"))
+         profiles = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-c"))
+         connects = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-d"))
+         user_dir = argv[i + 1];
+   }
+
+   if (!mkdtemp(root))
+      return 1;
+   snprintf(cache_dir, sizeof(cache_dir), "%s/cache", root);
+
+   if (user_dir)
+      strlcpy(dir, user_dir, sizeof(dir));
+   else
+   {
+      unsigned p;
+      snprintf(dir, sizeof(dir), "%s/udev", root);
+      path_mkdir(dir);
+      for (p = 0; p < profiles; p++)
+         if (!bench_write_profile(dir, p))
+            return 1;
+      /* Let the directory settle, see AUTODETECT_INDEX_SETTLE_SEC */
+      sleep(3);
+   }
+
+   if (!(queries = (bench_query_t*)malloc(connects * sizeof(*queries))))
+      return 1;
+   bench_make_queries(queries, connects, profiles);
+
+   {
+      struct string_list *list = dir_list_new(dir, "cfg",
+            false, false, false, false);
+      num_files = list ? list->size : 0;
+      if (list)
+         string_list_free(list);
+   }
+   printf("%u profiles in %s, %u connects\n\n",
+         (unsigned)num_files, dir, connects);
+
+   scan = bench_scan_connects(dir, queries, connects);
+   cold = bench_index_once(dir, cache_dir, &queries[0]);
+   input_autodetect_index_free();
+   warm = bench_index_once(dir, cache_dir, &queries[0]);
+   hot  = bench_index_connects(dir, cache_dir, queries, connects);
+
+   printf("scan every profile:      %10.1f us/connect\n", scan);
+   printf("index, build and save:   %10.1f us\n", cold);
+   printf("index, load from cache:  %10.1f us\n", warm);
+   printf("index, in memory:        %10.1f us/connect\n\n", hot);
+
+   bad += bench_verify(dir, cache_dir, queries, connects);
+
+   /* A new profile changes the directory */
+   if (!user_dir)
+   {
+      bench_query_t added;
+      config_file_t *conf = NULL;
+      unsigned affinity   = 0;
+      input_autodetect_device_t device;
+
+      sleep(3);
+      bench_write_profile(dir, profiles);
+      sleep(3);
+
+      bench_profile_device(profiles, added.name, sizeof(added.name),
+            &added.vid, &added.pid);
+      added.phys[0] = '\0';
+      device.name   = added.name;
+      device.phys   = added.phys;
+      device.vid    = added.vid;
+      device.pid    = added.pid;
+
+      input_autodetect_index_find(dir, cache_dir, &device, &conf, &affinity);
+      if (!conf || !strstr(conf->path, "Synthetic_"))
+      {
+         printf("  added profile not found\n");
+         bad++;
+      }
+      else
+      {
+         char expected[32];
+         snprintf(expected, sizeof(expected), "Synthetic_%05u.cfg", profiles);
+         if (!string_is_equal(path_basename(conf->path), expected))
+         {
+            printf("  added profile not found, got %s\n",
+                  path_basename(conf->path));
+            bad++;
+         }
+      }
+      if (conf)
+         config_file_free(conf);
+      bad += bench_verify(dir, cache_dir, queries, connects);
+   }
+
+   input_autodetect_index_free();
+   free(queries);
+
+   if (!user_dir)
+      bench_remove_dir(dir);
+   bench_remove_dir(cache_dir);
+   rmdir(root);
+
+   if (bad)
+   {
+      printf("FAILED: %u lookups differ from the scan\n", bad);
+      return 1;
+   }
+   printf("index matches the scan for every connect\n");
+   return 0;
+}
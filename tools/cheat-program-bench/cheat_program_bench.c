@@ -0,0 +1,522 @@
+/* Compiled cheat program benchmark and equivalence test.
+ *
+ * Generates cheat sets over core memory split in several buffers:
+ * every cheat type including conditions, all search sizes, bit
+ * writes, repeats with address and value steps, both endiannesses
+ * and rumble. Each set is applied for a number of frames both by the
+ * interpreter cheat_manager_apply_retro_cheats() used to run (kept
+ * below as the reference) and by cheat_program_apply(), on two copies
+ * of the same memory; memory, rumble calls and the 'cheat applied'
+ * result must match after every frame. Then times both on large
+ * cheat packs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../cheat_program.h"
+
+#define NUM_BUFFERS_MAX  4
+#define ARENA_PAD        16
+#define NUM_SETS         2000
+#define FRAMES_PER_SET   8
+#define RUMBLE_LOG_MAX   4096
+
+typedef struct
+{
+   uint8_t *arena;
+   size_t arena_size;
+   uint8_t *bufs[NUM_BUFFERS_MAX];
+   unsigned sizes[NUM_BUFFERS_MAX];
+   unsigned num_bufs;
+   unsigned total;
+} memory_t;
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static double now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Rumble calls, in order */
+
+static const struct item_cheat *rumble_base;
+static unsigned rumble_log[RUMBLE_LOG_MAX][2];
+static unsigned rumble_count;
+
+static void rumble_record(struct item_cheat *cheat, unsigned int value)
+{
+   if (rumble_count < RUMBLE_LOG_MAX)
+   {
+      rumble_log[rumble_count][0] = (unsigned)(cheat - rumble_base);
+      rumble_log[rumble_count][1] = value;
+   }
+   rumble_count++;
+}
+
+/* Reference: the interpreter, as it was in cheat_manager.c */
+
+static unsigned translate_address(const cheat_manager_t *cheat_st,
+      unsigned address, unsigned char **curr)
+{
+   unsigned             offset = 0;
+   unsigned                  i = 0;
+
+   for (i = 0; i < cheat_st->num_memory_buffers; i++)
+   {
+      if ((address >= offset) && (address < offset + cheat_st->memory_size_list[i]))
+      {
+         *curr = cheat_st->memory_buf_list[i];
+         break;
+      }
+      else
+         offset += cheat_st->memory_size_list[i];
+   }
+
+   return offset;
+}
+
+static void setup_search_meta(unsigned int bitsize,
+      unsigned int *bytes_per_item, unsigned int *mask, unsigned int *bits)
+{
+   switch (bitsize)
+   {
+      case 0: *bytes_per_item = 1; *bits = 1; *mask = 0x01; break;
+      case 1: *bytes_per_item = 1; *bits = 2; *mask = 0x03; break;
+      case 2: *bytes_per_item = 1; *bits = 4; *mask = 0x0F; break;
+      case 3: *bytes_per_item = 1; *bits = 8; *mask = 0xFF; break;
+      case 4: *bytes_per_item = 2; *bits = 8; *mask = 0xFFFF; break;
+      case 5: *bytes_per_item = 4; *bits = 8; *mask = 0xFFFFFFFF; break;
+   }
+}
+
+static bool reference_apply(cheat_manager_t *cheat_st)
+{
+   unsigned i;
+   unsigned int offset;
+   unsigned int mask           = 0;
+   unsigned int bytes_per_item = 1;
+   unsigned int bits           = 8;
+   unsigned int curr_val       = 0;
+   bool run_cheat              = true;
+   bool cheat_applied          = false;
+
+   for (i = 0; i < cheat_st->size; i++)
+   {
+      unsigned char *curr       = NULL;
+      bool set_value            = false;
+      unsigned int idx          = 0;
+      unsigned int value_to_set = 0;
+      unsigned int repeat_iter  = 0;
+      unsigned int address_mask = cheat_st->cheats[i].address_mask;
+
+      if (cheat_st->cheats[i].handler != CHEAT_HANDLER_TYPE_RETRO || !cheat_st->cheats[i].state)
+         continue;
+
+      if (!run_cheat)
+      {
+         run_cheat = true;
+         continue;
+      }
+      setup_search_meta(cheat_st->cheats[i].memory_search_size, &bytes_per_item, &mask, &bits);
+
+      curr   = cheat_st->curr_memory_buf;
+      idx    = cheat_st->cheats[i].address;
+
+      offset = translate_address(cheat_st, idx, &curr);
+
+      switch (bytes_per_item)
+      {
+         case 2:
+            curr_val = cheat_st->big_endian ?
+               (*(curr + idx - offset) * 256) + *(curr + idx + 1 - offset) :
+               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256);
+            break;
+         case 4:
+            curr_val = cheat_st->big_endian ?
+               ((unsigned)*(curr + idx - offset) * 256 * 256 * 256) + (*(curr + idx + 1 - offset) * 256 * 256) + (*(curr + idx + 2 - offset) * 256) + *(curr + idx + 3 - offset) :
+               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256) + (*(curr + idx + 2 - offset) * 256 * 256) + ((unsigned)*(curr + idx + 3 - offset) * 256 * 256 * 256);
+            break;
+         case 1:
+         default:
+            curr_val = *(curr + idx - offset);
+            break;
+      }
+
+      if (cheat_st->cheats[i].rumble_type != RUMBLE_TYPE_DISABLED)
+         rumble_record(&cheat_st->cheats[i], curr_val);
+
+      switch (cheat_st->cheats[i].cheat_type)
+      {
+         case CHEAT_TYPE_SET_TO_VALUE:
+            set_value = true;
+            value_to_set = cheat_st->cheats[i].value;
+            break;
+         case CHEAT_TYPE_INCREASE_VALUE:
+            set_value = true;
+            value_to_set = curr_val + cheat_st->cheats[i].value;
+            break;
+         case CHEAT_TYPE_DECREASE_VALUE:
+            set_value = true;
+            value_to_set = curr_val - cheat_st->cheats[i].value;
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_EQ:
+            if (!(curr_val == cheat_st->cheats[i].value))
+               run_cheat = false;
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_NEQ:
+            if (!(curr_val != cheat_st->cheats[i].value))
+               run_cheat = false;
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_LT:
+            if (!(cheat_st->cheats[i].value < curr_val))
+               run_cheat = false;
+            break;
+         case CHEAT_TYPE_RUN_NEXT_IF_GT:
+            if (!(cheat_st->cheats[i].value > curr_val))
+               run_cheat = false;
+            break;
+      }
+
+      if (set_value)
+      {
+         cheat_applied = true;
+         for (repeat_iter = 1; repeat_iter <= cheat_st->cheats[i].repeat_count; repeat_iter++)
+         {
+            switch (bytes_per_item)
+            {
+               case 2:
+                  if (cheat_st->cheats[i].big_endian)
+                  {
+                     *(curr + idx - offset) = (value_to_set >> 8) & 0xFF;
+                     *(curr + idx + 1 - offset) = value_to_set & 0xFF;
+                  }
+                  else
+                  {
+                     *(curr + idx - offset) = value_to_set & 0xFF;
+                     *(curr + idx + 1 - offset) = (value_to_set >> 8) & 0xFF;
+                  }
+                  break;
+               case 4:
+                  if (cheat_st->cheats[i].big_endian)
+                  {
+                     *(curr + idx - offset) = (value_to_set >> 24) & 0xFF;
+                     *(curr + idx + 1 - offset) = (value_to_set >> 16) & 0xFF;
+                     *(curr + idx + 2 - offset) = (value_to_set >> 8) & 0xFF;
+                     *(curr + idx + 3 - offset) = value_to_set & 0xFF;
+                  }
+                  else
+                  {
+                     *(curr + idx - offset) = value_to_set & 0xFF;
+                     *(curr + idx + 1 - offset) = (value_to_set >> 8) & 0xFF;
+                     *(curr + idx + 2 - offset) = (value_to_set >> 16) & 0xFF;
+                     *(curr + idx + 3 - offset) = (value_to_set >> 24) & 0xFF;
+                  }
+                  break;
+               case 1:
+                  if (bits < 8)
+                  {
+                     unsigned bitpos;
+                     unsigned char val = *(curr + idx - offset);
+
+                     for (bitpos = 0; bitpos < 8; bitpos++)
+                     {
+                        if ((address_mask >> bitpos) & 0x01)
+                        {
+                           mask = (~(1 << bitpos) & 0xFF);
+                           /* Clear current bit value */
+                           val = val & mask;
+                           /* Inject cheat bit value */
+                           val = val | (((value_to_set >> bitpos) & 0x01) << bitpos);
+                        }
+                     }
+
+                     *(curr + idx - offset) = val;
+                  }
+                  else
+                     *(curr + idx - offset) = value_to_set & 0xFF;
+                  break;
+               default:
+                  *(curr + idx - offset) = value_to_set & 0xFF;
+                  break;
+            }
+
+            value_to_set += cheat_st->cheats[i].repeat_add_to_value;
+
+            if (mask != 0)
+               value_to_set = value_to_set % mask;
+
+            if (bits < 8)
+            {
+               unsigned int bit_iter;
+               for (bit_iter = 0; bit_iter < cheat_st->cheats[i].repeat_add_to_address; bit_iter++)
+               {
+                  address_mask = (address_mask << mask) & 0xFF;
+
+                  if (address_mask == 0)
+                  {
+                     address_mask = mask;
+                     idx++;
+                  }
+               }
+            }
+            else
+               idx += (cheat_st->cheats[i].repeat_add_to_address * bytes_per_item);
+
+            idx = idx % cheat_st->total_memory_size;
+
+            offset = translate_address(cheat_st, idx, &curr);
+         }
+      }
+   }
+
+   return cheat_applied;
+}
+
+/* Generation */
+
+static void memory_new(memory_t *mem, unsigned num_bufs, unsigned max_size)
+{
+   unsigned i;
+   size_t pos = 0;
+
+   mem->num_bufs = num_bufs;
+   mem->total    = 0;
+   for (i = 0; i < num_bufs; i++)
+   {
+      mem->sizes[i]  = 16 + rng() % max_size;
+      mem->total    += mem->sizes[i];
+   }
+
+   /* One arena, so reads running past a buffer stay in bounds */
+   mem->arena_size = mem->total + (num_bufs + 1) * ARENA_PAD;
+   mem->arena      = (uint8_t*)malloc(mem->arena_size);
+   for (i = 0; i < mem->arena_size; i++)
+      mem->arena[i] = (uint8_t)rng();
+
+   for (i = 0; i < num_bufs; i++)
+   {
+      mem->bufs[i] = mem->arena + pos;
+      pos         += mem->sizes[i] + ARENA_PAD;
+   }
+}
+
+static void memory_clone(memory_t *dst, const memory_t *src)
+{
+   unsigned i;
+   *dst       = *src;
+   dst->arena = (uint8_t*)malloc(src->arena_size);
+   memcpy(dst->arena, src->arena, src->arena_size);
+   for (i = 0; i < src->num_bufs; i++)
+      dst->bufs[i] = dst->arena + (src->bufs[i] - src->arena);
+}
+
+static void state_init(cheat_manager_t *cheat_st, memory_t *mem,
+      struct item_cheat *cheats, unsigned size, bool big_endian)
+{
+   memset(cheat_st, 0, sizeof(*cheat_st));
+   cheat_st->cheats             = cheats;
+   cheat_st->size               = size;
+   cheat_st->memory_buf_list    = mem->bufs;
+   cheat_st->memory_size_list   = mem->sizes;
+   cheat_st->num_memory_buffers = mem->num_bufs;
+   cheat_st->total_memory_size  = mem->total;
+   cheat_st->curr_memory_buf    = mem->bufs[0];
+   cheat_st->big_endian         = big_endian;
+   cheat_st->memory_initialized = true;
+}
+
+static void cheat_random(struct item_cheat *cheat, unsigned total,
+      unsigned max_repeat)
+{
+   unsigned size = rng() % 6;
+
+   memset(cheat, 0, sizeof(*cheat));
+   cheat->handler            = (rng() % 8) ? CHEAT_HANDLER_TYPE_RETRO : CHEAT_HANDLER_TYPE_EMU;
+   cheat->state              = (rng() % 8) != 0;
+   cheat->memory_search_size = size;
+   cheat->cheat_type         = rng() % 8;
+   /* Stay clear of the end, multi-byte reads do not wrap */
+   cheat->address            = rng() % (total - 4);
+   cheat->big_endian         = rng() & 1;
+   cheat->repeat_count       = (rng() % 4) ? 1 : rng() % (max_repeat + 1);
+   cheat->repeat_add_to_address = 1 + rng() % 4;
+   cheat->repeat_add_to_value   = (rng() % 2) ? 0 : rng() % 16;
+   cheat->rumble_type        = (rng() % 4) ? RUMBLE_TYPE_DISABLED : 1 + rng() % 10;
+
+   switch (rng() % 4)
+   {
+      case 0:
+         cheat->value = rng();
+         break;
+      case 1:
+         cheat->value = rng() % 4;
+         break;
+      default:
+         cheat->value = rng() & ((size >= 5) ? 0xFFFFFFFF : (size == 4) ? 0xFFFF : 0xFF);
+         break;
+   }
+
+   /* Bit cheats: single bits, nibbles, or any mask */
+   if (size < 3)
+   {
+      switch (rng() % 3)
+      {
+         case 0:
+            cheat->address_mask = 1 << (rng() % 8);
+            break;
+         case 1:
+            cheat->address_mask = (rng() & 1) ? 0x0F : 0xF0;
+            break;
+         default:
+            cheat->address_mask = rng() & 0xFF;
+            break;
+      }
+   }
+}
+
+/* Equivalence */
+
+static int run_equivalence(void)
+{
+   unsigned set, frame, i;
+   int failures = 0;
+
+   for (set = 0; set < NUM_SETS; set++)
+   {
+      memory_t mem_ref, mem_prog;
+      cheat_manager_t st_ref, st_prog;
+      cheat_program_t *program;
+      unsigned rumble_ref[RUMBLE_LOG_MAX][2];
+      unsigned count_ref;
+      unsigned size       = 1 + rng() % 64;
+      bool big_endian     = rng() & 1;
+      struct item_cheat *cheats = (struct item_cheat*)
+            calloc(size, sizeof(*cheats));
+
+      memory_new(&mem_ref, 1 + rng() % NUM_BUFFERS_MAX, 64 + rng() % 512);
+      memory_clone(&mem_prog, &mem_ref);
+
+      for (i = 0; i < size; i++)
+         cheat_random(&cheats[i], mem_ref.total, 24);
+
+      state_init(&st_ref,  &mem_ref,  cheats, size, big_endian);
+      state_init(&st_prog, &mem_prog, cheats, size, big_endian);
+
+      program     = cheat_program_new(&st_prog);
+      rumble_base = cheats;
+
+      for (frame = 0; frame < FRAMES_PER_SET; frame++)
+      {
+         bool applied_ref, applied_prog;
+
+         rumble_count = 0;
+         applied_ref  = reference_apply(&st_ref);
+         count_ref    = rumble_count;
+         memcpy(rumble_ref, rumble_log, sizeof(rumble_ref));
+
+         rumble_count = 0;
+         applied_prog = cheat_program_apply(program, big_endian, rumble_record);
+
+         if (     applied_ref != applied_prog
+               || count_ref   != rumble_count
+               || memcmp(rumble_ref, rumble_log,
+                  (count_ref < RUMBLE_LOG_MAX ? count_ref : RUMBLE_LOG_MAX)
+                  * sizeof(rumble_log[0]))
+               || memcmp(mem_ref.arena, mem_prog.arena, mem_ref.arena_size))
+         {
+            if (failures++ < 5)
+               printf("FAIL: set %u frame %u (%u cheats)\n", set, frame, size);
+            break;
+         }
+      }
+
+      cheat_program_free(program);
+      free(mem_ref.arena);
+      free(mem_prog.arena);
+      free(cheats);
+   }
+
+   printf("Equivalence: %u cheat sets x %u frames, %s\n",
+         NUM_SETS, FRAMES_PER_SET, failures ? "MISMATCH" : "identical");
+   return failures;
+}
+
+/* Timing */
+
+static void run_bench(unsigned size, unsigned max_repeat, unsigned frames)
+{
+   unsigned i, frame;
+   memory_t mem;
+   cheat_manager_t cheat_st;
+   cheat_program_t *program;
+   double t, ref_ns, prog_ns, build_ns;
+   struct item_cheat *cheats = (struct item_cheat*)
+         calloc(size, sizeof(*cheats));
+
+   /* A typical map: work RAM and a few smaller regions */
+   memory_new(&mem, NUM_BUFFERS_MAX, 64 * 1024);
+
+   for (i = 0; i < size; i++)
+   {
+      cheat_random(&cheats[i], mem.total, max_repeat);
+      cheats[i].handler     = CHEAT_HANDLER_TYPE_RETRO;
+      cheats[i].state       = true;
+      cheats[i].rumble_type = RUMBLE_TYPE_DISABLED;
+   }
+
+   state_init(&cheat_st, &mem, cheats, size, false);
+
+   t = now_ns();
+   for (frame = 0; frame < frames; frame++)
+      reference_apply(&cheat_st);
+   ref_ns = (now_ns() - t) / frames;
+
+   t        = now_ns();
+   program  = cheat_program_new(&cheat_st);
+   build_ns = now_ns() - t;
+
+   t = now_ns();
+   for (frame = 0; frame < frames; frame++)
+      cheat_program_apply(program, false, NULL);
+   prog_ns = (now_ns() - t) / frames;
+
+   printf("%6u cheats, repeats <= %4u: interpreter %9.0f ns/frame, "
+         "compiled %8.0f ns/frame (%5.1fx), build %8.0f ns\n",
+         size, max_repeat, ref_ns, prog_ns, ref_ns / prog_ns, build_ns);
+
+   cheat_program_free(program);
+   free(mem.arena);
+   free(cheats);
+}
+
+int main(void)
+{
+   int failures = run_equivalence();
+
+   printf("\n");
+   run_bench(100,  1,   20000);
+   run_bench(500,  16,  5000);
+   run_bench(2000, 16,  2000);
+   run_bench(500,  256, 1000);
+
+   if (failures)
+   {
+      printf("\n%d mismatching set(s)\n", failures);
+      return 1;
+   }
+   return 0;
+}
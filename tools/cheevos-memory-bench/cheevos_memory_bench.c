@@ -0,0 +1,350 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures achievement evaluation time per frame with memory reads going
+ * through the rc_libretro region walk and through the page table in
+ * cheevos/cheevos_memory.c.
+ *
+ * Each case lays out a set of memory regions shaped after a console (or
+ * a worst case with the maximum number of regions, or awkwardly sized
+ * ones that force the fallback path) and activates a synthetic set of
+ * achievements with a few conditions each, on addresses clustered the
+ * way real sets cluster around game variables. Memory is scribbled on
+ * between frames.
+ *
+ * The read columns time the lookups alone, on the same address mix.
+ *
+ * Before timing, random reads and lookups are checked against
+ * rc_libretro, and both runtimes are run in lockstep to check they
+ * raise the same events.
+ *
+ * Usage: cheevos_memory_bench [-a achievements] [-n frames] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../cheevos/cheevos_memory.h"
+#include "../../deps/rcheevos/include/rc_runtime.h"
+
+struct bench_case
+{
+   const char *name;
+   unsigned count;
+   size_t size[RC_LIBRETRO_MAX_MEMORY_REGIONS];
+   unsigned null_region;          /* 1-based, 0 for none */
+};
+
+static const struct bench_case cases[] = {
+   { "psx",      3, { 0x10000, 0x1F0000, 0x400 }, 0 },
+   { "n64",      2, { 0x800000, 0x400000 }, 0 },
+   { "saturn",   2, { 0x100000, 0x100000 }, 0 },
+   { "many",     32, {
+      0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000,
+      0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000,
+      0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000,
+      0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000, 0x10000 }, 0 },
+   { "unaligned", 6, { 0x1234, 0x20000, 0x3, 0x7FFF1, 0x800, 0x40001 }, 4 },
+};
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static rc_libretro_memory_regions_t regions;
+static rcheevos_memory_pages_t pages;
+static unsigned long long reads;
+
+/* Same as rc_client's little-endian peek */
+static uint32_t peek_legacy(uint32_t address, uint32_t num_bytes, void *ud)
+{
+   uint32_t value = 0;
+   reads++;
+   if (num_bytes <= 4
+         && rc_libretro_memory_read(&regions, address,
+            (uint8_t*)&value, num_bytes) == num_bytes)
+      return value;
+   return 0;
+}
+
+static uint32_t peek_paged(uint32_t address, uint32_t num_bytes, void *ud)
+{
+   uint32_t value = 0;
+   reads++;
+   if (num_bytes <= 4
+         && rcheevos_memory_pages_read(&pages, address,
+            (uint8_t*)&value, num_bytes) == num_bytes)
+      return value;
+   return 0;
+}
+
+#define MAX_EVENTS 65536
+
+static rc_runtime_event_t events[2][MAX_EVENTS];
+static unsigned event_count[2];
+static unsigned event_side;
+
+static void event_handler(const rc_runtime_event_t *e)
+{
+   if (event_count[event_side] < MAX_EVENTS)
+      events[event_side][event_count[event_side]++] = *e;
+}
+
+static void setup_regions(const struct bench_case *c)
+{
+   unsigned i;
+
+   memset(&regions, 0, sizeof(regions));
+   regions.count = c->count;
+   for (i = 0; i < c->count; i++)
+   {
+      regions.size[i]    = c->size[i];
+      regions.total_size += c->size[i];
+      if (c->null_region != i + 1)
+      {
+         regions.data[i] = (uint8_t*)malloc(c->size[i]);
+         memset(regions.data[i], 0, c->size[i]);
+      }
+   }
+}
+
+static void free_regions(void)
+{
+   unsigned i;
+   for (i = 0; i < regions.count; i++)
+      free(regions.data[i]);
+   memset(&regions, 0, sizeof(regions));
+}
+
+/* Game variables sit in a handful of structures */
+static uint32_t random_address(const uint32_t *clusters, unsigned num_clusters)
+{
+   if ((rng() & 7) == 0)
+      return rng() % (uint32_t)regions.total_size;
+   return (clusters[rng() % num_clusters] + (rng() & 0xFF))
+      % (uint32_t)regions.total_size;
+}
+
+static void make_achievement(char *s, size_t len,
+      const uint32_t *clusters, unsigned num_clusters)
+{
+   static const char *sizes[] = { "0xH", "0x ", "0xX", "0xL", "0xM", "0xW" };
+   static const char *ops[]   = { "=", "!=", "<", ">=" };
+   unsigned i, n = 2 + rng() % 5;
+   size_t pos    = 0;
+
+   for (i = 0; i < n && pos < len; i++)
+   {
+      uint32_t address = random_address(clusters, num_clusters);
+      const char *size = sizes[rng() % 6];
+      unsigned kind    = rng() % 3;
+
+      if (i)
+         s[pos++] = '_';
+
+      if (kind == 0)
+         pos += snprintf(s + pos, len - pos, "%s%06x%sd%s%06x",
+               size, address, ops[rng() % 4], size, address);
+      else
+         pos += snprintf(s + pos, len - pos, "%s%06x%s%u",
+               size, address, ops[rng() % 4], rng() % 4);
+   }
+}
+
+static void scribble(const uint32_t *clusters, unsigned num_clusters,
+      unsigned writes)
+{
+   unsigned i;
+   for (i = 0; i < writes; i++)
+   {
+      uint32_t address = random_address(clusters, num_clusters);
+      uint8_t *p       = rc_libretro_memory_find(&regions, address);
+      if (p)
+         *p = (uint8_t)(rng() % 5);
+   }
+}
+
+static int check_reads(void)
+{
+   unsigned i;
+   uint32_t total = (uint32_t)regions.total_size;
+
+   for (i = 0; i < 1000000; i++)
+   {
+      uint8_t a[16], b[16];
+      uint32_t ra, rb;
+      uint32_t address   = rng() % (total + 64);
+      uint32_t num_bytes = 1 + rng() % 8;
+
+      if (i & 1)
+         address = (address & ~(uint32_t)0xFFF) + 0x1000 - (rng() % 8);
+
+      memset(a, 0xAA, sizeof(a));
+      memset(b, 0xAA, sizeof(b));
+      ra = rc_libretro_memory_read(&regions, address, a, num_bytes);
+      rb = rcheevos_memory_pages_read(&pages, address, b, num_bytes);
+
+      if (ra != rb || memcmp(a, b, sizeof(a)))
+      {
+         printf("read mismatch at %06x (%u bytes): %u vs %u\n",
+               address, num_bytes, ra, rb);
+         return 0;
+      }
+
+      if (     rc_libretro_memory_find(&regions, address)
+            != rcheevos_memory_pages_find(&pages, address))
+      {
+         printf("find mismatch at %06x\n", address);
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/* Average ns per 4-byte read, legacy walk or page table */
+static double time_reads(const uint32_t *clusters, unsigned num_clusters,
+      int paged)
+{
+   unsigned i;
+   static uint32_t addresses[4096];
+   volatile uint32_t sink = 0;
+   int64_t t0;
+
+   for (i = 0; i < 4096; i++)
+      addresses[i] = random_address(clusters, num_clusters);
+
+   t0 = bench_usec();
+   for (i = 0; i < 4000000; i++)
+      sink += paged
+         ? peek_paged(addresses[i & 4095], 4, NULL)
+         : peek_legacy(addresses[i & 4095], 4, NULL);
+   return (bench_usec() - t0) * 1000.0 / 4000000;
+}
+
+int main(int argc, char **argv)
+{
+   unsigned c, i, f;
+   unsigned num_achievements = 1000;
+   unsigned num_frames       = 3000;
+   int failed                = 0;
+
+   for (i = 1; i + 1 < (unsigned)argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-a"))
+         num_achievements = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-n"))
+         num_frames       = (unsigned)atoi(argv[i + 1]);
+   }
+
+   printf("%u achievements, %u frames\n\n", num_achievements, num_frames);
+   printf("%-10s %8s %5s %10s %11s %12s %8s %9s %10s\n",
+         "case", "total", "page", "reads/frm",
+         "walk us/frm", "paged us/frm", "speedup",
+         "walk ns/rd", "paged ns/rd");
+
+   for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+   {
+      rc_runtime_t rt[2];
+      uint32_t clusters[64];
+      int64_t usec[2]       = { 0, 0 };
+      unsigned long long frame_reads = 0;
+      char memaddr[512];
+
+      setup_regions(&cases[c]);
+      rcheevos_memory_pages_init(&pages, &regions);
+
+      for (i = 0; i < 64; i++)
+         clusters[i] = rng() % (uint32_t)regions.total_size;
+
+      if (!check_reads())
+      {
+         failed = 1;
+         rcheevos_memory_pages_free(&pages);
+         free_regions();
+         continue;
+      }
+
+      rc_runtime_init(&rt[0]);
+      rc_runtime_init(&rt[1]);
+      for (i = 0; i < num_achievements; i++)
+      {
+         make_achievement(memaddr, sizeof(memaddr), clusters, 64);
+         rc_runtime_activate_achievement(&rt[0], i + 1, memaddr, NULL, 0);
+         rc_runtime_activate_achievement(&rt[1], i + 1, memaddr, NULL, 0);
+      }
+
+      event_count[0] = event_count[1] = 0;
+
+      for (f = 0; f < num_frames; f++)
+      {
+         int64_t t0;
+
+         scribble(clusters, 64, 200);
+
+         reads      = 0;
+         event_side = 0;
+         t0         = bench_usec();
+         rc_runtime_do_frame(&rt[0], event_handler, peek_legacy, NULL, NULL);
+         usec[0]   += bench_usec() - t0;
+         frame_reads += reads;
+
+         event_side = 1;
+         t0         = bench_usec();
+         rc_runtime_do_frame(&rt[1], event_handler, peek_paged, NULL, NULL);
+         usec[1]   += bench_usec() - t0;
+      }
+
+      if (     event_count[0] != event_count[1]
+            || memcmp(events[0], events[1],
+               event_count[0] * sizeof(events[0][0])))
+      {
+         printf("%-10s event mismatch (%u vs %u)\n", cases[c].name,
+               event_count[0], event_count[1]);
+         failed = 1;
+      }
+      else
+         printf("%-10s %7uK %5u %10llu %11.1f %12.1f %7.2fx %9.1f %10.1f\n",
+               cases[c].name,
+               (unsigned)(regions.total_size >> 10),
+               pages.mask + 1,
+               frame_reads / num_frames,
+               (double)usec[0] / num_frames,
+               (double)usec[1] / num_frames,
+               (double)usec[0] / (usec[1] ? usec[1] : 1),
+               time_reads(clusters, 64, 0),
+               time_reads(clusters, 64, 1));
+
+      rc_runtime_destroy(&rt[0]);
+      rc_runtime_destroy(&rt[1]);
+      rcheevos_memory_pages_free(&pages);
+      free_regions();
+   }
+
+   return failed;
+}
@@ -0,0 +1,349 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times loading content the way task_content.c does, with and without
+ * content_cache.c.
+ *
+ * A few synthetic disc images are written, part random data and part
+ * padding, like typical optical media dumps. Loading one means reading
+ * it into memory and computing its CRC32. Two patterns are timed:
+ * reloading the same image over and over, and cycling through all
+ * images as when swapping discs, with a budget that holds two raw
+ * images, so the cache only keeps all of them when compressed.
+ *
+ * Every load must return the image as written, an image changed on
+ * disk must not be returned from the cache, content larger than the
+ * budget must not be cached and the budget must never be exceeded.
+ * Note that the legacy reads are served from the OS page cache here,
+ * so the timings are a lower bound of what loading from disk costs.
+ *
+ * Usage: content_cache_bench [-s image MB] [-n images] [-r loads] [-d dir] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+
+#include "../../content_cache.h"
+
+#define MAX_IMAGES 16
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+   if (!cond)
+   {
+      printf("FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* Sectors of random data mixed with runs of padding */
+static uint8_t *make_image(size_t len)
+{
+   size_t i, j;
+   uint8_t *data = (uint8_t*)malloc(len);
+
+   if (!data)
+      return NULL;
+
+   for (i = 0; i < len; i += 2048)
+   {
+      size_t sector = MIN(len - i, 2048);
+
+      if (rng() % 100 < 45)
+      {
+         for (j = 0; j < sector; j += 4)
+         {
+            uint32_t v = rng();
+            memcpy(data + i + j, &v, MIN(sector - j, 4));
+         }
+      }
+      else
+         memset(data + i, (rng() % 4) ? 0x00 : 0xFF, sector);
+   }
+
+   return data;
+}
+
+/* What task_content.c does without a cache. Checked
+ * like load_cached(), to time both the same way. */
+static void load_legacy(const char *path, const uint8_t *expect,
+      int64_t expect_len, uint32_t *crc)
+{
+   void *buf   = NULL;
+   int64_t len = 0;
+
+   if (!filestream_read_file(path, &buf, &len))
+   {
+      check(false, "image readable");
+      return;
+   }
+
+   check(len == expect_len && !memcmp(buf, expect, (size_t)len),
+         "loaded image matches");
+
+   *crc = encoding_crc32(0, (const uint8_t*)buf, (size_t)len);
+   free(buf);
+}
+
+/* What task_content.c does with the cache, returning true on a hit */
+static bool load_cached(const char *path, const uint8_t *expect,
+      int64_t expect_len, uint32_t *crc)
+{
+   void *buf   = NULL;
+   int64_t len = 0;
+   bool hit    = content_cache_get(path, &buf, &len);
+
+   if (!hit)
+   {
+      if (!filestream_read_file(path, &buf, &len))
+      {
+         check(false, "image readable");
+         return false;
+      }
+      content_cache_put(path, buf, len);
+   }
+
+   check(len == expect_len && !memcmp(buf, expect, (size_t)len),
+         "loaded image matches");
+
+   if (!content_cache_get_crc(path, crc))
+   {
+      *crc = encoding_crc32(0, (const uint8_t*)buf, (size_t)len);
+      content_cache_set_crc(path, *crc);
+   }
+
+   free(buf);
+   return hit;
+}
+
+int main(int argc, char **argv)
+{
+   int i, r;
+   char dir[256];
+   char paths[MAX_IMAGES][PATH_MAX_LENGTH];
+   uint8_t *images[MAX_IMAGES];
+   uint32_t crcs[MAX_IMAGES];
+   size_t image_mb = 64;
+   int num_images  = 3;
+   int loads       = 12;
+   size_t image_len;
+   size_t budget;
+   int mode;
+
+   snprintf(dir, sizeof(dir), "/tmp/content_cache_bench.%d", (int)getpid());
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-s") && i + 1 < argc)
+         image_mb   = (size_t)atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         num_images = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+         loads      = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+         strlcpy(dir, argv[++i], sizeof(dir));
+      else
+      {
+         fprintf(stderr,
+               "Usage: %s [-s image MB] [-n images] [-r loads] [-d dir]\n",
+               argv[0]);
+         return 1;
+      }
+   }
+
+   if (num_images < 2)
+      num_images = 2;
+   if (num_images > MAX_IMAGES)
+      num_images = MAX_IMAGES;
+
+   image_len = image_mb << 20;
+   budget    = image_len * 2 + (image_len / 2);
+
+   path_mkdir(dir);
+
+   for (i = 0; i < num_images; i++)
+   {
+      snprintf(paths[i], sizeof(paths[i]), "%s/disc%d.iso", dir, i + 1);
+      if (!(images[i] = make_image(image_len))
+            || !filestream_write_file(paths[i], images[i], image_len))
+      {
+         fprintf(stderr, "Cannot write %s\n", paths[i]);
+         return 1;
+      }
+      crcs[i] = encoding_crc32(0, images[i], image_len);
+   }
+
+   printf("%d images of %u MB, budget %u MB, %d loads\n\n",
+         num_images, (unsigned)image_mb, (unsigned)(budget >> 20), loads);
+   printf("%-10s %-12s %10s %8s %10s\n",
+         "pattern", "method", "ms/load", "hits", "cache MB");
+
+   /* Reloading the same image */
+   {
+      int64_t t = bench_usec();
+      for (r = 0; r < loads; r++)
+      {
+         uint32_t crc = 0;
+         load_legacy(paths[0], images[0], image_len, &crc);
+         check(crc == crcs[0], "legacy CRC32");
+      }
+      t = bench_usec() - t;
+      printf("%-10s %-12s %10.2f %8s %10s\n", "reload", "legacy",
+            t / 1000.0 / loads, "-", "-");
+   }
+
+   for (mode = 0; mode < 2; mode++)
+   {
+      int hits  = 0;
+      int64_t t;
+
+      content_cache_set_limits(budget, mode == 1);
+
+      t = bench_usec();
+      for (r = 0; r < loads; r++)
+      {
+         uint32_t crc = 0;
+         if (load_cached(paths[0], images[0], image_len, &crc))
+            hits++;
+         check(crc == crcs[0], "cached CRC32");
+      }
+      t = bench_usec() - t;
+      printf("%-10s %-12s %10.2f %8d %10.1f\n", "reload",
+            mode ? "cache (zstd)" : "cache (raw)",
+            t / 1000.0 / loads, hits,
+            content_cache_get_size() / 1048576.0);
+      check(hits == loads - 1, "reloads hit");
+
+      content_cache_deinit();
+   }
+
+   /* Swapping between all images */
+   {
+      int64_t t = bench_usec();
+      for (r = 0; r < loads; r++)
+      {
+         uint32_t crc = 0;
+         int n        = r % num_images;
+         load_legacy(paths[n], images[n], image_len, &crc);
+         check(crc == crcs[n], "legacy CRC32");
+      }
+      t = bench_usec() - t;
+      printf("%-10s %-12s %10.2f %8s %10s\n", "swap", "legacy",
+            t / 1000.0 / loads, "-", "-");
+   }
+
+   for (mode = 0; mode < 2; mode++)
+   {
+      int hits = 0;
+      int64_t t;
+
+      content_cache_set_limits(budget, mode == 1);
+
+      t = bench_usec();
+      for (r = 0; r < loads; r++)
+      {
+         uint32_t crc = 0;
+         int n        = r % num_images;
+         if (load_cached(paths[n], images[n], image_len, &crc))
+            hits++;
+         check(crc == crcs[n], "cached CRC32");
+         check(content_cache_get_size() <= budget, "within budget");
+      }
+      t = bench_usec() - t;
+      printf("%-10s %-12s %10.2f %8d %10.1f\n", "swap",
+            mode ? "cache (zstd)" : "cache (raw)",
+            t / 1000.0 / loads, hits,
+            content_cache_get_size() / 1048576.0);
+
+      content_cache_deinit();
+   }
+
+   /* An image changed on disk must be read again */
+   {
+      void *buf   = NULL;
+      int64_t len = 0;
+      uint32_t crc;
+
+      content_cache_set_limits(budget, true);
+      load_cached(paths[0], images[0], image_len, &crc);
+
+      /* Same size, different data and modification time */
+      sleep(1);
+      images[0][0] ^= 0xFF;
+      filestream_write_file(paths[0], images[0], image_len);
+      check(!content_cache_get(paths[0], &buf, &len),
+            "changed image not returned");
+      check(!content_cache_get_crc(paths[0], &crc),
+            "changed image CRC32 not returned");
+      free(buf);
+
+      check(!load_cached(paths[0], images[0], image_len, &crc)
+            && crc == encoding_crc32(0, images[0], image_len),
+            "changed image reloaded");
+
+      /* Larger than the whole budget */
+      content_cache_set_limits(image_len / 8, false);
+      check(!content_cache_put(paths[1], images[1], image_len),
+            "oversized content not cached");
+      check(content_cache_get_size() == 0, "budget shrink evicts");
+
+      content_cache_set_limits(0, false);
+      check(!content_cache_put(paths[1], images[1], 16),
+            "disabled cache stores nothing");
+      content_cache_deinit();
+   }
+
+   for (i = 0; i < num_images; i++)
+   {
+      filestream_delete(paths[i]);
+      free(images[i]);
+   }
+   rmdir(dir);
+
+   if (failures)
+   {
+      printf("\n%d checks failed\n", failures);
+      return 1;
+   }
+
+   printf("\nAll checks passed\n");
+   return 0;
+}
@@ -0,0 +1,654 @@
+/* Delta core update benchmark.
+ *
+ * Generates successive builds of a fake core and publishes them from a
+ * local HTTP stand-in for the buildbot: for each build its archive and
+ * the delta from the previous build, written the way
+ * 'zstd --patch-from' does. Each update is then fetched with net_http
+ * both ways, as a full archive and as a delta applied with
+ * core_updater_delta_apply(), reporting bytes transferred and update
+ * time. Also checks the fallbacks: no delta published for the
+ * installed build, and a delta that does not rebuild the advertised
+ * CRC, which must leave the installed core untouched.
+ *
+ * Builds are modelled on relinked binaries: a stream of instruction
+ * sequences, some carrying addresses of other sequences. Each build
+ * inserts and removes code at a few dozen places, which moves most of
+ * what follows and rewrites every address pointing past it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+
+#include <boolean.h>
+#include <compat/strl.h>
+#include <net/net_http.h>
+#include <net/net_compat.h>
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+#include <encodings/crc32.h>
+
+#include "../../core_updater_delta.h"
+
+#define NUM_BUILDS      5
+#define NUM_RECORDS     (600 * 1024)
+#define NUM_SEQUENCES   4096
+#define EDITS_PER_BUILD 40
+#define ARCHIVE_LEVEL   9
+#define DELTA_LEVEL     19
+
+#define CORE_NAME       "bench_libretro.so"
+#define INSTALLED_PATH  "bench_installed_libretro.so"
+#define DOWNLOAD_PATH   "bench_installed_libretro.so.zst"
+
+typedef struct
+{
+   uint32_t id;     /* Stable across builds */
+   uint32_t target; /* Id of the record addressed, if any */
+   uint16_t seq;
+   uint8_t  imm;
+   uint8_t  is_addr;
+} record_t;
+
+typedef struct
+{
+   char name[256];
+   uint8_t *data;
+   size_t len;
+} blob_t;
+
+static uint8_t *sequences[NUM_SEQUENCES];
+static size_t sequence_len[NUM_SEQUENCES];
+
+static blob_t published[NUM_BUILDS * 3];
+static size_t num_published;
+static size_t bytes_served;
+static int server_fd = -1;
+static volatile bool server_quit;
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Builds */
+
+static uint32_t next_id;
+
+static record_t new_record(size_t count)
+{
+   record_t r;
+   r.id      = next_id++;
+   r.seq     = (uint16_t)(rng() % NUM_SEQUENCES);
+   r.imm     = (uint8_t)rng();
+   r.is_addr = (rng() % 4) == 0;
+   r.target  = (uint32_t)(rng() % (count ? count : 1));
+   return r;
+}
+
+static uint8_t *serialize(const record_t *records, size_t count,
+      size_t *len)
+{
+   size_t i, pos = 0, size = 0;
+   uint32_t *offsets = (uint32_t*)calloc(next_id, sizeof(uint32_t));
+   uint8_t *out;
+
+   for (i = 0; i < count; i++)
+   {
+      offsets[records[i].id] = (uint32_t)size;
+      size += sequence_len[records[i].seq] + (records[i].is_addr ? 4 : 1);
+   }
+
+   out = (uint8_t*)malloc(size);
+   for (i = 0; i < count; i++)
+   {
+      const record_t *r = &records[i];
+      memcpy(out + pos, sequences[r->seq], sequence_len[r->seq]);
+      pos += sequence_len[r->seq];
+      if (r->is_addr)
+      {
+         uint32_t addr = 0x400000 + offsets[r->target];
+         memcpy(out + pos, &addr, 4);
+         pos += 4;
+      }
+      else
+         out[pos++] = r->imm;
+   }
+
+   free(offsets);
+   *len = size;
+   return out;
+}
+
+static record_t *next_build(const record_t *records, size_t count,
+      size_t *out_count)
+{
+   size_t i, j, n = 0;
+   size_t sites[EDITS_PER_BUILD];
+   record_t *out = (record_t*)malloc((count + EDITS_PER_BUILD * 64)
+         * sizeof(record_t));
+
+   for (i = 0; i < EDITS_PER_BUILD; i++)
+      sites[i] = rng() % count;
+
+   for (i = 0; i < count; i++)
+   {
+      bool skip = false;
+
+      for (j = 0; j < EDITS_PER_BUILD; j++)
+      {
+         if (sites[j] == i)
+         {
+            /* New code, addressing existing code */
+            size_t k, added = rng() % 48;
+            for (k = 0; k < added; k++)
+            {
+               out[n]        = new_record(count);
+               out[n].target = records[rng() % count].id;
+               n++;
+            }
+            /* Removed code */
+            skip = (rng() % 2) == 0;
+         }
+      }
+
+      if (skip)
+         continue;
+
+      out[n] = records[i];
+      /* Tweaked constants */
+      if ((rng() % 1000) == 0)
+         out[n].imm = (uint8_t)rng();
+      n++;
+   }
+
+   /* Addresses of removed records point elsewhere */
+   {
+      uint8_t *alive = (uint8_t*)calloc(next_id, 1);
+      for (i = 0; i < n; i++)
+         alive[out[i].id] = 1;
+      for (i = 0; i < n; i++)
+         if (out[i].is_addr && !alive[out[i].target])
+            out[i].target = out[rng() % n].id;
+      free(alive);
+   }
+
+   *out_count = n;
+   return out;
+}
+
+/* Publishing */
+
+static void publish(const char *name, uint8_t *data, size_t len)
+{
+   blob_t *blob = &published[num_published++];
+   blob->name[0] = '/';
+   strlcpy(blob->name + 1, name, sizeof(blob->name) - 1);
+   blob->data = data;
+   blob->len  = len;
+}
+
+static uint8_t *make_archive(const uint8_t *core, size_t core_len,
+      size_t *len)
+{
+   size_t bound = ZSTD_compressBound(core_len);
+   uint8_t *out = (uint8_t*)malloc(bound);
+   *len         = ZSTD_compress(out, bound, core, core_len, ARCHIVE_LEVEL);
+   return out;
+}
+
+/* Same parameters as 'zstd --patch-from' */
+static uint8_t *make_delta(const uint8_t *base, size_t base_len,
+      const uint8_t *core, size_t core_len, size_t *len)
+{
+   int window_log   = 10;
+   size_t bound     = ZSTD_compressBound(core_len);
+   uint8_t *out     = (uint8_t*)malloc(bound);
+   ZSTD_CCtx *cctx  = ZSTD_createCCtx();
+
+   while ((1ULL << window_log) < (base_len > core_len ? base_len : core_len))
+      window_log++;
+
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, DELTA_LEVEL);
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, window_log);
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, 1);
+   ZSTD_CCtx_refPrefix(cctx, base, base_len);
+
+   *len = ZSTD_compress2(cctx, out, bound, core, core_len);
+   ZSTD_freeCCtx(cctx);
+   if (ZSTD_isError(*len))
+   {
+      free(out);
+      return NULL;
+   }
+   return out;
+}
+
+/* HTTP stand-in */
+
+static void send_all(int fd, const void *data, size_t len)
+{
+   const uint8_t *p = (const uint8_t*)data;
+   while (len)
+   {
+      ssize_t n = send(fd, p, len, 0);
+      if (n <= 0)
+         return;
+      p   += n;
+      len -= (size_t)n;
+   }
+}
+
+static void server_thread(void *data)
+{
+   while (!server_quit)
+   {
+      size_t i, got = 0;
+      char req[4096];
+      char path[256];
+      char header[256];
+      const blob_t *blob = NULL;
+      int fd             = accept(server_fd, NULL, NULL);
+
+      if (fd < 0)
+         continue;
+
+      /* Read the request head */
+      while (got < sizeof(req) - 1)
+      {
+         ssize_t n = recv(fd, req + got, sizeof(req) - 1 - got, 0);
+         if (n <= 0)
+            break;
+         got      += (size_t)n;
+         req[got]  = '\0';
+         if (strstr(req, "\r\n\r\n"))
+            break;
+      }
+      req[got] = '\0';
+
+      path[0] = '\0';
+      sscanf(req, "GET %255s", path);
+
+      for (i = 0; i < num_published; i++)
+         if (!strcmp(published[i].name, path))
+            blob = &published[i];
+
+      if (blob)
+      {
+         int _len = snprintf(header, sizeof(header),
+               "HTTP/1.1 200 OK\r\n"
+               "Content-Length: %lu\r\n"
+               "Connection: close\r\n\r\n",
+               (unsigned long)blob->len);
+         send_all(fd, header, (size_t)_len);
+         send_all(fd, blob->data, blob->len);
+         bytes_served += (size_t)_len + blob->len;
+      }
+      else
+      {
+         const char *not_found =
+               "HTTP/1.1 404 Not Found\r\n"
+               "Content-Length: 0\r\n"
+               "Connection: close\r\n\r\n";
+         send_all(fd, not_found, strlen(not_found));
+         bytes_served += strlen(not_found);
+      }
+
+      close(fd);
+   }
+}
+
+static int server_start(void)
+{
+   struct sockaddr_in addr;
+   socklen_t addr_len = sizeof(addr);
+   int one            = 1;
+
+   server_fd = socket(AF_INET, SOCK_STREAM, 0);
+   setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port        = 0;
+
+   if (     bind(server_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+         || listen(server_fd, 8) < 0
+         || getsockname(server_fd, (struct sockaddr*)&addr, &addr_len) < 0)
+      return -1;
+
+   return ntohs(addr.sin_port);
+}
+
+/* Client */
+
+static uint8_t *http_get(const char *url, size_t *len, int *status)
+{
+   uint8_t *data = NULL;
+   uint8_t *body;
+   struct http_t *http;
+   struct http_connection_t *conn = net_http_connection_new(url, "GET", NULL);
+
+   *len    = 0;
+   *status = 0;
+
+   if (!conn)
+      return NULL;
+
+   while (!net_http_connection_iterate(conn)) { }
+
+   if (!net_http_connection_done(conn)
+         || !(http = net_http_new(conn)))
+   {
+      net_http_connection_free(conn);
+      return NULL;
+   }
+   net_http_connection_free(conn);
+
+   while (!net_http_update(http, NULL, NULL)) { }
+
+   *status = net_http_status(http);
+   if ((body = net_http_data(http, len, true)) && *len)
+   {
+      data = (uint8_t*)malloc(*len);
+      memcpy(data, body, *len);
+   }
+
+   net_http_delete(http);
+   return data;
+}
+
+static uint32_t file_crc(const char *path)
+{
+   void *data  = NULL;
+   int64_t len = 0;
+   uint32_t crc;
+
+   if (!filestream_read_file(path, &data, &len))
+      return 0;
+   crc = encoding_crc32(0, (const uint8_t*)data, (size_t)len);
+   free(data);
+   return crc;
+}
+
+/* Full update: fetch the archive and unpack it over the core */
+static bool update_full(const char *archive_url, uint32_t target_crc)
+{
+   int status;
+   size_t len;
+   bool ret      = false;
+   uint8_t *data = http_get(archive_url, &len, &status);
+
+   if (data && status == 200)
+   {
+      unsigned long long size = ZSTD_getFrameContentSize(data, len);
+      uint8_t *core           = (uint8_t*)malloc((size_t)size);
+
+      if (     ZSTD_decompress(core, (size_t)size, data, len) == size
+            && encoding_crc32(0, core, (size_t)size) == target_crc)
+         ret = filestream_write_file(INSTALLED_PATH, core, (int64_t)size);
+      free(core);
+   }
+
+   free(data);
+   return ret;
+}
+
+/* Delta update, as the core updater does it */
+static bool update_delta(const char *archive_url,
+      uint32_t base_crc, uint32_t target_crc, int *status)
+{
+   size_t len;
+   char url[512];
+   bool ret      = false;
+   uint8_t *data = NULL;
+
+   *status = 0;
+
+   if (!core_updater_delta_get_url(url, sizeof(url),
+            archive_url, base_crc, target_crc))
+      return false;
+
+   if ((data = http_get(url, &len, status)) && *status == 200)
+   {
+      if (filestream_write_file(DOWNLOAD_PATH, data, (int64_t)len))
+         ret = core_updater_delta_apply(INSTALLED_PATH, DOWNLOAD_PATH,
+               INSTALLED_PATH, target_crc);
+      filestream_delete(DOWNLOAD_PATH);
+   }
+
+   free(data);
+   return ret;
+}
+
+int main(void)
+{
+   size_t i, b;
+   int port;
+   char archive_url[256];
+   char name[256];
+   record_t *records;
+   size_t count;
+   uint8_t *cores[NUM_BUILDS];
+   size_t core_len[NUM_BUILDS];
+   uint32_t crcs[NUM_BUILDS];
+   size_t archive_len[NUM_BUILDS];
+   size_t delta_len[NUM_BUILDS];
+   double full_ms[NUM_BUILDS];
+   double delta_ms[NUM_BUILDS];
+   size_t full_bytes[NUM_BUILDS];
+   size_t delta_bytes[NUM_BUILDS];
+   sthread_t *thread;
+   int failures = 0;
+
+   for (i = 0; i < NUM_SEQUENCES; i++)
+   {
+      size_t k;
+      sequence_len[i] = 4 + rng() % 17;
+      sequences[i]    = (uint8_t*)malloc(sequence_len[i]);
+      for (k = 0; k < sequence_len[i]; k++)
+         sequences[i][k] = (uint8_t)rng();
+   }
+
+   /* Builds */
+   records = (record_t*)malloc(NUM_RECORDS * sizeof(record_t));
+   for (count = 0; count < NUM_RECORDS; count++)
+      records[count] = new_record(NUM_RECORDS);
+   for (i = 0; i < count; i++)
+      records[i].target = records[records[i].target].id;
+
+   for (b = 0; b < NUM_BUILDS; b++)
+   {
+      if (b > 0)
+      {
+         size_t n;
+         record_t *next = next_build(records, count, &n);
+         free(records);
+         records = next;
+         count   = n;
+      }
+      cores[b]    = serialize(records, count, &core_len[b]);
+      crcs[b]     = encoding_crc32(0, cores[b], core_len[b]);
+   }
+   free(records);
+
+   /* Buildbot: latest archive only, deltas from every
+    * earlier build that was published */
+   if ((port = server_start()) < 0)
+   {
+      fprintf(stderr, "Cannot start HTTP stand-in.\n");
+      return 1;
+   }
+   snprintf(archive_url, sizeof(archive_url),
+         "http://127.0.0.1:%d/%s.zip", port, CORE_NAME);
+
+   for (b = 0; b < NUM_BUILDS; b++)
+   {
+      uint8_t *archive = make_archive(cores[b], core_len[b], &archive_len[b]);
+
+      /* Each build is served under the same archive name in
+       * turn, keep them apart under a per-build name */
+      snprintf(name, sizeof(name), "build%u/%s.zip", (unsigned)b, CORE_NAME);
+      publish(name, archive, archive_len[b]);
+
+      delta_len[b] = 0;
+      if (b > 0)
+      {
+         uint8_t *delta = make_delta(cores[b - 1], core_len[b - 1],
+               cores[b], core_len[b], &delta_len[b]);
+         snprintf(name, sizeof(name), "%s.%08lx-%08lx.zst", CORE_NAME,
+               (unsigned long)crcs[b - 1], (unsigned long)crcs[b]);
+         publish(name, delta, delta_len[b]);
+      }
+   }
+
+   network_init();
+   thread = sthread_create(server_thread, NULL);
+
+   printf("Core builds: %u, %.1f MiB each\n\n", NUM_BUILDS,
+         core_len[0] / (1024.0 * 1024.0));
+   printf("%-8s %14s %10s %14s %10s %9s\n",
+         "update", "full bytes", "full ms", "delta bytes", "delta ms", "saved");
+
+   for (b = 1; b < NUM_BUILDS; b++)
+   {
+      int status;
+      size_t before;
+      double t;
+      char build_url[256];
+
+      snprintf(build_url, sizeof(build_url),
+            "http://127.0.0.1:%d/build%u/%s.zip", port, (unsigned)b, CORE_NAME);
+
+      /* Full */
+      filestream_write_file(INSTALLED_PATH, cores[b - 1], (int64_t)core_len[b - 1]);
+      before = bytes_served;
+      t      = now_ms();
+      if (!update_full(build_url, crcs[b]) || file_crc(INSTALLED_PATH) != crcs[b])
+      {
+         printf("FAIL: full update %u\n", (unsigned)b);
+         failures++;
+      }
+      full_ms[b]    = now_ms() - t;
+      full_bytes[b] = bytes_served - before;
+
+      /* Delta */
+      filestream_write_file(INSTALLED_PATH, cores[b - 1], (int64_t)core_len[b - 1]);
+      before = bytes_served;
+      t      = now_ms();
+      if (     !update_delta(archive_url, crcs[b - 1], crcs[b], &status)
+            || file_crc(INSTALLED_PATH) != crcs[b])
+      {
+         printf("FAIL: delta update %u (HTTP %d)\n", (unsigned)b, status);
+         failures++;
+      }
+      delta_ms[b]    = now_ms() - t;
+      delta_bytes[b] = bytes_served - before;
+
+      printf("%u -> %u   %14lu %10.1f %14lu %10.1f %8.1f%%\n",
+            (unsigned)(b - 1), (unsigned)b,
+            (unsigned long)full_bytes[b], full_ms[b],
+            (unsigned long)delta_bytes[b], delta_ms[b],
+            100.0 * (1.0 - (double)delta_bytes[b] / full_bytes[b]));
+   }
+
+   /* Fallback: installed build is not one a delta was made from */
+   {
+      int status;
+      uint8_t *local = (uint8_t*)malloc(core_len[1]);
+      memcpy(local, cores[1], core_len[1]);
+      local[core_len[1] / 2] ^= 0xFF;
+      filestream_write_file(INSTALLED_PATH, local, (int64_t)core_len[1]);
+
+      if (     update_delta(archive_url,
+                  encoding_crc32(0, local, core_len[1]), crcs[2], &status)
+            || status != 404)
+      {
+         printf("FAIL: unknown base was not reported missing (HTTP %d)\n", status);
+         failures++;
+      }
+      else
+         printf("\nUnknown installed build: no delta (HTTP 404), full download\n");
+      free(local);
+   }
+
+   /* Fallback: a delta that does not rebuild the advertised core.
+    * Published under the name of the 3 -> 4 delta, made from 2 */
+   {
+      int status;
+      uint32_t crc_before;
+
+      for (i = 0; i < num_published; i++)
+      {
+         snprintf(name, sizeof(name), "/%s.%08lx-%08lx.zst", CORE_NAME,
+               (unsigned long)crcs[3], (unsigned long)crcs[4]);
+         if (!strcmp(published[i].name, name))
+         {
+            free(published[i].data);
+            published[i].data = make_delta(cores[2], core_len[2],
+                  cores[4], core_len[4], &published[i].len);
+         }
+      }
+
+      filestream_write_file(INSTALLED_PATH, cores[3], (int64_t)core_len[3]);
+      crc_before = file_crc(INSTALLED_PATH);
+
+      if (     update_delta(archive_url, crcs[3], crcs[4], &status)
+            || file_crc(INSTALLED_PATH) != crc_before)
+      {
+         printf("FAIL: mismatched delta was applied\n");
+         failures++;
+      }
+      else
+         printf("Mismatched delta: rejected, installed core untouched\n");
+   }
+
+   /* Stop the server with a last request */
+   server_quit = true;
+   {
+      int status;
+      size_t len;
+      snprintf(name, sizeof(name), "http://127.0.0.1:%d/quit", port);
+      free(http_get(name, &len, &status));
+   }
+   sthread_join(thread);
+   close(server_fd);
+
+   filestream_delete(INSTALLED_PATH);
+   for (i = 0; i < num_published; i++)
+      free(published[i].data);
+   for (b = 0; b < NUM_BUILDS; b++)
+      free(cores[b]);
+   for (i = 0; i < NUM_SEQUENCES; i++)
+      free(sequences[i]);
+
+   if (failures)
+   {
+      printf("\n%d failure(s)\n", failures);
+      return 1;
+   }
+   printf("\nAll updates verified\n");
+   return 0;
+}
@@ -0,0 +1,381 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares reading evdev devices once per frame, as the udev input
+ * driver does by default, with draining them on a reader thread
+ * (linux_evdev_reader.c).
+ *
+ * A recording of a high-rate mouse, with a key pressed or released
+ * every 50 ms, is generated and played back through the fake evdev
+ * device of evdev_replay, which buffers as few events as a real evdev
+ * client buffer. A 60 Hz frame loop then takes the events, either by
+ * reading the device directly at the end of each frame, or from the
+ * reader thread.
+ *
+ * For each mode, reports lost to the full buffer, mouse motion and
+ * key presses lost, and the latency from the event timestamp to the
+ * frame that sees it are printed. With the reader thread, nothing may
+ * be lost, and every event must come out in the recorded order.
+ *
+ * Usage: evdev_reader_bench [-r mouse rate Hz] [-d seconds]
+ *                           [-b buffered events] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+
+#include "../../input/common/linux_evdev_reader.h"
+
+#define FRAME_USEC 16667
+
+#ifdef input_event_sec
+#define EVENT_SEC(ev)  (ev)->input_event_sec
+#define EVENT_USEC(ev) (ev)->input_event_usec
+#else
+#define EVENT_SEC(ev)  (ev)->time.tv_sec
+#define EVENT_USEC(ev) (ev)->time.tv_usec
+#endif
+
+typedef struct bench_result
+{
+   long rel_x;
+   unsigned presses;
+   unsigned releases;
+   unsigned events;
+   unsigned syn_dropped;
+   unsigned reports_dropped;
+   unsigned out_of_order;
+   int64_t *latencies;
+   size_t latency_count;
+} bench_result_t;
+
+static int64_t now_usec(clockid_t clock)
+{
+   struct timespec ts;
+   clock_gettime(clock, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void push_event(struct input_event *events, size_t *count,
+      int64_t time, unsigned type, unsigned code, int value)
+{
+   struct input_event *ev = &events[(*count)++];
+   memset(ev, 0, sizeof(*ev));
+   EVENT_SEC(ev)  = time / 1000000;
+   EVENT_USEC(ev) = time % 1000000;
+   ev->type       = type;
+   ev->code       = code;
+   ev->value      = value;
+}
+
+/* Mouse reports of REL_X/REL_Y at @rate Hz, and a key
+ * toggled every 50 ms in a report of its own */
+static size_t make_recording(const char *path, unsigned rate,
+      unsigned seconds, long *rel_x, unsigned *presses,
+      unsigned *releases, struct input_event **out)
+{
+   FILE *file;
+   size_t count   = 0;
+   unsigned i, reports = rate * seconds;
+   unsigned keys  = seconds * 20;
+   int64_t step   = 1000000 / rate;
+   struct input_event *events = (struct input_event*)malloc(
+         ((size_t)reports * 3 + keys * 2) * sizeof(*events));
+   bool down      = false;
+   int64_t next_key = 50000;
+
+   *rel_x    = 0;
+   *presses  = 0;
+   *releases = 0;
+
+   for (i = 0; i < reports; i++)
+   {
+      int64_t t = (int64_t)i * step;
+
+      if (t >= next_key)
+      {
+         down = !down;
+         push_event(events, &count, t, EV_KEY, KEY_A, down);
+         push_event(events, &count, t, EV_SYN, SYN_REPORT, 0);
+         if (down)
+            (*presses)++;
+         else
+            (*releases)++;
+         next_key += 50000;
+      }
+
+      push_event(events, &count, t, EV_REL, REL_X, 1 + (i % 3));
+      push_event(events, &count, t, EV_REL, REL_Y, -1);
+      push_event(events, &count, t, EV_SYN, SYN_REPORT, 0);
+      *rel_x += 1 + (i % 3);
+   }
+
+   if ((file = fopen(path, "wb")))
+   {
+      fwrite(events, sizeof(*events), count, file);
+      fclose(file);
+   }
+
+   *out = events;
+   return count;
+}
+
+static void account(bench_result_t *res, const struct input_event *ev,
+      int64_t now, const struct input_event *recording,
+      size_t recording_count, size_t *pos)
+{
+   int64_t time = (int64_t)EVENT_SEC(ev) * 1000000 + EVENT_USEC(ev);
+
+   res->events++;
+   res->latencies[res->latency_count++] = now - time;
+
+   if (ev->type == EV_SYN && ev->code == SYN_DROPPED)
+   {
+      res->syn_dropped++;
+      return;
+   }
+
+   if (ev->type == EV_REL && ev->code == REL_X)
+      res->rel_x += ev->value;
+   else if (ev->type == EV_KEY && ev->code == KEY_A)
+   {
+      if (ev->value)
+         res->presses++;
+      else
+         res->releases++;
+   }
+
+   /* Without drops, events must come out as recorded */
+   if (!res->syn_dropped)
+   {
+      if (     *pos >= recording_count
+            || recording[*pos].type  != ev->type
+            || recording[*pos].code  != ev->code
+            || recording[*pos].value != ev->value)
+         res->out_of_order++;
+      (*pos)++;
+   }
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+   int64_t x = *(const int64_t*)a;
+   int64_t y = *(const int64_t*)b;
+   return (x > y) - (x < y);
+}
+
+static void run(bool threaded, const char *path, unsigned buffer_events,
+      const struct input_event *recording, size_t recording_count,
+      bench_result_t *res, evdev_reader_stats_t *stats)
+{
+   struct input_event events[32];
+   size_t pos              = 0;
+   evdev_reader_t *reader  = NULL;
+   int id                  = -1;
+   int64_t deadline;
+   evdev_replay_t *replay  = evdev_replay_new(path, 1.0f, buffer_events);
+
+   memset(res, 0, sizeof(*res));
+   res->latencies = (int64_t*)malloc(
+         (recording_count + 4096) * sizeof(*res->latencies));
+
+   if (!replay)
+   {
+      fprintf(stderr, "Failed to start replay.\n");
+      exit(1);
+   }
+
+   if (threaded)
+   {
+      if (     !(reader = evdev_reader_new())
+            || (id = evdev_reader_add(reader,
+                  evdev_replay_get_fd(replay))) < 0)
+      {
+         fprintf(stderr, "Failed to start reader.\n");
+         exit(1);
+      }
+   }
+
+   deadline = now_usec(CLOCK_MONOTONIC);
+
+   for (;;)
+   {
+      int i, len;
+      int64_t now;
+      bool done = evdev_replay_is_done(replay);
+
+      /* The frame's emulation; input is polled at its end */
+      deadline += FRAME_USEC;
+      while ((now = now_usec(CLOCK_MONOTONIC)) < deadline)
+      {
+         struct timespec ts;
+         ts.tv_sec  = 0;
+         ts.tv_nsec = (long)(deadline - now) * 1000;
+         nanosleep(&ts, NULL);
+      }
+
+      now = now_usec(CLOCK_REALTIME);
+
+      if (threaded)
+      {
+         while ((len = evdev_reader_read(reader, id,
+                     events, sizeof(events) / sizeof(events[0]))) > 0)
+            for (i = 0; i < len; i++)
+               account(res, &events[i], now,
+                     recording, recording_count, &pos);
+      }
+      else
+      {
+         while ((len = (int)read(evdev_replay_get_fd(replay),
+                     events, sizeof(events))) > 0)
+         {
+            len /= sizeof(events[0]);
+            for (i = 0; i < len; i++)
+               account(res, &events[i], now,
+                     recording, recording_count, &pos);
+         }
+      }
+
+      /* One more frame after the last report was written */
+      if (done)
+         break;
+   }
+
+   res->reports_dropped = evdev_replay_get_dropped(replay);
+
+   if (threaded)
+   {
+      evdev_reader_get_stats(reader, stats);
+      /* The descriptor must be free to close once this returns */
+      evdev_reader_remove(reader, id);
+   }
+
+   evdev_replay_free(replay);
+   evdev_reader_free(reader);
+
+   qsort(res->latencies, res->latency_count,
+         sizeof(*res->latencies), cmp_int64);
+}
+
+static int64_t percentile(const bench_result_t *res, unsigned pct)
+{
+   size_t i;
+   if (!res->latency_count)
+      return 0;
+   i = (res->latency_count * pct + 99) / 100;
+   return res->latencies[i ? i - 1 : 0];
+}
+
+static void print_result(const char *label, const bench_result_t *res,
+      long rel_x, unsigned presses, unsigned releases)
+{
+   printf("%-9s %8u events, %6u reports dropped, %4u SYN_DROPPED, "
+         "motion lost %5.1f%%, presses %u/%u, releases %u/%u, "
+         "latency p50 %5lld us, p99 %5lld us, max %5lld us\n",
+         label, res->events, res->reports_dropped, res->syn_dropped,
+         100.0 * (double)(rel_x - res->rel_x) / (double)rel_x,
+         res->presses, presses, res->releases, releases,
+         (long long)percentile(res, 50), (long long)percentile(res, 99),
+         (long long)(res->latency_count
+            ? res->latencies[res->latency_count - 1] : 0));
+}
+
+int main(int argc, char **argv)
+{
+   int opt;
+   long rel_x;
+   unsigned presses, releases;
+   size_t count;
+   struct input_event *recording;
+   bench_result_t direct, threaded;
+   evdev_reader_stats_t stats;
+   char path[64];
+   unsigned rate          = 8000;
+   unsigned seconds       = 2;
+   unsigned buffer_events = 64;
+   int fail               = 0;
+
+   while ((opt = getopt(argc, argv, "r:d:b:")) != -1)
+   {
+      switch (opt)
+      {
+         case 'r':
+            rate = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+         case 'd':
+            seconds = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+         case 'b':
+            buffer_events = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-r mouse rate Hz] [-d seconds] "
+                  "[-b buffered events]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if (!rate || !seconds)
+      return 1;
+
+   snprintf(path, sizeof(path), "/tmp/evdev_reader_bench_%d.bin",
+         (int)getpid());
+   count = make_recording(path, rate, seconds, &rel_x, &presses,
+         &releases, &recording);
+
+   printf("Recording: %u Hz mouse for %u s, %lu events, "
+         "%u key presses; device buffer of %u events\n",
+         rate, seconds, (unsigned long)count, presses, buffer_events);
+
+   run(false, path, buffer_events, recording, count, &direct, NULL);
+   run(true,  path, buffer_events, recording, count, &threaded, &stats);
+
+   print_result("per-frame", &direct, rel_x, presses, releases);
+   print_result("threaded", &threaded, rel_x, presses, releases);
+
+   printf("Reader stats: %llu events, read avg %lld us, p99 %lld us, "
+         "max %lld us; delivered avg %lld us, p50 %lld us, p99 %lld us; "
+         "%llu stalls\n",
+         (unsigned long long)stats.events,
+         (long long)stats.read_avg, (long long)stats.read_p99,
+         (long long)stats.read_max,
+         (long long)stats.delivery_avg, (long long)stats.delivery_p50,
+         (long long)stats.delivery_p99,
+         (unsigned long long)stats.stalls);
+
+   if (     threaded.reports_dropped
+         || threaded.syn_dropped
+         || threaded.out_of_order
+         || threaded.events != count
+         || threaded.rel_x != rel_x
+         || threaded.presses != presses
+         || threaded.releases != releases
+         || stats.events != count)
+   {
+      printf("FAIL: the reader thread lost or reordered events\n");
+      fail = 1;
+   }
+   else
+      printf("OK: every event came through the reader thread in order\n");
+
+   unlink(path);
+   free(recording);
+   free(direct.latencies);
+   free(threaded.latencies);
+   return fail;
+}
@@ -0,0 +1,216 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless test core for measuring fast-forward throughput.
+ *
+ * Every frame spends a fixed amount of "emulation" work, then renders a
+ * 0RGB1555 frame and 735 stereo samples unless the frontend reports
+ * through RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE that they are not
+ * wanted. Fast-forward is forced on, without a rate limit, through
+ * RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE.
+ *
+ * After the requested number of frames the core prints how many frames
+ * per second the frontend achieved, how many it would have achieved
+ * running only retro_run (core-only throughput), and how many frames
+ * were rendered, then asks the frontend to shut down.
+ *
+ * Environment:
+ *   FF_CORE_FRAMES  frames to run (default 20000)
+ *   FF_CORE_WORK    emulation work per frame, iterations (default 20000)
+ *   FF_CORE_RENDER  "always" to ignore the audio/video enable flags
+ *
+ * With the null video driver the frontend reports video as disabled to
+ * every core, so FF_CORE_RENDER=always is what shows the cost of the
+ * frontend side of the pipeline.
+ *
+ * Usage: run_bench.sh [retroarch binary] [frames] [work per frame] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libretro.h>
+
+#define FF_CORE_WIDTH       320
+#define FF_CORE_HEIGHT      240
+#define FF_CORE_SAMPLES     735
+
+static retro_environment_t environ_cb;
+static retro_video_refresh_t video_cb;
+static retro_audio_sample_batch_t audio_batch_cb;
+static retro_input_poll_t input_poll_cb;
+
+static uint16_t frame[FF_CORE_WIDTH * FF_CORE_HEIGHT];
+static int16_t samples[FF_CORE_SAMPLES * 2];
+
+static unsigned frames_total = 20000;
+static unsigned work         = 20000;
+static bool render_always    = false;
+
+static unsigned frames_run;
+static unsigned frames_video;
+static unsigned frames_audio;
+static uint32_t state        = 2463534242u;
+static int64_t start_usec;
+static int64_t core_usec;
+static bool shutdown_sent;
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t xorshift32(uint32_t x)
+{
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return x;
+}
+
+RETRO_API void retro_set_environment(retro_environment_t cb)
+{
+   bool no_game = true;
+   environ_cb   = cb;
+   cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &no_game);
+}
+
+RETRO_API void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
+RETRO_API void retro_set_audio_sample(retro_audio_sample_t cb) { }
+RETRO_API void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) { audio_batch_cb = cb; }
+RETRO_API void retro_set_input_poll(retro_input_poll_t cb) { input_poll_cb = cb; }
+RETRO_API void retro_set_input_state(retro_input_state_t cb) { }
+
+RETRO_API void retro_init(void)
+{
+   const char *s;
+   if ((s = getenv("FF_CORE_FRAMES")))
+      frames_total  = (unsigned)strtoul(s, NULL, 0);
+   if ((s = getenv("FF_CORE_WORK")))
+      work          = (unsigned)strtoul(s, NULL, 0);
+   if ((s = getenv("FF_CORE_RENDER")))
+      render_always = !strcmp(s, "always");
+}
+
+RETRO_API void retro_deinit(void) { }
+
+RETRO_API unsigned retro_api_version(void) { return RETRO_API_VERSION; }
+
+RETRO_API void retro_get_system_info(struct retro_system_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->library_name     = "ff_test_core";
+   info->library_version  = "1";
+   info->valid_extensions = "";
+}
+
+RETRO_API void retro_get_system_av_info(struct retro_system_av_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->timing.fps            = 60.0;
+   info->timing.sample_rate    = 44100.0;
+   info->geometry.base_width   = FF_CORE_WIDTH;
+   info->geometry.base_height  = FF_CORE_HEIGHT;
+   info->geometry.max_width    = FF_CORE_WIDTH;
+   info->geometry.max_height   = FF_CORE_HEIGHT;
+   info->geometry.aspect_ratio = 4.0f / 3.0f;
+}
+
+RETRO_API void retro_set_controller_port_device(unsigned port, unsigned device) { }
+RETRO_API void retro_reset(void) { }
+
+RETRO_API void retro_run(void)
+{
+   unsigned i;
+   int av       = 3;
+   int64_t t0   = bench_usec();
+   uint32_t x   = state;
+
+   input_poll_cb();
+
+   for (i = 0; i < work; i++)
+      x = xorshift32(x);
+   state = x;
+
+   if (!render_always)
+      environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av);
+
+   if (av & 1)
+   {
+      for (i = 0; i < FF_CORE_WIDTH * FF_CORE_HEIGHT; i++)
+         frame[i] = (uint16_t)((i + (x >> 7) + frames_run) & 0x7fff);
+      frames_video++;
+   }
+
+   if (av & 2)
+   {
+      for (i = 0; i < FF_CORE_SAMPLES; i++)
+      {
+         int16_t v          = (int16_t)(((i + frames_run) & 0xff) * 64 - 8192);
+         samples[i * 2 + 0] = v;
+         samples[i * 2 + 1] = v;
+      }
+      frames_audio++;
+   }
+
+   core_usec += bench_usec() - t0;
+
+   video_cb((av & 1) ? frame : NULL, FF_CORE_WIDTH, FF_CORE_HEIGHT,
+         FF_CORE_WIDTH * sizeof(uint16_t));
+   if (av & 2)
+      audio_batch_cb(samples, FF_CORE_SAMPLES);
+
+   if (++frames_run == frames_total && !shutdown_sent)
+   {
+      double sec = (bench_usec() - start_usec) / 1000000.0;
+      printf("frames %u  wall %.2f s  %.0f fps  core-only %.0f fps  "
+            "rendered video %u audio %u\n",
+            frames_run, sec, frames_run / sec,
+            frames_run / (core_usec / 1000000.0),
+            frames_video, frames_audio);
+      fflush(stdout);
+      shutdown_sent = true;
+      environ_cb(RETRO_ENVIRONMENT_SHUTDOWN, NULL);
+   }
+}
+
+RETRO_API size_t retro_serialize_size(void) { return 0; }
+RETRO_API bool retro_serialize(void *data, size_t size) { return false; }
+RETRO_API bool retro_unserialize(const void *data, size_t size) { return false; }
+RETRO_API void retro_cheat_reset(void) { }
+RETRO_API void retro_cheat_set(unsigned index, bool enabled, const char *code) { }
+
+RETRO_API bool retro_load_game(const struct retro_game_info *game)
+{
+   struct retro_fastforwarding_override ff;
+
+   ff.ratio          = 0.0f;
+   ff.fastforward    = true;
+   ff.notification   = false;
+   ff.inhibit_toggle = true;
+   environ_cb(RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE, &ff);
+
+   start_usec = bench_usec();
+   return true;
+}
+
+RETRO_API bool retro_load_game_special(unsigned type,
+      const struct retro_game_info *info, size_t num) { return false; }
+RETRO_API void retro_unload_game(void) { }
+RETRO_API unsigned retro_get_region(void) { return RETRO_REGION_NTSC; }
+RETRO_API void *retro_get_memory_data(unsigned id) { return NULL; }
+RETRO_API size_t retro_get_memory_size(unsigned id) { return 0; }
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Runs ff_test_core through the frontend headless, with the null
+# drivers, once with plain fast-forward and once with turbo
+# fast-forward, for a core that honours the audio/video enable flags
+# and for one that always renders.
+#
+# Usage: ./run_bench.sh [retroarch binary] [frames] [work per frame]
+
+RETROARCH=${1:-../../retroarch}
+FRAMES=${2:-20000}
+WORK=${3:-2000}
+CFG=$(mktemp)
+
+for render in honour always; do
+   for turbo in false true; do
+      cat > "$CFG" <<CFG_EOF
+video_driver = "null"
+audio_driver = "null"
+input_driver = "null"
+fastforward_frameskip = "true"
+fastforward_turbo = "$turbo"
+config_save_on_exit = "false"
+load_dummy_on_core_shutdown = "false"
+CFG_EOF
+      printf 'render %-6s turbo %-5s  ' $render $turbo
+      FF_CORE_FRAMES=$FRAMES FF_CORE_WORK=$WORK FF_CORE_RENDER=$render \
+         "$RETROARCH" --config "$CFG" -L ./ff_test_core.so 2>/dev/null | grep frames
+   done
+done
+
+rm -f "$CFG"
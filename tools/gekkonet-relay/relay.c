@@ -0,0 +1,599 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE /* recvmmsg/sendmmsg */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "relay.h"
+#include "../../network/netplay/netplay_gekkonet_relay.h"
+
+/* Datagrams moved per recvmmsg()/sendmmsg() call */
+#define RELAY_BATCH 64
+
+typedef struct relay_member
+{
+   struct sockaddr_in addr;
+   uint64_t           nonce;
+   int64_t            last_seen;
+   bool               used;
+} relay_member_t;
+
+typedef struct relay_session
+{
+   relay_member_t members[GEKKONET_RELAY_MAX_SLOTS];
+   uint64_t       id;
+   unsigned       count;
+   int            next_free;
+} relay_session_t;
+
+/* Session id -> session slab index */
+typedef struct relay_session_entry
+{
+   uint64_t id;
+   int      index;
+   bool     used;
+} relay_session_entry_t;
+
+/* Source address -> (session, slot) */
+typedef struct relay_route
+{
+   uint32_t ip;
+   uint16_t port;
+   uint8_t  slot;
+   bool     used;
+   int      session;
+} relay_route_t;
+
+struct relay
+{
+   relay_session_t       *sessions;
+   relay_session_entry_t *session_index;
+   relay_route_t         *routes;
+   relay_stats_t          stats;
+   size_t                 session_mask;
+   size_t                 route_mask;
+   unsigned               max_sessions;
+   unsigned               num_sessions;
+   unsigned               timeout_ms;
+   int                    free_session;
+   int                    fd;
+   unsigned short         port;
+
+   /* Receive buffers, reused for every batch. Forwarded packets are sent
+    * straight out of these after the slot byte has been rewritten. */
+   uint8_t                bufs[RELAY_BATCH][GEKKONET_RELAY_MAX_PACKET];
+   struct sockaddr_in     from[RELAY_BATCH];
+   struct sockaddr_in     to[RELAY_BATCH];
+#ifdef __linux__
+   struct mmsghdr         in_msgs[RELAY_BATCH];
+   struct iovec           in_iov[RELAY_BATCH];
+   struct mmsghdr         out_msgs[RELAY_BATCH];
+   struct iovec           out_iov[RELAY_BATCH];
+#endif
+};
+
+static size_t relay_pow2(size_t n)
+{
+   size_t p = 16;
+   while (p < n)
+      p <<= 1;
+   return p;
+}
+
+static size_t relay_hash_u64(uint64_t v)
+{
+   v ^= v >> 33;
+   v *= 0xff51afd7ed558ccdULL;
+   v ^= v >> 33;
+   return (size_t)v;
+}
+
+static size_t relay_hash_addr(uint32_t ip, uint16_t port)
+{
+   return relay_hash_u64(((uint64_t)ip << 16) | port);
+}
+
+/* --- Session index ------------------------------------------------------- */
+
+static int relay_session_find(const relay_t *relay, uint64_t id)
+{
+   size_t i = relay_hash_u64(id) & relay->session_mask;
+
+   for (; relay->session_index[i].used; i = (i + 1) & relay->session_mask)
+      if (relay->session_index[i].id == id)
+         return relay->session_index[i].index;
+   return -1;
+}
+
+static int relay_session_create(relay_t *relay, uint64_t id)
+{
+   size_t           i;
+   int              index = relay->free_session;
+   relay_session_t *session;
+
+   if (index < 0)
+      return -1;
+
+   session              = &relay->sessions[index];
+   relay->free_session  = session->next_free;
+   memset(session, 0, sizeof(*session));
+   session->id          = id;
+   session->next_free   = -1;
+
+   i = relay_hash_u64(id) & relay->session_mask;
+   while (relay->session_index[i].used)
+      i = (i + 1) & relay->session_mask;
+   relay->session_index[i].id    = id;
+   relay->session_index[i].index = index;
+   relay->session_index[i].used  = true;
+
+   relay->num_sessions++;
+   return index;
+}
+
+/* Linear probing with backward shift deletion, so lookups never have to
+ * step over tombstones. */
+static void relay_session_destroy(relay_t *relay, int index)
+{
+   size_t i = relay_hash_u64(relay->sessions[index].id) & relay->session_mask;
+   size_t j;
+
+   while (relay->session_index[i].index != index)
+      i = (i + 1) & relay->session_mask;
+
+   relay->session_index[i].used = false;
+   for (j = i;;)
+   {
+      size_t k;
+      j = (j + 1) & relay->session_mask;
+      if (!relay->session_index[j].used)
+         break;
+      k = relay_hash_u64(relay->session_index[j].id) & relay->session_mask;
+      if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+         continue;
+      relay->session_index[i]      = relay->session_index[j];
+      relay->session_index[j].used = false;
+      i = j;
+   }
+
+   relay->sessions[index].next_free = relay->free_session;
+   relay->free_session              = index;
+   relay->num_sessions--;
+}
+
+/* --- Routes -------------------------------------------------------------- */
+
+static relay_route_t *relay_route_find(relay_t *relay,
+      const struct sockaddr_in *addr)
+{
+   uint32_t ip   = addr->sin_addr.s_addr;
+   uint16_t port = addr->sin_port;
+   size_t   i    = relay_hash_addr(ip, port) & relay->route_mask;
+
+   for (; relay->routes[i].used; i = (i + 1) & relay->route_mask)
+      if (relay->routes[i].ip == ip && relay->routes[i].port == port)
+         return &relay->routes[i];
+   return NULL;
+}
+
+static void relay_route_add(relay_t *relay, const struct sockaddr_in *addr,
+      int session, uint8_t slot)
+{
+   uint32_t ip   = addr->sin_addr.s_addr;
+   uint16_t port = addr->sin_port;
+   size_t   i    = relay_hash_addr(ip, port) & relay->route_mask;
+
+   while (relay->routes[i].used)
+      i = (i + 1) & relay->route_mask;
+   relay->routes[i].ip      = ip;
+   relay->routes[i].port    = port;
+   relay->routes[i].session = session;
+   relay->routes[i].slot    = slot;
+   relay->routes[i].used    = true;
+}
+
+static void relay_route_remove(relay_t *relay, relay_route_t *route)
+{
+   size_t i = (size_t)(route - relay->routes);
+   size_t j;
+
+   relay->routes[i].used = false;
+   for (j = i;;)
+   {
+      size_t k;
+      j = (j + 1) & relay->route_mask;
+      if (!relay->routes[j].used)
+         break;
+      k = relay_hash_addr(relay->routes[j].ip, relay->routes[j].port)
+        & relay->route_mask;
+      if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+         continue;
+      relay->routes[i]      = relay->routes[j];
+      relay->routes[j].used = false;
+      i = j;
+   }
+}
+
+static void relay_member_remove(relay_t *relay, int session, uint8_t slot)
+{
+   relay_session_t *s      = &relay->sessions[session];
+   relay_member_t  *member = &s->members[slot];
+   relay_route_t   *route  = relay_route_find(relay, &member->addr);
+
+   if (route)
+      relay_route_remove(relay, route);
+   member->used = false;
+   if (!--s->count)
+      relay_session_destroy(relay, session);
+}
+
+/* --- Packet handling ----------------------------------------------------- */
+
+/* Returns true if buf should be sent to relay->to[i]. */
+static bool relay_handle(relay_t *relay, unsigned i, size_t len,
+      int64_t now_ms)
+{
+   uint8_t                  *buf  = relay->bufs[i];
+   const struct sockaddr_in *from = &relay->from[i];
+   relay_route_t            *route;
+
+   switch (gekkonet_relay_read_header(buf, len))
+   {
+      case GEKKONET_RELAY_DATA:
+         {
+            relay_session_t *session;
+            relay_member_t  *dst;
+            uint8_t          slot;
+
+            if (len <= GEKKONET_RELAY_DATA_SIZE)
+               break;
+            if (!(route = relay_route_find(relay, from)))
+               break;
+
+            session = &relay->sessions[route->session];
+            session->members[route->slot].last_seen = now_ms;
+
+            slot = buf[GEKKONET_RELAY_HEADER_SIZE];
+            if (slot >= GEKKONET_RELAY_MAX_SLOTS)
+               break;
+            dst = &session->members[slot];
+            if (!dst->used || slot == route->slot)
+               break;
+
+            buf[GEKKONET_RELAY_HEADER_SIZE] = route->slot;
+            relay->to[i] = dst->addr;
+            return true;
+         }
+
+      case GEKKONET_RELAY_REGISTER:
+         {
+            uint64_t         id;
+            uint64_t         nonce;
+            uint8_t          slot;
+            int              index;
+            relay_member_t  *member;
+
+            if (len < GEKKONET_RELAY_REGISTER_SIZE)
+               break;
+            id    = gekkonet_relay_read_session(buf);
+            nonce = gekkonet_relay_read_nonce(buf);
+            slot  = buf[GEKKONET_RELAY_HEADER_SIZE + 8];
+            if (slot >= GEKKONET_RELAY_MAX_SLOTS)
+               break;
+
+            /* Everyone would meet in the session of the empty name */
+            if (id == GEKKONET_RELAY_EMPTY_SESSION || !nonce)
+               goto reject;
+
+            /* Keepalive from a known member, or the member restarted on
+             * the same address */
+            if (     (route = relay_route_find(relay, from))
+                  && relay->sessions[route->session].id == id
+                  && route->slot == slot)
+            {
+               member            = &relay->sessions[route->session].members[slot];
+               member->nonce     = nonce;
+               member->last_seen = now_ms;
+            }
+            else
+            {
+               /* Only the member holding the slot may move it to a new
+                * address, e.g. after a NAT rebinding */
+               if (     (index = relay_session_find(relay, id)) >= 0
+                     && relay->sessions[index].members[slot].used
+                     && relay->sessions[index].members[slot].nonce != nonce)
+                  goto reject;
+
+               /* This address moves to a new session or slot */
+               if (route)
+                  relay_member_remove(relay, route->session, route->slot);
+
+               if ((index = relay_session_find(relay, id)) < 0
+                     && (index = relay_session_create(relay, id)) < 0)
+                  break;
+
+               member = &relay->sessions[index].members[slot];
+               if (member->used)
+               {
+                  route = relay_route_find(relay, &member->addr);
+                  if (route)
+                     relay_route_remove(relay, route);
+               }
+               else
+                  relay->sessions[index].count++;
+
+               member->addr      = *from;
+               member->nonce     = nonce;
+               member->last_seen = now_ms;
+               member->used      = true;
+               relay_route_add(relay, from, index, slot);
+            }
+
+            /* Acknowledge in place */
+            buf[4]       = GEKKONET_RELAY_REGISTERED;
+            relay->to[i] = *from;
+            return true;
+
+reject:
+            relay->stats.rejected++;
+            buf[4]       = GEKKONET_RELAY_REJECTED;
+            relay->to[i] = *from;
+            return true;
+         }
+
+      default:
+         break;
+   }
+
+   relay->stats.dropped++;
+   return false;
+}
+
+#ifdef __linux__
+unsigned relay_poll(relay_t *relay, int64_t now_ms)
+{
+   unsigned total = 0;
+
+   for (;;)
+   {
+      int      i;
+      int      n;
+      unsigned out = 0;
+      unsigned sent;
+
+      for (i = 0; i < RELAY_BATCH; i++)
+      {
+         relay->in_iov[i].iov_base              = relay->bufs[i];
+         relay->in_iov[i].iov_len               = GEKKONET_RELAY_MAX_PACKET;
+         relay->in_msgs[i].msg_hdr.msg_iov      = &relay->in_iov[i];
+         relay->in_msgs[i].msg_hdr.msg_iovlen   = 1;
+         relay->in_msgs[i].msg_hdr.msg_name     = &relay->from[i];
+         relay->in_msgs[i].msg_hdr.msg_namelen  = sizeof(relay->from[i]);
+         relay->in_msgs[i].msg_hdr.msg_control  = NULL;
+         relay->in_msgs[i].msg_hdr.msg_controllen = 0;
+         relay->in_msgs[i].msg_hdr.msg_flags    = 0;
+      }
+
+      n = recvmmsg(relay->fd, relay->in_msgs, RELAY_BATCH, MSG_DONTWAIT, NULL);
+      relay->stats.recv_calls++;
+      if (n <= 0)
+         break;
+
+      relay->stats.packets_in += (uint64_t)n;
+      total                   += (unsigned)n;
+
+      for (i = 0; i < n; i++)
+      {
+         size_t len = relay->in_msgs[i].msg_len;
+
+         if (!relay_handle(relay, (unsigned)i, len, now_ms))
+            continue;
+
+         relay->out_iov[out].iov_base               = relay->bufs[i];
+         relay->out_iov[out].iov_len                = len;
+         relay->out_msgs[out].msg_hdr.msg_iov       = &relay->out_iov[out];
+         relay->out_msgs[out].msg_hdr.msg_iovlen    = 1;
+         relay->out_msgs[out].msg_hdr.msg_name      = &relay->to[i];
+         relay->out_msgs[out].msg_hdr.msg_namelen   = sizeof(relay->to[i]);
+         relay->out_msgs[out].msg_hdr.msg_control   = NULL;
+         relay->out_msgs[out].msg_hdr.msg_controllen = 0;
+         relay->out_msgs[out].msg_hdr.msg_flags     = 0;
+         relay->stats.bytes_out                    += len;
+         out++;
+      }
+
+      for (sent = 0; sent < out;)
+      {
+         int ret = sendmmsg(relay->fd, relay->out_msgs + sent, out - sent, 0);
+         relay->stats.send_calls++;
+         if (ret <= 0)
+         {
+            /* Socket buffer full; the rest of this batch is lost, like
+             * any other dropped datagram. */
+            relay->stats.dropped += out - sent;
+            break;
+         }
+         sent += (unsigned)ret;
+      }
+      relay->stats.packets_out += sent;
+
+      if (n < RELAY_BATCH)
+         break;
+   }
+
+   return total;
+}
+#else
+unsigned relay_poll(relay_t *relay, int64_t now_ms)
+{
+   unsigned total = 0;
+
+   for (;;)
+   {
+      socklen_t slen = sizeof(relay->from[0]);
+      ssize_t   len  = recvfrom(relay->fd, relay->bufs[0],
+            GEKKONET_RELAY_MAX_PACKET, 0,
+            (struct sockaddr*)&relay->from[0], &slen);
+
+      relay->stats.recv_calls++;
+      if (len <= 0)
+         break;
+
+      relay->stats.packets_in++;
+      total++;
+
+      if (relay_handle(relay, 0, (size_t)len, now_ms))
+      {
+         relay->stats.send_calls++;
+         if (sendto(relay->fd, relay->bufs[0], (size_t)len, 0,
+               (struct sockaddr*)&relay->to[0], sizeof(relay->to[0])) > 0)
+         {
+            relay->stats.packets_out++;
+            relay->stats.bytes_out += (uint64_t)len;
+         }
+         else
+            relay->stats.dropped++;
+      }
+   }
+
+   return total;
+}
+#endif
+
+void relay_expire(relay_t *relay, int64_t now_ms)
+{
+   unsigned i;
+
+   for (i = 0; i < relay->max_sessions; i++)
+   {
+      relay_session_t *session = &relay->sessions[i];
+      unsigned slot;
+
+      if (!session->count)
+         continue;
+
+      for (slot = 0; slot < GEKKONET_RELAY_MAX_SLOTS; slot++)
+         if (     session->members[slot].used
+               && now_ms - session->members[slot].last_seen
+                  > (int64_t)relay->timeout_ms)
+         {
+            relay_member_remove(relay, (int)i, (uint8_t)slot);
+            if (!session->count)
+               break;
+         }
+   }
+}
+
+/* --- Setup --------------------------------------------------------------- */
+
+relay_t *relay_new(unsigned short port, unsigned max_sessions,
+      unsigned timeout_ms)
+{
+   struct sockaddr_in addr;
+   socklen_t          alen = sizeof(addr);
+   int                size = 4 * 1024 * 1024;
+   unsigned           i;
+   relay_t           *relay;
+
+   if (!max_sessions)
+      return NULL;
+
+   if (!(relay = (relay_t*)calloc(1, sizeof(*relay))))
+      return NULL;
+
+   relay->max_sessions  = max_sessions;
+   relay->timeout_ms    = timeout_ms;
+   relay->session_mask  = relay_pow2(max_sessions * 2) - 1;
+   relay->route_mask    = relay_pow2(max_sessions * 4) - 1;
+   relay->sessions      = (relay_session_t*)calloc(max_sessions,
+         sizeof(*relay->sessions));
+   relay->session_index = (relay_session_entry_t*)calloc(
+         relay->session_mask + 1, sizeof(*relay->session_index));
+   relay->routes        = (relay_route_t*)calloc(
+         relay->route_mask + 1, sizeof(*relay->routes));
+   relay->fd            = -1;
+
+   if (!relay->sessions || !relay->session_index || !relay->routes)
+      goto error;
+
+   for (i = 0; i < max_sessions; i++)
+      relay->sessions[i].next_free = (i + 1 < max_sessions) ? (int)i + 1 : -1;
+   relay->free_session = 0;
+
+   if ((relay->fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+      goto error;
+
+   /* Bursts from thousands of peers easily overrun the default buffers */
+   setsockopt(relay->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+   setsockopt(relay->fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+   fcntl(relay->fd, F_SETFL, fcntl(relay->fd, F_GETFL, 0) | O_NONBLOCK);
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_ANY);
+   addr.sin_port        = htons(port);
+   if (bind(relay->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+      goto error;
+   if (getsockname(relay->fd, (struct sockaddr*)&addr, &alen) < 0)
+      goto error;
+   relay->port = ntohs(addr.sin_port);
+
+   return relay;
+
+error:
+   relay_free(relay);
+   return NULL;
+}
+
+void relay_free(relay_t *relay)
+{
+   if (!relay)
+      return;
+   if (relay->fd >= 0)
+      close(relay->fd);
+   free(relay->sessions);
+   free(relay->session_index);
+   free(relay->routes);
+   free(relay);
+}
+
+int relay_fd(const relay_t *relay)
+{
+   return relay->fd;
+}
+
+unsigned short relay_port(const relay_t *relay)
+{
+   return relay->port;
+}
+
+unsigned relay_sessions(const relay_t *relay)
+{
+   return relay->num_sessions;
+}
+
+const relay_stats_t *relay_get_stats(const relay_t *relay)
+{
+   return &relay->stats;
+}
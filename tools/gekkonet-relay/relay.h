@@ -0,0 +1,60 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEKKONET_RELAY_SERVER_H
+#define __GEKKONET_RELAY_SERVER_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+
+/* Headless relay for GekkoNet traffic, see
+ * network/netplay/netplay_gekkonet_relay.h for the wire format. */
+
+typedef struct relay_stats
+{
+   uint64_t packets_in;
+   uint64_t packets_out;
+   uint64_t bytes_out;
+   uint64_t dropped;
+   uint64_t rejected;
+   uint64_t recv_calls;
+   uint64_t send_calls;
+} relay_stats_t;
+
+typedef struct relay relay_t;
+
+/* Binds to 'port' (0 = ephemeral) on all interfaces. Routing tables are
+ * sized for 'max_sessions' sessions. */
+relay_t *relay_new(unsigned short port, unsigned max_sessions,
+      unsigned timeout_ms);
+
+void relay_free(relay_t *relay);
+
+int relay_fd(const relay_t *relay);
+
+unsigned short relay_port(const relay_t *relay);
+
+/* Forwards every datagram waiting on the socket, in batches.
+ * Returns the number of datagrams handled. */
+unsigned relay_poll(relay_t *relay, int64_t now_ms);
+
+/* Drops members that have been silent for longer than the timeout. */
+void relay_expire(relay_t *relay, int64_t now_ms);
+
+unsigned relay_sessions(const relay_t *relay);
+
+const relay_stats_t *relay_get_stats(const relay_t *relay);
+
+#endif
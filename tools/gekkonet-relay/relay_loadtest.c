@@ -0,0 +1,478 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Load test for gekkonet-relay: simulates many two player sessions on
+ * loopback, each member sending one datagram per frame to its peer, first
+ * directly and then through the relay, and reports relay throughput and
+ * the latency it adds.
+ *
+ * Usage: relay_loadtest [-n sessions] [-d seconds] [-r rate] [-b bytes] [-a relay host:port]
+ * Without -a, a relay is started on a thread of this process. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "relay.h"
+#include "../../network/netplay/netplay_gekkonet_relay.h"
+
+/* Latency histogram: 10 usec buckets up to 100 msec */
+#define LT_BUCKET_USEC 10
+#define LT_BUCKETS     10000
+
+typedef struct lt_member
+{
+   struct sockaddr_in addr;
+   int                fd;
+   uint8_t            slot;
+   bool               registered;
+} lt_member_t;
+
+typedef struct lt_result
+{
+   uint64_t sent;
+   uint64_t received;
+   uint64_t latency_sum;
+   uint64_t latency_max;
+   uint32_t hist[LT_BUCKETS + 1];
+} lt_result_t;
+
+static lt_member_t        *members;
+static struct pollfd      *pfds;
+static unsigned            num_members;
+static struct sockaddr_in  relay_addr;
+static uint64_t            session_base;
+
+static relay_t            *local_relay;
+static volatile int        relay_thread_quit;
+
+static int64_t lt_now_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *lt_relay_thread(void *data)
+{
+   (void)data;
+   while (!relay_thread_quit)
+   {
+      struct pollfd pfd;
+      pfd.fd      = relay_fd(local_relay);
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, 10) > 0)
+         relay_poll(local_relay, lt_now_usec() / 1000);
+   }
+   return NULL;
+}
+
+static bool lt_raise_fd_limit(unsigned needed)
+{
+   struct rlimit rl;
+
+   if (getrlimit(RLIMIT_NOFILE, &rl) < 0)
+      return false;
+   if (rl.rlim_cur >= needed)
+      return true;
+   if (rl.rlim_max < needed)
+      return false;
+   rl.rlim_cur = needed;
+   return setrlimit(RLIMIT_NOFILE, &rl) == 0;
+}
+
+static bool lt_open_members(unsigned sessions)
+{
+   unsigned i;
+
+   num_members = sessions * 2;
+   members     = (lt_member_t*)calloc(num_members, sizeof(*members));
+   pfds        = (struct pollfd*)calloc(num_members, sizeof(*pfds));
+   if (!members || !pfds)
+      return false;
+
+   for (i = 0; i < num_members; i++)
+   {
+      socklen_t len = sizeof(members[i].addr);
+
+      members[i].slot                 = (uint8_t)(i & 1);
+      members[i].addr.sin_family      = AF_INET;
+      members[i].addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      members[i].fd = socket(AF_INET, SOCK_DGRAM, 0);
+      if (members[i].fd < 0)
+         return false;
+      fcntl(members[i].fd, F_SETFL,
+            fcntl(members[i].fd, F_GETFL, 0) | O_NONBLOCK);
+      if (bind(members[i].fd, (struct sockaddr*)&members[i].addr,
+               sizeof(members[i].addr)) < 0)
+         return false;
+      getsockname(members[i].fd, (struct sockaddr*)&members[i].addr, &len);
+
+      pfds[i].fd     = members[i].fd;
+      pfds[i].events = POLLIN;
+   }
+
+   return true;
+}
+
+static bool lt_register(void)
+{
+   int64_t  deadline = lt_now_usec() + 5000000;
+   unsigned pending  = num_members;
+
+   while (pending && lt_now_usec() < deadline)
+   {
+      unsigned i;
+      int64_t  resend = lt_now_usec() + 200000;
+
+      for (i = 0; i < num_members; i++)
+      {
+         uint8_t pkt[GEKKONET_RELAY_REGISTER_SIZE];
+         if (members[i].registered)
+            continue;
+         gekkonet_relay_write_register(pkt, GEKKONET_RELAY_REGISTER,
+               session_base + i / 2, members[i].slot, i + 1);
+         sendto(members[i].fd, pkt, sizeof(pkt), 0,
+               (struct sockaddr*)&relay_addr, sizeof(relay_addr));
+      }
+
+      while (pending && lt_now_usec() < resend)
+      {
+         if (poll(pfds, num_members, 20) <= 0)
+            continue;
+         for (i = 0; i < num_members; i++)
+         {
+            uint8_t buf[64];
+            if (!(pfds[i].revents & POLLIN))
+               continue;
+            while (recv(members[i].fd, buf, sizeof(buf), 0) > 0)
+               if (     gekkonet_relay_read_header(buf, sizeof(buf))
+                        == GEKKONET_RELAY_REGISTERED
+                     && !members[i].registered)
+               {
+                  members[i].registered = true;
+                  pending--;
+               }
+         }
+      }
+   }
+
+   return !pending;
+}
+
+/* A stranger that knows a session id must not take over a held slot. */
+static bool lt_takeover_rejected(void)
+{
+   uint8_t            pkt[GEKKONET_RELAY_REGISTER_SIZE];
+   struct sockaddr_in addr;
+   struct pollfd      pfd;
+   int64_t            deadline = lt_now_usec() + 1000000;
+   uint8_t            type     = 0;
+   int                fd       = socket(AF_INET, SOCK_DGRAM, 0);
+
+   if (fd < 0)
+      return false;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+
+   gekkonet_relay_write_register(pkt, GEKKONET_RELAY_REGISTER,
+         session_base, members[0].slot, ~(uint64_t)0);
+   sendto(fd, pkt, sizeof(pkt), 0,
+         (struct sockaddr*)&relay_addr, sizeof(relay_addr));
+
+   pfd.fd     = fd;
+   pfd.events = POLLIN;
+   while (!type && lt_now_usec() < deadline)
+      if (     poll(&pfd, 1, 20) > 0
+            && recv(fd, pkt, sizeof(pkt), 0) > 0)
+         type = gekkonet_relay_read_header(pkt, sizeof(pkt));
+
+   close(fd);
+   return type == GEKKONET_RELAY_REJECTED;
+}
+
+static void lt_receive(lt_member_t *member, bool relayed, lt_result_t *res)
+{
+   uint8_t buf[GEKKONET_RELAY_MAX_PACKET];
+   size_t  ofs = relayed ? GEKKONET_RELAY_DATA_SIZE : 0;
+   ssize_t len;
+
+   while ((len = recv(member->fd, buf, sizeof(buf), 0)) > 0)
+   {
+      int64_t  sent_at;
+      uint64_t usec;
+
+      if ((size_t)len < ofs + sizeof(sent_at))
+         continue;
+      if (relayed && gekkonet_relay_read_header(buf, (size_t)len)
+            != GEKKONET_RELAY_DATA)
+         continue;
+
+      memcpy(&sent_at, buf + ofs, sizeof(sent_at));
+      usec = (uint64_t)(lt_now_usec() - sent_at);
+
+      res->received++;
+      res->latency_sum += usec;
+      if (usec > res->latency_max)
+         res->latency_max = usec;
+      res->hist[usec / LT_BUCKET_USEC < LT_BUCKETS
+         ? usec / LT_BUCKET_USEC : LT_BUCKETS]++;
+   }
+}
+
+static void lt_run(bool relayed, unsigned seconds, unsigned rate,
+      unsigned bytes, lt_result_t *res)
+{
+   uint8_t  pkt[GEKKONET_RELAY_MAX_PACKET];
+   size_t   ofs       = relayed ? GEKKONET_RELAY_DATA_SIZE : 0;
+   int64_t  period    = 1000000 / rate;
+   int64_t  start     = lt_now_usec();
+   int64_t  end       = start + (int64_t)seconds * 1000000;
+   int64_t  drain_end = end + 200000;
+   int64_t  next_tick = start;
+
+   memset(pkt, 0xa5, sizeof(pkt));
+   memset(res, 0, sizeof(*res));
+
+   for (;;)
+   {
+      int64_t  now = lt_now_usec();
+      int      timeout;
+      unsigned i;
+
+      if (now >= drain_end)
+         break;
+
+      if (now >= next_tick && now < end)
+      {
+         for (i = 0; i < num_members; i++)
+         {
+            lt_member_t *peer = &members[i ^ 1];
+            int64_t      ts   = lt_now_usec();
+
+            if (relayed)
+            {
+               gekkonet_relay_write_header(pkt, GEKKONET_RELAY_DATA);
+               pkt[GEKKONET_RELAY_HEADER_SIZE] = peer->slot;
+            }
+            memcpy(pkt + ofs, &ts, sizeof(ts));
+
+            if (sendto(members[i].fd, pkt, ofs + bytes, 0,
+                  relayed
+                     ? (struct sockaddr*)&relay_addr
+                     : (struct sockaddr*)&peer->addr,
+                  sizeof(struct sockaddr_in)) > 0)
+               res->sent++;
+         }
+         next_tick += period;
+         /* Fell behind: skip ticks rather than bursting */
+         if (next_tick < now)
+            next_tick = now + period;
+      }
+
+      timeout = (int)(((now < end ? next_tick : drain_end) - lt_now_usec()) / 1000);
+      if (timeout < 0)
+         timeout = 0;
+      if (poll(pfds, num_members, timeout) <= 0)
+         continue;
+
+      for (i = 0; i < num_members; i++)
+         if (pfds[i].revents & POLLIN)
+            lt_receive(&members[i], relayed, res);
+   }
+}
+
+static uint64_t lt_percentile(const lt_result_t *res, double pct)
+{
+   uint64_t target = (uint64_t)(res->received * pct);
+   uint64_t seen   = 0;
+   unsigned i;
+
+   for (i = 0; i <= LT_BUCKETS; i++)
+   {
+      seen += res->hist[i];
+      if (seen > target)
+         return (uint64_t)i * LT_BUCKET_USEC;
+   }
+   return res->latency_max;
+}
+
+static void lt_report(const char *name, const lt_result_t *res,
+      unsigned seconds, unsigned bytes)
+{
+   double secs = (double)seconds;
+
+   printf("%-7s sent %9llu  received %9llu  loss %5.2f%%  "
+         "%8.0f pkt/s  %7.2f Mbit/s  latency avg %5llu p50 %5llu p99 %6llu max %6llu us\n",
+         name,
+         (unsigned long long)res->sent,
+         (unsigned long long)res->received,
+         res->sent ? 100.0 * (double)(res->sent - res->received) / res->sent : 0.0,
+         res->received / secs,
+         res->received * (double)bytes * 8.0 / secs / 1e6,
+         (unsigned long long)(res->received ? res->latency_sum / res->received : 0),
+         (unsigned long long)lt_percentile(res, 0.50),
+         (unsigned long long)lt_percentile(res, 0.99),
+         (unsigned long long)res->latency_max);
+}
+
+int main(int argc, char *argv[])
+{
+   static lt_result_t direct;
+   static lt_result_t relayed;
+   unsigned  sessions = 1000;
+   unsigned  seconds  = 5;
+   unsigned  rate     = 60;
+   unsigned  bytes    = 64;
+   const char *remote = NULL;
+   pthread_t thread;
+   int       i;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         sessions = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+         seconds  = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+         rate     = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+         bytes    = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-a") && i + 1 < argc)
+         remote   = argv[++i];
+      else
+      {
+         fprintf(stderr, "Usage: %s [-n sessions] [-d seconds] [-r rate] "
+               "[-b bytes] [-a relay host:port]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   if (!sessions || !seconds || !rate || bytes < sizeof(int64_t)
+         || bytes > GEKKONET_RELAY_MAX_PACKET - GEKKONET_RELAY_DATA_SIZE)
+   {
+      fprintf(stderr, "Invalid parameters.\n");
+      return 1;
+   }
+
+   if (!lt_raise_fd_limit(sessions * 2 + 64))
+   {
+      fprintf(stderr, "Cannot open %u sockets, raise the file descriptor limit.\n",
+            sessions * 2);
+      return 1;
+   }
+
+   memset(&relay_addr, 0, sizeof(relay_addr));
+   relay_addr.sin_family = AF_INET;
+   if (remote)
+   {
+      char host[64];
+      const char *colon = strrchr(remote, ':');
+      size_t len        = colon ? (size_t)(colon - remote) : strlen(remote);
+
+      if (len >= sizeof(host))
+         len = sizeof(host) - 1;
+      memcpy(host, remote, len);
+      host[len] = '\0';
+      relay_addr.sin_port = htons(colon
+            ? (unsigned short)strtoul(colon + 1, NULL, 0)
+            : GEKKONET_RELAY_DEFAULT_PORT);
+      if (inet_pton(AF_INET, host, &relay_addr.sin_addr) != 1)
+      {
+         fprintf(stderr, "Invalid relay address %s.\n", remote);
+         return 1;
+      }
+   }
+   else
+   {
+      if (!(local_relay = relay_new(0, sessions, GEKKONET_RELAY_TIMEOUT_MS)))
+      {
+         fprintf(stderr, "Could not start the relay.\n");
+         return 1;
+      }
+      relay_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      relay_addr.sin_port        = htons(relay_port(local_relay));
+      pthread_create(&thread, NULL, lt_relay_thread, NULL);
+   }
+
+   if (!lt_open_members(sessions))
+   {
+      fprintf(stderr, "Could not open member sockets.\n");
+      return 1;
+   }
+
+   session_base = (uint64_t)lt_now_usec() << 20;
+
+   printf("%u sessions, %u members, %u Hz, %u byte payloads, %u s per run\n",
+         sessions, num_members, rate, bytes, seconds);
+
+   lt_run(false, seconds, rate, bytes, &direct);
+   lt_report("direct", &direct, seconds, bytes);
+
+   /* Registering last keeps members from timing out on a relay with a
+    * short timeout while the direct run goes on */
+   if (!lt_register())
+   {
+      fprintf(stderr, "Not every member could register with the relay.\n");
+      return 1;
+   }
+
+   if (!lt_takeover_rejected())
+   {
+      fprintf(stderr, "The relay let a stranger take over a slot.\n");
+      return 1;
+   }
+
+   lt_run(true,  seconds, rate, bytes, &relayed);
+   lt_report("relay",  &relayed, seconds, bytes);
+
+   printf("added latency: avg %lld us, p50 %lld us, p99 %lld us\n",
+         (long long)(relayed.received ? relayed.latency_sum / relayed.received : 0)
+       - (long long)(direct.received  ? direct.latency_sum  / direct.received  : 0),
+         (long long)lt_percentile(&relayed, 0.50) - (long long)lt_percentile(&direct, 0.50),
+         (long long)lt_percentile(&relayed, 0.99) - (long long)lt_percentile(&direct, 0.99));
+
+   if (local_relay)
+   {
+      const relay_stats_t *stats = relay_get_stats(local_relay);
+      relay_thread_quit = 1;
+      pthread_join(thread, NULL);
+      printf("relay: %u sessions, %llu in, %llu out, %llu dropped, "
+            "%llu rejected, %.1f packets per recv call, %.1f per send call\n",
+            relay_sessions(local_relay),
+            (unsigned long long)stats->packets_in,
+            (unsigned long long)stats->packets_out,
+            (unsigned long long)stats->dropped,
+            (unsigned long long)stats->rejected,
+            stats->recv_calls ? (double)stats->packets_in / stats->recv_calls : 0.0,
+            stats->send_calls ? (double)stats->packets_out / stats->send_calls : 0.0);
+      relay_free(local_relay);
+   }
+
+   return 0;
+}
@@ -0,0 +1,142 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* gekkonet-relay: forwards GekkoNet datagrams between the members of a
+ * session, for players that cannot reach each other directly.
+ *
+ * Usage: gekkonet-relay [-p port] [-s max sessions] [-t timeout ms] [-q] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+
+#include "relay.h"
+#include "../../network/netplay/netplay_gekkonet_relay.h"
+
+#define RELAY_STATS_INTERVAL_MS 10000
+
+static volatile sig_atomic_t relay_quit = 0;
+
+static void relay_sighandler(int sig)
+{
+   (void)sig;
+   relay_quit = 1;
+}
+
+static int64_t relay_now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void relay_usage(const char *argv0)
+{
+   fprintf(stderr,
+         "Usage: %s [-p port] [-s max sessions] [-t timeout ms] [-q]\n"
+         "  -p  UDP port to listen on (default %u)\n"
+         "  -s  Maximum number of concurrent sessions (default 4096)\n"
+         "  -t  Forget members silent for this long (default %u)\n"
+         "  -q  Do not print periodic statistics\n",
+         argv0, (unsigned)GEKKONET_RELAY_DEFAULT_PORT,
+         (unsigned)GEKKONET_RELAY_TIMEOUT_MS);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned short port     = GEKKONET_RELAY_DEFAULT_PORT;
+   unsigned max_sessions   = 4096;
+   unsigned timeout_ms     = GEKKONET_RELAY_TIMEOUT_MS;
+   bool quiet              = false;
+   int64_t next_expire;
+   int64_t next_stats;
+   relay_t *relay;
+   int i;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-p") && i + 1 < argc)
+         port         = (unsigned short)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+         max_sessions = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+         timeout_ms   = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-q"))
+         quiet        = true;
+      else
+      {
+         relay_usage(argv[0]);
+         return 1;
+      }
+   }
+
+   if (!(relay = relay_new(port, max_sessions, timeout_ms)))
+   {
+      fprintf(stderr, "Could not start relay on port %u.\n", (unsigned)port);
+      return 1;
+   }
+
+   signal(SIGINT,  relay_sighandler);
+   signal(SIGTERM, relay_sighandler);
+
+   printf("GekkoNet relay listening on UDP port %u (%u sessions max).\n",
+         (unsigned)relay_port(relay), max_sessions);
+   fflush(stdout);
+
+   next_expire = relay_now_ms() + 1000;
+   next_stats  = relay_now_ms() + RELAY_STATS_INTERVAL_MS;
+
+   while (!relay_quit)
+   {
+      struct pollfd pfd;
+      int64_t now;
+
+      pfd.fd      = relay_fd(relay);
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      poll(&pfd, 1, 1000);
+
+      now = relay_now_ms();
+      if (pfd.revents & POLLIN)
+         relay_poll(relay, now);
+
+      if (now >= next_expire)
+      {
+         relay_expire(relay, now);
+         next_expire = now + 1000;
+      }
+
+      if (!quiet && now >= next_stats)
+      {
+         const relay_stats_t *stats = relay_get_stats(relay);
+         printf("sessions %u  in %llu  out %llu  dropped %llu  "
+               "rejected %llu  (%.1f packets per recv call)\n",
+               relay_sessions(relay),
+               (unsigned long long)stats->packets_in,
+               (unsigned long long)stats->packets_out,
+               (unsigned long long)stats->dropped,
+               (unsigned long long)stats->rejected,
+               stats->recv_calls
+                  ? (double)stats->packets_in / stats->recv_calls : 0.0);
+         fflush(stdout);
+         next_stats = now + RELAY_STATS_INTERVAL_MS;
+      }
+   }
+
+   relay_free(relay);
+   return 0;
+}
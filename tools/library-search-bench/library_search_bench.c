@@ -0,0 +1,457 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times searching a large library through library_search.c.
+ *
+ * Synthetic entries are spread over a number of playlists, each with
+ * a title made of a few words, a region and some database metadata.
+ * Building the index, saving and loading it are timed, then every
+ * prefix of a set of titles is queried the way it would be typed,
+ * against a case insensitive substring scan of all labels.
+ *
+ * Each full title must be among the first results for it, titles
+ * with a mistyped letter must still be found, a loaded index must
+ * answer like the one it was saved from, and rebuilding a single
+ * playlist must replace only its own entries.
+ *
+ * Usage: library_search_bench [-n entries] [-p playlists] [-d dir] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <compat/strcasestr.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "../../library_search.h"
+
+#define NUM_QUERIES 100
+
+static const char *words[] = {
+   "super", "mario", "world", "legend", "zelda", "sonic", "hedgehog",
+   "street", "fighter", "final", "fantasy", "metal", "gear", "solid",
+   "castlevania", "symphony", "night", "donkey", "kong", "country",
+   "mega", "man", "chrono", "trigger", "secret", "mana", "kirby",
+   "dream", "land", "pokemon", "crystal", "ruby", "sapphire", "tetris",
+   "puzzle", "league", "racing", "kart", "star", "fox", "wars",
+   "rogue", "squadron", "dragon", "quest", "warrior", "ninja",
+   "gaiden", "turtles", "adventure", "island", "yoshis", "story",
+   "banjo", "kazooie", "golden", "eye", "perfect", "dark", "resident",
+   "evil", "silent", "hill", "crash", "bandicoot", "spyro", "tekken",
+   "soul", "calibur", "mortal", "kombat", "ridge", "racer", "gran",
+   "turismo", "tony", "hawk", "pro", "skater", "ape", "escape",
+   "jet", "set", "radio", "shenmue", "phantasy", "panzer", "dragoon",
+   "saga", "frontier", "breath", "fire", "illusion", "gaia", "terranigma",
+   "earthbound", "mother", "contra", "hard", "corps", "gradius",
+   "darius", "axelay", "ikaruga", "radiant", "silvergun", "thunder",
+   "force", "gunstar", "heroes", "streets", "rage", "golden", "axe",
+   "shinobi", "alex", "kidd", "wonder", "boy", "monster", "bomberman",
+   "adventures", "bonk", "bloody", "roar", "lords", "thunder", "ys",
+   "ancient", "lost", "valestein", "cotton", "fantastic", "night",
+   "dreams", "parodius", "twinbee", "goemon", "mystical", "ninja"
+};
+
+static const char *regions[] = {
+   "(USA)", "(Europe)", "(Japan)", "(USA, Europe)", "(World)",
+   "(Japan) (Rev 1)", "(Europe) (En,Fr,De)", "(Brazil)"
+};
+
+static const char *genres[] = {
+   "Action", "Platform", "Role-Playing", "Shooter", "Racing",
+   "Fighting", "Puzzle", "Sports", "Strategy", "Adventure"
+};
+
+static const char *publishers[] = {
+   "Nintendo", "Sega", "Capcom", "Konami", "Square", "Namco",
+   "Hudson Soft", "Taito", "Enix", "Irem"
+};
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+   int64_t x = *(const int64_t*)a;
+   int64_t y = *(const int64_t*)b;
+   return (x > y) - (x < y);
+}
+
+/* Game title of two to four words, as the label, and its full
+ * name with the region */
+static void random_title(char *title, size_t title_len,
+      char *name, size_t name_len, unsigned n)
+{
+   unsigned i;
+   unsigned num_words = 2 + rng() % 3;
+   size_t _len        = 0;
+
+   title[0] = '\0';
+   for (i = 0; i < num_words; i++)
+   {
+      const char *word = words[rng() % ARRAY_SIZE(words)];
+      if (i)
+         _len += strlcpy(title + _len, " ", title_len - _len);
+      title[_len] = (char)(word[0] - 'a' + 'A');
+      _len       += 1 + strlcpy(title + _len + 1, word + 1,
+            title_len - _len - 1);
+   }
+   /* Keep titles distinct */
+   snprintf(title + _len, title_len - _len, " %u", n);
+   snprintf(name, name_len, "%s %s", title, regions[rng() % ARRAY_SIZE(regions)]);
+}
+
+typedef struct
+{
+   char path[PATH_MAX_LENGTH];
+   library_search_doc_t *docs;
+   size_t count;
+} bench_playlist_t;
+
+static size_t brute_force(bench_playlist_t *playlists, unsigned num_playlists,
+      const char *query, library_search_result_t *results, size_t max)
+{
+   unsigned p;
+   size_t i, count = 0;
+   for (p = 0; p < num_playlists; p++)
+      for (i = 0; i < playlists[p].count; i++)
+         if (strcasestr(playlists[p].docs[i].label, query) && count < max)
+         {
+            results[count].playlist_path = playlists[p].path;
+            results[count].label         = playlists[p].docs[i].label;
+            results[count].entry_idx     = playlists[p].docs[i].entry_idx;
+            results[count].score         = 0;
+            count++;
+         }
+   return count;
+}
+
+static bool in_results(const library_search_result_t *results, size_t count,
+      size_t top, const char *label)
+{
+   size_t i;
+   for (i = 0; i < count && i < top; i++)
+      if (string_is_equal(results[i].label, label))
+         return true;
+   return false;
+}
+
+static library_search_segment_t *build_segment(bench_playlist_t *playlist)
+{
+   return library_search_segment_new(playlist->path, 1, 1,
+         playlist->docs, playlist->count);
+}
+
+int main(int argc, char **argv)
+{
+   unsigned i, p;
+   char index_path[PATH_MAX_LENGTH];
+   library_search_result_t results[LIBRARY_SEARCH_MAX_RESULTS];
+   library_search_result_t loaded_results[LIBRARY_SEARCH_MAX_RESULTS];
+   int64_t *times_index        = NULL;
+   int64_t *times_brute        = NULL;
+   size_t num_times            = 0;
+   unsigned num_entries        = 200000;
+   unsigned num_playlists      = 40;
+   const char *dir             = "/tmp";
+   bench_playlist_t *playlists = NULL;
+   library_search_t *index     = NULL;
+   library_search_t *loaded    = NULL;
+   library_search_t *updated   = NULL;
+   unsigned failures           = 0;
+   unsigned found_full         = 0;
+   unsigned found_typo         = 0;
+   unsigned num_typo           = 0;
+   int64_t t_build, t_save, t_load, t_rebuild;
+
+   for (i = 1; i < (unsigned)argc; i++)
+   {
+      if (string_is_equal(argv[i], "-n") && i + 1 < (unsigned)argc)
+         num_entries = (unsigned)strtoul(argv[++i], NULL, 10);
+      else if (string_is_equal(argv[i], "-p") && i + 1 < (unsigned)argc)
+         num_playlists = (unsigned)strtoul(argv[++i], NULL, 10);
+      else if (string_is_equal(argv[i], "-d") && i + 1 < (unsigned)argc)
+         dir = argv[++i];
+   }
+   if (!num_playlists)
+      num_playlists = 1;
+
+   fill_pathname_join_special(index_path, dir, "library_search_bench.idx",
+         sizeof(index_path));
+
+   /* Generate the library */
+   playlists = (bench_playlist_t*)calloc(num_playlists, sizeof(*playlists));
+   for (p = 0; p < num_playlists; p++)
+   {
+      snprintf(playlists[p].path, sizeof(playlists[p].path),
+            "/playlists/System %u.lpl", p);
+      playlists[p].docs = (library_search_doc_t*)calloc(
+            num_entries / num_playlists + 1, sizeof(library_search_doc_t));
+   }
+   for (i = 0; i < num_entries; i++)
+   {
+      char title[256];
+      char name[256];
+      char text[512];
+      bench_playlist_t *playlist = &playlists[i % num_playlists];
+      library_search_doc_t *doc  = &playlist->docs[playlist->count];
+
+      random_title(title, sizeof(title), name, sizeof(name), i);
+      snprintf(text, sizeof(text), "%s.zip %s %s %u",
+            name, genres[rng() % ARRAY_SIZE(genres)],
+            publishers[rng() % ARRAY_SIZE(publishers)],
+            1985 + rng() % 20);
+      doc->label     = strdup(title);
+      doc->text      = strdup(text);
+      doc->entry_idx = (uint32_t)playlist->count++;
+   }
+
+   printf("%u entries, %u playlists\n\n", num_entries, num_playlists);
+
+   /* Build */
+   t_build = bench_usec();
+   index   = library_search_new();
+   for (p = 0; p < num_playlists; p++)
+   {
+      library_search_segment_t *segment = build_segment(&playlists[p]);
+      if (!library_search_add(index, segment))
+         failures++;
+      library_search_segment_free(segment);
+   }
+   t_build = bench_usec() - t_build;
+   if (library_search_size(index) != num_entries)
+   {
+      printf("index holds %u entries, expected %u\n",
+            (unsigned)library_search_size(index), num_entries);
+      failures++;
+   }
+
+   t_save = bench_usec();
+   if (!library_search_save(index, index_path))
+   {
+      printf("saving %s failed\n", index_path);
+      failures++;
+   }
+   t_save = bench_usec() - t_save;
+
+   t_load = bench_usec();
+   loaded = library_search_load(index_path);
+   t_load = bench_usec() - t_load;
+   if (!loaded || library_search_size(loaded) != num_entries)
+   {
+      printf("loading %s failed\n", index_path);
+      failures++;
+   }
+
+   /* Type titles one key at a time */
+   times_index = (int64_t*)malloc(NUM_QUERIES * 64 * sizeof(int64_t));
+   times_brute = (int64_t*)malloc(NUM_QUERIES * 64 * sizeof(int64_t));
+   for (i = 0; i < NUM_QUERIES; i++)
+   {
+      size_t j, count;
+      char query[64];
+      const bench_playlist_t *playlist = &playlists[rng() % num_playlists];
+      const char *label                = playlist->docs[
+         rng() % playlist->count].label;
+
+      for (j = 1; label[j - 1] && j < sizeof(query) && num_times
+            < NUM_QUERIES * 64; j++)
+      {
+         int64_t t;
+         strlcpy(query, label, j + 1);
+
+         t = bench_usec();
+         library_search_query(index, query, results, ARRAY_SIZE(results));
+         times_index[num_times] = bench_usec() - t;
+
+         t = bench_usec();
+         brute_force(playlists, num_playlists, query, results,
+               ARRAY_SIZE(results));
+         times_brute[num_times] = bench_usec() - t;
+         num_times++;
+      }
+
+      count = library_search_query(index, label, results, ARRAY_SIZE(results));
+      if (in_results(results, count, 3, label))
+         found_full++;
+      else
+         printf("\"%s\" not in the first results\n", label);
+
+      if (loaded)
+      {
+         size_t k;
+         size_t loaded_count = library_search_query(loaded, label,
+               loaded_results, ARRAY_SIZE(loaded_results));
+         bool same           = (loaded_count == count);
+         for (k = 0; same && k < count; k++)
+            same = results[k].entry_idx == loaded_results[k].entry_idx
+               && results[k].score == loaded_results[k].score
+               && string_is_equal(results[k].playlist_path,
+                     loaded_results[k].playlist_path);
+         if (!same)
+         {
+            printf("loaded index answers \"%s\" differently\n", label);
+            failures++;
+         }
+      }
+
+      /* Change one letter of the longest word */
+      if (strlen(label) >= 12)
+      {
+         char typo[256];
+         size_t at = 0, best = 0, start = 0;
+         strlcpy(typo, label, sizeof(typo));
+         for (j = 0; ; j++)
+         {
+            if (typo[j] == ' ' || !typo[j])
+            {
+               if (j - start > best)
+               {
+                  best = j - start;
+                  at   = start + best / 2;
+               }
+               start = j + 1;
+               if (!typo[j])
+                  break;
+            }
+         }
+         if (best >= 5)
+         {
+            typo[at] = (typo[at] == 'x') ? 'q' : 'x';
+            num_typo++;
+            count = library_search_query(index, typo, results,
+                  ARRAY_SIZE(results));
+            if (in_results(results, count, 10, label))
+               found_typo++;
+            else
+               printf("\"%s\" not found for \"%s\"\n", label, typo);
+         }
+      }
+   }
+
+   qsort(times_index, num_times, sizeof(int64_t), cmp_i64);
+   qsort(times_brute, num_times, sizeof(int64_t), cmp_i64);
+
+   /* Rebuild one playlist after adding an entry to it */
+   {
+      library_search_segment_t *segment;
+      bench_playlist_t *playlist = &playlists[0];
+      library_search_doc_t *docs = (library_search_doc_t*)realloc(
+            playlist->docs, (playlist->count + 1) * sizeof(*docs));
+      size_t count;
+
+      playlist->docs                     = docs;
+      docs[playlist->count].label        = strdup("Zzyzx Quokka Odyssey");
+      docs[playlist->count].text         = NULL;
+      docs[playlist->count].entry_idx    = (uint32_t)playlist->count;
+      playlist->count++;
+
+      t_rebuild = bench_usec();
+      updated   = library_search_new();
+      for (p = 0; p < num_playlists; p++)
+      {
+         if (p == 0)
+         {
+            segment = build_segment(playlist);
+            library_search_add(updated, segment);
+            library_search_segment_free(segment);
+         }
+         else
+            library_search_add(updated,
+                  library_search_find(index, playlists[p].path));
+      }
+      t_rebuild = bench_usec() - t_rebuild;
+
+      count = library_search_query(updated, "quokka odys", results,
+            ARRAY_SIZE(results));
+      if (     library_search_size(updated) != num_entries + 1
+            || !count
+            || !string_is_equal(results[0].playlist_path, playlist->path)
+            || results[0].entry_idx != playlist->count - 1)
+      {
+         printf("rebuilt playlist not searched\n");
+         failures++;
+      }
+      if (library_search_query(index, "quokka odys", results,
+               ARRAY_SIZE(results)))
+      {
+         printf("previous index changed by the rebuild\n");
+         failures++;
+      }
+   }
+
+   printf("%-22s %10s\n", "", "total ms");
+   printf("%-22s %10.1f\n", "build", t_build / 1000.0);
+   printf("%-22s %10.1f\n", "save", t_save / 1000.0);
+   printf("%-22s %10.1f\n", "load", t_load / 1000.0);
+   printf("%-22s %10.1f\n", "rebuild one playlist", t_rebuild / 1000.0);
+   printf("\n%u keystrokes\n", (unsigned)num_times);
+   printf("%-22s %10s %10s %10s\n", "", "p50 us", "p99 us", "max us");
+   printf("%-22s %10lld %10lld %10lld\n", "index",
+         (long long)times_index[num_times / 2],
+         (long long)times_index[num_times * 99 / 100],
+         (long long)times_index[num_times - 1]);
+   printf("%-22s %10lld %10lld %10lld\n", "substring scan",
+         (long long)times_brute[num_times / 2],
+         (long long)times_brute[num_times * 99 / 100],
+         (long long)times_brute[num_times - 1]);
+   printf("\nfull titles found %u/%u, with a typo %u/%u\n",
+         found_full, NUM_QUERIES, found_typo, num_typo);
+
+   if (found_full != NUM_QUERIES || found_typo != num_typo)
+      failures++;
+
+   filestream_delete(index_path);
+   library_search_free(index);
+   library_search_free(loaded);
+   library_search_free(updated);
+   for (p = 0; p < num_playlists; p++)
+   {
+      size_t j;
+      for (j = 0; j < playlists[p].count; j++)
+      {
+         free((char*)playlists[p].docs[j].label);
+         free((char*)playlists[p].docs[j].text);
+      }
+      free(playlists[p].docs);
+   }
+   free(playlists);
+   free(times_index);
+   free(times_brute);
+
+   if (failures)
+   {
+      printf("FAILED\n");
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,417 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the trans_stream backends netplay can use for savestate
+ * transfers: compression ratio and time, round trip checked.
+ *
+ * Given savestate files (of one core, oldest first), it compresses those.
+ * Otherwise it builds sequences of synthetic states shaped after a few kinds
+ * of systems: sparse work RAM, tile based video memory, sample data and
+ * register blocks, changing a little from one state to the next.
+ *
+ * The "dict" rows load the first state of a sequence as a raw zstd
+ * dictionary and compress the rest against it, the way a per-core
+ * dictionary from sample states would be used. Every zstd row is also
+ * decompressed in 64 KiB pieces to exercise incremental streaming.
+ *
+ * Usage: compression_bench [-n states] [state files...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include <streams/trans_stream.h>
+
+#define CHUNK_SIZE (64 * 1024)
+
+enum region_kind
+{
+   REGION_SPARSE = 0,
+   REGION_TILES,
+   REGION_SAMPLES,
+   REGION_REGS
+};
+
+struct region
+{
+   enum region_kind kind;
+   size_t size;
+};
+
+struct profile
+{
+   const char *name;
+   struct region regions[6];
+};
+
+struct codec
+{
+   const char *name;
+   const struct trans_stream_backend *backend;
+   int level;
+   bool dict;
+};
+
+static const struct profile profiles[] = {
+   { "8-bit", {
+      { REGION_SPARSE,   2 * 1024 },
+      { REGION_TILES,    2 * 1024 },
+      { REGION_SPARSE,   8 * 1024 },
+      { REGION_REGS,          512 } } },
+   { "16-bit", {
+      { REGION_SPARSE, 128 * 1024 },
+      { REGION_TILES,   64 * 1024 },
+      { REGION_SAMPLES, 64 * 1024 },
+      { REGION_SPARSE,   8 * 1024 },
+      { REGION_REGS,     2 * 1024 } } },
+   { "32-bit", {
+      { REGION_SPARSE, 2048 * 1024 },
+      { REGION_TILES,  1024 * 1024 },
+      { REGION_SAMPLES, 512 * 1024 },
+      { REGION_REGS,      8 * 1024 } } },
+};
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static uint64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void fill_region(uint8_t *p, const struct region *r)
+{
+   size_t i;
+
+   switch (r->kind)
+   {
+      case REGION_SPARSE:
+         /* Mostly cleared, with runs of small values and some pointers */
+         memset(p, 0, r->size);
+         for (i = 0; i < r->size; i += 1 + rng() % 24)
+         {
+            size_t run = 1 + rng() % 16;
+            while (run-- && i < r->size)
+               p[i++] = (uint8_t)(rng() % 5 ? rng() & 0x1F : rng());
+         }
+         break;
+      case REGION_TILES:
+         {
+            /* Tiles drawn from a small set, with a few unique ones */
+            uint8_t tiles[64][32];
+            for (i = 0; i < sizeof(tiles); i++)
+               ((uint8_t*)tiles)[i] = (uint8_t)(rng() & (rng() & 1 ? 0x11 : 0xFF));
+            for (i = 0; i + 32 <= r->size; i += 32)
+            {
+               if (rng() % 8)
+                  memcpy(p + i, tiles[rng() % 64], 32);
+               else
+               {
+                  size_t j;
+                  for (j = 0; j < 32; j++)
+                     p[i + j] = (uint8_t)rng();
+               }
+            }
+         }
+         break;
+      case REGION_SAMPLES:
+         {
+            /* 16-bit audio: a couple of tones and some noise */
+            double phase = 0.0;
+            for (i = 0; i + 2 <= r->size; i += 2)
+            {
+               int16_t s = (int16_t)(6000.0 * sin(phase)
+                     + 2000.0 * sin(phase * 3.01) + (int)(rng() % 64) - 32);
+               p[i]      = (uint8_t)s;
+               p[i + 1]  = (uint8_t)(s >> 8);
+               phase    += 0.05;
+            }
+         }
+         break;
+      case REGION_REGS:
+         for (i = 0; i < r->size; i++)
+            p[i] = (uint8_t)rng();
+         break;
+   }
+}
+
+static size_t profile_size(const struct profile *prof)
+{
+   size_t i, len = 0;
+   for (i = 0; i < 6 && prof->regions[i].size; i++)
+      len += prof->regions[i].size;
+   return len;
+}
+
+static void profile_fill(const struct profile *prof, uint8_t *state)
+{
+   size_t i;
+   for (i = 0; i < 6 && prof->regions[i].size; i++)
+   {
+      fill_region(state, &prof->regions[i]);
+      state += prof->regions[i].size;
+   }
+}
+
+/* Play on for a while: a few percent of the bytes change */
+static void profile_advance(uint8_t *state, size_t len)
+{
+   size_t n = len / 40;
+   while (n--)
+   {
+      size_t at = rng() % len;
+      state[at] = (uint8_t)(state[at] + 1 + rng() % 3);
+   }
+}
+
+static bool transcode(const struct trans_stream_backend *backend,
+      void *stream, const uint8_t *in, size_t in_size,
+      uint8_t *out, size_t out_size, size_t chunk, size_t *written)
+{
+   size_t done_in  = 0;
+   size_t done_out = 0;
+
+   /* Feed and drain in pieces, the way a streaming transfer would */
+   for (;;)
+   {
+      uint32_t rd, wn;
+      enum trans_stream_error err;
+      size_t in_now  = in_size  - done_in  < chunk ? in_size  - done_in  : chunk;
+      size_t out_now = out_size - done_out < chunk ? out_size - done_out : chunk;
+      bool last      = done_in + in_now == in_size;
+      bool ok;
+
+      backend->set_in(stream, in + done_in, (uint32_t)in_now);
+      backend->set_out(stream, out + done_out, (uint32_t)out_now);
+      ok        = backend->trans(stream, last, &rd, &wn, &err);
+      done_in  += rd;
+      done_out += wn;
+
+      if (!ok && err != TRANS_STREAM_ERROR_BUFFER_FULL)
+         return false;
+      if (last && err == TRANS_STREAM_ERROR_NONE && done_in == in_size)
+         break;
+      if (!rd && !wn && done_out == out_size)
+         return false;
+   }
+
+   *written = done_out;
+   return true;
+}
+
+static void bench(const struct codec *codec, uint8_t **states,
+      size_t count, size_t len)
+{
+   size_t i;
+   size_t total_in  = 0;
+   size_t total_out = 0;
+   uint64_t c_usec  = 0;
+   uint64_t d_usec  = 0;
+   size_t first     = codec->dict ? 1 : 0;
+   size_t zlen      = len * 2 + 1024;
+   uint8_t *zbuf    = (uint8_t*)malloc(zlen);
+   uint8_t *out     = (uint8_t*)malloc(len);
+   void *cstream    = codec->backend->stream_new();
+   void *dstream    = codec->backend->reverse->stream_new();
+   bool streaming   = codec->backend == trans_stream_get_zstd_compress_backend();
+
+   if (codec->level >= 0)
+      codec->backend->define(cstream, "level", (uint32_t)codec->level);
+   if (codec->dict)
+   {
+      /* The window has to reach back across the whole dictionary */
+      uint32_t window_log = 10;
+      while (window_log < 27 && ((size_t)1 << window_log) < len * 2)
+         window_log++;
+      codec->backend->define(cstream, "window_log", window_log);
+      codec->backend->define(cstream, "long_distance", 1);
+      trans_stream_zstd_set_dictionary(cstream, states[0], len);
+      trans_stream_zstd_set_dictionary(dstream, states[0], len);
+   }
+
+   for (i = first; i < count; i++)
+   {
+      size_t wn, dn;
+      uint64_t t0 = bench_usec();
+
+      /* As netplay_send_savestate does it: one call into a big buffer */
+      if (!transcode(codec->backend, cstream, states[i], len,
+               zbuf, zlen, zlen, &wn))
+      {
+         printf("%-12s compression failed\n", codec->name);
+         goto end;
+      }
+      c_usec += bench_usec() - t0;
+
+      t0 = bench_usec();
+      if (     !transcode(codec->backend->reverse, dstream, zbuf, wn,
+                  out, len, streaming ? CHUNK_SIZE : zlen, &dn)
+            || dn != len || memcmp(out, states[i], len))
+      {
+         printf("%-12s round trip FAILED\n", codec->name);
+         goto end;
+      }
+      d_usec += bench_usec() - t0;
+
+      total_in  += len;
+      total_out += wn;
+   }
+
+   if (total_in)
+      printf("%-12s %9.1f KiB  ratio %6.2f  compress %8.3f ms  "
+            "decompress %7.3f ms\n",
+            codec->name, (double)total_out / (count - first) / 1024.0,
+            (double)total_in / total_out,
+            c_usec / 1000.0 / (count - first),
+            d_usec / 1000.0 / (count - first));
+
+end:
+   codec->backend->stream_free(cstream);
+   codec->backend->reverse->stream_free(dstream);
+   free(zbuf);
+   free(out);
+}
+
+static void bench_all(const char *name, uint8_t **states, size_t count,
+      size_t len)
+{
+   size_t i;
+   struct codec codecs[] = {
+      { "none",         trans_stream_get_pipe_backend(),            -1, false },
+      { "zlib 9",       trans_stream_get_zlib_deflate_backend(),     9, false },
+      { "zlib 6",       trans_stream_get_zlib_deflate_backend(),     6, false },
+      { "zlib 1",       trans_stream_get_zlib_deflate_backend(),     1, false },
+      { "zstd 1",       trans_stream_get_zstd_compress_backend(),    1, false },
+      { "zstd 3",       trans_stream_get_zstd_compress_backend(),    3, false },
+      { "zstd 9",       trans_stream_get_zstd_compress_backend(),    9, false },
+      { "zstd 1 dict",  trans_stream_get_zstd_compress_backend(),    1, true  },
+      { "zstd 3 dict",  trans_stream_get_zstd_compress_backend(),    3, true  },
+   };
+
+   printf("\n%s: %u states of %.1f KiB (averages per state)\n", name,
+         (unsigned)count, len / 1024.0);
+
+   for (i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++)
+   {
+      if (codecs[i].dict && count < 2)
+         continue;
+      bench(&codecs[i], states, count, len);
+   }
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+   long size;
+   uint8_t *data = NULL;
+   FILE *f       = fopen(path, "rb");
+
+   if (!f)
+      return NULL;
+   if (     !fseek(f, 0, SEEK_END)
+         && (size = ftell(f)) > 0
+         && !fseek(f, 0, SEEK_SET)
+         && (data = (uint8_t*)malloc((size_t)size)))
+   {
+      if (fread(data, 1, (size_t)size, f) != (size_t)size)
+      {
+         free(data);
+         data = NULL;
+      }
+      else
+         *len = (size_t)size;
+   }
+   fclose(f);
+   return data;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i, j;
+   size_t count = 8;
+   int arg      = 1;
+
+   if (arg + 1 < argc && !strcmp(argv[arg], "-n"))
+   {
+      count = strtoul(argv[arg + 1], NULL, 0);
+      arg  += 2;
+   }
+   if (count < 1)
+      count = 1;
+
+   if (arg < argc)
+   {
+      /* States of different sizes can't share the dictionary rows, so
+       * only the ones the size of the first are used */
+      size_t len = 0;
+      size_t n   = 0;
+      uint8_t **states = (uint8_t**)calloc(argc - arg, sizeof(*states));
+
+      for (; arg < argc; arg++)
+      {
+         size_t flen   = 0;
+         uint8_t *data = read_file(argv[arg], &flen);
+         if (!data || (n && flen != len))
+         {
+            fprintf(stderr, "Skipping %s\n", argv[arg]);
+            free(data);
+            continue;
+         }
+         len         = flen;
+         states[n++] = data;
+      }
+      if (n)
+         bench_all("Files", states, n, len);
+      for (i = 0; i < n; i++)
+         free(states[i]);
+      free(states);
+      return n ? 0 : 1;
+   }
+
+   for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+   {
+      size_t len       = profile_size(&profiles[i]);
+      uint8_t **states = (uint8_t**)malloc(count * sizeof(*states));
+
+      for (j = 0; j < count; j++)
+      {
+         states[j] = (uint8_t*)malloc(len);
+         if (j)
+         {
+            memcpy(states[j], states[j - 1], len);
+            profile_advance(states[j], len);
+         }
+         else
+            profile_fill(&profiles[i], states[j]);
+      }
+
+      bench_all(profiles[i].name, states, count, len);
+
+      for (j = 0; j < count; j++)
+         free(states[j]);
+      free(states);
+   }
+
+   return 0;
+}
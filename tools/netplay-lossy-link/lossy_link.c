@@ -0,0 +1,462 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Simulates one direction of a builtin netplay input exchange over a lossy
+ * link and compares how late input frames become usable with TCP alone and
+ * with the UDP fast path (network/netplay/netplay_udp.c) added on top.
+ *
+ * The sender produces one input frame every 1/60 s. Over TCP each frame is
+ * one segment: segments are delivered in order, a lost one is resent after
+ * three duplicate acks or the retransmission timeout (minimum 200 ms,
+ * doubling on each further loss), and everything behind it waits. With the
+ * fast path every frame also goes out as a datagram repeating all frames the
+ * receiver has not acknowledged, and the receiver acknowledges with a
+ * datagram of its own every frame. Both directions share the loss model;
+ * TCP acks are assumed not to be lost.
+ *
+ * For every frame of the receiver the harness counts how far the remote
+ * input lags (a stall if it reaches the threshold) and, whenever late input
+ * arrives, how many frames have to be replayed (the rewind depth).
+ *
+ * Usage: lossy_link [-r rtt ms] [-j jitter ms] [-l loss] [-b burst ms]
+ *                   [-t seconds] [-s stall frames] [-S seed] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../../network/netplay/netplay_udp.h"
+
+#define FRAME_MS     (1000.0 / 60.0)
+#define TCP_MIN_RTO  200.0
+#define MAX_IN_FLIGHT 4096
+
+typedef struct
+{
+   double start;
+   double end;
+} burst_t;
+
+/* Loss of one direction of the link. With bursts the link alternates
+ * between good and bad periods and drops everything while bad; without,
+ * every packet is lost independently. */
+typedef struct
+{
+   burst_t *bursts;
+   size_t count;
+   double loss;
+} link_t;
+
+typedef struct
+{
+   uint8_t data[NETPLAY_UDP_MAX_PACKET];
+   double arrival;
+   size_t len;
+} datagram_t;
+
+typedef struct
+{
+   unsigned *depths;
+   unsigned rewinds;
+   unsigned stalls;
+   unsigned max_lag;
+} result_t;
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static double rng_uniform(void)
+{
+   /* xorshift64* */
+   rng_state ^= rng_state >> 12;
+   rng_state ^= rng_state << 25;
+   rng_state ^= rng_state >> 27;
+   return (double)((rng_state * 0x2545F4914F6CDD1DULL) >> 11)
+      / (double)(1ULL << 53);
+}
+
+static double rng_exp(double mean)
+{
+   return -mean * log1p(-rng_uniform());
+}
+
+static void link_init(link_t *link, double loss, double burst_ms,
+      double duration)
+{
+   double t = 0.0;
+   size_t cap = 0;
+
+   link->bursts = NULL;
+   link->count  = 0;
+   link->loss   = loss;
+
+   if (burst_ms <= 0.0 || loss <= 0.0)
+      return;
+
+   /* Good periods long enough that 'loss' of the time is spent bad */
+   while (t < duration)
+   {
+      t += rng_exp(burst_ms * (1.0 - loss) / loss);
+      if (link->count == cap)
+      {
+         cap          = cap ? cap * 2 : 64;
+         link->bursts = (burst_t*)realloc(link->bursts, cap * sizeof(burst_t));
+      }
+      link->bursts[link->count].start = t;
+      t += rng_exp(burst_ms);
+      link->bursts[link->count].end   = t;
+      link->count++;
+   }
+}
+
+static bool link_lost(const link_t *link, double t)
+{
+   size_t lo = 0, hi = link->count;
+
+   if (!link->bursts)
+      return rng_uniform() < link->loss;
+
+   while (lo < hi)
+   {
+      size_t mid = (lo + hi) / 2;
+      if (link->bursts[mid].end <= t)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo < link->count && link->bursts[lo].start <= t;
+}
+
+static double link_delay(double rtt, double jitter)
+{
+   return rtt / 2.0 + rng_uniform() * jitter;
+}
+
+/* When each TCP segment reaches the receiver, ignoring ordering */
+static void tcp_arrivals(const link_t *link, double *arrival,
+      unsigned frames, double rtt, double jitter)
+{
+   unsigned i;
+   double rto = rtt + 4.0 * jitter;
+
+   if (rto < TCP_MIN_RTO)
+      rto = TCP_MIN_RTO;
+
+   for (i = 0; i < frames; i++)
+   {
+      double sent = i * FRAME_MS;
+      arrival[i]  = link_lost(link, sent) ? -1.0
+         : sent + link_delay(rtt, jitter);
+   }
+
+   for (i = 0; i < frames; i++)
+   {
+      double sent, timeout;
+      unsigned later = 0, j;
+
+      if (arrival[i] >= 0.0)
+         continue;
+
+      /* The third segment after it to get through triggers a fast
+       * retransmit, unless the timer fires first */
+      sent    = i * FRAME_MS;
+      timeout = rto;
+      for (j = i + 1; j < frames && later < 3; j++)
+         if (arrival[j] >= 0.0 && ++later == 3)
+            break;
+      if (later == 3 && arrival[j] + rtt / 2.0 < sent + timeout)
+         sent = arrival[j] + rtt / 2.0;
+      else
+         sent += timeout;
+
+      while (link_lost(link, sent))
+      {
+         timeout *= 2.0;
+         sent    += timeout;
+      }
+      arrival[i] = sent + link_delay(rtt, jitter);
+   }
+
+   /* In order delivery */
+   for (i = 1; i < frames; i++)
+      if (arrival[i] < arrival[i - 1])
+         arrival[i] = arrival[i - 1];
+}
+
+static int compare_unsigned(const void *a, const void *b)
+{
+   unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+   return (x > y) - (x < y);
+}
+
+/* Runs the receiver against the usable time of every frame */
+static void measure(const double *usable, unsigned frames,
+      unsigned stall_frames, result_t *res)
+{
+   unsigned frame;
+   unsigned next = 0;
+
+   memset(res, 0, sizeof(*res));
+   res->depths = (unsigned*)calloc(frames, sizeof(unsigned));
+
+   for (frame = 1; frame < frames; frame++)
+   {
+      double now     = frame * FRAME_MS;
+      unsigned first = next;
+      unsigned lag;
+
+      while (next < frames && usable[next] <= now)
+         next++;
+
+      /* Input for frames we already ran on a guess */
+      if (next > first && frame > first)
+         res->depths[res->rewinds++] = frame - first;
+
+      lag = frame > next ? frame - next : 0;
+      if (lag > res->max_lag)
+         res->max_lag = lag;
+      if (lag >= stall_frames)
+         res->stalls++;
+   }
+
+   qsort(res->depths, res->rewinds, sizeof(unsigned), compare_unsigned);
+}
+
+static void report(const char *name, const result_t *res, unsigned frames)
+{
+   unsigned i;
+   double avg = 0.0;
+
+   for (i = 0; i < res->rewinds; i++)
+      avg += res->depths[i];
+   if (res->rewinds)
+      avg /= res->rewinds;
+
+   printf("%-9s stalled %6u (%5.2f%%)  max lag %3u  rewinds %6u  "
+         "depth avg %5.2f p99 %3u max %3u\n",
+         name, res->stalls, 100.0 * res->stalls / frames, res->max_lag,
+         res->rewinds, avg,
+         res->rewinds ? res->depths[(res->rewinds - 1) * 99 / 100] : 0,
+         res->rewinds ? res->depths[res->rewinds - 1] : 0);
+}
+
+/* Replays the datagram exchange on top of the TCP delivery times */
+static void simulate_udp(const link_t *fwd, const link_t *back,
+      const double *tcp, double *usable, unsigned frames,
+      double rtt, double jitter, unsigned *sent_bytes)
+{
+   static datagram_t to_recv[MAX_IN_FLIGHT];
+   static datagram_t to_send[MAX_IN_FLIGHT];
+   netplay_udp_window_t send_window, ack_window;
+   size_t n_recv = 0, n_send = 0;
+   uint32_t acked = 0;
+   uint32_t read  = 0;
+   unsigned tcp_next = 0;
+   unsigned frame;
+
+   netplay_udp_window_reset(&send_window, 0, 0);
+   netplay_udp_window_reset(&ack_window, 0, 0);
+   *sent_bytes = 0;
+
+   for (frame = 0; frame < frames; frame++)
+      usable[frame] = -1.0;
+
+   for (frame = 0; frame < frames + 600; frame++)
+   {
+      double now = frame * FRAME_MS;
+      double end = now + FRAME_MS;
+      size_t i;
+
+      if (frame < frames)
+      {
+         uint32_t input = frame * 2654435761u;
+         datagram_t *dgram;
+
+         netplay_udp_window_push(&send_window, frame, 1, 1, &input);
+         if (n_recv < MAX_IN_FLIGHT)
+         {
+            dgram      = &to_recv[n_recv];
+            dgram->len = netplay_udp_encode(&send_window, acked, 1, 0, 1,
+                  dgram->data, sizeof(dgram->data));
+            *sent_bytes += dgram->len;
+            if (!link_lost(fwd, now))
+            {
+               dgram->arrival = now + link_delay(rtt, jitter);
+               n_recv++;
+            }
+         }
+      }
+
+      /* Receiver side: TCP and datagrams, in time order within the frame */
+      for (;;)
+      {
+         double best = end;
+         size_t best_i = n_recv;
+
+         for (i = 0; i < n_recv; i++)
+            if (to_recv[i].arrival < best)
+            {
+               best   = to_recv[i].arrival;
+               best_i = i;
+            }
+         if (tcp_next < frames && tcp[tcp_next] < best)
+         {
+            if (read <= tcp_next)
+            {
+               for (; read <= tcp_next; read++)
+                  usable[read] = tcp[tcp_next];
+            }
+            tcp_next++;
+            continue;
+         }
+         if (best_i == n_recv)
+            break;
+
+         {
+            netplay_udp_packet_t pkt;
+            if (netplay_udp_decode(to_recv[best_i].data,
+                     to_recv[best_i].len, &pkt))
+            {
+               for (i = 0; i < pkt.count; i++)
+               {
+                  uint32_t f = pkt.first_frame + (uint32_t)i;
+                  if ((int32_t)(f - read) < 0)
+                     continue;
+                  if (f != read)
+                     break;
+                  usable[read++] = best;
+               }
+            }
+         }
+         to_recv[best_i] = to_recv[--n_recv];
+      }
+
+      /* Receiver acknowledges once per frame */
+      if (n_send < MAX_IN_FLIGHT && !link_lost(back, now))
+      {
+         datagram_t *dgram = &to_send[n_send++];
+         dgram->len     = netplay_udp_encode(&ack_window, 0, 1, read, 0,
+               dgram->data, sizeof(dgram->data));
+         dgram->arrival = now + link_delay(rtt, jitter);
+      }
+
+      for (i = 0; i < n_send; )
+      {
+         netplay_udp_packet_t pkt;
+         if (to_send[i].arrival >= end)
+         {
+            i++;
+            continue;
+         }
+         if (     netplay_udp_decode(to_send[i].data, to_send[i].len, &pkt)
+               && (int32_t)(pkt.ack - acked) > 0)
+            acked = pkt.ack;
+         to_send[i] = to_send[--n_send];
+      }
+   }
+
+   for (frame = 0; frame < frames; frame++)
+      if (usable[frame] < 0.0)
+         usable[frame] = tcp[frame];
+}
+
+static void usage(const char *argv0)
+{
+   fprintf(stderr,
+         "Usage: %s [-r rtt ms] [-j jitter ms] [-l loss] [-b burst ms]\n"
+         "          [-t seconds] [-s stall frames] [-S seed]\n"
+         "  -r  Round trip time (default 80)\n"
+         "  -j  Extra one way delay, uniformly up to this (default 10)\n"
+         "  -l  Fraction of packets lost (default 0.02)\n"
+         "  -b  Mean length of a loss burst, 0 for independent loss (default 0)\n"
+         "  -t  Simulated time (default 600)\n"
+         "  -s  Lag in frames that counts as a stall (default 8)\n"
+         "  -S  Random seed\n", argv0);
+}
+
+int main(int argc, char *argv[])
+{
+   double rtt          = 80.0;
+   double jitter       = 10.0;
+   double loss         = 0.02;
+   double burst        = 0.0;
+   double seconds      = 600.0;
+   unsigned stall      = 8;
+   unsigned frames, sent_bytes;
+   double *tcp, *usable;
+   link_t fwd, back;
+   result_t tcp_res, udp_res;
+   int i;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (i + 1 >= argc)
+      {
+         usage(argv[0]);
+         return 1;
+      }
+      if (!strcmp(argv[i], "-r"))
+         rtt       = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-j"))
+         jitter    = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-l"))
+         loss      = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-b"))
+         burst     = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-t"))
+         seconds   = atof(argv[++i]);
+      else if (!strcmp(argv[i], "-s"))
+         stall     = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-S"))
+         rng_state = strtoull(argv[++i], NULL, 0) | 1;
+      else
+      {
+         usage(argv[0]);
+         return 1;
+      }
+   }
+
+   if (loss < 0.0 || loss >= 1.0 || seconds <= 0.0)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+
+   frames = (unsigned)(seconds * 60.0);
+   tcp    = (double*)malloc(frames * sizeof(double));
+   usable = (double*)malloc(frames * sizeof(double));
+   link_init(&fwd,  loss, burst, (frames + 600) * FRAME_MS);
+   link_init(&back, loss, burst, (frames + 600) * FRAME_MS);
+
+   tcp_arrivals(&fwd, tcp, frames, rtt, jitter);
+   simulate_udp(&fwd, &back, tcp, usable, frames, rtt, jitter, &sent_bytes);
+
+   printf("rtt %.0f ms  jitter %.0f ms  loss %.1f%%  burst %.0f ms  "
+         "%u frames  stall at %u\n",
+         rtt, jitter, loss * 100.0, burst, frames, stall);
+
+   measure(tcp, frames, stall, &tcp_res);
+   measure(usable, frames, stall, &udp_res);
+   report("TCP only", &tcp_res, frames);
+   report("TCP+UDP", &udp_res, frames);
+   printf("UDP overhead %.1f bytes per frame\n", (double)sent_bytes / frames);
+
+   free(tcp_res.depths);
+   free(udp_res.depths);
+   free(tcp);
+   free(usable);
+   free(fwd.bursts);
+   free(back.bursts);
+   return 0;
+}
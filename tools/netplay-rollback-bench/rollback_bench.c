@@ -0,0 +1,325 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Drives the GekkoNet event queue with a synthetic rollback stream and an
+ * artificially slow core, once resimulating every rollback at once and
+ * once spreading it with the frame budget, and reports how the per host
+ * frame work compares to the frame period.
+ *
+ * A new frame is queued every host frame, as GekkoNet keeps advancing
+ * while a rollback is spread. Every host frame must present a frame, and
+ * the replay must catch up within the spread window.
+ *
+ * Usage: rollback_bench [frame cost usec] [rollback depth] [rollback interval] [spread] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../network/netplay/netplay_gekkonet.h"
+
+#define BENCH_FRAMES       3000
+#define BENCH_PERIOD_USEC  16667
+#define BENCH_SLOTS        64
+
+typedef struct bench_state
+{
+   uint32_t frame;
+   uint32_t acc;
+} bench_state_t;
+
+static bench_state_t core_state;
+static unsigned      core_cost_usec;
+
+static unsigned char slot_state[BENCH_SLOTS][sizeof(bench_state_t)];
+static unsigned int  slot_len[BENCH_SLOTS];
+static unsigned int  slot_crc[BENCH_SLOTS];
+
+static ra_gekkonet_ctx_t    ctx;
+static ra_gekkonet_budget_t budget;
+static bool                 presented;
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t bench_true_input(uint32_t frame)
+{
+   return frame * 7 + 3;
+}
+
+/* The slow core: burn the configured time, then fold in this frame's input. */
+static void bench_core_run(void)
+{
+   int64_t end = bench_usec() + core_cost_usec;
+   uint32_t in;
+
+   while (bench_usec() < end);
+
+   memcpy(&in, ra_gekkonet_get_current_input(&ctx), sizeof(in));
+   core_state.acc = core_state.acc * 31 + in;
+   core_state.frame++;
+}
+
+static bool bench_save(void *dst, unsigned int cap,
+      unsigned int *out_size, unsigned int *out_crc)
+{
+   if (cap < sizeof(core_state))
+      return false;
+   memcpy(dst, &core_state, sizeof(core_state));
+   *out_size = sizeof(core_state);
+   *out_crc  = core_state.acc;
+   return true;
+}
+
+static bool bench_load(const void *src, unsigned int size)
+{
+   if (size != sizeof(core_state))
+      return false;
+   memcpy(&core_state, src, sizeof(core_state));
+   return true;
+}
+
+static void bench_run_frame(void)
+{
+   presented = true;
+}
+
+static void bench_resim_frame(void)
+{
+   int64_t start = bench_usec();
+   bench_core_run();
+   ra_gekkonet_budget_record(&budget, bench_usec() - start, true);
+}
+
+static void bench_push_advance(GekkoGameEvent *ev, int frame,
+      uint32_t *input, bool rolling_back)
+{
+   ev->type                 = AdvanceEvent;
+   ev->data.adv.frame        = frame;
+   ev->data.adv.input_len    = sizeof(*input);
+   ev->data.adv.inputs       = (unsigned char*)input;
+   ev->data.adv.rolling_back = rolling_back;
+}
+
+static void bench_push_save(GekkoGameEvent *ev, int frame)
+{
+   unsigned slot         = (unsigned)frame % BENCH_SLOTS;
+   slot_len[slot]        = sizeof(slot_state[slot]);
+   ev->type              = SaveEvent;
+   ev->data.save.frame     = frame;
+   ev->data.save.state     = slot_state[slot];
+   ev->data.save.state_len = &slot_len[slot];
+   ev->data.save.checksum  = &slot_crc[slot];
+}
+
+/* Builds the batch GekkoNet would emit for 'frame': a plain advance, or,
+ * every 'interval' frames, a rollback over the last 'depth' frames whose
+ * inputs were mispredicted. Returns the number of events. */
+static int bench_build_batch(GekkoGameEvent *evs, GekkoGameEvent **ptrs,
+      uint32_t *inputs, int frame, unsigned depth, unsigned interval)
+{
+   int n = 0;
+   int i;
+   bool rollback = frame > (int)depth + 1 && (frame % interval) == 0;
+
+   if (rollback)
+   {
+      int g;
+      int sync = frame - (int)depth - 1;
+
+      evs[n].type                = LoadEvent;
+      evs[n].data.load.frame     = sync;
+      evs[n].data.load.state     = slot_state[(unsigned)sync % BENCH_SLOTS];
+      evs[n].data.load.state_len = slot_len[(unsigned)sync % BENCH_SLOTS];
+      n++;
+
+      for (g = sync + 1; g < frame; g++)
+      {
+         inputs[n] = bench_true_input((uint32_t)g);
+         bench_push_advance(&evs[n], g, &inputs[n], true);
+         n++;
+         bench_push_save(&evs[n++], g);
+      }
+   }
+
+   /* Frames that will be rolled back later are first run on a wrong guess */
+   inputs[n] = bench_true_input((uint32_t)frame);
+   if (((unsigned)frame % interval) >= interval - depth)
+      inputs[n] ^= 0x5a5a;
+   bench_push_advance(&evs[n], frame, &inputs[n], false);
+   n++;
+   bench_push_save(&evs[n++], frame);
+
+   for (i = 0; i < n; i++)
+      ptrs[i] = &evs[i];
+   return n;
+}
+
+static int bench_cmp_i64(const void *a, const void *b)
+{
+   int64_t x = *(const int64_t*)a;
+   int64_t y = *(const int64_t*)b;
+   return (x > y) - (x < y);
+}
+
+static bool bench_run(const char *name, unsigned depth,
+      unsigned interval, unsigned spread)
+{
+   static int64_t  work[BENCH_FRAMES];
+   GekkoGameEvent  evs[256];
+   GekkoGameEvent *ptrs[256];
+   uint32_t        inputs[256];
+   unsigned        host;
+   unsigned        over        = 0;
+   unsigned        held        = 0;
+   unsigned        worst_catch = 0;
+   unsigned        catching    = 0;
+   int             frame       = 0;
+   int64_t         sum         = 0;
+   uint32_t        expect_acc  = 0;
+   uint32_t        f;
+   bool            ok;
+
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&core_state, 0, sizeof(core_state));
+   ctx.input_size        = sizeof(uint32_t);
+   ctx.state_size        = sizeof(bench_state_t);
+   ctx.current_input_buf = calloc(1, ctx.input_size);
+   ctx.save_cb           = bench_save;
+   ctx.load_cb           = bench_load;
+   ctx.run_frame_cb      = bench_run_frame;
+   ctx.resim_frame_cb    = bench_resim_frame;
+   ctx.active            = true;
+   ra_gekkonet_budget_init(&budget, BENCH_PERIOD_USEC, spread);
+
+   for (host = 0; host < BENCH_FRAMES; host++)
+   {
+      int64_t  start = bench_usec();
+      int64_t  events_start;
+      unsigned pending;
+      int      n;
+
+      presented = false;
+      n = bench_build_batch(evs, ptrs, inputs, frame++, depth, interval);
+      ra_gekkonet_queue_events(&ctx, ptrs, n);
+
+      pending = ra_gekkonet_pending_resim(&ctx);
+      if (!ra_gekkonet_is_predicting(&ctx) && pending)
+         ra_gekkonet_budget_begin(&budget);
+      events_start = bench_usec();
+      ra_gekkonet_process_events(&ctx,
+            ra_gekkonet_budget_allow(&budget, pending));
+      ra_gekkonet_budget_record_events(&budget, bench_usec() - events_start);
+
+      if (presented)
+      {
+         int64_t run_start = bench_usec();
+         bench_core_run();
+         ra_gekkonet_budget_record(&budget, bench_usec() - run_start, false);
+      }
+      else
+         held++;
+      ra_gekkonet_flush_events(&ctx);
+
+      if (ra_gekkonet_is_predicting(&ctx))
+      {
+         if (++catching > worst_catch)
+            worst_catch = catching;
+      }
+      else
+         catching = 0;
+
+      work[host] = bench_usec() - start;
+      sum       += work[host];
+      if (work[host] > BENCH_PERIOD_USEC)
+         over++;
+   }
+
+   /* Untimed: run up to the next rollback and finish the queue, so that
+    * every frame ends up simulated on its true input */
+   while (     (frame - 1) % (int)interval
+            || ra_gekkonet_has_pending_events(&ctx)
+            || ra_gekkonet_is_predicting(&ctx))
+   {
+      presented = false;
+      if ((frame - 1) % (int)interval)
+      {
+         int n = bench_build_batch(evs, ptrs, inputs, frame++,
+               depth, interval);
+         ra_gekkonet_queue_events(&ctx, ptrs, n);
+      }
+      ra_gekkonet_process_events(&ctx, UINT32_MAX);
+      if (presented)
+         bench_core_run();
+      ra_gekkonet_flush_events(&ctx);
+   }
+
+   for (f = 0; f < core_state.frame; f++)
+      expect_acc = expect_acc * 31 + bench_true_input(f);
+   ok = core_state.acc == expect_acc
+      && core_state.frame == (uint32_t)frame
+      && !held
+      && worst_catch < (spread > 1 ? spread : 1);
+
+   qsort(work, BENCH_FRAMES, sizeof(work[0]), bench_cmp_i64);
+   printf("%-10s avg %6lld us  p99 %6lld us  max %6lld us  "
+         "over budget %4u  repeated frames %4u  worst catch-up %u  %s\n",
+         name,
+         (long long)(sum / BENCH_FRAMES),
+         (long long)work[BENCH_FRAMES * 99 / 100],
+         (long long)work[BENCH_FRAMES - 1],
+         over, held, worst_catch,
+         ok ? "state ok" : "STATE MISMATCH");
+
+   ra_gekkonet_deinit(&ctx);
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned depth    = 8;
+   unsigned interval = 20;
+   unsigned spread   = 3;
+   bool     ok;
+
+   core_cost_usec = 3000;
+   if (argc > 1)
+      core_cost_usec = (unsigned)strtoul(argv[1], NULL, 0);
+   if (argc > 2)
+      depth          = (unsigned)strtoul(argv[2], NULL, 0);
+   if (argc > 3)
+      interval       = (unsigned)strtoul(argv[3], NULL, 0);
+   if (argc > 4)
+      spread         = (unsigned)strtoul(argv[4], NULL, 0);
+
+   if (!depth || depth + 1 >= interval || depth > 60)
+   {
+      fprintf(stderr, "Rollback depth must be between 1 and min(interval - 2, 60).\n");
+      return 1;
+   }
+
+   printf("core %u us/frame, period %u us, %u frame rollback every %u frames, "
+         "spread over %u frames\n",
+         core_cost_usec, BENCH_PERIOD_USEC, depth, interval, spread);
+
+   ok = bench_run("immediate", depth, interval, 0);
+   ok = bench_run("spread",    depth, interval, spread) && ok;
+
+   return ok ? 0 : 1;
+}
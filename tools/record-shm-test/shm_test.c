@@ -0,0 +1,288 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the shared memory export under concurrent readers.
+ *
+ * The parent publishes frames and audio through record_shm_ring.c the way
+ * the "shm" record driver does, as fast as it can, so slots are reused
+ * while readers are still looking at them. Forked readers attach by name
+ * and verify every pixel and sample they accept against the pattern the
+ * writer used for that frame number or audio position:
+ *
+ *   - "peek" readers check frames in place, then ask whether the slot
+ *     was reused meanwhile and only count the frame if it was not;
+ *   - "copy" readers use record_shm_read_video();
+ *   - "slow" readers sleep between peeking at a frame and checking it,
+ *     so the slot is usually reused under them: they have to notice,
+ *     and they lose frames instead of holding the writer up.
+ *
+ * Any accepted frame or audio sample that does not match is an error.
+ * The writer is timed alone and with the readers attached.
+ *
+ * Usage: shm_test [-n frames] [-r readers] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../../record/record_shm_ring.h"
+
+#define TEST_NAME     "/retroarch-shm-test"
+#define TEST_WIDTH    640
+#define TEST_HEIGHT   480
+#define TEST_CHANNELS 2
+#define TEST_BATCH    800   /* Audio frames per video frame */
+
+enum reader_kind
+{
+   READER_PEEK = 0,
+   READER_COPY,
+   READER_SLOW
+};
+
+static const char *reader_names[] = { "peek", "copy", "slow" };
+
+static uint64_t test_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t test_pixel(uint64_t frame, unsigned x, unsigned y)
+{
+   uint32_t h = (uint32_t)frame * 0x9E3779B1u ^ (x * 0x85EBCA6Bu)
+      ^ (y * 0xC2B2AE35u);
+   h ^= h >> 15;
+   return h;
+}
+
+static int16_t test_sample(uint64_t pos, unsigned channel)
+{
+   return (int16_t)(uint16_t)((pos * 7 + channel * 3) ^ (pos >> 16));
+}
+
+static void fill_frame(uint32_t *frame, uint64_t n)
+{
+   unsigned x, y;
+   for (y = 0; y < TEST_HEIGHT; y++)
+      for (x = 0; x < TEST_WIDTH; x++)
+         frame[y * TEST_WIDTH + x] = test_pixel(n, x, y);
+}
+
+static bool check_frame(const record_shm_frame_t *f)
+{
+   unsigned x, y;
+   const uint8_t *row = (const uint8_t*)f->data;
+
+   if (f->width != TEST_WIDTH || f->height != TEST_HEIGHT)
+      return false;
+
+   for (y = 0; y < TEST_HEIGHT; y++, row += f->pitch)
+   {
+      const uint32_t *px = (const uint32_t*)row;
+      for (x = 0; x < TEST_WIDTH; x++)
+         if (px[x] != test_pixel(f->frame, x, y))
+            return false;
+   }
+   return true;
+}
+
+static int run_reader(enum reader_kind kind, int out_fd)
+{
+   char report[256];
+   record_shm_ring_t ring;
+   record_shm_frame_t f;
+   uint64_t last          = 0;
+   uint64_t seen          = 0;
+   uint64_t skipped       = 0;
+   uint64_t overwritten   = 0;
+   uint64_t bad           = 0;
+   uint64_t audio_pos     = 0;
+   uint64_t audio_frames  = 0;
+   uint64_t audio_dropped = 0;
+   uint64_t audio_bad     = 0;
+   int16_t *audio         = (int16_t*)malloc(4096 * TEST_CHANNELS
+         * sizeof(int16_t));
+   uint32_t *copy         = (uint32_t*)malloc(TEST_WIDTH * TEST_HEIGHT
+         * sizeof(uint32_t));
+
+   while (!record_shm_attach(&ring, TEST_NAME))
+      usleep(1000);
+
+   for (;;)
+   {
+      size_t i, n;
+      int ret;
+
+      if (kind == READER_COPY)
+         ret = record_shm_read_video(&ring, last, &f, copy,
+               TEST_WIDTH * TEST_HEIGHT * sizeof(uint32_t));
+      else
+         ret = record_shm_peek_video(&ring, last, &f);
+
+      if (ret < 0)
+         break;
+
+      if (ret > 0)
+      {
+         bool ok;
+
+         /* Long enough for the writer to come around to this slot */
+         if (kind == READER_SLOW)
+            usleep(5000);
+
+         ok = check_frame(&f);
+
+         if (kind != READER_COPY && !record_shm_frame_valid(&f))
+            overwritten++;
+         else
+         {
+            if (!ok)
+               bad++;
+            seen++;
+            skipped += f.frame - last - 1;
+            last     = f.frame;
+         }
+      }
+      else
+         usleep(200);
+
+      while ((n = record_shm_read_audio(&ring, &audio_pos, audio,
+                  4096, &audio_dropped)) > 0)
+      {
+         uint64_t start = audio_pos - n;
+         for (i = 0; i < n * TEST_CHANNELS; i++)
+            if (audio[i] != test_sample(start + i / TEST_CHANNELS,
+                     i % TEST_CHANNELS))
+               audio_bad++;
+         audio_frames += n;
+      }
+   }
+
+   snprintf(report, sizeof(report),
+         "%-5s frames %6llu  skipped %6llu  overwritten %5llu  bad %llu  "
+         "audio %8llu  dropped %7llu  bad %llu\n",
+         reader_names[kind],
+         (unsigned long long)seen, (unsigned long long)skipped,
+         (unsigned long long)overwritten, (unsigned long long)bad,
+         (unsigned long long)audio_frames,
+         (unsigned long long)audio_dropped,
+         (unsigned long long)audio_bad);
+   if (write(out_fd, report, strlen(report)) < 0)
+      return 1;
+
+   record_shm_detach(&ring);
+   free(audio);
+   free(copy);
+   return (bad || audio_bad) ? 1 : 0;
+}
+
+/* Returns the average time the writer spent per frame */
+static double run_writer(unsigned frames)
+{
+   unsigned i, j;
+   record_shm_ring_t ring;
+   uint64_t start, spent = 0;
+   uint64_t audio_pos    = 0;
+   uint32_t *frame       = (uint32_t*)malloc(TEST_WIDTH * TEST_HEIGHT
+         * sizeof(uint32_t));
+   int16_t audio[TEST_BATCH * TEST_CHANNELS];
+
+   if (!record_shm_create(&ring, TEST_NAME, TEST_WIDTH, TEST_HEIGHT,
+            RECORD_SHM_PIX_XRGB8888, TEST_CHANNELS, 48000, 4096, 60.0))
+   {
+      perror("record_shm_create");
+      exit(1);
+   }
+
+   for (i = 1; i <= frames; i++)
+   {
+      fill_frame(frame, i);
+      for (j = 0; j < TEST_BATCH * TEST_CHANNELS; j++)
+         audio[j] = test_sample(audio_pos + j / TEST_CHANNELS,
+               j % TEST_CHANNELS);
+
+      start = test_usec();
+      record_shm_publish_video(&ring, frame, TEST_WIDTH, TEST_HEIGHT,
+            TEST_WIDTH * sizeof(uint32_t), start);
+      record_shm_publish_audio(&ring, audio, TEST_BATCH, start);
+      spent     += test_usec() - start;
+      audio_pos += TEST_BATCH;
+   }
+
+   record_shm_destroy(&ring);
+   free(frame);
+   return (double)spent / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   int fds[2];
+   double alone, shared;
+   unsigned frames  = 3000;
+   unsigned readers = 6;
+   int failed       = 0;
+
+   for (i = 1; i + 1 < argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-n"))
+         frames  = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-r"))
+         readers = (unsigned)atoi(argv[i + 1]);
+   }
+
+   alone = run_writer(frames);
+
+   if (pipe(fds) < 0)
+      return 1;
+
+   for (i = 0; i < (int)readers; i++)
+   {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+         close(fds[0]);
+         exit(run_reader((enum reader_kind)(i % 3), fds[1]));
+      }
+   }
+   close(fds[1]);
+
+   /* Let the readers attach */
+   usleep(100000);
+   shared = run_writer(frames);
+
+   for (i = 0; i < (int)readers; i++)
+   {
+      int status;
+      if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+         failed = 1;
+   }
+
+   {
+      char buf[4096];
+      ssize_t len;
+      while ((len = read(fds[0], buf, sizeof(buf))) > 0)
+         fwrite(buf, 1, (size_t)len, stdout);
+   }
+
+   printf("\nwriter: %.1f us/frame alone, %.1f us/frame with %u readers\n",
+         alone, shared, readers);
+   printf("%s\n", failed ? "FAILED" : "all accepted frames and samples intact");
+   return failed;
+}
@@ -0,0 +1,153 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless test core for the allocation counter (alloc_counter.h).
+ *
+ * Runs without content and drives every per-frame path of the frontend
+ * the way a typical core does: an XRGB8888 frame, a batch of stereo
+ * audio frames and a poll of the joypad buttons each frame. It never
+ * allocates after retro_init(), so a steady-state allocation reported
+ * while it runs comes from the frontend.
+ *
+ * Usage: make check [FRAMES=n] */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <libretro.h>
+
+#define WIDTH          320
+#define HEIGHT         240
+#define SAMPLE_RATE    48000
+#define AUDIO_FRAMES   (SAMPLE_RATE / 60)
+
+static uint32_t frame_buf[WIDTH * HEIGHT];
+static int16_t audio_buf[AUDIO_FRAMES * 2];
+static unsigned frame_count;
+
+static retro_environment_t environ_cb;
+static retro_video_refresh_t video_cb;
+static retro_audio_sample_batch_t audio_batch_cb;
+static retro_input_poll_t input_poll_cb;
+static retro_input_state_t input_state_cb;
+
+void retro_set_environment(retro_environment_t cb)
+{
+   bool no_content = true;
+   environ_cb      = cb;
+   cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &no_content);
+}
+
+void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
+void retro_set_audio_sample(retro_audio_sample_t cb) { }
+void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) { audio_batch_cb = cb; }
+void retro_set_input_poll(retro_input_poll_t cb) { input_poll_cb = cb; }
+void retro_set_input_state(retro_input_state_t cb) { input_state_cb = cb; }
+
+void retro_init(void) { frame_count = 0; }
+void retro_deinit(void) { }
+
+unsigned retro_api_version(void)
+{
+   return RETRO_API_VERSION;
+}
+
+void retro_get_system_info(struct retro_system_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->library_name     = "Alloc Test";
+   info->library_version  = "1.0";
+   info->valid_extensions = "";
+   info->need_fullpath    = false;
+}
+
+void retro_get_system_av_info(struct retro_system_av_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->geometry.base_width   = WIDTH;
+   info->geometry.base_height  = HEIGHT;
+   info->geometry.max_width    = WIDTH;
+   info->geometry.max_height   = HEIGHT;
+   info->geometry.aspect_ratio = 4.0f / 3.0f;
+   info->timing.fps            = 60.0;
+   info->timing.sample_rate    = SAMPLE_RATE;
+}
+
+void retro_set_controller_port_device(unsigned port, unsigned device) { }
+void retro_reset(void) { frame_count = 0; }
+
+void retro_run(void)
+{
+   unsigned i;
+   unsigned buttons = 0;
+   uint32_t color;
+
+   input_poll_cb();
+   for (i = 0; i < 16; i++)
+      if (input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, i))
+         buttons |= 1 << i;
+
+   /* A moving gradient, so the frame is never a dupe */
+   color = (frame_count * 0x010203u) ^ (buttons << 8);
+   for (i = 0; i < WIDTH * HEIGHT; i++)
+      frame_buf[i] = color + i;
+   video_cb(frame_buf, WIDTH, HEIGHT, WIDTH * sizeof(uint32_t));
+
+   for (i = 0; i < AUDIO_FRAMES; i++)
+   {
+      int16_t s          = (int16_t)(((frame_count * AUDIO_FRAMES + i) & 0xff) << 6);
+      audio_buf[i * 2]     = s;
+      audio_buf[i * 2 + 1] = s;
+   }
+   audio_batch_cb(audio_buf, AUDIO_FRAMES);
+
+   frame_count++;
+}
+
+bool retro_load_game(const struct retro_game_info *game)
+{
+   enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+   return environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt);
+}
+
+bool retro_load_game_special(unsigned type,
+      const struct retro_game_info *info, size_t num)
+{
+   return false;
+}
+
+void retro_unload_game(void) { }
+unsigned retro_get_region(void) { return RETRO_REGION_NTSC; }
+size_t retro_serialize_size(void) { return sizeof(frame_count); }
+
+bool retro_serialize(void *data, size_t size)
+{
+   if (size < sizeof(frame_count))
+      return false;
+   memcpy(data, &frame_count, sizeof(frame_count));
+   return true;
+}
+
+bool retro_unserialize(const void *data, size_t size)
+{
+   if (size < sizeof(frame_count))
+      return false;
+   memcpy(&frame_count, data, sizeof(frame_count));
+   return true;
+}
+
+void retro_cheat_reset(void) { }
+void retro_cheat_set(unsigned index, bool enabled, const char *code) { }
+void *retro_get_memory_data(unsigned id) { return NULL; }
+size_t retro_get_memory_size(unsigned id) { return 0; }
@@ -0,0 +1,494 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times reading runtime info for every entry of a large playlist.
+ *
+ * A runtime log directory is filled with per core .lrtl files, the way
+ * runtime_file.c used to write them, for most entries of a synthetic
+ * playlist. Reading runtime info for all entries is timed the old way,
+ * checking the directory and parsing one JSON file per entry, and
+ * through runtime_db.c: importing the files into a database once,
+ * opening the database and looking up every entry.
+ *
+ * All looked up entries must match the log files. Sessions saved
+ * through the journal must survive reopening, a line cut short at the
+ * end of the journal must be dropped without losing earlier ones, and
+ * saving the same few entries over and over must not grow the journal
+ * without bound.
+ *
+ * Usage: runtime_db_bench [-n entries] [-c cores] [-d dir] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <formats/rjson.h>
+#include <lists/dir_list.h>
+#include <lists/string_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "../../runtime_db.h"
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void random_entry(runtime_db_entry_t *entry)
+{
+   entry->runtime_hours      = rng() % 200;
+   entry->runtime_minutes    = rng() % 60;
+   entry->runtime_seconds    = rng() % 60;
+   entry->last_played_year   = 2015 + rng() % 10;
+   entry->last_played_month  = 1 + rng() % 12;
+   entry->last_played_day    = 1 + rng() % 28;
+   entry->last_played_hour   = rng() % 24;
+   entry->last_played_minute = rng() % 60;
+   entry->last_played_second = rng() % 60;
+   entry->play_count         = rng() % 500;
+   entry->state_slot         = rng() % 10;
+}
+
+/* Same layout as the JSON runtime_log_save() used to write */
+static bool write_legacy(const char *path, const runtime_db_entry_t *entry)
+{
+   RFILE *file = filestream_open(path, RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   filestream_printf(file,
+         "{\n"
+         "  \"version\": \"1.0\",\n"
+         "  \"runtime\": \"%u:%02u:%02u\",\n"
+         "  \"last_played\": \"%04u-%02u-%02u %02u:%02u:%02u\",\n"
+         "  \"play_count\": \"%u\",\n"
+         "  \"state_slot\": \"%u\"\n"
+         "}\n",
+         entry->runtime_hours, entry->runtime_minutes, entry->runtime_seconds,
+         entry->last_played_year, entry->last_played_month,
+         entry->last_played_day, entry->last_played_hour,
+         entry->last_played_minute, entry->last_played_second,
+         entry->play_count, entry->state_slot);
+
+   return filestream_close(file) == 0;
+}
+
+typedef struct
+{
+   char **current;
+   char *values[4];
+} legacy_ctx_t;
+
+static bool legacy_member(void *ctx, const char *s, size_t len)
+{
+   static const char *names[4] = {
+      "runtime", "last_played", "play_count", "state_slot" };
+   legacy_ctx_t *p_ctx = (legacy_ctx_t*)ctx;
+   unsigned i;
+
+   for (i = 0; i < 4; i++)
+      if (string_is_equal(s, names[i]))
+         p_ctx->current = &p_ctx->values[i];
+   return true;
+}
+
+static bool legacy_string(void *ctx, const char *s, size_t len)
+{
+   legacy_ctx_t *p_ctx = (legacy_ctx_t*)ctx;
+   if (p_ctx->current && len)
+   {
+      free(*p_ctx->current);
+      *p_ctx->current = strdup(s);
+   }
+   p_ctx->current = NULL;
+   return true;
+}
+
+/* What runtime_log_init() used to do per entry */
+static bool read_legacy(const char *dir, const char *path,
+      runtime_db_entry_t *entry)
+{
+   legacy_ctx_t ctx = {0};
+   bool ret         = false;
+   unsigned i;
+   rjson_t *parser;
+   RFILE *file;
+
+   if (!path_is_directory(dir) || !path_is_valid(path))
+      return false;
+
+   if (!(file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   if ((parser = rjson_open_rfile(file)))
+   {
+      rjson_parse(parser, &ctx, legacy_member, legacy_string,
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+      rjson_free(parser);
+   }
+   filestream_close(file);
+
+   memset(entry, 0, sizeof(*entry));
+   if (     ctx.values[0] && ctx.values[1] && ctx.values[2] && ctx.values[3]
+         && sscanf(ctx.values[0], "%u:%02u:%02u",
+            &entry->runtime_hours, &entry->runtime_minutes,
+            &entry->runtime_seconds) == 3
+         && sscanf(ctx.values[1], "%04u-%02u-%02u %02u:%02u:%02u",
+            &entry->last_played_year, &entry->last_played_month,
+            &entry->last_played_day, &entry->last_played_hour,
+            &entry->last_played_minute, &entry->last_played_second) == 6
+         && sscanf(ctx.values[2], "%u", &entry->play_count) == 1
+         && sscanf(ctx.values[3], "%04u", &entry->state_slot) == 1)
+      ret = true;
+
+   for (i = 0; i < 4; i++)
+      free(ctx.values[i]);
+   return ret;
+}
+
+/* Same walk as runtime_log_import() */
+static size_t import_dir(runtime_db_t *db, const char *dir,
+      const char *core_name)
+{
+   size_t i, count           = 0;
+   struct string_list *files = dir_list_new(dir, "lrtl",
+         false, false, false, false);
+
+   if (!files)
+      return 0;
+
+   for (i = 0; i < files->size; i++)
+   {
+      char key[PATH_MAX_LENGTH];
+      runtime_db_entry_t entry;
+
+      if (!read_legacy(dir, files->elems[i].data, &entry))
+         continue;
+      if (core_name)
+         snprintf(key, sizeof(key), "%s/%s", core_name,
+               path_basename(files->elems[i].data));
+      else
+         strlcpy(key, path_basename(files->elems[i].data), sizeof(key));
+      runtime_db_set(db, key, &entry);
+      count++;
+   }
+
+   string_list_free(files);
+   return count;
+}
+
+static size_t import_all(runtime_db_t *db, const char *dir)
+{
+   size_t i, count          = 0;
+   struct string_list *dirs = dir_list_new(dir, "lrtl",
+         true, false, false, false);
+
+   if (!dirs)
+      return 0;
+   for (i = 0; i < dirs->size; i++)
+      if (dirs->elems[i].attr.i == RARCH_DIRECTORY)
+         count += import_dir(db, dirs->elems[i].data,
+               path_basename(dirs->elems[i].data));
+   count += import_dir(db, dir, NULL);
+   string_list_free(dirs);
+
+   if (count)
+      runtime_db_compact(db);
+   return count;
+}
+
+static void remove_tree(const char *dir)
+{
+   size_t i;
+   struct string_list *list = dir_list_new(dir, NULL,
+         true, true, false, false);
+
+   if (list)
+   {
+      for (i = 0; i < list->size; i++)
+      {
+         if (list->elems[i].attr.i == RARCH_DIRECTORY)
+            remove_tree(list->elems[i].data);
+         else
+            filestream_delete(list->elems[i].data);
+      }
+      string_list_free(list);
+   }
+   filestream_delete(dir);
+}
+
+int main(int argc, char **argv)
+{
+   char dir[256];
+   char db_path[PATH_MAX_LENGTH];
+   unsigned num_entries    = 20000;
+   unsigned num_cores      = 12;
+   unsigned i, j;
+   unsigned found_legacy   = 0;
+   unsigned found_db       = 0;
+   unsigned logged         = 0;
+   int failed              = 0;
+   int64_t t0, usec_legacy, usec_import, usec_open, usec_lookup;
+   size_t imported;
+   runtime_db_entry_t *expected;
+   unsigned char *has_log;
+   unsigned char *rev;
+   runtime_db_t *db;
+
+   strlcpy(dir, "runtime_db_bench.tmp", sizeof(dir));
+
+   for (i = 1; i + 1 < (unsigned)argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-n"))
+         num_entries = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-c"))
+         num_cores   = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-d"))
+         strlcpy(dir, argv[i + 1], sizeof(dir));
+   }
+
+   if (!num_cores)
+      num_cores = 1;
+
+   expected = (runtime_db_entry_t*)calloc(num_entries, sizeof(*expected));
+   has_log  = (unsigned char*)calloc(num_entries, 1);
+   rev      = (unsigned char*)calloc(num_entries, 1);
+
+   remove_tree(dir);
+   path_mkdir(dir);
+   fill_pathname_join(db_path, dir, "content_runtime.lrtdb", sizeof(db_path));
+
+   /* Most entries have been played, some only with another core */
+   for (j = 0; j < num_cores; j++)
+   {
+      char core_dir[PATH_MAX_LENGTH];
+      snprintf(core_dir, sizeof(core_dir), "%s/Core %u", dir, j);
+      path_mkdir(core_dir);
+   }
+
+   for (i = 0; i < num_entries; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+
+      rev[i] = (unsigned char)(rng() % 3);
+      if (rng() % 10 == 0)
+         continue;
+
+      random_entry(&expected[i]);
+      snprintf(path, sizeof(path), "%s/Core %u/Game %u (Rev %u).lrtl",
+            dir, i % num_cores, i, rev[i]);
+      if (write_legacy(path, &expected[i]))
+      {
+         has_log[i] = 1;
+         logged++;
+      }
+   }
+
+   printf("%u playlist entries, %u cores, %u with a log file\n\n",
+         num_entries, num_cores, logged);
+
+   /* Legacy: one stat, stat and JSON parse per entry */
+   t0 = bench_usec();
+   for (i = 0; i < num_entries; i++)
+   {
+      char core_dir[512];
+      char path[PATH_MAX_LENGTH];
+      runtime_db_entry_t entry;
+
+      snprintf(core_dir, sizeof(core_dir), "%s/Core %u", dir, i % num_cores);
+      snprintf(path, sizeof(path), "%s/Game %u (Rev %u).lrtl",
+            core_dir, i, rev[i]);
+      if (read_legacy(core_dir, path, &entry))
+      {
+         found_legacy++;
+         if (memcmp(&entry, &expected[i], sizeof(entry)))
+            failed = 1;
+      }
+   }
+   usec_legacy = bench_usec() - t0;
+
+   /* First start: import */
+   t0       = bench_usec();
+   db       = runtime_db_open(db_path);
+   imported = import_all(db, dir);
+   runtime_db_free(db);
+   usec_import = bench_usec() - t0;
+
+   /* Every later start: open and look up */
+   t0        = bench_usec();
+   db        = runtime_db_open(db_path);
+   usec_open = bench_usec() - t0;
+
+   t0 = bench_usec();
+   for (i = 0; i < num_entries; i++)
+   {
+      char key[PATH_MAX_LENGTH];
+      runtime_db_entry_t entry;
+
+      snprintf(key, sizeof(key), "Core %u/Game %u (Rev %u).lrtl",
+            i % num_cores, i, rev[i]);
+      if (runtime_db_get(db, key, &entry))
+      {
+         found_db++;
+         if (!has_log[i] || memcmp(&entry, &expected[i], sizeof(entry)))
+            failed = 1;
+      }
+   }
+   usec_lookup = bench_usec() - t0;
+
+   printf("%-22s %10s %10s\n", "", "total ms", "us/entry");
+   printf("%-22s %10.1f %10.2f\n", "legacy read",
+         usec_legacy / 1000.0, (double)usec_legacy / num_entries);
+   printf("%-22s %10.1f %10.2f\n", "import (once)",
+         usec_import / 1000.0, (double)usec_import / num_entries);
+   printf("%-22s %10.1f %10.2f\n", "database open",
+         usec_open / 1000.0, (double)usec_open / num_entries);
+   printf("%-22s %10.1f %10.2f\n", "database lookup",
+         usec_lookup / 1000.0, (double)usec_lookup / num_entries);
+   printf("%-22s %10.1f %10.2f\n", "database open+lookup",
+         (usec_open + usec_lookup) / 1000.0,
+         (double)(usec_open + usec_lookup) / num_entries);
+   printf("\nspeedup %.1fx, %u/%u/%u entries found (legacy/import/db)\n",
+         (double)usec_legacy / (usec_open + usec_lookup ? usec_open + usec_lookup : 1),
+         found_legacy, (unsigned)imported, found_db);
+
+   if (found_legacy != logged || found_db != logged || imported != logged)
+      failed = 1;
+
+   /* Sessions go through the journal and survive reopening,
+    * keys with separators in them included */
+   {
+      runtime_db_entry_t sessions[100];
+      runtime_db_entry_t entry, check;
+
+      for (i = 0; i < 1000; i++)
+      {
+         char key[64];
+         snprintf(key, sizeof(key), "Core 0/Session\t%u\\.lrtl", i % 100);
+         random_entry(&sessions[i % 100]);
+         if (!runtime_db_put(db, key, &sessions[i % 100]))
+            failed = 1;
+      }
+      runtime_db_free(db);
+
+      db = runtime_db_open(db_path);
+      for (i = 0; i < 100; i++)
+      {
+         char key[64];
+         snprintf(key, sizeof(key), "Core 0/Session\t%u\\.lrtl", i);
+         if (     !runtime_db_get(db, key, &check)
+               || memcmp(&check, &sessions[i], sizeof(check)))
+         {
+            printf("journal entry %u lost\n", i);
+            failed = 1;
+         }
+      }
+      if (runtime_db_count(db) != logged + 100)
+      {
+         printf("journal count %u, expected %u\n",
+               (unsigned)runtime_db_count(db), logged + 100);
+         failed = 1;
+      }
+      runtime_db_free(db);
+
+      /* A crash in the middle of appending a line */
+      {
+         RFILE *file = filestream_open(db_path,
+               RETRO_VFS_FILE_ACCESS_READ_WRITE
+               | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE);
+         filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END);
+         filestream_printf(file, "Core 0/Torn.lrtl\t1:02:0");
+         filestream_close(file);
+      }
+
+      db = runtime_db_open(db_path);
+      random_entry(&entry);
+      runtime_db_put(db, "Core 0/After.lrtl", &entry);
+      runtime_db_free(db);
+
+      db = runtime_db_open(db_path);
+      if (     runtime_db_get(db, "Core 0/Torn.lrtl", &check)
+            || !runtime_db_get(db, "Core 0/After.lrtl", &check)
+            || memcmp(&check, &entry, sizeof(check))
+            || runtime_db_count(db) != logged + 101)
+      {
+         printf("torn journal line not handled\n");
+         failed = 1;
+      }
+      runtime_db_free(db);
+
+      printf("database %u entries, %.1f KiB\n",
+            logged + 101, path_get_size(db_path) / 1024.0);
+   }
+
+   /* Playing the same few games over and over */
+   {
+      char small_path[PATH_MAX_LENGTH];
+      runtime_db_entry_t entry;
+      int64_t size;
+      char *buf = NULL;
+      unsigned lines = 0;
+
+      fill_pathname_join(small_path, dir, "small.lrtdb", sizeof(small_path));
+      db = runtime_db_open(small_path);
+      for (i = 0; i < 1000; i++)
+      {
+         char key[64];
+         snprintf(key, sizeof(key), "Game %u.lrtl", i % 10);
+         random_entry(&entry);
+         runtime_db_put(db, key, &entry);
+      }
+      runtime_db_free(db);
+
+      if (filestream_read_file(small_path, (void**)&buf, &size) && buf)
+      {
+         for (j = 0; j < (unsigned)size; j++)
+            lines += buf[j] == '\n';
+         free(buf);
+      }
+      printf("1000 sessions on 10 games: %u journal lines\n", lines);
+      if (!lines || lines > 10 * 2 + 64 + 1)
+         failed = 1;
+   }
+
+   remove_tree(dir);
+   free(expected);
+   free(has_log);
+   free(rev);
+
+   if (failed)
+      printf("FAILED\n");
+   return failed;
+}
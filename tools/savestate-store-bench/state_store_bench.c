@@ -0,0 +1,647 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the deduplicating save state store (state_store.c) on
+ * generated series of states.
+ *
+ * A series models one game played between saves: a state made of a
+ * header with a frame counter, work RAM, video RAM and a section whose
+ * size varies (a sound or event queue, so later bytes shift around).
+ * Between two saves, bursts of work RAM and a few blocks of video RAM
+ * change. The series is saved to slots as plain files, then to the
+ * store without and with compression, reporting the space used and
+ * the save and load latency of each.
+ *
+ * Every state read back must match what was saved, exports must match
+ * too, deleting slots must let the collector delete exactly the chunks
+ * no other slot uses, a damaged chunk must fail the load, states
+ * written through state_writer.c must end up in the store, and writes
+ * from several threads, each collecting after it, must all read back.
+ *
+ * Usage: state_store_bench [-n states] [-s state KiB] [-c changed %]
+ *                          [-d directory]
+ *        state_store_bench -x state out   (export a plain state) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <retro_dirent.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+
+#include "../../state_store.h"
+#include "../../state_writer.h"
+
+static unsigned num_states  = 20;
+static size_t state_size    = 1024 * 1024;
+static unsigned changed_pct = 2;
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+   if (!cond)
+   {
+      printf("FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+/* Game state the series is generated from */
+static uint8_t *wram;
+static uint8_t *vram;
+static size_t wram_size;
+static size_t vram_size;
+static size_t queue_size;
+static uint32_t frame;
+
+static void game_init(void)
+{
+   size_t i;
+   wram_size  = state_size / 2;
+   vram_size  = state_size / 4;
+   wram       = (uint8_t*)calloc(1, wram_size);
+   vram       = (uint8_t*)calloc(1, vram_size);
+
+   /* Game variables from a small range of values, with unused
+    * stretches left zeroed */
+   for (i = 0; i < wram_size; i++)
+      if ((i / 4096) % 4 != 3)
+         wram[i] = (uint8_t)(rng() % 24);
+   /* Tiles */
+   for (i = 0; i < vram_size; i++)
+      vram[i] = (uint8_t)(((i >> 3) ^ (i >> 9)) & 0x0f);
+}
+
+static void game_play(void)
+{
+   size_t changed = wram_size * changed_pct / 100;
+   unsigned i;
+
+   while (changed)
+   {
+      size_t len = 16 + rng() % 240;
+      size_t pos, j;
+      if (len > changed)
+         len = changed;
+      pos = rng() % (wram_size - len);
+      for (j = 0; j < len; j++)
+         wram[pos + j] = (uint8_t)(rng() % 24);
+      changed -= len;
+   }
+
+   for (i = 0; i < 4; i++)
+   {
+      size_t pos = (rng() % (vram_size / 1024)) * 1024;
+      memset(vram + pos, (int)(rng() & 0x0f), 1024);
+   }
+
+   queue_size = rng() % 4096;
+   frame     += 3600;
+}
+
+/* Serializes like a core: header, work RAM, queue, video RAM, and
+ * registers filling up the rest */
+static uint8_t *game_serialize(size_t *len)
+{
+   size_t pos   = 0;
+   size_t total = state_size + queue_size;
+   uint8_t *s   = (uint8_t*)malloc(total);
+   size_t i;
+
+   memset(s, 0, 64);
+   memcpy(s, "STATE", 5);
+   memcpy(s + 8, &frame, sizeof(frame));
+   pos += 64;
+   memcpy(s + pos, wram, wram_size);
+   pos += wram_size;
+   for (i = 0; i < queue_size; i++)
+      s[pos + i] = (uint8_t)(frame + i * 7);
+   pos += queue_size;
+   memcpy(s + pos, vram, vram_size);
+   pos += vram_size;
+   for (i = pos; i < total; i++)
+      s[i] = (uint8_t)(i * 13 + (i >> 8));
+
+   *len = total;
+   return s;
+}
+
+static uint64_t dir_usage(const char *dir, bool recurse)
+{
+   uint64_t total = 0;
+   struct RDIR *rdir = retro_opendir(dir);
+   char path[PATH_MAX_LENGTH];
+
+   if (!rdir)
+      return 0;
+   while (retro_readdir(rdir))
+   {
+      const char *name = retro_dirent_get_name(rdir);
+      if (!strcmp(name, ".") || !strcmp(name, ".."))
+         continue;
+      fill_pathname_join_special(path, dir, name, sizeof(path));
+      if (retro_dirent_is_dir(rdir, NULL))
+      {
+         if (recurse)
+            total += dir_usage(path, false);
+      }
+      else
+         total += (uint64_t)path_get_size(path);
+   }
+   retro_closedir(rdir);
+   return total;
+}
+
+static unsigned dir_count(const char *dir)
+{
+   unsigned count = 0;
+   struct RDIR *rdir = retro_opendir(dir);
+   if (!rdir)
+      return 0;
+   while (retro_readdir(rdir))
+   {
+      const char *name = retro_dirent_get_name(rdir);
+      if (strcmp(name, ".") && strcmp(name, ".."))
+         count++;
+   }
+   retro_closedir(rdir);
+   return count;
+}
+
+static void remove_dir(const char *dir)
+{
+   struct RDIR *rdir = retro_opendir(dir);
+   char path[PATH_MAX_LENGTH];
+
+   if (!rdir)
+      return;
+   while (retro_readdir(rdir))
+   {
+      const char *name = retro_dirent_get_name(rdir);
+      if (!strcmp(name, ".") || !strcmp(name, ".."))
+         continue;
+      fill_pathname_join_special(path, dir, name, sizeof(path));
+      if (retro_dirent_is_dir(rdir, NULL))
+         remove_dir(path);
+      else
+         filestream_delete(path);
+   }
+   retro_closedir(rdir);
+   rmdir(dir);
+}
+
+static void slot_path(char *s, const char *dir, unsigned slot, size_t len)
+{
+   char name[64];
+   if (slot)
+      snprintf(name, sizeof(name), "Game.state%u", slot);
+   else
+      strlcpy(name, "Game.state", sizeof(name));
+   fill_pathname_join_special(s, dir, name, len);
+}
+
+/* Loads a slot like task_save.c does */
+static void *load_slot(const char *path, size_t *len)
+{
+   void *buf       = NULL;
+   int64_t buf_len = 0;
+
+   if (!filestream_read_file(path, &buf, &buf_len))
+      return NULL;
+   if (state_store_is_manifest(buf, (size_t)buf_len))
+   {
+      void *state = state_store_read(path, buf, (size_t)buf_len, len);
+      free(buf);
+      return state;
+   }
+   *len = (size_t)buf_len;
+   return buf;
+}
+
+struct series
+{
+   uint8_t **states;
+   size_t *lens;
+   uint64_t total;
+};
+
+static void run_series(const char *name, const char *dir,
+      const struct series *series, int flags, uint64_t plain_usage)
+{
+   unsigned i;
+   uint64_t usage;
+   int64_t save_time = 0;
+   int64_t load_time = 0;
+   bool matches      = true;
+   char path[PATH_MAX_LENGTH];
+   state_store_stats_t stats;
+
+   path_mkdir(dir);
+   state_store_get_stats(&stats);
+
+   for (i = 0; i < num_states; i++)
+   {
+      int64_t start;
+      slot_path(path, dir, i, sizeof(path));
+      start = bench_usec();
+      if (flags < 0)
+         check(filestream_write_file(path, series->states[i],
+                  (int64_t)series->lens[i]), "plain write");
+      else
+         check(state_store_write(path, series->states[i], series->lens[i],
+                  (unsigned)flags), "store write");
+      save_time += bench_usec() - start;
+   }
+
+   for (i = 0; i < num_states; i++)
+   {
+      int64_t start;
+      size_t _len = 0;
+      void *state;
+      slot_path(path, dir, i, sizeof(path));
+      start      = bench_usec();
+      state      = load_slot(path, &_len);
+      load_time += bench_usec() - start;
+      if (     !state
+            || _len != series->lens[i]
+            || memcmp(state, series->states[i], _len))
+         matches = false;
+      free(state);
+   }
+   check(matches, "every state reads back as saved");
+
+   state_store_get_stats(&stats);
+   usage = dir_usage(dir, true);
+   printf("  %-18s %10.2f %7.1f%% %9.2f %9.2f",
+         name, usage / (1024.0 * 1024.0),
+         plain_usage ? 100.0 * usage / plain_usage : 100.0,
+         save_time / 1000.0 / num_states, load_time / 1000.0 / num_states);
+   if (flags >= 0)
+      printf("   %u/%u chunks reused", stats.chunks_reused, stats.chunks);
+   printf("\n");
+}
+
+/* Exports, deletes and collects in the compressed store */
+static void check_maintenance(const char *dir, const struct series *series)
+{
+   unsigned i;
+   unsigned before, after, deleted;
+   size_t _len = 0;
+   void *state;
+   char path[PATH_MAX_LENGTH];
+   char out[PATH_MAX_LENGTH];
+   char chunk_dir[PATH_MAX_LENGTH];
+
+   fill_pathname_join_special(chunk_dir, dir, "Game.chunks", sizeof(chunk_dir));
+   fill_pathname_join_special(out, dir, "export.bin", sizeof(out));
+
+   /* Export */
+   slot_path(path, dir, num_states / 2, sizeof(path));
+   check(state_store_export(path, out), "export");
+   state = load_slot(out, &_len);
+   check(state && _len == series->lens[num_states / 2]
+         && !memcmp(state, series->states[num_states / 2], _len),
+         "exported state matches");
+   free(state);
+   filestream_delete(out);
+
+   /* Nothing to collect while every state is there */
+   check(state_store_collect(path) == 0, "no garbage while all slots exist");
+
+   /* Drop the older half of the slots */
+   before = dir_count(chunk_dir);
+   for (i = 0; i < num_states / 2; i++)
+   {
+      slot_path(path, dir, i, sizeof(path));
+      filestream_delete(path);
+   }
+   slot_path(path, dir, num_states - 1, sizeof(path));
+   deleted = state_store_collect(path);
+   after   = dir_count(chunk_dir);
+   printf("\nDeleting %u of %u slots: %u of %u chunks collected\n",
+         num_states / 2, num_states, deleted, before);
+   check(deleted > 0 && after == before - deleted, "old chunks collected");
+   check(state_store_collect(path) == 0, "collecting twice deletes nothing");
+
+   for (i = num_states / 2; i < num_states; i++)
+   {
+      slot_path(path, dir, i, sizeof(path));
+      state = load_slot(path, &_len);
+      check(state && _len == series->lens[i]
+            && !memcmp(state, series->states[i], _len),
+            "remaining slots intact after collection");
+      free(state);
+   }
+
+   /* A plain state over a manifest leaves its chunks to collect */
+   slot_path(path, dir, num_states - 1, sizeof(path));
+   filestream_write_file(path, series->states[0], (int64_t)series->lens[0]);
+   check(state_store_collect(path) > 0, "chunks of an overwritten manifest collected");
+
+   /* Damage a chunk: its state must not load */
+   {
+      struct RDIR *rdir = retro_opendir(chunk_dir);
+      char chunk[PATH_MAX_LENGTH];
+      void *buf         = NULL;
+      int64_t buf_len   = 0;
+
+      chunk[0] = '\0';
+      while (rdir && retro_readdir(rdir))
+      {
+         const char *name = retro_dirent_get_name(rdir);
+         if (strcmp(name, ".") && strcmp(name, ".."))
+         {
+            fill_pathname_join_special(chunk, chunk_dir, name, sizeof(chunk));
+            break;
+         }
+      }
+      if (rdir)
+         retro_closedir(rdir);
+
+      if (chunk[0] && filestream_read_file(chunk, &buf, &buf_len))
+      {
+         bool any_failed = false;
+         ((uint8_t*)buf)[buf_len - 1] ^= 0x55;
+         filestream_write_file(chunk, buf, buf_len);
+         free(buf);
+         for (i = num_states / 2; i < num_states - 1; i++)
+         {
+            slot_path(path, dir, i, sizeof(path));
+            if (!(state = load_slot(path, &_len)))
+               any_failed = true;
+            else if (_len != series->lens[i]
+                  || memcmp(state, series->states[i], _len))
+               check(false, "damaged chunk never loads as a wrong state");
+            free(state);
+         }
+         check(any_failed, "damaged chunk fails the load");
+         filestream_delete(chunk);
+      }
+   }
+}
+
+#define CONCURRENT_WRITERS 4
+
+struct concurrent_writer
+{
+   const char *dir;
+   const struct series *series;
+   unsigned id;
+   bool ok;
+};
+
+/* Writes every state of the series to its own slots in turn, so its
+ * collections run while the other threads write chunks they share */
+static void concurrent_writer_thread(void *data)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   struct concurrent_writer *w = (struct concurrent_writer*)data;
+
+   w->ok = true;
+   for (i = 0; i < num_states; i++)
+   {
+      slot_path(path, w->dir, 1 + w->id + (i & 1) * CONCURRENT_WRITERS,
+            sizeof(path));
+      if (!state_store_write(path, w->series->states[i],
+               w->series->lens[i], STATE_STORE_FLAG_COMPRESS))
+         w->ok = false;
+   }
+}
+
+static void check_concurrent(const char *dir, const struct series *series)
+{
+   unsigned i;
+   bool ok  = true;
+   bool all = true;
+   sthread_t *threads[CONCURRENT_WRITERS];
+   struct concurrent_writer writers[CONCURRENT_WRITERS];
+   char path[PATH_MAX_LENGTH];
+
+   path_mkdir(dir);
+   for (i = 0; i < CONCURRENT_WRITERS; i++)
+   {
+      writers[i].dir    = dir;
+      writers[i].series = series;
+      writers[i].id     = i;
+      threads[i]        = sthread_create(concurrent_writer_thread,
+            &writers[i]);
+   }
+   for (i = 0; i < CONCURRENT_WRITERS; i++)
+   {
+      sthread_join(threads[i]);
+      ok = ok && writers[i].ok;
+   }
+   check(ok, "concurrent writes succeed");
+
+   /* The first slot of each writer ends with the last even state of
+    * the series, the second one with the last odd state */
+   slot_path(path, dir, 1, sizeof(path));
+   state_store_collect(path);
+   for (i = 0; i < CONCURRENT_WRITERS * 2; i++)
+   {
+      size_t _len  = 0;
+      unsigned odd = i / CONCURRENT_WRITERS;
+      unsigned n   = num_states - 1 - ((num_states - 1 - odd) & 1);
+      void *state;
+      slot_path(path, dir, 1 + i, sizeof(path));
+      state = load_slot(path, &_len);
+      if (     !state
+            || _len != series->lens[n]
+            || memcmp(state, series->states[n], _len))
+         all = false;
+      free(state);
+   }
+   check(all, "concurrent writes read back after collection");
+}
+
+/* Saves through the write-behind queue with the store flag */
+static void check_writer(const char *dir, const struct series *series)
+{
+   void *data;
+   void *state;
+   size_t _len      = 0;
+   uint32_t ticket;
+   state_writer_t *writer = state_writer_new(2);
+   char path[PATH_MAX_LENGTH];
+
+   path_mkdir(dir);
+   slot_path(path, dir, 1, sizeof(path));
+
+   data   = malloc(series->lens[1]);
+   memcpy(data, series->states[1], series->lens[1]);
+   ticket = state_writer_submit(writer, path, data, series->lens[1],
+         STATE_WRITER_FLAG_STORE | STATE_WRITER_FLAG_COMPRESS,
+         STATE_WRITER_SYNC_ATOMIC);
+   state_writer_wait(writer, NULL);
+   check(state_writer_poll(writer, ticket) == STATE_WRITER_STATUS_DONE,
+         "writer stores the state");
+   check(path_get_size(path) < (int32_t)(series->lens[1] / 16),
+         "writer leaves a manifest");
+   state = load_slot(path, &_len);
+   check(state && _len == series->lens[1]
+         && !memcmp(state, series->states[1], _len),
+         "state stored by the writer reads back");
+   free(state);
+
+   /* A plain save over it drops its chunks */
+   data   = malloc(series->lens[2]);
+   memcpy(data, series->states[2], series->lens[2]);
+   ticket = state_writer_submit(writer, path, data, series->lens[2], 0,
+         STATE_WRITER_SYNC_NONE);
+   state_writer_wait(writer, NULL);
+   check(state_writer_poll(writer, ticket) == STATE_WRITER_STATUS_DONE,
+         "writer writes the plain state");
+   {
+      char chunk_dir[PATH_MAX_LENGTH];
+      fill_pathname_join_special(chunk_dir, dir, "Game.chunks",
+            sizeof(chunk_dir));
+      check(dir_count(chunk_dir) == 0,
+            "plain save over the only manifest empties the store");
+   }
+
+   state_writer_free(writer);
+}
+
+int main(int argc, char **argv)
+{
+   int c;
+   unsigned i;
+   uint64_t plain_usage;
+   struct series series;
+   const char *base = "/tmp/state_store_bench";
+   char dir[PATH_MAX_LENGTH];
+
+   state_store_init();
+
+   if (argc == 4 && !strcmp(argv[1], "-x"))
+   {
+      if (!state_store_export(argv[2], argv[3]))
+      {
+         fprintf(stderr, "Could not export \"%s\".\n", argv[2]);
+         return 1;
+      }
+      return 0;
+   }
+
+   while ((c = getopt(argc, argv, "n:s:c:d:")) != -1)
+   {
+      switch (c)
+      {
+         case 'n':
+            num_states = (unsigned)atoi(optarg);
+            break;
+         case 's':
+            state_size = (size_t)atoi(optarg) * 1024;
+            break;
+         case 'c':
+            changed_pct = (unsigned)atoi(optarg);
+            break;
+         case 'd':
+            base = optarg;
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-n states] [-s state KiB] "
+                  "[-c changed %%] [-d directory]\n"
+                  "       %s -x state out\n", argv[0], argv[0]);
+            return 1;
+      }
+   }
+
+   if (num_states < 4)
+      num_states = 4;
+   if (state_size < 64 * 1024)
+      state_size = 64 * 1024;
+   if (changed_pct > 100)
+      changed_pct = 100;
+
+   remove_dir(base);
+   path_mkdir(base);
+
+   game_init();
+   series.states = (uint8_t**)calloc(num_states, sizeof(*series.states));
+   series.lens   = (size_t*)calloc(num_states, sizeof(*series.lens));
+   series.total  = 0;
+   for (i = 0; i < num_states; i++)
+   {
+      game_play();
+      series.states[i] = game_serialize(&series.lens[i]);
+      series.total    += series.lens[i];
+   }
+
+   printf("%u states of %u KiB, %u%% of work RAM changed between saves\n\n",
+         num_states, (unsigned)(state_size / 1024), changed_pct);
+   printf("  %-18s %10s %8s %9s %9s\n", "run", "disk MiB", "of plain",
+         "save ms", "load ms");
+
+   fill_pathname_join_special(dir, base, "plain", sizeof(dir));
+   run_series("plain files", dir, &series, -1, 0);
+   plain_usage = dir_usage(dir, true);
+
+   fill_pathname_join_special(dir, base, "store", sizeof(dir));
+   run_series("store", dir, &series, 0, plain_usage);
+
+   fill_pathname_join_special(dir, base, "store-zstd", sizeof(dir));
+   run_series("store, compressed", dir, &series,
+         STATE_STORE_FLAG_COMPRESS, plain_usage);
+
+   check_maintenance(dir, &series);
+
+   fill_pathname_join_special(dir, base, "writer", sizeof(dir));
+   check_writer(dir, &series);
+
+   fill_pathname_join_special(dir, base, "concurrent", sizeof(dir));
+   check_concurrent(dir, &series);
+
+   remove_dir(base);
+
+   for (i = 0; i < num_states; i++)
+      free(series.states[i]);
+   free(series.states);
+   free(series.lens);
+   free(wram);
+   free(vram);
+
+   if (failures)
+   {
+      printf("\n%d check(s) failed\n", failures);
+      return 1;
+   }
+   printf("\nAll checks passed\n");
+   return 0;
+}
@@ -0,0 +1,406 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Hammers state_writer.c with saves on throttled storage.
+ *
+ * Storage is a VFS stand-in installed through filestream_vfs_init():
+ * it passes everything on to the default implementation, but only
+ * lets one operation in at a time and charges each write its size at
+ * the given bandwidth and each open and close a fixed latency, the
+ * way a slow SD card or network share behaves.
+ *
+ * States are submitted at a fixed interval, faster than the storage
+ * can take them, to a few slots in random order. Each run reports how
+ * long the caller was held up per save (the frame time a player would
+ * lose), how many files were actually written, and how long until
+ * everything was on storage. The "blocking" run writes every state
+ * before returning, the way states were saved before the queue.
+ *
+ * Every run then checks that each slot holds the last state submitted
+ * to it, that every ticket ended up written or superseded, and that
+ * no temporary files are left behind.
+ *
+ * Usage: state_writer_bench [-n saves] [-k slots] [-s state KiB]
+ *                           [-i interval ms] [-b KiB/s] [-l latency ms] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <libretro.h>
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <streams/file_stream.h>
+#include <vfs/vfs_implementation.h>
+
+#include "../../state_writer.h"
+
+static unsigned num_saves     = 200;
+static unsigned num_slots     = 4;
+static size_t state_size      = 1024 * 1024;
+static unsigned interval_ms   = 10;
+static unsigned bandwidth_kib = 8 * 1024;
+static unsigned latency_ms    = 5;
+
+static slock_t *storage_lock;
+static unsigned files_written;
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_sleep_usec(int64_t usec)
+{
+   struct timespec ts;
+   if (usec <= 0)
+      return;
+   ts.tv_sec  = usec / 1000000;
+   ts.tv_nsec = (usec % 1000000) * 1000;
+   nanosleep(&ts, NULL);
+}
+
+/* Throttled storage */
+
+static struct retro_vfs_file_handle *slow_open(const char *path,
+      unsigned mode, unsigned hints)
+{
+   libretro_vfs_implementation_file *f;
+   slock_lock(storage_lock);
+   bench_sleep_usec(latency_ms * 1000);
+   f = retro_vfs_file_open_impl(path, mode, hints);
+   if (f && (mode & RETRO_VFS_FILE_ACCESS_WRITE))
+      files_written++;
+   slock_unlock(storage_lock);
+   return (struct retro_vfs_file_handle*)f;
+}
+
+static int slow_close(struct retro_vfs_file_handle *stream)
+{
+   int ret;
+   slock_lock(storage_lock);
+   bench_sleep_usec(latency_ms * 1000);
+   ret = retro_vfs_file_close_impl((libretro_vfs_implementation_file*)stream);
+   slock_unlock(storage_lock);
+   return ret;
+}
+
+static int64_t slow_write(struct retro_vfs_file_handle *stream,
+      const void *s, uint64_t len)
+{
+   int64_t ret;
+   slock_lock(storage_lock);
+   bench_sleep_usec((int64_t)(len * 1000000 / (bandwidth_kib * 1024ull)));
+   ret = retro_vfs_file_write_impl(
+         (libretro_vfs_implementation_file*)stream, s, len);
+   slock_unlock(storage_lock);
+   return ret;
+}
+
+static const char *vfs_get_path(struct retro_vfs_file_handle *stream)
+{
+   return retro_vfs_file_get_path_impl(
+         (libretro_vfs_implementation_file*)stream);
+}
+
+static int64_t vfs_size(struct retro_vfs_file_handle *stream)
+{
+   return retro_vfs_file_size_impl((libretro_vfs_implementation_file*)stream);
+}
+
+static int64_t vfs_truncate(struct retro_vfs_file_handle *stream, int64_t len)
+{
+   return retro_vfs_file_truncate_impl(
+         (libretro_vfs_implementation_file*)stream, len);
+}
+
+static int64_t vfs_tell(struct retro_vfs_file_handle *stream)
+{
+   return retro_vfs_file_tell_impl((libretro_vfs_implementation_file*)stream);
+}
+
+static int64_t vfs_seek(struct retro_vfs_file_handle *stream,
+      int64_t offset, int whence)
+{
+   return retro_vfs_file_seek_impl(
+         (libretro_vfs_implementation_file*)stream, offset, whence);
+}
+
+static int64_t vfs_read(struct retro_vfs_file_handle *stream,
+      void *s, uint64_t len)
+{
+   return retro_vfs_file_read_impl(
+         (libretro_vfs_implementation_file*)stream, s, len);
+}
+
+static int vfs_flush(struct retro_vfs_file_handle *stream)
+{
+   return retro_vfs_file_flush_impl((libretro_vfs_implementation_file*)stream);
+}
+
+static int vfs_remove(const char *path)
+{
+   int ret;
+   slock_lock(storage_lock);
+   bench_sleep_usec(latency_ms * 1000);
+   ret = retro_vfs_file_remove_impl(path);
+   slock_unlock(storage_lock);
+   return ret;
+}
+
+static int vfs_rename(const char *old_path, const char *new_path)
+{
+   int ret;
+   slock_lock(storage_lock);
+   bench_sleep_usec(latency_ms * 1000);
+   ret = retro_vfs_file_rename_impl(old_path, new_path);
+   slock_unlock(storage_lock);
+   return ret;
+}
+
+static struct retro_vfs_interface slow_vfs = {
+   vfs_get_path,
+   slow_open,
+   slow_close,
+   vfs_size,
+   vfs_tell,
+   vfs_seek,
+   vfs_read,
+   slow_write,
+   vfs_flush,
+   vfs_remove,
+   vfs_rename,
+   vfs_truncate
+};
+
+/* States */
+
+static void fill_state(uint8_t *data, unsigned seq)
+{
+   size_t i;
+   uint32_t x = 0x9E3779B9u * (seq + 1);
+   for (i = 0; i < state_size; i++)
+   {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      data[i] = (uint8_t)x;
+   }
+}
+
+static bool check_slot(const char *path, unsigned seq, uint8_t *expect)
+{
+   bool ok;
+   uint8_t *buf = (uint8_t*)malloc(state_size + 1);
+   FILE *fp     = fopen(path, "rb");
+   size_t got   = 0;
+
+   if (fp)
+   {
+      got = fread(buf, 1, state_size + 1, fp);
+      fclose(fp);
+   }
+
+   fill_state(expect, seq);
+   ok = fp && got == state_size && !memcmp(buf, expect, state_size);
+   free(buf);
+   return ok;
+}
+
+static unsigned count_tmp_files(const char *dir)
+{
+   struct dirent *e;
+   unsigned n = 0;
+   DIR *d     = opendir(dir);
+   if (!d)
+      return 0;
+   while ((e = readdir(d)))
+      if (strstr(e->d_name, ".tmp"))
+         n++;
+   closedir(d);
+   return n;
+}
+
+static void clear_dir(const char *dir)
+{
+   struct dirent *e;
+   char path[PATH_MAX_LENGTH];
+   DIR *d = opendir(dir);
+   if (!d)
+      return;
+   while ((e = readdir(d)))
+   {
+      if (e->d_name[0] == '.')
+         continue;
+      snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+      remove(path);
+   }
+   closedir(d);
+}
+
+static bool run(const char *name, const char *dir, bool blocking,
+      enum state_writer_sync sync)
+{
+   unsigned i;
+   int64_t t0, t_end;
+   int64_t stall_total  = 0;
+   int64_t stall_max    = 0;
+   unsigned done        = 0;
+   unsigned superseded  = 0;
+   unsigned failed      = 0;
+   unsigned bad_slots   = 0;
+   unsigned tmp_files;
+   bool ok;
+   char path[PATH_MAX_LENGTH];
+   uint32_t *tickets    = (uint32_t*)calloc(num_saves, sizeof(*tickets));
+   unsigned *last_seq   = (unsigned*)calloc(num_slots, sizeof(*last_seq));
+   uint8_t *scratch     = (uint8_t*)malloc(state_size);
+   state_writer_t *w    = state_writer_new(2);
+   uint32_t rng         = 12345;
+
+   clear_dir(dir);
+   files_written = 0;
+   t0            = bench_usec();
+
+   for (i = 0; i < num_saves; i++)
+   {
+      int64_t s0, stall;
+      unsigned slot;
+      uint8_t *data = (uint8_t*)malloc(state_size);
+
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      slot = rng % num_slots;
+
+      /* Serializing is the caller's cost either way */
+      fill_state(data, i);
+      last_seq[slot] = i;
+      snprintf(path, sizeof(path), "%s/state%u", dir, slot);
+
+      s0 = bench_usec();
+      tickets[i] = state_writer_submit(w, path, data, state_size, 0, sync);
+      if (blocking)
+         state_writer_wait(w, path);
+      stall = bench_usec() - s0;
+
+      stall_total += stall;
+      if (stall > stall_max)
+         stall_max = stall;
+
+      bench_sleep_usec(interval_ms * 1000 - stall);
+   }
+
+   state_writer_wait(w, NULL);
+   t_end = bench_usec();
+
+   for (i = 0; i < num_saves; i++)
+   {
+      switch (state_writer_poll(w, tickets[i]))
+      {
+         case STATE_WRITER_STATUS_DONE:
+            done++;
+            break;
+         case STATE_WRITER_STATUS_SUPERSEDED:
+            superseded++;
+            break;
+         default:
+            failed++;
+            break;
+      }
+   }
+
+   for (i = 0; i < num_slots; i++)
+   {
+      snprintf(path, sizeof(path), "%s/state%u", dir, i);
+      if (!check_slot(path, last_seq[i], scratch))
+         bad_slots++;
+   }
+
+   tmp_files = count_tmp_files(dir);
+
+   printf("%-9s %9.2f %9.2f %6u %6u %6u %9.2f  %s\n",
+         name,
+         stall_total / 1000.0 / num_saves,
+         stall_max / 1000.0,
+         files_written, done, superseded,
+         (t_end - t0) / 1000000.0,
+         (failed || bad_slots || tmp_files) ? "FAIL" : "ok");
+   if (failed || bad_slots || tmp_files)
+      printf("          %u failed tickets, %u bad slots, %u temp files\n",
+            failed, bad_slots, tmp_files);
+
+   ok = !failed && !bad_slots && !tmp_files;
+
+   state_writer_free(w);
+   free(tickets);
+   free(last_seq);
+   free(scratch);
+   return ok;
+}
+
+int main(int argc, char **argv)
+{
+   int c;
+   bool ok = true;
+   char dir[] = "/tmp/state_writer_bench.XXXXXX";
+   struct retro_vfs_interface_info vfs_info;
+
+   while ((c = getopt(argc, argv, "n:k:s:i:b:l:")) != -1)
+   {
+      switch (c)
+      {
+         case 'n': num_saves     = (unsigned)atoi(optarg); break;
+         case 'k': num_slots     = (unsigned)atoi(optarg); break;
+         case 's': state_size    = (size_t)atoi(optarg) * 1024; break;
+         case 'i': interval_ms   = (unsigned)atoi(optarg); break;
+         case 'b': bandwidth_kib = (unsigned)atoi(optarg); break;
+         case 'l': latency_ms    = (unsigned)atoi(optarg); break;
+         default:
+            return 1;
+      }
+   }
+
+   if (!num_saves || !num_slots || !state_size || !bandwidth_kib
+         || !mkdtemp(dir))
+      return 1;
+
+   storage_lock                        = slock_new();
+   vfs_info.required_interface_version = 2;
+   vfs_info.iface                      = &slow_vfs;
+   filestream_vfs_init(&vfs_info);
+
+   printf("%u saves of %u KiB to %u slots every %u ms, "
+         "storage %u KiB/s, %u ms per open/close\n\n",
+         num_saves, (unsigned)(state_size / 1024), num_slots, interval_ms,
+         bandwidth_kib, latency_ms);
+   printf("%-9s %9s %9s %6s %6s %6s %9s\n",
+         "mode", "stall ms", "max ms", "files", "done", "merged", "total s");
+
+   ok &= run("blocking", dir, true,  STATE_WRITER_SYNC_NONE);
+   ok &= run("queue",    dir, false, STATE_WRITER_SYNC_NONE);
+   ok &= run("flush",    dir, false, STATE_WRITER_SYNC_FILE);
+   ok &= run("atomic",   dir, false, STATE_WRITER_SYNC_ATOMIC);
+
+   clear_dir(dir);
+   rmdir(dir);
+   slock_free(storage_lock);
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,340 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the CPU time the software compositor used by the xshm driver
+ * spends per frame, rendering into the memory sink.
+ *
+ * Each case scales a core frame into a viewport of a typical window, with
+ * nearest (integer or fractional) and bilinear filtering, from RGB565 and
+ * XRGB8888. The menu rows blend an RGUI sized RGBA4444 texture over the
+ * whole window on top of that, and the OSD rows draw a line of glyphs.
+ *
+ * Before timing anything the nearest path is checked against a plain
+ * reference, bilinear for identity and monotonic gradients, and the menu
+ * blend against the per-pixel formula.
+ *
+ * Usage: softrender_bench [-n frames] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../gfx/common/softrender.h"
+
+struct bench_case
+{
+   const char *name;
+   unsigned src_width;
+   unsigned src_height;
+   unsigned out_width;
+   unsigned out_height;
+   unsigned vp_width;
+   unsigned vp_height;
+};
+
+static const struct bench_case cases[] = {
+   { "256x224 4x    ", 256, 224, 1920, 1080, 1024,  896 },
+   { "256x224 8:7   ", 256, 224, 1920, 1080, 1234, 1080 },
+   { "320x240 4.5x  ", 320, 240, 1920, 1080, 1440, 1080 },
+   { "640x480 3x    ", 640, 480, 2560, 1440, 1920, 1440 },
+   { "1280x720 fill ", 1280, 720, 1920, 1080, 1920, 1080 },
+};
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t bench_rand(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static uint64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void fill_random(void *buf, size_t len)
+{
+   size_t i;
+   uint8_t *p = (uint8_t*)buf;
+   for (i = 0; i < len; i++)
+      p[i] = (uint8_t)bench_rand();
+}
+
+static void begin_frame(softrender_t *r, const struct bench_case *c)
+{
+   softrender_begin(r, c->out_width, c->out_height);
+   softrender_set_viewport(r,
+         (c->out_width  - c->vp_width)  / 2,
+         (c->out_height - c->vp_height) / 2,
+         c->vp_width, c->vp_height);
+}
+
+static int check_nearest(void)
+{
+   unsigned i, x, y;
+   softrender_t r;
+   int ret         = 0;
+   uint32_t *frame = (uint32_t*)malloc(320 * 240 * sizeof(uint32_t));
+
+   fill_random(frame, 320 * 240 * sizeof(uint32_t));
+   softrender_init(&r, &softrender_sink_memory, 0, 0);
+
+   for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      struct bench_case c = cases[i];
+      c.src_width         = 320;
+      c.src_height        = 240;
+
+      begin_frame(&r, &c);
+      softrender_draw_frame(&r, frame, 320, 240,
+            320 * sizeof(uint32_t), true);
+
+      for (y = 0; y < r.vp_height; y++)
+      {
+         const uint32_t *row = r.out + (r.vp_y + y) * r.out_pitch + r.vp_x;
+         unsigned src_y      = ((2 * y + 1) * 240) / (2 * r.vp_height);
+         for (x = 0; x < r.vp_width; x++)
+         {
+            unsigned src_x = ((2 * x + 1) * 320) / (2 * r.vp_width);
+            if (row[x] != frame[src_y * 320 + src_x])
+            {
+               fprintf(stderr, "nearest mismatch in %s at %u,%u\n",
+                     c.name, x, y);
+               ret = 1;
+               goto end;
+            }
+         }
+      }
+   }
+
+end:
+   softrender_free(&r);
+   free(frame);
+   return ret;
+}
+
+/* Bilinear at 1:1 has to reproduce the frame, and a gradient has to stay
+ * between its neighbours when upscaled */
+static int check_bilinear(void)
+{
+   unsigned x, y;
+   softrender_t r;
+   int ret         = 0;
+   uint32_t *frame = (uint32_t*)malloc(97 * 61 * sizeof(uint32_t));
+
+   fill_random(frame, 97 * 61 * sizeof(uint32_t));
+   softrender_init(&r, &softrender_sink_memory, 0, 0);
+   r.filter = SOFTRENDER_FILTER_BILINEAR;
+
+   softrender_begin(&r, 97, 61);
+   softrender_set_viewport(&r, 0, 0, 97, 61);
+   softrender_draw_frame(&r, frame, 97, 61, 97 * sizeof(uint32_t), true);
+   if (memcmp(r.out, frame, 97 * 61 * sizeof(uint32_t)))
+   {
+      fprintf(stderr, "bilinear 1:1 does not match the frame\n");
+      ret = 1;
+      goto end;
+   }
+
+   for (y = 0; y < 61; y++)
+      for (x = 0; x < 97; x++)
+         frame[y * 97 + x] = (x * 2) << 16 | (y * 4);
+
+   softrender_begin(&r, 300, 200);
+   softrender_set_viewport(&r, 7, 3, 291, 183);
+   softrender_draw_frame(&r, frame, 97, 61, 97 * sizeof(uint32_t), true);
+   for (y = 1; y < 183; y++)
+   {
+      const uint32_t *row  = r.out + (3 + y) * r.out_pitch + 7;
+      const uint32_t *prev = row - r.out_pitch;
+      for (x = 1; x < 291; x++)
+      {
+         if (     (row[x] >> 16) < (row[x - 1] >> 16)
+               || (row[x] & 0xff) < (prev[x] & 0xff)
+               || (row[x] >> 16) > 192
+               || (row[x] & 0xff) > 240)
+         {
+            fprintf(stderr, "bilinear gradient broken at %u,%u\n", x, y);
+            ret = 1;
+            goto end;
+         }
+      }
+   }
+
+end:
+   softrender_free(&r);
+   free(frame);
+   return ret;
+}
+
+static int check_blend(void)
+{
+   unsigned i, j;
+   softrender_t r;
+   int ret         = 0;
+   unsigned count  = 67 * 13;
+   uint32_t *frame = (uint32_t*)malloc(count * sizeof(uint32_t));
+   uint32_t *menu  = (uint32_t*)malloc(count * sizeof(uint32_t));
+   static const float alphas[] = { 1.0f, 0.75f, 0.3f, 0.0f };
+
+   softrender_init(&r, &softrender_sink_memory, 0, 0);
+   r.menu_filter = SOFTRENDER_FILTER_NEAREST;
+
+   for (j = 0; j < sizeof(alphas) / sizeof(alphas[0]); j++)
+   {
+      unsigned global;
+
+      fill_random(frame, count * sizeof(uint32_t));
+      fill_random(menu, count * sizeof(uint32_t));
+      /* Make sure the extremes show up */
+      menu[0] |= 0xff000000;
+      menu[1] &= 0x00ffffff;
+
+      softrender_begin(&r, 67, 13);
+      softrender_set_viewport(&r, 0, 0, 67, 13);
+      softrender_draw_frame(&r, frame, 67, 13, 67 * sizeof(uint32_t), true);
+      softrender_set_menu(&r, menu, true, 67, 13, alphas[j]);
+      softrender_enable_menu(&r, true, false);
+      softrender_draw_menu(&r);
+      global = r.menu_alpha;
+
+      for (i = 0; i < count; i++)
+      {
+         unsigned k;
+         uint32_t expect = 0;
+         uint32_t a      = ((menu[i] >> 24) * global) >> 8;
+
+         a += a >> 7;
+         for (k = 0; k < 32; k += 8)
+            expect |= (((((menu[i] >> k) & 0xff) * a
+                    + ((frame[i] >> k) & 0xff) * (256 - a)) >> 8) & 0xff) << k;
+
+         if (r.out[i] != expect)
+         {
+            fprintf(stderr, "blend mismatch at %u (alpha %.2f): "
+                  "%08x, expected %08x\n",
+                  i, alphas[j], (unsigned)r.out[i], (unsigned)expect);
+            ret = 1;
+            goto end;
+         }
+      }
+   }
+
+end:
+   softrender_free(&r);
+   free(frame);
+   free(menu);
+   return ret;
+}
+
+static void draw_osd(softrender_t *r, const uint8_t *glyph)
+{
+   unsigned i;
+   int x = 40;
+   int y = (int)r->out_height - 80;
+
+   /* About 40 characters of 24x32 text */
+   for (i = 0; i < 40; i++, x += 26)
+      softrender_draw_mask(r, x, y, glyph, 24, 32, 24, 0xffff00);
+}
+
+static double run_case(const struct bench_case *c,
+      enum softrender_filter filter, bool rgb32, bool menu, bool osd,
+      unsigned frames)
+{
+   unsigned i;
+   uint64_t start;
+   softrender_t r;
+   unsigned pitch    = c->src_width * (rgb32 ? 4 : 2);
+   uint8_t *frame    = (uint8_t*)malloc(pitch * c->src_height);
+   uint16_t *texture = (uint16_t*)malloc(320 * 240 * sizeof(uint16_t));
+   uint8_t glyph[24 * 32];
+
+   fill_random(frame, pitch * c->src_height);
+   fill_random(texture, 320 * 240 * sizeof(uint16_t));
+   fill_random(glyph, sizeof(glyph));
+
+   softrender_init(&r, &softrender_sink_memory, c->out_width, c->out_height);
+   r.filter      = filter;
+   r.menu_filter = SOFTRENDER_FILTER_BILINEAR;
+   if (menu)
+   {
+      softrender_set_menu(&r, texture, false, 320, 240, 0.9f);
+      softrender_enable_menu(&r, true, true);
+   }
+
+   /* Warm up: allocations and scaler filters */
+   begin_frame(&r, c);
+   softrender_draw_frame(&r, frame, c->src_width, c->src_height,
+         pitch, rgb32);
+
+   start = bench_usec();
+   for (i = 0; i < frames; i++)
+   {
+      begin_frame(&r, c);
+      softrender_draw_frame(&r, frame, c->src_width, c->src_height,
+            pitch, rgb32);
+      softrender_draw_menu(&r);
+      if (osd)
+         draw_osd(&r, glyph);
+      softrender_present(&r);
+   }
+
+   softrender_free(&r);
+   free(frame);
+   free(texture);
+
+   return (double)(bench_usec() - start) / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   unsigned frames = 300;
+
+   if (argc > 2 && !strcmp(argv[1], "-n"))
+      frames = (unsigned)atoi(argv[2]);
+   if (!frames)
+      frames = 1;
+
+   if (check_nearest() || check_bilinear() || check_blend())
+      return 1;
+   printf("nearest, bilinear and blend checks passed\n\n");
+
+   printf("%-16s %-8s %10s %10s %10s %10s\n",
+         "case", "filter", "565", "8888", "+menu", "+osd");
+   for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+   {
+      unsigned f;
+      for (f = 0; f < 2; f++)
+      {
+         enum softrender_filter filter = f
+            ? SOFTRENDER_FILTER_BILINEAR : SOFTRENDER_FILTER_NEAREST;
+         printf("%-16s %-8s %8.0fus %8.0fus %8.0fus %8.0fus\n",
+               cases[i].name, f ? "bilinear" : "nearest",
+               run_case(&cases[i], filter, false, false, false, frames),
+               run_case(&cases[i], filter, true,  false, false, frames),
+               run_case(&cases[i], filter, true,  true,  false, frames),
+               run_case(&cases[i], filter, true,  false, true,  frames));
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,378 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures how late a frame-paced thread wakes up, with and without
+ * the scheduling settings of a thread role (sthread_role_apply()).
+ *
+ * A thread sleeps until the start of each frame, records how late it
+ * woke up, then busy-waits for part of the frame like an emulator
+ * running a core. Runs are made on an idle system, then under a
+ * synthetic load of busy threads at default priority, first with
+ * default scheduling, then with a nice value, then with the policy
+ * given on the command line. Real-time policies fall back to a nice
+ * value when the process is not allowed to use them, as in RetroArch.
+ *
+ * The settings reported as applied are read back from the system and
+ * must match what was asked for. A role that is not configured must
+ * be left untouched, threads created while a role is applied must not
+ * inherit it, and sthread_role_restore() must bring the defaults back.
+ *
+ * Usage: thread_jitter_bench [-n frames] [-l load threads] [-w work us]
+ *                            [-s nice|fifo|rr] [-p priority] [-c cpu mask]
+ *                            [-k timer slack ns] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+
+#define FRAME_NSEC  16666667LL
+#define MAX_LOAD    64
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+   if (!cond)
+   {
+      printf("FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static int64_t bench_nsec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static volatile bool load_stop;
+
+/* Never sleeps, like a runaway core or a compiler in the background */
+static void load_thread(void *data)
+{
+   volatile uint32_t x = 1;
+   while (!load_stop)
+   {
+      unsigned i;
+      for (i = 0; i < 10000; i++)
+         x = x * 1664525u + 1013904223u;
+   }
+}
+
+struct jitter_run
+{
+   const char *name;
+   int64_t *lateness;
+   unsigned frames;
+   unsigned work_us;
+   unsigned flags;
+   /* Read back after applying the role */
+   int nice_value;
+   int policy;
+   uint64_t cpu_mask;
+   unsigned long timer_slack;
+};
+
+static void read_back(struct jitter_run *run)
+{
+   unsigned i;
+   cpu_set_t set;
+
+   run->nice_value  = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+   run->policy      = sched_getscheduler(0);
+   run->timer_slack = (unsigned long)prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+   run->cpu_mask    = 0;
+   if (sched_getaffinity(0, sizeof(set), &set) == 0)
+      for (i = 0; i < 64; i++)
+         if (CPU_ISSET(i, &set))
+            run->cpu_mask |= (uint64_t)1 << i;
+}
+
+/* A thread without a role, reading what it started with */
+static void plain_thread(void *data)
+{
+   read_back((struct jitter_run*)data);
+}
+
+static void frame_thread(void *data)
+{
+   unsigned i;
+   struct timespec next;
+   struct jitter_run *run = (struct jitter_run*)data;
+
+   run->flags       = sthread_role_apply(STHREAD_ROLE_MAIN);
+   read_back(run);
+
+   clock_gettime(CLOCK_MONOTONIC, &next);
+   for (i = 0; i < run->frames; i++)
+   {
+      int64_t deadline;
+      int64_t busy_until;
+
+      next.tv_nsec += FRAME_NSEC;
+      while (next.tv_nsec >= 1000000000L)
+      {
+         next.tv_nsec -= 1000000000L;
+         next.tv_sec++;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+      deadline         = (int64_t)next.tv_sec * 1000000000LL + next.tv_nsec;
+      run->lateness[i] = bench_nsec() - deadline;
+
+      busy_until       = bench_nsec() + (int64_t)run->work_us * 1000;
+      while (bench_nsec() < busy_until);
+   }
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+   int64_t x = *(const int64_t*)a;
+   int64_t y = *(const int64_t*)b;
+   return (x > y) - (x < y);
+}
+
+static void run_frames(struct jitter_run *run, unsigned load_threads)
+{
+   unsigned i;
+   sthread_t *load[MAX_LOAD];
+   sthread_t *thread;
+   int64_t sum     = 0;
+   bool early      = false;
+
+   load_stop       = false;
+   for (i = 0; i < load_threads; i++)
+      load[i]      = sthread_create(load_thread, NULL);
+
+   thread          = sthread_create(frame_thread, run);
+   sthread_join(thread);
+
+   load_stop       = true;
+   for (i = 0; i < load_threads; i++)
+      sthread_join(load[i]);
+
+   for (i = 0; i < run->frames; i++)
+   {
+      if (run->lateness[i] < 0)
+         early = true;
+      sum += run->lateness[i];
+   }
+   check(!early, "no wake-up before the deadline");
+
+   qsort(run->lateness, run->frames, sizeof(int64_t), cmp_int64);
+   printf("  %-26s %8.1f %8.1f %8.1f %9.1f   %s%s%s%s\n", run->name,
+         (double)sum / run->frames / 1000.0,
+         run->lateness[run->frames / 2] / 1000.0,
+         run->lateness[run->frames * 99 / 100] / 1000.0,
+         run->lateness[run->frames - 1] / 1000.0,
+         (run->flags & STHREAD_ROLE_FLAG_AFFINITY)       ? "affinity " : "",
+         (run->flags & STHREAD_ROLE_FLAG_SCHED)          ? "sched " : "",
+         (run->flags & STHREAD_ROLE_FLAG_SCHED_FALLBACK) ? "fallback-nice " : "",
+         (run->flags & STHREAD_ROLE_FLAG_TIMER_SLACK)    ? "slack" : "");
+}
+
+static void check_applied(const struct jitter_run *run,
+      const struct sthread_role_config *config)
+{
+   if (run->flags & STHREAD_ROLE_FLAG_AFFINITY)
+      check(run->cpu_mask == config->cpu_mask, "affinity read back");
+   /* Linux 6.8 and later give real-time threads no timer slack */
+   if (run->flags & STHREAD_ROLE_FLAG_TIMER_SLACK)
+      check(run->timer_slack == config->timer_slack_ns
+            || (run->timer_slack == 0 && run->policy != SCHED_OTHER),
+            "timer slack read back");
+   if (run->flags & STHREAD_ROLE_FLAG_SCHED_FALLBACK)
+      check(run->nice_value == config->fallback_nice
+            && run->policy == SCHED_OTHER, "fallback nice read back");
+   if (run->flags & STHREAD_ROLE_FLAG_SCHED)
+   {
+      if (config->sched == STHREAD_SCHED_NICE)
+         check(run->nice_value == config->priority, "nice read back");
+      else
+         check(run->policy == (config->sched == STHREAD_SCHED_FIFO
+                  ? SCHED_FIFO : SCHED_RR), "real-time policy read back");
+   }
+   check(!(run->flags & STHREAD_ROLE_FLAG_SCHED)
+         || !(run->flags & STHREAD_ROLE_FLAG_SCHED_FALLBACK),
+         "either the policy or its fallback is applied");
+}
+
+int main(int argc, char **argv)
+{
+   int c;
+   struct jitter_run run;
+   struct jitter_run plain;
+   struct jitter_run defaults;
+   struct sthread_role_config config;
+   struct sthread_role_config nice_config;
+   int64_t *lateness;
+   sthread_t *thread;
+   unsigned frames       = 180;
+   unsigned load_threads = 0;
+   unsigned work_us      = 4000;
+   long cpus             = sysconf(_SC_NPROCESSORS_ONLN);
+
+   memset(&config, 0, sizeof(config));
+   config.sched          = STHREAD_SCHED_FIFO;
+   config.priority       = 10;
+   config.fallback_nice  = -10;
+   config.timer_slack_ns = 1000;
+
+   while ((c = getopt(argc, argv, "n:l:w:s:p:c:k:")) != -1)
+   {
+      switch (c)
+      {
+         case 'n':
+            frames = (unsigned)atoi(optarg);
+            break;
+         case 'l':
+            load_threads = (unsigned)atoi(optarg);
+            break;
+         case 'w':
+            work_us = (unsigned)atoi(optarg);
+            break;
+         case 's':
+            if (!strcmp(optarg, "nice"))
+               config.sched = STHREAD_SCHED_NICE;
+            else if (!strcmp(optarg, "rr"))
+               config.sched = STHREAD_SCHED_RR;
+            else
+               config.sched = STHREAD_SCHED_FIFO;
+            break;
+         case 'p':
+            config.priority = atoi(optarg);
+            break;
+         case 'c':
+            config.cpu_mask = strtoull(optarg, NULL, 0);
+            break;
+         case 'k':
+            config.timer_slack_ns = (unsigned)atoi(optarg);
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-n frames] [-l load threads] "
+                  "[-w work us] [-s nice|fifo|rr] [-p priority] "
+                  "[-c cpu mask] [-k timer slack ns]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if (frames < 2)
+      frames = 2;
+   if (load_threads == 0)
+      load_threads = (unsigned)(cpus > 0 ? cpus : 1) * 2;
+   if (load_threads > MAX_LOAD)
+      load_threads = MAX_LOAD;
+
+   memset(&run, 0, sizeof(run));
+   run.frames   = frames;
+   run.work_us  = work_us;
+   lateness     = (int64_t*)malloc(frames * sizeof(int64_t));
+   run.lateness = lateness;
+
+   printf("%ld CPUs online, %u load threads, %u frames of %.2f ms "
+         "with %u us of work\n", cpus, load_threads, frames,
+         FRAME_NSEC / 1e6, work_us);
+   printf("\nWake-up lateness in us:\n");
+   printf("  %-26s %8s %8s %8s %9s   %s\n", "run",
+         "mean", "p50", "p99", "max", "applied");
+
+   /* A role that is not configured is left untouched */
+   sthread_role_set_config(STHREAD_ROLE_MAIN, NULL);
+   run.name = "idle, default";
+   run_frames(&run, 0);
+   check(run.flags == 0, "unconfigured role not applied");
+
+   run.name = "loaded, default";
+   run_frames(&run, load_threads);
+   check(run.flags == 0, "unconfigured role not applied");
+
+   /* Only what is asked for is changed */
+   memset(&nice_config, 0, sizeof(nice_config));
+   sthread_role_set_config(STHREAD_ROLE_MAIN, &nice_config);
+   check(sthread_role_apply(STHREAD_ROLE_MAIN) == 0,
+         "empty role applies nothing");
+   check(sthread_role_apply(STHREAD_ROLE_LAST) == 0,
+         "invalid role applies nothing");
+
+   nice_config.sched    = STHREAD_SCHED_NICE;
+   nice_config.priority = -10;
+   sthread_role_set_config(STHREAD_ROLE_MAIN, &nice_config);
+   run.name = "loaded, nice -10";
+   run_frames(&run, load_threads);
+   check_applied(&run, &nice_config);
+
+   sthread_role_set_config(STHREAD_ROLE_MAIN, &config);
+   run.name = config.sched == STHREAD_SCHED_NICE ? "loaded, role (nice)"
+      : config.sched == STHREAD_SCHED_RR ? "loaded, role (rr)"
+      : "loaded, role (fifo)";
+   run_frames(&run, load_threads);
+   check_applied(&run, &config);
+   check(run.flags != 0, "role applied");
+
+   sthread_role_set_config(STHREAD_ROLE_MAIN, NULL);
+
+   /* Threads start from the defaults, not from their creator's role,
+    * and the creator gets the defaults back when roles are disabled */
+   read_back(&defaults);
+   memset(&nice_config, 0, sizeof(nice_config));
+   nice_config.sched          = STHREAD_SCHED_NICE;
+   nice_config.priority       = defaults.nice_value < 19
+      ? defaults.nice_value + 1 : defaults.nice_value;
+   nice_config.timer_slack_ns = 1000;
+   nice_config.cpu_mask       = defaults.cpu_mask & ~(defaults.cpu_mask - 1);
+   sthread_role_set_config(STHREAD_ROLE_MAIN, &nice_config);
+   memset(&run, 0, sizeof(run));
+   run.flags = sthread_role_apply(STHREAD_ROLE_MAIN);
+   read_back(&run);
+   check_applied(&run, &nice_config);
+   thread = sthread_create(plain_thread, &plain);
+   sthread_join(thread);
+   check(plain.nice_value == defaults.nice_value,
+         "new thread starts at the default nice value");
+   check(plain.timer_slack == defaults.timer_slack,
+         "new thread starts at the default timer slack");
+   check(plain.cpu_mask == defaults.cpu_mask,
+         "new thread starts on the default CPUs");
+
+   sthread_role_set_config(STHREAD_ROLE_MAIN, NULL);
+   sthread_role_restore();
+   read_back(&run);
+   /* Lowering a nice value again needs CAP_SYS_NICE or RLIMIT_NICE */
+   check(run.nice_value == defaults.nice_value
+         || (geteuid() != 0 && run.nice_value == nice_config.priority),
+         "defaults restored: nice value");
+   check(run.timer_slack == defaults.timer_slack,
+         "defaults restored: timer slack");
+   check(run.cpu_mask == defaults.cpu_mask, "defaults restored: CPUs");
+
+   free(lateness);
+
+   if (failures)
+   {
+      printf("\n%d check(s) failed\n", failures);
+      return 1;
+   }
+   printf("\nAll checks passed\n");
+   return 0;
+}
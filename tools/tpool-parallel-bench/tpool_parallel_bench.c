@@ -0,0 +1,393 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares splitting small per-frame jobs across threads with the
+ * work queue of tpool_t (tpool_add_work() and tpool_wait()) and with
+ * tpool_parallel_for().
+ *
+ * Dispatch overhead is timed with empty jobs issued back to back.
+ * Per-frame latency is timed with a few jobs per frame, processing
+ * rows of pixels like a video filter would, with an idle gap between
+ * frames so workers may go to sleep as they would in a frontend.
+ *
+ * Every job must process each index exactly once, from a valid worker
+ * index, and give the same output as running it on a single thread.
+ * Note that on a machine with a single core, splitting a job can only
+ * add overhead, the timings then only show the cost of dispatching.
+ *
+ * Usage: tpool_parallel_bench [-t workers] [-f frames] [-n dispatches] [-p] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <retro_miscellaneous.h>
+#include <rthreads/rthreads.h>
+#include <rthreads/tpool.h>
+
+#define ROW_PIXELS    320
+#define MAX_ROWS      480
+#define JOBS_PER_FRAME  4
+#define FRAME_GAP_USEC 2000
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+static int64_t bench_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+   if (!cond)
+   {
+      printf("FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static uint32_t src_pixels[MAX_ROWS * ROW_PIXELS];
+static uint32_t dst_pixels[MAX_ROWS * ROW_PIXELS];
+static uint32_t ref_pixels[MAX_ROWS * ROW_PIXELS];
+
+/* Halves the brightness and blends each pixel with its right
+ * neighbour, about what a simple softfilter does per pixel */
+static void filter_rows(size_t begin, size_t end)
+{
+   size_t y, x;
+
+   for (y = begin; y < end; y++)
+   {
+      const uint32_t *in = src_pixels + y * ROW_PIXELS;
+      uint32_t *out      = dst_pixels + y * ROW_PIXELS;
+
+      for (x = 0; x < ROW_PIXELS - 1; x++)
+         out[x] = ((in[x] >> 1) & 0x7f7f7f7fu)
+            + ((in[x + 1] >> 2) & 0x3f3f3f3fu);
+      out[x]    = (in[x] >> 1) & 0x7f7f7f7fu;
+   }
+}
+
+static void filter_range(void *userdata, size_t begin, size_t end,
+      unsigned worker)
+{
+   filter_rows(begin, end);
+}
+
+static void empty_range(void *userdata, size_t begin, size_t end,
+      unsigned worker)
+{
+}
+
+/* The tpool_t version: one queued item per thread. */
+struct queue_piece
+{
+   tpool_range_func_t func;
+   size_t begin;
+   size_t end;
+};
+
+static void queue_piece_run(void *arg)
+{
+   struct queue_piece *piece = (struct queue_piece*)arg;
+   piece->func(NULL, piece->begin, piece->end, 0);
+}
+
+static struct queue_piece queue_pieces[64];
+
+static void queue_for(tpool_t *tp, unsigned threads, size_t count,
+      tpool_range_func_t func)
+{
+   unsigned i;
+
+   for (i = 0; i < threads; i++)
+   {
+      queue_pieces[i].func  = func;
+      queue_pieces[i].begin = count * i / threads;
+      queue_pieces[i].end   = count * (i + 1) / threads;
+      tpool_add_work(tp, queue_piece_run, &queue_pieces[i]);
+   }
+   tpool_wait(tp);
+}
+
+enum bench_method
+{
+   METHOD_SERIAL = 0,
+   METHOD_QUEUE,
+   METHOD_SPIN,
+   METHOD_PARK
+};
+
+static const char *method_names[] = {
+   "serial", "tpool queue", "parallel_for", "parallel_for (spin 0)"
+};
+
+struct bench_pools
+{
+   tpool_t *queue;
+   tpool_parallel_t *spin;
+   tpool_parallel_t *park;
+   unsigned threads;
+};
+
+static void run_job(struct bench_pools *pools, enum bench_method method,
+      size_t count, tpool_range_func_t func)
+{
+   switch (method)
+   {
+      case METHOD_SERIAL:
+         func(NULL, 0, count, 0);
+         break;
+      case METHOD_QUEUE:
+         queue_for(pools->queue, pools->threads, count, func);
+         break;
+      case METHOD_SPIN:
+         tpool_parallel_for(pools->spin, count, 0, func, NULL);
+         break;
+      case METHOD_PARK:
+         tpool_parallel_for(pools->park, count, 0, func, NULL);
+         break;
+   }
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+   int64_t x = *(const int64_t*)a;
+   int64_t y = *(const int64_t*)b;
+   return (x > y) - (x < y);
+}
+
+/* Coverage check: counts how many times each index is processed. */
+struct coverage
+{
+   uint8_t *hits;
+   unsigned threads;
+   volatile bool bad_worker;
+};
+
+static void coverage_range(void *userdata, size_t begin, size_t end,
+      unsigned worker)
+{
+   size_t i;
+   struct coverage *cov = (struct coverage*)userdata;
+
+   if (worker >= cov->threads || begin >= end)
+      cov->bad_worker = true;
+   for (i = begin; i < end; i++)
+      cov->hits[i]++;
+}
+
+static void check_coverage(tpool_parallel_t *pp, unsigned jobs)
+{
+   unsigned j;
+   struct coverage cov;
+   size_t max_count = 20000;
+   bool exact       = true;
+
+   cov.hits       = (uint8_t*)malloc(max_count);
+   cov.threads    = tpool_parallel_get_threads(pp);
+   cov.bad_worker = false;
+
+   for (j = 0; j < jobs && exact; j++)
+   {
+      size_t i;
+      size_t count = 1 + rng() % max_count;
+      size_t grain = (rng() & 1) ? 0 : rng() % 64;
+
+      memset(cov.hits, 0, count);
+      tpool_parallel_for(pp, count, grain, coverage_range, &cov);
+      for (i = 0; i < count; i++)
+         if (cov.hits[i] != 1)
+            exact = false;
+   }
+
+   /* More chunks than TPOOL_MAX_CHUNKS */
+   if (exact)
+   {
+      size_t i;
+      uint8_t *hits = (uint8_t*)calloc(200000, 1);
+      free(cov.hits);
+      cov.hits = hits;
+      tpool_parallel_for(pp, 200000, 1, coverage_range, &cov);
+      for (i = 0; i < 200000; i++)
+         if (cov.hits[i] != 1)
+            exact = false;
+   }
+
+   check(exact, "every index processed exactly once");
+   check(!cov.bad_worker, "worker index in range and chunks not empty");
+   free(cov.hits);
+}
+
+int main(int argc, char **argv)
+{
+   int c;
+   unsigned i, m;
+   struct bench_pools pools;
+   int cpus[63];
+   unsigned workers    = 3;
+   unsigned frames     = 300;
+   unsigned dispatches = 20000;
+   bool pin            = false;
+   size_t row_counts[] = { 16, 60, 240 };
+   int64_t *lat;
+
+   while ((c = getopt(argc, argv, "t:f:n:p")) != -1)
+   {
+      switch (c)
+      {
+         case 't':
+            workers = (unsigned)atoi(optarg);
+            break;
+         case 'f':
+            frames = (unsigned)atoi(optarg);
+            break;
+         case 'n':
+            dispatches = (unsigned)atoi(optarg);
+            break;
+         case 'p':
+            pin = true;
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-t workers] [-f frames] "
+                  "[-n dispatches] [-p]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if (workers > 63)
+      workers = 63;
+   if (frames == 0)
+      frames = 1;
+   if (dispatches == 0)
+      dispatches = 1;
+   /* Worker i on CPU i + 1, leaving CPU 0 to the caller */
+   for (i = 0; i < workers; i++)
+      cpus[i] = (int)(i + 1) % (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+   for (i = 0; i < MAX_ROWS * ROW_PIXELS; i++)
+      src_pixels[i] = rng();
+
+   pools.threads = workers + 1;
+   pools.queue   = tpool_create(pools.threads);
+   pools.spin    = tpool_parallel_create(workers,
+         TPOOL_PARALLEL_SPIN_DEFAULT, pin ? cpus : NULL);
+   pools.park    = tpool_parallel_create(workers, 0, pin ? cpus : NULL);
+   lat           = (int64_t*)malloc(frames * sizeof(*lat));
+
+   printf("%u workers + caller, %ld CPUs online%s\n", workers,
+         sysconf(_SC_NPROCESSORS_ONLN), pin ? ", pinned" : "");
+
+   check(pools.queue && pools.spin && pools.park, "pools created");
+   check(tpool_parallel_get_threads(pools.spin) == workers + 1,
+         "all workers started");
+
+   /* Correctness */
+   check_coverage(pools.spin, 2000);
+   check_coverage(pools.park, 500);
+   check_coverage(NULL, 20);
+
+   filter_rows(0, MAX_ROWS);
+   memcpy(ref_pixels, dst_pixels, sizeof(ref_pixels));
+   for (m = METHOD_QUEUE; m <= METHOD_PARK; m++)
+   {
+      memset(dst_pixels, 0, sizeof(dst_pixels));
+      run_job(&pools, (enum bench_method)m, MAX_ROWS, filter_range);
+      check(!memcmp(dst_pixels, ref_pixels, sizeof(ref_pixels)),
+            "output matches single thread");
+   }
+
+   /* Pools must stop cleanly whether workers spin or sleep */
+   for (i = 0; i < 20; i++)
+   {
+      tpool_parallel_t *pp = tpool_parallel_create(workers, i & 1
+            ? TPOOL_PARALLEL_SPIN_DEFAULT : 0, NULL);
+      if (i & 2)
+         tpool_parallel_for(pp, 100, 1, empty_range, NULL);
+      if (i & 4)
+         usleep(1000);
+      tpool_parallel_free(pp);
+   }
+
+   /* Dispatch overhead */
+   printf("\nDispatch overhead, empty job of %u chunks:\n",
+         pools.threads * 4);
+   for (m = METHOD_SERIAL; m <= METHOD_PARK; m++)
+   {
+      unsigned n   = m == METHOD_SERIAL ? dispatches * 10 : dispatches;
+      int64_t t0   = bench_usec();
+      for (i = 0; i < n; i++)
+         run_job(&pools, (enum bench_method)m, pools.threads * 4,
+               empty_range);
+      printf("  %-22s %9.2f us/job\n", method_names[m],
+            (double)(bench_usec() - t0) / n);
+   }
+
+   /* Per-frame latency */
+   for (c = 0; c < (int)ARRAY_SIZE(row_counts); c++)
+   {
+      size_t rows = row_counts[c];
+
+      printf("\nPer-frame latency, %u jobs of %u rows of %u pixels, "
+            "%u us between frames:\n", JOBS_PER_FRAME, (unsigned)rows,
+            ROW_PIXELS, FRAME_GAP_USEC);
+      for (m = METHOD_SERIAL; m <= METHOD_PARK; m++)
+      {
+         int64_t sum = 0;
+
+         for (i = 0; i < frames; i++)
+         {
+            unsigned j;
+            int64_t t0 = bench_usec();
+            for (j = 0; j < JOBS_PER_FRAME; j++)
+               run_job(&pools, (enum bench_method)m, rows, filter_range);
+            lat[i] = bench_usec() - t0;
+            sum   += lat[i];
+            usleep(FRAME_GAP_USEC);
+         }
+
+         qsort(lat, frames, sizeof(*lat), cmp_int64);
+         printf("  %-22s mean %8.1f us   p50 %6d us   p99 %6d us\n",
+               method_names[m], (double)sum / frames,
+               (int)lat[frames / 2], (int)lat[frames * 99 / 100]);
+      }
+   }
+
+   tpool_destroy(pools.queue);
+   tpool_parallel_free(pools.spin);
+   tpool_parallel_free(pools.park);
+   free(lat);
+
+   if (failures)
+   {
+      printf("\n%d check(s) failed\n", failures);
+      return 1;
+   }
+   printf("\nAll checks passed\n");
+   return 0;
+}
@@ -0,0 +1,707 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs the automatic mode of the AI service against a local mock
+ * translation server, the way tasks/task_translation.c does:
+ *
+ * - full:   every response is followed by a request with the whole
+ *           frame, as before translation_request.c.
+ * - diff:   frames with nothing changed since the last request are
+ *           not sent, and looked at again TRANSLATION_RECHECK_MSEC
+ *           later; changed frames go out whole.
+ * - region: as diff, but only the changed regions are sent.
+ *
+ * The content is a 320x240 RGB565 scene with dithered background
+ * noise: a dialogue box that types out a message, waits for it to be
+ * read with a blinking prompt, then closes while a sprite walks
+ * across the screen.
+ *
+ * The server takes longer for bigger requests, as OCR does, and
+ * records the requests, bytes and service time. The client reports
+ * the round trip latency, and the time spent capturing the frame on
+ * the main thread against converting, comparing and encoding it,
+ * which is now done by a task.
+ *
+ * Every request that was not sent must have shown the same text as
+ * the last one sent, and every region request must cover all the
+ * glyphs that changed since. A fade too slow to show between two
+ * captures must still be sent once it adds up.
+ *
+ * Usage: translation_diff_bench [-d seconds] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <boolean.h>
+#include <net/net_http.h>
+#include <net/net_compat.h>
+#include <rthreads/rthreads.h>
+#include <gfx/scaler/scaler.h>
+#include <gfx/video_frame.h>
+
+#include "../../translation_request.h"
+
+#define WIDTH             320
+#define HEIGHT            240
+#define FRAME_MS          (1000.0 / 60.0)
+
+/* Must match TRANSLATION_RECHECK_USEC in tasks/task_translation.c */
+#define RECHECK_MSEC      250
+
+/* Mock OCR: a fixed cost, then 1 ms per SERVICE_BYTES_PER_MS
+ * of request */
+#define SERVICE_BASE_MS       20
+#define SERVICE_BYTES_PER_MS  8192
+
+/* Dialogue box, in 8x12 glyph cells */
+#define BOX_X             8
+#define BOX_Y             168
+#define BOX_W             304
+#define BOX_H             64
+#define GLYPH_W           8
+#define GLYPH_H           12
+#define TEXT_X            (BOX_X + 8)
+#define TEXT_Y            (BOX_Y + 6)
+#define TEXT_COLS         36
+#define MESSAGE_LEN       60
+
+/* Frames of each part of a scene */
+#define TYPE_FRAMES       (MESSAGE_LEN * 2)
+#define HOLD_FRAMES       150
+#define WALK_FRAMES       90
+#define SCENE_FRAMES      (TYPE_FRAMES + HOLD_FRAMES + WALK_FRAMES)
+
+#define MAX_SCENES        64
+
+enum bench_mode
+{
+   MODE_FULL = 0,
+   MODE_DIFF,
+   MODE_REGION
+};
+
+typedef struct text_state
+{
+   unsigned message;
+   unsigned chars;
+   bool visible;
+} text_state_t;
+
+typedef struct bench_result
+{
+   unsigned captures;
+   unsigned requests;
+   unsigned region_requests;
+   unsigned suppressed;
+   unsigned missed;
+   unsigned uncovered;
+   unsigned messages;
+   unsigned messages_seen;
+   double capture_ms;
+   double encode_ms;
+   double latency_ms[4096];
+   unsigned latency_count;
+   /* From the server */
+   size_t bytes;
+   double service_ms;
+} bench_result_t;
+
+static int server_fd = -1;
+static volatile bool server_quit;
+static size_t server_bytes;
+static unsigned server_requests;
+static unsigned server_region_requests;
+static double server_service_ms;
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void sleep_ms(double ms)
+{
+   struct timespec ts;
+   if (ms <= 0)
+      return;
+   ts.tv_sec  = (time_t)(ms / 1000.0);
+   ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1000000.0);
+   nanosleep(&ts, NULL);
+}
+
+/* Scene */
+
+static uint16_t rgb565(unsigned r, unsigned g, unsigned b)
+{
+   return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static uint32_t hash(uint32_t x)
+{
+   x ^= x >> 16;
+   x *= 0x7feb352dU;
+   x ^= x >> 15;
+   x *= 0x846ca68bU;
+   x ^= x >> 16;
+   return x;
+}
+
+static void scene_text(unsigned frame, text_state_t *text)
+{
+   unsigned scene = frame / SCENE_FRAMES;
+   unsigned t     = frame % SCENE_FRAMES;
+
+   text->message  = scene;
+   text->visible  = t < TYPE_FRAMES + HOLD_FRAMES;
+   text->chars    = text->visible ? MIN(t / 2 + 1, MESSAGE_LEN) : 0;
+}
+
+static void glyph_rect(unsigned i, translation_region_t *r)
+{
+   r->x      = TEXT_X + (i % TEXT_COLS) * GLYPH_W;
+   r->y      = TEXT_Y + (i / TEXT_COLS) * GLYPH_H * 2;
+   r->width  = GLYPH_W;
+   r->height = GLYPH_H;
+}
+
+static void render(uint16_t *fb, unsigned frame)
+{
+   unsigned x, y, i;
+   text_state_t text;
+   unsigned t      = frame % SCENE_FRAMES;
+   /* The sprite walks while the box is closed, and
+    * stands still otherwise */
+   unsigned walk   = (t >= TYPE_FRAMES + HOLD_FRAMES)
+      ? t - (TYPE_FRAMES + HOLD_FRAMES) : 0;
+   unsigned sx     = 24 + walk * 3;
+   unsigned sy     = 72 + ((walk / 4) & 1) * 2;
+
+   scene_text(frame, &text);
+
+   /* Background, with dithering that changes every frame */
+   for (y = 0; y < HEIGHT; y++)
+      for (x = 0; x < WIDTH; x++)
+      {
+         unsigned noise = hash(x + y * WIDTH + frame * 0x9e3779b1U) & 7;
+         fb[y * WIDTH + x] = rgb565(40 + x / 8 + noise,
+               80 + y / 6 + noise, 60 + noise);
+      }
+
+   /* Sprite */
+   for (y = sy; y < sy + 24; y++)
+      for (x = sx; x < sx + 16; x++)
+         fb[y * WIDTH + x] = ((x - sx) ^ (y - sy)) & 4
+            ? rgb565(240, 200, 40) : rgb565(180, 40, 40);
+
+   if (!text.visible)
+      return;
+
+   /* Box */
+   for (y = BOX_Y; y < BOX_Y + BOX_H; y++)
+      for (x = BOX_X; x < BOX_X + BOX_W; x++)
+         fb[y * WIDTH + x] = (  x < BOX_X + 2 || x >= BOX_X + BOX_W - 2
+                             || y < BOX_Y + 2 || y >= BOX_Y + BOX_H - 2)
+            ? rgb565(255, 255, 255) : rgb565(16, 16, 96);
+
+   /* Glyphs, a pattern of 6x10 dots for each character */
+   for (i = 0; i < text.chars; i++)
+   {
+      translation_region_t r;
+      uint32_t bits = hash(text.message * 131 + i);
+      glyph_rect(i, &r);
+      for (y = 1; y < 11; y++)
+         for (x = 1; x < 7; x++)
+            if ((bits >> ((y * 6 + x) & 31)) & 1)
+               fb[(r.y + y) * WIDTH + r.x + x] = rgb565(255, 255, 255);
+   }
+
+   /* Prompt blinking every half second once the message is out */
+   if (text.chars == MESSAGE_LEN && ((t / 30) & 1))
+      for (y = BOX_Y + BOX_H - 14; y < BOX_Y + BOX_H - 6; y++)
+         for (x = BOX_X + BOX_W - 16; x < BOX_X + BOX_W - 8; x++)
+            fb[y * WIDTH + x] = rgb565(255, 255, 255);
+}
+
+/* Mock translation server */
+
+static void send_all(int fd, const void *data, size_t len)
+{
+   const uint8_t *p = (const uint8_t*)data;
+   while (len)
+   {
+      ssize_t n = send(fd, p, len, 0);
+      if (n <= 0)
+         return;
+      p   += n;
+      len -= (size_t)n;
+   }
+}
+
+static void server_thread(void *data)
+{
+   static const char body[] =
+         "{ \"text\": \"Translated text.\", \"auto\": \"auto\" }";
+
+   while (!server_quit)
+   {
+      char header[256];
+      char *req          = NULL;
+      char *head_end     = NULL;
+      size_t got         = 0;
+      size_t cap         = 65536;
+      size_t content_len = 0;
+      double service;
+      int _len;
+      int fd             = accept(server_fd, NULL, NULL);
+
+      if (fd < 0)
+         continue;
+
+      req = (char*)malloc(cap + 1);
+
+      /* Head, then the body up to Content-Length */
+      for (;;)
+      {
+         ssize_t n;
+
+         if (head_end && got >= (size_t)(head_end + 4 - req) + content_len)
+            break;
+
+         if (got == cap)
+         {
+            size_t off = head_end ? (size_t)(head_end - req) : 0;
+            cap       *= 2;
+            req        = (char*)realloc(req, cap + 1);
+            if (head_end)
+               head_end = req + off;
+         }
+
+         if ((n = recv(fd, req + got, cap - got, 0)) <= 0)
+            break;
+         got      += (size_t)n;
+         req[got]  = '\0';
+
+         if (!head_end && (head_end = strstr(req, "\r\n\r\n")))
+         {
+            const char *cl = strstr(req, "Content-Length:");
+            if (cl && cl < head_end)
+               content_len = strtoul(cl + 15, NULL, 10);
+         }
+      }
+
+      if (head_end && !strncmp(req, "POST", 4))
+      {
+         server_requests++;
+         server_bytes += content_len;
+         if (strstr(head_end, "\"regions\""))
+            server_region_requests++;
+
+         service            = SERVICE_BASE_MS
+            + (double)content_len / SERVICE_BYTES_PER_MS;
+         server_service_ms += service;
+         sleep_ms(service);
+      }
+
+      _len = snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: %lu\r\n"
+            "Connection: close\r\n\r\n",
+            (unsigned long)(sizeof(body) - 1));
+      send_all(fd, header, (size_t)_len);
+      send_all(fd, body, sizeof(body) - 1);
+
+      free(req);
+      close(fd);
+   }
+}
+
+static int server_start(void)
+{
+   struct sockaddr_in addr;
+   socklen_t addr_len = sizeof(addr);
+   int one            = 1;
+
+   server_fd = socket(AF_INET, SOCK_STREAM, 0);
+   setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port        = 0;
+
+   if (     bind(server_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+         || listen(server_fd, 8) < 0
+         || getsockname(server_fd, (struct sockaddr*)&addr, &addr_len) < 0)
+      return -1;
+
+   return ntohs(addr.sin_port);
+}
+
+/* Client */
+
+static bool http_post(const char *url, const char *json)
+{
+   size_t len;
+   bool ok = false;
+   struct http_t *http;
+   struct http_connection_t *conn = net_http_connection_new(url, "POST", json);
+
+   if (!conn)
+      return false;
+
+   while (!net_http_connection_iterate(conn)) { }
+
+   if (!net_http_connection_done(conn)
+         || !(http = net_http_new(conn)))
+   {
+      net_http_connection_free(conn);
+      return false;
+   }
+   net_http_connection_free(conn);
+
+   while (!net_http_update(http, NULL, NULL)) { }
+
+   ok = net_http_status(http) == 200
+      && net_http_data(http, &len, false)
+      && len;
+
+   net_http_delete(http);
+   return ok;
+}
+
+static bool region_contains(const translation_region_t *regions,
+      unsigned count, const translation_region_t *r)
+{
+   unsigned i;
+   for (i = 0; i < count; i++)
+      if (     r->x >= regions[i].x
+            && r->y >= regions[i].y
+            && r->x + r->width  <= regions[i].x + regions[i].width
+            && r->y + r->height <= regions[i].y + regions[i].height)
+         return true;
+   return false;
+}
+
+/* Whether the regions show every glyph that differs
+ * between @sent and @now */
+static bool regions_cover(const translation_region_t *regions,
+      unsigned count, const text_state_t *sent, const text_state_t *now)
+{
+   unsigned i;
+   translation_region_t box;
+
+   if (     sent->visible != now->visible
+         || sent->message != now->message
+         || now->chars < sent->chars)
+   {
+      box.x      = BOX_X;
+      box.y      = BOX_Y;
+      box.width  = BOX_W;
+      box.height = BOX_H;
+      return region_contains(regions, count, &box);
+   }
+
+   for (i = sent->chars; i < now->chars; i++)
+   {
+      translation_region_t r;
+      glyph_rect(i, &r);
+      if (!region_contains(regions, count, &r))
+         return false;
+   }
+
+   return true;
+}
+
+static void run(enum bench_mode mode, const char *url,
+      unsigned seconds, bench_result_t *res)
+{
+   struct scaler_ctx scaler;
+   text_state_t sent;
+   bool seen[MAX_SCENES];
+   uint16_t *fb           = (uint16_t*)malloc(WIDTH * HEIGHT * 2);
+   uint16_t *capture      = (uint16_t*)malloc(WIDTH * HEIGHT * 2);
+   uint8_t *bit24_image   = (uint8_t*)malloc(WIDTH * HEIGHT * 3);
+   translation_diff_t *diff = translation_diff_new();
+   double start;
+   unsigned i;
+
+   memset(res, 0, sizeof(*res));
+   memset(&scaler, 0, sizeof(scaler));
+   memset(&sent, 0, sizeof(sent));
+   memset(seen, 0, sizeof(seen));
+
+   server_bytes           = 0;
+   server_requests        = 0;
+   server_region_requests = 0;
+   server_service_ms      = 0;
+
+   start = now_ms();
+
+   for (;;)
+   {
+      translation_region_t regions[TRANSLATION_DIFF_MAX_REGIONS];
+      text_state_t text;
+      char *json;
+      int count;
+      double t0, t1, t2;
+      double elapsed  = now_ms() - start;
+      unsigned frame  = (unsigned)(elapsed / FRAME_MS);
+
+      if (elapsed >= seconds * 1000.0)
+         break;
+
+      /* The core's frame, then what run_translation_service
+       * does on the main thread */
+      render(fb, frame);
+      scene_text(frame, &text);
+
+      t0 = now_ms();
+      memcpy(capture, fb, WIDTH * HEIGHT * 2);
+      t1 = now_ms();
+
+      /* task_translation_request_handler */
+      scaler.in_fmt = SCALER_FMT_RGB565;
+      video_frame_convert_to_bgr24(&scaler, bit24_image,
+            (const uint8_t*)capture + (HEIGHT - 1) * WIDTH * 2,
+            WIDTH, HEIGHT, -(WIDTH * 2));
+      scaler_ctx_gen_reset(&scaler);
+
+      if (mode == MODE_FULL || !res->captures)
+         translation_diff_reset(diff);
+      count = translation_diff_update(diff,
+            bit24_image + WIDTH * (HEIGHT - 1) * 3, WIDTH, HEIGHT,
+            -(WIDTH * 3), regions, TRANSLATION_DIFF_MAX_REGIONS);
+
+      res->captures++;
+
+      if (mode != MODE_FULL && res->captures > 1 && count == 0)
+      {
+         t2               = now_ms();
+         res->capture_ms += t1 - t0;
+         res->encode_ms  += t2 - t1;
+         res->suppressed++;
+         if (     text.visible != sent.visible
+               || text.message != sent.message
+               || text.chars   != sent.chars)
+            res->missed++;
+         sleep_ms(RECHECK_MSEC);
+         continue;
+      }
+
+      if (mode != MODE_REGION)
+         count = -1;
+
+      json = translation_request_encode(
+            bit24_image + WIDTH * (HEIGHT - 1) * 3, WIDTH, HEIGHT,
+            -(WIDTH * 3), (count > 0) ? regions : NULL,
+            (count > 0) ? (unsigned)count : 0,
+            "bench__scene", false, NULL);
+      t2 = now_ms();
+
+      res->capture_ms += t1 - t0;
+      res->encode_ms  += t2 - t1;
+
+      if (count > 0)
+      {
+         res->region_requests++;
+         if (!regions_cover(regions, (unsigned)count, &sent, &text))
+            res->uncovered++;
+      }
+
+      if (!json || !http_post(url, json))
+      {
+         fprintf(stderr, "Request failed.\n");
+         exit(1);
+      }
+      free(json);
+
+      res->latency_ms[res->latency_count++ % 4096] = now_ms() - t2;
+      res->requests++;
+      sent = text;
+      if (     text.visible
+            && text.chars == MESSAGE_LEN
+            && text.message < MAX_SCENES)
+         seen[text.message] = true;
+   }
+
+   /* Messages fully typed out and shown long enough to be read */
+   res->messages = (unsigned)(seconds * 1000.0 / FRAME_MS
+         - TYPE_FRAMES - HOLD_FRAMES / 2) / SCENE_FRAMES + 1;
+   for (i = 0; i < res->messages && i < MAX_SCENES; i++)
+      res->messages_seen += seen[i];
+
+   res->bytes      = server_bytes;
+   res->service_ms = server_service_ms;
+   if (server_requests != res->requests
+         || server_region_requests != res->region_requests)
+      fprintf(stderr, "Server saw %u requests, %u with regions\n",
+            server_requests, server_region_requests);
+
+   translation_diff_free(diff);
+   free(bit24_image);
+   free(capture);
+   free(fb);
+}
+
+/* Fades in by less than TRANSLATION_DIFF_THRESHOLD between two
+ * captures. Returns the capture that was first reported changed,
+ * which must come once the fade adds up past the threshold. */
+static unsigned run_slow_fade(void)
+{
+   translation_region_t regions[TRANSLATION_DIFF_MAX_REGIONS];
+   unsigned step;
+   unsigned found           = 0;
+   uint8_t *image           = (uint8_t*)malloc(WIDTH * HEIGHT * 3);
+   translation_diff_t *diff = translation_diff_new();
+
+   for (step = 0; step < 16 && !found; step++)
+   {
+      memset(image, 40 + step * (TRANSLATION_DIFF_THRESHOLD / 3),
+            WIDTH * HEIGHT * 3);
+      if (     translation_diff_update(diff, image, WIDTH, HEIGHT,
+                  WIDTH * 3, regions, TRANSLATION_DIFF_MAX_REGIONS) != 0
+            && step)
+         found = step;
+   }
+
+   translation_diff_free(diff);
+   free(image);
+   return found;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+   double x = *(const double*)a;
+   double y = *(const double*)b;
+   return (x > y) - (x < y);
+}
+
+static void print_result(const char *label, bench_result_t *res,
+      unsigned seconds)
+{
+   unsigned n = MIN(res->latency_count, 4096);
+   double avg = 0;
+   unsigned i;
+
+   qsort(res->latency_ms, n, sizeof(double), cmp_double);
+   for (i = 0; i < n; i++)
+      avg += res->latency_ms[i];
+   if (n)
+      avg /= n;
+
+   printf("%-7s %4u requests (%3u regions, %4u unchanged), "
+         "%7.1f KB/s, service %5.1f%% busy, "
+         "latency avg %5.1f ms p95 %5.1f ms, "
+         "main thread %.3f ms, task %.3f ms per capture\n",
+         label, res->requests, res->region_requests, res->suppressed,
+         res->bytes / 1024.0 / seconds,
+         100.0 * res->service_ms / (seconds * 1000.0),
+         avg, n ? res->latency_ms[(n * 95) / 100] : 0.0,
+         res->captures ? res->capture_ms / res->captures : 0.0,
+         res->captures ? res->encode_ms  / res->captures : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+   char url[64];
+   int opt, port;
+   sthread_t *thread;
+   bench_result_t *full, *diff, *region;
+   unsigned fade;
+   unsigned seconds = 12;
+   int fail         = 0;
+
+   while ((opt = getopt(argc, argv, "d:")) != -1)
+   {
+      switch (opt)
+      {
+         case 'd':
+            seconds = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-d seconds]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if (!seconds)
+      return 1;
+
+   network_init();
+
+   if ((port = server_start()) < 0)
+   {
+      fprintf(stderr, "Failed to start server.\n");
+      return 1;
+   }
+   snprintf(url, sizeof(url), "http://127.0.0.1:%d/?output=text", port);
+   thread = sthread_create(server_thread, NULL);
+
+   full   = (bench_result_t*)calloc(1, sizeof(*full));
+   diff   = (bench_result_t*)calloc(1, sizeof(*diff));
+   region = (bench_result_t*)calloc(1, sizeof(*region));
+
+   printf("Scene: %ux%u, %u s, a %u character message every %.1f s\n",
+         WIDTH, HEIGHT, seconds, MESSAGE_LEN, SCENE_FRAMES * FRAME_MS / 1000.0);
+
+   run(MODE_FULL,   url, seconds, full);
+   run(MODE_DIFF,   url, seconds, diff);
+   run(MODE_REGION, url, seconds, region);
+
+   print_result("full",   full,   seconds);
+   print_result("diff",   diff,   seconds);
+   print_result("region", region, seconds);
+
+   fade = run_slow_fade();
+   printf("Slow fade: sent at capture %u\n", fade);
+
+   if (     diff->missed || region->missed || region->uncovered
+         || !fade || fade > 4
+         || diff->messages_seen   != diff->messages
+         || region->messages_seen != region->messages
+         || full->messages_seen   != full->messages)
+   {
+      printf("FAIL: %u/%u skipped requests with new text, "
+            "%u region requests missing changed glyphs, "
+            "messages read %u/%u/%u of %u, slow fade %s\n",
+            diff->missed, region->missed, region->uncovered,
+            full->messages_seen, diff->messages_seen,
+            region->messages_seen, region->messages,
+            (!fade || fade > 4) ? "not sent" : "sent");
+      fail = 1;
+   }
+   else
+      printf("OK: every text change was sent\n");
+
+   /* Stop the server with a last request */
+   server_quit = true;
+   http_post(url, "{}");
+   sthread_join(thread);
+   close(server_fd);
+
+   free(full);
+   free(diff);
+   free(region);
+   return fail;
+}
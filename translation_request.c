@@ -0,0 +1,436 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_miscellaneous.h>
+#include <encodings/base64.h>
+#include <formats/rjson.h>
+#include <formats/rpng.h>
+
+#include "translation_request.h"
+
+struct translation_diff
+{
+   /* Downscaled luma of the previous frame, and of the current one */
+   uint8_t *luma;
+   uint8_t *next;
+   /* One flag per tile, then the tiles left to visit
+    * while grouping changed tiles */
+   uint8_t *changed;
+   unsigned *stack;
+   unsigned width;
+   unsigned height;
+   unsigned luma_width;
+   unsigned luma_height;
+   unsigned tiles_x;
+   unsigned tiles_y;
+   bool valid;
+};
+
+translation_diff_t *translation_diff_new(void)
+{
+   return (translation_diff_t*)calloc(1, sizeof(translation_diff_t));
+}
+
+static void translation_diff_free_buffers(translation_diff_t *diff)
+{
+   free(diff->luma);
+   free(diff->next);
+   free(diff->changed);
+   free(diff->stack);
+   diff->luma    = NULL;
+   diff->next    = NULL;
+   diff->changed = NULL;
+   diff->stack   = NULL;
+}
+
+void translation_diff_free(translation_diff_t *diff)
+{
+   if (!diff)
+      return;
+   translation_diff_free_buffers(diff);
+   free(diff);
+}
+
+void translation_diff_reset(translation_diff_t *diff)
+{
+   diff->valid = false;
+}
+
+static bool translation_diff_resize(translation_diff_t *diff,
+      unsigned width, unsigned height)
+{
+   size_t luma_size, tiles;
+
+   translation_diff_free_buffers(diff);
+
+   diff->width       = width;
+   diff->height      = height;
+   diff->luma_width  = (width  + TRANSLATION_DIFF_SCALE - 1) / TRANSLATION_DIFF_SCALE;
+   diff->luma_height = (height + TRANSLATION_DIFF_SCALE - 1) / TRANSLATION_DIFF_SCALE;
+   diff->tiles_x     = (diff->luma_width  + TRANSLATION_DIFF_TILE - 1) / TRANSLATION_DIFF_TILE;
+   diff->tiles_y     = (diff->luma_height + TRANSLATION_DIFF_TILE - 1) / TRANSLATION_DIFF_TILE;
+   diff->valid       = false;
+
+   luma_size         = (size_t)diff->luma_width * diff->luma_height;
+   tiles             = (size_t)diff->tiles_x * diff->tiles_y;
+
+   if (     !(diff->luma    = (uint8_t*)malloc(luma_size))
+         || !(diff->next    = (uint8_t*)malloc(luma_size))
+         || !(diff->changed = (uint8_t*)malloc(tiles))
+         || !(diff->stack   = (unsigned*)malloc(tiles * sizeof(unsigned))))
+   {
+      translation_diff_free_buffers(diff);
+      diff->width  = 0;
+      diff->height = 0;
+      return false;
+   }
+
+   return true;
+}
+
+/* Box-filters the luma of each TRANSLATION_DIFF_SCALE square */
+static void translation_diff_downscale(const translation_diff_t *diff,
+      uint8_t *out, const uint8_t *frame, int stride)
+{
+   unsigned lx, ly;
+
+   for (ly = 0; ly < diff->luma_height; ly++)
+   {
+      unsigned y0 = ly * TRANSLATION_DIFF_SCALE;
+      unsigned y1 = MIN(y0 + TRANSLATION_DIFF_SCALE, diff->height);
+
+      for (lx = 0; lx < diff->luma_width; lx++)
+      {
+         unsigned x, y;
+         unsigned sum = 0;
+         unsigned x0  = lx * TRANSLATION_DIFF_SCALE;
+         unsigned x1  = MIN(x0 + TRANSLATION_DIFF_SCALE, diff->width);
+
+         for (y = y0; y < y1; y++)
+         {
+            const uint8_t *px = frame + (ptrdiff_t)y * stride + x0 * 3;
+            for (x = x0; x < x1; x++, px += 3)
+               sum += (px[2] * 77 + px[1] * 150 + px[0] * 29) >> 8;
+         }
+
+         *out++ = (uint8_t)(sum / ((x1 - x0) * (y1 - y0)));
+      }
+   }
+}
+
+static bool translation_diff_tile_changed(const translation_diff_t *diff,
+      unsigned tx, unsigned ty)
+{
+   unsigned x, y;
+   unsigned x0 = tx * TRANSLATION_DIFF_TILE;
+   unsigned y0 = ty * TRANSLATION_DIFF_TILE;
+   unsigned x1 = MIN(x0 + TRANSLATION_DIFF_TILE, diff->luma_width);
+   unsigned y1 = MIN(y0 + TRANSLATION_DIFF_TILE, diff->luma_height);
+
+   for (y = y0; y < y1; y++)
+   {
+      const uint8_t *a = diff->luma + (size_t)y * diff->luma_width;
+      const uint8_t *b = diff->next + (size_t)y * diff->luma_width;
+      for (x = x0; x < x1; x++)
+      {
+         int d = (int)a[x] - (int)b[x];
+         if (d > TRANSLATION_DIFF_THRESHOLD || d < -TRANSLATION_DIFF_THRESHOLD)
+            return true;
+      }
+   }
+
+   return false;
+}
+
+static bool translation_region_overlap(const translation_region_t *a,
+      const translation_region_t *b)
+{
+   return a->x < b->x + b->width  && b->x < a->x + a->width
+       && a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+static void translation_region_merge(translation_region_t *a,
+      const translation_region_t *b)
+{
+   unsigned x1 = MAX(a->x + a->width,  b->x + b->width);
+   unsigned y1 = MAX(a->y + a->height, b->y + b->height);
+   a->x        = MIN(a->x, b->x);
+   a->y        = MIN(a->y, b->y);
+   a->width    = x1 - a->x;
+   a->height   = y1 - a->y;
+}
+
+int translation_diff_update(translation_diff_t *diff,
+      const uint8_t *frame, unsigned width, unsigned height,
+      int stride, translation_region_t *regions, unsigned max_regions)
+{
+   uint8_t *tmp;
+   unsigned i, j, tx, ty;
+   unsigned changed = 0;
+   unsigned count   = 0;
+   size_t tiles;
+
+   if (!frame || !width || !height)
+      return -1;
+
+   if (     (width != diff->width || height != diff->height)
+         && !translation_diff_resize(diff, width, height))
+      return -1;
+
+   translation_diff_downscale(diff, diff->next, frame, stride);
+
+   tiles = (size_t)diff->tiles_x * diff->tiles_y;
+
+   if (diff->valid)
+   {
+      for (ty = 0; ty < diff->tiles_y; ty++)
+      {
+         for (tx = 0; tx < diff->tiles_x; tx++)
+         {
+            bool c = translation_diff_tile_changed(diff, tx, ty);
+            diff->changed[ty * diff->tiles_x + tx] = c;
+            changed += c;
+         }
+      }
+   }
+
+   /* An unchanged frame is not sent, so the next one is still
+    * compared with the last frame that was, and slow changes such
+    * as fades add up until they show */
+   if (diff->valid && !changed)
+      return 0;
+
+   tmp        = diff->luma;
+   diff->luma = diff->next;
+   diff->next = tmp;
+
+   if (!diff->valid)
+   {
+      diff->valid = true;
+      return -1;
+   }
+
+   if ((size_t)changed * 100 > tiles * TRANSLATION_DIFF_FULL_PERCENT)
+      return -1;
+
+   /* Bounding boxes of groups of touching changed tiles */
+   for (i = 0; i < tiles; i++)
+   {
+      unsigned top   = 0;
+      unsigned min_x = diff->tiles_x, min_y = diff->tiles_y;
+      unsigned max_x = 0, max_y = 0;
+
+      if (!diff->changed[i])
+         continue;
+
+      diff->changed[i]    = 0;
+      diff->stack[top++]  = i;
+
+      while (top)
+      {
+         int dx, dy;
+         unsigned t  = diff->stack[--top];
+         unsigned cx = t % diff->tiles_x;
+         unsigned cy = t / diff->tiles_x;
+
+         min_x = MIN(min_x, cx);
+         min_y = MIN(min_y, cy);
+         max_x = MAX(max_x, cx);
+         max_y = MAX(max_y, cy);
+
+         for (dy = -1; dy <= 1; dy++)
+         {
+            for (dx = -1; dx <= 1; dx++)
+            {
+               int nx = (int)cx + dx;
+               int ny = (int)cy + dy;
+               unsigned n;
+
+               if (     nx < 0 || ny < 0
+                     || nx >= (int)diff->tiles_x
+                     || ny >= (int)diff->tiles_y)
+                  continue;
+
+               n = (unsigned)ny * diff->tiles_x + (unsigned)nx;
+               if (diff->changed[n])
+               {
+                  diff->changed[n]   = 0;
+                  diff->stack[top++] = n;
+               }
+            }
+         }
+      }
+
+      if (count >= max_regions)
+         return -1;
+
+      min_x = (min_x > TRANSLATION_DIFF_MARGIN) ? min_x - TRANSLATION_DIFF_MARGIN : 0;
+      min_y = (min_y > TRANSLATION_DIFF_MARGIN) ? min_y - TRANSLATION_DIFF_MARGIN : 0;
+      max_x = MIN(max_x + TRANSLATION_DIFF_MARGIN, diff->tiles_x - 1);
+      max_y = MIN(max_y + TRANSLATION_DIFF_MARGIN, diff->tiles_y - 1);
+
+      /* Tiles to frame pixels */
+      regions[count].x      = min_x * TRANSLATION_DIFF_TILE * TRANSLATION_DIFF_SCALE;
+      regions[count].y      = min_y * TRANSLATION_DIFF_TILE * TRANSLATION_DIFF_SCALE;
+      regions[count].width  = MIN((max_x + 1) * TRANSLATION_DIFF_TILE
+            * TRANSLATION_DIFF_SCALE, width)  - regions[count].x;
+      regions[count].height = MIN((max_y + 1) * TRANSLATION_DIFF_TILE
+            * TRANSLATION_DIFF_SCALE, height) - regions[count].y;
+      count++;
+   }
+
+   /* Margins can make regions overlap */
+   for (i = 0; i < count; i++)
+   {
+      for (j = i + 1; j < count; j++)
+      {
+         if (!translation_region_overlap(&regions[i], &regions[j]))
+            continue;
+         translation_region_merge(&regions[i], &regions[j]);
+         regions[j] = regions[--count];
+         /* The grown region may now overlap earlier ones */
+         j = i;
+      }
+   }
+
+   return (int)count;
+}
+
+static bool translation_request_add_image(rjsonwriter_t *writer,
+      const uint8_t *data, unsigned width, unsigned height, int stride)
+{
+   int b64_len       = 0;
+   uint64_t png_len  = 0;
+   char *b64         = NULL;
+   uint8_t *png      = rpng_save_image_bgr24_string(data,
+         width, height, stride, &png_len);
+
+   if (!png)
+      return false;
+
+   b64 = base64(png, (int)png_len, &b64_len);
+   free(png);
+
+   if (!b64)
+      return false;
+
+   rjsonwriter_add_string(writer, "image");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string_len(writer, b64, b64_len);
+   free(b64);
+   return true;
+}
+
+char *translation_request_encode(const uint8_t *frame,
+      unsigned width, unsigned height, int stride,
+      const translation_region_t *regions, unsigned count,
+      const char *label, bool paused, const int *gamepad)
+{
+   static const char *state_labels[TRANSLATION_GAMEPAD_BUTTONS] = {
+      "b", "y", "select", "start", "up", "down", "left", "right",
+      "a", "x", "l", "r", "l2", "r2", "l3", "r3" };
+   unsigned i;
+   const char *json   = NULL;
+   char *ret          = NULL;
+   rjsonwriter_t *writer;
+
+   if (!(writer = rjsonwriter_open_memory()))
+      return NULL;
+
+   rjsonwriter_raw(writer, "{", 1);
+   rjsonwriter_raw(writer, " ", 1);
+
+   if (!regions || !count)
+   {
+      if (!translation_request_add_image(writer,
+               frame, width, height, stride))
+         goto end;
+   }
+   else
+   {
+      rjsonwriter_add_string(writer, "regions");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_raw(writer, "[", 1);
+
+      for (i = 0; i < count; i++)
+      {
+         const translation_region_t *r = &regions[i];
+
+         if (i)
+            rjsonwriter_raw(writer, ",", 1);
+         rjsonwriter_raw(writer, " ", 1);
+         rjsonwriter_rawf(writer,
+               "{ \"x\": %u, \"y\": %u, \"width\": %u, \"height\": %u, ",
+               r->x, r->y, r->width, r->height);
+         if (!translation_request_add_image(writer,
+                  frame + (ptrdiff_t)r->y * stride + r->x * 3,
+                  r->width, r->height, stride))
+            goto end;
+         rjsonwriter_raw(writer, " ", 1);
+         rjsonwriter_raw(writer, "}", 1);
+      }
+
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_raw(writer, "]", 1);
+      rjsonwriter_rawf(writer, ", \"width\": %u, \"height\": %u",
+            width, height);
+   }
+
+   if (label)
+   {
+      rjsonwriter_raw(writer, ",", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, "label");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, label);
+   }
+
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string(writer, "state");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_raw(writer, "{", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string(writer, "paused");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%u", (paused ? 1 : 0));
+   for (i = 0; i < TRANSLATION_GAMEPAD_BUTTONS; i++)
+   {
+      rjsonwriter_raw(writer, ",", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, state_labels[i]);
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_rawf(writer, "%u", (gamepad && gamepad[i]) ? 1 : 0);
+   }
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_raw(writer, "}", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_raw(writer, "}", 1);
+
+   if ((json = rjsonwriter_get_memory_buffer(writer, NULL)))
+      ret = strdup(json);
+
+end:
+   rjsonwriter_free(writer);
+   return ret;
+}
@@ -0,0 +1,129 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TRANSLATION_REQUEST_H
+#define __TRANSLATION_REQUEST_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Frames are compared on their luma, downscaled by this
+ * factor each way */
+#define TRANSLATION_DIFF_SCALE 4
+
+/* Tiles are this many downscaled pixels each way, so
+ * 32x32 pixels of the frame */
+#define TRANSLATION_DIFF_TILE 8
+
+/* Luma differences up to this are noise, such as dithering
+ * or palette flicker, rather than changed text */
+#define TRANSLATION_DIFF_THRESHOLD 12
+
+/* Changed areas are grown by this many tiles on each side,
+ * so that the service gets the text around a change too */
+#define TRANSLATION_DIFF_MARGIN 1
+
+/* Past this share of changed tiles, the whole frame is sent */
+#define TRANSLATION_DIFF_FULL_PERCENT 50
+
+/* Most regions sent in one request */
+#define TRANSLATION_DIFF_MAX_REGIONS 8
+
+/* Buttons sent with every request, in the order of
+ * input_driver_state_t.ai_gamepad_state */
+#define TRANSLATION_GAMEPAD_BUTTONS 16
+
+typedef struct translation_region
+{
+   unsigned x;
+   unsigned y;
+   unsigned width;
+   unsigned height;
+} translation_region_t;
+
+/* Change detection between the frames of successive
+ * translation requests.
+ *
+ * Each frame is reduced to a small luma image, split into
+ * tiles. Tiles that changed since the previous frame are
+ * grouped into rectangles, in frame pixels, which are all
+ * that has to be sent to the service. */
+typedef struct translation_diff translation_diff_t;
+
+translation_diff_t *translation_diff_new(void);
+
+void translation_diff_free(translation_diff_t *diff);
+
+/* The next frame is compared with nothing, and reported
+ * as changed as a whole */
+void translation_diff_reset(translation_diff_t *diff);
+
+/**
+ * translation_diff_update:
+ * @diff        : Change detection state.
+ * @frame       : BGR24 frame, first row at the top.
+ * @width       : Width of the frame.
+ * @height      : Height of the frame.
+ * @stride      : Bytes from a row to the one below it, may be
+ *                negative for bottom-up images.
+ * @regions     : Where to store the changed regions.
+ * @max_regions : Size of @regions.
+ *
+ * Compares @frame with the last one that was reported as
+ * changed, which is the last one the caller sent. Unless
+ * nothing changed, @frame then replaces it as the frame the
+ * next one is compared with.
+ *
+ * Returns: number of changed regions, 0 if nothing changed,
+ * or -1 if the whole frame should be sent: nothing to compare
+ * with, or too much changed.
+ **/
+int translation_diff_update(translation_diff_t *diff,
+      const uint8_t *frame, unsigned width, unsigned height,
+      int stride, translation_region_t *regions, unsigned max_regions);
+
+/**
+ * translation_request_encode:
+ * @frame       : BGR24 frame, first row at the top.
+ * @width       : Width of the frame.
+ * @height      : Height of the frame.
+ * @stride      : Bytes from a row to the one below it.
+ * @regions     : Regions of @frame to send, or NULL to send
+ *                the whole frame.
+ * @count       : Number of @regions.
+ * @label       : Label of the content, or NULL.
+ * @paused      : Whether the content is paused.
+ * @gamepad     : TRANSLATION_GAMEPAD_BUTTONS button states,
+ *                or NULL if none is pressed.
+ *
+ * Builds the JSON body of a request to the AI service.
+ * The whole frame goes as "image", a PNG in base64. Regions
+ * go instead as "regions", each with its position and its
+ * own "image", along with the "width" and "height" of the
+ * frame they were cut from.
+ *
+ * Returns: JSON body to free, or NULL on error.
+ **/
+char *translation_request_encode(const uint8_t *frame,
+      unsigned width, unsigned height, int stride,
+      const translation_region_t *regions, unsigned count,
+      const char *label, bool paused, const int *gamepad);
+
+RETRO_END_DECLS
+
+#endif